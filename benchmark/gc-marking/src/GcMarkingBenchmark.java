@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import com.google.caliper.Param;
+import com.google.caliper.SimpleBenchmark;
+
+public class GcMarkingBenchmark extends SimpleBenchmark {
+  // Size of the live object graph.
+  @Param({"64", "256", "1024"}) int liveMegabytes;
+
+  private static final int NODE_PAYLOAD_SIZE = 48;
+
+  static class Node {
+    Node left;
+    Node right;
+    Object payload;
+  }
+
+  private Node root;
+
+  // Build a wide tree so that the marking threads have plenty of work to steal.
+  private static Node buildTree(long bytes) {
+    long nodes = bytes / (NODE_PAYLOAD_SIZE + 32);
+    Node[] queue = new Node[(int) Math.min(nodes, Integer.MAX_VALUE)];
+    Node root = new Node();
+    queue[0] = root;
+    int head = 0;
+    int tail = 1;
+    while (tail < queue.length) {
+      Node parent = queue[head++];
+      parent.payload = new byte[NODE_PAYLOAD_SIZE];
+      parent.left = new Node();
+      queue[tail++] = parent.left;
+      if (tail < queue.length) {
+        parent.right = new Node();
+        queue[tail++] = parent.right;
+      }
+    }
+    return root;
+  }
+
+  @Override
+  protected void setUp() throws Exception {
+    root = buildTree((long) liveMegabytes * 1024 * 1024);
+    Runtime.getRuntime().gc();
+  }
+
+  @Override
+  protected void tearDown() throws Exception {
+    root = null;
+  }
+
+  public void timeFullGc(int reps) {
+    for (int i = 0; i < reps; i++) {
+      Runtime.getRuntime().gc();
+    }
+  }
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import com.google.caliper.Param;
+import com.google.caliper.SimpleBenchmark;
+
+public class InstructionSchedulingBenchmark extends SimpleBenchmark {
+  @Param({"16", "1024", "65536"}) int size;
+
+  static class Node {
+    int key;
+    int value;
+    Node next;
+  }
+
+  private int[] a;
+  private int[] b;
+  private double[] doubles;
+  private Node list;
+
+  @Override
+  protected void setUp() throws Exception {
+    a = new int[size];
+    b = new int[size];
+    doubles = new double[size];
+    list = null;
+    for (int i = 0; i < size; i++) {
+      a[i] = i;
+      b[i] = size - i;
+      doubles[i] = i * 0.5;
+      Node node = new Node();
+      node.key = i;
+      node.value = i * 7;
+      node.next = list;
+      list = node;
+    }
+  }
+
+  // Naive order: each load is right before its use.
+
+  private static int dotProduct(int[] x, int[] y) {
+    int sum = 0;
+    for (int i = 0; i < x.length - 1; i += 2) {
+      sum += x[i] * y[i];
+      sum += x[i + 1] * y[i + 1];
+    }
+    return sum;
+  }
+
+  private static int walkList(Node node) {
+    int total = 0;
+    while (node != null) {
+      total += node.key * 3 + node.value;
+      node = node.next;
+    }
+    return total;
+  }
+
+  private static double polynomial(double[] x) {
+    double sum = 0;
+    for (int i = 0; i < x.length - 1; i += 2) {
+      sum += x[i] * x[i] * 3.0 + x[i] * 2.0;
+      sum += x[i + 1] * x[i + 1] * 3.0 + x[i + 1] * 2.0;
+    }
+    return sum;
+  }
+
+  // The same kernels, interleaved by hand.
+
+  private static int dotProductInterleaved(int[] x, int[] y) {
+    int sum = 0;
+    for (int i = 0; i < x.length - 1; i += 2) {
+      int x0 = x[i];
+      int y0 = y[i];
+      int x1 = x[i + 1];
+      int y1 = y[i + 1];
+      sum += x0 * y0 + x1 * y1;
+    }
+    return sum;
+  }
+
+  private static int walkListInterleaved(Node node) {
+    int total = 0;
+    while (node != null) {
+      Node next = node.next;
+      int key = node.key;
+      int value = node.value;
+      total += key * 3 + value;
+      node = next;
+    }
+    return total;
+  }
+
+  private static double polynomialInterleaved(double[] x) {
+    double sum = 0;
+    for (int i = 0; i < x.length - 1; i += 2) {
+      double x0 = x[i];
+      double x1 = x[i + 1];
+      double square0 = x0 * x0;
+      double square1 = x1 * x1;
+      double linear0 = x0 * 2.0;
+      double linear1 = x1 * 2.0;
+      sum += square0 * 3.0 + linear0;
+      sum += square1 * 3.0 + linear1;
+    }
+    return sum;
+  }
+
+  public int timeDotProduct(int reps) {
+    int result = 0;
+    for (int rep = 0; rep < reps; rep++) {
+      result += dotProduct(a, b);
+    }
+    return result;
+  }
+
+  public int timeDotProductInterleaved(int reps) {
+    int result = 0;
+    for (int rep = 0; rep < reps; rep++) {
+      result += dotProductInterleaved(a, b);
+    }
+    return result;
+  }
+
+  public int timeWalkList(int reps) {
+    int result = 0;
+    for (int rep = 0; rep < reps; rep++) {
+      result += walkList(list);
+    }
+    return result;
+  }
+
+  public int timeWalkListInterleaved(int reps) {
+    int result = 0;
+    for (int rep = 0; rep < reps; rep++) {
+      result += walkListInterleaved(list);
+    }
+    return result;
+  }
+
+  public double timePolynomial(int reps) {
+    double result = 0;
+    for (int rep = 0; rep < reps; rep++) {
+      result += polynomial(doubles);
+    }
+    return result;
+  }
+
+  public double timePolynomialInterleaved(int reps) {
+    double result = 0;
+    for (int rep = 0; rep < reps; rep++) {
+      result += polynomialInterleaved(doubles);
+    }
+    return result;
+  }
+}
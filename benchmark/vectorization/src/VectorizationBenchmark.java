@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import com.google.caliper.Param;
+import com.google.caliper.SimpleBenchmark;
+
+public class VectorizationBenchmark extends SimpleBenchmark {
+  @Param({"16", "1024", "65536"}) int size;
+
+  private int[] ints;
+  private byte[] bytes;
+  private float[] floats;
+
+  @Override
+  protected void setUp() throws Exception {
+    ints = new int[size];
+    bytes = new byte[size];
+    floats = new float[size];
+    for (int i = 0; i < size; i++) {
+      ints[i] = i;
+      bytes[i] = (byte) i;
+      floats[i] = i;
+    }
+  }
+
+  // Vectorized loops.
+
+  private static void addInts(int[] a, int x) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] += x;
+    }
+  }
+
+  private static int sumInts(int[] a) {
+    int sum = 0;
+    for (int i = 0; i < a.length; i++) {
+      sum += a[i];
+    }
+    return sum;
+  }
+
+  private static void xorBytes(byte[] a, byte x) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] ^= x;
+    }
+  }
+
+  private static void scaleFloats(float[] a, float s) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] *= s;
+    }
+  }
+
+  // Scalar loops doing the same work.
+
+  private static void addIntsScalar(int[] a, int x) {
+    for (int i = a.length - 1; i >= 0; i--) {
+      a[i] += x;
+    }
+  }
+
+  private static int sumIntsScalar(int[] a) {
+    int sum = 0;
+    for (int i = a.length - 1; i >= 0; i--) {
+      sum += a[i];
+    }
+    return sum;
+  }
+
+  private static void xorBytesScalar(byte[] a, byte x) {
+    for (int i = a.length - 1; i >= 0; i--) {
+      a[i] ^= x;
+    }
+  }
+
+  private static void scaleFloatsScalar(float[] a, float s) {
+    for (int i = a.length - 1; i >= 0; i--) {
+      a[i] *= s;
+    }
+  }
+
+  public void timeAddInts(int reps) {
+    for (int rep = 0; rep < reps; rep++) {
+      addInts(ints, rep);
+    }
+  }
+
+  public void timeAddIntsScalar(int reps) {
+    for (int rep = 0; rep < reps; rep++) {
+      addIntsScalar(ints, rep);
+    }
+  }
+
+  public int timeSumInts(int reps) {
+    int result = 0;
+    for (int rep = 0; rep < reps; rep++) {
+      result += sumInts(ints);
+    }
+    return result;
+  }
+
+  public int timeSumIntsScalar(int reps) {
+    int result = 0;
+    for (int rep = 0; rep < reps; rep++) {
+      result += sumIntsScalar(ints);
+    }
+    return result;
+  }
+
+  public void timeXorBytes(int reps) {
+    for (int rep = 0; rep < reps; rep++) {
+      xorBytes(bytes, (byte) rep);
+    }
+  }
+
+  public void timeXorBytesScalar(int reps) {
+    for (int rep = 0; rep < reps; rep++) {
+      xorBytesScalar(bytes, (byte) rep);
+    }
+  }
+
+  public void timeScaleFloats(int reps) {
+    for (int rep = 0; rep < reps; rep++) {
+      scaleFloats(floats, 1.0001f);
+    }
+  }
+
+  public void timeScaleFloatsScalar(int reps) {
+    for (int rep = 0; rep < reps; rep++) {
+      scaleFloatsScalar(floats, 1.0001f);
+    }
+  }
+}
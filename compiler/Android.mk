@@ -60,14 +60,20 @@ LIBART_COMPILER_SRC_FILES := \
 	optimizing/licm.cc \
 	optimizing/load_store_elimination.cc \
 	optimizing/locations.cc \
+	optimizing/loop_optimization.cc \
 	optimizing/nodes.cc \
 	optimizing/nodes_arm64.cc \
 	optimizing/optimization.cc \
 	optimizing/optimizing_compiler.cc \
 	optimizing/parallel_move_resolver.cc \
+	optimizing/partial_escape_analysis.cc \
 	optimizing/prepare_for_register_allocation.cc \
 	optimizing/reference_type_propagation.cc \
+	optimizing/register_allocation_resolver.cc \
 	optimizing/register_allocator.cc \
+	optimizing/register_allocator_graph_color.cc \
+	optimizing/register_allocator_linear_scan.cc \
+	optimizing/scheduler.cc \
 	optimizing/select_generator.cc \
 	optimizing/sharpening.cc \
 	optimizing/side_effects_analysis.cc \
@@ -104,10 +110,12 @@ LIBART_COMPILER_SRC_FILES_arm64 := \
 	jni/quick/arm64/calling_convention_arm64.cc \
 	linker/arm64/relative_patcher_arm64.cc \
 	optimizing/code_generator_arm64.cc \
+	optimizing/code_generator_vector_arm64.cc \
 	optimizing/instruction_simplifier_arm.cc \
 	optimizing/instruction_simplifier_arm64.cc \
 	optimizing/instruction_simplifier_shared.cc \
 	optimizing/intrinsics_arm64.cc \
+	optimizing/scheduler_arm64.cc \
 	utils/arm64/assembler_arm64.cc \
 	utils/arm64/managed_register_arm64.cc \
 
@@ -143,6 +151,7 @@ LIBART_COMPILER_SRC_FILES_x86_64 := \
 	linker/x86_64/relative_patcher_x86_64.cc \
 	optimizing/intrinsics_x86_64.cc \
 	optimizing/code_generator_x86_64.cc \
+	optimizing/code_generator_vector_x86_64.cc \
 	utils/x86_64/assembler_x86_64.cc \
 	utils/x86_64/managed_register_x86_64.cc \
 
@@ -44,7 +44,9 @@ CompilerOptions::CompilerOptions()
       init_failure_output_(nullptr),
       dump_cfg_file_name_(""),
       dump_cfg_append_(false),
-      force_determinism_(false) {
+      force_determinism_(false),
+      register_allocation_strategy_(RegisterAllocator::kRegisterAllocatorDefault),
+      has_register_allocation_strategy_(false) {
 }
 
 CompilerOptions::~CompilerOptions() {
@@ -99,7 +101,9 @@ CompilerOptions::CompilerOptions(CompilerFilter::Filter compiler_filter,
     init_failure_output_(init_failure_output),
     dump_cfg_file_name_(dump_cfg_file_name),
     dump_cfg_append_(dump_cfg_append),
-    force_determinism_(force_determinism) {
+    force_determinism_(force_determinism),
+    register_allocation_strategy_(RegisterAllocator::kRegisterAllocatorDefault),
+    has_register_allocation_strategy_(false) {
 }
 
 void CompilerOptions::ParseHugeMethodMax(const StringPiece& option, UsageFn Usage) {
@@ -130,6 +134,20 @@ void CompilerOptions::ParseInlineMaxCodeUnits(const StringPiece& option, UsageFn
   ParseUintOption(option, "--inline-max-code-units", &inline_max_code_units_, Usage);
 }
 
+void CompilerOptions::ParseRegisterAllocationStrategy(const StringPiece& option,
+                                                      UsageFn Usage) {
+  DCHECK(option.starts_with("--register-allocation-strategy="));
+  const char* choice = option.substr(strlen("--register-allocation-strategy=")).data();
+  if (strcmp(choice, "linear-scan") == 0) {
+    register_allocation_strategy_ = RegisterAllocator::kRegisterAllocatorLinearScan;
+  } else if (strcmp(choice, "graph-color") == 0) {
+    register_allocation_strategy_ = RegisterAllocator::kRegisterAllocatorGraphColor;
+  } else {
+    Usage("Unknown --register-allocation-strategy value %s", choice);
+  }
+  has_register_allocation_strategy_ = true;
+}
+
 void CompilerOptions::ParseDumpInitFailures(const StringPiece& option,
                                             UsageFn Usage ATTRIBUTE_UNUSED) {
   DCHECK(option.starts_with("--dump-init-failures="));
@@ -190,6 +208,8 @@ bool CompilerOptions::ParseCompilerOption(const StringPiece& option, UsageFn Usa
     dump_cfg_file_name_ = option.substr(strlen("--dump-cfg=")).data();
   } else if (option.starts_with("--dump-cfg-append")) {
     dump_cfg_append_ = true;
+  } else if (option.starts_with("--register-allocation-strategy=")) {
+    ParseRegisterAllocationStrategy(option, Usage);
   } else {
     // Option not recognized.
     return false;
@@ -553,8 +553,9 @@ class BCEVisitor : public HGraphVisitor {
     first_index_bounds_check_map_.clear();
     HGraphVisitor::VisitBasicBlock(block);
     // We should never deoptimize from an osr method, otherwise we might wrongly optimize
-    // code dominated by the deoptimization.
-    if (!GetGraph()->IsCompilingOsr()) {
+    // code dominated by the deoptimization. Methods that deoptimized too often don't
+    // speculate either.
+    if (GetGraph()->IsSpeculationAllowed()) {
       AddComparesWithDeoptimization(block);
     }
   }
@@ -1367,8 +1368,9 @@ class BCEVisitor : public HGraphVisitor {
         return false;
       }
       // We should never deoptimize from an osr method, otherwise we might wrongly optimize
-      // code dominated by the deoptimization.
-      if (GetGraph()->IsCompilingOsr()) {
+      // code dominated by the deoptimization. Methods that deoptimized too often don't
+      // speculate either.
+      if (!GetGraph()->IsSpeculationAllowed()) {
         return false;
       }
       // A try boundary preheader is hard to handle.
@@ -74,6 +74,8 @@ static bool CheckType(Primitive::Type type, Location location) {
            || (type == Primitive::kPrimNot);
   } else if (location.IsDoubleStackSlot()) {
     return (type == Primitive::kPrimLong) || (type == Primitive::kPrimDouble);
+  } else if (location.IsSIMDStackSlot()) {
+    return type == Primitive::kPrimDouble;
   } else if (location.IsConstant()) {
     if (location.GetConstant()->IsIntConstant()) {
       return Primitive::IsIntegralType(type) && (type != Primitive::kPrimLong);
@@ -291,7 +293,7 @@ void CodeGenerator::InitializeCodeGeneration(size_t number_of_spill_slots,
         number_of_spill_slots * kVRegSize
         + number_of_out_slots * kVRegSize
         + maximum_number_of_live_core_registers * GetWordSize()
-        + maximum_number_of_live_fpu_registers * GetFloatingPointSpillSlotSize()
+        + maximum_number_of_live_fpu_registers * GetSlowPathFPWidth()
         + FrameEntrySpillSize(),
         kStackAlignment));
   }
@@ -632,7 +634,9 @@ static void CheckCovers(uint32_t dex_pc,
   CodeInfoEncoding encoding = code_info.ExtractEncoding();
   for (size_t i = 0; i < loop_headers.size(); ++i) {
     if (loop_headers[i]->GetDexPc() == dex_pc) {
-      if (graph.IsCompilingOsr()) {
+      // Only the loops marked irreducible are OSR entries.
+      HLoopInformation* info = loop_headers[i]->GetBlock()->GetLoopInformation();
+      if (graph.IsCompilingOsr() && info->IsIrreducible()) {
         DCHECK(code_info.GetOsrStackMapForDexPc(dex_pc, encoding).IsValid());
       }
       ++(*covered)[i];
@@ -774,11 +778,12 @@ void CodeGenerator::RecordPcInfo(HInstruction* instruction,
   if (instruction->IsSuspendCheck() &&
       (info != nullptr) &&
       graph_->IsCompilingOsr() &&
+      info->IsIrreducible() &&
       (inlining_depth == 0)) {
     DCHECK_EQ(info->GetSuspendCheck(), instruction);
     // We duplicate the stack map as a marker that this stack map can be an OSR entry.
     // Duplicating it avoids having the runtime recognize and skip an OSR stack map.
-    DCHECK(info->IsIrreducible());
+    // Only the loops which got hot, and the loops around them, are OSR entries.
     stack_map_stream_.BeginStackMapEntry(
         dex_pc, native_pc, register_mask, locations->GetStackMask(), outer_environment_size, 0);
     EmitEnvironment(instruction->GetEnvironment(), slow_path);
@@ -1192,6 +1197,9 @@ void CodeGenerator::ValidateInvokeRuntime(HInstruction* instruction, SlowPathCod
 void SlowPathCode::SaveLiveRegisters(CodeGenerator* codegen, LocationSummary* locations) {
   RegisterSet* live_registers = locations->GetLiveRegisters();
   size_t stack_offset = codegen->GetFirstRegisterSlotInSlowPath();
+  // The runtime only preserves the lower part of the callee-save floating point
+  // registers, so all the live ones are saved in full when SIMD values are live.
+  const bool save_all_fp_registers = codegen->GetGraph()->HasSIMD();
 
   for (size_t i = 0, e = codegen->GetNumberOfCoreRegisters(); i < e; ++i) {
     if (!codegen->IsCoreCalleeSaveRegister(i)) {
@@ -1209,7 +1217,7 @@ void SlowPathCode::SaveLiveRegisters(CodeGenerator* codegen, LocationSummary* lo
   }
 
   for (size_t i = 0, e = codegen->GetNumberOfFloatingPointRegisters(); i < e; ++i) {
-    if (!codegen->IsFloatingPointCalleeSaveRegister(i)) {
+    if (!codegen->IsFloatingPointCalleeSaveRegister(i) || save_all_fp_registers) {
       if (live_registers->ContainsFloatingPointRegister(i)) {
         DCHECK_LT(stack_offset, codegen->GetFrameSize() - codegen->FrameEntrySpillSize());
         DCHECK_LT(i, kMaximumNumberOfExpectedRegisters);
@@ -1223,6 +1231,7 @@ void SlowPathCode::SaveLiveRegisters(CodeGenerator* codegen, LocationSummary* lo
 void SlowPathCode::RestoreLiveRegisters(CodeGenerator* codegen, LocationSummary* locations) {
   RegisterSet* live_registers = locations->GetLiveRegisters();
   size_t stack_offset = codegen->GetFirstRegisterSlotInSlowPath();
+  const bool restore_all_fp_registers = codegen->GetGraph()->HasSIMD();
 
   for (size_t i = 0, e = codegen->GetNumberOfCoreRegisters(); i < e; ++i) {
     if (!codegen->IsCoreCalleeSaveRegister(i)) {
@@ -1235,7 +1244,7 @@ void SlowPathCode::RestoreLiveRegisters(CodeGenerator* codegen, LocationSummary*
   }
 
   for (size_t i = 0, e = codegen->GetNumberOfFloatingPointRegisters(); i < e; ++i) {
-    if (!codegen->IsFloatingPointCalleeSaveRegister(i)) {
+    if (!codegen->IsFloatingPointCalleeSaveRegister(i) || restore_all_fp_registers) {
       if (live_registers->ContainsFloatingPointRegister(i)) {
         DCHECK_LT(stack_offset, codegen->GetFrameSize() - codegen->FrameEntrySpillSize());
         DCHECK_LT(i, kMaximumNumberOfExpectedRegisters);
@@ -205,6 +205,9 @@ class CodeGenerator : public DeletableArenaObject<kArenaAllocCodeGenerator> {
   virtual const Assembler& GetAssembler() const = 0;
   virtual size_t GetWordSize() const = 0;
   virtual size_t GetFloatingPointSpillSlotSize() const = 0;
+  // Returns the number of bytes needed to save a floating point register in a
+  // slow path, which is more than the spill slot size once SIMD values are live.
+  virtual size_t GetSlowPathFPWidth() const { return GetFloatingPointSpillSlotSize(); }
   virtual uintptr_t GetAddressOf(HBasicBlock* block) = 0;
   void InitializeCodeGeneration(size_t number_of_spill_slots,
                                 size_t maximum_number_of_live_core_registers,
@@ -5741,6 +5741,65 @@ void InstructionCodeGeneratorARM::VisitMonitorOperation(HMonitorOperation* instr
   }
 }
 
+void LocationsBuilderARM::VisitUpdateHotness(HUpdateHotness* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(Location::RegisterLocation(calling_convention.GetRegisterAt(1)));
+  locations->SetOut(Location::RegisterLocation(R0));
+}
+
+void InstructionCodeGeneratorARM::VisitUpdateHotness(HUpdateHotness* instruction) {
+  InvokeRuntimeCallingConvention calling_convention;
+  // The dex pc of the loop header for a back edge, kDexNoIndex for the method entry.
+  uint32_t dex_pc = instruction->IsBackEdge() ? instruction->GetDexPc() : DexFile::kDexNoIndex;
+  __ LoadImmediate(calling_convention.GetRegisterAt(1), dex_pc);
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateHotness),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr);
+  CheckEntrypointTypes<kQuickJitUpdateHotness, uint32_t, ArtMethod*, uint32_t>();
+}
+
+void LocationsBuilderARM::VisitUpdateInlineCache(HUpdateInlineCache* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, Location::RegisterLocation(calling_convention.GetRegisterAt(2)));
+  locations->AddTemp(Location::RegisterLocation(calling_convention.GetRegisterAt(1)));
+}
+
+void InstructionCodeGeneratorARM::VisitUpdateInlineCache(HUpdateInlineCache* instruction) {
+  InvokeRuntimeCallingConvention calling_convention;
+  __ LoadImmediate(calling_convention.GetRegisterAt(1), instruction->GetDexPc());
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateInlineCache),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr);
+  CheckEntrypointTypes<kQuickJitUpdateInlineCache, void, ArtMethod*, uint32_t, mirror::Object*>();
+}
+
+void LocationsBuilderARM::VisitUpdateBranchProfile(HUpdateBranchProfile* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, Location::RegisterLocation(calling_convention.GetRegisterAt(2)));
+  locations->AddTemp(Location::RegisterLocation(calling_convention.GetRegisterAt(1)));
+}
+
+void InstructionCodeGeneratorARM::VisitUpdateBranchProfile(HUpdateBranchProfile* instruction) {
+  InvokeRuntimeCallingConvention calling_convention;
+  __ LoadImmediate(calling_convention.GetRegisterAt(1), instruction->GetDexPc());
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateBranchProfile),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr);
+  CheckEntrypointTypes<kQuickJitUpdateBranchProfile, void, ArtMethod*, uint32_t, uint32_t>();
+}
+
 void LocationsBuilderARM::VisitAnd(HAnd* instruction) { HandleBitwiseOperation(instruction, AND); }
 void LocationsBuilderARM::VisitOr(HOr* instruction) { HandleBitwiseOperation(instruction, ORR); }
 void LocationsBuilderARM::VisitXor(HXor* instruction) { HandleBitwiseOperation(instruction, EOR); }
@@ -62,6 +62,7 @@ using helpers::OperandFromMemOperand;
 using helpers::OutputCPURegister;
 using helpers::OutputFPRegister;
 using helpers::OutputRegister;
+using helpers::QRegisterFrom;
 using helpers::RegisterFrom;
 using helpers::StackOperandFrom;
 using helpers::VIXLRegCodeFromART;
@@ -145,10 +146,16 @@ static void SaveRestoreLiveRegistersHelper(CodeGenerator* codegen,
                                          register_set->GetFloatingPointRegisters(),
                                          codegen->GetNumberOfFloatingPointRegisters()));
 
+  // The callee-save floating point registers only preserve their lower 64 bits, so
+  // live SIMD registers are saved in full, including the callee-save ones.
+  const bool has_simd = codegen->GetGraph()->HasSIMD();
   CPURegList core_list = CPURegList(CPURegister::kRegister, kXRegSize,
       register_set->GetCoreRegisters() & (~callee_saved_core_registers.list()));
-  CPURegList fp_list = CPURegList(CPURegister::kFPRegister, kDRegSize,
-      register_set->GetFloatingPointRegisters() & (~callee_saved_fp_registers.list()));
+  CPURegList fp_list = CPURegList(CPURegister::kFPRegister,
+      has_simd ? kQRegSize : kDRegSize,
+      has_simd
+          ? register_set->GetFloatingPointRegisters()
+          : register_set->GetFloatingPointRegisters() & (~callee_saved_fp_registers.list()));
 
   MacroAssembler* masm = down_cast<CodeGeneratorARM64*>(codegen)->GetVIXLAssembler();
   UseScratchRegisterScope temps(masm);
@@ -157,19 +164,22 @@ static void SaveRestoreLiveRegistersHelper(CodeGenerator* codegen,
   int64_t core_spill_size = core_list.TotalSizeInBytes();
   int64_t fp_spill_size = fp_list.TotalSizeInBytes();
   int64_t reg_size = kXRegSizeInBytes;
-  int64_t max_ls_pair_offset = spill_offset + core_spill_size + fp_spill_size - 2 * reg_size;
+  int64_t fp_reg_size = has_simd ? kQRegSizeInBytes : kDRegSizeInBytes;
+  int64_t max_ls_pair_offset = spill_offset + core_spill_size + fp_spill_size - 2 * fp_reg_size;
   uint32_t ls_access_size = WhichPowerOf2(reg_size);
+  uint32_t fp_ls_access_size = WhichPowerOf2(fp_reg_size);
   if (((core_list.Count() > 1) || (fp_list.Count() > 1)) &&
-      !masm->IsImmLSPair(max_ls_pair_offset, ls_access_size)) {
+      (!masm->IsImmLSPair(spill_offset + core_spill_size - 2 * reg_size, ls_access_size) ||
+       !masm->IsImmLSPair(max_ls_pair_offset, fp_ls_access_size))) {
     // If the offset does not fit in the instruction's immediate field, use an alternate register
     // to compute the base address(float point registers spill base address).
     Register new_base = temps.AcquireSameSizeAs(base);
     __ Add(new_base, base, Operand(spill_offset + core_spill_size));
     base = new_base;
     spill_offset = -core_spill_size;
-    int64_t new_max_ls_pair_offset = fp_spill_size - 2 * reg_size;
+    int64_t new_max_ls_pair_offset = fp_spill_size - 2 * fp_reg_size;
     DCHECK(masm->IsImmLSPair(spill_offset, ls_access_size));
-    DCHECK(masm->IsImmLSPair(new_max_ls_pair_offset, ls_access_size));
+    DCHECK(masm->IsImmLSPair(new_max_ls_pair_offset, fp_ls_access_size));
   }
 
   if (is_save) {
@@ -197,13 +207,14 @@ void SlowPathCodeARM64::SaveLiveRegisters(CodeGenerator* codegen, LocationSummar
     }
   }
 
+  const bool save_all_fp_registers = codegen->GetGraph()->HasSIMD();
   for (size_t i = 0, e = codegen->GetNumberOfFloatingPointRegisters(); i < e; ++i) {
-    if (!codegen->IsFloatingPointCalleeSaveRegister(i) &&
+    if ((!codegen->IsFloatingPointCalleeSaveRegister(i) || save_all_fp_registers) &&
         register_set->ContainsFloatingPointRegister(i)) {
       DCHECK_LT(stack_offset, codegen->GetFrameSize() - codegen->FrameEntrySpillSize());
       DCHECK_LT(i, kMaximumNumberOfExpectedRegisters);
       saved_fpu_stack_offsets_[i] = stack_offset;
-      stack_offset += kDRegSizeInBytes;
+      stack_offset += codegen->GetSlowPathFPWidth();
     }
   }
 
@@ -962,8 +973,11 @@ void ParallelMoveResolverARM64::FinishEmitNativeCode() {
 
 Location ParallelMoveResolverARM64::AllocateScratchLocationFor(Location::Kind kind) {
   DCHECK(kind == Location::kRegister || kind == Location::kFpuRegister ||
-         kind == Location::kStackSlot || kind == Location::kDoubleStackSlot);
-  kind = (kind == Location::kFpuRegister) ? Location::kFpuRegister : Location::kRegister;
+         kind == Location::kStackSlot || kind == Location::kDoubleStackSlot ||
+         kind == Location::kSIMDStackSlot);
+  kind = (kind == Location::kFpuRegister || kind == Location::kSIMDStackSlot)
+      ? Location::kFpuRegister
+      : Location::kRegister;
   Location scratch = GetScratchLocation(kind);
   if (!scratch.Equals(Location::NoLocation())) {
     return scratch;
@@ -1134,15 +1148,15 @@ size_t CodeGeneratorARM64::RestoreCoreRegister(size_t stack_index, uint32_t reg_
 }
 
 size_t CodeGeneratorARM64::SaveFloatingPointRegister(size_t stack_index, uint32_t reg_id) {
-  FPRegister reg = FPRegister(reg_id, kDRegSize);
+  FPRegister reg = FPRegister(reg_id, GetGraph()->HasSIMD() ? kQRegSize : kDRegSize);
   __ Str(reg, MemOperand(sp, stack_index));
-  return kArm64WordSize;
+  return GetSlowPathFPWidth();
 }
 
 size_t CodeGeneratorARM64::RestoreFloatingPointRegister(size_t stack_index, uint32_t reg_id) {
-  FPRegister reg = FPRegister(reg_id, kDRegSize);
+  FPRegister reg = FPRegister(reg_id, GetGraph()->HasSIMD() ? kQRegSize : kDRegSize);
   __ Ldr(reg, MemOperand(sp, stack_index));
-  return kArm64WordSize;
+  return GetSlowPathFPWidth();
 }
 
 void CodeGeneratorARM64::DumpCoreRegister(std::ostream& stream, int reg) const {
@@ -1216,6 +1230,8 @@ void CodeGeneratorARM64::MoveLocation(Location destination,
     if (source.IsStackSlot() || source.IsDoubleStackSlot()) {
       DCHECK(dst.Is64Bits() == source.IsDoubleStackSlot());
       __ Ldr(dst, StackOperandFrom(source));
+    } else if (source.IsSIMDStackSlot()) {
+      __ Ldr(QRegisterFrom(destination), StackOperandFrom(source));
     } else if (source.IsConstant()) {
       DCHECK(CoherentConstantAndType(source, dst_type));
       MoveConstant(dst, source.GetConstant());
@@ -1238,7 +1254,24 @@ void CodeGeneratorARM64::MoveLocation(Location destination,
         __ Fmov(RegisterFrom(destination, dst_type), FPRegisterFrom(source, source_type));
       } else {
         DCHECK(destination.IsFpuRegister());
-        __ Fmov(FPRegister(dst), FPRegisterFrom(source, dst_type));
+        if (GetGraph()->HasSIMD()) {
+          // The register may hold a vector value, move all of its lanes.
+          __ Mov(QRegisterFrom(destination).V16B(), QRegisterFrom(source).V16B());
+        } else {
+          __ Fmov(FPRegister(dst), FPRegisterFrom(source, dst_type));
+        }
+      }
+    }
+  } else if (destination.IsSIMDStackSlot()) {
+    if (source.IsFpuRegister()) {
+      __ Str(QRegisterFrom(source), StackOperandFrom(destination));
+    } else {
+      DCHECK(source.IsSIMDStackSlot());
+      UseScratchRegisterScope temps(GetVIXLAssembler());
+      Register temp = temps.AcquireX();
+      for (size_t offset = 0; offset < kQRegSizeInBytes; offset += kXRegSizeInBytes) {
+        __ Ldr(temp, MemOperand(sp, source.GetStackIndex() + offset));
+        __ Str(temp, MemOperand(sp, destination.GetStackIndex() + offset));
       }
     }
   } else {  // The destination is not a register. It must be a stack slot.
@@ -4156,6 +4189,71 @@ void InstructionCodeGeneratorARM64::VisitMonitorOperation(HMonitorOperation* ins
   }
 }
 
+void LocationsBuilderARM64::VisitUpdateHotness(HUpdateHotness* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, LocationFrom(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(LocationFrom(calling_convention.GetRegisterAt(1)));
+  locations->SetOut(calling_convention.GetReturnLocation(Primitive::kPrimBoolean));
+}
+
+void InstructionCodeGeneratorARM64::VisitUpdateHotness(HUpdateHotness* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register dex_pc_reg = RegisterFrom(locations->GetTemp(0), Primitive::kPrimInt);
+  DCHECK(dex_pc_reg.Is(w1));
+  // The dex pc of the loop header for a back edge, kDexNoIndex for the method entry.
+  uint32_t dex_pc = instruction->IsBackEdge() ? instruction->GetDexPc() : DexFile::kDexNoIndex;
+  __ Mov(dex_pc_reg, dex_pc);
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateHotness),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr);
+  CheckEntrypointTypes<kQuickJitUpdateHotness, uint32_t, ArtMethod*, uint32_t>();
+}
+
+void LocationsBuilderARM64::VisitUpdateInlineCache(HUpdateInlineCache* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, LocationFrom(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, LocationFrom(calling_convention.GetRegisterAt(2)));
+  locations->AddTemp(LocationFrom(calling_convention.GetRegisterAt(1)));
+}
+
+void InstructionCodeGeneratorARM64::VisitUpdateInlineCache(HUpdateInlineCache* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register dex_pc = RegisterFrom(locations->GetTemp(0), Primitive::kPrimInt);
+  DCHECK(dex_pc.Is(w1));
+  __ Mov(dex_pc, instruction->GetDexPc());
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateInlineCache),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr);
+  CheckEntrypointTypes<kQuickJitUpdateInlineCache, void, ArtMethod*, uint32_t, mirror::Object*>();
+}
+
+void LocationsBuilderARM64::VisitUpdateBranchProfile(HUpdateBranchProfile* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, LocationFrom(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, LocationFrom(calling_convention.GetRegisterAt(2)));
+  locations->AddTemp(LocationFrom(calling_convention.GetRegisterAt(1)));
+}
+
+void InstructionCodeGeneratorARM64::VisitUpdateBranchProfile(HUpdateBranchProfile* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register dex_pc = RegisterFrom(locations->GetTemp(0), Primitive::kPrimInt);
+  DCHECK(dex_pc.Is(w1));
+  __ Mov(dex_pc, instruction->GetDexPc());
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateBranchProfile),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr);
+  CheckEntrypointTypes<kQuickJitUpdateBranchProfile, void, ArtMethod*, uint32_t, uint32_t>();
+}
+
 void LocationsBuilderARM64::VisitMul(HMul* mul) {
   LocationSummary* locations =
       new (GetGraph()->GetArena()) LocationSummary(mul, LocationSummary::kNoCall);
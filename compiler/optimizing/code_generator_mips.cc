@@ -4100,6 +4100,68 @@ void InstructionCodeGeneratorMIPS::VisitMonitorOperation(HMonitorOperation* inst
   CheckEntrypointTypes<kQuickUnlockObject, void, mirror::Object*>();
 }
 
+void LocationsBuilderMIPS::VisitUpdateHotness(HUpdateHotness* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(Location::RegisterLocation(calling_convention.GetRegisterAt(1)));
+  locations->SetOut(calling_convention.GetReturnLocation(Primitive::kPrimBoolean));
+}
+
+void InstructionCodeGeneratorMIPS::VisitUpdateHotness(HUpdateHotness* instruction) {
+  InvokeRuntimeCallingConvention calling_convention;
+  // The dex pc of the loop header for a back edge, kDexNoIndex for the method entry.
+  uint32_t dex_pc = instruction->IsBackEdge() ? instruction->GetDexPc() : DexFile::kDexNoIndex;
+  __ LoadConst32(calling_convention.GetRegisterAt(1), dex_pc);
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateHotness),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr,
+                          IsDirectEntrypoint(kQuickJitUpdateHotness));
+  CheckEntrypointTypes<kQuickJitUpdateHotness, uint32_t, ArtMethod*, uint32_t>();
+}
+
+void LocationsBuilderMIPS::VisitUpdateInlineCache(HUpdateInlineCache* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, Location::RegisterLocation(calling_convention.GetRegisterAt(2)));
+  locations->AddTemp(Location::RegisterLocation(calling_convention.GetRegisterAt(1)));
+}
+
+void InstructionCodeGeneratorMIPS::VisitUpdateInlineCache(HUpdateInlineCache* instruction) {
+  InvokeRuntimeCallingConvention calling_convention;
+  __ LoadConst32(calling_convention.GetRegisterAt(1), instruction->GetDexPc());
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateInlineCache),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr,
+                          IsDirectEntrypoint(kQuickJitUpdateInlineCache));
+  CheckEntrypointTypes<kQuickJitUpdateInlineCache, void, ArtMethod*, uint32_t, mirror::Object*>();
+}
+
+void LocationsBuilderMIPS::VisitUpdateBranchProfile(HUpdateBranchProfile* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, Location::RegisterLocation(calling_convention.GetRegisterAt(2)));
+  locations->AddTemp(Location::RegisterLocation(calling_convention.GetRegisterAt(1)));
+}
+
+void InstructionCodeGeneratorMIPS::VisitUpdateBranchProfile(HUpdateBranchProfile* instruction) {
+  InvokeRuntimeCallingConvention calling_convention;
+  __ LoadConst32(calling_convention.GetRegisterAt(1), instruction->GetDexPc());
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateBranchProfile),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr,
+                          IsDirectEntrypoint(kQuickJitUpdateBranchProfile));
+  CheckEntrypointTypes<kQuickJitUpdateBranchProfile, void, ArtMethod*, uint32_t, uint32_t>();
+}
+
 void LocationsBuilderMIPS::VisitMul(HMul* mul) {
   LocationSummary* locations =
       new (GetGraph()->GetArena()) LocationSummary(mul, LocationSummary::kNoCall);
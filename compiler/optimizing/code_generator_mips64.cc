@@ -3318,6 +3318,65 @@ void InstructionCodeGeneratorMIPS64::VisitMonitorOperation(HMonitorOperation* in
   }
 }
 
+void LocationsBuilderMIPS64::VisitUpdateHotness(HUpdateHotness* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(Location::RegisterLocation(calling_convention.GetRegisterAt(1)));
+  locations->SetOut(calling_convention.GetReturnLocation(Primitive::kPrimBoolean));
+}
+
+void InstructionCodeGeneratorMIPS64::VisitUpdateHotness(HUpdateHotness* instruction) {
+  GpuRegister dex_pc_reg = instruction->GetLocations()->GetTemp(0).AsRegister<GpuRegister>();
+  // The dex pc of the loop header for a back edge, kDexNoIndex for the method entry.
+  uint32_t dex_pc = instruction->IsBackEdge() ? instruction->GetDexPc() : DexFile::kDexNoIndex;
+  __ LoadConst32(dex_pc_reg, dex_pc);
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateHotness),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr);
+  CheckEntrypointTypes<kQuickJitUpdateHotness, uint32_t, ArtMethod*, uint32_t>();
+}
+
+void LocationsBuilderMIPS64::VisitUpdateInlineCache(HUpdateInlineCache* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, Location::RegisterLocation(calling_convention.GetRegisterAt(2)));
+  locations->AddTemp(Location::RegisterLocation(calling_convention.GetRegisterAt(1)));
+}
+
+void InstructionCodeGeneratorMIPS64::VisitUpdateInlineCache(HUpdateInlineCache* instruction) {
+  GpuRegister dex_pc = instruction->GetLocations()->GetTemp(0).AsRegister<GpuRegister>();
+  __ LoadConst32(dex_pc, instruction->GetDexPc());
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateInlineCache),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr);
+  CheckEntrypointTypes<kQuickJitUpdateInlineCache, void, ArtMethod*, uint32_t, mirror::Object*>();
+}
+
+void LocationsBuilderMIPS64::VisitUpdateBranchProfile(HUpdateBranchProfile* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, Location::RegisterLocation(calling_convention.GetRegisterAt(2)));
+  locations->AddTemp(Location::RegisterLocation(calling_convention.GetRegisterAt(1)));
+}
+
+void InstructionCodeGeneratorMIPS64::VisitUpdateBranchProfile(HUpdateBranchProfile* instruction) {
+  GpuRegister dex_pc = instruction->GetLocations()->GetTemp(0).AsRegister<GpuRegister>();
+  __ LoadConst32(dex_pc, instruction->GetDexPc());
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateBranchProfile),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr);
+  CheckEntrypointTypes<kQuickJitUpdateBranchProfile, void, ArtMethod*, uint32_t, uint32_t>();
+}
+
 void LocationsBuilderMIPS64::VisitMul(HMul* mul) {
   LocationSummary* locations =
       new (GetGraph()->GetArena()) LocationSummary(mul, LocationSummary::kNoCall);
@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "code_generator_arm64.h"
+
+#include "common_arm64.h"
+#include "mirror/array-inl.h"
+
+using namespace vixl;   // NOLINT(build/namespaces)
+
+namespace art {
+namespace arm64 {
+
+using helpers::HeapOperand;
+using helpers::Int64ConstantFrom;
+using helpers::InputRegisterAt;
+using helpers::OutputRegister;
+using helpers::QRegisterFrom;
+using helpers::WRegisterFrom;
+using helpers::XRegisterFrom;
+
+#define __ GetVIXLAssembler()->
+
+void LocationsBuilderARM64::VisitVecReplicateScalar(HVecReplicateScalar* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong:
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetOut(Location::RequiresFpuRegister());
+      break;
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      locations->SetInAt(0, Location::RequiresFpuRegister());
+      locations->SetOut(Location::RequiresFpuRegister());
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type " << instruction->GetPackedType();
+      UNREACHABLE();
+  }
+}
+
+void InstructionCodeGeneratorARM64::VisitVecReplicateScalar(HVecReplicateScalar* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  FPRegister dst = QRegisterFrom(locations->Out());
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+      DCHECK_EQ(16u, instruction->GetVectorLength());
+      __ Dup(dst.V16B(), InputRegisterAt(instruction, 0));
+      break;
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      DCHECK_EQ(8u, instruction->GetVectorLength());
+      __ Dup(dst.V8H(), InputRegisterAt(instruction, 0));
+      break;
+    case Primitive::kPrimInt:
+      DCHECK_EQ(4u, instruction->GetVectorLength());
+      __ Dup(dst.V4S(), InputRegisterAt(instruction, 0));
+      break;
+    case Primitive::kPrimLong:
+      DCHECK_EQ(2u, instruction->GetVectorLength());
+      __ Dup(dst.V2D(), XRegisterFrom(locations->InAt(0)));
+      break;
+    case Primitive::kPrimFloat:
+      DCHECK_EQ(4u, instruction->GetVectorLength());
+      __ Dup(dst.V4S(), QRegisterFrom(locations->InAt(0)).V4S(), 0);
+      break;
+    case Primitive::kPrimDouble:
+      DCHECK_EQ(2u, instruction->GetVectorLength());
+      __ Dup(dst.V2D(), QRegisterFrom(locations->InAt(0)).V2D(), 0);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type " << instruction->GetPackedType();
+      UNREACHABLE();
+  }
+}
+
+void LocationsBuilderARM64::VisitVecReduce(HVecReduce* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresFpuRegister());
+  locations->SetOut(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+}
+
+void InstructionCodeGeneratorARM64::VisitVecReduce(HVecReduce* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  FPRegister src = QRegisterFrom(locations->InAt(0));
+  FPRegister tmp = QRegisterFrom(locations->GetTemp(0));
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimInt:
+      DCHECK_EQ(4u, instruction->GetVectorLength());
+      __ Addv(tmp.S(), src.V4S());
+      __ Umov(OutputRegister(instruction), tmp.V4S(), 0);
+      break;
+    case Primitive::kPrimLong:
+      DCHECK_EQ(2u, instruction->GetVectorLength());
+      __ Addp(tmp.D(), src.V2D());
+      __ Umov(OutputRegister(instruction), tmp.V2D(), 0);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type " << instruction->GetPackedType();
+      UNREACHABLE();
+  }
+}
+
+// Helper to set up locations for vector binary operations.
+static void CreateVecBinOpLocations(ArenaAllocator* arena, HVecBinaryOperation* instruction) {
+  LocationSummary* locations = new (arena) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresFpuRegister());
+  locations->SetInAt(1, Location::RequiresFpuRegister());
+  locations->SetOut(Location::RequiresFpuRegister(), Location::kNoOutputOverlap);
+}
+
+void LocationsBuilderARM64::VisitVecAdd(HVecAdd* instruction) {
+  CreateVecBinOpLocations(GetGraph()->GetArena(), instruction);
+}
+
+void InstructionCodeGeneratorARM64::VisitVecAdd(HVecAdd* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  FPRegister lhs = QRegisterFrom(locations->InAt(0));
+  FPRegister rhs = QRegisterFrom(locations->InAt(1));
+  FPRegister dst = QRegisterFrom(locations->Out());
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+      __ Add(dst.V16B(), lhs.V16B(), rhs.V16B());
+      break;
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      __ Add(dst.V8H(), lhs.V8H(), rhs.V8H());
+      break;
+    case Primitive::kPrimInt:
+      __ Add(dst.V4S(), lhs.V4S(), rhs.V4S());
+      break;
+    case Primitive::kPrimLong:
+      __ Add(dst.V2D(), lhs.V2D(), rhs.V2D());
+      break;
+    case Primitive::kPrimFloat:
+      __ Fadd(dst.V4S(), lhs.V4S(), rhs.V4S());
+      break;
+    case Primitive::kPrimDouble:
+      __ Fadd(dst.V2D(), lhs.V2D(), rhs.V2D());
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type " << instruction->GetPackedType();
+      UNREACHABLE();
+  }
+}
+
+void LocationsBuilderARM64::VisitVecSub(HVecSub* instruction) {
+  CreateVecBinOpLocations(GetGraph()->GetArena(), instruction);
+}
+
+void InstructionCodeGeneratorARM64::VisitVecSub(HVecSub* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  FPRegister lhs = QRegisterFrom(locations->InAt(0));
+  FPRegister rhs = QRegisterFrom(locations->InAt(1));
+  FPRegister dst = QRegisterFrom(locations->Out());
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+      __ Sub(dst.V16B(), lhs.V16B(), rhs.V16B());
+      break;
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      __ Sub(dst.V8H(), lhs.V8H(), rhs.V8H());
+      break;
+    case Primitive::kPrimInt:
+      __ Sub(dst.V4S(), lhs.V4S(), rhs.V4S());
+      break;
+    case Primitive::kPrimLong:
+      __ Sub(dst.V2D(), lhs.V2D(), rhs.V2D());
+      break;
+    case Primitive::kPrimFloat:
+      __ Fsub(dst.V4S(), lhs.V4S(), rhs.V4S());
+      break;
+    case Primitive::kPrimDouble:
+      __ Fsub(dst.V2D(), lhs.V2D(), rhs.V2D());
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type " << instruction->GetPackedType();
+      UNREACHABLE();
+  }
+}
+
+void LocationsBuilderARM64::VisitVecMul(HVecMul* instruction) {
+  CreateVecBinOpLocations(GetGraph()->GetArena(), instruction);
+}
+
+void InstructionCodeGeneratorARM64::VisitVecMul(HVecMul* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  FPRegister lhs = QRegisterFrom(locations->InAt(0));
+  FPRegister rhs = QRegisterFrom(locations->InAt(1));
+  FPRegister dst = QRegisterFrom(locations->Out());
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      __ Mul(dst.V8H(), lhs.V8H(), rhs.V8H());
+      break;
+    case Primitive::kPrimInt:
+      __ Mul(dst.V4S(), lhs.V4S(), rhs.V4S());
+      break;
+    case Primitive::kPrimFloat:
+      __ Fmul(dst.V4S(), lhs.V4S(), rhs.V4S());
+      break;
+    case Primitive::kPrimDouble:
+      __ Fmul(dst.V2D(), lhs.V2D(), rhs.V2D());
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type " << instruction->GetPackedType();
+      UNREACHABLE();
+  }
+}
+
+void LocationsBuilderARM64::VisitVecAnd(HVecAnd* instruction) {
+  CreateVecBinOpLocations(GetGraph()->GetArena(), instruction);
+}
+
+void InstructionCodeGeneratorARM64::VisitVecAnd(HVecAnd* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  // Bitwise operations do not depend on the packed type.
+  __ And(QRegisterFrom(locations->Out()).V16B(),
+         QRegisterFrom(locations->InAt(0)).V16B(),
+         QRegisterFrom(locations->InAt(1)).V16B());
+}
+
+void LocationsBuilderARM64::VisitVecOr(HVecOr* instruction) {
+  CreateVecBinOpLocations(GetGraph()->GetArena(), instruction);
+}
+
+void InstructionCodeGeneratorARM64::VisitVecOr(HVecOr* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  __ Orr(QRegisterFrom(locations->Out()).V16B(),
+         QRegisterFrom(locations->InAt(0)).V16B(),
+         QRegisterFrom(locations->InAt(1)).V16B());
+}
+
+void LocationsBuilderARM64::VisitVecXor(HVecXor* instruction) {
+  CreateVecBinOpLocations(GetGraph()->GetArena(), instruction);
+}
+
+void InstructionCodeGeneratorARM64::VisitVecXor(HVecXor* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  __ Eor(QRegisterFrom(locations->Out()).V16B(),
+         QRegisterFrom(locations->InAt(0)).V16B(),
+         QRegisterFrom(locations->InAt(1)).V16B());
+}
+
+// Helper to set up locations for vector memory operations.
+static void CreateVecMemLocations(ArenaAllocator* arena,
+                                  HVecMemoryOperation* instruction,
+                                  bool is_load) {
+  LocationSummary* locations = new (arena) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RegisterOrConstant(instruction->InputAt(1)));
+  if (is_load) {
+    locations->SetOut(Location::RequiresFpuRegister());
+  } else {
+    locations->SetInAt(2, Location::RequiresFpuRegister());
+  }
+}
+
+// Helper to compute the address of the first element accessed by a vector memory operation.
+// Q register loads and stores only scale a register offset by 16, so the index is added
+// to the base first, in `temp`, when it is not a constant.
+static MemOperand VecAddress(MacroAssembler* masm,
+                             HVecMemoryOperation* instruction,
+                             const Register& temp) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register base = InputRegisterAt(instruction, 0);
+  Location index = locations->InAt(1);
+  Primitive::Type packed_type = instruction->GetPackedType();
+  uint32_t offset = mirror::Array::DataOffset(Primitive::ComponentSize(packed_type)).Uint32Value();
+  size_t shift = Primitive::ComponentSizeShift(packed_type);
+  if (index.IsConstant()) {
+    offset += Int64ConstantFrom(index) << shift;
+    return HeapOperand(base, offset);
+  }
+  masm->Add(temp, base, Operand(WRegisterFrom(index), LSL, shift));
+  return HeapOperand(temp, offset);
+}
+
+void LocationsBuilderARM64::VisitVecLoad(HVecLoad* instruction) {
+  CreateVecMemLocations(GetGraph()->GetArena(), instruction, /* is_load */ true);
+}
+
+void InstructionCodeGeneratorARM64::VisitVecLoad(HVecLoad* instruction) {
+  MacroAssembler* masm = GetVIXLAssembler();
+  UseScratchRegisterScope temps(masm);
+  Register temp = temps.AcquireW();
+  __ Ldr(QRegisterFrom(instruction->GetLocations()->Out()), VecAddress(masm, instruction, temp));
+}
+
+void LocationsBuilderARM64::VisitVecStore(HVecStore* instruction) {
+  CreateVecMemLocations(GetGraph()->GetArena(), instruction, /* is_load */ false);
+}
+
+void InstructionCodeGeneratorARM64::VisitVecStore(HVecStore* instruction) {
+  MacroAssembler* masm = GetVIXLAssembler();
+  UseScratchRegisterScope temps(masm);
+  Register temp = temps.AcquireW();
+  __ Str(QRegisterFrom(instruction->GetLocations()->InAt(2)), VecAddress(masm, instruction, temp));
+}
+
+#undef __
+
+}  // namespace arm64
+}  // namespace art
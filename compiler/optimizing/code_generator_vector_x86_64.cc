@@ -0,0 +1,338 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "code_generator_x86_64.h"
+
+#include "mirror/array-inl.h"
+
+namespace art {
+namespace x86_64 {
+
+// NOLINT on __ macro to suppress wrong warning/fix from clang-tidy.
+#define __ down_cast<X86_64Assembler*>(GetAssembler())->  // NOLINT
+
+void LocationsBuilderX86_64::VisitVecReplicateScalar(HVecReplicateScalar* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong:
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetOut(Location::RequiresFpuRegister());
+      break;
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      locations->SetInAt(0, Location::RequiresFpuRegister());
+      locations->SetOut(Location::RequiresFpuRegister());
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type " << instruction->GetPackedType();
+      UNREACHABLE();
+  }
+}
+
+void InstructionCodeGeneratorX86_64::VisitVecReplicateScalar(HVecReplicateScalar* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  XmmRegister out = locations->Out().AsFpuRegister<XmmRegister>();
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+      DCHECK_EQ(16u, instruction->GetVectorLength());
+      __ movd(out, locations->InAt(0).AsRegister<CpuRegister>(), /* is64bit */ false);
+      __ punpcklbw(out, out);
+      __ punpcklwd(out, out);
+      __ pshufd(out, out, Immediate(0));
+      break;
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      DCHECK_EQ(8u, instruction->GetVectorLength());
+      __ movd(out, locations->InAt(0).AsRegister<CpuRegister>(), /* is64bit */ false);
+      __ punpcklwd(out, out);
+      __ pshufd(out, out, Immediate(0));
+      break;
+    case Primitive::kPrimInt:
+      DCHECK_EQ(4u, instruction->GetVectorLength());
+      __ movd(out, locations->InAt(0).AsRegister<CpuRegister>(), /* is64bit */ false);
+      __ pshufd(out, out, Immediate(0));
+      break;
+    case Primitive::kPrimLong:
+      DCHECK_EQ(2u, instruction->GetVectorLength());
+      __ movd(out, locations->InAt(0).AsRegister<CpuRegister>(), /* is64bit */ true);
+      __ punpcklqdq(out, out);
+      break;
+    case Primitive::kPrimFloat:
+      DCHECK_EQ(4u, instruction->GetVectorLength());
+      __ pshufd(out, locations->InAt(0).AsFpuRegister<XmmRegister>(), Immediate(0));
+      break;
+    case Primitive::kPrimDouble:
+      DCHECK_EQ(2u, instruction->GetVectorLength());
+      __ pshufd(out, locations->InAt(0).AsFpuRegister<XmmRegister>(), Immediate(0x44));
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type " << instruction->GetPackedType();
+      UNREACHABLE();
+  }
+}
+
+void LocationsBuilderX86_64::VisitVecReduce(HVecReduce* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresFpuRegister());
+  locations->SetOut(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+}
+
+void InstructionCodeGeneratorX86_64::VisitVecReduce(HVecReduce* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  XmmRegister src = locations->InAt(0).AsFpuRegister<XmmRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+  XmmRegister tmp = locations->GetTemp(0).AsFpuRegister<XmmRegister>();
+  XmmRegister tmp2 = locations->GetTemp(1).AsFpuRegister<XmmRegister>();
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimInt:
+      DCHECK_EQ(4u, instruction->GetVectorLength());
+      // Add the high half to the low half, then the second lane to the first one.
+      __ pshufd(tmp, src, Immediate(0x4E));
+      __ paddd(tmp, src);
+      __ pshufd(tmp2, tmp, Immediate(0xB1));
+      __ paddd(tmp, tmp2);
+      __ movd(out, tmp, /* is64bit */ false);
+      break;
+    case Primitive::kPrimLong:
+      DCHECK_EQ(2u, instruction->GetVectorLength());
+      __ pshufd(tmp, src, Immediate(0x4E));
+      __ paddq(tmp, src);
+      __ movd(out, tmp, /* is64bit */ true);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type " << instruction->GetPackedType();
+      UNREACHABLE();
+  }
+}
+
+// Helper to set up locations for vector binary operations.
+static void CreateVecBinOpLocations(ArenaAllocator* arena, HVecBinaryOperation* instruction) {
+  LocationSummary* locations = new (arena) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresFpuRegister());
+  locations->SetInAt(1, Location::RequiresFpuRegister());
+  locations->SetOut(Location::SameAsFirstInput());
+}
+
+void LocationsBuilderX86_64::VisitVecAdd(HVecAdd* instruction) {
+  CreateVecBinOpLocations(GetGraph()->GetArena(), instruction);
+}
+
+void InstructionCodeGeneratorX86_64::VisitVecAdd(HVecAdd* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  DCHECK(locations->InAt(0).Equals(locations->Out()));
+  XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  XmmRegister src = locations->InAt(1).AsFpuRegister<XmmRegister>();
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+      __ paddb(dst, src);
+      break;
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      __ paddw(dst, src);
+      break;
+    case Primitive::kPrimInt:
+      __ paddd(dst, src);
+      break;
+    case Primitive::kPrimLong:
+      __ paddq(dst, src);
+      break;
+    case Primitive::kPrimFloat:
+      __ addps(dst, src);
+      break;
+    case Primitive::kPrimDouble:
+      __ addpd(dst, src);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type " << instruction->GetPackedType();
+      UNREACHABLE();
+  }
+}
+
+void LocationsBuilderX86_64::VisitVecSub(HVecSub* instruction) {
+  CreateVecBinOpLocations(GetGraph()->GetArena(), instruction);
+}
+
+void InstructionCodeGeneratorX86_64::VisitVecSub(HVecSub* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  DCHECK(locations->InAt(0).Equals(locations->Out()));
+  XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  XmmRegister src = locations->InAt(1).AsFpuRegister<XmmRegister>();
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+      __ psubb(dst, src);
+      break;
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      __ psubw(dst, src);
+      break;
+    case Primitive::kPrimInt:
+      __ psubd(dst, src);
+      break;
+    case Primitive::kPrimLong:
+      __ psubq(dst, src);
+      break;
+    case Primitive::kPrimFloat:
+      __ subps(dst, src);
+      break;
+    case Primitive::kPrimDouble:
+      __ subpd(dst, src);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type " << instruction->GetPackedType();
+      UNREACHABLE();
+  }
+}
+
+void LocationsBuilderX86_64::VisitVecMul(HVecMul* instruction) {
+  CreateVecBinOpLocations(GetGraph()->GetArena(), instruction);
+}
+
+void InstructionCodeGeneratorX86_64::VisitVecMul(HVecMul* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  DCHECK(locations->InAt(0).Equals(locations->Out()));
+  XmmRegister dst = locations->Out().AsFpuRegister<XmmRegister>();
+  XmmRegister src = locations->InAt(1).AsFpuRegister<XmmRegister>();
+  switch (instruction->GetPackedType()) {
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      __ pmullw(dst, src);
+      break;
+    case Primitive::kPrimInt:
+      // The loop optimization only vectorizes integer multiplications with SSE4.1.
+      DCHECK(codegen_->GetInstructionSetFeatures().HasSSE4_1());
+      __ pmulld(dst, src);
+      break;
+    case Primitive::kPrimFloat:
+      __ mulps(dst, src);
+      break;
+    case Primitive::kPrimDouble:
+      __ mulpd(dst, src);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported SIMD type " << instruction->GetPackedType();
+      UNREACHABLE();
+  }
+}
+
+void LocationsBuilderX86_64::VisitVecAnd(HVecAnd* instruction) {
+  CreateVecBinOpLocations(GetGraph()->GetArena(), instruction);
+}
+
+void InstructionCodeGeneratorX86_64::VisitVecAnd(HVecAnd* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  DCHECK(locations->InAt(0).Equals(locations->Out()));
+  // Bitwise operations do not depend on the packed type.
+  __ pand(locations->Out().AsFpuRegister<XmmRegister>(),
+          locations->InAt(1).AsFpuRegister<XmmRegister>());
+}
+
+void LocationsBuilderX86_64::VisitVecOr(HVecOr* instruction) {
+  CreateVecBinOpLocations(GetGraph()->GetArena(), instruction);
+}
+
+void InstructionCodeGeneratorX86_64::VisitVecOr(HVecOr* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  DCHECK(locations->InAt(0).Equals(locations->Out()));
+  __ por(locations->Out().AsFpuRegister<XmmRegister>(),
+         locations->InAt(1).AsFpuRegister<XmmRegister>());
+}
+
+void LocationsBuilderX86_64::VisitVecXor(HVecXor* instruction) {
+  CreateVecBinOpLocations(GetGraph()->GetArena(), instruction);
+}
+
+void InstructionCodeGeneratorX86_64::VisitVecXor(HVecXor* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  DCHECK(locations->InAt(0).Equals(locations->Out()));
+  __ pxor(locations->Out().AsFpuRegister<XmmRegister>(),
+          locations->InAt(1).AsFpuRegister<XmmRegister>());
+}
+
+// Helper to set up locations for vector memory operations.
+static void CreateVecMemLocations(ArenaAllocator* arena,
+                                  HVecMemoryOperation* instruction,
+                                  bool is_load) {
+  LocationSummary* locations = new (arena) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RegisterOrConstant(instruction->InputAt(1)));
+  if (is_load) {
+    locations->SetOut(Location::RequiresFpuRegister());
+  } else {
+    locations->SetInAt(2, Location::RequiresFpuRegister());
+  }
+}
+
+// Helper to compute the address of the first element accessed by a vector memory operation.
+static Address VecAddress(LocationSummary* locations, Primitive::Type packed_type) {
+  CpuRegister base = locations->InAt(0).AsRegister<CpuRegister>();
+  Location index = locations->InAt(1);
+  size_t size = Primitive::ComponentSize(packed_type);
+  uint32_t data_offset = mirror::Array::DataOffset(size).Uint32Value();
+  if (index.IsConstant()) {
+    int32_t value = index.GetConstant()->AsIntConstant()->GetValue();
+    return Address(base, (value << Primitive::ComponentSizeShift(packed_type)) + data_offset);
+  }
+  ScaleFactor scale = static_cast<ScaleFactor>(Primitive::ComponentSizeShift(packed_type));
+  return Address(base, index.AsRegister<CpuRegister>(), scale, data_offset);
+}
+
+void LocationsBuilderX86_64::VisitVecLoad(HVecLoad* instruction) {
+  CreateVecMemLocations(GetGraph()->GetArena(), instruction, /* is_load */ true);
+}
+
+void InstructionCodeGeneratorX86_64::VisitVecLoad(HVecLoad* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Primitive::Type packed_type = instruction->GetPackedType();
+  Address address = VecAddress(locations, packed_type);
+  XmmRegister reg = locations->Out().AsFpuRegister<XmmRegister>();
+  // Array elements are only guaranteed to be 8-byte aligned, use unaligned accesses.
+  if (Primitive::IsFloatingPointType(packed_type)) {
+    __ movups(reg, address);
+  } else {
+    __ movdqu(reg, address);
+  }
+}
+
+void LocationsBuilderX86_64::VisitVecStore(HVecStore* instruction) {
+  CreateVecMemLocations(GetGraph()->GetArena(), instruction, /* is_load */ false);
+}
+
+void InstructionCodeGeneratorX86_64::VisitVecStore(HVecStore* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Primitive::Type packed_type = instruction->GetPackedType();
+  Address address = VecAddress(locations, packed_type);
+  XmmRegister reg = locations->InAt(2).AsFpuRegister<XmmRegister>();
+  if (Primitive::IsFloatingPointType(packed_type)) {
+    __ movups(address, reg);
+  } else {
+    __ movdqu(address, reg);
+  }
+}
+
+#undef __
+
+}  // namespace x86_64
+}  // namespace art
@@ -6580,6 +6580,65 @@ void InstructionCodeGeneratorX86::VisitMonitorOperation(HMonitorOperation* instr
   }
 }
 
+void LocationsBuilderX86::VisitUpdateHotness(HUpdateHotness* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(Location::RegisterLocation(calling_convention.GetRegisterAt(1)));
+  locations->SetOut(Location::RegisterLocation(EAX));
+}
+
+void InstructionCodeGeneratorX86::VisitUpdateHotness(HUpdateHotness* instruction) {
+  InvokeRuntimeCallingConvention calling_convention;
+  // The dex pc of the loop header for a back edge, kDexNoIndex for the method entry.
+  uint32_t dex_pc = instruction->IsBackEdge() ? instruction->GetDexPc() : DexFile::kDexNoIndex;
+  __ movl(calling_convention.GetRegisterAt(1), Immediate(dex_pc));
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateHotness),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr);
+  CheckEntrypointTypes<kQuickJitUpdateHotness, uint32_t, ArtMethod*, uint32_t>();
+}
+
+void LocationsBuilderX86::VisitUpdateInlineCache(HUpdateInlineCache* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, Location::RegisterLocation(calling_convention.GetRegisterAt(2)));
+  locations->AddTemp(Location::RegisterLocation(calling_convention.GetRegisterAt(1)));
+}
+
+void InstructionCodeGeneratorX86::VisitUpdateInlineCache(HUpdateInlineCache* instruction) {
+  InvokeRuntimeCallingConvention calling_convention;
+  __ movl(calling_convention.GetRegisterAt(1), Immediate(instruction->GetDexPc()));
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateInlineCache),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr);
+  CheckEntrypointTypes<kQuickJitUpdateInlineCache, void, ArtMethod*, uint32_t, mirror::Object*>();
+}
+
+void LocationsBuilderX86::VisitUpdateBranchProfile(HUpdateBranchProfile* instruction) {
+  LocationSummary* locations =
+      new (GetGraph()->GetArena()) LocationSummary(instruction, LocationSummary::kCall);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, Location::RegisterLocation(calling_convention.GetRegisterAt(2)));
+  locations->AddTemp(Location::RegisterLocation(calling_convention.GetRegisterAt(1)));
+}
+
+void InstructionCodeGeneratorX86::VisitUpdateBranchProfile(HUpdateBranchProfile* instruction) {
+  InvokeRuntimeCallingConvention calling_convention;
+  __ movl(calling_convention.GetRegisterAt(1), Immediate(instruction->GetDexPc()));
+  codegen_->InvokeRuntime(QUICK_ENTRY_POINT(pJitUpdateBranchProfile),
+                          instruction,
+                          instruction->GetDexPc(),
+                          nullptr);
+  CheckEntrypointTypes<kQuickJitUpdateBranchProfile, void, ArtMethod*, uint32_t, uint32_t>();
+}
+
 void LocationsBuilderX86::VisitAnd(HAnd* instruction) { HandleBitwiseOperation(instruction); }
 void LocationsBuilderX86::VisitOr(HOr* instruction) { HandleBitwiseOperation(instruction); }
 void LocationsBuilderX86::VisitXor(HXor* instruction) { HandleBitwiseOperation(instruction); }
@@ -81,6 +81,11 @@ static inline vixl::FPRegister DRegisterFrom(Location location) {
   return vixl::FPRegister::DRegFromCode(location.reg());
 }
 
+static inline vixl::FPRegister QRegisterFrom(Location location) {
+  DCHECK(location.IsFpuRegister()) << location;
+  return vixl::FPRegister::QRegFromCode(location.reg());
+}
+
 static inline vixl::FPRegister SRegisterFrom(Location location) {
   DCHECK(location.IsFpuRegister()) << location;
   return vixl::FPRegister::SRegFromCode(location.reg());
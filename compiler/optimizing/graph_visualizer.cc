@@ -313,6 +313,8 @@ class HGraphVisualizerPrinter : public HGraphDelegateVisitor {
       codegen_.DumpCoreRegister(stream, location.high());
     } else if (location.IsUnallocated()) {
       stream << "unallocated";
+    } else if (location.IsSIMDStackSlot()) {
+      stream << "4x" << location.GetStackIndex() << "(sp)";
     } else {
       DCHECK(location.IsDoubleStackSlot());
       stream << "2x" << location.GetStackIndex() << "(sp)";
@@ -467,6 +469,11 @@ class HGraphVisualizerPrinter : public HGraphDelegateVisitor {
     StartAttributeStream("kind") << (try_boundary->IsEntry() ? "entry" : "exit");
   }
 
+  void VisitVecOperation(HVecOperation* vec_operation) OVERRIDE {
+    StartAttributeStream("packed_type") << vec_operation->GetPackedType();
+    StartAttributeStream("vector_length") << vec_operation->GetVectorLength();
+  }
+
 #if defined(ART_ENABLE_CODEGEN_arm) || defined(ART_ENABLE_CODEGEN_arm64)
   void VisitMultiplyAccumulate(HMultiplyAccumulate* instruction) OVERRIDE {
     StartAttributeStream("kind") << instruction->GetOpKind();
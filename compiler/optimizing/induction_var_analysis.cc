@@ -83,8 +83,8 @@ static Primitive::Type Narrowest(Primitive::Type type1, Primitive::Type type2) {
 // Class methods.
 //
 
-HInductionVarAnalysis::HInductionVarAnalysis(HGraph* graph)
-    : HOptimization(graph, kInductionPassName),
+HInductionVarAnalysis::HInductionVarAnalysis(HGraph* graph, const char* name)
+    : HOptimization(graph, name),
       global_depth_(0),
       stack_(graph->GetArena()->Adapter(kArenaAllocInductionVarAnalysis)),
       scc_(graph->GetArena()->Adapter(kArenaAllocInductionVarAnalysis)),
@@ -220,6 +220,16 @@ void InductionVarRange::GenerateTakenTest(HInstruction* context,
   }
 }
 
+bool InductionVarRange::IsConstantTripCount(HLoopInformation* loop,
+                                            /*out*/ int64_t* trip_count) const {
+  HInductionVarAnalysis::InductionInfo* trip =
+      induction_analysis_->LookupInfo(loop, loop->GetHeader()->GetLastInstruction());
+  return trip != nullptr &&
+      trip->operation == HInductionVarAnalysis::kTripCountInLoop &&
+      IsConstant(trip->op_a, kExact, trip_count) &&
+      *trip_count > 0;
+}
+
 //
 // Private class methods.
 //
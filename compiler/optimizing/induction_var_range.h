@@ -116,6 +116,12 @@ class InductionVarRange {
                          HBasicBlock* block,
                          /*out*/ HInstruction** taken_test);
 
+  /**
+   * Returns true if the given loop is known to be taken and finite, with a body executed
+   * a constant number of times, which is returned in trip_count.
+   */
+  bool IsConstantTripCount(HLoopInformation* loop, /*out*/ int64_t* trip_count) const;
+
  private:
   /*
    * Enum used in IsConstant() request.
@@ -54,6 +54,10 @@ static constexpr size_t kMaximumNumberOfCumulatedDexRegisters = 64;
 // Avoid inlining within a huge method due to memory pressure.
 static constexpr size_t kMaximumCodeUnitSize = 4096;
 
+// Receiver types seen in less than this percentage of the calls recorded by an
+// inline cache are not inlined, and are left to the virtual or interface dispatch.
+static constexpr uint64_t kMinimumInlinedReceiverPercentage = 10;
+
 void HInliner::Run() {
   const CompilerOptions& compiler_options = compiler_driver_->GetCompilerOptions();
   if ((compiler_options.GetInlineDepthLimit() == 0)
@@ -313,11 +317,15 @@ bool HInliner::TryInline(HInvoke* invoke_instruction) {
                        << PrettyMethod(method_index, caller_dex_file)
                        << " is not hit and not inlined";
         return false;
-      } else if (ic.IsMonomorphic()) {
+      }
+      if (TryInlineSingleImplementation(invoke_instruction, resolved_method)) {
+        return true;
+      }
+      if (ic.IsMonomorphic()) {
         MaybeRecordStat(kMonomorphicCall);
-        if (outermost_graph_->IsCompilingOsr()) {
-          // If we are compiling OSR, we pretend this call is polymorphic, as we may come from the
-          // interpreter and it may have seen different receiver types.
+        if (!outermost_graph_->IsSpeculationAllowed()) {
+          // If we cannot deoptimize (OSR, or the method deoptimized too often), we pretend this
+          // call is polymorphic, as it may see different receiver types.
           return TryInlinePolymorphicCall(invoke_instruction, resolved_method, ic);
         } else {
           return TryInlineMonomorphicCall(invoke_instruction, resolved_method, ic);
@@ -327,12 +335,19 @@ bool HInliner::TryInline(HInvoke* invoke_instruction) {
         return TryInlinePolymorphicCall(invoke_instruction, resolved_method, ic);
       } else {
         DCHECK(ic.IsMegamorphic());
+        MaybeRecordStat(kMegamorphicCall);
+        // The receivers of a megamorphic call can still be dominated by a few types,
+        // which are then worth inlining behind type guards.
+        if (TryInlinePolymorphicCall(invoke_instruction, resolved_method, ic)) {
+          return true;
+        }
         VLOG(compiler) << "Interface or virtual call to "
                        << PrettyMethod(method_index, caller_dex_file)
                        << " is megamorphic and not inlined";
-        MaybeRecordStat(kMegamorphicCall);
         return false;
       }
+    } else if (TryInlineSingleImplementation(invoke_instruction, resolved_method)) {
+      return true;
     }
   }
 
@@ -466,7 +481,11 @@ bool HInliner::TryInlinePolymorphicCall(HInvoke* invoke_instruction,
   DCHECK(invoke_instruction->IsInvokeVirtual() || invoke_instruction->IsInvokeInterface())
       << invoke_instruction->DebugName();
 
-  if (TryInlinePolymorphicCallToSameTarget(invoke_instruction, resolved_method, ic)) {
+  // A megamorphic call may see receivers that resolve to other targets than
+  // the ones in the cache, so it cannot be replaced by a deoptimization guard.
+  const bool is_megamorphic = ic.IsMegamorphic();
+  if (!is_megamorphic &&
+      TryInlinePolymorphicCallToSameTarget(invoke_instruction, resolved_method, ic)) {
     return true;
   }
 
@@ -474,20 +493,48 @@ bool HInliner::TryInlinePolymorphicCall(HInvoke* invoke_instruction,
   size_t pointer_size = class_linker->GetImagePointerSize();
   const DexFile& caller_dex_file = *caller_compilation_unit_.GetDexFile();
 
+  // Take a snapshot of the inline cache, as it can be updated concurrently, and
+  // order the receiver types by decreasing number of calls so that the most
+  // frequent ones are checked first.
+  mirror::Class* types[InlineCache::kIndividualCacheSize];
+  uint32_t counts[InlineCache::kIndividualCacheSize];
+  size_t order[InlineCache::kIndividualCacheSize];
+  size_t number_of_types = 0;
+  uint64_t total_count = ic.GetMegamorphicCount();
+  for (size_t i = 0; i < InlineCache::kIndividualCacheSize; ++i) {
+    mirror::Class* type = ic.GetTypeAt(i);
+    if (type == nullptr) {
+      break;
+    }
+    types[number_of_types] = type;
+    counts[number_of_types] = ic.GetCountAt(i);
+    total_count += counts[number_of_types];
+    order[number_of_types] = number_of_types;
+    ++number_of_types;
+  }
+  std::stable_sort(order, order + number_of_types, [&counts](size_t lhs, size_t rhs) {
+    return counts[lhs] > counts[rhs];
+  });
+
   bool all_targets_inlined = true;
   bool one_target_inlined = false;
-  for (size_t i = 0; i < InlineCache::kIndividualCacheSize; ++i) {
-    if (ic.GetTypeAt(i) == nullptr) {
+  for (size_t j = 0; j < number_of_types; ++j) {
+    mirror::Class* type = types[order[j]];
+    uint64_t count = counts[order[j]];
+    if (count * 100 < total_count * kMinimumInlinedReceiverPercentage) {
+      // This and the remaining receiver types are too rare to be worth a type guard.
+      VLOG(compiler) << "Call to " << PrettyMethod(resolved_method)
+                     << " from inline cache is not inlined for " << PrettyClass(type)
+                     << " and less frequent receivers";
+      all_targets_inlined = false;
       break;
     }
     ArtMethod* method = nullptr;
     if (invoke_instruction->IsInvokeInterface()) {
-      method = ic.GetTypeAt(i)->FindVirtualMethodForInterface(
-          resolved_method, pointer_size);
+      method = type->FindVirtualMethodForInterface(resolved_method, pointer_size);
     } else {
       DCHECK(invoke_instruction->IsInvokeVirtual());
-      method = ic.GetTypeAt(i)->FindVirtualMethodForVirtual(
-          resolved_method, pointer_size);
+      method = type->FindVirtualMethodForVirtual(resolved_method, pointer_size);
     }
 
     HInstruction* receiver = invoke_instruction->InputAt(0);
@@ -495,23 +542,24 @@ bool HInliner::TryInlinePolymorphicCall(HInvoke* invoke_instruction,
     HBasicBlock* bb_cursor = invoke_instruction->GetBlock();
 
     uint32_t class_index = FindClassIndexIn(
-        ic.GetTypeAt(i), caller_dex_file, caller_compilation_unit_.GetDexCache());
+        type, caller_dex_file, caller_compilation_unit_.GetDexCache());
     HInstruction* return_replacement = nullptr;
     if (class_index == DexFile::kDexNoIndex ||
         !TryBuildAndInline(invoke_instruction, method, &return_replacement)) {
       all_targets_inlined = false;
     } else {
       one_target_inlined = true;
-      bool is_referrer = (ic.GetTypeAt(i) == outermost_graph_->GetArtMethod()->GetDeclaringClass());
+      bool is_referrer = (type == outermost_graph_->GetArtMethod()->GetDeclaringClass());
 
       // If we have inlined all targets before, and this receiver is the last seen,
       // we deoptimize instead of keeping the original invoke instruction.
       bool deoptimize = all_targets_inlined &&
-          (i != InlineCache::kIndividualCacheSize - 1) &&
-          (ic.GetTypeAt(i + 1) == nullptr);
+          !is_megamorphic &&
+          (j == number_of_types - 1);
 
-      if (outermost_graph_->IsCompilingOsr()) {
-        // We do not support HDeoptimize in OSR methods.
+      if (!outermost_graph_->IsSpeculationAllowed()) {
+        // We do not support HDeoptimize in OSR methods, nor use it in methods that
+        // deoptimized too often.
         deoptimize = false;
       }
       HInstruction* compare = AddTypeGuard(
@@ -521,9 +569,6 @@ bool HInliner::TryInlinePolymorphicCall(HInvoke* invoke_instruction,
           invoke_instruction->ReplaceWith(return_replacement);
         }
         invoke_instruction->GetBlock()->RemoveInstruction(invoke_instruction);
-        // Because the inline cache data can be populated concurrently, we force the end of the
-        // iteration. Otherhwise, we could see a new receiver type.
-        break;
       } else {
         CreateDiamondPatternForPolymorphicInline(compare, return_replacement, invoke_instruction);
       }
@@ -536,7 +581,7 @@ bool HInliner::TryInlinePolymorphicCall(HInvoke* invoke_instruction,
                    << " of its targets could be inlined";
     return false;
   }
-  MaybeRecordStat(kInlinedPolymorphicCall);
+  MaybeRecordStat(is_megamorphic ? kInlinedMegamorphicCall : kInlinedPolymorphicCall);
 
   // Run type propagation to get the guards typed.
   ReferenceTypePropagation rtp_fixup(graph_,
@@ -682,6 +727,27 @@ bool HInliner::TryInlinePolymorphicCallToSameTarget(HInvoke* invoke_instruction,
   }
 
   // We successfully inlined, now add a guard.
+  AddMethodTableGuard(invoke_instruction,
+                      receiver,
+                      cursor,
+                      bb_cursor,
+                      method_index,
+                      actual_method,
+                      return_replacement);
+
+  MaybeRecordStat(kInlinedPolymorphicCall);
+
+  return true;
+}
+
+void HInliner::AddMethodTableGuard(HInvoke* invoke_instruction,
+                                   HInstruction* receiver,
+                                   HInstruction* cursor,
+                                   HBasicBlock* bb_cursor,
+                                   size_t method_index,
+                                   ArtMethod* method,
+                                   HInstruction* return_replacement) {
+  ClassLinker* class_linker = caller_compilation_unit_.GetClassLinker();
   HInstanceFieldGet* receiver_class = BuildGetReceiverClass(
       class_linker, receiver, invoke_instruction->GetDexPc());
 
@@ -699,10 +765,10 @@ bool HInliner::TryInlinePolymorphicCallToSameTarget(HInvoke* invoke_instruction,
   HConstant* constant;
   if (type == Primitive::kPrimLong) {
     constant = graph_->GetLongConstant(
-        reinterpret_cast<intptr_t>(actual_method), invoke_instruction->GetDexPc());
+        reinterpret_cast<intptr_t>(method), invoke_instruction->GetDexPc());
   } else {
     constant = graph_->GetIntConstant(
-        reinterpret_cast<intptr_t>(actual_method), invoke_instruction->GetDexPc());
+        reinterpret_cast<intptr_t>(method), invoke_instruction->GetDexPc());
   }
 
   HNotEqual* compare = new (graph_->GetArena()) HNotEqual(class_table_get, constant);
@@ -714,7 +780,7 @@ bool HInliner::TryInlinePolymorphicCallToSameTarget(HInvoke* invoke_instruction,
   bb_cursor->InsertInstructionAfter(class_table_get, receiver_class);
   bb_cursor->InsertInstructionAfter(compare, class_table_get);
 
-  if (outermost_graph_->IsCompilingOsr()) {
+  if (!outermost_graph_->IsSpeculationAllowed()) {
     CreateDiamondPatternForPolymorphicInline(compare, return_replacement, invoke_instruction);
   } else {
     // TODO: Extend reference type propagation to understand the guard.
@@ -734,9 +800,62 @@ bool HInliner::TryInlinePolymorphicCallToSameTarget(HInvoke* invoke_instruction,
                                      handles_,
                                      /* is_first_run */ false);
   rtp_fixup.Run();
+}
 
-  MaybeRecordStat(kInlinedPolymorphicCall);
+bool HInliner::TryInlineSingleImplementation(HInvoke* invoke_instruction,
+                                             ArtMethod* resolved_method) {
+  // This optimization only works under JIT, which invalidates the code when a class
+  // overriding the method gets loaded.
+  DCHECK(Runtime::Current()->UseJitCompilation());
+  if (!invoke_instruction->IsInvokeVirtual()) {
+    // The class hierarchy analysis only tracks the overrides of class methods.
+    return false;
+  }
+  if (graph_->GetInstructionSet() == kMips64) {
+    // The guard needs HClassTableGet, which the mips64 code generator does not support.
+    return false;
+  }
+  ClassLinker* class_linker = caller_compilation_unit_.GetClassLinker();
+  size_t pointer_size = class_linker->GetImagePointerSize();
+
+  HInstruction* receiver = invoke_instruction->InputAt(0);
+  ReferenceTypeInfo info = (receiver->IsNullCheck() ? receiver->InputAt(0) : receiver)
+      ->GetReferenceTypeInfo();
+  ArtMethod* single_implementation = resolved_method;
+  if (info.IsValid() &&
+      !info.GetTypeHandle()->IsInterface() &&
+      !info.GetTypeHandle()->IsErroneous() &&
+      resolved_method->GetDeclaringClass()->IsAssignableFrom(info.GetTypeHandle().Get())) {
+    // The receiver type may inherit an implementation of a method declared higher up
+    // in the hierarchy.
+    single_implementation = info.GetTypeHandle()->FindVirtualMethodForVirtual(
+        resolved_method, pointer_size);
+  }
+  if (single_implementation == nullptr ||
+      !single_implementation->HasSingleImplementation() ||
+      !single_implementation->IsInvokable()) {
+    return false;
+  }
+
+  HInstruction* cursor = invoke_instruction->GetPrevious();
+  HBasicBlock* bb_cursor = invoke_instruction->GetBlock();
+  HInstruction* return_replacement = nullptr;
+  if (!TryBuildAndInline(invoke_instruction, single_implementation, &return_replacement)) {
+    return false;
+  }
 
+  // The guard only fails for receivers of a class overriding the method, which has to be
+  // loaded after this compilation. The code cache invalidates the code when that happens.
+  AddMethodTableGuard(invoke_instruction,
+                      receiver,
+                      cursor,
+                      bb_cursor,
+                      invoke_instruction->AsInvokeVirtual()->GetVTableIndex(),
+                      single_implementation,
+                      return_replacement);
+  outermost_graph_->AddChaSingleImplementationDependency(single_implementation);
+
+  MaybeRecordStat(kInlinedSingleImplementation);
   return true;
 }
 
@@ -1085,8 +1204,10 @@ bool HInliner::TryBuildAndInlineHelper(HInvoke* invoke_instruction,
       invoke_type,
       graph_->IsDebuggable(),
       /* osr */ false,
+      /* baseline */ false,
       caller_instruction_counter);
   callee_graph->SetArtMethod(resolved_method);
+  callee_graph->SetSpeculationAllowed(graph_->IsSpeculationAllowed());
 
   // When they are needed, allocate `inline_stats` on the heap instead
   // of on the stack, as Clang might produce a stack frame too large
@@ -107,7 +107,9 @@ class HInliner : public HOptimization {
                                 const InlineCache& ic)
     SHARED_REQUIRES(Locks::mutator_lock_);
 
-  // Try to inline targets of a polymorphic call.
+  // Try to inline targets of a polymorphic or megamorphic call. The receiver
+  // types are checked in decreasing order of frequency, and the ones that are
+  // rare enough are left to the original invoke.
   bool TryInlinePolymorphicCall(HInvoke* invoke_instruction,
                                 ArtMethod* resolved_method,
                                 const InlineCache& ic)
@@ -118,6 +120,23 @@ class HInliner : public HOptimization {
                                             const InlineCache& ic)
     SHARED_REQUIRES(Locks::mutator_lock_);
 
+  // Try to inline the target of a virtual call which no loaded class overrides, as
+  // found by the class hierarchy analysis. The code gets a guard on the receiver's vtable
+  // entry, and the JIT code cache invalidates it when an overriding class gets loaded.
+  bool TryInlineSingleImplementation(HInvoke* invoke_instruction, ArtMethod* resolved_method)
+    SHARED_REQUIRES(Locks::mutator_lock_);
+
+  // Add a guard that the vtable or IMT entry `method_index` of the class of `receiver` is
+  // `method`, for an invoke already inlined after `cursor`. Deoptimizes if the guard fails,
+  // or calls the original invoke when speculation is not allowed.
+  void AddMethodTableGuard(HInvoke* invoke_instruction,
+                           HInstruction* receiver,
+                           HInstruction* cursor,
+                           HBasicBlock* bb_cursor,
+                           size_t method_index,
+                           ArtMethod* method,
+                           HInstruction* return_replacement)
+    SHARED_REQUIRES(Locks::mutator_lock_);
 
   HInstanceFieldGet* BuildGetReceiverClass(ClassLinker* class_linker,
                                            HInstruction* receiver,
@@ -19,10 +19,17 @@
 #include "bytecode_utils.h"
 #include "class_linker.h"
 #include "driver/compiler_options.h"
+#include "jit/jit.h"
+#include "jit/jit_code_cache.h"
+#include "jit/profiling_info.h"
 #include "scoped_thread_state_change.h"
 
 namespace art {
 
+// Number of times an IF instruction must have been executed, always going the
+// same way, before the compiler speculates it keeps doing so.
+static constexpr uint32_t kMinimumBranchSamplesForSpeculation = 128;
+
 void HInstructionBuilder::MaybeRecordStat(MethodCompilationStat compilation_stat) {
   if (compilation_stats_ != nullptr) {
     compilation_stats_->RecordStat(compilation_stat);
@@ -258,6 +265,8 @@ static bool IsBlockPopulated(HBasicBlock* block) {
 }
 
 bool HInstructionBuilder::Build() {
+  FindColdBranches();
+
   locals_for_.resize(graph_->GetBlocks().size(),
                      ArenaVector<HInstruction*>(arena_->Adapter(kArenaAllocGraphBuilder)));
 
@@ -281,6 +290,10 @@ bool HInstructionBuilder::Build() {
 
     if (current_block_->IsEntryBlock()) {
       InitializeParameters();
+      if (graph_->IsCompilingBaseline()) {
+        AppendInstruction(new (arena_) HUpdateHotness(
+            graph_->GetCurrentMethod(), /* is_back_edge */ false, 0u));
+      }
       AppendInstruction(new (arena_) HSuspendCheck(0u));
       AppendInstruction(new (arena_) HGoto(0u));
       continue;
@@ -339,9 +352,34 @@ bool HInstructionBuilder::Build() {
 
   SetLoopHeaderPhiInputs();
 
+  if (graph_->IsCompilingBaseline()) {
+    InsertLoopHotnessUpdates();
+  }
+
   return true;
 }
 
+void HInstructionBuilder::InsertLoopHotnessUpdates() {
+  // Done once the blocks are populated, as the suspend check is expected to be
+  // the only instruction of a loop header until then.
+  for (HBasicBlock* block : loop_headers_) {
+    HSuspendCheck* suspend_check = block->GetLoopInformation()->GetSuspendCheck();
+    HUpdateHotness* update = new (arena_) HUpdateHotness(graph_->GetCurrentMethod(),
+                                                         /* is_back_edge */ true,
+                                                         suspend_check->GetDexPc());
+    block->InsertInstructionAfter(update, suspend_check);
+    if (block->IsTryBlock()) {
+      // Catch phis do not know about the deoptimization, keep running the baseline code.
+      continue;
+    }
+    // Once OSR code is ready for the loop, leave the baseline code for the interpreter,
+    // which enters the OSR code at the next back edge.
+    HDeoptimize* deoptimize = new (arena_) HDeoptimize(update, suspend_check->GetDexPc());
+    deoptimize->CopyEnvironmentFrom(suspend_check->GetEnvironment());
+    block->InsertInstructionAfter(deoptimize, update);
+  }
+}
+
 void HInstructionBuilder::FindNativeDebugInfoLocations(ArenaBitVector* locations) {
   // The callback gets called when the line number changes.
   // In other words, it marks the start of new java statement.
@@ -473,21 +511,67 @@ template<typename T>
 void HInstructionBuilder::If_22t(const Instruction& instruction, uint32_t dex_pc) {
   HInstruction* first = LoadLocal(instruction.VRegA(), Primitive::kPrimInt);
   HInstruction* second = LoadLocal(instruction.VRegB(), Primitive::kPrimInt);
-  T* comparison = new (arena_) T(first, second, dex_pc);
-  AppendInstruction(comparison);
-  AppendInstruction(new (arena_) HIf(comparison, dex_pc));
-  current_block_ = nullptr;
+  BuildIf(new (arena_) T(first, second, dex_pc), dex_pc);
 }
 
 template<typename T>
 void HInstructionBuilder::If_21t(const Instruction& instruction, uint32_t dex_pc) {
   HInstruction* value = LoadLocal(instruction.VRegA(), Primitive::kPrimInt);
-  T* comparison = new (arena_) T(value, graph_->GetIntConstant(0, dex_pc), dex_pc);
+  BuildIf(new (arena_) T(value, graph_->GetIntConstant(0, dex_pc), dex_pc), dex_pc);
+}
+
+void HInstructionBuilder::BuildIf(HCondition* comparison, uint32_t dex_pc) {
   AppendInstruction(comparison);
-  AppendInstruction(new (arena_) HIf(comparison, dex_pc));
+  HInstruction* if_input = comparison;
+  if (graph_->IsCompilingBaseline()) {
+    // Record the direction taken for the optimizing tier to speculate on.
+    AppendInstruction(new (arena_) HUpdateBranchProfile(
+        graph_->GetCurrentMethod(), comparison, dex_pc));
+  } else if (!current_block_->IsTryBlock()) {
+    auto it = cold_branches_.find(dex_pc);
+    if (it != cold_branches_.end()) {
+      // Deoptimize if the branch goes the way it never went, and make the other
+      // successor dead for dead code elimination to remove.
+      HInstruction* deoptimize_condition = comparison;
+      if (it->second) {
+        deoptimize_condition = new (arena_) HBooleanNot(comparison, dex_pc);
+        AppendInstruction(deoptimize_condition);
+      }
+      AppendInstruction(new (arena_) HDeoptimize(deoptimize_condition, dex_pc));
+      if_input = graph_->GetIntConstant(it->second ? 1 : 0, dex_pc);
+      MaybeRecordStat(MethodCompilationStat::kSpeculatedBranch);
+    }
+  }
+  AppendInstruction(new (arena_) HIf(if_input, dex_pc));
   current_block_ = nullptr;
 }
 
+void HInstructionBuilder::FindColdBranches() {
+  if (!graph_->IsSpeculationAllowed() ||
+      graph_->IsCompilingBaseline() ||
+      graph_->GetArtMethod() == nullptr ||
+      !Runtime::Current()->UseJitCompilation()) {
+    return;
+  }
+  ScopedObjectAccess soa(Thread::Current());
+  ArtMethod* method = graph_->GetArtMethod();
+  jit::JitCodeCache* code_cache = Runtime::Current()->GetJit()->GetCodeCache();
+  ProfilingInfo* info = code_cache->NotifyCompilerUse(method, soa.Self());
+  if (info == nullptr) {
+    return;
+  }
+  for (size_t i = 0, e = info->GetNumberOfBranchCaches(); i < e; ++i) {
+    const BranchCache& cache = info->GetBranchCacheAt(i);
+    uint32_t taken = cache.GetTakenCount();
+    uint32_t not_taken = cache.GetNotTakenCount();
+    if (taken + not_taken >= kMinimumBranchSamplesForSpeculation &&
+        (taken == 0 || not_taken == 0)) {
+      cold_branches_.Put(cache.GetDexPc(), taken != 0);
+    }
+  }
+  code_cache->DoneCompilerUse(method, soa.Self());
+}
+
 template<typename T>
 void HInstructionBuilder::Unop_12x(const Instruction& instruction,
                                    Primitive::Type type,
@@ -1123,6 +1207,12 @@ bool HInstructionBuilder::HandleInvoke(HInvoke* invoke,
     argument_index++;
   }
 
+  if (graph_->IsCompilingBaseline() && (invoke->IsInvokeVirtual() || invoke->IsInvokeInterface())) {
+    // Record the receiver class like the interpreter does, for the optimizing tier to inline.
+    AppendInstruction(new (arena_) HUpdateInlineCache(
+        graph_->GetCurrentMethod(), invoke->InputAt(0), invoke->GetDexPc()));
+  }
+
   AppendInstruction(invoke);
   latest_result_ = invoke;
 
@@ -63,7 +63,8 @@ class HInstructionBuilder : public ValueObject {
                                       arena_->Adapter(kArenaAllocGraphBuilder)),
         compilation_stats_(compiler_stats),
         dex_cache_(dex_cache),
-        loop_headers_(graph->GetArena()->Adapter(kArenaAllocGraphBuilder)) {
+        loop_headers_(graph->GetArena()->Adapter(kArenaAllocGraphBuilder)),
+        cold_branches_(std::less<uint32_t>(), arena_->Adapter(kArenaAllocGraphBuilder)) {
     loop_headers_.reserve(kDefaultNumberOfLoops);
   }
 
@@ -75,6 +76,8 @@ class HInstructionBuilder : public ValueObject {
   void InitializeBlockLocals();
   void PropagateLocalsToCatchBlocks();
   void SetLoopHeaderPhiInputs();
+  // Adds the back edge hotness updates of baseline compiled code to the loop headers.
+  void InsertLoopHotnessUpdates();
 
   bool ProcessDexInstruction(const Instruction& instruction, uint32_t dex_pc);
   void FindNativeDebugInfoLocations(ArenaBitVector* locations);
@@ -133,6 +136,14 @@ class HInstructionBuilder : public ValueObject {
   template<typename T> void If_21t(const Instruction& instruction, uint32_t dex_pc);
   template<typename T> void If_22t(const Instruction& instruction, uint32_t dex_pc);
 
+  // Appends `comparison` and the HIf on it. If the profile shows the branch always
+  // went the same way, the HIf is replaced by a deoptimization guard and a jump.
+  void BuildIf(HCondition* comparison, uint32_t dex_pc);
+
+  // Records the IF instructions of the method that the profile shows always went
+  // the same way, in `cold_branches_`.
+  void FindColdBranches();
+
   void Conversion_12x(const Instruction& instruction,
                       Primitive::Type input_type,
                       Primitive::Type result_type,
@@ -308,6 +319,10 @@ class HInstructionBuilder : public ValueObject {
 
   ArenaVector<HBasicBlock*> loop_headers_;
 
+  // Dex pcs of the IF instructions to speculate on, mapped to the direction they
+  // always went: true if they always jumped to their target.
+  ArenaSafeMap<uint32_t, bool> cold_branches_;
+
   static constexpr int kDefaultNumberOfLoops = 2;
 
   DISALLOW_COPY_AND_ASSIGN(HInstructionBuilder);
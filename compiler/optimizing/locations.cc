@@ -88,7 +88,9 @@ std::ostream& operator<<(std::ostream& os, const Location& location) {
     os << location.reg();
   } else if (location.IsPair()) {
     os << location.low() << ":" << location.high();
-  } else if (location.IsStackSlot() || location.IsDoubleStackSlot()) {
+  } else if (location.IsStackSlot() ||
+             location.IsDoubleStackSlot() ||
+             location.IsSIMDStackSlot()) {
     os << location.GetStackIndex();
   }
   return os;
@@ -67,6 +67,8 @@ class Location : public ValueObject {
     // a policy that specifies what kind of location is suitable. Payload
     // contains register allocation policy.
     kUnallocated = 10,
+
+    kSIMDStackSlot = 11,  // 128bit stack slot, holding a vector value.
   };
 
   Location() : ValueObject(), value_(kInvalid) {
@@ -75,6 +77,7 @@ class Location : public ValueObject {
     static_assert((kUnallocated & kLocationConstantMask) != kConstant, "TagError");
     static_assert((kStackSlot & kLocationConstantMask) != kConstant, "TagError");
     static_assert((kDoubleStackSlot & kLocationConstantMask) != kConstant, "TagError");
+    static_assert((kSIMDStackSlot & kLocationConstantMask) != kConstant, "TagError");
     static_assert((kRegister & kLocationConstantMask) != kConstant, "TagError");
     static_assert((kFpuRegister & kLocationConstantMask) != kConstant, "TagError");
     static_assert((kRegisterPair & kLocationConstantMask) != kConstant, "TagError");
@@ -262,8 +265,20 @@ class Location : public ValueObject {
     return GetKind() == kDoubleStackSlot;
   }
 
+  static Location SIMDStackSlot(intptr_t stack_index) {
+    uintptr_t payload = EncodeStackIndex(stack_index);
+    Location loc(kSIMDStackSlot, payload);
+    // Ensure that sign is preserved.
+    DCHECK_EQ(loc.GetStackIndex(), stack_index);
+    return loc;
+  }
+
+  bool IsSIMDStackSlot() const {
+    return GetKind() == kSIMDStackSlot;
+  }
+
   intptr_t GetStackIndex() const {
-    DCHECK(IsStackSlot() || IsDoubleStackSlot());
+    DCHECK(IsStackSlot() || IsDoubleStackSlot() || IsSIMDStackSlot());
     // Decode stack index manually to preserve sign.
     return GetPayload() - kStackIndexBias;
   }
@@ -311,6 +326,7 @@ class Location : public ValueObject {
       case kRegister: return "R";
       case kStackSlot: return "S";
       case kDoubleStackSlot: return "DS";
+      case kSIMDStackSlot: return "SIMD";
       case kUnallocated: return "U";
       case kConstant: return "C";
       case kFpuRegister: return "F";
@@ -505,7 +521,10 @@ class LocationSummary : public ArenaObject<kArenaAllocLocationSummary> {
     // 1) Parameters, where we only know the exact stack slot after
     //    doing full register allocation.
     // 2) Unallocated location.
-    DCHECK(output_.IsStackSlot() || output_.IsDoubleStackSlot() || output_.IsUnallocated());
+    DCHECK(output_.IsStackSlot() ||
+           output_.IsDoubleStackSlot() ||
+           output_.IsSIMDStackSlot() ||
+           output_.IsUnallocated());
     output_ = location;
   }
 
@@ -583,7 +602,8 @@ class LocationSummary : public ArenaObject<kArenaAllocLocationSummary> {
         || input.IsFpuRegister()
         || input.IsPair()
         || input.IsStackSlot()
-        || input.IsDoubleStackSlot();
+        || input.IsDoubleStackSlot()
+        || input.IsSIMDStackSlot();
   }
 
   bool OutputCanOverlapWithInputs() const {
@@ -0,0 +1,1233 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "loop_optimization.h"
+
+#include "arch/instruction_set.h"
+#include "arch/x86_64/instruction_set_features_x86_64.h"
+#include "driver/compiler_driver.h"
+#include "driver/compiler_options.h"
+
+namespace art {
+
+// Maximum number of instructions in the copies of the body of a loop fully unrolled.
+static constexpr size_t kFullUnrollingMaxInstructions = 32;
+
+// Maximum number of instructions in the body of a loop peeled.
+static constexpr size_t kPeelingMaxInstructions = 32;
+
+// Maximum number of instructions in the copies of the body of a loop partially unrolled,
+// and maximum number of copies, for the loops the JIT profile found hot and for the
+// loops of unknown hotness.
+static constexpr size_t kHotUnrollingMaxInstructions = 64;
+static constexpr size_t kHotUnrollingMaxFactor = 4;
+static constexpr size_t kUnrollingMaxInstructions = 16;
+static constexpr size_t kUnrollingMaxFactor = 2;
+
+// Maximum number of instructions unrolling and peeling add to a method.
+static constexpr size_t kCodeGrowthBudget = 256;
+
+// Returns whether values of types `type1` and `type2` are packed the same way in vectors.
+static bool IsSamePackedKind(Primitive::Type type1, Primitive::Type type2) {
+  return Primitive::ComponentSize(type1) == Primitive::ComponentSize(type2) &&
+      Primitive::IsFloatingPointType(type1) == Primitive::IsFloatingPointType(type2);
+}
+
+// Returns whether a scalar value of type `type` fits in the lanes of a vector of
+// `packed_type`. A narrow integral lane holds the lower bits of an int value.
+static bool IsPackableScalarType(Primitive::Type type, Primitive::Type packed_type) {
+  switch (packed_type) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+      return Primitive::IsIntegralType(type) && type != Primitive::kPrimLong;
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      return type == packed_type;
+    default:
+      return false;
+  }
+}
+
+// Returns whether an arithmetic operation of type `type` can be done on vectors of
+// `packed_type`. Integral operations on narrow lanes compute the lower bits of the int
+// results, which is only correct for operations whose lower result bits only depend on
+// the lower bits of their inputs.
+static bool IsPackableOperationType(Primitive::Type type, Primitive::Type packed_type) {
+  switch (packed_type) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+      return type == Primitive::kPrimInt || type == Primitive::kPrimBoolean;
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      return type == packed_type;
+    default:
+      return false;
+  }
+}
+
+// Returns whether HLoopOptimization::Clone() can copy `instruction`.
+static bool IsCloneable(HInstruction* instruction) {
+  switch (instruction->GetKind()) {
+    case HInstruction::kAdd:
+    case HInstruction::kSub:
+    case HInstruction::kMul:
+    case HInstruction::kDiv:
+    case HInstruction::kRem:
+    case HInstruction::kAnd:
+    case HInstruction::kOr:
+    case HInstruction::kXor:
+    case HInstruction::kShl:
+    case HInstruction::kShr:
+    case HInstruction::kUShr:
+    case HInstruction::kRor:
+    case HInstruction::kNeg:
+    case HInstruction::kNot:
+    case HInstruction::kTypeConversion:
+    case HInstruction::kEqual:
+    case HInstruction::kNotEqual:
+    case HInstruction::kLessThan:
+    case HInstruction::kLessThanOrEqual:
+    case HInstruction::kGreaterThan:
+    case HInstruction::kGreaterThanOrEqual:
+    case HInstruction::kBelow:
+    case HInstruction::kBelowOrEqual:
+    case HInstruction::kAbove:
+    case HInstruction::kAboveOrEqual:
+    case HInstruction::kArrayLength:
+    case HInstruction::kArrayGet:
+    case HInstruction::kNullCheck:
+    case HInstruction::kBoundsCheck:
+    case HInstruction::kDivZeroCheck:
+    case HInstruction::kClinitCheck:
+    case HInstruction::kInstanceFieldGet:
+    case HInstruction::kInstanceFieldSet:
+    case HInstruction::kStaticFieldGet:
+    case HInstruction::kStaticFieldSet:
+      return true;
+    case HInstruction::kArraySet:
+      // Stores of references have flags for the type check and the write barrier.
+      return instruction->AsArraySet()->GetComponentType() != Primitive::kPrimNot;
+    default:
+      return false;
+  }
+}
+
+// Returns the constant `instruction` evaluates to, or null. Divisions are left to the
+// constant folding, which knows about their division by zero checks.
+static HConstant* TryStaticEvaluation(HInstruction* instruction) {
+  if (instruction->IsDiv() || instruction->IsRem()) {
+    return nullptr;
+  } else if (instruction->IsBinaryOperation()) {
+    return instruction->AsBinaryOperation()->TryStaticEvaluation();
+  } else if (instruction->IsUnaryOperation()) {
+    return instruction->AsUnaryOperation()->TryStaticEvaluation();
+  } else if (instruction->IsTypeConversion()) {
+    return instruction->AsTypeConversion()->TryStaticEvaluation();
+  }
+  return nullptr;
+}
+
+// Recomputes the dominance and loop information after a loop transformation.
+static void RecomputeLoopInformation(HGraph* graph) {
+  graph->ClearLoopInformation();
+  graph->ClearDominanceInformation();
+  graph->BuildDominatorTree();
+}
+
+HLoopOptimization::HLoopOptimization(HGraph* graph,
+                                     CompilerDriver* compiler_driver,
+                                     HInductionVarAnalysis* induction_analysis,
+                                     OptimizingCompilerStats* stats)
+    : HOptimization(graph, kLoopOptimizationPassName, stats),
+      compiler_driver_(compiler_driver),
+      induction_range_(induction_analysis),
+      trip_counts_(std::less<HBasicBlock*>(),
+                   graph->GetArena()->Adapter(kArenaAllocLoopOptimization)),
+      code_growth_budget_(kCodeGrowthBudget),
+      loop_info_(nullptr),
+      body_(nullptr),
+      exit_(nullptr),
+      induction_(nullptr),
+      increment_(nullptr),
+      upper_bound_(nullptr),
+      vector_length_(0),
+      vector_candidates_(std::less<HInstruction*>(),
+                         graph->GetArena()->Adapter(kArenaAllocLoopOptimization)),
+      reductions_(graph->GetArena()->Adapter(kArenaAllocLoopOptimization)),
+      vector_map_(std::less<HInstruction*>(),
+                  graph->GetArena()->Adapter(kArenaAllocLoopOptimization)),
+      vector_preheader_(nullptr),
+      vector_header_(nullptr),
+      vector_body_(nullptr),
+      vector_index_(nullptr),
+      iteration_map_(std::less<HInstruction*>(),
+                     graph->GetArena()->Adapter(kArenaAllocLoopOptimization)) {}
+
+void HLoopOptimization::Run() {
+  // Vector values are not described in stack maps, and copies of the loop body share
+  // their dex pcs, so the loops of debuggable code and of code entered through OSR are
+  // left alone. Exception edges and irreducible loops are not worth the complexity.
+  if (graph_->IsDebuggable() ||
+      graph_->IsCompilingOsr() ||
+      graph_->HasTryCatch() ||
+      graph_->HasIrreducibleLoops()) {
+    return;
+  }
+
+  // Collect the loop headers first: transforming a loop recomputes the loop information.
+  ArenaVector<HBasicBlock*> headers(graph_->GetArena()->Adapter(kArenaAllocLoopOptimization));
+  for (HPostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    if (block->IsLoopHeader()) {
+      headers.push_back(block);
+      int64_t trip_count = 0;
+      if (induction_range_.IsConstantTripCount(block->GetLoopInformation(), &trip_count)) {
+        trip_counts_.Put(block, trip_count);
+      }
+    }
+  }
+
+  for (HBasicBlock* header : headers) {
+    OptimizeLoop(header);
+  }
+}
+
+void HLoopOptimization::OptimizeLoop(HBasicBlock* header) {
+  if (!header->IsLoopHeader() || !IsSimpleLoop(header)) {
+    return;
+  }
+
+  auto trip_count = trip_counts_.find(header);
+  if (trip_count != trip_counts_.end() && CanFullyUnroll(trip_count->second)) {
+    FullyUnroll(trip_count->second);
+    MaybeRecordStat(MethodCompilationStat::kFullyUnrolledLoop);
+    return;
+  }
+
+  if (IsVectorizationSupported() && CanVectorize()) {
+    Vectorize();
+    MaybeRecordStat(MethodCompilationStat::kVectorizedLoop);
+    return;
+  }
+
+  if (CanPeel()) {
+    Peel();
+    MaybeRecordStat(MethodCompilationStat::kPeeledLoop);
+    if (!IsSimpleLoop(header)) {
+      return;
+    }
+  }
+
+  size_t factor = GetUnrollingFactor();
+  if (factor > 1) {
+    PartiallyUnroll(factor);
+    MaybeRecordStat(MethodCompilationStat::kPartiallyUnrolledLoop);
+  }
+}
+
+bool HLoopOptimization::IsSimpleLoop(HBasicBlock* header) {
+  loop_info_ = header->GetLoopInformation();
+  body_ = nullptr;
+  exit_ = nullptr;
+
+  // Only consider innermost loops made of the header, evaluating the loop condition,
+  // and of a single body block.
+  if (loop_info_->IsIrreducible() ||
+      loop_info_->NumberOfBackEdges() != 1 ||
+      loop_info_->GetBlocks().NumSetBits() != 2 ||
+      !loop_info_->HasSuspendCheck() ||
+      !loop_info_->GetPreHeader()->GetLastInstruction()->IsGoto()) {
+    return false;
+  }
+  HBasicBlock* body = loop_info_->GetBackEdges()[0];
+  if (body == header ||
+      body->GetPredecessors().size() != 1 ||
+      body->GetSinglePredecessor() != header ||
+      body->GetSuccessors().size() != 1) {
+    return false;
+  }
+
+  // The header must only evaluate the loop condition.
+  HInstruction* suspend_check = header->GetFirstInstruction();
+  HInstruction* last = header->GetLastInstruction();
+  if (suspend_check != loop_info_->GetSuspendCheck() || !last->IsIf()) {
+    return false;
+  }
+  HInstruction* condition = suspend_check->GetNext();
+  if (condition->GetNext() != last ||
+      last->InputAt(0) != condition ||
+      !condition->IsCondition() ||
+      !condition->HasOnlyOneNonEnvironmentUse()) {
+    return false;
+  }
+  HIf* if_instruction = last->AsIf();
+  HBasicBlock* exit = (if_instruction->IfTrueSuccessor() == body)
+      ? if_instruction->IfFalseSuccessor()
+      : if_instruction->IfTrueSuccessor();
+  if (loop_info_->Contains(*exit)) {
+    return false;
+  }
+  body_ = body;
+  exit_ = exit;
+  return true;
+}
+
+bool HLoopOptimization::FindInductionAndCondition() {
+  induction_ = nullptr;
+  increment_ = nullptr;
+  upper_bound_ = nullptr;
+
+  // The loop must run while `i < n`, for the induction `i` and an invariant `n`.
+  HBasicBlock* header = loop_info_->GetHeader();
+  HIf* if_instruction = header->GetLastInstruction()->AsIf();
+  HInstruction* condition = if_instruction->InputAt(0);
+  bool body_on_true = (if_instruction->IfTrueSuccessor() == body_);
+  HInstruction* left = condition->InputAt(0);
+  HInstruction* right = condition->InputAt(1);
+  HInstruction* induction;
+  HInstruction* upper_bound;
+  if ((body_on_true && condition->IsLessThan()) ||
+      (!body_on_true && condition->IsGreaterThanOrEqual())) {
+    induction = left;
+    upper_bound = right;
+  } else if ((body_on_true && condition->IsGreaterThan()) ||
+             (!body_on_true && condition->IsLessThanOrEqual())) {
+    induction = right;
+    upper_bound = left;
+  } else {
+    return false;
+  }
+  if (!induction->IsPhi() ||
+      induction->GetBlock() != header ||
+      induction->GetType() != Primitive::kPrimInt ||
+      upper_bound->GetType() != Primitive::kPrimInt ||
+      !IsInvariant(upper_bound)) {
+    return false;
+  }
+
+  // The induction must go up by 1.
+  DCHECK_EQ(induction->InputCount(), 2u);
+  HInstruction* increment = induction->InputAt(1);
+  if (!increment->IsAdd() ||
+      increment->GetBlock() != body_ ||
+      increment->InputAt(0) != induction ||
+      !increment->InputAt(1)->IsIntConstant() ||
+      increment->InputAt(1)->AsIntConstant()->GetValue() != 1) {
+    return false;
+  }
+  induction_ = induction->AsPhi();
+  increment_ = increment;
+  upper_bound_ = upper_bound;
+  return true;
+}
+
+bool HLoopOptimization::IsInvariant(HInstruction* instruction) const {
+  return !loop_info_->Contains(*instruction->GetBlock());
+}
+
+bool HLoopOptimization::IsCompilingForSize() const {
+  return compiler_driver_->GetCompilerOptions().GetCompilerFilter() == CompilerFilter::kSpace;
+}
+
+bool HLoopOptimization::IsVectorizationSupported() const {
+  InstructionSet instruction_set = compiler_driver_->GetInstructionSet();
+  return instruction_set == kArm64 || instruction_set == kX86_64;
+}
+
+bool HLoopOptimization::IsSupportedOperation(HInstruction* instruction,
+                                             Primitive::Type packed_type) const {
+  if (instruction->IsMul()) {
+    switch (packed_type) {
+      case Primitive::kPrimBoolean:
+      case Primitive::kPrimByte:
+      case Primitive::kPrimLong:
+        // Neither SSE nor NEON multiplies bytes or longs lane-wise.
+        return false;
+      case Primitive::kPrimInt:
+        // Only SSE4.1 multiplies ints lane-wise.
+        return compiler_driver_->GetInstructionSet() != kX86_64 ||
+            compiler_driver_->GetInstructionSetFeatures()->
+                AsX86_64InstructionSetFeatures()->HasSSE4_1();
+      default:
+        return true;
+    }
+  } else if (instruction->IsAnd() || instruction->IsOr() || instruction->IsXor()) {
+    return !Primitive::IsFloatingPointType(packed_type);
+  }
+  DCHECK(instruction->IsAdd() || instruction->IsSub());
+  return true;
+}
+
+bool HLoopOptimization::CanVectorize() {
+  vector_length_ = 0;
+  vector_candidates_.clear();
+  reductions_.clear();
+
+  // The induction must start at 0, so that the vector loop stops at the largest
+  // multiple of the vector length below `n`, and only be used by the vector loop.
+  if (!FindInductionAndCondition()) {
+    return false;
+  }
+  HInstruction* start = induction_->InputAt(0);
+  return start->IsIntConstant() &&
+      start->AsIntConstant()->GetValue() == 0 &&
+      increment_->HasOnlyOneNonEnvironmentUse() &&
+      FindRoots();
+}
+
+bool HLoopOptimization::FindRoots() {
+  HBasicBlock* header = loop_info_->GetHeader();
+  HInstruction* condition = header->GetLastInstruction()->InputAt(0);
+
+  // The header phis other than the induction must be sums: `s = phi(s0, s + x)`.
+  for (HInstructionIterator it(header->GetPhis()); !it.Done(); it.Advance()) {
+    HPhi* phi = it.Current()->AsPhi();
+    if (phi == induction_) {
+      continue;
+    }
+    Primitive::Type type = phi->GetType();
+    HInstruction* add = phi->InputAt(1);
+    if ((type != Primitive::kPrimInt && type != Primitive::kPrimLong) ||
+        !add->IsAdd() ||
+        add->GetType() != type ||
+        add->GetBlock() != body_ ||
+        !add->HasOnlyOneNonEnvironmentUse()) {
+      return false;
+    }
+    HInstruction* value;
+    if (add->InputAt(0) == phi) {
+      value = add->InputAt(1);
+    } else if (add->InputAt(1) == phi) {
+      value = add->InputAt(0);
+    } else {
+      return false;
+    }
+    if (vector_length_ == 0) {
+      vector_length_ = HVecOperation::kSIMDNumberOfBytes / Primitive::ComponentSize(type);
+    }
+    if (!DemandVector(value, type)) {
+      return false;
+    }
+    vector_candidates_.Put(add, type);
+    reductions_.push_back(phi);
+  }
+
+  // The stores into invariant arrays at the induction.
+  for (HInstructionIterator it(body_->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* instruction = it.Current();
+    if (!instruction->IsArraySet()) {
+      continue;
+    }
+    HArraySet* array_set = instruction->AsArraySet();
+    Primitive::Type packed_type = array_set->GetComponentType();
+    if (packed_type == Primitive::kPrimNot ||
+        array_set->GetIndex() != induction_ ||
+        !IsInvariant(array_set->GetArray())) {
+      return false;
+    }
+    if (vector_length_ == 0) {
+      vector_length_ = HVecOperation::kSIMDNumberOfBytes / Primitive::ComponentSize(packed_type);
+    }
+    if (!DemandVector(array_set->GetValue(), packed_type)) {
+      return false;
+    }
+    vector_candidates_.Put(array_set, packed_type);
+  }
+  if (vector_candidates_.empty()) {
+    return false;
+  }
+
+  // Everything the body computes must be vectorized, and only be used by vectors.
+  for (HInstructionIterator it(body_->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* instruction = it.Current();
+    if (instruction == increment_ || instruction->IsGoto()) {
+      continue;
+    }
+    auto candidate = vector_candidates_.find(instruction);
+    if (candidate == vector_candidates_.end() ||
+        Primitive::ComponentSize(candidate->second) * vector_length_ !=
+            HVecOperation::kSIMDNumberOfBytes ||
+        instruction->HasEnvironmentUses()) {
+      return false;
+    }
+    for (const HUseListNode<HInstruction*>& use : instruction->GetUses()) {
+      HInstruction* user = use.GetUser();
+      if (user->GetBlock() != header &&
+          vector_candidates_.find(user) == vector_candidates_.end()) {
+        return false;
+      }
+    }
+  }
+
+  // The scalar values of the loop phis are only used by the loop condition and by
+  // the vectorized instructions in the loop. The environment of the suspend check
+  // gets fixed up when duplicated in the vector loop.
+  for (HInstructionIterator it(header->GetPhis()); !it.Done(); it.Advance()) {
+    HInstruction* phi = it.Current();
+    for (const HUseListNode<HInstruction*>& use : phi->GetUses()) {
+      HInstruction* user = use.GetUser();
+      if (loop_info_->Contains(*user->GetBlock()) &&
+          user != condition &&
+          user != increment_ &&
+          vector_candidates_.find(user) == vector_candidates_.end()) {
+        return false;
+      }
+    }
+    for (const HUseListNode<HEnvironment*>& use : phi->GetEnvUses()) {
+      HInstruction* holder = use.GetUser()->GetHolder();
+      if (loop_info_->Contains(*holder->GetBlock()) && holder != loop_info_->GetSuspendCheck()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool HLoopOptimization::DemandVector(HInstruction* instruction, Primitive::Type packed_type) {
+  // All the vectors of the loop have the same length.
+  if (Primitive::ComponentSize(packed_type) * vector_length_ != HVecOperation::kSIMDNumberOfBytes) {
+    return false;
+  }
+  auto candidate = vector_candidates_.find(instruction);
+  if (candidate != vector_candidates_.end()) {
+    return IsSamePackedKind(candidate->second, packed_type);
+  }
+  if (IsInvariant(instruction)) {
+    // Replicated into all the lanes before the loop.
+    return IsPackableScalarType(instruction->GetType(), packed_type);
+  }
+  if (instruction->GetBlock() != body_) {
+    return false;
+  }
+
+  if (instruction->IsArrayGet()) {
+    if (instruction->InputAt(1) != induction_ ||
+        !IsInvariant(instruction->InputAt(0)) ||
+        !IsSamePackedKind(instruction->GetType(), packed_type)) {
+      return false;
+    }
+  } else if (instruction->IsTypeConversion()) {
+    // A conversion to a narrow type does not change the lower bits held by the
+    // narrow lanes, and is dropped.
+    Primitive::Type input_type = instruction->InputAt(0)->GetType();
+    if (Primitive::IsFloatingPointType(packed_type) ||
+        Primitive::ComponentSize(packed_type) >= Primitive::ComponentSize(Primitive::kPrimInt) ||
+        !IsSamePackedKind(instruction->GetType(), packed_type) ||
+        !IsPackableScalarType(input_type, packed_type) ||
+        !DemandVector(instruction->InputAt(0), packed_type)) {
+      return false;
+    }
+  } else if (instruction->IsAdd() ||
+             instruction->IsSub() ||
+             instruction->IsMul() ||
+             instruction->IsAnd() ||
+             instruction->IsOr() ||
+             instruction->IsXor()) {
+    if (!IsPackableOperationType(instruction->GetType(), packed_type) ||
+        !IsSupportedOperation(instruction, packed_type) ||
+        !DemandVector(instruction->InputAt(0), packed_type) ||
+        !DemandVector(instruction->InputAt(1), packed_type)) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  vector_candidates_.Put(instruction, packed_type);
+  return true;
+}
+
+void HLoopOptimization::Vectorize() {
+  ArenaAllocator* arena = graph_->GetArena();
+  HBasicBlock* header = loop_info_->GetHeader();
+  HSuspendCheck* suspend_check = loop_info_->GetSuspendCheck();
+  uint32_t dex_pc = header->GetDexPc();
+  vector_map_.clear();
+
+  // The vector loop is inserted between the pre-header and the scalar loop, which
+  // runs the remaining iterations:
+  //
+  //   pre-header -> vector header <-> vector body
+  //                       |
+  //                 vector exit -> header <-> body
+  vector_preheader_ = loop_info_->GetPreHeader();
+  vector_header_ = new (arena) HBasicBlock(graph_, dex_pc);
+  vector_body_ = new (arena) HBasicBlock(graph_, dex_pc);
+  HBasicBlock* vector_exit = new (arena) HBasicBlock(graph_, dex_pc);
+  graph_->AddBlock(vector_header_);
+  graph_->AddBlock(vector_body_);
+  graph_->AddBlock(vector_exit);
+  header->ReplacePredecessor(vector_preheader_, vector_exit);
+  vector_preheader_->AddSuccessor(vector_header_);
+  vector_header_->AddSuccessor(vector_body_);
+  vector_header_->AddSuccessor(vector_exit);
+  vector_body_->AddSuccessor(vector_header_);
+
+  // The vector loop runs up to the largest multiple of the vector length not above
+  // `n`. A negative `n` gives a negative bound, and no vector iteration.
+  HInstruction* vector_upper_bound = new (arena) HAnd(
+      Primitive::kPrimInt,
+      upper_bound_,
+      graph_->GetIntConstant(-static_cast<int32_t>(vector_length_)));
+  vector_preheader_->InsertInstructionBefore(vector_upper_bound,
+                                             vector_preheader_->GetLastInstruction());
+
+  // Vector header: the vector index, the vector sums, and the loop condition.
+  vector_index_ = new (arena) HPhi(arena, kNoRegNumber, 0, Primitive::kPrimInt);
+  vector_header_->AddPhi(vector_index_);
+  vector_index_->AddInput(graph_->GetIntConstant(0));
+  for (HPhi* phi : reductions_) {
+    Primitive::Type type = phi->GetType();
+    HInstruction* zero = (type == Primitive::kPrimLong)
+        ? static_cast<HInstruction*>(graph_->GetLongConstant(0))
+        : static_cast<HInstruction*>(graph_->GetIntConstant(0));
+    HInstruction* zero_vector = new (arena) HVecReplicateScalar(arena, zero, type, vector_length_);
+    vector_preheader_->InsertInstructionBefore(zero_vector,
+                                               vector_preheader_->GetLastInstruction());
+    HPhi* vector_phi = new (arena) HPhi(arena, kNoRegNumber, 0, Primitive::kPrimDouble);
+    vector_header_->AddPhi(vector_phi);
+    vector_phi->AddInput(zero_vector);
+    vector_map_.Put(phi, vector_phi);
+  }
+  HSuspendCheck* vector_suspend_check = new (arena) HSuspendCheck(suspend_check->GetDexPc());
+  vector_header_->AddInstruction(vector_suspend_check);
+  // The copied environment refers to the phis of the scalar loop, which do not dominate
+  // the vector loop. The induction is replaced by the vector index, and the sums, only
+  // held in vectors, by no value: vectorized code is not debuggable, and does not
+  // deoptimize at suspend checks.
+  iteration_map_.clear();
+  iteration_map_.Put(induction_, vector_index_);
+  for (HPhi* phi : reductions_) {
+    iteration_map_.Put(phi, nullptr);
+  }
+  vector_suspend_check->CopyEnvironmentFrom(suspend_check->GetEnvironment());
+  RemapEnvironment(vector_suspend_check->GetEnvironment());
+  HInstruction* condition = new (arena) HLessThan(vector_index_, vector_upper_bound);
+  vector_header_->AddInstruction(condition);
+  vector_header_->AddInstruction(new (arena) HIf(condition));
+
+  // Vector body: the vector operations, in the order of the scalar ones.
+  for (HInstructionIterator it(body_->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* instruction = it.Current();
+    if (vector_candidates_.find(instruction) != vector_candidates_.end()) {
+      GenerateVector(instruction);
+    }
+  }
+  HInstruction* next_index = new (arena) HAdd(Primitive::kPrimInt,
+                                              vector_index_,
+                                              graph_->GetIntConstant(vector_length_));
+  vector_body_->AddInstruction(next_index);
+  vector_body_->AddInstruction(new (arena) HGoto());
+  vector_index_->AddInput(next_index);
+  for (HPhi* phi : reductions_) {
+    vector_map_.Get(phi)->AsPhi()->AddInput(vector_map_.Get(phi->InputAt(1)));
+  }
+
+  // Vector exit: the scalar loop continues from the vector index, and from the sums
+  // of the lanes of the vector sums.
+  for (HPhi* phi : reductions_) {
+    Primitive::Type type = phi->GetType();
+    HInstruction* reduce =
+        new (arena) HVecReduce(arena, vector_map_.Get(phi), type, vector_length_);
+    vector_exit->AddInstruction(reduce);
+    HInstruction* sum = new (arena) HAdd(type, phi->InputAt(0), reduce);
+    vector_exit->AddInstruction(sum);
+    phi->ReplaceInput(sum, 0);
+  }
+  vector_exit->AddInstruction(new (arena) HGoto());
+  induction_->ReplaceInput(vector_index_, 0);
+
+  graph_->SetHasSIMD(true);
+  RecomputeLoopInformation(graph_);
+}
+
+HInstruction* HLoopOptimization::GetVector(HInstruction* instruction,
+                                           Primitive::Type packed_type) {
+  auto it = vector_map_.find(instruction);
+  if (it != vector_map_.end()) {
+    return it->second;
+  }
+  // Invariants are replicated in the pre-header, once per loop.
+  DCHECK(IsInvariant(instruction));
+  HInstruction* vector = new (graph_->GetArena()) HVecReplicateScalar(
+      graph_->GetArena(), instruction, packed_type, vector_length_);
+  vector_preheader_->InsertInstructionBefore(vector, vector_preheader_->GetLastInstruction());
+  vector_map_.Put(instruction, vector);
+  return vector;
+}
+
+HInstruction* HLoopOptimization::GenerateVector(HInstruction* instruction) {
+  ArenaAllocator* arena = graph_->GetArena();
+  Primitive::Type packed_type = vector_candidates_.Get(instruction);
+  HInstruction* vector;
+  if (instruction->IsArrayGet()) {
+    vector = new (arena) HVecLoad(
+        arena, instruction->InputAt(0), vector_index_, packed_type, vector_length_);
+  } else if (instruction->IsArraySet()) {
+    vector = new (arena) HVecStore(arena,
+                                   instruction->InputAt(0),
+                                   vector_index_,
+                                   GetVector(instruction->InputAt(2), packed_type),
+                                   packed_type,
+                                   vector_length_);
+  } else if (instruction->IsTypeConversion()) {
+    vector = GetVector(instruction->InputAt(0), packed_type);
+    vector_map_.Put(instruction, vector);
+    return vector;
+  } else {
+    HInstruction* left = GetVector(instruction->InputAt(0), packed_type);
+    HInstruction* right = GetVector(instruction->InputAt(1), packed_type);
+    if (instruction->IsAdd()) {
+      vector = new (arena) HVecAdd(arena, left, right, packed_type, vector_length_);
+    } else if (instruction->IsSub()) {
+      vector = new (arena) HVecSub(arena, left, right, packed_type, vector_length_);
+    } else if (instruction->IsMul()) {
+      vector = new (arena) HVecMul(arena, left, right, packed_type, vector_length_);
+    } else if (instruction->IsAnd()) {
+      vector = new (arena) HVecAnd(arena, left, right, packed_type, vector_length_);
+    } else if (instruction->IsOr()) {
+      vector = new (arena) HVecOr(arena, left, right, packed_type, vector_length_);
+    } else {
+      DCHECK(instruction->IsXor());
+      vector = new (arena) HVecXor(arena, left, right, packed_type, vector_length_);
+    }
+  }
+  vector_body_->AddInstruction(vector);
+  vector_map_.Put(instruction, vector);
+  return vector;
+}
+
+bool HLoopOptimization::CanCloneBody(/*out*/ size_t* body_size) const {
+  size_t size = 0;
+  for (HInstructionIterator it(body_->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* instruction = it.Current();
+    if (instruction->IsGoto()) {
+      continue;
+    }
+    if (!IsCloneable(instruction)) {
+      return false;
+    }
+    ++size;
+  }
+  *body_size = size;
+  return true;
+}
+
+bool HLoopOptimization::CanFullyUnroll(int64_t trip_count) const {
+  size_t body_size = 0;
+  if (IsCompilingForSize() || !CanCloneBody(&body_size)) {
+    return false;
+  }
+  DCHECK_GT(trip_count, 0);
+  size_t max_instructions = std::min(kFullUnrollingMaxInstructions, code_growth_budget_);
+  return static_cast<uint64_t>(trip_count) <= max_instructions &&
+      static_cast<size_t>(trip_count) * body_size <= max_instructions;
+}
+
+bool HLoopOptimization::CanPeel() const {
+  // The exit gets phis merging the values of the loop phis from the loop and from the
+  // peeled iteration.
+  size_t body_size = 0;
+  if (IsCompilingForSize() ||
+      exit_->GetPredecessors().size() != 1 ||
+      !exit_->GetPhis().IsEmpty() ||
+      !CanCloneBody(&body_size) ||
+      body_size > std::min(kPeelingMaxInstructions, code_growth_budget_)) {
+    return false;
+  }
+  for (HInstructionIterator it(body_->GetInstructions()); !it.Done(); it.Advance()) {
+    if (IsInvariantCheck(it.Current())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool HLoopOptimization::IsInvariantCheck(HInstruction* instruction) const {
+  // LICM does not hoist these checks out of the loop body, which may not be executed.
+  if (!instruction->IsNullCheck() &&
+      !instruction->IsBoundsCheck() &&
+      !instruction->IsDivZeroCheck() &&
+      !instruction->IsClinitCheck()) {
+    return false;
+  }
+  for (size_t i = 0, e = instruction->InputCount(); i < e; ++i) {
+    if (!IsInvariant(instruction->InputAt(i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t HLoopOptimization::GetUnrollingFactor() {
+  size_t body_size = 0;
+  if (IsCompilingForSize() || !FindInductionAndCondition() || !CanCloneBody(&body_size)) {
+    return 1;
+  }
+  size_t max_factor = kUnrollingMaxFactor;
+  size_t max_instructions = kUnrollingMaxInstructions;
+  // The dex pcs of inlined loops are those of the callee, not covered by the profile. The
+  // profile only samples the back edges since the method got hot, so the loops without samples
+  // may still be hot and keep the static heuristics.
+  if (graph_->HasLoopProfile() &&
+      !loop_info_->GetSuspendCheck()->GetEnvironment()->IsFromInlinedInvoke() &&
+      graph_->IsHotLoopHeader(loop_info_->GetHeader()->GetDexPc())) {
+    max_factor = kHotUnrollingMaxFactor;
+    max_instructions = kHotUnrollingMaxInstructions;
+  }
+  max_instructions = std::min(max_instructions, code_growth_budget_);
+  size_t factor = max_factor;
+  while (factor > 1 && factor * body_size > max_instructions) {
+    factor /= 2;
+  }
+  return factor;
+}
+
+void HLoopOptimization::FullyUnroll(int64_t trip_count) {
+  HBasicBlock* header = loop_info_->GetHeader();
+  HBasicBlock* preheader = loop_info_->GetPreHeader();
+
+  // The copies of the body go to the pre-header, one per iteration.
+  iteration_map_.clear();
+  for (HInstructionIterator it(header->GetPhis()); !it.Done(); it.Advance()) {
+    iteration_map_.Put(it.Current(), it.Current()->InputAt(0));
+  }
+  for (int64_t i = 0; i < trip_count; ++i) {
+    CloneIteration(preheader);
+  }
+
+  // The loop phis get their values after the last iteration. Deleting the body
+  // replaces them with these values, and the If of the header with a Goto.
+  for (HInstructionIterator it(header->GetPhis()); !it.Done(); it.Advance()) {
+    HInstruction* phi = it.Current();
+    phi->ReplaceInput(GetIterationValue(phi), 0);
+  }
+  HInstruction* condition = header->GetLastInstruction()->InputAt(0);
+  HSuspendCheck* suspend_check = loop_info_->GetSuspendCheck();
+  body_->DisconnectAndDelete();
+  header->RemoveInstruction(condition);
+  header->RemoveInstruction(suspend_check);
+  RecomputeLoopInformation(graph_);
+}
+
+void HLoopOptimization::Peel() {
+  ArenaAllocator* arena = graph_->GetArena();
+  HBasicBlock* header = loop_info_->GetHeader();
+  HBasicBlock* preheader = loop_info_->GetPreHeader();
+  HIf* if_instruction = header->GetLastInstruction()->AsIf();
+  uint32_t dex_pc = header->GetDexPc();
+
+  // The first iteration runs before the loop, if the loop condition holds, and the
+  // loop continues from its values:
+  //
+  //   pre-header -> peeled header -> peeled body -> header <-> body
+  //                       |                            |
+  //                       +-----------> exit <---------+
+  //
+  // Rebuilding the dominator tree splits the critical edges to the exit.
+  HBasicBlock* peeled_header = new (arena) HBasicBlock(graph_, dex_pc);
+  HBasicBlock* peeled_body = new (arena) HBasicBlock(graph_, dex_pc);
+  graph_->AddBlock(peeled_header);
+  graph_->AddBlock(peeled_body);
+  header->ReplacePredecessor(preheader, peeled_body);
+  preheader->AddSuccessor(peeled_header);
+  if (if_instruction->IfTrueSuccessor() == body_) {
+    peeled_header->AddSuccessor(peeled_body);
+    peeled_header->AddSuccessor(exit_);
+  } else {
+    peeled_header->AddSuccessor(exit_);
+    peeled_header->AddSuccessor(peeled_body);
+  }
+
+  // After the loop, the loop phis are replaced by exit phis, which take their initial
+  // values when the loop is not entered.
+  for (HInstructionIterator it(header->GetPhis()); !it.Done(); it.Advance()) {
+    HPhi* phi = it.Current()->AsPhi();
+    HPhi* exit_phi = nullptr;
+    const HUseList<HInstruction*>& uses = phi->GetUses();
+    for (auto use_it = uses.begin(), end = uses.end(); use_it != end; /* ++use_it below */) {
+      HInstruction* user = use_it->GetUser();
+      size_t index = use_it->GetIndex();
+      // Increment `use_it` now because `*use_it` may disappear thanks to user->ReplaceInput().
+      ++use_it;
+      if (!IsInvariant(user)) {
+        continue;
+      }
+      if (exit_phi == nullptr) {
+        exit_phi = new (arena) HPhi(arena, kNoRegNumber, 0, phi->GetType());
+      }
+      user->ReplaceInput(exit_phi, index);
+    }
+    const HUseList<HEnvironment*>& env_uses = phi->GetEnvUses();
+    for (auto use_it = env_uses.begin(), end = env_uses.end(); use_it != end; /* ++use_it below */) {
+      HEnvironment* environment = use_it->GetUser();
+      size_t index = use_it->GetIndex();
+      ++use_it;
+      if (!IsInvariant(environment->GetHolder())) {
+        continue;
+      }
+      if (exit_phi == nullptr) {
+        exit_phi = new (arena) HPhi(arena, kNoRegNumber, 0, phi->GetType());
+      }
+      environment->RemoveAsUserOfInput(index);
+      environment->SetRawEnvAt(index, exit_phi);
+      exit_phi->AddEnvUseAt(environment, index);
+    }
+    if (exit_phi != nullptr) {
+      DCHECK_EQ(exit_->GetPredecessorIndexOf(header), 0u);
+      exit_->AddPhi(exit_phi);
+      exit_phi->AddInput(phi);
+      exit_phi->AddInput(phi->InputAt(0));
+      if (phi->GetType() == Primitive::kPrimNot) {
+        exit_phi->SetReferenceTypeInfo(phi->GetReferenceTypeInfo());
+        exit_phi->SetCanBeNull(phi->CanBeNull());
+      }
+    }
+  }
+
+  // The peeled iteration, with the loop phis at their initial values.
+  iteration_map_.clear();
+  for (HInstructionIterator it(header->GetPhis()); !it.Done(); it.Advance()) {
+    iteration_map_.Put(it.Current(), it.Current()->InputAt(0));
+  }
+  HInstruction* condition = Clone(if_instruction->InputAt(0));
+  peeled_header->AddInstruction(condition);
+  peeled_header->AddInstruction(new (arena) HIf(condition, if_instruction->GetDexPc()));
+  peeled_body->AddInstruction(new (arena) HGoto());
+  CloneIteration(peeled_body);
+  for (HInstructionIterator it(header->GetPhis()); !it.Done(); it.Advance()) {
+    HInstruction* phi = it.Current();
+    phi->ReplaceInput(GetIterationValue(phi), 0);
+  }
+
+  // The checks on loop invariants passed in the peeled iteration, which dominates the loop.
+  for (HInstructionIterator it(body_->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* instruction = it.Current();
+    if (IsInvariantCheck(instruction)) {
+      instruction->ReplaceWith(iteration_map_.Get(instruction));
+      body_->RemoveInstruction(instruction);
+    }
+  }
+
+  RecomputeLoopInformation(graph_);
+}
+
+void HLoopOptimization::PartiallyUnroll(size_t factor) {
+  ArenaAllocator* arena = graph_->GetArena();
+  HBasicBlock* header = loop_info_->GetHeader();
+  HBasicBlock* preheader = loop_info_->GetPreHeader();
+  HSuspendCheck* suspend_check = loop_info_->GetSuspendCheck();
+  uint32_t dex_pc = header->GetDexPc();
+
+  // The unrolled loop is inserted between the pre-header and the loop, which runs
+  // the remaining iterations, like a vector loop:
+  //
+  //   pre-header -> unrolled header <-> unrolled body
+  //                         |
+  //                  unrolled exit -> header <-> body
+  HBasicBlock* unrolled_header = new (arena) HBasicBlock(graph_, dex_pc);
+  HBasicBlock* unrolled_body = new (arena) HBasicBlock(graph_, dex_pc);
+  HBasicBlock* unrolled_exit = new (arena) HBasicBlock(graph_, dex_pc);
+  graph_->AddBlock(unrolled_header);
+  graph_->AddBlock(unrolled_body);
+  graph_->AddBlock(unrolled_exit);
+  header->ReplacePredecessor(preheader, unrolled_exit);
+  preheader->AddSuccessor(unrolled_header);
+  unrolled_header->AddSuccessor(unrolled_body);
+  unrolled_header->AddSuccessor(unrolled_exit);
+  unrolled_body->AddSuccessor(unrolled_header);
+
+  // For a loop from `l` to `n`, the unrolled loop runs while at least `factor`
+  // iterations remain, up to `l + ((n - l) & -factor)`. That is in [l, n] when the
+  // loop is taken, although the computation may wrap around, so the unrolled loop
+  // stops at `l` otherwise.
+  HInstruction* lower_bound = induction_->InputAt(0);
+  HInstruction* cursor = preheader->GetLastInstruction();
+  HInstruction* taken = new (arena) HLessThan(lower_bound, upper_bound_);
+  HInstruction* span = new (arena) HSub(Primitive::kPrimInt, upper_bound_, lower_bound);
+  HInstruction* unrolled_span = new (arena) HAnd(
+      Primitive::kPrimInt, span, graph_->GetIntConstant(-static_cast<int32_t>(factor)));
+  HInstruction* end = new (arena) HAdd(Primitive::kPrimInt, lower_bound, unrolled_span);
+  HInstruction* unrolled_upper_bound = new (arena) HSelect(taken, end, lower_bound, dex_pc);
+  preheader->InsertInstructionBefore(taken, cursor);
+  preheader->InsertInstructionBefore(span, cursor);
+  preheader->InsertInstructionBefore(unrolled_span, cursor);
+  preheader->InsertInstructionBefore(end, cursor);
+  preheader->InsertInstructionBefore(unrolled_upper_bound, cursor);
+
+  // Unrolled header: a copy of each loop phi, and the unrolled loop condition.
+  ArenaVector<HPhi*> unrolled_phis(arena->Adapter(kArenaAllocLoopOptimization));
+  iteration_map_.clear();
+  for (HInstructionIterator it(header->GetPhis()); !it.Done(); it.Advance()) {
+    HPhi* phi = it.Current()->AsPhi();
+    HPhi* unrolled_phi = new (arena) HPhi(arena, kNoRegNumber, 0, phi->GetType());
+    unrolled_header->AddPhi(unrolled_phi);
+    unrolled_phi->AddInput(phi->InputAt(0));
+    if (phi->GetType() == Primitive::kPrimNot) {
+      unrolled_phi->SetReferenceTypeInfo(phi->GetReferenceTypeInfo());
+      unrolled_phi->SetCanBeNull(phi->CanBeNull());
+    }
+    unrolled_phis.push_back(unrolled_phi);
+    iteration_map_.Put(phi, unrolled_phi);
+  }
+  HSuspendCheck* unrolled_suspend_check = new (arena) HSuspendCheck(suspend_check->GetDexPc());
+  unrolled_header->AddInstruction(unrolled_suspend_check);
+  unrolled_suspend_check->CopyEnvironmentFrom(suspend_check->GetEnvironment());
+  RemapEnvironment(unrolled_suspend_check->GetEnvironment());
+  HInstruction* condition =
+      new (arena) HLessThan(iteration_map_.Get(induction_), unrolled_upper_bound);
+  unrolled_header->AddInstruction(condition);
+  unrolled_header->AddInstruction(new (arena) HIf(condition));
+
+  // Unrolled body: `factor` copies of the body, the last one feeding the phis.
+  unrolled_body->AddInstruction(new (arena) HGoto());
+  for (size_t i = 0; i < factor; ++i) {
+    CloneIteration(unrolled_body);
+  }
+  size_t i = 0;
+  for (HInstructionIterator it(header->GetPhis()); !it.Done(); it.Advance(), ++i) {
+    unrolled_phis[i]->AddInput(GetIterationValue(it.Current()));
+  }
+
+  // Unrolled exit: the loop continues from the values of the unrolled loop.
+  unrolled_exit->AddInstruction(new (arena) HGoto());
+  i = 0;
+  for (HInstructionIterator it(header->GetPhis()); !it.Done(); it.Advance(), ++i) {
+    it.Current()->ReplaceInput(unrolled_phis[i], 0);
+  }
+
+  RecomputeLoopInformation(graph_);
+}
+
+void HLoopOptimization::CloneIteration(HBasicBlock* block) {
+  HInstruction* cursor = block->GetLastInstruction();
+  size_t body_size = 0;
+  for (HInstructionIterator it(body_->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* instruction = it.Current();
+    if (instruction->IsGoto()) {
+      continue;
+    }
+    HInstruction* copy = Clone(instruction);
+    block->InsertInstructionBefore(copy, cursor);
+    if (instruction->HasEnvironment()) {
+      copy->CopyEnvironmentFrom(instruction->GetEnvironment());
+      RemapEnvironment(copy->GetEnvironment());
+    }
+    // Iterations with a constant induction compute constants.
+    HConstant* constant = TryStaticEvaluation(copy);
+    if (constant != nullptr) {
+      block->RemoveInstruction(copy);
+      copy = constant;
+    } else {
+      ++body_size;
+    }
+    iteration_map_.Overwrite(instruction, copy);
+  }
+  code_growth_budget_ -= std::min(body_size, code_growth_budget_);
+
+  // The loop phis take the values computed by this iteration. All of them are looked
+  // up before any is updated, as a phi may take the value of another phi.
+  HBasicBlock* header = loop_info_->GetHeader();
+  ArenaVector<HInstruction*> next_values(
+      graph_->GetArena()->Adapter(kArenaAllocLoopOptimization));
+  for (HInstructionIterator it(header->GetPhis()); !it.Done(); it.Advance()) {
+    next_values.push_back(GetIterationValue(it.Current()->InputAt(1)));
+  }
+  size_t i = 0;
+  for (HInstructionIterator it(header->GetPhis()); !it.Done(); it.Advance(), ++i) {
+    iteration_map_.Overwrite(it.Current(), next_values[i]);
+  }
+}
+
+HInstruction* HLoopOptimization::Clone(HInstruction* instruction) {
+  ArenaAllocator* arena = graph_->GetArena();
+  Primitive::Type type = instruction->GetType();
+  uint32_t dex_pc = instruction->GetDexPc();
+  HInstruction* input0 =
+      (instruction->InputCount() > 0) ? GetIterationValue(instruction->InputAt(0)) : nullptr;
+  HInstruction* input1 =
+      (instruction->InputCount() > 1) ? GetIterationValue(instruction->InputAt(1)) : nullptr;
+  HInstruction* copy = nullptr;
+  switch (instruction->GetKind()) {
+    case HInstruction::kAdd: copy = new (arena) HAdd(type, input0, input1, dex_pc); break;
+    case HInstruction::kSub: copy = new (arena) HSub(type, input0, input1, dex_pc); break;
+    case HInstruction::kMul: copy = new (arena) HMul(type, input0, input1, dex_pc); break;
+    case HInstruction::kDiv: copy = new (arena) HDiv(type, input0, input1, dex_pc); break;
+    case HInstruction::kRem: copy = new (arena) HRem(type, input0, input1, dex_pc); break;
+    case HInstruction::kAnd: copy = new (arena) HAnd(type, input0, input1, dex_pc); break;
+    case HInstruction::kOr: copy = new (arena) HOr(type, input0, input1, dex_pc); break;
+    case HInstruction::kXor: copy = new (arena) HXor(type, input0, input1, dex_pc); break;
+    case HInstruction::kShl: copy = new (arena) HShl(type, input0, input1, dex_pc); break;
+    case HInstruction::kShr: copy = new (arena) HShr(type, input0, input1, dex_pc); break;
+    case HInstruction::kUShr: copy = new (arena) HUShr(type, input0, input1, dex_pc); break;
+    case HInstruction::kRor: copy = new (arena) HRor(type, input0, input1); break;
+    case HInstruction::kNeg: copy = new (arena) HNeg(type, input0, dex_pc); break;
+    case HInstruction::kNot: copy = new (arena) HNot(type, input0, dex_pc); break;
+    case HInstruction::kTypeConversion:
+      copy = new (arena) HTypeConversion(type, input0, dex_pc);
+      break;
+    case HInstruction::kEqual: copy = new (arena) HEqual(input0, input1, dex_pc); break;
+    case HInstruction::kNotEqual: copy = new (arena) HNotEqual(input0, input1, dex_pc); break;
+    case HInstruction::kLessThan: copy = new (arena) HLessThan(input0, input1, dex_pc); break;
+    case HInstruction::kLessThanOrEqual:
+      copy = new (arena) HLessThanOrEqual(input0, input1, dex_pc);
+      break;
+    case HInstruction::kGreaterThan:
+      copy = new (arena) HGreaterThan(input0, input1, dex_pc);
+      break;
+    case HInstruction::kGreaterThanOrEqual:
+      copy = new (arena) HGreaterThanOrEqual(input0, input1, dex_pc);
+      break;
+    case HInstruction::kBelow: copy = new (arena) HBelow(input0, input1, dex_pc); break;
+    case HInstruction::kBelowOrEqual:
+      copy = new (arena) HBelowOrEqual(input0, input1, dex_pc);
+      break;
+    case HInstruction::kAbove: copy = new (arena) HAbove(input0, input1, dex_pc); break;
+    case HInstruction::kAboveOrEqual:
+      copy = new (arena) HAboveOrEqual(input0, input1, dex_pc);
+      break;
+    case HInstruction::kArrayLength: copy = new (arena) HArrayLength(input0, dex_pc); break;
+    case HInstruction::kArrayGet:
+      copy = new (arena) HArrayGet(input0, input1, type, dex_pc, instruction->GetSideEffects());
+      break;
+    case HInstruction::kArraySet:
+      copy = new (arena) HArraySet(input0,
+                                   input1,
+                                   GetIterationValue(instruction->InputAt(2)),
+                                   instruction->AsArraySet()->GetComponentType(),
+                                   dex_pc,
+                                   instruction->GetSideEffects());
+      break;
+    case HInstruction::kNullCheck: copy = new (arena) HNullCheck(input0, dex_pc); break;
+    case HInstruction::kBoundsCheck:
+      copy = new (arena) HBoundsCheck(input0, input1, dex_pc);
+      break;
+    case HInstruction::kDivZeroCheck: copy = new (arena) HDivZeroCheck(input0, dex_pc); break;
+    case HInstruction::kClinitCheck:
+      copy = new (arena) HClinitCheck(input0->AsLoadClass(), dex_pc);
+      break;
+    case HInstruction::kInstanceFieldGet: {
+      const FieldInfo& info = instruction->AsInstanceFieldGet()->GetFieldInfo();
+      copy = new (arena) HInstanceFieldGet(input0,
+                                           info.GetFieldType(),
+                                           info.GetFieldOffset(),
+                                           info.IsVolatile(),
+                                           info.GetFieldIndex(),
+                                           info.GetDeclaringClassDefIndex(),
+                                           info.GetDexFile(),
+                                           info.GetDexCache(),
+                                           dex_pc);
+      break;
+    }
+    case HInstruction::kInstanceFieldSet: {
+      const FieldInfo& info = instruction->AsInstanceFieldSet()->GetFieldInfo();
+      copy = new (arena) HInstanceFieldSet(input0,
+                                           input1,
+                                           info.GetFieldType(),
+                                           info.GetFieldOffset(),
+                                           info.IsVolatile(),
+                                           info.GetFieldIndex(),
+                                           info.GetDeclaringClassDefIndex(),
+                                           info.GetDexFile(),
+                                           info.GetDexCache(),
+                                           dex_pc);
+      if (!instruction->AsInstanceFieldSet()->GetValueCanBeNull()) {
+        copy->AsInstanceFieldSet()->ClearValueCanBeNull();
+      }
+      break;
+    }
+    case HInstruction::kStaticFieldGet: {
+      const FieldInfo& info = instruction->AsStaticFieldGet()->GetFieldInfo();
+      copy = new (arena) HStaticFieldGet(input0,
+                                         info.GetFieldType(),
+                                         info.GetFieldOffset(),
+                                         info.IsVolatile(),
+                                         info.GetFieldIndex(),
+                                         info.GetDeclaringClassDefIndex(),
+                                         info.GetDexFile(),
+                                         info.GetDexCache(),
+                                         dex_pc);
+      break;
+    }
+    case HInstruction::kStaticFieldSet: {
+      const FieldInfo& info = instruction->AsStaticFieldSet()->GetFieldInfo();
+      copy = new (arena) HStaticFieldSet(input0,
+                                         input1,
+                                         info.GetFieldType(),
+                                         info.GetFieldOffset(),
+                                         info.IsVolatile(),
+                                         info.GetFieldIndex(),
+                                         info.GetDeclaringClassDefIndex(),
+                                         info.GetDexFile(),
+                                         info.GetDexCache(),
+                                         dex_pc);
+      if (!instruction->AsStaticFieldSet()->GetValueCanBeNull()) {
+        copy->AsStaticFieldSet()->ClearValueCanBeNull();
+      }
+      break;
+    }
+    default:
+      LOG(FATAL) << "Unexpected instruction " << instruction->DebugName();
+      UNREACHABLE();
+  }
+  if (instruction->IsCondition()) {
+    copy->AsCondition()->SetBias(instruction->AsCondition()->GetBias());
+  }
+  if (type == Primitive::kPrimNot) {
+    copy->SetReferenceTypeInfo(instruction->GetReferenceTypeInfo());
+  }
+  return copy;
+}
+
+HInstruction* HLoopOptimization::GetIterationValue(HInstruction* instruction) const {
+  auto it = iteration_map_.find(instruction);
+  if (it != iteration_map_.end()) {
+    return it->second;
+  }
+  DCHECK(IsInvariant(instruction));
+  return instruction;
+}
+
+void HLoopOptimization::RemapEnvironment(HEnvironment* environment) {
+  for (; environment != nullptr; environment = environment->GetParent()) {
+    for (size_t i = 0, e = environment->Size(); i < e; ++i) {
+      HInstruction* value = environment->GetInstructionAt(i);
+      if (value == nullptr) {
+        continue;
+      }
+      auto it = iteration_map_.find(value);
+      if (it == iteration_map_.end()) {
+        DCHECK(IsInvariant(value));
+        continue;
+      }
+      HInstruction* replacement = it->second;
+      environment->RemoveAsUserOfInput(i);
+      environment->SetRawEnvAt(i, replacement);
+      if (replacement != nullptr) {
+        replacement->AddEnvUseAt(environment, i);
+      }
+    }
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_LOOP_OPTIMIZATION_H_
+#define ART_COMPILER_OPTIMIZING_LOOP_OPTIMIZATION_H_
+
+#include "base/arena_containers.h"
+#include "induction_var_range.h"
+#include "nodes.h"
+#include "optimization.h"
+
+namespace art {
+
+class CompilerDriver;
+
+/**
+ * Loop optimizations, on innermost loops made of a header evaluating the loop
+ * condition and of a single body block:
+ *
+ * (1) Full unrolling: a loop with a small constant trip count, as found by the
+ *     induction variable analysis, is replaced by copies of its body.
+ * (2) Vectorization: a simple counted loop over arrays
+ *
+ *       for (int i = 0; i < n; i++) { a[i] = b[i] + x; sum += c[i]; }
+ *
+ *     gets a vector loop processing one SIMD register worth of elements per
+ *     iteration inserted before it, the original loop becoming the cleanup loop
+ *     running the remaining iterations.
+ * (3) Peeling: the first iteration of a loop with null, bounds, division by zero
+ *     or class initialization checks on loop invariants is run before the loop,
+ *     which then no longer needs these checks.
+ * (4) Partial unrolling: a counted loop with a small body gets a loop running
+ *     several copies of its body per iteration inserted before it, in the same
+ *     way as a vector loop. The loops the JIT profile found hot are unrolled the
+ *     most, the loops it found cold not at all.
+ *
+ * Unrolling and peeling stay within a code size budget per loop and per method,
+ * and are not done when compiling for size.
+ */
+class HLoopOptimization : public HOptimization {
+ public:
+  HLoopOptimization(HGraph* graph,
+                    CompilerDriver* compiler_driver,
+                    HInductionVarAnalysis* induction_analysis,
+                    OptimizingCompilerStats* stats);
+
+  void Run() OVERRIDE;
+
+  static constexpr const char* kLoopOptimizationPassName = "loop_optimization";
+
+ private:
+  // Applies the transformations that fit the loop with header `header`.
+  void OptimizeLoop(HBasicBlock* header);
+
+  // Returns whether the loop with header `header` is made of the header, only
+  // evaluating the loop condition, and of a single body block, in which case
+  // loop_info_, body_ and exit_ are set.
+  bool IsSimpleLoop(HBasicBlock* header);
+
+  // Returns whether the loop runs while `i < n`, for an int induction `i` incremented
+  // by 1 in the body and an invariant `n`, in which case induction_, increment_ and
+  // upper_bound_ are set.
+  bool FindInductionAndCondition();
+
+  bool IsInvariant(HInstruction* instruction) const;
+
+  // Returns whether the code size matters more than the speed of the code.
+  bool IsCompilingForSize() const;
+
+  // Returns whether the code generator supports `instruction` on vectors of `packed_type`.
+  bool IsVectorizationSupported() const;
+  bool IsSupportedOperation(HInstruction* instruction, Primitive::Type packed_type) const;
+
+  // Vectorization analysis: returns whether the loop can be vectorized, in which
+  // case the fields describing the vector loop are set.
+  bool CanVectorize();
+  bool FindRoots();
+  bool DemandVector(HInstruction* instruction, Primitive::Type packed_type);
+
+  // Vectorization: inserts the vector loop before the analyzed loop.
+  void Vectorize();
+  HInstruction* GetVector(HInstruction* instruction, Primitive::Type packed_type);
+  HInstruction* GenerateVector(HInstruction* instruction);
+
+  // Unrolling and peeling analysis. Returns whether all the instructions of the
+  // body can be copied, and their number in `body_size`.
+  bool CanCloneBody(/*out*/ size_t* body_size) const;
+  bool CanFullyUnroll(int64_t trip_count) const;
+  bool CanPeel() const;
+  bool IsInvariantCheck(HInstruction* instruction) const;
+  // Returns the number of copies of the body in an iteration of the partially
+  // unrolled loop, 1 if the loop is not worth unrolling.
+  size_t GetUnrollingFactor();
+
+  // Unrolling and peeling.
+  void FullyUnroll(int64_t trip_count);
+  void Peel();
+  void PartiallyUnroll(size_t factor);
+
+  // Appends a copy of the body to `block`, for the iteration in which the loop phis
+  // have the values given by iteration_map_, then maps the loop phis to their values
+  // in the next iteration.
+  void CloneIteration(HBasicBlock* block);
+  HInstruction* Clone(HInstruction* instruction);
+  HInstruction* GetIterationValue(HInstruction* instruction) const;
+
+  // Replaces the loop values in `environment` by their values in iteration_map_.
+  void RemapEnvironment(HEnvironment* environment);
+
+  CompilerDriver* const compiler_driver_;
+  InductionVarRange induction_range_;
+
+  // Constant trip counts of the loops, by header, looked up before the first
+  // transformation recomputes the loop information, which the induction variable
+  // analysis refers to.
+  ArenaSafeMap<HBasicBlock*, int64_t> trip_counts_;
+
+  // Number of instructions unrolling and peeling may still add to the method.
+  size_t code_growth_budget_;
+
+  // The loop being analyzed, and its parts.
+  HLoopInformation* loop_info_;
+  HBasicBlock* body_;
+  HBasicBlock* exit_;
+  HPhi* induction_;
+  HInstruction* increment_;
+  HInstruction* upper_bound_;
+
+  // Number of elements processed per iteration of the vector loop, which is the
+  // same for all the vector operations of the loop.
+  size_t vector_length_;
+
+  // Instructions of the loop body turned into vector operations, with their packed type.
+  ArenaSafeMap<HInstruction*, Primitive::Type> vector_candidates_;
+
+  // Header phis accumulating a sum over the loop iterations.
+  ArenaVector<HPhi*> reductions_;
+
+  // Vector (or vector phi) replacing a scalar, during the transformation.
+  ArenaSafeMap<HInstruction*, HInstruction*> vector_map_;
+
+  // Blocks of the vector loop, during the transformation.
+  HBasicBlock* vector_preheader_;
+  HBasicBlock* vector_header_;
+  HBasicBlock* vector_body_;
+  HPhi* vector_index_;
+
+  // Values of the loop phis and of the body instructions in the iteration being
+  // copied, or in the vector loop.
+  ArenaSafeMap<HInstruction*, HInstruction*> iteration_map_;
+
+  DISALLOW_COPY_AND_ASSIGN(HLoopOptimization);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_LOOP_OPTIMIZATION_H_
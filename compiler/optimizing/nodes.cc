@@ -644,6 +644,31 @@ void HLoopInformation::PopulateIrreducibleRecursive(HBasicBlock* block, ArenaBit
   }
 }
 
+static bool IsInlinedLoop(HLoopInformation* info) {
+  HSuspendCheck* suspend_check = info->GetSuspendCheck();
+  if (suspend_check == nullptr) {
+    // Just building the graph in OSR mode, this loop is not inlined. We never build an
+    // inner graph in OSR mode as we can do OSR transition only from the outer method.
+    return false;
+  }
+  // Look at the suspend check's environment to determine if the loop was inlined.
+  DCHECK(suspend_check->HasEnvironment());
+  return suspend_check->GetEnvironment()->IsFromInlinedInvoke();
+}
+
+bool HLoopInformation::HasOsrEntry() const {
+  // Inlined loops do not act as OSR entry points, and their dex pcs are those of the callee.
+  for (HBlocksInLoopIterator it(*this); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    if (block->IsLoopHeader() &&
+        !IsInlinedLoop(block->GetLoopInformation()) &&
+        header_->GetGraph()->IsOsrLoopHeader(block->GetDexPc())) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void HLoopInformation::Populate() {
   DCHECK_EQ(blocks_.NumSetBits(), 0u) << "Loop information has already been populated";
   // Populate this loop: starting with the back edge, recursively add predecessors
@@ -674,22 +699,12 @@ void HLoopInformation::Populate() {
     }
   }
 
-  if (!is_irreducible_loop && graph->IsCompilingOsr()) {
-    // When compiling in OSR mode, all loops in the compiled method may be entered
+  if (!is_irreducible_loop && graph->IsCompilingOsr() && HasOsrEntry()) {
+    // When compiling in OSR mode, the hot loops in the compiled method may be entered
     // from the interpreter. We treat this OSR entry point just like an extra entry
-    // to an irreducible loop, so we need to mark the method's loops as irreducible.
-    // This does not apply to inlined loops which do not act as OSR entry points.
-    if (suspend_check_ == nullptr) {
-      // Just building the graph in OSR mode, this loop is not inlined. We never build an
-      // inner graph in OSR mode as we can do OSR transition only from the outer method.
-      is_irreducible_loop = true;
-    } else {
-      // Look at the suspend check's environment to determine if the loop was inlined.
-      DCHECK(suspend_check_->HasEnvironment());
-      if (!suspend_check_->GetEnvironment()->IsFromInlinedInvoke()) {
-        is_irreducible_loop = true;
-      }
-    }
+    // to an irreducible loop, so we need to mark these loops, and the loops around
+    // them, as irreducible.
+    is_irreducible_loop = true;
   }
   if (is_irreducible_loop) {
     irreducible_ = true;
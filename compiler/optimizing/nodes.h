@@ -283,6 +283,7 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
          InvokeType invoke_type = kInvalidInvokeType,
          bool debuggable = false,
          bool osr = false,
+         bool baseline = false,
          int start_instruction_id = 0)
       : arena_(arena),
         blocks_(arena->Adapter(kArenaAllocBlockList)),
@@ -296,6 +297,7 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
         temporaries_vreg_slots_(0),
         has_bounds_checks_(false),
         has_try_catch_(false),
+        has_simd_(false),
         has_irreducible_loops_(false),
         debuggable_(debuggable),
         current_instruction_id_(start_instruction_id),
@@ -312,7 +314,14 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
         cached_double_constants_(std::less<int64_t>(), arena->Adapter(kArenaAllocConstantsMap)),
         cached_current_method_(nullptr),
         inexact_object_rti_(ReferenceTypeInfo::CreateInvalid()),
-        osr_(osr) {
+        osr_(osr),
+        osr_loop_headers_(arena->Adapter(kArenaAllocGraph)),
+        has_loop_profile_(false),
+        hot_loop_headers_(arena->Adapter(kArenaAllocGraph)),
+        baseline_(baseline),
+        speculation_allowed_(!osr),
+        cha_single_implementation_list_(std::less<ArtMethod*>(),
+                                        arena->Adapter(kArenaAllocGraph)) {
     blocks_.reserve(kDefaultNumberOfBlocks);
   }
 
@@ -453,6 +462,14 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
     has_bounds_checks_ = value;
   }
 
+  bool HasSIMD() const {
+    return has_simd_;
+  }
+
+  void SetHasSIMD(bool value) {
+    has_simd_ = value;
+  }
+
   bool ShouldGenerateConstructorBarrier() const {
     return should_generate_constructor_barrier_;
   }
@@ -502,6 +519,37 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
 
   bool IsCompilingOsr() const { return osr_; }
 
+  // Restricts the OSR entries of the compiled code to the loops with the given header
+  // dex pc. Without any, all the loops of the method are entries.
+  void AddOsrLoopHeader(uint32_t dex_pc) { osr_loop_headers_.push_back(dex_pc); }
+  bool IsOsrLoopHeader(uint32_t dex_pc) const {
+    return osr_loop_headers_.empty() || ContainsElement(osr_loop_headers_, dex_pc);
+  }
+
+  // Records the loops of the method the JIT profile found hot, by header dex pc.
+  // Without a loop profile, or for the loops without samples in it, the hotness
+  // of the loops is unknown.
+  bool HasLoopProfile() const { return has_loop_profile_; }
+  void SetHasLoopProfile(bool value) { has_loop_profile_ = value; }
+  void AddHotLoopHeader(uint32_t dex_pc) { hot_loop_headers_.push_back(dex_pc); }
+  bool IsHotLoopHeader(uint32_t dex_pc) const {
+    return ContainsElement(hot_loop_headers_, dex_pc);
+  }
+
+  bool IsCompilingBaseline() const { return baseline_; }
+
+  bool IsSpeculationAllowed() const { return speculation_allowed_; }
+  void SetSpeculationAllowed(bool value) { speculation_allowed_ = value; }
+
+  // Records that the code devirtualized calls to `method` because no loaded class overrides it,
+  // so that the JIT code cache invalidates the code when a class overriding it gets loaded.
+  void AddChaSingleImplementationDependency(ArtMethod* method) {
+    cha_single_implementation_list_.insert(method);
+  }
+  const ArenaSet<ArtMethod*>& GetChaSingleImplementationList() const {
+    return cha_single_implementation_list_;
+  }
+
   bool HasTryCatch() const { return has_try_catch_; }
   void SetHasTryCatch(bool value) { has_try_catch_ = value; }
 
@@ -585,6 +633,10 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
   // try/catch-related passes if false.
   bool has_try_catch_;
 
+  // Flag whether SIMD instructions appear in the graph. If true, the code
+  // generators may have to be more careful spilling the wider registers.
+  bool has_simd_;
+
   // Flag whether there are any irreducible loops in the graph.
   bool has_irreducible_loops_;
 
@@ -637,6 +689,29 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
   // compiled code entries which the interpreter can directly jump to.
   const bool osr_;
 
+  // The dex pcs of the loop headers the interpreter may enter the OSR code at,
+  // the loops which got hot. Other loops are compiled as regular loops.
+  ArenaVector<uint32_t> osr_loop_headers_;
+
+  // Whether the JIT profile counted the back edges of the loops of the method,
+  // and the dex pcs of the headers of the loops it found hot.
+  bool has_loop_profile_;
+  ArenaVector<uint32_t> hot_loop_headers_;
+
+  // Whether we are compiling this graph for the baseline JIT tier: the graph
+  // is only lightly optimized and reports method hotness and receiver types
+  // back to the runtime so that the method can later be recompiled optimized.
+  const bool baseline_;
+
+  // Whether the compiled code may rely on assumptions it checks with HDeoptimize,
+  // from the profile or from dynamic bounds checks. Never for OSR, as we should never
+  // deoptimize from an OSR method, and not for methods which deoptimized too often.
+  bool speculation_allowed_;
+
+  // The methods with a single implementation the code relies on, see
+  // AddChaSingleImplementationDependency.
+  ArenaSet<ArtMethod*> cha_single_implementation_list_;
+
   friend class SsaBuilder;           // For caching constants.
   friend class SsaLivenessAnalysis;  // For the linear order.
   friend class HInliner;             // For the reverse post order.
@@ -739,6 +814,9 @@ class HLoopInformation : public ArenaObject<kArenaAllocLoopInfo> {
   // Internal recursive implementation of `Populate`.
   void PopulateRecursive(HBasicBlock* block);
   void PopulateIrreducibleRecursive(HBasicBlock* block, ArenaBitVector* finalized);
+  // Returns whether the interpreter may enter the OSR code in this loop, at its
+  // header or at the header of an inner loop.
+  bool HasOsrEntry() const;
 
   HBasicBlock* header_;
   HSuspendCheck* suspend_check_;
@@ -1264,6 +1342,9 @@ class HLoopInformationOutwardIterator : public ValueObject {
   M(TryBoundary, Instruction)                                           \
   M(TypeConversion, Instruction)                                        \
   M(UShr, BinaryOperation)                                              \
+  M(UpdateBranchProfile, Instruction)                                   \
+  M(UpdateHotness, Instruction)                                         \
+  M(UpdateInlineCache, Instruction)                                     \
   M(Xor, BinaryOperation)                                               \
 
 /*
@@ -1308,8 +1389,25 @@ class HLoopInformationOutwardIterator : public ValueObject {
 
 #define FOR_EACH_CONCRETE_INSTRUCTION_X86_64(M)
 
+/*
+ * Vector instructions, only generated by the loop optimization for the
+ * architectures it vectorizes loops for.
+ */
+#define FOR_EACH_CONCRETE_INSTRUCTION_VECTOR(M)                         \
+  M(VecReplicateScalar, VecUnaryOperation)                              \
+  M(VecReduce, VecUnaryOperation)                                       \
+  M(VecAdd, VecBinaryOperation)                                         \
+  M(VecSub, VecBinaryOperation)                                         \
+  M(VecMul, VecBinaryOperation)                                         \
+  M(VecAnd, VecBinaryOperation)                                         \
+  M(VecOr, VecBinaryOperation)                                          \
+  M(VecXor, VecBinaryOperation)                                         \
+  M(VecLoad, VecMemoryOperation)                                        \
+  M(VecStore, VecMemoryOperation)
+
 #define FOR_EACH_CONCRETE_INSTRUCTION(M)                                \
   FOR_EACH_CONCRETE_INSTRUCTION_COMMON(M)                               \
+  FOR_EACH_CONCRETE_INSTRUCTION_VECTOR(M)                               \
   FOR_EACH_CONCRETE_INSTRUCTION_SHARED(M)                               \
   FOR_EACH_CONCRETE_INSTRUCTION_ARM(M)                                  \
   FOR_EACH_CONCRETE_INSTRUCTION_ARM64(M)                                \
@@ -1323,7 +1421,11 @@ class HLoopInformationOutwardIterator : public ValueObject {
   M(Constant, Instruction)                                              \
   M(UnaryOperation, Instruction)                                        \
   M(BinaryOperation, Instruction)                                       \
-  M(Invoke, Instruction)
+  M(Invoke, Instruction)                                                \
+  M(VecOperation, Instruction)                                          \
+  M(VecUnaryOperation, VecOperation)                                    \
+  M(VecBinaryOperation, VecOperation)                                   \
+  M(VecMemoryOperation, VecOperation)
 
 #define FOR_EACH_INSTRUCTION(M)                                         \
   FOR_EACH_CONCRETE_INSTRUCTION(M)                                      \
@@ -6164,6 +6266,68 @@ class HMonitorOperation : public HTemplateInstruction<1> {
   DISALLOW_COPY_AND_ASSIGN(HMonitorOperation);
 };
 
+// Reports to the runtime that the method compiled for the baseline JIT tier
+// was entered or took a loop back edge, so that the runtime can decide when
+// to recompile it with the optimizing tier. For a back edge, returns whether
+// OSR code is ready for the loop, in which case the compiled code transfers
+// to the interpreter, which enters the OSR code at the next back edge.
+class HUpdateHotness : public HExpression<1> {
+ public:
+  HUpdateHotness(HCurrentMethod* current_method, bool is_back_edge, uint32_t dex_pc)
+      : HExpression(Primitive::kPrimBoolean, SideEffects::CanTriggerGC(), dex_pc) {
+    SetPackedFlag<kFlagIsBackEdge>(is_back_edge);
+    SetRawInputAt(0, current_method);
+  }
+
+  bool IsBackEdge() const { return GetPackedFlag<kFlagIsBackEdge>(); }
+
+  DECLARE_INSTRUCTION(UpdateHotness);
+
+ private:
+  static constexpr size_t kFlagIsBackEdge = kNumberOfExpressionPackedBits;
+  static constexpr size_t kNumberOfUpdateHotnessPackedBits = kFlagIsBackEdge + 1;
+  static_assert(kNumberOfUpdateHotnessPackedBits <= kMaxNumberOfPackedBits,
+                "Too many packed fields.");
+
+  DISALLOW_COPY_AND_ASSIGN(HUpdateHotness);
+};
+
+// Records the class of the receiver of a virtual or interface call in the
+// inline cache of the calling method, for the baseline JIT tier.
+class HUpdateInlineCache : public HTemplateInstruction<2> {
+ public:
+  HUpdateInlineCache(HCurrentMethod* current_method, HInstruction* receiver, uint32_t dex_pc)
+      : HTemplateInstruction(SideEffects::CanTriggerGC(), dex_pc) {
+    SetRawInputAt(0, current_method);
+    SetRawInputAt(1, receiver);
+  }
+
+  HInstruction* GetReceiver() const { return InputAt(1); }
+
+  DECLARE_INSTRUCTION(UpdateInlineCache);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HUpdateInlineCache);
+};
+
+// Records whether the IF at the dex pc of the instruction jumps to its target,
+// that is whether its condition is true, for the baseline JIT tier.
+class HUpdateBranchProfile : public HTemplateInstruction<2> {
+ public:
+  HUpdateBranchProfile(HCurrentMethod* current_method, HInstruction* condition, uint32_t dex_pc)
+      : HTemplateInstruction(SideEffects::CanTriggerGC(), dex_pc) {
+    SetRawInputAt(0, current_method);
+    SetRawInputAt(1, condition);
+  }
+
+  HInstruction* GetCondition() const { return InputAt(1); }
+
+  DECLARE_INSTRUCTION(UpdateBranchProfile);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HUpdateBranchProfile);
+};
+
 class HSelect : public HExpression<3> {
  public:
   HSelect(HInstruction* condition,
@@ -6347,6 +6511,7 @@ class HParallelMove : public HTemplateInstruction<0> {
 #ifdef ART_ENABLE_CODEGEN_x86
 #include "nodes_x86.h"
 #endif
+#include "nodes_vector.h"
 
 namespace art {
 
@@ -0,0 +1,401 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_NODES_VECTOR_H_
+#define ART_COMPILER_OPTIMIZING_NODES_VECTOR_H_
+
+namespace art {
+
+// Abstraction of a vector operation, i.e. an operation performed on all the
+// `vector_length` lanes of a SIMD register, each lane holding a value of the
+// packed type. Vector operations are introduced by the loop optimization
+// pass, and only supported by the code generators of the instruction sets
+// the pass vectorizes loops for.
+class HVecOperation : public HInstruction {
+ public:
+  // Number of bytes in a SIMD register, on all supported instruction sets.
+  static constexpr size_t kSIMDNumberOfBytes = 16;
+
+  HVecOperation(ArenaAllocator* arena,
+                Primitive::Type packed_type,
+                SideEffects side_effects,
+                size_t number_of_inputs,
+                size_t vector_length,
+                uint32_t dex_pc)
+      : HInstruction(side_effects, dex_pc),
+        vector_length_(vector_length),
+        inputs_(number_of_inputs, arena->Adapter(kArenaAllocVectorNode)) {
+    DCHECK_GE(vector_length, 2u);
+    SetPackedField<TypeField>(packed_type);
+  }
+
+  size_t InputCount() const OVERRIDE { return inputs_.size(); }
+
+  // Returns the type of the values held by the lanes.
+  Primitive::Type GetPackedType() const { return GetPackedField<TypeField>(); }
+
+  // Returns the number of lanes.
+  size_t GetVectorLength() const { return vector_length_; }
+
+  // Returns the number of bytes in a full vector.
+  size_t GetVectorNumberOfBytes() const {
+    return vector_length_ * Primitive::ComponentSize(GetPackedType());
+  }
+
+  // A vector value lives in a floating point (SIMD) register, which the register
+  // allocator only assigns to floating point values. Operations not producing a
+  // vector value override this.
+  Primitive::Type GetType() const OVERRIDE { return Primitive::kPrimDouble; }
+
+  // Vector values are not moved by GVN or LICM: a vector value live across a call
+  // would need the full SIMD register preserved, while callee-save conventions only
+  // preserve its low 64 bits.
+  bool CanBeMoved() const OVERRIDE { return false; }
+
+  bool InstructionDataEquals(HInstruction* other) const OVERRIDE {
+    const HVecOperation* o = other->AsVecOperation();
+    return GetVectorLength() == o->GetVectorLength() && GetPackedType() == o->GetPackedType();
+  }
+
+  // Returns whether `instruction` defines a vector value, which needs a full SIMD
+  // register, or a full SIMD stack slot when spilled.
+  static bool ReturnsSIMDValue(HInstruction* instruction) {
+    if (instruction->IsVecOperation()) {
+      return instruction->GetType() == Primitive::kPrimDouble;
+    } else if (instruction->IsPhi() && instruction->GetType() == Primitive::kPrimDouble) {
+      // The vectorizer creates the inputs of a vector phi before the phi itself.
+      for (size_t i = 0, e = instruction->InputCount(); i < e; ++i) {
+        if (instruction->InputAt(i)->IsVecOperation()) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  DECLARE_ABSTRACT_INSTRUCTION(VecOperation);
+
+ protected:
+  const HUserRecord<HInstruction*> InputRecordAt(size_t index) const OVERRIDE {
+    return inputs_[index];
+  }
+
+  void SetRawInputRecordAt(size_t index, const HUserRecord<HInstruction*>& input) OVERRIDE {
+    inputs_[index] = input;
+  }
+
+  static constexpr size_t kFieldType = HInstruction::kNumberOfGenericPackedBits;
+  static constexpr size_t kFieldTypeSize =
+      MinimumBitsToStore(static_cast<size_t>(Primitive::kPrimLast));
+  static constexpr size_t kNumberOfVectorOpPackedBits = kFieldType + kFieldTypeSize;
+  static_assert(kNumberOfVectorOpPackedBits <= kMaxNumberOfPackedBits, "Too many packed fields.");
+  using TypeField = BitField<Primitive::Type, kFieldType, kFieldTypeSize>;
+
+ private:
+  const size_t vector_length_;
+  ArenaVector<HUserRecord<HInstruction*>> inputs_;
+
+  DISALLOW_COPY_AND_ASSIGN(HVecOperation);
+};
+
+// Abstraction of a unary vector operation.
+class HVecUnaryOperation : public HVecOperation {
+ public:
+  HVecUnaryOperation(ArenaAllocator* arena,
+                     HInstruction* input,
+                     Primitive::Type packed_type,
+                     size_t vector_length,
+                     uint32_t dex_pc)
+      : HVecOperation(arena,
+                      packed_type,
+                      SideEffects::None(),
+                      /* number_of_inputs */ 1,
+                      vector_length,
+                      dex_pc) {
+    SetRawInputAt(0, input);
+  }
+
+  HInstruction* GetInput() const { return InputAt(0); }
+
+  DECLARE_ABSTRACT_INSTRUCTION(VecUnaryOperation);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecUnaryOperation);
+};
+
+// Abstraction of a binary vector operation, performed lane by lane.
+class HVecBinaryOperation : public HVecOperation {
+ public:
+  HVecBinaryOperation(ArenaAllocator* arena,
+                      HInstruction* left,
+                      HInstruction* right,
+                      Primitive::Type packed_type,
+                      size_t vector_length,
+                      uint32_t dex_pc)
+      : HVecOperation(arena,
+                      packed_type,
+                      SideEffects::None(),
+                      /* number_of_inputs */ 2,
+                      vector_length,
+                      dex_pc) {
+    SetRawInputAt(0, left);
+    SetRawInputAt(1, right);
+  }
+
+  HInstruction* GetLeft() const { return InputAt(0); }
+  HInstruction* GetRight() const { return InputAt(1); }
+
+  DECLARE_ABSTRACT_INSTRUCTION(VecBinaryOperation);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecBinaryOperation);
+};
+
+// Abstraction of a vector operation accessing the consecutive array elements
+// base[index], ..., base[index + vector_length - 1]. The vectorizer only uses
+// these once the bounds checks and null check of the accesses are eliminated.
+class HVecMemoryOperation : public HVecOperation {
+ public:
+  HVecMemoryOperation(ArenaAllocator* arena,
+                      Primitive::Type packed_type,
+                      SideEffects side_effects,
+                      size_t number_of_inputs,
+                      size_t vector_length,
+                      uint32_t dex_pc)
+      : HVecOperation(arena, packed_type, side_effects, number_of_inputs, vector_length, dex_pc) {}
+
+  HInstruction* GetArray() const { return InputAt(0); }
+  HInstruction* GetIndex() const { return InputAt(1); }
+
+  DECLARE_ABSTRACT_INSTRUCTION(VecMemoryOperation);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecMemoryOperation);
+};
+
+//
+// Definitions of concrete vector operations.
+//
+
+// Replicates a scalar value into all lanes:
+//   replicate(x) = [ x, .. , x ].
+class HVecReplicateScalar : public HVecUnaryOperation {
+ public:
+  HVecReplicateScalar(ArenaAllocator* arena,
+                      HInstruction* scalar,
+                      Primitive::Type packed_type,
+                      size_t vector_length,
+                      uint32_t dex_pc = kNoDexPc)
+      : HVecUnaryOperation(arena, scalar, packed_type, vector_length, dex_pc) {}
+
+  DECLARE_INSTRUCTION(VecReplicateScalar);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecReplicateScalar);
+};
+
+// Adds all lanes into a scalar value, wrapping around on overflow:
+//   reduce([ x1, .. , xn ]) = x1 + .. + xn.
+class HVecReduce : public HVecUnaryOperation {
+ public:
+  HVecReduce(ArenaAllocator* arena,
+             HInstruction* input,
+             Primitive::Type packed_type,
+             size_t vector_length,
+             uint32_t dex_pc = kNoDexPc)
+      : HVecUnaryOperation(arena, input, packed_type, vector_length, dex_pc) {
+    DCHECK(packed_type == Primitive::kPrimInt || packed_type == Primitive::kPrimLong);
+  }
+
+  Primitive::Type GetType() const OVERRIDE { return GetPackedType(); }
+
+  DECLARE_INSTRUCTION(VecReduce);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecReduce);
+};
+
+// Adds lanes, wrapping around on overflow for integral types:
+//   [ x1, .. , xn ] + [ y1, .. , yn ] = [ x1 + y1, .. , xn + yn ].
+class HVecAdd : public HVecBinaryOperation {
+ public:
+  HVecAdd(ArenaAllocator* arena,
+          HInstruction* left,
+          HInstruction* right,
+          Primitive::Type packed_type,
+          size_t vector_length,
+          uint32_t dex_pc = kNoDexPc)
+      : HVecBinaryOperation(arena, left, right, packed_type, vector_length, dex_pc) {}
+
+  DECLARE_INSTRUCTION(VecAdd);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecAdd);
+};
+
+// Subtracts lanes, wrapping around on overflow for integral types:
+//   [ x1, .. , xn ] - [ y1, .. , yn ] = [ x1 - y1, .. , xn - yn ].
+class HVecSub : public HVecBinaryOperation {
+ public:
+  HVecSub(ArenaAllocator* arena,
+          HInstruction* left,
+          HInstruction* right,
+          Primitive::Type packed_type,
+          size_t vector_length,
+          uint32_t dex_pc = kNoDexPc)
+      : HVecBinaryOperation(arena, left, right, packed_type, vector_length, dex_pc) {}
+
+  DECLARE_INSTRUCTION(VecSub);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecSub);
+};
+
+// Multiplies lanes, keeping the low bits of the products for integral types:
+//   [ x1, .. , xn ] * [ y1, .. , yn ] = [ x1 * y1, .. , xn * yn ].
+class HVecMul : public HVecBinaryOperation {
+ public:
+  HVecMul(ArenaAllocator* arena,
+          HInstruction* left,
+          HInstruction* right,
+          Primitive::Type packed_type,
+          size_t vector_length,
+          uint32_t dex_pc = kNoDexPc)
+      : HVecBinaryOperation(arena, left, right, packed_type, vector_length, dex_pc) {
+    DCHECK(packed_type != Primitive::kPrimByte && packed_type != Primitive::kPrimLong);
+  }
+
+  DECLARE_INSTRUCTION(VecMul);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecMul);
+};
+
+// Bitwise-ands lanes:
+//   [ x1, .. , xn ] & [ y1, .. , yn ] = [ x1 & y1, .. , xn & yn ].
+class HVecAnd : public HVecBinaryOperation {
+ public:
+  HVecAnd(ArenaAllocator* arena,
+          HInstruction* left,
+          HInstruction* right,
+          Primitive::Type packed_type,
+          size_t vector_length,
+          uint32_t dex_pc = kNoDexPc)
+      : HVecBinaryOperation(arena, left, right, packed_type, vector_length, dex_pc) {}
+
+  DECLARE_INSTRUCTION(VecAnd);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecAnd);
+};
+
+// Bitwise-ors lanes:
+//   [ x1, .. , xn ] | [ y1, .. , yn ] = [ x1 | y1, .. , xn | yn ].
+class HVecOr : public HVecBinaryOperation {
+ public:
+  HVecOr(ArenaAllocator* arena,
+         HInstruction* left,
+         HInstruction* right,
+         Primitive::Type packed_type,
+         size_t vector_length,
+         uint32_t dex_pc = kNoDexPc)
+      : HVecBinaryOperation(arena, left, right, packed_type, vector_length, dex_pc) {}
+
+  DECLARE_INSTRUCTION(VecOr);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecOr);
+};
+
+// Bitwise-xors lanes:
+//   [ x1, .. , xn ] ^ [ y1, .. , yn ] = [ x1 ^ y1, .. , xn ^ yn ].
+class HVecXor : public HVecBinaryOperation {
+ public:
+  HVecXor(ArenaAllocator* arena,
+          HInstruction* left,
+          HInstruction* right,
+          Primitive::Type packed_type,
+          size_t vector_length,
+          uint32_t dex_pc = kNoDexPc)
+      : HVecBinaryOperation(arena, left, right, packed_type, vector_length, dex_pc) {}
+
+  DECLARE_INSTRUCTION(VecXor);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecXor);
+};
+
+// Loads consecutive array elements into a vector:
+//   load(base, index) = [ base[index], .. , base[index + n - 1] ].
+class HVecLoad : public HVecMemoryOperation {
+ public:
+  HVecLoad(ArenaAllocator* arena,
+           HInstruction* base,
+           HInstruction* index,
+           Primitive::Type packed_type,
+           size_t vector_length,
+           uint32_t dex_pc = kNoDexPc)
+      : HVecMemoryOperation(arena,
+                            packed_type,
+                            SideEffects::ArrayReadOfType(packed_type),
+                            /* number_of_inputs */ 2,
+                            vector_length,
+                            dex_pc) {
+    SetRawInputAt(0, base);
+    SetRawInputAt(1, index);
+  }
+
+  DECLARE_INSTRUCTION(VecLoad);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecLoad);
+};
+
+// Stores the lanes of a vector into consecutive array elements:
+//   base[index], .. , base[index + n - 1] = [ x1, .. , xn ].
+class HVecStore : public HVecMemoryOperation {
+ public:
+  HVecStore(ArenaAllocator* arena,
+            HInstruction* base,
+            HInstruction* index,
+            HInstruction* value,
+            Primitive::Type packed_type,
+            size_t vector_length,
+            uint32_t dex_pc = kNoDexPc)
+      : HVecMemoryOperation(arena,
+                            packed_type,
+                            SideEffects::ArrayWriteOfType(packed_type),
+                            /* number_of_inputs */ 3,
+                            vector_length,
+                            dex_pc) {
+    SetRawInputAt(0, base);
+    SetRawInputAt(1, index);
+    SetRawInputAt(2, value);
+  }
+
+  HInstruction* GetValue() const { return InputAt(2); }
+
+  Primitive::Type GetType() const OVERRIDE { return Primitive::kPrimVoid; }
+
+  DECLARE_INSTRUCTION(VecStore);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HVecStore);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_NODES_VECTOR_H_
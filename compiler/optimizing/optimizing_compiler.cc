@@ -65,14 +65,18 @@
 #include "jit/debugger_interface.h"
 #include "jit/jit.h"
 #include "jit/jit_code_cache.h"
+#include "jit/profiling_info.h"
 #include "jni/quick/jni_compiler.h"
 #include "licm.h"
+#include "loop_optimization.h"
 #include "load_store_elimination.h"
 #include "nodes.h"
 #include "oat_quick_method_header.h"
+#include "partial_escape_analysis.h"
 #include "prepare_for_register_allocation.h"
 #include "reference_type_propagation.h"
 #include "register_allocator.h"
+#include "scheduler.h"
 #include "select_generator.h"
 #include "sharpening.h"
 #include "side_effects_analysis.h"
@@ -86,6 +90,10 @@ namespace art {
 
 static constexpr size_t kArenaAllocatorMemoryReportThreshold = 8 * MB;
 
+// Number of deoptimizations of the compiled code of a method after which the
+// JIT compiles it without speculating on its profile.
+static constexpr uint16_t kMaximumDeoptimizationsForSpeculation = 8;
+
 /**
  * Used by the code generator, to allocate the code in a vector.
  */
@@ -292,7 +300,11 @@ class OptimizingCompiler FINAL : public Compiler {
     }
   }
 
-  bool JitCompile(Thread* self, jit::JitCodeCache* code_cache, ArtMethod* method, bool osr)
+  bool JitCompile(Thread* self,
+                  jit::JitCodeCache* code_cache,
+                  ArtMethod* method,
+                  bool baseline,
+                  bool osr)
       OVERRIDE
       SHARED_REQUIRES(Locks::mutator_lock_);
 
@@ -309,7 +321,9 @@ class OptimizingCompiler FINAL : public Compiler {
   // This method:
   // 1) Builds the graph. Returns null if it failed to build it.
   // 2) Transforms the graph to SSA. Returns null if it failed.
-  // 3) Runs optimizations on the graph, including register allocator.
+  // 3) Runs optimizations on the graph, including register allocator. When
+  //    compiling for the `baseline` JIT tier, only the passes the code generators
+  //    rely on are run.
   // 4) Generates code with the `code_allocator` provided.
   CodeGenerator* TryCompile(ArenaAllocator* arena,
                             CodeVectorAllocator* code_allocator,
@@ -322,6 +336,7 @@ class OptimizingCompiler FINAL : public Compiler {
                             const DexFile& dex_file,
                             Handle<mirror::DexCache> dex_cache,
                             ArtMethod* method,
+                            bool baseline,
                             bool osr) const;
 
   std::unique_ptr<OptimizingCompilerStats> compilation_stats_;
@@ -478,10 +493,61 @@ static void RunArchOptimizations(InstructionSet instruction_set,
   }
 }
 
+// Graph coloring produces fewer spills and moves than linear scan, but takes
+// longer to run. Unless told otherwise, only use it ahead of time, for the
+// compiler filters that favor code quality over compile time.
+static RegisterAllocator::Strategy GetRegisterAllocationStrategy(CompilerDriver* driver) {
+  const CompilerOptions& compiler_options = driver->GetCompilerOptions();
+  if (compiler_options.HasRegisterAllocationStrategy()) {
+    return compiler_options.GetRegisterAllocationStrategy();
+  }
+  if (Runtime::Current()->UseJitCompilation()) {
+    return RegisterAllocator::kRegisterAllocatorLinearScan;
+  }
+  switch (compiler_options.GetCompilerFilter()) {
+    case CompilerFilter::kSpeedProfile:
+    case CompilerFilter::kSpeed:
+    case CompilerFilter::kEverythingProfile:
+    case CompilerFilter::kEverything:
+      return RegisterAllocator::kRegisterAllocatorGraphColor;
+    default:
+      return RegisterAllocator::kRegisterAllocatorLinearScan;
+  }
+}
+
+static void RecordRegisterAllocationStats(HGraph* graph,
+                                          const SsaLivenessAnalysis& liveness,
+                                          OptimizingCompilerStats* stats) {
+  size_t spilled_values = 0;
+  for (size_t i = 0, e = liveness.GetNumberOfSsaValues(); i < e; ++i) {
+    HInstruction* instruction = liveness.GetInstructionFromSsaIndex(i);
+    // Parameters and the current method live in the caller's frame anyway.
+    if (instruction->GetLiveInterval()->HasSpillSlot() &&
+        !instruction->IsParameterValue() &&
+        !instruction->IsCurrentMethod()) {
+      ++spilled_values;
+    }
+  }
+  size_t inserted_moves = 0;
+  for (HReversePostOrderIterator it(*graph); !it.Done(); it.Advance()) {
+    for (HInstructionIterator inst_it(it.Current()->GetInstructions());
+         !inst_it.Done();
+         inst_it.Advance()) {
+      if (inst_it.Current()->IsParallelMove()) {
+        inserted_moves += inst_it.Current()->AsParallelMove()->NumMoves();
+      }
+    }
+  }
+  stats->RecordStat(MethodCompilationStat::kSpilledValue, spilled_values);
+  stats->RecordStat(MethodCompilationStat::kInsertedMove, inserted_moves);
+}
+
 NO_INLINE  // Avoid increasing caller's frame size by large stack-allocated objects.
 static void AllocateRegisters(HGraph* graph,
                               CodeGenerator* codegen,
-                              PassObserver* pass_observer) {
+                              PassObserver* pass_observer,
+                              RegisterAllocator::Strategy strategy,
+                              OptimizingCompilerStats* stats) {
   {
     PassScope scope(PrepareForRegisterAllocation::kPrepareForRegisterAllocationPassName,
                     pass_observer);
@@ -494,7 +560,10 @@ static void AllocateRegisters(HGraph* graph,
   }
   {
     PassScope scope(RegisterAllocator::kRegisterAllocatorPassName, pass_observer);
-    RegisterAllocator(graph->GetArena(), codegen, liveness).AllocateRegisters();
+    RegisterAllocator::Create(graph->GetArena(), codegen, liveness, strategy)->AllocateRegisters();
+  }
+  if (stats != nullptr) {
+    RecordRegisterAllocationStats(graph, liveness, stats);
   }
 }
 
@@ -515,12 +584,18 @@ static void RunOptimizations(HGraph* graph,
   HSelectGenerator* select_generator = new (arena) HSelectGenerator(graph, stats);
   HConstantFolding* fold2 = new (arena) HConstantFolding(graph, "constant_folding_after_inlining");
   HConstantFolding* fold3 = new (arena) HConstantFolding(graph, "constant_folding_after_bce");
+  PartialEscapeAnalysis* escape = new (arena) PartialEscapeAnalysis(graph, stats);
   SideEffectsAnalysis* side_effects = new (arena) SideEffectsAnalysis(graph);
   GVNOptimization* gvn = new (arena) GVNOptimization(graph, *side_effects);
   LICM* licm = new (arena) LICM(graph, *side_effects, stats);
   LoadStoreElimination* lse = new (arena) LoadStoreElimination(graph, *side_effects);
   HInductionVarAnalysis* induction = new (arena) HInductionVarAnalysis(graph);
   BoundsCheckElimination* bce = new (arena) BoundsCheckElimination(graph, *side_effects, induction);
+  // LSE and escape analysis change the loops after bce, the loop optimization needs induction
+  // results of its own.
+  HInductionVarAnalysis* induction2 = new (arena) HInductionVarAnalysis(
+      graph, "induction_var_analysis_after_lse");
+  HLoopOptimization* loop = new (arena) HLoopOptimization(graph, driver, induction2, stats);
   HSharpening* sharpening = new (arena) HSharpening(graph, codegen, dex_compilation_unit, driver);
   InstructionSimplifier* simplify2 = new (arena) InstructionSimplifier(
       graph, stats, "instruction_simplifier_after_bce");
@@ -552,6 +627,9 @@ static void RunOptimizations(HGraph* graph,
     fold3,  // evaluates code generated by dynamic bce
     simplify2,
     lse,
+    escape,  // replaces the allocations lse could not remove
+    induction2,
+    loop,  // unrolls, vectorizes and peels the loops left by bce
     dce2,
     // The codegen has a few assumptions that only the instruction simplifier
     // can satisfy. For example, the code generator does not expect to see a
@@ -561,7 +639,49 @@ static void RunOptimizations(HGraph* graph,
   RunOptimizations(optimizations2, arraysize(optimizations2), pass_observer);
 
   RunArchOptimizations(driver->GetInstructionSet(), graph, codegen, stats, pass_observer);
-  AllocateRegisters(graph, codegen, pass_observer);
+
+  // Scheduling comes last, to see the instructions the code generator will emit.
+  HInstructionScheduling* scheduling = new (arena) HInstructionScheduling(
+      graph, driver->GetInstructionSet(), driver->GetInstructionSetFeatures(), stats);
+  HOptimization* scheduling_optimizations[] = {
+    scheduling
+  };
+  RunOptimizations(scheduling_optimizations, arraysize(scheduling_optimizations), pass_observer);
+
+  AllocateRegisters(graph,
+                    codegen,
+                    pass_observer,
+                    GetRegisterAllocationStrategy(driver),
+                    stats);
+}
+
+// The pipeline of the baseline JIT tier: no inlining and none of the optional
+// optimizations, only what the code generators need to produce good enough code.
+static void RunBaselineOptimizations(HGraph* graph,
+                                     CodeGenerator* codegen,
+                                     CompilerDriver* driver,
+                                     OptimizingCompilerStats* stats,
+                                     const DexCompilationUnit& dex_compilation_unit,
+                                     PassObserver* pass_observer) {
+  ArenaAllocator* arena = graph->GetArena();
+  IntrinsicsRecognizer* intrinsics = new (arena) IntrinsicsRecognizer(graph, driver, stats);
+  HSharpening* sharpening = new (arena) HSharpening(graph, codegen, dex_compilation_unit, driver);
+  InstructionSimplifier* simplify = new (arena) InstructionSimplifier(
+      graph, stats, "instruction_simplifier_before_codegen");
+
+  HOptimization* optimizations[] = {
+    intrinsics,
+    sharpening,
+    simplify,
+  };
+  RunOptimizations(optimizations, arraysize(optimizations), pass_observer);
+
+  RunArchOptimizations(driver->GetInstructionSet(), graph, codegen, stats, pass_observer);
+  AllocateRegisters(graph,
+                    codegen,
+                    pass_observer,
+                    GetRegisterAllocationStrategy(driver),
+                    stats);
 }
 
 static ArenaVector<LinkerPatch> EmitAndSortLinkerPatches(CodeGenerator* codegen) {
@@ -616,6 +736,7 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* arena,
                                               const DexFile& dex_file,
                                               Handle<mirror::DexCache> dex_cache,
                                               ArtMethod* method,
+                                              bool baseline,
                                               bool osr) const {
   MaybeRecordStat(MethodCompilationStat::kAttemptCompilation);
   CompilerDriver* compiler_driver = GetCompilerDriver();
@@ -678,7 +799,8 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* arena,
       compiler_driver->GetInstructionSet(),
       kInvalidInvokeType,
       compiler_driver->GetCompilerOptions().GetDebuggable(),
-      osr);
+      osr,
+      baseline);
 
   const uint8_t* interpreter_metadata = nullptr;
   if (method == nullptr) {
@@ -706,6 +828,41 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* arena,
     if (dex_cache->GetResolvedType(type_index) == nullptr) {
       dex_cache->SetResolvedType(type_index, method->GetDeclaringClass());
     }
+
+    // Stop speculating once the compiled code of the method keeps deoptimizing:
+    // the profile has proven to be a poor predictor for it.
+    if (Runtime::Current()->UseJitCompilation() && graph->IsSpeculationAllowed()) {
+      jit::JitCodeCache* code_cache = Runtime::Current()->GetJit()->GetCodeCache();
+      ProfilingInfo* info = code_cache->NotifyCompilerUse(method, soa.Self());
+      if (info != nullptr) {
+        if (info->GetDeoptimizationCount() >= kMaximumDeoptimizationsForSpeculation) {
+          graph->SetSpeculationAllowed(false);
+          MaybeRecordStat(MethodCompilationStat::kNotSpeculatingAfterDeoptimizations);
+        }
+        code_cache->DoneCompilerUse(method, soa.Self());
+      }
+    }
+
+    // Only the loops which got hot are OSR entries, the other loops of the method
+    // stay reducible and get fully optimized. The loop optimizations unroll the
+    // loops which ran since the method got hot more aggressively.
+    if (Runtime::Current()->UseJitCompilation()) {
+      jit::JitCodeCache* code_cache = Runtime::Current()->GetJit()->GetCodeCache();
+      ProfilingInfo* info = code_cache->NotifyCompilerUse(method, soa.Self());
+      if (info != nullptr) {
+        graph->SetHasLoopProfile(info->GetNumberOfLoopCaches() != 0);
+        for (size_t i = 0; i < info->GetNumberOfLoopCaches(); ++i) {
+          const LoopCache& loop = info->GetLoopCacheAt(i);
+          if (loop.IsHot() && osr) {
+            graph->AddOsrLoopHeader(loop.GetDexPc());
+          }
+          if (loop.IsHot() || loop.GetBackEdgeCount() != 0) {
+            graph->AddHotLoopHeader(loop.GetDexPc());
+          }
+        }
+        code_cache->DoneCompilerUse(method, soa.Self());
+      }
+    }
   }
 
   std::unique_ptr<CodeGenerator> codegen(
@@ -769,13 +926,22 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* arena,
       }
     }
 
-    RunOptimizations(graph,
-                     codegen.get(),
-                     compiler_driver,
-                     compilation_stats_.get(),
-                     dex_compilation_unit,
-                     &pass_observer,
-                     &handles);
+    if (baseline) {
+      RunBaselineOptimizations(graph,
+                               codegen.get(),
+                               compiler_driver,
+                               compilation_stats_.get(),
+                               dex_compilation_unit,
+                               &pass_observer);
+    } else {
+      RunOptimizations(graph,
+                       codegen.get(),
+                       compiler_driver,
+                       compilation_stats_.get(),
+                       dex_compilation_unit,
+                       &pass_observer,
+                       &handles);
+    }
 
     codegen->Compile(code_allocator);
     pass_observer.DumpDisassembly();
@@ -814,6 +980,7 @@ CompiledMethod* OptimizingCompiler::Compile(const DexFile::CodeItem* code_item,
                    dex_file,
                    dex_cache,
                    nullptr,
+                   /* baseline */ false,
                    /* osr */ false));
     if (codegen.get() != nullptr) {
       MaybeRecordStat(MethodCompilationStat::kCompiled);
@@ -868,6 +1035,7 @@ bool IsCompilingWithCoreImage() {
 bool OptimizingCompiler::JitCompile(Thread* self,
                                     jit::JitCodeCache* code_cache,
                                     ArtMethod* method,
+                                    bool baseline,
                                     bool osr) {
   StackHandleScope<2> hs(self);
   Handle<mirror::ClassLoader> class_loader(hs.NewHandle(
@@ -901,6 +1069,7 @@ bool OptimizingCompiler::JitCompile(Thread* self,
                    *dex_file,
                    dex_cache,
                    method,
+                   baseline,
                    osr));
     if (codegen.get() == nullptr) {
       return false;
@@ -930,7 +1099,9 @@ bool OptimizingCompiler::JitCompile(Thread* self,
       codegen->GetFpuSpillMask(),
       code_allocator.GetMemory().data(),
       code_allocator.GetSize(),
-      osr);
+      baseline,
+      osr,
+      codegen->GetGraph()->GetChaSingleImplementationList());
 
   if (code == nullptr) {
     code_cache->ClearData(self, stack_map_data);
@@ -54,6 +54,8 @@ enum MethodCompilationStat {
   kNotCompiledVerifyAtRuntime,
   kInlinedMonomorphicCall,
   kInlinedPolymorphicCall,
+  kInlinedMegamorphicCall,
+  kInlinedSingleImplementation,
   kMonomorphicCall,
   kPolymorphicCall,
   kMegamorphicCall,
@@ -65,6 +67,18 @@ enum MethodCompilationStat {
   kInlinedInvokeVirtualOrInterface,
   kImplicitNullCheckGenerated,
   kExplicitNullCheckGenerated,
+  kSpeculatedBranch,
+  kNotSpeculatingAfterDeoptimizations,
+  kVectorizedLoop,
+  kFullyUnrolledLoop,
+  kPartiallyUnrolledLoop,
+  kPeeledLoop,
+  kScalarReplacedAllocation,
+  kMaterializedAllocation,
+  kRemovedMonitorOperation,
+  kSpilledValue,
+  kInsertedMove,
+  kScheduledRegion,
   kLastStat
 };
 
@@ -132,6 +146,8 @@ class OptimizingCompilerStats {
       case kNotCompiledVerifyAtRuntime : name = "NotCompiledVerifyAtRuntime"; break;
       case kInlinedMonomorphicCall: name = "InlinedMonomorphicCall"; break;
       case kInlinedPolymorphicCall: name = "InlinedPolymorphicCall"; break;
+      case kInlinedMegamorphicCall: name = "InlinedMegamorphicCall"; break;
+      case kInlinedSingleImplementation: name = "InlinedSingleImplementation"; break;
       case kMonomorphicCall: name = "MonomorphicCall"; break;
       case kPolymorphicCall: name = "PolymorphicCall"; break;
       case kMegamorphicCall: name = "MegamorphicCall"; break;
@@ -143,6 +159,20 @@ class OptimizingCompilerStats {
       case kInlinedInvokeVirtualOrInterface: name = "InlinedInvokeVirtualOrInterface"; break;
       case kImplicitNullCheckGenerated: name = "ImplicitNullCheckGenerated"; break;
       case kExplicitNullCheckGenerated: name = "ExplicitNullCheckGenerated"; break;
+      case kSpeculatedBranch: name = "SpeculatedBranch"; break;
+      case kNotSpeculatingAfterDeoptimizations:
+        name = "NotSpeculatingAfterDeoptimizations";
+        break;
+      case kVectorizedLoop: name = "VectorizedLoop"; break;
+      case kFullyUnrolledLoop: name = "FullyUnrolledLoop"; break;
+      case kPartiallyUnrolledLoop: name = "PartiallyUnrolledLoop"; break;
+      case kPeeledLoop: name = "PeeledLoop"; break;
+      case kScalarReplacedAllocation: name = "ScalarReplacedAllocation"; break;
+      case kMaterializedAllocation: name = "MaterializedAllocation"; break;
+      case kRemovedMonitorOperation: name = "RemovedMonitorOperation"; break;
+      case kSpilledValue: name = "SpilledValue"; break;
+      case kInsertedMove: name = "InsertedMove"; break;
+      case kScheduledRegion: name = "ScheduledRegion"; break;
 
       case kLastStat:
         LOG(FATAL) << "invalid stat "
@@ -47,8 +47,12 @@ void ParallelMoveResolverWithSwap::EmitNativeCode(HParallelMove* parallel_move)
       continue;
     }
 
-    if ((move.GetSource().IsStackSlot() || move.GetSource().IsDoubleStackSlot()) &&
-        (move.GetDestination().IsStackSlot() || move.GetDestination().IsDoubleStackSlot())) {
+    if ((move.GetSource().IsStackSlot() ||
+         move.GetSource().IsDoubleStackSlot() ||
+         move.GetSource().IsSIMDStackSlot()) &&
+        (move.GetDestination().IsStackSlot() ||
+         move.GetDestination().IsDoubleStackSlot() ||
+         move.GetDestination().IsSIMDStackSlot())) {
       PerformMove(i);
     }
   }
@@ -326,7 +330,10 @@ void ParallelMoveResolverNoSwap::EmitNativeCode(HParallelMove* parallel_move) {
   for (size_t i = 0; i < moves_.size(); ++i) {
     MoveOperands* move = moves_[i];
     Location destination = move->GetDestination();
-    if (!move->IsEliminated() && !destination.IsStackSlot() && !destination.IsDoubleStackSlot()) {
+    if (!move->IsEliminated() &&
+        !destination.IsStackSlot() &&
+        !destination.IsDoubleStackSlot() &&
+        !destination.IsSIMDStackSlot()) {
       Location source = move->GetSource();
       EmitMove(i);
       move->Eliminate();
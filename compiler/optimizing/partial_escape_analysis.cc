@@ -0,0 +1,871 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "partial_escape_analysis.h"
+
+#include "art_field-inl.h"
+#include "base/arena_bit_vector.h"
+#include "base/arena_containers.h"
+#include "mirror/dex_cache-inl.h"
+#include "mirror/object.h"
+#include "scoped_thread_state_change.h"
+
+namespace art {
+
+// Maximum number of elements of the arrays that are scalar replaced.
+static constexpr int32_t kMaxArrayLength = 8;
+
+// Maximum number of fields or elements of an allocation that are scalar replaced.
+static constexpr size_t kMaxNumberOfSlots = 16;
+
+static HInstruction* GetDefaultValue(HGraph* graph, Primitive::Type type) {
+  switch (Primitive::PrimitiveKind(type)) {
+    case Primitive::kPrimNot:
+      return graph->GetNullConstant();
+    case Primitive::kPrimInt:
+      return graph->GetIntConstant(0);
+    case Primitive::kPrimLong:
+      return graph->GetLongConstant(0);
+    case Primitive::kPrimFloat:
+      return graph->GetFloatConstant(0);
+    case Primitive::kPrimDouble:
+      return graph->GetDoubleConstant(0);
+    default:
+      LOG(FATAL) << "Unexpected type " << type;
+      UNREACHABLE();
+  }
+}
+
+// Returns whether the field is final, or may be.
+static bool MayBeFinal(const FieldInfo& field_info, size_t pointer_size) {
+  ScopedObjectAccess soa(Thread::Current());
+  Handle<mirror::DexCache> dex_cache = field_info.GetDexCache();
+  if (dex_cache.Get() == nullptr) {
+    return true;
+  }
+  ArtField* field = dex_cache->GetResolvedField(field_info.GetFieldIndex(), pointer_size);
+  return field == nullptr || field->IsFinal();
+}
+
+// Returns whether the allocation can be removed without changing the behavior of the
+// method, other than not throwing OutOfMemoryError: the class is resolved, accessible
+// and initialized, and has no finalizer.
+static bool IsCandidate(HInstruction* instruction) {
+  if (instruction->IsNewInstance()) {
+    HNewInstance* new_instance = instruction->AsNewInstance();
+    return new_instance->GetEntrypoint() == kQuickAllocObjectInitialized &&
+        !new_instance->IsFinalizable() &&
+        !new_instance->IsStringAlloc();
+  } else if (instruction->IsNewArray()) {
+    HNewArray* new_array = instruction->AsNewArray();
+    HInstruction* length = new_array->InputAt(0);
+    return new_array->GetEntrypoint() == kQuickAllocArray &&
+        length->IsIntConstant() &&
+        length->AsIntConstant()->GetValue() >= 0 &&
+        length->AsIntConstant()->GetValue() <= kMaxArrayLength;
+  }
+  return false;
+}
+
+// Scalar replacement of one allocation.
+class AllocationReplacer : public ValueObject {
+ public:
+  AllocationReplacer(HGraph* graph, HInstruction* allocation)
+      : graph_(graph),
+        allocation_(allocation),
+        slot_keys_(graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+        slot_types_(graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+        slot_fields_(graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+        slot_of_access_(std::less<HInstruction*>(),
+                        graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+        monitor_operations_(graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+        null_checks_(graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+        deoptimizations_(graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+        deoptimization_values_(graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+        escapes_(graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+        phi_escapes_(graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+        materialization_points_(std::less<HBasicBlock*>(),
+                                graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+        block_values_(graph->GetBlocks().size(),
+                      ArenaVector<HInstruction*>(
+                          graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+                      graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+        loop_phis_(graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+        created_phis_(graph->GetArena()->Adapter(kArenaAllocEscapeAnalysis)),
+        needs_constructor_barrier_(false),
+        number_of_materializations_(0) {}
+
+  // Returns whether the allocation can be scalar replaced, classifying its uses.
+  bool Analyze();
+
+  // Replaces the accesses to the allocation by SSA values, materializes the
+  // allocation where it escapes, and removes it.
+  void Replace();
+
+  // Whether Replace() added blocks, after which the dominance and loop information
+  // must be recomputed.
+  bool HasAddedBlocks() const { return !deoptimizations_.empty(); }
+
+  size_t GetNumberOfMaterializations() const { return number_of_materializations_; }
+  size_t GetNumberOfMonitorOperations() const { return monitor_operations_.size(); }
+
+ private:
+  bool IsArray() const { return allocation_->IsNewArray(); }
+
+  int32_t GetArrayLength() const {
+    DCHECK(IsArray());
+    return allocation_->InputAt(0)->AsIntConstant()->GetValue();
+  }
+
+  // Returns the element index accessed by `access`, an array get or set on the
+  // allocation, or -1 if it is not a constant in the bounds of the array.
+  int32_t GetConstantIndex(HInstruction* access) const;
+
+  // Records that `access` reads or writes the slot with key `key`, a field offset
+  // or an element index, of type `type`. Returns false if the slot is accessed
+  // with different types or there are too many slots.
+  bool AddAccess(HInstruction* access,
+                 size_t key,
+                 Primitive::Type type,
+                 const FieldInfo* field_info);
+
+  // Classifies the use of the allocation, or of one of its null checks, by `user` at
+  // input `index`. Returns false if the allocation cannot be scalar replaced.
+  bool AddUse(HInstruction* user, size_t index);
+
+  void AddEscape(HInstruction* user);
+  void AddPhiEscape(HPhi* phi, size_t index);
+
+  // Records the deoptimizations whose environment holds `instruction`.
+  void AddDeoptimizations(HInstruction* instruction);
+
+  // Returns whether the direct accesses to the allocation and its materialization
+  // points are never reachable from a materialization point.
+  bool MaterializesOncePerPath();
+
+  // Returns whether a field or element is accessed in a catch block or in a block
+  // reachable from one.
+  bool IsAccessedAfterCatch() const;
+
+  // Marks the blocks reachable from `block` in `visited`, stopping at the block of
+  // the allocation, where a new object is allocated.
+  void VisitSuccessors(HBasicBlock* block, ArenaBitVector* visited) const;
+
+  // Returns the values of the slots when entering `block`.
+  void MergePredecessorValues(HBasicBlock* block, ArenaVector<HInstruction*>* values);
+  HPhi* CreatePhi(HBasicBlock* block, size_t slot);
+
+  // Returns the environment of `cursor`, or else of the closest instruction before it
+  // that has one.
+  HEnvironment* FindEnvironment(HInstruction* cursor) const;
+
+  // Allocates and initializes a copy of the allocation before `cursor`.
+  HInstruction* Materialize(HInstruction* cursor, const ArenaVector<HInstruction*>& values);
+
+  // Moves `deoptimize` to a block of its own, only entered when it deoptimizes, where
+  // the object is materialized for the interpreter.
+  void MaterializeForDeoptimization(HInstruction* deoptimize,
+                                    const ArenaVector<HInstruction*>& values);
+
+  // Replaces the allocation by `materialized` in its escaping uses in `block`.
+  void ReplaceEscapes(HBasicBlock* block, HInstruction* materialized);
+
+  void RemovePhis();
+
+  HGraph* const graph_;
+  HInstruction* const allocation_;
+
+  // Field offsets or element indices of the accessed slots, with their types and,
+  // for fields, the field of the first access.
+  ArenaVector<size_t> slot_keys_;
+  ArenaVector<Primitive::Type> slot_types_;
+  ArenaVector<const FieldInfo*> slot_fields_;
+
+  // Slot of each direct access, field get or set, array get or set.
+  ArenaSafeMap<HInstruction*, size_t> slot_of_access_;
+
+  ArenaVector<HInstruction*> monitor_operations_;
+
+  // Null checks of the allocation, removed with it.
+  ArenaVector<HInstruction*> null_checks_;
+
+  // Deoptimizations whose environment holds the allocation, and the values of the
+  // slots there.
+  ArenaVector<HInstruction*> deoptimizations_;
+  ArenaVector<std::pair<HInstruction*, ArenaVector<HInstruction*>>> deoptimization_values_;
+
+  // Uses where the allocation escapes: instructions, which need the object before
+  // them, and phi inputs, which need it at the end of the corresponding predecessor.
+  ArenaVector<HInstruction*> escapes_;
+  ArenaVector<std::pair<HPhi*, size_t>> phi_escapes_;
+
+  // First escaping use in each block with one, before which the object is
+  // materialized.
+  ArenaSafeMap<HBasicBlock*, HInstruction*> materialization_points_;
+
+  // Values of the slots at the end of each block, by block id.
+  ArenaVector<ArenaVector<HInstruction*>> block_values_;
+
+  // Loop header phis, whose back edge inputs are set once the loop is processed.
+  ArenaVector<std::pair<HPhi*, size_t>> loop_phis_;
+  ArenaVector<HPhi*> created_phis_;
+
+  // Whether a final field is stored to the materialized objects, which must then be
+  // published safely like after their constructor.
+  bool needs_constructor_barrier_;
+
+  size_t number_of_materializations_;
+
+  DISALLOW_COPY_AND_ASSIGN(AllocationReplacer);
+};
+
+int32_t AllocationReplacer::GetConstantIndex(HInstruction* access) const {
+  HInstruction* index = access->InputAt(1);
+  if (index->IsBoundsCheck()) {
+    index = index->InputAt(0);
+  }
+  if (!index->IsIntConstant()) {
+    return -1;
+  }
+  int32_t value = index->AsIntConstant()->GetValue();
+  return (value >= 0 && value < GetArrayLength()) ? value : -1;
+}
+
+bool AllocationReplacer::AddAccess(HInstruction* access,
+                                   size_t key,
+                                   Primitive::Type type,
+                                   const FieldInfo* field_info) {
+  size_t slot = 0;
+  while (slot < slot_keys_.size() && slot_keys_[slot] != key) {
+    ++slot;
+  }
+  if (slot == slot_keys_.size()) {
+    if (slot == kMaxNumberOfSlots) {
+      return false;
+    }
+    slot_keys_.push_back(key);
+    slot_types_.push_back(type);
+    slot_fields_.push_back(field_info);
+  } else if (Primitive::PrimitiveKind(slot_types_[slot]) != Primitive::PrimitiveKind(type)) {
+    // The same element read as an int and as a float, or a field through
+    // different class definitions.
+    return false;
+  }
+  slot_of_access_.Put(access, slot);
+  return true;
+}
+
+void AllocationReplacer::AddEscape(HInstruction* user) {
+  if (std::find(escapes_.begin(), escapes_.end(), user) == escapes_.end()) {
+    escapes_.push_back(user);
+  }
+}
+
+void AllocationReplacer::AddPhiEscape(HPhi* phi, size_t index) {
+  phi_escapes_.push_back(std::make_pair(phi, index));
+}
+
+void AllocationReplacer::AddDeoptimizations(HInstruction* instruction) {
+  for (const HUseListNode<HEnvironment*>& use : instruction->GetEnvUses()) {
+    HInstruction* holder = use.GetUser()->GetHolder();
+    if (holder->IsDeoptimize() &&
+        std::find(deoptimizations_.begin(), deoptimizations_.end(), holder) ==
+            deoptimizations_.end()) {
+      deoptimizations_.push_back(holder);
+    }
+  }
+}
+
+bool AllocationReplacer::AddUse(HInstruction* user, size_t index) {
+  if (user->IsNullCheck()) {
+    // Null checks of an allocation are redundant; the instruction simplifier has not
+    // seen those of the inlined code yet. Their uses are uses of the allocation.
+    null_checks_.push_back(user);
+    AddDeoptimizations(user);
+    for (const HUseListNode<HInstruction*>& use : user->GetUses()) {
+      if (!AddUse(use.GetUser(), use.GetIndex())) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (user->IsPhi()) {
+    AddPhiEscape(user->AsPhi(), index);
+    return true;
+  }
+  if (index == 0 && user->IsInstanceFieldGet()) {
+    const FieldInfo& field_info = user->AsInstanceFieldGet()->GetFieldInfo();
+    size_t offset = field_info.GetFieldOffset().SizeValue();
+    // The object header is only set by the allocation.
+    if (!field_info.IsVolatile() && offset >= mirror::kObjectHeaderSize) {
+      return AddAccess(user, offset, field_info.GetFieldType(), &field_info);
+    }
+  } else if (index == 0 && user->IsInstanceFieldSet()) {
+    const FieldInfo& field_info = user->AsInstanceFieldSet()->GetFieldInfo();
+    size_t offset = field_info.GetFieldOffset().SizeValue();
+    if (!field_info.IsVolatile() && offset >= mirror::kObjectHeaderSize) {
+      return AddAccess(user, offset, field_info.GetFieldType(), &field_info);
+    }
+  } else if (index == 0 && user->IsArrayGet()) {
+    int32_t element = GetConstantIndex(user);
+    if (element >= 0) {
+      return AddAccess(user, element, user->GetType(), nullptr);
+    }
+  } else if (index == 0 && user->IsArraySet()) {
+    int32_t element = GetConstantIndex(user);
+    // The elements of the replaced array are not type checked.
+    if (element >= 0 && !user->AsArraySet()->NeedsTypeCheck()) {
+      return AddAccess(user, element, user->AsArraySet()->GetComponentType(), nullptr);
+    }
+  } else if (user->IsArrayLength()) {
+    return true;
+  } else if (user->IsMonitorOperation()) {
+    monitor_operations_.push_back(user);
+    return true;
+  } else if (user->IsBoundType()) {
+    // Not worth materializing just for the type of the object.
+    return false;
+  }
+  AddEscape(user);
+  return true;
+}
+
+bool AllocationReplacer::Analyze() {
+  for (const HUseListNode<HInstruction*>& use : allocation_->GetUses()) {
+    if (!AddUse(use.GetUser(), use.GetIndex())) {
+      return false;
+    }
+  }
+  AddDeoptimizations(allocation_);
+
+  // Locking is only elided for objects that never escape. The catch handlers, which
+  // synchronized blocks always have, get their values from the throwing instructions,
+  // so objects only escaping there are not materialized, and are not accessed after
+  // a catch.
+  bool escapes = !escapes_.empty() || !phi_escapes_.empty();
+  if ((escapes || !deoptimizations_.empty()) &&
+      (!monitor_operations_.empty() || graph_->HasTryCatch())) {
+    return false;
+  }
+  if (graph_->HasTryCatch() && IsAccessedAfterCatch()) {
+    return false;
+  }
+
+  // Find the materialization points, which must not be in loops the allocation is
+  // not in, as the materialized object would be allocated at each iteration.
+  HBasicBlock* allocation_block = allocation_->GetBlock();
+  for (HInstruction* user : escapes_) {
+    materialization_points_.Overwrite(user->GetBlock(), nullptr);
+  }
+  for (const std::pair<HPhi*, size_t>& phi_escape : phi_escapes_) {
+    HBasicBlock* predecessor = phi_escape.first->GetBlock()->GetPredecessors()[phi_escape.second];
+    materialization_points_.Overwrite(predecessor, predecessor->GetLastInstruction());
+  }
+  // Not worth it for an object escaping on all paths, or never accessed directly.
+  if (materialization_points_.find(allocation_block) != materialization_points_.end() ||
+      (escapes && slot_of_access_.empty())) {
+    return false;
+  }
+  for (auto& entry : materialization_points_) {
+    HBasicBlock* block = entry.first;
+    for (HLoopInformationOutwardIterator it(*block); !it.Done(); it.Advance()) {
+      if (!it.Current()->Contains(*allocation_block)) {
+        return false;
+      }
+    }
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* instruction = it.Current();
+      if (std::find(escapes_.begin(), escapes_.end(), instruction) != escapes_.end()) {
+        entry.second = instruction;
+        break;
+      }
+    }
+    DCHECK(entry.second != nullptr);
+  }
+
+  return MaterializesOncePerPath();
+}
+
+void AllocationReplacer::VisitSuccessors(HBasicBlock* block, ArenaBitVector* visited) const {
+  for (HBasicBlock* successor : block->GetSuccessors()) {
+    if (successor != allocation_->GetBlock() && !visited->IsBitSet(successor->GetBlockId())) {
+      visited->SetBit(successor->GetBlockId());
+      VisitSuccessors(successor, visited);
+    }
+  }
+}
+
+bool AllocationReplacer::IsAccessedAfterCatch() const {
+  ArenaBitVector reachable(graph_->GetArena(),
+                           graph_->GetBlocks().size(),
+                           /* expandable */ false,
+                           kArenaAllocEscapeAnalysis);
+  for (HBasicBlock* block : graph_->GetBlocks()) {
+    if (block != nullptr && block->IsCatchBlock()) {
+      reachable.SetBit(block->GetBlockId());
+      VisitSuccessors(block, &reachable);
+    }
+  }
+  for (const auto& entry : slot_of_access_) {
+    if (reachable.IsBitSet(entry.first->GetBlock()->GetBlockId())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool AllocationReplacer::MaterializesOncePerPath() {
+  if (materialization_points_.empty()) {
+    return true;
+  }
+  ArenaBitVector reachable(graph_->GetArena(),
+                           graph_->GetBlocks().size(),
+                           /* expandable */ false,
+                           kArenaAllocEscapeAnalysis);
+  for (const auto& entry : materialization_points_) {
+    VisitSuccessors(entry.first, &reachable);
+  }
+  for (const auto& entry : materialization_points_) {
+    if (reachable.IsBitSet(entry.first->GetBlockId())) {
+      return false;
+    }
+  }
+  // The deoptimizations after a materialization would need the materialized object,
+  // which may not be available there, and are not worth handling.
+  auto after_materialization = [&](HInstruction* instruction) {
+    HBasicBlock* block = instruction->GetBlock();
+    if (reachable.IsBitSet(block->GetBlockId())) {
+      return true;
+    }
+    auto point = materialization_points_.find(block);
+    return point != materialization_points_.end() && !instruction->StrictlyDominates(point->second);
+  };
+  for (const auto& entry : slot_of_access_) {
+    if (after_materialization(entry.first)) {
+      return false;
+    }
+  }
+  for (HInstruction* deoptimize : deoptimizations_) {
+    if (after_materialization(deoptimize)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+HPhi* AllocationReplacer::CreatePhi(HBasicBlock* block, size_t slot) {
+  ArenaAllocator* arena = graph_->GetArena();
+  HPhi* phi = new (arena) HPhi(arena, kNoRegNumber, 0, HPhi::ToPhiType(slot_types_[slot]));
+  if (phi->GetType() == Primitive::kPrimNot) {
+    phi->SetReferenceTypeInfo(graph_->GetInexactObjectRti());
+  }
+  block->AddPhi(phi);
+  created_phis_.push_back(phi);
+  return phi;
+}
+
+void AllocationReplacer::MergePredecessorValues(HBasicBlock* block,
+                                                ArenaVector<HInstruction*>* values) {
+  if (block->IsLoopHeader()) {
+    // The values from the back edges are not known yet.
+    for (size_t slot = 0; slot < values->size(); ++slot) {
+      HPhi* phi = CreatePhi(block, slot);
+      loop_phis_.push_back(std::make_pair(phi, slot));
+      (*values)[slot] = phi;
+    }
+    return;
+  }
+  const ArenaVector<HBasicBlock*>& predecessors = block->GetPredecessors();
+  for (size_t slot = 0; slot < values->size(); ++slot) {
+    HInstruction* value = block_values_[predecessors[0]->GetBlockId()][slot];
+    for (size_t i = 1; i < predecessors.size(); ++i) {
+      if (block_values_[predecessors[i]->GetBlockId()][slot] != value) {
+        HPhi* phi = CreatePhi(block, slot);
+        for (HBasicBlock* predecessor : predecessors) {
+          phi->AddInput(block_values_[predecessor->GetBlockId()][slot]);
+        }
+        value = phi;
+        break;
+      }
+    }
+    (*values)[slot] = value;
+  }
+}
+
+HInstruction* AllocationReplacer::Materialize(HInstruction* cursor,
+                                              const ArenaVector<HInstruction*>& values) {
+  ArenaAllocator* arena = graph_->GetArena();
+  HBasicBlock* block = cursor->GetBlock();
+  uint32_t dex_pc = allocation_->GetDexPc();
+  HInstruction* materialized;
+  if (IsArray()) {
+    HNewArray* new_array = allocation_->AsNewArray();
+    materialized = new (arena) HNewArray(new_array->InputAt(0),
+                                         new_array->InputAt(1)->AsCurrentMethod(),
+                                         dex_pc,
+                                         new_array->GetTypeIndex(),
+                                         new_array->GetDexFile(),
+                                         new_array->GetEntrypoint());
+  } else {
+    HNewInstance* new_instance = allocation_->AsNewInstance();
+    materialized = new (arena) HNewInstance(new_instance->InputAt(0),
+                                            new_instance->InputAt(1)->AsCurrentMethod(),
+                                            dex_pc,
+                                            new_instance->GetTypeIndex(),
+                                            new_instance->GetDexFile(),
+                                            /* can_throw */ false,
+                                            /* finalizable */ false,
+                                            new_instance->GetEntrypoint());
+  }
+  block->InsertInstructionBefore(materialized, cursor);
+  // The vregs of the allocation site may have changed since, use the state at the
+  // escape, where the object is allocated.
+  materialized->CopyEnvironmentFrom(FindEnvironment(cursor));
+  materialized->SetReferenceTypeInfo(allocation_->GetReferenceTypeInfo());
+
+  // Fields and elements are zero after the allocation.
+  bool has_stores = false;
+  for (size_t slot = 0; slot < slot_keys_.size(); ++slot) {
+    HInstruction* value = values[slot];
+    if (value == GetDefaultValue(graph_, slot_types_[slot])) {
+      continue;
+    }
+    has_stores = true;
+    HInstruction* store;
+    if (IsArray()) {
+      HArraySet* array_set =
+          new (arena) HArraySet(materialized,
+                                graph_->GetIntConstant(static_cast<int32_t>(slot_keys_[slot])),
+                                value,
+                                slot_types_[slot],
+                                dex_pc);
+      // The value was stored in the array without a type check.
+      array_set->ClearNeedsTypeCheck();
+      store = array_set;
+    } else {
+      const FieldInfo* field_info = slot_fields_[slot];
+      store = new (arena) HInstanceFieldSet(materialized,
+                                            value,
+                                            field_info->GetFieldType(),
+                                            field_info->GetFieldOffset(),
+                                            /* is_volatile */ false,
+                                            field_info->GetFieldIndex(),
+                                            field_info->GetDeclaringClassDefIndex(),
+                                            field_info->GetDexFile(),
+                                            field_info->GetDexCache(),
+                                            dex_pc);
+    }
+    block->InsertInstructionBefore(store, cursor);
+  }
+  if (has_stores && needs_constructor_barrier_) {
+    // The barrier of the inlined constructor stayed at the original allocation, the
+    // stores of the final fields must be visible before the object is published.
+    block->InsertInstructionBefore(new (arena) HMemoryBarrier(kStoreStore, dex_pc), cursor);
+  }
+  ++number_of_materializations_;
+  return materialized;
+}
+
+HEnvironment* AllocationReplacer::FindEnvironment(HInstruction* cursor) const {
+  // The allocation has an environment and dominates the cursor.
+  HInstruction* instruction = cursor;
+  while (!instruction->HasEnvironment()) {
+    if (instruction->GetPrevious() != nullptr) {
+      instruction = instruction->GetPrevious();
+    } else {
+      instruction = instruction->GetBlock()->GetDominator()->GetLastInstruction();
+    }
+  }
+  return instruction->GetEnvironment();
+}
+
+void AllocationReplacer::MaterializeForDeoptimization(HInstruction* deoptimize,
+                                                      const ArenaVector<HInstruction*>& values) {
+  ArenaAllocator* arena = graph_->GetArena();
+  uint32_t dex_pc = deoptimize->GetDexPc();
+  HBasicBlock* block = deoptimize->GetBlock();
+  HBasicBlock* merge = block->SplitAfterForInlining(deoptimize);
+  HBasicBlock* deoptimize_block = block->SplitBeforeForInlining(deoptimize);
+  HBasicBlock* otherwise = new (arena) HBasicBlock(graph_, dex_pc);
+  graph_->AddBlock(deoptimize_block);
+  graph_->AddBlock(otherwise);
+  graph_->AddBlock(merge);
+
+  // The compiled code never continues after the deoptimization: `merge` only sees the
+  // values of the slots, as if the object had not been materialized.
+  block->AddInstruction(new (arena) HIf(deoptimize->InputAt(0), dex_pc));
+  deoptimize->ReplaceInput(graph_->GetIntConstant(1), 0);
+  deoptimize_block->AddInstruction(new (arena) HGoto(dex_pc));
+  otherwise->AddInstruction(new (arena) HGoto(dex_pc));
+  block->AddSuccessor(deoptimize_block);
+  block->AddSuccessor(otherwise);
+  deoptimize_block->AddSuccessor(merge);
+  otherwise->AddSuccessor(merge);
+
+  HInstruction* materialized = Materialize(deoptimize, values);
+  for (HEnvironment* environment = deoptimize->GetEnvironment();
+       environment != nullptr;
+       environment = environment->GetParent()) {
+    for (size_t i = 0, e = environment->Size(); i < e; ++i) {
+      if (environment->GetInstructionAt(i) == allocation_) {
+        environment->RemoveAsUserOfInput(i);
+        environment->SetRawEnvAt(i, materialized);
+        materialized->AddEnvUseAt(environment, i);
+      }
+    }
+  }
+}
+
+void AllocationReplacer::ReplaceEscapes(HBasicBlock* block, HInstruction* materialized) {
+  for (HInstruction* user : escapes_) {
+    if (user->GetBlock() != block) {
+      continue;
+    }
+    for (size_t i = 0, e = user->InputCount(); i < e; ++i) {
+      if (user->InputAt(i) == allocation_) {
+        user->ReplaceInput(materialized, i);
+      }
+    }
+  }
+  for (const std::pair<HPhi*, size_t>& phi_escape : phi_escapes_) {
+    HPhi* phi = phi_escape.first;
+    if (phi->GetBlock()->GetPredecessors()[phi_escape.second] == block) {
+      phi->ReplaceInput(materialized, phi_escape.second);
+    }
+  }
+}
+
+void AllocationReplacer::Replace() {
+  HBasicBlock* allocation_block = allocation_->GetBlock();
+  ArenaVector<HInstruction*> values(slot_keys_.size(),
+                                    nullptr,
+                                    graph_->GetArena()->Adapter(kArenaAllocEscapeAnalysis));
+
+  for (HInstruction* null_check : null_checks_) {
+    null_check->ReplaceWith(null_check->InputAt(0));
+    null_check->GetBlock()->RemoveInstruction(null_check);
+  }
+
+  if (!IsArray()) {
+    size_t pointer_size = InstructionSetPointerSize(graph_->GetInstructionSet());
+    for (const FieldInfo* field_info : slot_fields_) {
+      needs_constructor_barrier_ =
+          needs_constructor_barrier_ || MayBeFinal(*field_info, pointer_size);
+    }
+  }
+
+  // Blocks dominated by the allocation, in reverse post order, so that the values
+  // of the slots at the end of the predecessors are known, except for back edges.
+  for (HReversePostOrderIterator block_it(*graph_); !block_it.Done(); block_it.Advance()) {
+    HBasicBlock* block = block_it.Current();
+    if (!allocation_block->Dominates(block)) {
+      continue;
+    }
+    if (block->IsCatchBlock()) {
+      // Never read: the slots are not accessed after a catch.
+      for (size_t slot = 0; slot < values.size(); ++slot) {
+        values[slot] = GetDefaultValue(graph_, slot_types_[slot]);
+      }
+    } else if (block != allocation_block) {
+      MergePredecessorValues(block, &values);
+    }
+    auto point = materialization_points_.find(block);
+    HInstruction* cursor = (point != materialization_points_.end()) ? point->second : nullptr;
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* instruction = it.Current();
+      if (instruction == cursor) {
+        ReplaceEscapes(block, Materialize(cursor, values));
+        cursor = nullptr;
+      }
+      if (instruction == allocation_) {
+        for (size_t slot = 0; slot < values.size(); ++slot) {
+          values[slot] = GetDefaultValue(graph_, slot_types_[slot]);
+        }
+        continue;
+      }
+      if (instruction->IsDeoptimize() &&
+          std::find(deoptimizations_.begin(), deoptimizations_.end(), instruction) !=
+              deoptimizations_.end()) {
+        deoptimization_values_.push_back(std::make_pair(instruction, values));
+        continue;
+      }
+      if (instruction->IsArrayLength() && instruction->InputAt(0) == allocation_) {
+        instruction->ReplaceWith(allocation_->InputAt(0));
+        block->RemoveInstruction(instruction);
+        continue;
+      }
+      auto access = slot_of_access_.find(instruction);
+      if (access == slot_of_access_.end()) {
+        continue;
+      }
+      size_t slot = access->second;
+      if (instruction->IsArrayGet() || instruction->IsArraySet()) {
+        // The index is in the bounds of the array.
+        HInstruction* index = instruction->InputAt(1);
+        if (index->IsBoundsCheck()) {
+          index->ReplaceWith(index->InputAt(0));
+          index->GetBlock()->RemoveInstruction(index);
+        }
+      }
+      if (instruction->IsInstanceFieldSet() || instruction->IsArraySet()) {
+        values[slot] = instruction->InputAt(instruction->IsArraySet() ? 2 : 1);
+      } else {
+        instruction->ReplaceWith(values[slot]);
+      }
+      block->RemoveInstruction(instruction);
+    }
+    block_values_[block->GetBlockId()] = values;
+  }
+
+  for (const std::pair<HPhi*, size_t>& loop_phi : loop_phis_) {
+    HPhi* phi = loop_phi.first;
+    for (HBasicBlock* predecessor : phi->GetBlock()->GetPredecessors()) {
+      phi->AddInput(block_values_[predecessor->GetBlockId()][loop_phi.second]);
+    }
+  }
+
+  // Once the values of the loop phis are known.
+  for (const auto& entry : deoptimization_values_) {
+    MaterializeForDeoptimization(entry.first, entry.second);
+  }
+
+  for (HInstruction* monitor_operation : monitor_operations_) {
+    monitor_operation->GetBlock()->RemoveInstruction(monitor_operation);
+  }
+
+  DCHECK(!allocation_->HasNonEnvironmentUses());
+  allocation_->RemoveEnvironmentUsers();
+  allocation_block->RemoveInstruction(allocation_);
+  RemovePhis();
+}
+
+void AllocationReplacer::RemovePhis() {
+  // Phis are created at all merges and loop headers, whether or not the values are
+  // used after them. The phis only used by created phis are dead.
+  ArenaVector<HPhi*> worklist(graph_->GetArena()->Adapter(kArenaAllocEscapeAnalysis));
+  ArenaSet<HPhi*> live_phis(graph_->GetArena()->Adapter(kArenaAllocEscapeAnalysis));
+  auto is_created_phi = [this](HInstruction* instruction) {
+    return instruction->IsPhi() &&
+        std::find(created_phis_.begin(), created_phis_.end(), instruction) != created_phis_.end();
+  };
+  for (HPhi* phi : created_phis_) {
+    bool is_live = phi->HasEnvironmentUses();
+    for (const HUseListNode<HInstruction*>& use : phi->GetUses()) {
+      is_live = is_live || !is_created_phi(use.GetUser());
+    }
+    if (is_live && live_phis.insert(phi).second) {
+      worklist.push_back(phi);
+    }
+  }
+  while (!worklist.empty()) {
+    HPhi* phi = worklist.back();
+    worklist.pop_back();
+    for (size_t i = 0, e = phi->InputCount(); i < e; ++i) {
+      HInstruction* input = phi->InputAt(i);
+      if (is_created_phi(input) && live_phis.insert(input->AsPhi()).second) {
+        worklist.push_back(input->AsPhi());
+      }
+    }
+  }
+  for (HPhi* phi : created_phis_) {
+    if (live_phis.find(phi) == live_phis.end()) {
+      for (size_t i = 0, e = phi->InputCount(); i < e; ++i) {
+        phi->RemoveAsUserOfInput(i);
+      }
+    }
+  }
+  for (HPhi* phi : created_phis_) {
+    if (live_phis.find(phi) == live_phis.end()) {
+      DCHECK(!phi->HasUses());
+      phi->GetBlock()->RemovePhi(phi, /* ensure_safety */ false);
+    }
+  }
+
+  // The live phis merging a single value with themselves are replaced by that value.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto it = live_phis.begin(); it != live_phis.end(); ) {
+      HPhi* phi = *it;
+      HInstruction* value = nullptr;
+      bool is_redundant = true;
+      for (size_t i = 0, e = phi->InputCount(); i < e && is_redundant; ++i) {
+        HInstruction* input = phi->InputAt(i);
+        if (input == phi || input == value) {
+          continue;
+        }
+        is_redundant = (value == nullptr);
+        value = input;
+      }
+      if (is_redundant && value != nullptr) {
+        phi->ReplaceWith(value);
+        phi->GetBlock()->RemovePhi(phi);
+        it = live_phis.erase(it);
+        changed = true;
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+void PartialEscapeAnalysis::Run() {
+  // The debugger may look at the objects.
+  if (graph_->IsDebuggable() ||
+      graph_->IsCompilingOsr() ||
+      graph_->HasIrreducibleLoops()) {
+    return;
+  }
+
+  ArenaVector<HInstruction*> allocations(graph_->GetArena()->Adapter(kArenaAllocEscapeAnalysis));
+  for (HReversePostOrderIterator block_it(*graph_); !block_it.Done(); block_it.Advance()) {
+    for (HInstructionIterator it(block_it.Current()->GetInstructions()); !it.Done(); it.Advance()) {
+      if (IsCandidate(it.Current())) {
+        allocations.push_back(it.Current());
+      }
+    }
+  }
+
+  // In allocation order, so that in `new Outer(new Inner())` the inner object no longer
+  // escapes through the store to the replaced outer one. Other orders are caught by
+  // trying the remaining allocations again until none is replaced.
+  bool replaced = true;
+  while (replaced) {
+    replaced = false;
+    for (auto it = allocations.begin(); it != allocations.end(); ) {
+      AllocationReplacer replacer(graph_, *it);
+      if (!replacer.Analyze()) {
+        ++it;
+        continue;
+      }
+      replacer.Replace();
+      if (replacer.HasAddedBlocks()) {
+        graph_->ClearLoopInformation();
+        graph_->ClearDominanceInformation();
+        graph_->BuildDominatorTree();
+      }
+      MaybeRecordStat(MethodCompilationStat::kScalarReplacedAllocation);
+      MaybeRecordStat(MethodCompilationStat::kMaterializedAllocation,
+                      replacer.GetNumberOfMaterializations());
+      MaybeRecordStat(MethodCompilationStat::kRemovedMonitorOperation,
+                      replacer.GetNumberOfMonitorOperations());
+      it = allocations.erase(it);
+      replaced = true;
+    }
+  }
+}
+
+}  // namespace art
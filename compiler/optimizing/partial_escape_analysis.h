@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_PARTIAL_ESCAPE_ANALYSIS_H_
+#define ART_COMPILER_OPTIMIZING_PARTIAL_ESCAPE_ANALYSIS_H_
+
+#include "optimization.h"
+
+namespace art {
+
+/**
+ * Scalar replacement of the allocations that do not escape the method, or only
+ * escape on some paths.
+ *
+ * The fields of an HNewInstance, or the elements of an HNewArray of small constant
+ * length, that are only accessed directly become SSA values, with phis where the
+ * paths merge. When the object flows into a call, the heap, a phi, a return or any
+ * other use than a field or element access, it is materialized right before that
+ * use, with the values of its fields at that point, on that path only:
+ *
+ *   Point p = new Point();         if (x < 0) {
+ *   p.x = x;                         Point m = new Point(); m.x = x; m.y = y;
+ *   p.y = y;                 =>      log(m);
+ *   if (x < 0) {                     return 0;
+ *     log(p);                      }
+ *     return 0;                    return x + y;
+ *   }
+ *   return p.x + p.y;
+ *
+ * An object is only materialized once on a path, and is not accessed directly
+ * after that. The monitor operations on an object that never escapes are removed.
+ * A deoptimization that needs the object gets a copy, allocated on the path where
+ * it deoptimizes.
+ */
+class PartialEscapeAnalysis : public HOptimization {
+ public:
+  PartialEscapeAnalysis(HGraph* graph, OptimizingCompilerStats* stats)
+      : HOptimization(graph, kPartialEscapeAnalysisPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  static constexpr const char* kPartialEscapeAnalysisPassName = "partial_escape_analysis";
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(PartialEscapeAnalysis);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_PARTIAL_ESCAPE_ANALYSIS_H_
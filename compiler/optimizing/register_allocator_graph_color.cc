@@ -0,0 +1,1400 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "register_allocator_graph_color.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+#include "base/bit_utils.h"
+#include "code_generator.h"
+#include "register_allocation_resolver.h"
+#include "ssa_liveness_analysis.h"
+
+namespace art {
+
+static constexpr size_t kDefaultNumberOfSpillSlots = 4;
+
+// Every failed coloring attempt splits intervals, so the number of attempts is
+// bounded by the number of register uses. In practice, a handful of attempts is
+// enough; we check in debug builds that nothing goes wrong.
+static constexpr size_t kMaxGraphColoringAttemptsDebug = 100;
+
+// Moves and memory accesses in a loop are assumed to execute ten times as often
+// as the ones outside of it. The depth is capped so that costs stay finite.
+static constexpr float kLoopCostMultiplier = 10.0f;
+static constexpr size_t kMaxLoopDepthForCost = 8;
+
+// Spill weight of the nodes that must get a register because splitting them
+// further would not help: temporaries, and intervals already reduced to a register use.
+static constexpr float kUnsplittableSpillWeight = std::numeric_limits<float>::max();
+
+// One bit per physical register. All supported targets have at most 64 registers
+// of each kind; an ARM double register is a pair of S registers.
+typedef uint64_t RegisterMask;
+static constexpr size_t kMaxNumberOfRegisters = 64;
+
+static RegisterMask RegisterBit(size_t reg) {
+  return static_cast<RegisterMask>(1u) << reg;
+}
+
+// For simplicity, we implement register pairs as (reg, reg + 1), like the linear scan
+// allocator does.
+static RegisterMask PairBits(size_t low) {
+  return RegisterBit(low) | RegisterBit(low + 1);
+}
+
+static size_t CountAvailableColors(RegisterMask free, bool requires_two_registers) {
+  if (!requires_two_registers) {
+    return POPCOUNT(free);
+  }
+  size_t count = 0;
+  for (size_t reg = 0; reg + 1 < kMaxNumberOfRegisters; reg += 2) {
+    if ((free & PairBits(reg)) == PairBits(reg)) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+static size_t LoopDepthAt(const SsaLivenessAnalysis& liveness, size_t position) {
+  HBasicBlock* block = liveness.GetBlockFromPosition(position / 2);
+  size_t depth = 0;
+  for (HLoopInformationOutwardIterator it(*block); !it.Done(); it.Advance()) {
+    ++depth;
+  }
+  return depth;
+}
+
+// Estimated cost of a move or of a memory access at `position`.
+static float CostAt(const SsaLivenessAnalysis& liveness, size_t position) {
+  size_t depth = std::min(LoopDepthAt(liveness, position), kMaxLoopDepthForCost);
+  return std::pow(kLoopCostMultiplier, static_cast<float>(depth));
+}
+
+// The spill weight of an interval is the cost of its register uses, divided by its
+// length: long intervals with few uses are the best candidates for spilling.
+static float ComputeSpillWeight(LiveInterval* interval, const SsaLivenessAnalysis& liveness) {
+  if (interval->IsTemp()) {
+    return kUnsplittableSpillWeight;
+  }
+  size_t start = interval->GetStart();
+  size_t end = interval->GetEnd();
+  size_t first_register_use = interval->FirstRegisterUse();
+  if (first_register_use == kNoLifetime) {
+    return 0.0f;
+  }
+  if (end - start <= 2) {
+    return kUnsplittableSpillWeight;
+  }
+  float use_cost = 0.0f;
+  for (size_t use = first_register_use;
+       use != kNoLifetime;
+       use = interval->FirstRegisterUseAfter(use)) {
+    use_cost += CostAt(liveness, use);
+  }
+  return use_cost / static_cast<float>(end - start);
+}
+
+class InterferenceNode;
+
+// A move between two nodes that could be removed by giving them the same color.
+class CoalesceOpportunity : public ArenaObject<kArenaAllocRegisterAllocator> {
+ public:
+  CoalesceOpportunity(InterferenceNode* a, InterferenceNode* b, float cost)
+      : node_a_(a), node_b_(b), cost_(cost) {}
+
+  InterferenceNode* GetNodeA() const { return node_a_; }
+  InterferenceNode* GetNodeB() const { return node_b_; }
+  float GetCost() const { return cost_; }
+
+ private:
+  InterferenceNode* const node_a_;
+  InterferenceNode* const node_b_;
+  const float cost_;
+
+  DISALLOW_COPY_AND_ASSIGN(CoalesceOpportunity);
+};
+
+// A node of the interference graph. A node starts with one live interval sibling,
+// and accumulates the members of the nodes coalesced into it. Edges are only
+// recorded between nodes that need a color; the colors of precolored neighbors
+// are accumulated in a mask instead.
+class InterferenceNode : public ArenaObject<kArenaAllocRegisterAllocator> {
+ public:
+  InterferenceNode(ArenaAllocator* allocator,
+                   LiveInterval* interval,
+                   size_t id,
+                   RegisterMask precolor,
+                   float spill_weight)
+      : members_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        adjacent_nodes_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        coalesce_opportunities_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        id_(id),
+        requires_two_registers_(interval->HasHighInterval()),
+        is_precolored_(precolor != 0),
+        color_(precolor),
+        fixed_colors_(0),
+        degree_(0),
+        spill_weight_(spill_weight),
+        alias_(this),
+        mark_(0) {
+    members_.push_back(interval);
+  }
+
+  LiveInterval* GetInterval() const { return members_[0]; }
+  const ArenaVector<LiveInterval*>& GetMembers() const { return members_; }
+  ArenaVector<InterferenceNode*>* GetAdjacentNodes() { return &adjacent_nodes_; }
+  ArenaVector<CoalesceOpportunity*>* GetCoalesceOpportunities() {
+    return &coalesce_opportunities_;
+  }
+
+  size_t GetId() const { return id_; }
+  bool RequiresTwoRegisters() const { return requires_two_registers_; }
+  bool IsPrecolored() const { return is_precolored_; }
+
+  RegisterMask GetColor() const { return color_; }
+  void SetColor(RegisterMask color) { color_ = color; }
+  bool HasColor() const { return color_ != 0; }
+
+  RegisterMask GetFixedColors() const { return fixed_colors_; }
+  void AddFixedColors(RegisterMask colors) { fixed_colors_ |= colors; }
+
+  size_t GetDegree() const { return degree_; }
+  void SetDegree(size_t degree) { degree_ = degree; }
+
+  float GetSpillWeight() const { return spill_weight_; }
+
+  InterferenceNode* GetAlias() const { return alias_; }
+  void SetAlias(InterferenceNode* alias) { alias_ = alias; }
+
+  size_t GetMark() const { return mark_; }
+  void SetMark(size_t mark) { mark_ = mark; }
+
+  // Number of colors this node takes from a neighbor of `other`'s kind.
+  size_t EdgeWeightFor(const InterferenceNode* other) const {
+    return (requires_two_registers_ && !other->requires_two_registers_) ? 2 : 1;
+  }
+
+  // Number of colors still available to this node, given its precolored neighbors.
+  size_t NumberOfAvailableColors(RegisterMask allocatable) const {
+    return CountAvailableColors(allocatable & ~fixed_colors_, requires_two_registers_);
+  }
+
+  bool IsLiveAcrossCall() const {
+    for (LiveInterval* member : members_) {
+      if (member->HasWillCallSafepoint()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Merge `other` into this node.
+  void Coalesce(InterferenceNode* other) {
+    DCHECK(!is_precolored_);
+    DCHECK(!other->is_precolored_);
+    DCHECK_EQ(requires_two_registers_, other->requires_two_registers_);
+    other->alias_ = this;
+    members_.insert(members_.end(), other->members_.begin(), other->members_.end());
+    adjacent_nodes_.insert(
+        adjacent_nodes_.end(), other->adjacent_nodes_.begin(), other->adjacent_nodes_.end());
+    coalesce_opportunities_.insert(coalesce_opportunities_.end(),
+                                   other->coalesce_opportunities_.begin(),
+                                   other->coalesce_opportunities_.end());
+    fixed_colors_ |= other->fixed_colors_;
+    degree_ += other->degree_;
+    spill_weight_ = std::max(spill_weight_, other->spill_weight_);
+  }
+
+ private:
+  ArenaVector<LiveInterval*> members_;
+  ArenaVector<InterferenceNode*> adjacent_nodes_;
+  ArenaVector<CoalesceOpportunity*> coalesce_opportunities_;
+  const size_t id_;
+  const bool requires_two_registers_;
+  const bool is_precolored_;
+  RegisterMask color_;
+  RegisterMask fixed_colors_;
+  size_t degree_;
+  float spill_weight_;
+  InterferenceNode* alias_;
+  size_t mark_;
+
+  DISALLOW_COPY_AND_ASSIGN(InterferenceNode);
+};
+
+// The state of one coloring attempt for one register kind. It only reads the live
+// intervals; the allocator applies the result.
+class ColoringIteration : public ValueObject {
+ public:
+  ColoringIteration(ArenaAllocator* allocator,
+                    const SsaLivenessAnalysis& liveness,
+                    HGraph* graph,
+                    bool processing_core_registers,
+                    size_t number_of_registers,
+                    RegisterMask allocatable,
+                    RegisterMask callee_save,
+                    bool coalesce)
+      : allocator_(allocator),
+        liveness_(liveness),
+        graph_(graph),
+        processing_core_registers_(processing_core_registers),
+        allocatable_(allocatable),
+        callee_save_(callee_save),
+        coalesce_(coalesce),
+        nodes_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        node_map_(std::less<LiveInterval*>(), allocator->Adapter(kArenaAllocRegisterAllocator)),
+        physical_nodes_(number_of_registers,
+                        nullptr,
+                        allocator->Adapter(kArenaAllocRegisterAllocator)),
+        coalesce_opportunities_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        stack_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        current_mark_(0) {
+    DCHECK_LE(number_of_registers, kMaxNumberOfRegisters);
+  }
+
+  void BuildInterferenceGraph(const ArenaVector<LiveInterval*>& intervals,
+                              const ArenaVector<LiveInterval*>& physical_intervals);
+  void FindCoalesceOpportunities();
+  void Coalesce();
+  void PruneInterferenceGraph();
+  void ColorInterferenceGraph();
+
+  // Returns the nodes that were to be colored, after coalescing.
+  void GetColorableNodes(ArenaVector<InterferenceNode*>* nodes) const {
+    for (InterferenceNode* node : nodes_) {
+      if (!node->IsPrecolored() && node->GetAlias() == node) {
+        nodes->push_back(node);
+      }
+    }
+  }
+
+ private:
+  InterferenceNode* CreateNode(LiveInterval* interval, RegisterMask precolor);
+  InterferenceNode* FindNodeFor(LiveInterval* interval) const;
+  static InterferenceNode* Find(InterferenceNode* node);
+
+  void AddInterference(InterferenceNode* a, InterferenceNode* b);
+  void AddCoalesceOpportunity(InterferenceNode* a, InterferenceNode* b, float cost);
+
+  // Replace the neighbors of each node by their representative, and compute degrees.
+  void ComputeDegrees();
+
+  bool Interferes(InterferenceNode* a, InterferenceNode* b) const;
+
+  // Briggs test: merging `a` and `b` cannot make the graph uncolorable if the merged
+  // node has fewer neighbors of significant degree than available colors.
+  bool CanCoalesceConservatively(InterferenceNode* a, InterferenceNode* b);
+
+  bool IsLowDegree(const InterferenceNode* node) const {
+    return node->GetDegree() < node->NumberOfAvailableColors(allocatable_);
+  }
+
+  // Pick a register in `free` for `node`, or 0 if there is none.
+  RegisterMask ChooseColor(InterferenceNode* node, RegisterMask free) const;
+
+  ArenaAllocator* const allocator_;
+  const SsaLivenessAnalysis& liveness_;
+  HGraph* const graph_;
+  const bool processing_core_registers_;
+  const RegisterMask allocatable_;
+  const RegisterMask callee_save_;
+  const bool coalesce_;
+
+  // All nodes, in creation order.
+  ArenaVector<InterferenceNode*> nodes_;
+
+  // The node of each live interval sibling, and of each physical register.
+  ArenaSafeMap<LiveInterval*, InterferenceNode*> node_map_;
+  ArenaVector<InterferenceNode*> physical_nodes_;
+
+  ArenaVector<CoalesceOpportunity*> coalesce_opportunities_;
+
+  // Nodes in the order they were pruned from the graph.
+  ArenaVector<InterferenceNode*> stack_;
+
+  // Used to visit each node once when walking neighbor lists.
+  size_t current_mark_;
+
+  DISALLOW_COPY_AND_ASSIGN(ColoringIteration);
+};
+
+InterferenceNode* ColoringIteration::CreateNode(LiveInterval* interval, RegisterMask precolor) {
+  float spill_weight = (precolor != 0 || interval->IsFixed())
+      ? kUnsplittableSpillWeight
+      : ComputeSpillWeight(interval, liveness_);
+  InterferenceNode* node = new (allocator_) InterferenceNode(
+      allocator_, interval, nodes_.size(), precolor, spill_weight);
+  nodes_.push_back(node);
+  node_map_.Put(interval, node);
+  return node;
+}
+
+InterferenceNode* ColoringIteration::FindNodeFor(LiveInterval* interval) const {
+  if (interval == nullptr) {
+    return nullptr;
+  }
+  auto it = node_map_.find(interval);
+  return it == node_map_.end() ? nullptr : it->second;
+}
+
+InterferenceNode* ColoringIteration::Find(InterferenceNode* node) {
+  InterferenceNode* representative = node;
+  while (representative->GetAlias() != representative) {
+    representative = representative->GetAlias();
+  }
+  // Path compression.
+  while (node != representative) {
+    InterferenceNode* next = node->GetAlias();
+    node->SetAlias(representative);
+    node = next;
+  }
+  return representative;
+}
+
+void ColoringIteration::AddInterference(InterferenceNode* a, InterferenceNode* b) {
+  if (a->IsPrecolored() && b->IsPrecolored()) {
+    return;
+  } else if (a->IsPrecolored()) {
+    b->AddFixedColors(a->GetColor());
+  } else if (b->IsPrecolored()) {
+    a->AddFixedColors(b->GetColor());
+  } else {
+    a->GetAdjacentNodes()->push_back(b);
+    b->GetAdjacentNodes()->push_back(a);
+  }
+}
+
+void ColoringIteration::AddCoalesceOpportunity(InterferenceNode* a,
+                                               InterferenceNode* b,
+                                               float cost) {
+  if (a == b) {
+    return;
+  }
+  CoalesceOpportunity* opportunity = new (allocator_) CoalesceOpportunity(a, b, cost);
+  coalesce_opportunities_.push_back(opportunity);
+  a->GetCoalesceOpportunities()->push_back(opportunity);
+  b->GetCoalesceOpportunities()->push_back(opportunity);
+}
+
+// A start or end of a live range, for the sweep that finds interferences.
+struct RangeEndpoint {
+  RangeEndpoint(size_t position, bool is_start, InterferenceNode* node)
+      : position(position), is_start(is_start), node(node) {}
+
+  size_t position;
+  bool is_start;
+  InterferenceNode* node;
+};
+
+void ColoringIteration::BuildInterferenceGraph(
+    const ArenaVector<LiveInterval*>& intervals,
+    const ArenaVector<LiveInterval*>& physical_intervals) {
+  for (size_t reg = 0; reg < physical_intervals.size(); ++reg) {
+    LiveInterval* fixed = physical_intervals[reg];
+    // Blocked registers are never picked, so there is no need to model them.
+    if (fixed != nullptr && (allocatable_ & RegisterBit(reg)) != 0) {
+      physical_nodes_[reg] = CreateNode(fixed, RegisterBit(reg));
+    }
+  }
+
+  for (LiveInterval* interval : intervals) {
+    for (LiveInterval* sibling = interval;
+         sibling != nullptr;
+         sibling = sibling->GetNextSibling()) {
+      RegisterMask precolor = 0;
+      if (sibling->HasRegister()) {
+        precolor = RegisterBit(sibling->GetRegister());
+        if (sibling->HasHighInterval()) {
+          precolor |= RegisterBit(sibling->GetHighInterval()->GetRegister());
+        }
+      }
+      CreateNode(sibling, precolor);
+    }
+  }
+
+  // Sweep over the start and end positions of all ranges, keeping track of the nodes
+  // that are live. Every node interferes with the nodes live when one of its ranges starts.
+  ArenaVector<RangeEndpoint> endpoints(allocator_->Adapter(kArenaAllocRegisterAllocator));
+  for (InterferenceNode* node : nodes_) {
+    for (LiveRange* range = node->GetInterval()->GetFirstRange();
+         range != nullptr;
+         range = range->GetNext()) {
+      endpoints.push_back(RangeEndpoint(range->GetStart(), /* is_start */ true, node));
+      endpoints.push_back(RangeEndpoint(range->GetEnd(), /* is_start */ false, node));
+    }
+  }
+  std::sort(endpoints.begin(), endpoints.end(), [](const RangeEndpoint& lhs,
+                                                   const RangeEndpoint& rhs) {
+    if (lhs.position != rhs.position) {
+      return lhs.position < rhs.position;
+    }
+    // Ranges are half-open: process ends before starts at the same position.
+    if (lhs.is_start != rhs.is_start) {
+      return !lhs.is_start;
+    }
+    return lhs.node->GetId() < rhs.node->GetId();
+  });
+
+  ArenaVector<InterferenceNode*> live(allocator_->Adapter(kArenaAllocRegisterAllocator));
+  for (const RangeEndpoint& endpoint : endpoints) {
+    if (endpoint.is_start) {
+      for (InterferenceNode* other : live) {
+        AddInterference(endpoint.node, other);
+      }
+      live.push_back(endpoint.node);
+    } else {
+      auto it = std::find(live.begin(), live.end(), endpoint.node);
+      DCHECK(it != live.end());
+      *it = live.back();
+      live.pop_back();
+    }
+  }
+  DCHECK(live.empty());
+
+  ComputeDegrees();
+}
+
+void ColoringIteration::ComputeDegrees() {
+  for (InterferenceNode* node : nodes_) {
+    if (node->IsPrecolored() || node->GetAlias() != node) {
+      continue;
+    }
+    ArenaVector<InterferenceNode*>* adjacent = node->GetAdjacentNodes();
+    for (InterferenceNode*& neighbor : *adjacent) {
+      neighbor = Find(neighbor);
+      DCHECK_NE(neighbor, node);
+    }
+    std::sort(adjacent->begin(), adjacent->end(), [](InterferenceNode* lhs, InterferenceNode* rhs) {
+      return lhs->GetId() < rhs->GetId();
+    });
+    adjacent->erase(std::unique(adjacent->begin(), adjacent->end()), adjacent->end());
+    size_t degree = 0;
+    for (InterferenceNode* neighbor : *adjacent) {
+      degree += neighbor->EdgeWeightFor(node);
+    }
+    node->SetDegree(degree);
+  }
+}
+
+void ColoringIteration::FindCoalesceOpportunities() {
+  // Moves between the siblings of a split interval.
+  for (size_t i = 0, e = nodes_.size(); i < e; ++i) {
+    InterferenceNode* node = nodes_[i];
+    LiveInterval* interval = node->GetInterval();
+    if (interval->IsFixed() || interval->IsTemp()) {
+      continue;
+    }
+    LiveInterval* next = interval->GetNextSibling();
+    InterferenceNode* next_node = FindNodeFor(next);
+    if (next_node != nullptr) {
+      AddCoalesceOpportunity(node, next_node, CostAt(liveness_, next->GetStart()));
+    }
+  }
+
+  for (HLinearOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+
+    // Moves between phis and their inputs, at the end of each predecessor.
+    for (HInstructionIterator phi_it(block->GetPhis()); !phi_it.Done(); phi_it.Advance()) {
+      HPhi* phi = phi_it.Current()->AsPhi();
+      InterferenceNode* phi_node = FindNodeFor(phi->GetLiveInterval());
+      if (phi_node == nullptr) {
+        continue;
+      }
+      for (size_t i = 0, e = phi->InputCount(); i < e; ++i) {
+        size_t position = block->GetPredecessors()[i]->GetLifetimeEnd() - 1;
+        LiveInterval* input_interval = phi->InputAt(i)->GetLiveInterval();
+        if (input_interval == nullptr) {
+          continue;
+        }
+        InterferenceNode* input_node = FindNodeFor(input_interval->GetSiblingAt(position));
+        if (input_node != nullptr) {
+          AddCoalesceOpportunity(phi_node, input_node, CostAt(liveness_, position));
+        }
+      }
+    }
+
+    for (HInstructionIterator inst_it(block->GetInstructions());
+         !inst_it.Done();
+         inst_it.Advance()) {
+      HInstruction* instruction = inst_it.Current();
+      LocationSummary* locations = instruction->GetLocations();
+      if (locations == nullptr) {
+        continue;
+      }
+      size_t position = instruction->GetLifetimePosition();
+
+      // Moves to the fixed registers of inputs.
+      for (size_t i = 0, e = instruction->InputCount(); i < e; ++i) {
+        Location input = locations->InAt(i);
+        bool is_fixed_register = processing_core_registers_
+            ? input.IsRegister()
+            : input.IsFpuRegister();
+        LiveInterval* input_interval = instruction->InputAt(i)->GetLiveInterval();
+        if (!is_fixed_register || input_interval == nullptr) {
+          continue;
+        }
+        InterferenceNode* physical_node = physical_nodes_[input.reg()];
+        InterferenceNode* input_node = FindNodeFor(input_interval->GetSiblingAt(position - 1));
+        if (physical_node != nullptr && input_node != nullptr) {
+          AddCoalesceOpportunity(input_node, physical_node, CostAt(liveness_, position));
+        }
+      }
+
+      // Moves from the first input to an output that must be in the same register.
+      Location out = locations->Out();
+      LiveInterval* interval = instruction->GetLiveInterval();
+      if (interval != nullptr &&
+          out.IsUnallocated() &&
+          out.GetPolicy() == Location::kSameAsFirstInput &&
+          instruction->InputAt(0)->GetLiveInterval() != nullptr) {
+        InterferenceNode* out_node = FindNodeFor(interval->GetSiblingAt(position));
+        InterferenceNode* input_node =
+            FindNodeFor(instruction->InputAt(0)->GetLiveInterval()->GetSiblingAt(position - 1));
+        if (out_node != nullptr && input_node != nullptr) {
+          AddCoalesceOpportunity(out_node, input_node, CostAt(liveness_, position));
+        }
+      }
+    }
+  }
+}
+
+bool ColoringIteration::Interferes(InterferenceNode* a, InterferenceNode* b) const {
+  // Adjacency lists are symmetric, so looking at one side is enough.
+  InterferenceNode* smaller = a->GetAdjacentNodes()->size() < b->GetAdjacentNodes()->size() ? a : b;
+  InterferenceNode* other = smaller == a ? b : a;
+  for (InterferenceNode* neighbor : *smaller->GetAdjacentNodes()) {
+    if (Find(neighbor) == other) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ColoringIteration::CanCoalesceConservatively(InterferenceNode* a, InterferenceNode* b) {
+  RegisterMask free = allocatable_ & ~(a->GetFixedColors() | b->GetFixedColors());
+  size_t available = CountAvailableColors(free, a->RequiresTwoRegisters());
+  size_t significant = 0;
+  ++current_mark_;
+  for (InterferenceNode* node : {a, b}) {
+    for (InterferenceNode* neighbor : *node->GetAdjacentNodes()) {
+      neighbor = Find(neighbor);
+      if (neighbor->GetMark() == current_mark_) {
+        continue;
+      }
+      neighbor->SetMark(current_mark_);
+      if (!IsLowDegree(neighbor)) {
+        significant += neighbor->EdgeWeightFor(a);
+        if (significant >= available) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void ColoringIteration::Coalesce() {
+  if (!coalesce_) {
+    return;
+  }
+  // Remove the most expensive moves first.
+  ArenaVector<CoalesceOpportunity*> worklist(coalesce_opportunities_);
+  std::stable_sort(worklist.begin(), worklist.end(), [](CoalesceOpportunity* lhs,
+                                                        CoalesceOpportunity* rhs) {
+    return lhs->GetCost() > rhs->GetCost();
+  });
+  for (CoalesceOpportunity* opportunity : worklist) {
+    InterferenceNode* a = Find(opportunity->GetNodeA());
+    InterferenceNode* b = Find(opportunity->GetNodeB());
+    if (a == b ||
+        a->IsPrecolored() ||
+        b->IsPrecolored() ||
+        a->RequiresTwoRegisters() != b->RequiresTwoRegisters() ||
+        a->GetInterval()->IsTemp() ||
+        b->GetInterval()->IsTemp()) {
+      // Moves to precolored nodes are handled as preferences when selecting colors.
+      continue;
+    }
+    if (Interferes(a, b) || !CanCoalesceConservatively(a, b)) {
+      continue;
+    }
+    if (b->GetId() < a->GetId()) {
+      std::swap(a, b);
+    }
+    a->Coalesce(b);
+  }
+  ComputeDegrees();
+}
+
+void ColoringIteration::PruneInterferenceGraph() {
+  // Nodes of significant degree, with the cheapest to spill on top.
+  auto cheaper_to_spill_last = [](InterferenceNode* lhs, InterferenceNode* rhs) {
+    if (lhs->GetSpillWeight() != rhs->GetSpillWeight()) {
+      return lhs->GetSpillWeight() > rhs->GetSpillWeight();
+    }
+    return lhs->GetId() > rhs->GetId();
+  };
+  std::priority_queue<InterferenceNode*,
+                      ArenaVector<InterferenceNode*>,
+                      decltype(cheaper_to_spill_last)> spill_worklist(
+      cheaper_to_spill_last,
+      ArenaVector<InterferenceNode*>(allocator_->Adapter(kArenaAllocRegisterAllocator)));
+  ArenaVector<InterferenceNode*> low_degree_worklist(
+      allocator_->Adapter(kArenaAllocRegisterAllocator));
+
+  ArenaVector<InterferenceNode*> colorable(allocator_->Adapter(kArenaAllocRegisterAllocator));
+  GetColorableNodes(&colorable);
+  for (InterferenceNode* node : colorable) {
+    node->SetMark(0);
+    if (IsLowDegree(node)) {
+      low_degree_worklist.push_back(node);
+    } else {
+      spill_worklist.push(node);
+    }
+  }
+
+  static constexpr size_t kPruned = 1;
+  static constexpr size_t kInLowDegreeWorklist = 2;
+  for (InterferenceNode* node : low_degree_worklist) {
+    node->SetMark(kInLowDegreeWorklist);
+  }
+
+  size_t remaining = colorable.size();
+  while (remaining != 0) {
+    InterferenceNode* node = nullptr;
+    if (!low_degree_worklist.empty()) {
+      node = low_degree_worklist.back();
+      low_degree_worklist.pop_back();
+    } else {
+      // Only nodes of significant degree remain: optimistically push the cheapest
+      // one to spill, hoping its neighbors will not use all colors.
+      do {
+        DCHECK(!spill_worklist.empty());
+        node = spill_worklist.top();
+        spill_worklist.pop();
+      } while (node->GetMark() != 0);
+    }
+    DCHECK_NE(node->GetMark(), kPruned);
+    node->SetMark(kPruned);
+    stack_.push_back(node);
+    --remaining;
+
+    for (InterferenceNode* neighbor : *node->GetAdjacentNodes()) {
+      if (neighbor->GetMark() == kPruned) {
+        continue;
+      }
+      neighbor->SetDegree(neighbor->GetDegree() - node->EdgeWeightFor(neighbor));
+      if (neighbor->GetMark() == 0 && IsLowDegree(neighbor)) {
+        neighbor->SetMark(kInLowDegreeWorklist);
+        low_degree_worklist.push_back(neighbor);
+      }
+    }
+  }
+}
+
+RegisterMask ColoringIteration::ChooseColor(InterferenceNode* node, RegisterMask free) const {
+  bool pair = node->RequiresTwoRegisters();
+  auto fits = [free, pair](size_t reg) {
+    return pair
+        ? (reg % 2 == 0 && (free & PairBits(reg)) == PairBits(reg))
+        : (free & RegisterBit(reg)) != 0;
+  };
+  auto color_of = [pair](size_t reg) {
+    return pair ? PairBits(reg) : RegisterBit(reg);
+  };
+
+  // Prefer the color of a node we have a move with, starting with the most expensive move.
+  ArenaVector<CoalesceOpportunity*> hints(*node->GetCoalesceOpportunities());
+  std::stable_sort(hints.begin(), hints.end(), [](CoalesceOpportunity* lhs,
+                                                  CoalesceOpportunity* rhs) {
+    return lhs->GetCost() > rhs->GetCost();
+  });
+  for (CoalesceOpportunity* hint : hints) {
+    InterferenceNode* a = Find(hint->GetNodeA());
+    InterferenceNode* partner = (a == node) ? Find(hint->GetNodeB()) : a;
+    if (partner != node && partner->HasColor()) {
+      size_t reg = CTZ(partner->GetColor());
+      if (fits(reg)) {
+        return color_of(reg);
+      }
+    }
+  }
+
+  // Values live across calls are better off in callee-save registers, which only
+  // cost a save and restore in the frame entry and exit. Others should use the
+  // caller-save registers first, to leave callee-save registers unused.
+  RegisterMask preferred = node->IsLiveAcrossCall() ? callee_save_ : ~callee_save_;
+  for (RegisterMask candidates : {free & preferred, free}) {
+    for (size_t reg = 0; reg < kMaxNumberOfRegisters; ++reg) {
+      if ((candidates & RegisterBit(reg)) != 0 && fits(reg)) {
+        return color_of(reg);
+      }
+    }
+  }
+  return 0;
+}
+
+void ColoringIteration::ColorInterferenceGraph() {
+  while (!stack_.empty()) {
+    InterferenceNode* node = stack_.back();
+    stack_.pop_back();
+    RegisterMask taken = node->GetFixedColors();
+    for (InterferenceNode* neighbor : *node->GetAdjacentNodes()) {
+      taken |= neighbor->GetColor();
+    }
+    node->SetColor(ChooseColor(node, allocatable_ & ~taken));
+  }
+}
+
+RegisterAllocatorGraphColor::RegisterAllocatorGraphColor(ArenaAllocator* allocator,
+                                                         CodeGenerator* codegen,
+                                                         const SsaLivenessAnalysis& liveness)
+      : RegisterAllocator(allocator, codegen, liveness),
+        core_intervals_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        fp_intervals_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        physical_core_register_intervals_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        physical_fp_register_intervals_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        temp_intervals_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        safepoints_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        int_spill_slots_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        long_spill_slots_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        float_spill_slots_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        double_spill_slots_(allocator->Adapter(kArenaAllocRegisterAllocator)),
+        catch_phi_spill_slots_(0),
+        blocked_core_registers_(codegen->GetBlockedCoreRegisters()),
+        blocked_fp_registers_(codegen->GetBlockedFloatingPointRegisters()),
+        reserved_out_slots_(0),
+        maximum_number_of_live_core_registers_(0),
+        maximum_number_of_live_fp_registers_(0) {
+  temp_intervals_.reserve(4);
+  int_spill_slots_.reserve(kDefaultNumberOfSpillSlots);
+  long_spill_slots_.reserve(kDefaultNumberOfSpillSlots);
+  float_spill_slots_.reserve(kDefaultNumberOfSpillSlots);
+  double_spill_slots_.reserve(kDefaultNumberOfSpillSlots);
+
+  codegen->SetupBlockedRegisters();
+  physical_core_register_intervals_.resize(codegen->GetNumberOfCoreRegisters(), nullptr);
+  physical_fp_register_intervals_.resize(codegen->GetNumberOfFloatingPointRegisters(), nullptr);
+  // Always reserve for the current method and the graph's max out registers.
+  // ArtMethod* takes 2 vregs for 64 bits.
+  reserved_out_slots_ = InstructionSetPointerSize(codegen->GetInstructionSet()) / kVRegSize +
+      codegen->GetGraph()->GetMaximumNumberOfOutVRegs();
+}
+
+void RegisterAllocatorGraphColor::AllocateRegisters() {
+  ProcessInstructions();
+  ColorIntervals(/* processing_core_registers */ true);
+  ColorIntervals(/* processing_core_registers */ false);
+  AllocateSpillSlots();
+
+  RegisterAllocationResolver(allocator_, codegen_, liveness_)
+      .Resolve(maximum_number_of_live_core_registers_,
+               maximum_number_of_live_fp_registers_,
+               reserved_out_slots_,
+               int_spill_slots_.size(),
+               long_spill_slots_.size(),
+               float_spill_slots_.size(),
+               double_spill_slots_.size(),
+               catch_phi_spill_slots_,
+               temp_intervals_);
+
+  if (kIsDebugBuild) {
+    Validate(/* log_fatal_on_failure */ true);
+  }
+}
+
+bool RegisterAllocatorGraphColor::Validate(bool log_fatal_on_failure) {
+  for (bool processing_core_registers : {true, false}) {
+    ArenaVector<LiveInterval*> intervals(
+        allocator_->Adapter(kArenaAllocRegisterAllocatorValidate));
+    for (size_t i = 0; i < liveness_.GetNumberOfSsaValues(); ++i) {
+      LiveInterval* interval = liveness_.GetInstructionFromSsaIndex(i)->GetLiveInterval();
+      if (interval != nullptr && interval->IsFloatingPoint() != processing_core_registers) {
+        intervals.push_back(interval);
+      }
+    }
+    const ArenaVector<LiveInterval*>& physical_intervals = processing_core_registers
+        ? physical_core_register_intervals_
+        : physical_fp_register_intervals_;
+    for (LiveInterval* fixed : physical_intervals) {
+      if (fixed != nullptr) {
+        intervals.push_back(fixed);
+      }
+    }
+    for (LiveInterval* temp : temp_intervals_) {
+      if (temp->IsFloatingPoint() != processing_core_registers) {
+        intervals.push_back(temp);
+      }
+    }
+    if (!ValidateIntervals(intervals,
+                           GetNumberOfSpillSlots(),
+                           reserved_out_slots_,
+                           *codegen_,
+                           allocator_,
+                           processing_core_registers,
+                           log_fatal_on_failure)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void RegisterAllocatorGraphColor::ProcessInstructions() {
+  for (HLinearPostOrderIterator it(*codegen_->GetGraph()); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    // Instructions are processed backwards so that safepoints end up in decreasing
+    // order of lifetime position, and ranges of fixed intervals in increasing order.
+    for (HBackwardInstructionIterator back_it(block->GetInstructions()); !back_it.Done();
+         back_it.Advance()) {
+      ProcessInstruction(back_it.Current());
+    }
+    for (HInstructionIterator inst_it(block->GetPhis()); !inst_it.Done(); inst_it.Advance()) {
+      ProcessInstruction(inst_it.Current());
+    }
+
+    if (block->IsCatchBlock() ||
+        (block->IsLoopHeader() && block->GetLoopInformation()->IsIrreducible())) {
+      // By blocking all registers at the top of each catch block or irreducible loop, we force
+      // intervals belonging to the live-in set of the catch/header block to be spilled.
+      size_t position = block->GetLifetimeStart();
+      BlockRegisters(position, position + 1);
+    }
+  }
+}
+
+void RegisterAllocatorGraphColor::ProcessInstruction(HInstruction* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  size_t position = instruction->GetLifetimePosition();
+
+  if (locations == nullptr) return;
+
+  // Create synthesized intervals for temporaries.
+  for (size_t i = 0; i < locations->GetTempCount(); ++i) {
+    Location temp = locations->GetTemp(i);
+    if (temp.IsRegister() || temp.IsFpuRegister()) {
+      BlockRegister(temp, position, position + 1);
+      // Ensure that an explicit temporary register is marked as being allocated.
+      codegen_->AddAllocatedRegister(temp);
+    } else {
+      DCHECK(temp.IsUnallocated());
+      switch (temp.GetPolicy()) {
+        case Location::kRequiresRegister: {
+          LiveInterval* interval =
+              LiveInterval::MakeTempInterval(allocator_, Primitive::kPrimInt);
+          interval->AddTempUse(instruction, i);
+          temp_intervals_.push_back(interval);
+          core_intervals_.push_back(interval);
+          break;
+        }
+
+        case Location::kRequiresFpuRegister: {
+          LiveInterval* interval =
+              LiveInterval::MakeTempInterval(allocator_, Primitive::kPrimDouble);
+          interval->AddTempUse(instruction, i);
+          temp_intervals_.push_back(interval);
+          if (codegen_->NeedsTwoRegisters(Primitive::kPrimDouble)) {
+            // The high interval is colored together with the low one.
+            interval->AddHighInterval(/* is_temp */ true);
+            temp_intervals_.push_back(interval->GetHighInterval());
+          }
+          fp_intervals_.push_back(interval);
+          break;
+        }
+
+        default:
+          LOG(FATAL) << "Unexpected policy for temporary location "
+                     << temp.GetPolicy();
+      }
+    }
+  }
+
+  if (locations->NeedsSafepoint()) {
+    if (codegen_->IsLeafMethod()) {
+      // We do this here because we do not want the suspend check to artificially
+      // create live registers.
+      DCHECK(instruction->IsSuspendCheckEntry());
+      instruction->GetBlock()->RemoveInstruction(instruction);
+      return;
+    }
+    safepoints_.push_back(instruction);
+  }
+
+  if (locations->WillCall()) {
+    BlockRegisters(position, position + 1, /* caller_save_only */ true);
+  }
+
+  for (size_t i = 0; i < instruction->InputCount(); ++i) {
+    Location input = locations->InAt(i);
+    if (input.IsRegister() || input.IsFpuRegister()) {
+      BlockRegister(input, position, position + 1);
+    } else if (input.IsPair()) {
+      BlockRegister(input.ToLow(), position, position + 1);
+      BlockRegister(input.ToHigh(), position, position + 1);
+    }
+  }
+
+  LiveInterval* interval = instruction->GetLiveInterval();
+  if (interval == nullptr) return;
+
+  if (codegen_->NeedsTwoRegisters(interval->GetType())) {
+    interval->AddHighInterval();
+  }
+
+  for (size_t safepoint_index = safepoints_.size(); safepoint_index > 0; --safepoint_index) {
+    HInstruction* safepoint = safepoints_[safepoint_index - 1u];
+    size_t safepoint_position = safepoint->GetLifetimePosition();
+
+    // Test that safepoints are ordered in the optimal way.
+    DCHECK(safepoint_index == safepoints_.size() ||
+           safepoints_[safepoint_index]->GetLifetimePosition() < safepoint_position);
+
+    if (safepoint_position == interval->GetStart()) {
+      // The safepoint is for this instruction, so the location of the instruction
+      // does not need to be saved.
+      DCHECK_EQ(safepoint_index, safepoints_.size());
+      DCHECK_EQ(safepoint, instruction);
+      continue;
+    } else if (interval->IsDeadAt(safepoint_position)) {
+      break;
+    } else if (!interval->Covers(safepoint_position)) {
+      // Hole in the interval.
+      continue;
+    }
+    interval->AddSafepoint(safepoint);
+  }
+  interval->ResetSearchCache();
+
+  CheckForFixedOutput(instruction, interval);
+
+  if (instruction->IsPhi() && instruction->AsPhi()->IsCatchPhi()) {
+    AllocateSpillSlotForCatchPhi(instruction->AsPhi());
+  }
+
+  ArenaVector<LiveInterval*>& intervals = interval->IsFloatingPoint()
+      ? fp_intervals_
+      : core_intervals_;
+  if (interval->HasSpillSlot() || instruction->IsConstant()) {
+    // The value already has a home outside registers: only color from its first register use.
+    size_t first_register_use = interval->FirstRegisterUse();
+    if (first_register_use != kNoLifetime) {
+      intervals.push_back(SplitBetween(interval, interval->GetStart(), first_register_use - 1));
+    }
+  } else {
+    intervals.push_back(interval);
+  }
+}
+
+void RegisterAllocatorGraphColor::CheckForFixedOutput(HInstruction* instruction,
+                                                      LiveInterval* interval) {
+  LocationSummary* locations = instruction->GetLocations();
+  size_t position = instruction->GetLifetimePosition();
+
+  // Some instructions define their output in fixed register/stack slot. The part of
+  // the interval at the definition is precolored, and the fixed register is blocked
+  // at the instruction.
+  Location output = locations->Out();
+  if (output.IsUnallocated() && output.GetPolicy() == Location::kSameAsFirstInput) {
+    Location first = locations->InAt(0);
+    if (first.IsRegister() || first.IsFpuRegister()) {
+      interval->SetFrom(position + 1);
+      interval->SetRegister(first.reg());
+    } else if (first.IsPair()) {
+      interval->SetFrom(position + 1);
+      interval->SetRegister(first.low());
+      LiveInterval* high = interval->GetHighInterval();
+      high->SetRegister(first.high());
+      high->SetFrom(position + 1);
+    }
+  } else if (output.IsRegister() || output.IsFpuRegister()) {
+    // Shift the interval's start by one to account for the blocked register.
+    interval->SetFrom(position + 1);
+    interval->SetRegister(output.reg());
+    BlockRegister(output, position, position + 1);
+  } else if (output.IsPair()) {
+    interval->SetFrom(position + 1);
+    interval->SetRegister(output.low());
+    LiveInterval* high = interval->GetHighInterval();
+    high->SetRegister(output.high());
+    high->SetFrom(position + 1);
+    BlockRegister(output.ToLow(), position, position + 1);
+    BlockRegister(output.ToHigh(), position, position + 1);
+  } else if (output.IsStackSlot() || output.IsDoubleStackSlot() || output.IsSIMDStackSlot()) {
+    interval->SetSpillSlot(output.GetStackIndex());
+  } else {
+    DCHECK(output.IsUnallocated() || output.IsConstant());
+  }
+
+  if (interval->HasRegister()) {
+    bool is_fp = interval->IsFloatingPoint();
+    codegen_->AddAllocatedRegister(is_fp ? Location::FpuRegisterLocation(interval->GetRegister())
+                                         : Location::RegisterLocation(interval->GetRegister()));
+    if (interval->HasHighInterval()) {
+      int high = interval->GetHighInterval()->GetRegister();
+      codegen_->AddAllocatedRegister(is_fp ? Location::FpuRegisterLocation(high)
+                                           : Location::RegisterLocation(high));
+    }
+    // Only the definition needs to be in the fixed register: the rest of the
+    // interval is colored like any other.
+    TrySplit(interval, position + 2);
+  }
+}
+
+LiveInterval* RegisterAllocatorGraphColor::TrySplit(LiveInterval* interval, size_t position) {
+  if (interval->GetStart() < position && position < interval->GetEnd()) {
+    return Split(interval, position);
+  }
+  return interval;
+}
+
+bool RegisterAllocatorGraphColor::SplitAtRegisterUses(LiveInterval* interval) {
+  DCHECK(!interval->IsTemp());
+  DCHECK(!interval->HasRegister());
+  LiveInterval* last_sibling = interval->GetLastSibling();
+  LiveInterval* current = interval;
+
+  // Isolate the definition if it needs a register.
+  if (current->IsParent() && current->DefinitionRequiresRegister()) {
+    current = TrySplit(current, current->GetStart() + 1);
+  }
+
+  // Isolate each use that needs a register. The parts in between do not
+  // need a register, and will be spilled if coloring fails again.
+  for (size_t use = current->FirstRegisterUseAfter(current->GetStart());
+       use != kNoLifetime;
+       use = current->FirstRegisterUseAfter(current->GetStart())) {
+    current = TrySplit(current, use - 1);
+    current = TrySplit(current, use + 1);
+    if (current->GetStart() <= use) {
+      // The use is at the end of the interval, or could not be isolated further.
+      break;
+    }
+  }
+
+  return interval->GetLastSibling() != last_sibling;
+}
+
+void RegisterAllocatorGraphColor::ColorIntervals(bool processing_core_registers) {
+  ArenaVector<LiveInterval*>& intervals = processing_core_registers
+      ? core_intervals_
+      : fp_intervals_;
+  const ArenaVector<LiveInterval*>& physical_intervals = processing_core_registers
+      ? physical_core_register_intervals_
+      : physical_fp_register_intervals_;
+  size_t number_of_registers = processing_core_registers
+      ? codegen_->GetNumberOfCoreRegisters()
+      : codegen_->GetNumberOfFloatingPointRegisters();
+  bool* blocked_registers = processing_core_registers
+      ? blocked_core_registers_
+      : blocked_fp_registers_;
+
+  RegisterMask allocatable = 0;
+  RegisterMask callee_save = 0;
+  for (size_t reg = 0; reg < number_of_registers; ++reg) {
+    if (!blocked_registers[reg]) {
+      allocatable |= RegisterBit(reg);
+    }
+    if (!IsCallerSaveRegister(reg, processing_core_registers)) {
+      callee_save |= RegisterBit(reg);
+    }
+  }
+
+  bool coalesce = true;
+  for (size_t attempt = 1; ; ++attempt) {
+    DCHECK_LE(attempt, kMaxGraphColoringAttemptsDebug)
+        << "Graph coloring register allocation is taking too long to converge";
+
+    // Nodes do not outlive the attempt: use a separate arena for them.
+    ArenaAllocator attempt_allocator(allocator_->GetArenaPool());
+    ColoringIteration iteration(&attempt_allocator,
+                                liveness_,
+                                codegen_->GetGraph(),
+                                processing_core_registers,
+                                number_of_registers,
+                                allocatable,
+                                callee_save,
+                                coalesce);
+    iteration.BuildInterferenceGraph(intervals, physical_intervals);
+    iteration.FindCoalesceOpportunities();
+    iteration.Coalesce();
+    iteration.PruneInterferenceGraph();
+    iteration.ColorInterferenceGraph();
+
+    ArenaVector<InterferenceNode*> nodes(
+        attempt_allocator.Adapter(kArenaAllocRegisterAllocator));
+    iteration.GetColorableNodes(&nodes);
+
+    bool successful = true;
+    bool made_progress = false;
+    for (InterferenceNode* node : nodes) {
+      if (node->HasColor()) {
+        continue;
+      }
+      for (LiveInterval* member : node->GetMembers()) {
+        if (member->IsTemp()) {
+          successful = false;
+        } else if (member->FirstRegisterUse() != kNoLifetime) {
+          successful = false;
+          made_progress |= SplitAtRegisterUses(member);
+        }
+        // Otherwise, the member does not need a register and is simply spilled.
+      }
+    }
+
+    if (!successful) {
+      if (!made_progress) {
+        // Coalescing can tie intervals that would be colorable on their own.
+        // Give up on it for this register kind.
+        CHECK(coalesce) << "Graph coloring register allocation could not find a register";
+        coalesce = false;
+      }
+      continue;
+    }
+
+    // Commit the colors.
+    ArenaVector<size_t> live_registers(safepoints_.size(),
+                                       0u,
+                                       attempt_allocator.Adapter(kArenaAllocRegisterAllocator));
+    for (InterferenceNode* node : nodes) {
+      if (!node->HasColor()) {
+        continue;
+      }
+      int reg = CTZ(node->GetColor());
+      for (LiveInterval* member : node->GetMembers()) {
+        member->SetRegister(reg);
+        if (member->HasHighInterval()) {
+          member->GetHighInterval()->SetRegister(reg + 1);
+        }
+        RecordLiveRegistersAtSafepoints(member, &live_registers);
+      }
+      for (RegisterMask color = node->GetColor(); color != 0; color &= color - 1) {
+        int allocated = CTZ(color);
+        codegen_->AddAllocatedRegister(processing_core_registers
+            ? Location::RegisterLocation(allocated)
+            : Location::FpuRegisterLocation(allocated));
+      }
+    }
+    size_t maximum_live_registers = live_registers.empty()
+        ? 0u
+        : *std::max_element(live_registers.begin(), live_registers.end());
+    if (processing_core_registers) {
+      maximum_number_of_live_core_registers_ = maximum_live_registers;
+    } else {
+      maximum_number_of_live_fp_registers_ = maximum_live_registers;
+    }
+    return;
+  }
+}
+
+void RegisterAllocatorGraphColor::RecordLiveRegistersAtSafepoints(
+    LiveInterval* interval, ArenaVector<size_t>* live_registers) const {
+  size_t number_of_registers = interval->HasHighInterval() ? 2u : 1u;
+  for (SafepointPosition* safepoint = interval->GetFirstSafepoint();
+       safepoint != nullptr;
+       safepoint = safepoint->GetNext()) {
+    size_t position = safepoint->GetPosition();
+    if (!interval->CoversSlow(position) || !safepoint->GetLocations()->OnlyCallsOnSlowPath()) {
+      // Either the safepoint is covered by another sibling, or the registers are
+      // saved by the call itself.
+      continue;
+    }
+    // `safepoints_` is sorted by decreasing lifetime position.
+    auto it = std::lower_bound(safepoints_.begin(),
+                               safepoints_.end(),
+                               position,
+                               [](HInstruction* safepoint_instruction, size_t pos) {
+                                 return safepoint_instruction->GetLifetimePosition() > pos;
+                               });
+    DCHECK(it != safepoints_.end());
+    DCHECK_EQ((*it)->GetLifetimePosition(), position);
+    (*live_registers)[it - safepoints_.begin()] += number_of_registers;
+  }
+}
+
+void RegisterAllocatorGraphColor::BlockRegister(Location location, size_t start, size_t end) {
+  int reg = location.reg();
+  DCHECK(location.IsRegister() || location.IsFpuRegister());
+  LiveInterval* interval = location.IsRegister()
+      ? physical_core_register_intervals_[reg]
+      : physical_fp_register_intervals_[reg];
+  Primitive::Type type = location.IsRegister()
+      ? Primitive::kPrimInt
+      : Primitive::kPrimFloat;
+  if (interval == nullptr) {
+    interval = LiveInterval::MakeFixedInterval(allocator_, reg, type);
+    if (location.IsRegister()) {
+      physical_core_register_intervals_[reg] = interval;
+    } else {
+      physical_fp_register_intervals_[reg] = interval;
+    }
+  }
+  DCHECK(interval->GetRegister() == reg);
+  interval->AddRange(start, end);
+}
+
+void RegisterAllocatorGraphColor::BlockRegisters(size_t start, size_t end, bool caller_save_only) {
+  for (size_t i = 0; i < codegen_->GetNumberOfCoreRegisters(); ++i) {
+    if (!caller_save_only || !codegen_->IsCoreCalleeSaveRegister(i)) {
+      BlockRegister(Location::RegisterLocation(i), start, end);
+    }
+  }
+  for (size_t i = 0; i < codegen_->GetNumberOfFloatingPointRegisters(); ++i) {
+    if (!caller_save_only || !codegen_->IsFloatingPointCalleeSaveRegister(i)) {
+      BlockRegister(Location::FpuRegisterLocation(i), start, end);
+    }
+  }
+}
+
+bool RegisterAllocatorGraphColor::IsCallerSaveRegister(int reg,
+                                                       bool processing_core_registers) const {
+  return processing_core_registers
+      ? !codegen_->IsCoreCalleeSaveRegister(reg)
+      : !codegen_->IsFloatingPointCalleeSaveRegister(reg);
+}
+
+void RegisterAllocatorGraphColor::AllocateSpillSlots() {
+  // Any value with a part outside registers needs a spill slot.
+  ArenaVector<LiveInterval*> spilled(allocator_->Adapter(kArenaAllocRegisterAllocator));
+  for (size_t i = 0; i < liveness_.GetNumberOfSsaValues(); ++i) {
+    LiveInterval* interval = liveness_.GetInstructionFromSsaIndex(i)->GetLiveInterval();
+    for (LiveInterval* sibling = interval;
+         sibling != nullptr;
+         sibling = sibling->GetNextSibling()) {
+      if (!sibling->HasRegister()) {
+        spilled.push_back(interval);
+        break;
+      }
+    }
+  }
+
+  // Slots are handed out in order of interval start, so that a slot can be reused
+  // once the last value in it is dead.
+  std::stable_sort(spilled.begin(), spilled.end(), [](LiveInterval* lhs, LiveInterval* rhs) {
+    return lhs->GetStart() < rhs->GetStart();
+  });
+  for (LiveInterval* interval : spilled) {
+    AllocateSpillSlotFor(interval);
+  }
+}
+
+void RegisterAllocatorGraphColor::AllocateSpillSlotFor(LiveInterval* interval) {
+  DCHECK(interval->IsParent());
+  DCHECK(!interval->IsHighInterval());
+
+  // An instruction gets a spill slot for its entire lifetime.
+  if (interval->HasSpillSlot()) {
+    return;
+  }
+
+  HInstruction* defined_by = interval->GetDefinedBy();
+  DCHECK(!defined_by->IsPhi() || !defined_by->AsPhi()->IsCatchPhi());
+
+  if (defined_by->IsParameterValue()) {
+    // Parameters have their own stack slot.
+    interval->SetSpillSlot(codegen_->GetStackSlotOfParameter(defined_by->AsParameterValue()));
+    return;
+  }
+
+  if (defined_by->IsCurrentMethod()) {
+    interval->SetSpillSlot(0);
+    return;
+  }
+
+  if (defined_by->IsConstant()) {
+    // Constants don't need a spill slot.
+    return;
+  }
+
+  ArenaVector<size_t>* spill_slots = nullptr;
+  switch (interval->GetType()) {
+    case Primitive::kPrimDouble:
+      spill_slots = &double_spill_slots_;
+      break;
+    case Primitive::kPrimLong:
+      spill_slots = &long_spill_slots_;
+      break;
+    case Primitive::kPrimFloat:
+      spill_slots = &float_spill_slots_;
+      break;
+    case Primitive::kPrimNot:
+    case Primitive::kPrimInt:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimShort:
+      spill_slots = &int_spill_slots_;
+      break;
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unexpected type for interval " << interval->GetType();
+  }
+
+  // Find the first run of available spill slots. The run may extend past the
+  // slots allocated so far.
+  size_t number_of_spill_slots_needed = interval->NumberOfSpillSlotsNeeded();
+  size_t slot = 0;
+  for (size_t e = spill_slots->size(); slot < e; ++slot) {
+    bool found = true;
+    for (size_t s = slot, u = std::min(slot + number_of_spill_slots_needed, e); s < u; ++s) {
+      if ((*spill_slots)[s] > interval->GetStart()) {
+        found = false;
+        break;
+      }
+    }
+    if (found) {
+      break;
+    }
+  }
+
+  size_t end = interval->GetLastSibling()->GetEnd();
+  size_t upper = slot + number_of_spill_slots_needed;
+  if (upper > spill_slots->size()) {
+    // We need new spill slots.
+    spill_slots->resize(upper, end);
+  }
+  for (size_t s = slot; s < upper; ++s) {
+    (*spill_slots)[s] = end;
+  }
+
+  // Note that the exact spill slot location will be computed when we resolve,
+  // that is when we know the number of spill slots for each type.
+  interval->SetSpillSlot(slot);
+}
+
+void RegisterAllocatorGraphColor::AllocateSpillSlotForCatchPhi(HPhi* phi) {
+  LiveInterval* interval = phi->GetLiveInterval();
+
+  HInstruction* previous_phi = phi->GetPrevious();
+  DCHECK(previous_phi == nullptr ||
+         previous_phi->AsPhi()->GetRegNumber() <= phi->GetRegNumber())
+      << "Phis expected to be sorted by vreg number, so that equivalent phis are adjacent.";
+
+  if (phi->IsVRegEquivalentOf(previous_phi)) {
+    // This is an equivalent of the previous phi. We need to assign the same
+    // catch phi slot.
+    DCHECK(previous_phi->GetLiveInterval()->HasSpillSlot());
+    interval->SetSpillSlot(previous_phi->GetLiveInterval()->GetSpillSlot());
+  } else {
+    // Allocate a new spill slot for this catch phi.
+    interval->SetSpillSlot(catch_phi_spill_slots_);
+    catch_phi_spill_slots_ += interval->NumberOfSpillSlotsNeeded();
+  }
+}
+
+}  // namespace art
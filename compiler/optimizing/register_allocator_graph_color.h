@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_REGISTER_ALLOCATOR_GRAPH_COLOR_H_
+#define ART_COMPILER_OPTIMIZING_REGISTER_ALLOCATOR_GRAPH_COLOR_H_
+
+#include "arch/instruction_set.h"
+#include "base/arena_containers.h"
+#include "base/macros.h"
+#include "primitive.h"
+#include "register_allocator.h"
+
+namespace art {
+
+class CodeGenerator;
+class HInstruction;
+class HPhi;
+class LiveInterval;
+class Location;
+class SsaLivenessAnalysis;
+
+/**
+ * A graph coloring register allocator, in the style of Chaitin-Briggs.
+ *
+ * The live intervals of one register kind (core or floating point) form the
+ * nodes of an interference graph, together with the fixed intervals of the
+ * physical registers and the intervals whose output register is imposed by the
+ * code generator, which are precolored. Two nodes interfere when their live
+ * ranges intersect. Allocation then proceeds in four steps:
+ *
+ * (1) Coalescing: two nodes connected by a move (a phi and its input, the two
+ *     sides of a split, or an output and the input it must share a register with)
+ *     and that do not interfere are merged, provided the Briggs test proves the
+ *     merged node can still be colored. Moves to precolored nodes are not
+ *     coalesced, but become preferences when picking a color.
+ * (2) Simplification: nodes with fewer neighbors than available registers are
+ *     removed from the graph and pushed on a stack. When only high degree
+ *     nodes remain, the one with the lowest spill weight is pushed optimistically.
+ * (3) Selection: nodes are popped and given a register not used by their
+ *     neighbors, preferably the register of the nodes they have moves with.
+ * (4) Splitting: a node that could not be colored but needs a register is split
+ *     around its register uses, and coloring is attempted again. Parts without
+ *     register uses are simply spilled.
+ *
+ * Compared to linear scan, this allocator looks at the whole method at once,
+ * which removes moves at the cost of compile time, so it is only worth it
+ * ahead of time, for the compiler filters that favor code quality.
+ */
+class RegisterAllocatorGraphColor : public RegisterAllocator {
+ public:
+  RegisterAllocatorGraphColor(ArenaAllocator* allocator,
+                              CodeGenerator* codegen,
+                              const SsaLivenessAnalysis& analysis);
+  ~RegisterAllocatorGraphColor() OVERRIDE {}
+
+  void AllocateRegisters() OVERRIDE;
+
+  bool Validate(bool log_fatal_on_failure) OVERRIDE;
+
+  size_t GetNumberOfSpillSlots() const {
+    return int_spill_slots_.size()
+        + long_spill_slots_.size()
+        + float_spill_slots_.size()
+        + double_spill_slots_.size()
+        + catch_phi_spill_slots_;
+  }
+
+ private:
+  // Collect the live intervals, fixed intervals, temporaries and safepoints of the method.
+  void ProcessInstructions();
+  void ProcessInstruction(HInstruction* instruction);
+
+  // Give precolored intervals their register and slot-defined intervals their stack slot.
+  void CheckForFixedOutput(HInstruction* instruction, LiveInterval* interval);
+
+  // Color the intervals of one register kind. Intervals that fail to get a
+  // register are split around their register uses, until coloring succeeds.
+  void ColorIntervals(bool processing_core_registers);
+
+  // Split `interval` around its register uses, so that the parts in between
+  // can be spilled. Returns whether any split happened.
+  bool SplitAtRegisterUses(LiveInterval* interval);
+
+  // Split `interval` at `position` if it is strictly inside it.
+  static LiveInterval* TrySplit(LiveInterval* interval, size_t position);
+
+  // Update the fixed interval of the register in `location` to cover [start, end).
+  void BlockRegister(Location location, size_t start, size_t end);
+  void BlockRegisters(size_t start, size_t end, bool caller_save_only = false);
+
+  bool IsCallerSaveRegister(int reg, bool processing_core_registers) const;
+
+  // Allocate spill slots to the values that have a part outside registers.
+  void AllocateSpillSlots();
+  void AllocateSpillSlotFor(LiveInterval* interval);
+
+  // Allocate a spill slot for the given catch phi. Will allocate the same slot
+  // for phis which share the same vreg. Must be called in reverse linear order
+  // of lifetime positions and ascending vreg numbers for correctness.
+  void AllocateSpillSlotForCatchPhi(HPhi* phi);
+
+  // Record the number of live registers at the safepoints that call on slow path.
+  void RecordLiveRegistersAtSafepoints(LiveInterval* interval,
+                                       ArenaVector<size_t>* live_registers) const;
+
+  // The intervals to color, from their first sibling that may need a register.
+  ArenaVector<LiveInterval*> core_intervals_;
+  ArenaVector<LiveInterval*> fp_intervals_;
+
+  // Fixed intervals for physical registers. Such intervals cover the positions
+  // where an instruction requires a specific register.
+  ArenaVector<LiveInterval*> physical_core_register_intervals_;
+  ArenaVector<LiveInterval*> physical_fp_register_intervals_;
+
+  // Intervals for temporaries. Such intervals cover the positions
+  // where an instruction requires a temporary.
+  ArenaVector<LiveInterval*> temp_intervals_;
+
+  // Instructions that need a safepoint, in decreasing order of lifetime position.
+  ArenaVector<HInstruction*> safepoints_;
+
+  // The spill slots allocated for live intervals, typed like in the linear scan
+  // allocator. Each entry holds the end position of the last interval in that slot.
+  ArenaVector<size_t> int_spill_slots_;
+  ArenaVector<size_t> long_spill_slots_;
+  ArenaVector<size_t> float_spill_slots_;
+  ArenaVector<size_t> double_spill_slots_;
+
+  // Spill slots allocated to catch phis.
+  size_t catch_phi_spill_slots_;
+
+  // Blocked registers, as decided by the code generator.
+  bool* const blocked_core_registers_;
+  bool* const blocked_fp_registers_;
+
+  // Slots reserved for out arguments.
+  size_t reserved_out_slots_;
+
+  // The maximum live core and FP registers at safepoints.
+  size_t maximum_number_of_live_core_registers_;
+  size_t maximum_number_of_live_fp_registers_;
+
+  DISALLOW_COPY_AND_ASSIGN(RegisterAllocatorGraphColor);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_REGISTER_ALLOCATOR_GRAPH_COLOR_H_
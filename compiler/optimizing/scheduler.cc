@@ -0,0 +1,431 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scheduler.h"
+
+#include "arch/instruction_set_features.h"
+
+#ifdef ART_ENABLE_CODEGEN_arm64
+#include "scheduler_arm64.h"
+#endif
+
+namespace art {
+
+// The side effects `instruction` has for scheduling purposes. Values that are
+// not actual objects, like the interior pointers of HArm64IntermediateAddress,
+// are only valid until the next GC point, and so are their users.
+static SideEffects GetSchedulingSideEffects(HInstruction* instruction) {
+  SideEffects side_effects = instruction->GetSideEffects();
+  for (size_t i = 0, e = instruction->InputCount(); i < e; ++i) {
+    if (!instruction->InputAt(i)->IsActualObject()) {
+      side_effects.Add(SideEffects::DependsOnGC());
+    }
+  }
+  return side_effects;
+}
+
+// Whether `instruction` may leave the method or deoptimize, in which case the
+// memory it observes must stay as it was in the original order.
+static bool MayThrow(HInstruction* instruction) {
+  return instruction->CanThrow() || instruction->NeedsEnvironment();
+}
+
+// Whether `later` must stay after `earlier` for reasons other than data flow.
+static bool HasOrderingDependency(HInstruction* earlier, HInstruction* later) {
+  SideEffects earlier_effects = GetSchedulingSideEffects(earlier);
+  SideEffects later_effects = GetSchedulingSideEffects(later);
+  if (later_effects.MayDependOn(earlier_effects) || earlier_effects.MayDependOn(later_effects)) {
+    return true;
+  }
+  if (earlier_effects.DoesAnyWrite() && later_effects.DoesAnyWrite()) {
+    return true;
+  }
+  // Exceptions must be thrown in order, and with the memory state of the original order.
+  bool earlier_throws = MayThrow(earlier);
+  bool later_throws = MayThrow(later);
+  if (earlier_throws && (later_throws || later_effects.HasSideEffects())) {
+    return true;
+  }
+  return later_throws && earlier_effects.HasSideEffects();
+}
+
+static bool IsUseOf(HInstruction* user, HInstruction* instruction) {
+  for (size_t i = 0, e = user->InputCount(); i < e; ++i) {
+    if (user->InputAt(i) == instruction) {
+      return true;
+    }
+  }
+  return false;
+}
+
+HInstruction* HScheduler::GetGroupEnd(HInstruction* instruction) {
+  HInstruction* end = instruction;
+  for (HInstruction* next = end->GetNext(); next != nullptr; next = end->GetNext()) {
+    if (end->IsCondition()) {
+      // Keep conditions next to the user they may be emitted at, see
+      // PrepareForRegisterAllocation::CanEmitConditionAt.
+      bool emitted_at_next = end->HasOnlyOneNonEnvironmentUse()
+          && end->GetUses().front().GetUser() == next
+          && (next->IsIf()
+              || next->IsDeoptimize()
+              || (next->IsSelect() && next->AsSelect()->GetCondition() == end));
+      if (!emitted_at_next) {
+        break;
+      }
+    } else if (end->IsNullCheck()) {
+      // Keep null checks next to the user that may do them implicitly, see
+      // CodeGenerator::CanMoveNullCheckToUser.
+      if (!IsUseOf(next, end)) {
+        break;
+      }
+    } else {
+      break;
+    }
+    end = next;
+  }
+  return end;
+}
+
+bool HScheduler::IsSchedulingBarrier(HInstruction* instruction) {
+  return instruction->IsControlFlow()
+      || instruction->IsDeoptimize()
+      || instruction->IsSuspendCheck()
+      || instruction->IsInvoke()
+      || instruction->IsMonitorOperation()
+      || instruction->IsMemoryBarrier()
+      || instruction->IsNewInstance()
+      || instruction->IsNewArray()
+      || instruction->IsLoadException()
+      || instruction->IsClearException()
+      || instruction->IsNativeDebugInfo()
+      || instruction->IsParameterValue()
+      || instruction->IsCurrentMethod()
+      || instruction->IsUnresolvedInstanceFieldGet()
+      || instruction->IsUnresolvedInstanceFieldSet()
+      || instruction->IsUnresolvedStaticFieldGet()
+      || instruction->IsUnresolvedStaticFieldSet()
+      || instruction->IsUpdateBranchProfile()
+      || instruction->IsUpdateHotness()
+      || instruction->IsUpdateInlineCache();
+}
+
+HInstruction* HScheduler::FindRegionEnd(HInstruction* first) {
+  for (HInstruction* group = first; group != nullptr;) {
+    HInstruction* group_end = GetGroupEnd(group);
+    for (HInstruction* instruction = group; ; instruction = instruction->GetNext()) {
+      if (IsSchedulingBarrier(instruction)) {
+        return group;
+      }
+      if (instruction == group_end) {
+        break;
+      }
+    }
+    group = group_end->GetNext();
+  }
+  LOG(FATAL) << "Block does not end with control flow";
+  UNREACHABLE();
+}
+
+void HScheduler::BuildNodes(HInstruction* first,
+                            HInstruction* end,
+                            ArenaVector<SchedulingNode*>* nodes) {
+  for (HInstruction* group = first; group != end;) {
+    HInstruction* group_end = GetGroupEnd(group);
+    size_t number_of_instructions = 0;
+    uint32_t latency = 0;
+    uint32_t internal_latency = 0;
+    for (HInstruction* instruction = group; ; instruction = instruction->GetNext()) {
+      latency_visitor_->CalculateLatency(instruction);
+      latency = std::max(latency, latency_visitor_->GetLastVisitedLatency());
+      // Every instruction of the group after the first one takes an issue cycle.
+      internal_latency += latency_visitor_->GetLastVisitedInternalLatency()
+          + (number_of_instructions == 0 ? 0 : 1);
+      ++number_of_instructions;
+      if (instruction == group_end) {
+        break;
+      }
+    }
+    SchedulingNode* node =
+        new (arena_) SchedulingNode(group, number_of_instructions, nodes->size(), arena_);
+    node->SetLatency(latency);
+    node->SetInternalLatency(internal_latency);
+    HInstruction* instruction = group;
+    for (size_t i = 0; i < number_of_instructions; ++i, instruction = instruction->GetNext()) {
+      nodes_by_id_[instruction->GetId()] = node;
+    }
+    nodes->push_back(node);
+    group = group_end->GetNext();
+  }
+}
+
+void HScheduler::AddDependencies(SchedulingNode* earlier, SchedulingNode* later) {
+  bool has_data_dependency = false;
+  bool has_other_dependency = false;
+  HInstruction* later_instruction = later->GetFirstInstruction();
+  for (size_t i = 0; i < later->GetNumberOfInstructions(); ++i) {
+    for (size_t j = 0, e = later_instruction->InputCount(); j < e; ++j) {
+      if (nodes_by_id_[later_instruction->InputAt(j)->GetId()] == earlier) {
+        has_data_dependency = true;
+      }
+    }
+    for (HEnvironment* environment = later_instruction->GetEnvironment();
+         environment != nullptr;
+         environment = environment->GetParent()) {
+      for (size_t j = 0, e = environment->Size(); j < e; ++j) {
+        HInstruction* value = environment->GetInstructionAt(j);
+        if (value != nullptr && nodes_by_id_[value->GetId()] == earlier) {
+          has_other_dependency = true;
+        }
+      }
+    }
+    HInstruction* earlier_instruction = earlier->GetFirstInstruction();
+    for (size_t j = 0; j < earlier->GetNumberOfInstructions(); ++j) {
+      if (HasOrderingDependency(earlier_instruction, later_instruction)) {
+        has_other_dependency = true;
+      }
+      earlier_instruction = earlier_instruction->GetNext();
+    }
+    later_instruction = later_instruction->GetNext();
+  }
+
+  if (has_data_dependency) {
+    earlier->AddDataSuccessor(later);
+  } else if (has_other_dependency) {
+    earlier->AddOtherSuccessor(later);
+  } else {
+    return;
+  }
+  later->SetUnscheduledPredecessors(later->GetUnscheduledPredecessors() + 1);
+}
+
+void HScheduler::BuildDependencies(const ArenaVector<SchedulingNode*>& nodes) {
+  for (size_t i = 1; i < nodes.size(); ++i) {
+    for (size_t j = 0; j < i; ++j) {
+      AddDependencies(nodes[j], nodes[i]);
+    }
+  }
+}
+
+void HScheduler::CalculateCriticalPaths(const ArenaVector<SchedulingNode*>& nodes) {
+  // Dependencies follow the original order, so successors come later in `nodes`.
+  for (auto it = nodes.rbegin(), end = nodes.rend(); it != end; ++it) {
+    SchedulingNode* node = *it;
+    uint32_t critical_path = node->GetLatency();
+    for (SchedulingNode* successor : node->GetDataSuccessors()) {
+      critical_path = std::max(critical_path, node->GetLatency() + successor->GetCriticalPath());
+    }
+    for (SchedulingNode* successor : node->GetOtherSuccessors()) {
+      critical_path = std::max(critical_path, successor->GetCriticalPath());
+    }
+    node->SetCriticalPath(critical_path);
+  }
+}
+
+void HScheduler::ClearNodes(const ArenaVector<SchedulingNode*>& nodes) {
+  for (SchedulingNode* node : nodes) {
+    HInstruction* instruction = node->GetFirstInstruction();
+    for (size_t i = 0; i < node->GetNumberOfInstructions(); ++i) {
+      nodes_by_id_[instruction->GetId()] = nullptr;
+      instruction = instruction->GetNext();
+    }
+  }
+}
+
+// Issue `node` at `cycle`: its data successors cannot start before its result is available.
+static void IssueNode(SchedulingNode* node, uint32_t cycle) {
+  for (SchedulingNode* successor : node->GetDataSuccessors()) {
+    successor->SetEarliestCycle(
+        std::max(successor->GetEarliestCycle(), cycle + node->GetLatency()));
+  }
+}
+
+// Whether `candidate` should be issued at `cycle` rather than `other`.
+static bool IsBetterCandidate(SchedulingNode* candidate, SchedulingNode* other, uint32_t cycle) {
+  bool candidate_ready = candidate->GetEarliestCycle() <= cycle;
+  bool other_ready = other->GetEarliestCycle() <= cycle;
+  if (candidate_ready != other_ready) {
+    return candidate_ready;
+  }
+  if (!candidate_ready && candidate->GetEarliestCycle() != other->GetEarliestCycle()) {
+    // Stall for as little as possible.
+    return candidate->GetEarliestCycle() < other->GetEarliestCycle();
+  }
+  if (candidate->GetCriticalPath() != other->GetCriticalPath()) {
+    return candidate->GetCriticalPath() > other->GetCriticalPath();
+  }
+  return candidate->GetIndex() < other->GetIndex();
+}
+
+void HScheduler::ListSchedule(const ArenaVector<SchedulingNode*>& nodes,
+                              ArenaVector<SchedulingNode*>* schedule) {
+  ArenaVector<SchedulingNode*> candidates(schedule->get_allocator());
+  for (SchedulingNode* node : nodes) {
+    node->SetEarliestCycle(0);
+    if (node->GetUnscheduledPredecessors() == 0) {
+      candidates.push_back(node);
+    }
+  }
+
+  uint32_t cycle = 0;
+  while (!candidates.empty()) {
+    auto best = candidates.begin();
+    for (auto it = candidates.begin() + 1, end = candidates.end(); it != end; ++it) {
+      if (IsBetterCandidate(*it, *best, cycle)) {
+        best = it;
+      }
+    }
+    SchedulingNode* node = *best;
+    candidates.erase(best);
+
+    cycle = std::max(cycle, node->GetEarliestCycle());
+    IssueNode(node, cycle);
+    schedule->push_back(node);
+    for (SchedulingNode* successor : node->GetDataSuccessors()) {
+      successor->DecrementUnscheduledPredecessors();
+      if (successor->GetUnscheduledPredecessors() == 0) {
+        candidates.push_back(successor);
+      }
+    }
+    for (SchedulingNode* successor : node->GetOtherSuccessors()) {
+      successor->DecrementUnscheduledPredecessors();
+      if (successor->GetUnscheduledPredecessors() == 0) {
+        candidates.push_back(successor);
+      }
+    }
+    cycle += 1 + node->GetInternalLatency();
+  }
+  DCHECK_EQ(schedule->size(), nodes.size());
+}
+
+size_t HScheduler::SimulateIssue(const ArenaVector<SchedulingNode*>& order) {
+  for (SchedulingNode* node : order) {
+    node->SetEarliestCycle(0);
+  }
+  uint32_t cycle = 0;
+  uint32_t results_available = 0;
+  for (SchedulingNode* node : order) {
+    cycle = std::max(cycle, node->GetEarliestCycle());
+    IssueNode(node, cycle);
+    if (node->GetDataSuccessors().empty()) {
+      // The result may be used after the region.
+      results_available = std::max(results_available, cycle + node->GetLatency());
+    }
+    cycle += 1 + node->GetInternalLatency();
+  }
+  return std::max(cycle, results_available);
+}
+
+void HScheduler::Reorder(const ArenaVector<SchedulingNode*>& order, HInstruction* cursor) {
+  // Collect the instructions first, as moving them changes their successors.
+  ArenaVector<HInstruction*> instructions(arena_->Adapter(kArenaAllocScheduler));
+  for (SchedulingNode* node : order) {
+    HInstruction* instruction = node->GetFirstInstruction();
+    for (size_t i = 0; i < node->GetNumberOfInstructions(); ++i) {
+      instructions.push_back(instruction);
+      instruction = instruction->GetNext();
+    }
+  }
+  for (HInstruction* instruction : instructions) {
+    instruction->MoveBefore(cursor);
+  }
+}
+
+bool HScheduler::ScheduleRegion(HInstruction* first, HInstruction* end) {
+  ArenaVector<SchedulingNode*> nodes(arena_->Adapter(kArenaAllocScheduler));
+  BuildNodes(first, end, &nodes);
+  bool reordered = false;
+  if (nodes.size() > 1 && nodes.size() <= kMaxRegionSize) {
+    BuildDependencies(nodes);
+    CalculateCriticalPaths(nodes);
+    ArenaVector<SchedulingNode*> schedule(arena_->Adapter(kArenaAllocScheduler));
+    ListSchedule(nodes, &schedule);
+    if (SimulateIssue(schedule) < SimulateIssue(nodes)) {
+      Reorder(schedule, end);
+      reordered = true;
+    }
+  }
+  ClearNodes(nodes);
+  return reordered;
+}
+
+size_t HScheduler::ScheduleBlock(HBasicBlock* block) {
+  nodes_by_id_.resize(graph_->GetCurrentInstructionId(), nullptr);
+  size_t reordered_regions = 0;
+  for (HInstruction* first = block->GetFirstInstruction(); first != nullptr;) {
+    HInstruction* end = FindRegionEnd(first);
+    if (first != end && ScheduleRegion(first, end)) {
+      ++reordered_regions;
+    }
+    first = GetGroupEnd(end)->GetNext();
+  }
+  return reordered_regions;
+}
+
+size_t HScheduler::EstimateCycles(HBasicBlock* block) {
+  nodes_by_id_.resize(graph_->GetCurrentInstructionId(), nullptr);
+  size_t cycles = 0;
+  for (HInstruction* first = block->GetFirstInstruction(); first != nullptr;) {
+    HInstruction* end = FindRegionEnd(first);
+    if (first != end) {
+      ArenaVector<SchedulingNode*> nodes(arena_->Adapter(kArenaAllocScheduler));
+      BuildNodes(first, end, &nodes);
+      BuildDependencies(nodes);
+      cycles += SimulateIssue(nodes);
+      ClearNodes(nodes);
+    }
+    // Barriers issue on their own.
+    HInstruction* end_of_barrier = GetGroupEnd(end);
+    for (HInstruction* instruction = end; ; instruction = instruction->GetNext()) {
+      latency_visitor_->CalculateLatency(instruction);
+      cycles += 1 + latency_visitor_->GetLastVisitedInternalLatency();
+      if (instruction == end_of_barrier) {
+        break;
+      }
+    }
+    first = end_of_barrier->GetNext();
+  }
+  return cycles;
+}
+
+size_t HScheduler::Schedule() {
+  size_t reordered_regions = 0;
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    // The entry block only holds parameters and constants.
+    if (!block->IsEntryBlock()) {
+      reordered_regions += ScheduleBlock(block);
+    }
+  }
+  return reordered_regions;
+}
+
+void HInstructionScheduling::Run() {
+  switch (instruction_set_) {
+#ifdef ART_ENABLE_CODEGEN_arm64
+    case kArm64: {
+      arm64::SchedulingLatencyVisitorARM64 latency_visitor(
+          graph_, *features_->AsArm64InstructionSetFeatures());
+      HScheduler scheduler(graph_, &latency_visitor);
+      MaybeRecordStat(kScheduledRegion, scheduler.Schedule());
+      break;
+    }
+#endif
+    default:
+      break;
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_SCHEDULER_H_
+#define ART_COMPILER_OPTIMIZING_SCHEDULER_H_
+
+#include "arch/instruction_set.h"
+#include "base/arena_containers.h"
+#include "nodes.h"
+#include "optimization.h"
+
+namespace art {
+
+class InstructionSetFeatures;
+
+/**
+ * A node of the scheduling graph. It holds a single instruction, or a group of
+ * consecutive instructions that the code generator needs to keep adjacent, like
+ * a condition and the HIf it is emitted at, or an HNullCheck and the user doing
+ * the implicit null check.
+ */
+class SchedulingNode : public ArenaObject<kArenaAllocScheduler> {
+ public:
+  SchedulingNode(HInstruction* first,
+                 size_t number_of_instructions,
+                 size_t index,
+                 ArenaAllocator* arena)
+      : first_instruction_(first),
+        number_of_instructions_(number_of_instructions),
+        index_(index),
+        latency_(0),
+        internal_latency_(0),
+        critical_path_(0),
+        earliest_cycle_(0),
+        unscheduled_predecessors_(0),
+        data_successors_(arena->Adapter(kArenaAllocScheduler)),
+        other_successors_(arena->Adapter(kArenaAllocScheduler)) {}
+
+  HInstruction* GetFirstInstruction() const { return first_instruction_; }
+  size_t GetNumberOfInstructions() const { return number_of_instructions_; }
+
+  // Position of the node in the original order of its region.
+  size_t GetIndex() const { return index_; }
+
+  // Cycles before the result of the node can be used.
+  uint32_t GetLatency() const { return latency_; }
+  void SetLatency(uint32_t latency) { latency_ = latency; }
+
+  // Cycles spent issuing the node in addition to its first one, for instructions
+  // that expand to several machine instructions.
+  uint32_t GetInternalLatency() const { return internal_latency_; }
+  void SetInternalLatency(uint32_t latency) { internal_latency_ = latency; }
+
+  // The longest latency path from this node to the end of its region.
+  uint32_t GetCriticalPath() const { return critical_path_; }
+  void SetCriticalPath(uint32_t critical_path) { critical_path_ = critical_path; }
+
+  // The first cycle the node can issue at without stalling on its inputs.
+  uint32_t GetEarliestCycle() const { return earliest_cycle_; }
+  void SetEarliestCycle(uint32_t cycle) { earliest_cycle_ = cycle; }
+
+  size_t GetUnscheduledPredecessors() const { return unscheduled_predecessors_; }
+  void SetUnscheduledPredecessors(size_t count) { unscheduled_predecessors_ = count; }
+  void DecrementUnscheduledPredecessors() {
+    DCHECK_NE(unscheduled_predecessors_, 0u);
+    --unscheduled_predecessors_;
+  }
+
+  // Successors using a value computed by this node.
+  const ArenaVector<SchedulingNode*>& GetDataSuccessors() const { return data_successors_; }
+  void AddDataSuccessor(SchedulingNode* node) { data_successors_.push_back(node); }
+
+  // Successors that only need to stay after this node, because of memory,
+  // exceptions or environment uses.
+  const ArenaVector<SchedulingNode*>& GetOtherSuccessors() const { return other_successors_; }
+  void AddOtherSuccessor(SchedulingNode* node) { other_successors_.push_back(node); }
+
+ private:
+  HInstruction* const first_instruction_;
+  const size_t number_of_instructions_;
+  const size_t index_;
+  uint32_t latency_;
+  uint32_t internal_latency_;
+  uint32_t critical_path_;
+  uint32_t earliest_cycle_;
+  size_t unscheduled_predecessors_;
+  ArenaVector<SchedulingNode*> data_successors_;
+  ArenaVector<SchedulingNode*> other_successors_;
+
+  DISALLOW_COPY_AND_ASSIGN(SchedulingNode);
+};
+
+/**
+ * Computes the latencies of instructions for a given core. The default visit
+ * gives every instruction one cycle; backends override the instructions they
+ * know better.
+ */
+class SchedulingLatencyVisitor : public HGraphDelegateVisitor {
+ public:
+  explicit SchedulingLatencyVisitor(HGraph* graph)
+      : HGraphDelegateVisitor(graph),
+        last_visited_latency_(0),
+        last_visited_internal_latency_(0) {}
+
+  void VisitInstruction(HInstruction* instruction ATTRIBUTE_UNUSED) OVERRIDE {
+    last_visited_latency_ = kDefaultLatency;
+    last_visited_internal_latency_ = 0;
+  }
+
+  void CalculateLatency(HInstruction* instruction) {
+    last_visited_latency_ = kDefaultLatency;
+    last_visited_internal_latency_ = 0;
+    instruction->Accept(this);
+  }
+
+  uint32_t GetLastVisitedLatency() const { return last_visited_latency_; }
+  uint32_t GetLastVisitedInternalLatency() const { return last_visited_internal_latency_; }
+
+  static constexpr uint32_t kDefaultLatency = 1;
+
+ protected:
+  uint32_t last_visited_latency_;
+  uint32_t last_visited_internal_latency_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SchedulingLatencyVisitor);
+};
+
+/**
+ * A list scheduler working on one basic block at a time. Instructions that must
+ * not move, like control flow, invokes and suspend checks, split the block into
+ * regions. Within a region, the scheduler builds the dependencies between
+ * instructions from their inputs, their `SideEffects` and whether they can
+ * throw, and then issues instructions top-down: among the instructions whose
+ * dependencies are satisfied, it picks one whose inputs are available at the
+ * current cycle, favoring the longest path to the end of the region.
+ *
+ * The new order is only kept when the latency model estimates it issues in
+ * fewer cycles than the original one.
+ */
+class HScheduler : public ValueObject {
+ public:
+  HScheduler(HGraph* graph, SchedulingLatencyVisitor* latency_visitor)
+      : graph_(graph),
+        arena_(graph->GetArena()),
+        latency_visitor_(latency_visitor),
+        nodes_by_id_(arena_->Adapter(kArenaAllocScheduler)) {}
+
+  // Schedule all blocks of the graph, and return the number of regions that
+  // were reordered.
+  size_t Schedule();
+
+  // Schedule the instructions of `block`, and return the number of regions
+  // that were reordered.
+  size_t ScheduleBlock(HBasicBlock* block);
+
+  // Estimate the number of cycles the instructions of `block` take to issue
+  // in their current order. Used to compare schedules.
+  size_t EstimateCycles(HBasicBlock* block);
+
+  // Regions larger than this are left alone, as building the dependencies is
+  // quadratic in the number of nodes.
+  static constexpr size_t kMaxRegionSize = 256;
+
+ private:
+  // Return the last instruction of the group starting at `instruction`.
+  static HInstruction* GetGroupEnd(HInstruction* instruction);
+
+  // Whether `instruction` must keep its place, splitting the block into regions.
+  static bool IsSchedulingBarrier(HInstruction* instruction);
+
+  // Return the first instruction of the first group at or after `first` that
+  // contains a scheduling barrier.
+  static HInstruction* FindRegionEnd(HInstruction* first);
+
+  // Build the nodes of the region [`first`, `end`), in their original order.
+  void BuildNodes(HInstruction* first, HInstruction* end, ArenaVector<SchedulingNode*>* nodes);
+  void BuildDependencies(const ArenaVector<SchedulingNode*>& nodes);
+  void AddDependencies(SchedulingNode* earlier, SchedulingNode* later);
+  static void CalculateCriticalPaths(const ArenaVector<SchedulingNode*>& nodes);
+  void ClearNodes(const ArenaVector<SchedulingNode*>& nodes);
+
+  // Schedule the region [`first`, `end`), and return whether it was reordered.
+  bool ScheduleRegion(HInstruction* first, HInstruction* end);
+
+  // Append to `schedule` the list schedule of `nodes`.
+  static void ListSchedule(const ArenaVector<SchedulingNode*>& nodes,
+                           ArenaVector<SchedulingNode*>* schedule);
+
+  // Return the cycles needed to issue `order`, a topological order of the region,
+  // until the results used after the region are available.
+  static size_t SimulateIssue(const ArenaVector<SchedulingNode*>& order);
+
+  // Move the instructions of `order` before `cursor`, in that order.
+  void Reorder(const ArenaVector<SchedulingNode*>& order, HInstruction* cursor);
+
+  HGraph* const graph_;
+  ArenaAllocator* const arena_;
+  SchedulingLatencyVisitor* const latency_visitor_;
+
+  // The node of each instruction of the region being scheduled, indexed by instruction id.
+  ArenaVector<SchedulingNode*> nodes_by_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(HScheduler);
+};
+
+/**
+ * Optimization pass scheduling instructions for the latencies of the target core.
+ * Only ARM64 has a latency model for now; it is a no-op for other instruction sets.
+ */
+class HInstructionScheduling : public HOptimization {
+ public:
+  HInstructionScheduling(HGraph* graph,
+                         InstructionSet instruction_set,
+                         const InstructionSetFeatures* features,
+                         OptimizingCompilerStats* stats)
+      : HOptimization(graph, kInstructionSchedulingPassName, stats),
+        instruction_set_(instruction_set),
+        features_(features) {}
+
+  void Run() OVERRIDE;
+
+  static constexpr const char* kInstructionSchedulingPassName = "scheduler";
+
+ private:
+  const InstructionSet instruction_set_;
+  const InstructionSetFeatures* const features_;
+
+  DISALLOW_COPY_AND_ASSIGN(HInstructionScheduling);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_SCHEDULER_H_
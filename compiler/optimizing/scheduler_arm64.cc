@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scheduler_arm64.h"
+
+#include "arch/arm64/instruction_set_features_arm64.h"
+
+namespace art {
+namespace arm64 {
+
+// Latencies of the Cortex-A53, an in-order dual-issue core, as observed with
+// forwarding between dependent instructions.
+const SchedulingLatenciesARM64 SchedulingLatencyVisitorARM64::kCortexA53Latencies = {
+  /* integer_op */ 2,
+  /* data_proc_with_shifter_op */ 3,
+  /* mul_integer */ 6,
+  /* div_integer */ 5,
+  /* floating_point_op */ 5,
+  /* mul_floating_point */ 6,
+  /* div_float */ 15,
+  /* div_double */ 30,
+  /* type_conversion_floating_point_integer */ 5,
+  /* memory_load */ 5,
+  /* memory_store */ 3,
+  /* load_string_internal */ 7,
+  /* call */ 5,
+  /* call_internal */ 10,
+  /* simd_op */ 10,
+  /* simd_mul */ 12,
+};
+
+// Latencies typical of the out-of-order cores (Cortex-A57 and later, Kryo,
+// Denver, Exynos M1). They hide most stalls themselves, so these mostly keep
+// long latency instructions early.
+const SchedulingLatenciesARM64 SchedulingLatencyVisitorARM64::kOutOfOrderLatencies = {
+  /* integer_op */ 1,
+  /* data_proc_with_shifter_op */ 2,
+  /* mul_integer */ 3,
+  /* div_integer */ 8,
+  /* floating_point_op */ 3,
+  /* mul_floating_point */ 4,
+  /* div_float */ 10,
+  /* div_double */ 15,
+  /* type_conversion_floating_point_integer */ 5,
+  /* memory_load */ 4,
+  /* memory_store */ 1,
+  /* load_string_internal */ 5,
+  /* call */ 4,
+  /* call_internal */ 8,
+  /* simd_op */ 3,
+  /* simd_mul */ 5,
+};
+
+// The instruction set features do not keep the CPU variant, but only the
+// variants that may be a Cortex-A53 ("cortex-a53", "generic" and "default")
+// need its errata fixes, which tells them apart from the out-of-order cores.
+SchedulingLatencyVisitorARM64::SchedulingLatencyVisitorARM64(
+    HGraph* graph, const Arm64InstructionSetFeatures& features)
+    : SchedulingLatencyVisitor(graph),
+      latencies_(features.NeedFixCortexA53_835769() ? &kCortexA53Latencies
+                                                     : &kOutOfOrderLatencies) {}
+
+void SchedulingLatencyVisitorARM64::VisitArrayGet(HArrayGet* instruction) {
+  if (!instruction->GetIndex()->IsConstant()) {
+    // Computing the address of the element.
+    last_visited_internal_latency_ = latencies_->data_proc_with_shifter_op;
+  }
+  last_visited_latency_ = latencies_->memory_load;
+}
+
+void SchedulingLatencyVisitorARM64::VisitArrayLength(HArrayLength* instruction ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_->memory_load;
+}
+
+void SchedulingLatencyVisitorARM64::VisitArraySet(HArraySet* instruction) {
+  if (instruction->NeedsTypeCheck()) {
+    last_visited_internal_latency_ = latencies_->call_internal;
+  } else if (instruction->GetComponentType() == Primitive::kPrimNot) {
+    // Marking the card.
+    last_visited_internal_latency_ = latencies_->memory_load + latencies_->integer_op;
+  }
+  last_visited_latency_ = latencies_->memory_store;
+}
+
+void SchedulingLatencyVisitorARM64::VisitBinaryOperation(HBinaryOperation* instruction) {
+  last_visited_latency_ = Primitive::IsFloatingPointType(instruction->GetResultType())
+      ? latencies_->floating_point_op
+      : latencies_->integer_op;
+}
+
+void SchedulingLatencyVisitorARM64::VisitBitwiseNegatedRight(
+    HBitwiseNegatedRight* instruction ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_->integer_op;
+}
+
+void SchedulingLatencyVisitorARM64::VisitBoundsCheck(HBoundsCheck* instruction ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_->integer_op;
+}
+
+void SchedulingLatencyVisitorARM64::VisitCheckCast(HCheckCast* instruction ATTRIBUTE_UNUSED) {
+  // Loading the classes to compare, with a slow path for the rest.
+  last_visited_internal_latency_ = 2 * latencies_->memory_load;
+  last_visited_latency_ = latencies_->integer_op;
+}
+
+void SchedulingLatencyVisitorARM64::VisitClassTableGet(
+    HClassTableGet* instruction ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = latencies_->memory_load;
+  last_visited_latency_ = latencies_->memory_load;
+}
+
+void SchedulingLatencyVisitorARM64::VisitClinitCheck(HClinitCheck* instruction ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = latencies_->memory_load;
+  last_visited_latency_ = latencies_->integer_op;
+}
+
+void SchedulingLatencyVisitorARM64::VisitDiv(HDiv* instruction) {
+  Primitive::Type type = instruction->GetResultType();
+  switch (type) {
+    case Primitive::kPrimFloat:
+      last_visited_latency_ = latencies_->div_float;
+      break;
+    case Primitive::kPrimDouble:
+      last_visited_latency_ = latencies_->div_double;
+      break;
+    default:
+      if (instruction->GetRight()->IsConstant()) {
+        // Divisions by constants are done with multiplications and shifts.
+        last_visited_internal_latency_ = latencies_->mul_integer;
+        last_visited_latency_ = latencies_->data_proc_with_shifter_op;
+      } else {
+        last_visited_latency_ = latencies_->div_integer;
+      }
+      break;
+  }
+}
+
+void SchedulingLatencyVisitorARM64::HandleFieldGet(const FieldInfo& field_info) {
+  if (field_info.IsVolatile()) {
+    // Acquire load, or load followed by a barrier.
+    last_visited_internal_latency_ = latencies_->memory_load;
+  }
+  last_visited_latency_ = latencies_->memory_load;
+}
+
+void SchedulingLatencyVisitorARM64::HandleFieldSet(const FieldInfo& field_info) {
+  if (field_info.GetFieldType() == Primitive::kPrimNot) {
+    // Marking the card.
+    last_visited_internal_latency_ = latencies_->memory_load + latencies_->integer_op;
+  }
+  last_visited_latency_ = latencies_->memory_store;
+}
+
+void SchedulingLatencyVisitorARM64::VisitInstanceFieldGet(HInstanceFieldGet* instruction) {
+  HandleFieldGet(instruction->GetFieldInfo());
+}
+
+void SchedulingLatencyVisitorARM64::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
+  HandleFieldSet(instruction->GetFieldInfo());
+}
+
+void SchedulingLatencyVisitorARM64::VisitInstanceOf(HInstanceOf* instruction ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = 2 * latencies_->memory_load;
+  last_visited_latency_ = latencies_->integer_op;
+}
+
+void SchedulingLatencyVisitorARM64::VisitLoadClass(HLoadClass* instruction ATTRIBUTE_UNUSED) {
+  // Loading from the dex cache, with a slow path when not resolved.
+  last_visited_internal_latency_ = latencies_->memory_load;
+  last_visited_latency_ = latencies_->memory_load;
+}
+
+void SchedulingLatencyVisitorARM64::VisitLoadString(HLoadString* instruction ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = latencies_->load_string_internal;
+  last_visited_latency_ = latencies_->memory_load;
+}
+
+void SchedulingLatencyVisitorARM64::VisitMul(HMul* instruction) {
+  last_visited_latency_ = Primitive::IsFloatingPointType(instruction->GetResultType())
+      ? latencies_->mul_floating_point
+      : latencies_->mul_integer;
+}
+
+void SchedulingLatencyVisitorARM64::VisitMultiplyAccumulate(
+    HMultiplyAccumulate* instruction ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_->mul_integer;
+}
+
+void SchedulingLatencyVisitorARM64::VisitRem(HRem* instruction) {
+  if (Primitive::IsFloatingPointType(instruction->GetResultType())) {
+    // Calls fmod or fmodf.
+    last_visited_internal_latency_ = latencies_->call_internal;
+    last_visited_latency_ = latencies_->call;
+  } else if (instruction->GetRight()->IsConstant()) {
+    last_visited_internal_latency_ = 2 * latencies_->mul_integer;
+    last_visited_latency_ = latencies_->mul_integer;
+  } else {
+    // A division followed by a multiply-subtract.
+    last_visited_internal_latency_ = latencies_->div_integer;
+    last_visited_latency_ = latencies_->mul_integer;
+  }
+}
+
+void SchedulingLatencyVisitorARM64::VisitSelect(HSelect* instruction) {
+  last_visited_latency_ = Primitive::IsFloatingPointType(instruction->GetType())
+      ? latencies_->floating_point_op
+      : latencies_->integer_op;
+}
+
+void SchedulingLatencyVisitorARM64::VisitStaticFieldGet(HStaticFieldGet* instruction) {
+  HandleFieldGet(instruction->GetFieldInfo());
+}
+
+void SchedulingLatencyVisitorARM64::VisitStaticFieldSet(HStaticFieldSet* instruction) {
+  HandleFieldSet(instruction->GetFieldInfo());
+}
+
+void SchedulingLatencyVisitorARM64::VisitTypeConversion(HTypeConversion* instruction) {
+  if (Primitive::IsFloatingPointType(instruction->GetResultType()) ||
+      Primitive::IsFloatingPointType(instruction->GetInputType())) {
+    last_visited_latency_ = latencies_->type_conversion_floating_point_integer;
+  } else {
+    last_visited_latency_ = latencies_->integer_op;
+  }
+}
+
+void SchedulingLatencyVisitorARM64::VisitUnaryOperation(HUnaryOperation* instruction) {
+  last_visited_latency_ = Primitive::IsFloatingPointType(instruction->GetResultType())
+      ? latencies_->floating_point_op
+      : latencies_->integer_op;
+}
+
+void SchedulingLatencyVisitorARM64::VisitVecLoad(HVecLoad* instruction ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = latencies_->integer_op;
+  last_visited_latency_ = latencies_->memory_load;
+}
+
+void SchedulingLatencyVisitorARM64::VisitVecMul(HVecMul* instruction ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_->simd_mul;
+}
+
+void SchedulingLatencyVisitorARM64::VisitVecOperation(HVecOperation* instruction ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_->simd_op;
+}
+
+void SchedulingLatencyVisitorARM64::VisitVecReduce(HVecReduce* instruction ATTRIBUTE_UNUSED) {
+  // An across-lanes reduction followed by a move to a core register.
+  last_visited_internal_latency_ = latencies_->simd_op;
+  last_visited_latency_ = latencies_->type_conversion_floating_point_integer;
+}
+
+void SchedulingLatencyVisitorARM64::VisitVecStore(HVecStore* instruction ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = latencies_->integer_op;
+  last_visited_latency_ = latencies_->memory_store;
+}
+
+void SchedulingLatencyVisitorARM64::VisitArm64DataProcWithShifterOp(
+    HArm64DataProcWithShifterOp* instruction ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_->data_proc_with_shifter_op;
+}
+
+void SchedulingLatencyVisitorARM64::VisitArm64IntermediateAddress(
+    HArm64IntermediateAddress* instruction ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = latencies_->integer_op;
+}
+
+}  // namespace arm64
+}  // namespace art
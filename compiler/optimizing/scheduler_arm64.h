@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_SCHEDULER_ARM64_H_
+#define ART_COMPILER_OPTIMIZING_SCHEDULER_ARM64_H_
+
+#include "scheduler.h"
+
+namespace art {
+
+class Arm64InstructionSetFeatures;
+
+namespace arm64 {
+
+// Latencies, in cycles, of the classes of instructions of an ARM64 core.
+struct SchedulingLatenciesARM64 {
+  uint32_t integer_op;
+  uint32_t data_proc_with_shifter_op;
+  uint32_t mul_integer;
+  uint32_t div_integer;
+  uint32_t floating_point_op;
+  uint32_t mul_floating_point;
+  uint32_t div_float;
+  uint32_t div_double;
+  uint32_t type_conversion_floating_point_integer;
+  uint32_t memory_load;
+  uint32_t memory_store;
+  uint32_t load_string_internal;
+  uint32_t call;
+  uint32_t call_internal;
+  uint32_t simd_op;
+  uint32_t simd_mul;
+};
+
+class SchedulingLatencyVisitorARM64 : public SchedulingLatencyVisitor {
+ public:
+  // The Cortex-A53 issues in order, so it benefits the most from scheduling and
+  // gets its own latencies. Other cores use latencies typical of out-of-order cores.
+  SchedulingLatencyVisitorARM64(HGraph* graph, const Arm64InstructionSetFeatures& features);
+
+  // Whether the latencies are the ones of the in-order Cortex-A53.
+  bool IsInOrderModel() const { return latencies_ == &kCortexA53Latencies; }
+
+  // HInstruction visitors, sorted alphabetically.
+  void VisitArrayGet(HArrayGet* instruction) OVERRIDE;
+  void VisitArrayLength(HArrayLength* instruction) OVERRIDE;
+  void VisitArraySet(HArraySet* instruction) OVERRIDE;
+  void VisitBinaryOperation(HBinaryOperation* instruction) OVERRIDE;
+  void VisitBitwiseNegatedRight(HBitwiseNegatedRight* instruction) OVERRIDE;
+  void VisitBoundsCheck(HBoundsCheck* instruction) OVERRIDE;
+  void VisitCheckCast(HCheckCast* instruction) OVERRIDE;
+  void VisitClassTableGet(HClassTableGet* instruction) OVERRIDE;
+  void VisitClinitCheck(HClinitCheck* instruction) OVERRIDE;
+  void VisitDiv(HDiv* instruction) OVERRIDE;
+  void VisitInstanceFieldGet(HInstanceFieldGet* instruction) OVERRIDE;
+  void VisitInstanceFieldSet(HInstanceFieldSet* instruction) OVERRIDE;
+  void VisitInstanceOf(HInstanceOf* instruction) OVERRIDE;
+  void VisitLoadClass(HLoadClass* instruction) OVERRIDE;
+  void VisitLoadString(HLoadString* instruction) OVERRIDE;
+  void VisitMul(HMul* instruction) OVERRIDE;
+  void VisitMultiplyAccumulate(HMultiplyAccumulate* instruction) OVERRIDE;
+  void VisitRem(HRem* instruction) OVERRIDE;
+  void VisitSelect(HSelect* instruction) OVERRIDE;
+  void VisitStaticFieldGet(HStaticFieldGet* instruction) OVERRIDE;
+  void VisitStaticFieldSet(HStaticFieldSet* instruction) OVERRIDE;
+  void VisitTypeConversion(HTypeConversion* instruction) OVERRIDE;
+  void VisitUnaryOperation(HUnaryOperation* instruction) OVERRIDE;
+  void VisitVecLoad(HVecLoad* instruction) OVERRIDE;
+  void VisitVecMul(HVecMul* instruction) OVERRIDE;
+  void VisitVecOperation(HVecOperation* instruction) OVERRIDE;
+  void VisitVecReduce(HVecReduce* instruction) OVERRIDE;
+  void VisitVecStore(HVecStore* instruction) OVERRIDE;
+
+  void VisitArm64DataProcWithShifterOp(HArm64DataProcWithShifterOp* instruction) OVERRIDE;
+  void VisitArm64IntermediateAddress(HArm64IntermediateAddress* instruction) OVERRIDE;
+
+  static const SchedulingLatenciesARM64 kCortexA53Latencies;
+  static const SchedulingLatenciesARM64 kOutOfOrderLatencies;
+
+ private:
+  void HandleFieldGet(const FieldInfo& field_info);
+  void HandleFieldSet(const FieldInfo& field_info);
+
+  const SchedulingLatenciesARM64* const latencies_;
+
+  DISALLOW_COPY_AND_ASSIGN(SchedulingLatencyVisitorARM64);
+};
+
+}  // namespace arm64
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_SCHEDULER_ARM64_H_
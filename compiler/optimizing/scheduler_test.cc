@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/arena_allocator.h"
+#include "nodes.h"
+#include "optimizing_unit_test.h"
+#include "scheduler.h"
+
+namespace art {
+
+// Latencies of a simple in-order core: loads take a while, the rest does not.
+class TestSchedulingLatencyVisitor : public SchedulingLatencyVisitor {
+ public:
+  explicit TestSchedulingLatencyVisitor(HGraph* graph) : SchedulingLatencyVisitor(graph) {}
+
+  void VisitInstanceFieldGet(HInstanceFieldGet* instruction ATTRIBUTE_UNUSED) OVERRIDE {
+    last_visited_latency_ = kLoadLatency;
+  }
+
+  static constexpr uint32_t kLoadLatency = 4;
+};
+
+/**
+ * Fixture class for the scheduler tests.
+ */
+class SchedulerTest : public CommonCompilerTest {
+ public:
+  SchedulerTest() : pool_(), allocator_(&pool_) {
+    graph_ = CreateGraph(&allocator_);
+  }
+
+  // Builds a graph with a single block between the entry and exit blocks, and
+  // an object and an int parameter. Tests populate the block before its return.
+  void BuildBlock() {
+    entry_ = new (&allocator_) HBasicBlock(graph_);
+    block_ = new (&allocator_) HBasicBlock(graph_);
+    exit_ = new (&allocator_) HBasicBlock(graph_);
+    graph_->AddBlock(entry_);
+    graph_->AddBlock(block_);
+    graph_->AddBlock(exit_);
+    graph_->SetEntryBlock(entry_);
+    graph_->SetExitBlock(exit_);
+    entry_->AddSuccessor(block_);
+    block_->AddSuccessor(exit_);
+
+    object_ = new (&allocator_) HParameterValue(graph_->GetDexFile(), 0, 0, Primitive::kPrimNot);
+    entry_->AddInstruction(object_);
+    int_ = new (&allocator_) HParameterValue(graph_->GetDexFile(), 0, 1, Primitive::kPrimInt);
+    entry_->AddInstruction(int_);
+    entry_->AddInstruction(new (&allocator_) HGoto());
+    block_->AddInstruction(new (&allocator_) HReturnVoid());
+    exit_->AddInstruction(new (&allocator_) HExit());
+  }
+
+  HInstruction* AddFieldGet(Primitive::Type type, size_t offset) {
+    HInstruction* get = new (&allocator_) HInstanceFieldGet(object_,
+                                                            type,
+                                                            MemberOffset(offset),
+                                                            false,
+                                                            kUnknownFieldIndex,
+                                                            kUnknownClassDefIndex,
+                                                            graph_->GetDexFile(),
+                                                            dex_cache_,
+                                                            0);
+    return Add(get);
+  }
+
+  HInstruction* AddFieldSet(HInstruction* value, Primitive::Type type, size_t offset) {
+    HInstruction* set = new (&allocator_) HInstanceFieldSet(object_,
+                                                            value,
+                                                            type,
+                                                            MemberOffset(offset),
+                                                            false,
+                                                            kUnknownFieldIndex,
+                                                            kUnknownClassDefIndex,
+                                                            graph_->GetDexFile(),
+                                                            dex_cache_,
+                                                            0);
+    return Add(set);
+  }
+
+  HInstruction* Add(HInstruction* instruction) {
+    block_->InsertInstructionBefore(instruction, block_->GetLastInstruction());
+    return instruction;
+  }
+
+  // General building fields.
+  ArenaPool pool_;
+  ArenaAllocator allocator_;
+  HGraph* graph_;
+  ScopedNullHandle<mirror::DexCache> dex_cache_;
+
+  HBasicBlock* entry_;
+  HBasicBlock* block_;
+  HBasicBlock* exit_;
+  HInstruction* object_;
+  HInstruction* int_;
+};
+
+TEST_F(SchedulerTest, HoistLoadsAboveUses) {
+  BuildBlock();
+  HInstruction* get1 = AddFieldGet(Primitive::kPrimInt, 8);
+  HInstruction* add1 = Add(new (&allocator_) HAdd(Primitive::kPrimInt, get1, int_));
+  HInstruction* get2 = AddFieldGet(Primitive::kPrimInt, 12);
+  HInstruction* add2 = Add(new (&allocator_) HAdd(Primitive::kPrimInt, get2, int_));
+  HInstruction* add3 = Add(new (&allocator_) HAdd(Primitive::kPrimInt, add1, add2));
+  AddFieldSet(add3, Primitive::kPrimInt, 16);
+
+  TestSchedulingLatencyVisitor latency_visitor(graph_);
+  HScheduler scheduler(graph_, &latency_visitor);
+  size_t cycles_before = scheduler.EstimateCycles(block_);
+  EXPECT_EQ(1u, scheduler.ScheduleBlock(block_));
+  size_t cycles_after = scheduler.EstimateCycles(block_);
+
+  EXPECT_LT(cycles_after, cycles_before);
+  EXPECT_EQ(get2, get1->GetNext());
+  EXPECT_TRUE(get2->StrictlyDominates(add1));
+  EXPECT_TRUE(add1->StrictlyDominates(add3));
+  EXPECT_TRUE(add2->StrictlyDominates(add3));
+}
+
+TEST_F(SchedulerTest, KeepLoadAfterAliasingStore) {
+  BuildBlock();
+  HInstruction* add = Add(new (&allocator_) HAdd(Primitive::kPrimInt, int_, int_));
+  HInstruction* set = AddFieldSet(add, Primitive::kPrimInt, 8);
+  HInstruction* get_int = AddFieldGet(Primitive::kPrimInt, 12);
+  HInstruction* get_long = AddFieldGet(Primitive::kPrimLong, 16);
+  Add(new (&allocator_) HAdd(Primitive::kPrimInt, get_int, int_));
+  HInstruction* add_long = Add(new (&allocator_) HAdd(Primitive::kPrimLong, get_long, get_long));
+  add_long = Add(new (&allocator_) HAdd(Primitive::kPrimLong, add_long, add_long));
+  Add(new (&allocator_) HAdd(Primitive::kPrimLong, add_long, add_long));
+
+  TestSchedulingLatencyVisitor latency_visitor(graph_);
+  HScheduler scheduler(graph_, &latency_visitor);
+  EXPECT_EQ(1u, scheduler.ScheduleBlock(block_));
+
+  // The int load may read what the int store wrote, the long load cannot.
+  EXPECT_TRUE(set->StrictlyDominates(get_int));
+  EXPECT_TRUE(get_long->StrictlyDominates(set));
+  EXPECT_TRUE(add->StrictlyDominates(set));
+}
+
+TEST_F(SchedulerTest, KeepConditionBeforeSelect) {
+  BuildBlock();
+  HInstruction* get1 = AddFieldGet(Primitive::kPrimInt, 8);
+  HInstruction* condition = Add(new (&allocator_) HLessThan(int_, get1));
+  HInstruction* select = Add(new (&allocator_) HSelect(condition, int_, get1, kNoDexPc));
+  HInstruction* get2 = AddFieldGet(Primitive::kPrimInt, 12);
+  Add(new (&allocator_) HAdd(Primitive::kPrimInt, select, get2));
+
+  TestSchedulingLatencyVisitor latency_visitor(graph_);
+  HScheduler scheduler(graph_, &latency_visitor);
+  scheduler.ScheduleBlock(block_);
+
+  EXPECT_TRUE(get2->StrictlyDominates(condition));
+  EXPECT_EQ(select, condition->GetNext());
+}
+
+TEST_F(SchedulerTest, DoNotMoveAcrossBarriers) {
+  BuildBlock();
+  HInstruction* get1 = AddFieldGet(Primitive::kPrimInt, 8);
+  HInstruction* add1 = Add(new (&allocator_) HAdd(Primitive::kPrimInt, get1, int_));
+  HInstruction* barrier = Add(new (&allocator_) HMemoryBarrier(MemBarrierKind::kAnyAny));
+  HInstruction* get2 = AddFieldGet(Primitive::kPrimInt, 12);
+  Add(new (&allocator_) HAdd(Primitive::kPrimInt, get2, add1));
+
+  TestSchedulingLatencyVisitor latency_visitor(graph_);
+  HScheduler scheduler(graph_, &latency_visitor);
+  scheduler.ScheduleBlock(block_);
+
+  EXPECT_EQ(barrier, add1->GetNext());
+  EXPECT_EQ(get2, barrier->GetNext());
+}
+
+}  // namespace art
@@ -522,8 +522,31 @@ bool LiveInterval::SameRegisterKind(Location other) const {
   }
 }
 
-bool LiveInterval::NeedsTwoSpillSlots() const {
-  return type_ == Primitive::kPrimLong || type_ == Primitive::kPrimDouble;
+size_t LiveInterval::NumberOfSpillSlotsNeeded() const {
+  // A vector value is spilled in full, whatever the number of slots of its type.
+  HInstruction* definition = GetParent()->GetDefinedBy();
+  if (definition != nullptr && HVecOperation::ReturnsSIMDValue(definition)) {
+    return HVecOperation::kSIMDNumberOfBytes / kVRegSize;
+  }
+  return (type_ == Primitive::kPrimLong || type_ == Primitive::kPrimDouble) ? 2 : 1;
+}
+
+Location LiveInterval::ToSpillLocation() const {
+  DCHECK(!IsHighInterval());
+  DCHECK(GetParent()->HasSpillSlot());
+  int spill_slot = GetParent()->GetSpillSlot();
+  size_t number_of_spill_slots = NumberOfSpillSlotsNeeded();
+  switch (number_of_spill_slots) {
+    case 1:
+      return Location::StackSlot(spill_slot);
+    case 2:
+      return Location::DoubleStackSlot(spill_slot);
+    case 4:
+      return Location::SIMDStackSlot(spill_slot);
+    default:
+      LOG(FATAL) << "Unexpected number of spill slots " << number_of_spill_slots;
+      UNREACHABLE();
+  }
 }
 
 Location LiveInterval::ToLocation() const {
@@ -547,11 +570,7 @@ Location LiveInterval::ToLocation() const {
     if (defined_by->IsConstant()) {
       return defined_by->GetLocations()->Out();
     } else if (GetParent()->HasSpillSlot()) {
-      if (NeedsTwoSpillSlots()) {
-        return Location::DoubleStackSlot(GetParent()->GetSpillSlot());
-      } else {
-        return Location::StackSlot(GetParent()->GetSpillSlot());
-      }
+      return ToSpillLocation();
     } else {
       return Location();
     }
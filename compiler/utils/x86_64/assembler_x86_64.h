@@ -390,6 +390,10 @@ class X86_64Assembler FINAL : public Assembler {
   void leal(CpuRegister dst, const Address& src);
 
   void movaps(XmmRegister dst, XmmRegister src);
+  void movups(XmmRegister dst, const Address& src);  // Unaligned load.
+  void movups(const Address& dst, XmmRegister src);  // Unaligned store.
+  void movdqu(XmmRegister dst, const Address& src);  // Unaligned load.
+  void movdqu(const Address& dst, XmmRegister src);  // Unaligned store.
 
   void movss(XmmRegister dst, const Address& src);
   void movss(const Address& dst, XmmRegister src);
@@ -425,6 +429,33 @@ class X86_64Assembler FINAL : public Assembler {
   void divsd(XmmRegister dst, XmmRegister src);
   void divsd(XmmRegister dst, const Address& src);
 
+  void addps(XmmRegister dst, XmmRegister src);
+  void subps(XmmRegister dst, XmmRegister src);
+  void mulps(XmmRegister dst, XmmRegister src);
+  void addpd(XmmRegister dst, XmmRegister src);
+  void subpd(XmmRegister dst, XmmRegister src);
+  void mulpd(XmmRegister dst, XmmRegister src);
+
+  void paddb(XmmRegister dst, XmmRegister src);
+  void paddw(XmmRegister dst, XmmRegister src);
+  void paddd(XmmRegister dst, XmmRegister src);
+  void paddq(XmmRegister dst, XmmRegister src);
+  void psubb(XmmRegister dst, XmmRegister src);
+  void psubw(XmmRegister dst, XmmRegister src);
+  void psubd(XmmRegister dst, XmmRegister src);
+  void psubq(XmmRegister dst, XmmRegister src);
+  void pmullw(XmmRegister dst, XmmRegister src);
+  void pmulld(XmmRegister dst, XmmRegister src);  // SSE4.1.
+  void pand(XmmRegister dst, XmmRegister src);
+  void por(XmmRegister dst, XmmRegister src);
+  void pxor(XmmRegister dst, XmmRegister src);
+  void punpcklbw(XmmRegister dst, XmmRegister src);
+  void punpcklwd(XmmRegister dst, XmmRegister src);
+  void punpckldq(XmmRegister dst, XmmRegister src);
+  void punpcklqdq(XmmRegister dst, XmmRegister src);
+
+  void pshufd(XmmRegister dst, XmmRegister src, const Immediate& imm);
+
   void cvtsi2ss(XmmRegister dst, CpuRegister src);  // Note: this is the r/m32 version.
   void cvtsi2ss(XmmRegister dst, CpuRegister src, bool is64bit);
   void cvtsi2ss(XmmRegister dst, const Address& src, bool is64bit);
@@ -317,6 +317,12 @@ NO_RETURN static void Usage(const char* fmt, ...) {
              CompilerOptions::kDefaultInlineMaxCodeUnits);
   UsageError("      Default: %d", CompilerOptions::kDefaultInlineMaxCodeUnits);
   UsageError("");
+  UsageError("  --register-allocation-strategy=(linear-scan|graph-color): the register");
+  UsageError("      allocator used by Optimizing. Graph coloring takes longer to compile, and");
+  UsageError("      produces fewer spills and moves.");
+  UsageError("      Default: graph-color for the speed and everything filters, linear-scan");
+  UsageError("      otherwise.");
+  UsageError("");
   UsageError("  --dump-timing: display a breakdown of where time was spent");
   UsageError("");
   UsageError("  --include-patch-information: Include patching information so the generated code");
@@ -39,6 +39,7 @@ LIBART_COMMON_SRC_FILES := \
   base/timing_logger.cc \
   base/unix_file/fd_file.cc \
   base/unix_file/random_access_file_utils.cc \
+  cha.cc \
   check_jni.cc \
   class_linker.cc \
   class_table.cc \
@@ -52,6 +53,7 @@ LIBART_COMMON_SRC_FILES := \
   elf_file.cc \
   fault_handler.cc \
   gc/allocation_record.cc \
+  gc/allocation_sampler.cc \
   gc/allocator/dlmalloc.cc \
   gc/allocator/rosalloc.cc \
   gc/accounting/bitmap.cc \
@@ -106,6 +108,7 @@ LIBART_COMMON_SRC_FILES := \
   jit/debugger_interface.cc \
   jit/jit.cc \
   jit/jit_code_cache.cc \
+  jit/jit_warm_start_file.cc \
   jit/offline_profiling_info.cc \
   jit/profiling_info.cc \
   jit/profile_saver.cc  \
@@ -221,6 +224,7 @@ LIBART_COMMON_SRC_FILES += \
   entrypoints/quick/quick_field_entrypoints.cc \
   entrypoints/quick/quick_fillarray_entrypoints.cc \
   entrypoints/quick/quick_instrumentation_entrypoints.cc \
+  entrypoints/quick/quick_jit_entrypoints.cc \
   entrypoints/quick/quick_jni_entrypoints.cc \
   entrypoints/quick/quick_lock_entrypoints.cc \
   entrypoints/quick/quick_math_entrypoints.cc \
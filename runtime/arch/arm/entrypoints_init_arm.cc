@@ -105,6 +105,11 @@ void InitEntryPoints(JniEntryPoints* jpoints, QuickEntryPoints* qpoints) {
   qpoints->pReadBarrierMark = artReadBarrierMark;
   qpoints->pReadBarrierSlow = artReadBarrierSlow;
   qpoints->pReadBarrierForRootSlow = artReadBarrierForRootSlow;
+
+  // JIT
+  qpoints->pJitUpdateHotness = artJitUpdateHotness;
+  qpoints->pJitUpdateInlineCache = artJitUpdateInlineCache;
+  qpoints->pJitUpdateBranchProfile = artJitUpdateBranchProfile;
 }
 
 }  // namespace art
@@ -47,7 +47,10 @@ static constexpr bool IsDirectEntrypoint(QuickEntrypointEnum entrypoint) {
       entrypoint == kQuickCmplFloat ||
       entrypoint == kQuickReadBarrierMark ||
       entrypoint == kQuickReadBarrierSlow ||
-      entrypoint == kQuickReadBarrierForRootSlow;
+      entrypoint == kQuickReadBarrierForRootSlow ||
+      entrypoint == kQuickJitUpdateHotness ||
+      entrypoint == kQuickJitUpdateInlineCache ||
+      entrypoint == kQuickJitUpdateBranchProfile;
 }
 
 }  // namespace art
@@ -289,6 +289,16 @@ void InitEntryPoints(JniEntryPoints* jpoints, QuickEntryPoints* qpoints) {
   qpoints->pReadBarrierForRootSlow = artReadBarrierForRootSlow;
   static_assert(IsDirectEntrypoint(kQuickReadBarrierForRootSlow),
                 "Direct C stub not marked direct.");
+
+  // JIT
+  qpoints->pJitUpdateHotness = artJitUpdateHotness;
+  static_assert(IsDirectEntrypoint(kQuickJitUpdateHotness), "Direct C stub not marked direct.");
+  qpoints->pJitUpdateInlineCache = artJitUpdateInlineCache;
+  static_assert(IsDirectEntrypoint(kQuickJitUpdateInlineCache),
+                "Direct C stub not marked direct.");
+  qpoints->pJitUpdateBranchProfile = artJitUpdateBranchProfile;
+  static_assert(IsDirectEntrypoint(kQuickJitUpdateBranchProfile),
+                "Direct C stub not marked direct.");
 };
 
 }  // namespace art
@@ -36,6 +36,11 @@ extern "C" mirror::Object* art_quick_read_barrier_mark(mirror::Object*);
 extern "C" mirror::Object* art_quick_read_barrier_slow(mirror::Object*, mirror::Object*, uint32_t);
 extern "C" mirror::Object* art_quick_read_barrier_for_root_slow(GcRoot<mirror::Object>*);
 
+// JIT entrypoints.
+extern "C" uint32_t art_quick_jit_update_hotness(ArtMethod*, uint32_t);
+extern "C" void art_quick_jit_update_inline_cache(ArtMethod*, uint32_t, mirror::Object*);
+extern "C" void art_quick_jit_update_branch_profile(ArtMethod*, uint32_t, uint32_t);
+
 void InitEntryPoints(JniEntryPoints* jpoints, QuickEntryPoints* qpoints) {
 #if defined(__APPLE__)
   UNUSED(jpoints, qpoints);
@@ -85,6 +90,11 @@ void InitEntryPoints(JniEntryPoints* jpoints, QuickEntryPoints* qpoints) {
   qpoints->pReadBarrierMark = art_quick_read_barrier_mark;
   qpoints->pReadBarrierSlow = art_quick_read_barrier_slow;
   qpoints->pReadBarrierForRootSlow = art_quick_read_barrier_for_root_slow;
+
+  // JIT
+  qpoints->pJitUpdateHotness = art_quick_jit_update_hotness;
+  qpoints->pJitUpdateInlineCache = art_quick_jit_update_inline_cache;
+  qpoints->pJitUpdateBranchProfile = art_quick_jit_update_branch_profile;
 #endif  // __APPLE__
 };
 
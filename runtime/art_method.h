@@ -17,6 +17,7 @@
 #ifndef ART_RUNTIME_ART_METHOD_H_
 #define ART_RUNTIME_ART_METHOD_H_
 
+#include "atomic.h"
 #include "base/bit_utils.h"
 #include "base/casts.h"
 #include "dex_file.h"
@@ -256,6 +257,27 @@ class ArtMethod FINAL {
     access_flags_ = new_access_flags;
   }
 
+  // Set or clear runtime flags of a method which may already be in use. The verifier, native
+  // method registration and the class hierarchy analysis update the flags of a method from
+  // different threads, so they must not read-modify-write `access_flags_` non-atomically.
+  void AddAccessFlags(uint32_t flags) {
+    Atomic<uint32_t>* atomic_flags = reinterpret_cast<Atomic<uint32_t>*>(&access_flags_);
+    uint32_t old_flags;
+    do {
+      old_flags = atomic_flags->LoadRelaxed();
+    } while (!atomic_flags->CompareExchangeWeakSequentiallyConsistent(old_flags,
+                                                                      old_flags | flags));
+  }
+
+  void ClearAccessFlags(uint32_t flags) {
+    Atomic<uint32_t>* atomic_flags = reinterpret_cast<Atomic<uint32_t>*>(&access_flags_);
+    uint32_t old_flags;
+    do {
+      old_flags = atomic_flags->LoadRelaxed();
+    } while (!atomic_flags->CompareExchangeWeakSequentiallyConsistent(old_flags,
+                                                                      old_flags & ~flags));
+  }
+
   // Approximate what kind of method call would be used for this method.
   InvokeType GetInvokeType() SHARED_REQUIRES(Locks::mutator_lock_);
 
@@ -364,7 +386,7 @@ class ArtMethod FINAL {
 
   void SetSkipAccessChecks() {
     DCHECK(!SkipAccessChecks());
-    SetAccessFlags(GetAccessFlags() | kAccSkipAccessChecks);
+    AddAccessFlags(kAccSkipAccessChecks);
   }
 
   // Should this method be run in the interpreter and count locks (e.g., failed structured-
@@ -373,6 +395,20 @@ class ArtMethod FINAL {
     return (GetAccessFlags() & kAccMustCountLocks) != 0;
   }
 
+  // Returns true if no loaded class overrides this virtual method, so that virtual calls to it
+  // can only dispatch to it. Maintained by the ClassHierarchyAnalysis.
+  bool HasSingleImplementation() {
+    return (GetAccessFlags() & kAccSingleImplementation) != 0;
+  }
+
+  void SetHasSingleImplementation(bool single_implementation) {
+    if (single_implementation) {
+      AddAccessFlags(kAccSingleImplementation);
+    } else {
+      ClearAccessFlags(kAccSingleImplementation);
+    }
+  }
+
   // Returns true if this method could be overridden by a default method.
   bool IsOverridableByDefaultMethod() SHARED_REQUIRES(Locks::mutator_lock_);
 
@@ -49,6 +49,7 @@ const char* const ArenaAllocatorStatsImpl<kCount>::kAllocNames[] = {
   "Dominated    ",
   "Instruction  ",
   "InvokeInputs ",
+  "VectorNode   ",
   "PhiInputs    ",
   "LoopInfo     ",
   "LIBackEdges  ",
@@ -68,7 +69,10 @@ const char* const ArenaAllocatorStatsImpl<kCount>::kAllocNames[] = {
   "BCE          ",
   "DCE          ",
   "LSE          ",
+  "EscapeAnalys ",
   "LICM         ",
+  "LoopOpt      ",
+  "Scheduler    ",
   "SsaLiveness  ",
   "SsaPhiElim   ",
   "RefTypeProp  ",
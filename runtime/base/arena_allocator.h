@@ -60,6 +60,7 @@ enum ArenaAllocKind {
   kArenaAllocDominated,
   kArenaAllocInstruction,
   kArenaAllocInvokeInputs,
+  kArenaAllocVectorNode,
   kArenaAllocPhiInputs,
   kArenaAllocLoopInfo,
   kArenaAllocLoopInfoBackEdges,
@@ -79,7 +80,10 @@ enum ArenaAllocKind {
   kArenaAllocBoundsCheckElimination,
   kArenaAllocDCE,
   kArenaAllocLSE,
+  kArenaAllocEscapeAnalysis,
   kArenaAllocLICM,
+  kArenaAllocLoopOptimization,
+  kArenaAllocScheduler,
   kArenaAllocSsaLiveness,
   kArenaAllocSsaPhiElimination,
   kArenaAllocReferenceTypePropagation,
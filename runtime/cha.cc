@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cha.h"
+
+#include "art_method-inl.h"
+#include "jit/jit.h"
+#include "jit/jit_code_cache.h"
+#include "mirror/class-inl.h"
+#include "runtime.h"
+
+namespace art {
+
+void ClassHierarchyAnalysis::UpdateAfterLoadingOf(Handle<mirror::Class> klass,
+                                                  size_t pointer_size) {
+  if (klass->IsInterface()) {
+    // Calls to interface methods are not devirtualized.
+    return;
+  }
+  for (ArtMethod& method : klass->GetDeclaredVirtualMethods(pointer_size)) {
+    if (!method.IsAbstract()) {
+      method.SetHasSingleImplementation(true);
+    }
+  }
+  RemoveOverriddenSingleImplementations(klass.Get(), pointer_size);
+}
+
+void ClassHierarchyAnalysis::RemoveOverriddenSingleImplementations(mirror::Class* klass,
+                                                                   size_t pointer_size) {
+  mirror::Class* super_class = klass->GetSuperClass();
+  if (super_class == nullptr || klass->IsInterface()) {
+    return;
+  }
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  // Methods of the super class which `klass` does not override are the same entry in both
+  // vtables. A method further up the hierarchy which `klass` overrides is also overridden by
+  // the entry of `super_class`, and lost its flag when `super_class` got loaded.
+  int32_t super_vtable_length = super_class->GetVTableLength();
+  DCHECK_LE(super_vtable_length, klass->GetVTableLength());
+  for (int32_t i = 0; i < super_vtable_length; ++i) {
+    ArtMethod* super_method = super_class->GetVTableEntry(i, pointer_size);
+    if (!super_method->HasSingleImplementation() ||
+        klass->GetVTableEntry(i, pointer_size) == super_method) {
+      continue;
+    }
+    super_method->SetHasSingleImplementation(false);
+    if (jit != nullptr) {
+      // Clearing the flag first ensures code committed concurrently either sees the flag
+      // cleared, or is registered as a dependent by the time we look for them.
+      jit->GetCodeCache()->InvalidateSingleImplementationDependents(super_method);
+    }
+  }
+}
+
+}  // namespace art
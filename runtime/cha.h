@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CHA_H_
+#define ART_RUNTIME_CHA_H_
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "handle.h"
+
+namespace art {
+
+namespace mirror {
+  class Class;
+}  // namespace mirror
+
+// Class hierarchy analysis: keeps track of the virtual methods which no loaded class
+// overrides, so that the JIT can devirtualize calls to them. The analysis is incremental,
+// and done by the class linker as classes get linked. A class overriding a method which
+// had a single implementation invalidates the JIT code relying on it.
+class ClassHierarchyAnalysis {
+ public:
+  // Marks the virtual methods `klass` declares as single implementations, and clears the
+  // flag of the methods of its super class it overrides. Called once `klass` is resolved,
+  // before it can have instances.
+  static void UpdateAfterLoadingOf(Handle<mirror::Class> klass, size_t pointer_size)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
+  // Clears the flag of the methods of the super class of `klass` it overrides. Used for the
+  // classes of an app image, which were linked when the image got compiled.
+  static void RemoveOverriddenSingleImplementations(mirror::Class* klass, size_t pointer_size)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(ClassHierarchyAnalysis);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CHA_H_
@@ -40,6 +40,7 @@
 #include "base/time_utils.h"
 #include "base/unix_file/fd_file.h"
 #include "base/value_object.h"
+#include "cha.h"
 #include "class_linker-inl.h"
 #include "class_table-inl.h"
 #include "compiler_callbacks.h"
@@ -1783,6 +1784,10 @@ bool ClassLinker::AddImageSpace(
     if (added_class_table) {
       for (GcRoot<mirror::Class>& root : temp_set) {
         visitor(root.Read());
+        // The image got compiled without the classes loaded since, which may override the
+        // methods of the boot class path.
+        ClassHierarchyAnalysis::RemoveOverriddenSingleImplementations(root.Read(),
+                                                                      image_pointer_size_);
       }
     }
     // forward_dex_cache_arrays is true iff we copied all of the dex cache arrays into the .bss.
@@ -5223,6 +5228,7 @@ bool ClassLinker::LinkClass(Thread* self,
     // Return the new class.
     h_new_class_out->Assign(h_new_class.Get());
   }
+  ClassHierarchyAnalysis::UpdateAfterLoadingOf(*h_new_class_out, image_pointer_size_);
   return true;
 }
 
@@ -97,6 +97,27 @@ extern "C" mirror::Object* artReadBarrierSlow(mirror::Object* ref,
 extern "C" mirror::Object* artReadBarrierForRootSlow(GcRoot<mirror::Object>* root)
     SHARED_REQUIRES(Locks::mutator_lock_) HOT_ATTR;
 
+// JIT profiling entrypoints, called by baseline JIT code in place of the interpreter's
+// profiling. Like the read barrier entrypoints, they are called without a runtime frame and
+// therefore must not suspend.
+//
+// Adds a sample to the hotness counter of `method` on method entry, when `loop_header_dex_pc` is
+// DexFile::kDexNoIndex, or to the counter of the loop on a back edge. Returns whether OSR code
+// can be entered at the loop header.
+extern "C" uint32_t artJitUpdateHotness(ArtMethod* method, uint32_t loop_header_dex_pc)
+    SHARED_REQUIRES(Locks::mutator_lock_);
+
+// Records the class of `receiver` in the inline cache of the virtual or interface call of
+// `caller` at `dex_pc`.
+extern "C" void artJitUpdateInlineCache(ArtMethod* caller,
+                                        uint32_t dex_pc,
+                                        mirror::Object* receiver)
+    SHARED_REQUIRES(Locks::mutator_lock_);
+
+// Records whether the IF of `method` at `dex_pc` jumped to its target.
+extern "C" void artJitUpdateBranchProfile(ArtMethod* method, uint32_t dex_pc, uint32_t taken)
+    SHARED_REQUIRES(Locks::mutator_lock_);
+
 }  // namespace art
 
 #endif  // ART_RUNTIME_ENTRYPOINTS_QUICK_QUICK_ENTRYPOINTS_H_
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "art_method-inl.h"
+#include "debugger.h"
+#include "entrypoints/quick/quick_entrypoints.h"
+#include "jit/jit.h"
+#include "jit/profiling_info.h"
+#include "mirror/object-inl.h"
+#include "runtime.h"
+#include "thread.h"
+
+namespace art {
+
+extern "C" uint32_t artJitUpdateHotness(ArtMethod* method, uint32_t loop_header_dex_pc) {
+  Thread* self = Thread::Current();
+  ScopedAssertNoThreadSuspension ants(self, __FUNCTION__);
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  // Baseline code is only run for methods with a ProfilingInfo, but the ProfilingInfo may have
+  // been collected with the code in the meantime. Creating a new one could suspend.
+  ProfilingInfo* info = method->GetProfilingInfo(sizeof(void*));
+  if ((jit == nullptr) || (info == nullptr)) {
+    return 0u;
+  }
+  if (loop_header_dex_pc == DexFile::kDexNoIndex) {
+    jit->AddSamples(self, method, 1);
+    return 0u;
+  }
+  jit->AddLoopSamples(self, method, loop_header_dex_pc, 1);
+  // Once the OSR code for a hot loop is ready, the baseline code deoptimizes at the loop header
+  // and the interpreter enters the OSR code at its next back edge. The loop cache knows whether
+  // the OSR code is ready, looking it up in the code cache would take its lock at every back edge.
+  LoopCache* loop = info->GetLoopCache(loop_header_dex_pc);
+  if ((loop == nullptr) || !loop->HasOsrCode() || Dbg::IsDebuggerActive()) {
+    return 0u;
+  }
+  return 1u;
+}
+
+extern "C" void artJitUpdateInlineCache(ArtMethod* caller,
+                                        uint32_t dex_pc,
+                                        mirror::Object* receiver) {
+  Thread* self = Thread::Current();
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  if (jit != nullptr) {
+    jit->InvokeVirtualOrInterface(self, receiver, caller, dex_pc, /* callee */ nullptr);
+  }
+}
+
+extern "C" void artJitUpdateBranchProfile(ArtMethod* method, uint32_t dex_pc, uint32_t taken) {
+  ScopedAssertNoThreadSuspension ants(Thread::Current(), __FUNCTION__);
+  ProfilingInfo* info = method->GetProfilingInfo(sizeof(void*));
+  if (info != nullptr) {
+    info->AddBranchInfo(dex_pc, taken != 0);
+  }
+}
+
+}  // namespace art
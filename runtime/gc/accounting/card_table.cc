@@ -90,7 +90,7 @@ CardTable* CardTable::Create(const uint8_t* heap_begin, size_t heap_capacity) {
 }
 
 CardTable::CardTable(MemMap* mem_map, uint8_t* biased_begin, size_t offset)
-    : mem_map_(mem_map), biased_begin_(biased_begin), offset_(offset) {
+    : mem_map_(mem_map), biased_begin_(biased_begin), offset_(offset), use_huge_pages_(false) {
 }
 
 CardTable::~CardTable() {
@@ -106,7 +106,17 @@ void CardTable::ClearSpaceCards(space::ContinuousSpace* space) {
 
 void CardTable::ClearCardTable() {
   static_assert(kCardClean == 0, "kCardClean must be 0");
-  mem_map_->MadviseDontNeedAndZero();
+  if (use_huge_pages_) {
+    // Releasing the pages would split the huge pages backing the table.
+    memset(mem_map_->Begin(), kCardClean, mem_map_->Size());
+  } else {
+    mem_map_->MadviseDontNeedAndZero();
+  }
+}
+
+bool CardTable::AdviseHugePages() {
+  use_huge_pages_ = mem_map_->AdviseHugePages();
+  return use_huge_pages_;
 }
 
 void CardTable::ClearCardRange(uint8_t* start, uint8_t* end) {
@@ -114,6 +124,10 @@ void CardTable::ClearCardRange(uint8_t* start, uint8_t* end) {
     memset(start, 0, end - start);
     return;
   }
+  if (use_huge_pages_) {
+    memset(CardFromAddr(start), kCardClean, CardFromAddr(end) - CardFromAddr(start));
+    return;
+  }
   CHECK_ALIGNED(reinterpret_cast<uintptr_t>(start), kCardSize);
   CHECK_ALIGNED(reinterpret_cast<uintptr_t>(end), kCardSize);
   static_assert(kCardClean == 0, "kCardClean must be 0");
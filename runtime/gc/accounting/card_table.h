@@ -116,6 +116,10 @@ class CardTable {
   // Resets all of the bytes in the card table to clean.
   void ClearCardTable();
 
+  // Back the card table with transparent huge pages, see MemMap::AdviseHugePages. The table is
+  // then cleared in place.
+  bool AdviseHugePages();
+
   // Clear a range of cards that covers start to end, start and end must be aligned to kCardSize.
   void ClearCardRange(uint8_t* start, uint8_t* end);
 
@@ -148,6 +152,9 @@ class CardTable {
   // Card table doesn't begin at the beginning of the mem_map_, instead it is displaced by offset
   // to allow the byte value of biased_begin_ to equal GC_CARD_DIRTY
   const size_t offset_;
+  // Whether the table is backed by transparent huge pages, which are zeroed in place rather than
+  // released.
+  bool use_huge_pages_;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(CardTable);
 };
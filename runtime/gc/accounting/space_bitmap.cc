@@ -53,7 +53,8 @@ SpaceBitmap<kAlignment>::SpaceBitmap(const std::string& name, MemMap* mem_map, u
                                      size_t bitmap_size, const void* heap_begin)
     : mem_map_(mem_map), bitmap_begin_(bitmap_begin), bitmap_size_(bitmap_size),
       heap_begin_(reinterpret_cast<uintptr_t>(heap_begin)),
-      name_(name) {
+      name_(name),
+      use_huge_pages_(false) {
   CHECK(bitmap_begin_ != nullptr);
   CHECK_NE(bitmap_size, 0U);
 }
@@ -97,10 +98,21 @@ std::string SpaceBitmap<kAlignment>::Dump() const {
 template<size_t kAlignment>
 void SpaceBitmap<kAlignment>::Clear() {
   if (bitmap_begin_ != nullptr) {
-    mem_map_->MadviseDontNeedAndZero();
+    if (use_huge_pages_) {
+      // Releasing the pages would split the huge pages backing the bitmap.
+      memset(mem_map_->Begin(), 0, mem_map_->Size());
+    } else {
+      mem_map_->MadviseDontNeedAndZero();
+    }
   }
 }
 
+template<size_t kAlignment>
+bool SpaceBitmap<kAlignment>::AdviseHugePages() {
+  use_huge_pages_ = mem_map_->AdviseHugePages();
+  return use_huge_pages_;
+}
+
 template<size_t kAlignment>
 void SpaceBitmap<kAlignment>::CopyFrom(SpaceBitmap* source_bitmap) {
   DCHECK_EQ(Size(), source_bitmap->Size());
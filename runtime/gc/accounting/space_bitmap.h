@@ -87,6 +87,10 @@ class SpaceBitmap {
   // Fill the bitmap with zeroes.  Returns the bitmap's memory to the system as a side-effect.
   void Clear();
 
+  // Back the bitmap with transparent huge pages, see MemMap::AdviseHugePages. The bitmap is then
+  // cleared in place.
+  bool AdviseHugePages();
+
   bool Test(const mirror::Object* obj) const;
 
   // Return true iff <obj> is within the range of pointers that this bitmap could potentially cover,
@@ -226,6 +230,10 @@ class SpaceBitmap {
 
   // Name of this bitmap.
   std::string name_;
+
+  // Whether the bitmap is backed by transparent huge pages, which are cleared in place rather than
+  // released.
+  bool use_huge_pages_;
 };
 
 typedef SpaceBitmap<kObjectAlignment> ContinuousSpaceBitmap;
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_ACCOUNTING_WORK_STEALING_DEQUE_H_
+#define ART_RUNTIME_GC_ACCOUNTING_WORK_STEALING_DEQUE_H_
+
+#include <memory>
+
+#include "atomic.h"
+#include "base/bit_utils.h"
+#include "base/logging.h"
+#include "base/macros.h"
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+// A bounded Chase-Lev work-stealing deque. The owning thread pushes and pops at the bottom without
+// a lock while any other thread may steal from the top. The capacity is fixed, Push() returns
+// false on overflow and the caller is expected to spill the value somewhere else.
+template <typename T>
+class WorkStealingDeque {
+ public:
+  // Capacity is how many elements we can store in the deque, must be a power of two.
+  explicit WorkStealingDeque(size_t capacity)
+      : capacity_(capacity),
+        buffer_(new Atomic<T*>[capacity]),
+        top_(0),
+        bottom_(0) {
+    CHECK(IsPowerOfTwo(capacity)) << capacity;
+  }
+
+  // Only called by the owner. Returns false if the deque is full.
+  bool Push(T* value) {
+    DCHECK(value != nullptr);
+    const int64_t bottom = bottom_.LoadRelaxed();
+    const int64_t top = top_.LoadAcquire();
+    if (UNLIKELY(static_cast<size_t>(bottom - top) >= capacity_)) {
+      return false;
+    }
+    Slot(bottom)->StoreRelaxed(value);
+    // Publish the value before the new bottom so that a thief which sees the new bottom also sees
+    // the value.
+    QuasiAtomic::ThreadFenceRelease();
+    bottom_.StoreRelaxed(bottom + 1);
+    return true;
+  }
+
+  // Only called by the owner. Returns null if the deque is empty or if we lost the race for the
+  // last element to a thief.
+  T* Pop() {
+    const int64_t bottom = bottom_.LoadRelaxed() - 1;
+    bottom_.StoreRelaxed(bottom);
+    // The store to bottom_ must be visible before we read top_, otherwise both the owner and a
+    // thief could take the last element.
+    QuasiAtomic::ThreadFenceSequentiallyConsistent();
+    const int64_t top = top_.LoadRelaxed();
+    if (top > bottom) {
+      // Empty.
+      bottom_.StoreRelaxed(bottom + 1);
+      return nullptr;
+    }
+    T* value = Slot(bottom)->LoadRelaxed();
+    if (top == bottom) {
+      // Last element, race against the thieves for it.
+      if (!top_.CompareExchangeStrongSequentiallyConsistent(top, top + 1)) {
+        value = nullptr;
+      }
+      bottom_.StoreRelaxed(bottom + 1);
+    }
+    return value;
+  }
+
+  // May be called by any thread. Returns null if the deque is empty or if we lost a race.
+  T* Steal() {
+    const int64_t top = top_.LoadAcquire();
+    QuasiAtomic::ThreadFenceSequentiallyConsistent();
+    const int64_t bottom = bottom_.LoadAcquire();
+    if (top >= bottom) {
+      return nullptr;
+    }
+    T* value = Slot(top)->LoadRelaxed();
+    if (!top_.CompareExchangeStrongSequentiallyConsistent(top, top + 1)) {
+      return nullptr;
+    }
+    return value;
+  }
+
+  // Approximate when called concurrently with Push(), Pop() or Steal().
+  size_t Size() const {
+    const int64_t size = bottom_.LoadRelaxed() - top_.LoadRelaxed();
+    return size > 0 ? static_cast<size_t>(size) : 0u;
+  }
+
+  bool IsEmpty() const {
+    return Size() == 0;
+  }
+
+  size_t Capacity() const {
+    return capacity_;
+  }
+
+  // Only called when no other thread accesses the deque.
+  void Reset() {
+    top_.StoreRelaxed(0);
+    bottom_.StoreRelaxed(0);
+  }
+
+ private:
+  Atomic<T*>* Slot(int64_t index) const {
+    return &buffer_[static_cast<size_t>(index) & (capacity_ - 1)];
+  }
+
+  const size_t capacity_;
+  std::unique_ptr<Atomic<T*>[]> buffer_;
+  // Index of the oldest element, incremented by thieves and by the owner when it takes the last
+  // element.
+  Atomic<int64_t> top_;
+  // Index after the newest element, only written by the owner.
+  Atomic<int64_t> bottom_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingDeque);
+};
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_ACCOUNTING_WORK_STEALING_DEQUE_H_
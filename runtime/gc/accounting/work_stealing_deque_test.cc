@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "work_stealing_deque.h"
+
+#include <vector>
+
+#include "atomic.h"
+#include "common_runtime_test.h"
+#include "thread-inl.h"
+#include "thread_pool.h"
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+class WorkStealingDequeTest : public CommonRuntimeTest {};
+
+// Use fake pointers; the deque never dereferences the values.
+static uintptr_t* ValueAt(size_t i) {
+  return reinterpret_cast<uintptr_t*>((i + 1) * sizeof(uintptr_t));
+}
+
+static size_t IndexOf(uintptr_t* value) {
+  return reinterpret_cast<uintptr_t>(value) / sizeof(uintptr_t) - 1;
+}
+
+TEST_F(WorkStealingDequeTest, PushPop) {
+  WorkStealingDeque<uintptr_t> deque(16);
+  EXPECT_TRUE(deque.IsEmpty());
+  EXPECT_TRUE(deque.Pop() == nullptr);
+  EXPECT_TRUE(deque.Steal() == nullptr);
+  for (size_t i = 0; i < deque.Capacity(); ++i) {
+    EXPECT_TRUE(deque.Push(ValueAt(i)));
+  }
+  EXPECT_EQ(deque.Size(), deque.Capacity());
+  // Full.
+  EXPECT_FALSE(deque.Push(ValueAt(deque.Capacity())));
+  // The owner pops in LIFO order, thieves steal in FIFO order.
+  EXPECT_EQ(deque.Pop(), ValueAt(15));
+  EXPECT_EQ(deque.Steal(), ValueAt(0));
+  EXPECT_EQ(deque.Steal(), ValueAt(1));
+  EXPECT_EQ(deque.Pop(), ValueAt(14));
+  EXPECT_EQ(deque.Size(), 12u);
+  // Wrap around the ring buffer.
+  EXPECT_TRUE(deque.Push(ValueAt(100)));
+  EXPECT_TRUE(deque.Push(ValueAt(101)));
+  EXPECT_EQ(deque.Pop(), ValueAt(101));
+  EXPECT_EQ(deque.Pop(), ValueAt(100));
+  while (deque.Pop() != nullptr) {
+  }
+  EXPECT_TRUE(deque.IsEmpty());
+}
+
+class StealTask : public Task {
+ public:
+  StealTask(WorkStealingDeque<uintptr_t>* deque,
+            std::vector<AtomicInteger>* seen,
+            AtomicInteger* remaining)
+      : deque_(deque), seen_(seen), remaining_(remaining) {}
+
+  void Run(Thread* self ATTRIBUTE_UNUSED) {
+    while (remaining_->LoadSequentiallyConsistent() > 0) {
+      uintptr_t* value = deque_->Steal();
+      if (value != nullptr) {
+        (*seen_)[IndexOf(value)].FetchAndAddSequentiallyConsistent(1);
+        remaining_->FetchAndSubSequentiallyConsistent(1);
+      }
+    }
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  WorkStealingDeque<uintptr_t>* const deque_;
+  std::vector<AtomicInteger>* const seen_;
+  AtomicInteger* const remaining_;
+};
+
+// Check that every pushed value is taken exactly once when the owner races with thieves.
+TEST_F(WorkStealingDequeTest, ConcurrentSteal) {
+  static constexpr size_t kNumThieves = 4;
+  static constexpr size_t kNumValues = 256 * KB;
+  Thread* self = Thread::Current();
+  ThreadPool thread_pool("Work stealing deque test thread pool", kNumThieves);
+  WorkStealingDeque<uintptr_t> deque(1 * KB);
+  std::vector<AtomicInteger> seen(kNumValues);
+  AtomicInteger remaining(kNumValues);
+  for (size_t i = 0; i < kNumThieves; ++i) {
+    thread_pool.AddTask(self, new StealTask(&deque, &seen, &remaining));
+  }
+  thread_pool.StartWorkers(self);
+  size_t next = 0;
+  while (next < kNumValues) {
+    // Push a batch and pop some of it back, leaving the rest for the thieves.
+    while (next < kNumValues && deque.Push(ValueAt(next))) {
+      ++next;
+    }
+    for (size_t i = 0; i < deque.Capacity() / 4; ++i) {
+      uintptr_t* value = deque.Pop();
+      if (value == nullptr) {
+        break;
+      }
+      seen[IndexOf(value)].FetchAndAddSequentiallyConsistent(1);
+      remaining.FetchAndSubSequentiallyConsistent(1);
+    }
+  }
+  thread_pool.Wait(self, false, false);
+  thread_pool.StopWorkers(self);
+  EXPECT_EQ(remaining.LoadSequentiallyConsistent(), 0);
+  EXPECT_TRUE(deque.IsEmpty());
+  for (size_t i = 0; i < kNumValues; ++i) {
+    ASSERT_EQ(seen[i].LoadSequentiallyConsistent(), 1) << i;
+  }
+}
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,482 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allocation_sampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "art_method-inl.h"
+#include "base/time_utils.h"
+#include "base/unix_file/fd_file.h"
+#include "gc/heap.h"
+#include "handle_scope-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/object-inl.h"
+#include "os.h"
+#include "runtime.h"
+#include "scoped_thread_state_change.h"
+#include "stack.h"
+#include "thread_list.h"
+#include "utils.h"
+
+namespace art {
+namespace gc {
+
+// The number of call sites printed on SIGQUIT.
+static constexpr size_t kNumSigQuitCallSites = 10;
+
+class AllocationSampleStackVisitor : public StackVisitor {
+ public:
+  AllocationSampleStackVisitor(Thread* thread, AllocRecordStackTrace* trace_out)
+      SHARED_REQUIRES(Locks::mutator_lock_)
+      : StackVisitor(thread, nullptr, StackVisitor::StackWalkKind::kIncludeInlinedFramesNoResolve),
+        trace_(trace_out) {}
+
+  bool VisitFrame() OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+    if (trace_->GetDepth() >= AllocationSampler::kMaxStackDepth) {
+      return false;
+    }
+    ArtMethod* m = GetMethod();
+    // m may be null if we have inlined methods of unresolved classes. b/27858645
+    if (m != nullptr && !m->IsRuntimeMethod()) {
+      m = m->GetInterfaceMethodIfProxy(sizeof(void*));
+      trace_->AddStackElement(AllocRecordStackTraceElement(m, GetDexPc()));
+    }
+    return true;
+  }
+
+ private:
+  AllocRecordStackTrace* const trace_;
+};
+
+void AllocationSampler::SetSamplingEnabled(bool enabled, size_t sampling_interval) {
+  if (enabled) {
+    CHECK_GT(sampling_interval, 0u);
+  }
+  // The threads must not allocate while their countdowns and TLAB ends change.
+  if (Runtime::Current()->IsStarted()) {
+    ScopedSuspendAll ssa(__FUNCTION__);
+    SetSamplingEnabledSuspended(enabled, sampling_interval);
+  } else {
+    SetSamplingEnabledSuspended(enabled, sampling_interval);
+  }
+}
+
+void AllocationSampler::SetSamplingEnabledSuspended(bool enabled, size_t sampling_interval) {
+  Thread* self = Thread::Current();
+  Runtime* runtime = Runtime::Current();
+  Heap* heap = runtime->GetHeap();
+  MutexLock mu(self, *Locks::alloc_tracker_lock_);
+  if (heap->IsAllocSamplingEnabled() == enabled) {
+    return;  // Already enabled or disabled, bail.
+  }
+  AllocationSampler* sampler = heap->GetAllocationSampler();
+  if (enabled) {
+    if (sampler == nullptr) {
+      sampler = new AllocationSampler(sampling_interval);
+      heap->SetAllocationSampler(sampler);
+    } else {
+      // Start a new profile.
+      sampler->sampling_interval_ = sampling_interval;
+      sampler->Clear();
+    }
+    LOG(INFO) << "Enabling allocation sampling every " << PrettySize(sampling_interval)
+              << " on average";
+  } else {
+    // Keep the samples so that the profile can still be dumped.
+    LOG(INFO) << "Disabling allocation sampling";
+  }
+  heap->SetAllocSamplingEnabled(enabled);
+  MutexLock mu2(self, *Locks::thread_list_lock_);
+  for (Thread* thread : runtime->GetThreadList()->GetList()) {
+    if (enabled) {
+      // Drop the countdowns left from a previous sampling, they may use another interval.
+      thread->SetBytesUntilAllocSample(sampler->NextSampleInterval());
+    } else {
+      thread->ClearBytesUntilAllocSample();
+    }
+  }
+}
+
+void AllocationSampler::InitThread(Thread* thread) {
+  Heap* heap = Runtime::Current()->GetHeap();
+  if (heap == nullptr) {
+    return;
+  }
+  MutexLock mu(Thread::Current(), *Locks::alloc_tracker_lock_);
+  if (heap->IsAllocSamplingEnabled()) {
+    thread->SetBytesUntilAllocSample(heap->GetAllocationSampler()->NextSampleInterval());
+  }
+}
+
+AllocationSampler::AllocationSampler(size_t sampling_interval)
+    : sampling_interval_(sampling_interval),
+      rng_(NanoTime()),
+      total_samples_(0),
+      dropped_samples_(0),
+      start_time_ns_(NanoTime()) {}
+
+size_t AllocationSampler::NextSampleInterval() {
+  std::exponential_distribution<double> distribution(1.0 / sampling_interval_);
+  return std::max(static_cast<size_t>(distribution(rng_)), static_cast<size_t>(1));
+}
+
+double AllocationSampler::SampleWeight(size_t byte_count, size_t sampling_interval) {
+  // An allocation of byte_count bytes is sampled with probability 1 - exp(-byte_count / interval).
+  return 1.0 /
+      -std::expm1(-static_cast<double>(byte_count) / static_cast<double>(sampling_interval));
+}
+
+void AllocationSampler::SampleAllocation(Thread* self,
+                                         mirror::Object** obj,
+                                         size_t byte_count,
+                                         ssize_t bytes_until_sample) {
+  DCHECK_LE(bytes_until_sample, 0);
+  size_t num_samples = 1;
+  {
+    MutexLock mu(self, *Locks::alloc_tracker_lock_);
+    // Draw the next interval before walking the stack so that allocations during the stack walk
+    // do not take samples themselves.
+    bytes_until_sample += NextSampleInterval();
+    while (bytes_until_sample <= 0) {
+      ++num_samples;
+      bytes_until_sample += NextSampleInterval();
+    }
+    self->SetBytesUntilAllocSample(bytes_until_sample);
+  }
+
+  // Get stack trace outside of lock in case there are allocations during the stack walk.
+  // b/27858645.
+  CallSite site;
+  AllocationSampleStackVisitor visitor(self, /*out*/ &site.trace);
+  {
+    StackHandleScope<1> hs(self);
+    auto obj_wrapper = hs.NewHandleWrapper(obj);
+    visitor.WalkStack();
+  }
+  std::string storage;
+  site.class_descriptor = (*obj)->GetClass()->GetDescriptor(&storage);
+
+  MutexLock mu(self, *Locks::alloc_tracker_lock_);
+  if (!Runtime::Current()->GetHeap()->IsAllocSamplingEnabled()) {
+    // The sampling was disabled during the stack walk, bail.
+    return;
+  }
+  total_samples_ += num_samples;
+  auto it = call_sites_.find(site);
+  if (it == call_sites_.end()) {
+    if (call_sites_.size() >= kMaxCallSites) {
+      dropped_samples_ += num_samples;
+      return;
+    }
+    it = call_sites_.emplace(std::move(site), CallSiteStats()).first;
+  }
+  const double weight = SampleWeight(byte_count, sampling_interval_) * num_samples;
+  CallSiteStats& stats = it->second;
+  stats.samples += num_samples;
+  stats.estimated_objects += weight;
+  stats.estimated_bytes += weight * byte_count;
+}
+
+void AllocationSampler::VisitRoots(RootVisitor* visitor) {
+  BufferedRootVisitor<kDefaultBufferedRootCount> buffered_visitor(visitor, RootInfo(kRootDebugger));
+  for (const auto& pair : call_sites_) {
+    const AllocRecordStackTrace& trace = pair.first.trace;
+    for (size_t i = 0, depth = trace.GetDepth(); i < depth; ++i) {
+      trace.GetStackElement(i).GetMethod()->VisitRoots(buffered_visitor, sizeof(void*));
+    }
+  }
+}
+
+void AllocationSampler::Clear() {
+  call_sites_.clear();
+  total_samples_ = 0;
+  dropped_samples_ = 0;
+  start_time_ns_ = NanoTime();
+}
+
+// A minimal encoder for the protocol buffer wire format, enough to write profile.proto.
+class ProtoBuffer {
+ public:
+  void AddVarint(uint32_t field, uint64_t value) {
+    AddTag(field, kWireTypeVarint);
+    AddRawVarint(value);
+  }
+
+  void AddString(uint32_t field, const std::string& value) {
+    AddTag(field, kWireTypeLengthDelimited);
+    AddRawVarint(value.size());
+    data_ += value;
+  }
+
+  void AddMessage(uint32_t field, const ProtoBuffer& message) {
+    AddString(field, message.data_);
+  }
+
+  void AddPackedVarints(uint32_t field, const std::vector<uint64_t>& values) {
+    ProtoBuffer packed;
+    for (uint64_t value : values) {
+      packed.AddRawVarint(value);
+    }
+    AddString(field, packed.data_);
+  }
+
+  const std::string& GetData() const {
+    return data_;
+  }
+
+ private:
+  static constexpr uint32_t kWireTypeVarint = 0;
+  static constexpr uint32_t kWireTypeLengthDelimited = 2;
+
+  void AddTag(uint32_t field, uint32_t wire_type) {
+    AddRawVarint((field << 3) | wire_type);
+  }
+
+  void AddRawVarint(uint64_t value) {
+    while (value >= 0x80) {
+      data_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    data_.push_back(static_cast<char>(value));
+  }
+
+  std::string data_;
+};
+
+// Builds the string table of a profile, index 0 is the empty string.
+class ProfileStringTable {
+ public:
+  ProfileStringTable() {
+    Intern("");
+  }
+
+  uint64_t Intern(const std::string& str) {
+    auto it = indices_.find(str);
+    if (it != indices_.end()) {
+      return it->second;
+    }
+    const uint64_t index = strings_.size();
+    strings_.push_back(str);
+    indices_.emplace(str, index);
+    return index;
+  }
+
+  const std::vector<std::string>& GetStrings() const {
+    return strings_;
+  }
+
+ private:
+  std::vector<std::string> strings_;
+  std::unordered_map<std::string, uint64_t> indices_;
+};
+
+// Field numbers of profile.proto.
+enum PprofField : uint32_t {
+  kPprofProfileSampleType = 1,
+  kPprofProfileSample = 2,
+  kPprofProfileLocation = 4,
+  kPprofProfileFunction = 5,
+  kPprofProfileStringTable = 6,
+  kPprofProfileDurationNanos = 10,
+  kPprofProfilePeriodType = 11,
+  kPprofProfilePeriod = 12,
+  kPprofValueTypeType = 1,
+  kPprofValueTypeUnit = 2,
+  kPprofSampleLocationId = 1,
+  kPprofSampleValue = 2,
+  kPprofSampleLabel = 3,
+  kPprofLabelKey = 1,
+  kPprofLabelStr = 2,
+  kPprofLocationId = 1,
+  kPprofLocationLine = 4,
+  kPprofLineFunctionId = 1,
+  kPprofLineLine = 2,
+  kPprofFunctionId = 1,
+  kPprofFunctionName = 2,
+  kPprofFunctionSystemName = 3,
+  kPprofFunctionFilename = 4,
+};
+
+static ProtoBuffer PprofValueType(ProfileStringTable* strings,
+                                  const std::string& type,
+                                  const std::string& unit) {
+  ProtoBuffer value_type;
+  value_type.AddVarint(kPprofValueTypeType, strings->Intern(type));
+  value_type.AddVarint(kPprofValueTypeUnit, strings->Intern(unit));
+  return value_type;
+}
+
+static uint64_t EstimateToValue(double estimate) {
+  return static_cast<uint64_t>(std::llround(estimate));
+}
+
+bool AllocationSampler::DumpPprof(const std::string& filename, std::string* error_msg) {
+  Thread* self = Thread::Current();
+  std::vector<std::pair<CallSite, CallSiteStats>> call_sites;
+  size_t sampling_interval;
+  uint64_t duration_ns;
+  {
+    MutexLock mu(self, *Locks::alloc_tracker_lock_);
+    call_sites.reserve(call_sites_.size());
+    for (const auto& pair : call_sites_) {
+      call_sites.emplace_back(pair.first, pair.second);
+    }
+    sampling_interval = sampling_interval_;
+    duration_ns = NanoTime() - start_time_ns_;
+  }
+
+  ProfileStringTable strings;
+  ProtoBuffer profile;
+  profile.AddMessage(kPprofProfileSampleType, PprofValueType(&strings, "alloc_objects", "count"));
+  profile.AddMessage(kPprofProfileSampleType, PprofValueType(&strings, "alloc_space", "bytes"));
+  profile.AddMessage(kPprofProfilePeriodType, PprofValueType(&strings, "space", "bytes"));
+  profile.AddVarint(kPprofProfilePeriod, sampling_interval);
+  profile.AddVarint(kPprofProfileDurationNanos, duration_ns);
+
+  // Locations and functions are shared between the samples, ids start at 1.
+  std::unordered_map<AllocRecordStackTraceElement, uint64_t, HashAllocRecordTypes> location_ids;
+  std::unordered_map<ArtMethod*, uint64_t> function_ids;
+  const uint64_t class_label_key = strings.Intern("object class");
+  for (const auto& pair : call_sites) {
+    const AllocRecordStackTrace& trace = pair.first.trace;
+    std::vector<uint64_t> sample_location_ids;
+    for (size_t i = 0, depth = trace.GetDepth(); i < depth; ++i) {
+      const AllocRecordStackTraceElement& element = trace.GetStackElement(i);
+      auto location_it = location_ids.find(element);
+      if (location_it == location_ids.end()) {
+        ArtMethod* method = element.GetMethod();
+        auto function_it = function_ids.find(method);
+        if (function_it == function_ids.end()) {
+          const uint64_t function_id = function_ids.size() + 1;
+          function_it = function_ids.emplace(method, function_id).first;
+          const char* source_file = method->GetDeclaringClassSourceFile();
+          ProtoBuffer function;
+          function.AddVarint(kPprofFunctionId, function_id);
+          function.AddVarint(kPprofFunctionName, strings.Intern(PrettyMethod(method)));
+          function.AddVarint(kPprofFunctionSystemName, strings.Intern(PrettyMethod(method)));
+          function.AddVarint(kPprofFunctionFilename,
+                             strings.Intern(source_file != nullptr ? source_file : ""));
+          profile.AddMessage(kPprofProfileFunction, function);
+        }
+        const uint64_t location_id = location_ids.size() + 1;
+        location_it = location_ids.emplace(element, location_id).first;
+        ProtoBuffer line;
+        line.AddVarint(kPprofLineFunctionId, function_it->second);
+        line.AddVarint(kPprofLineLine, std::max(element.ComputeLineNumber(), 0));
+        ProtoBuffer location;
+        location.AddVarint(kPprofLocationId, location_id);
+        location.AddMessage(kPprofLocationLine, line);
+        profile.AddMessage(kPprofProfileLocation, location);
+      }
+      sample_location_ids.push_back(location_it->second);
+    }
+    const CallSiteStats& stats = pair.second;
+    ProtoBuffer label;
+    label.AddVarint(kPprofLabelKey, class_label_key);
+    const std::string class_name = PrettyDescriptor(pair.first.class_descriptor.c_str());
+    label.AddVarint(kPprofLabelStr, strings.Intern(class_name));
+    ProtoBuffer sample;
+    sample.AddPackedVarints(kPprofSampleLocationId, sample_location_ids);
+    sample.AddPackedVarints(kPprofSampleValue, { EstimateToValue(stats.estimated_objects),
+                                                 EstimateToValue(stats.estimated_bytes) });
+    sample.AddMessage(kPprofSampleLabel, label);
+    profile.AddMessage(kPprofProfileSample, sample);
+  }
+  for (const std::string& str : strings.GetStrings()) {
+    profile.AddString(kPprofProfileStringTable, str);
+  }
+
+  std::unique_ptr<File> file(OS::CreateEmptyFileWriteOnly(filename.c_str()));
+  if (file == nullptr) {
+    *error_msg = StringPrintf("Unable to open allocation profile '%s': %s",
+                              filename.c_str(),
+                              strerror(errno));
+    return false;
+  }
+  const std::string& data = profile.GetData();
+  if (!file->WriteFully(data.data(), data.size())) {
+    *error_msg = StringPrintf("Unable to write allocation profile '%s': %s",
+                              filename.c_str(),
+                              strerror(errno));
+    file->Erase();
+    return false;
+  }
+  if (file->FlushCloseOrErase() != 0) {
+    *error_msg = StringPrintf("Unable to close allocation profile '%s': %s",
+                              filename.c_str(),
+                              strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+void AllocationSampler::DumpForSigQuit(std::ostream& os) {
+  Thread* self = Thread::Current();
+  std::vector<std::pair<CallSite, CallSiteStats>> call_sites;
+  size_t sampling_interval;
+  size_t total_samples;
+  size_t dropped_samples;
+  {
+    MutexLock mu(self, *Locks::alloc_tracker_lock_);
+    call_sites.reserve(call_sites_.size());
+    for (const auto& pair : call_sites_) {
+      call_sites.emplace_back(pair.first, pair.second);
+    }
+    sampling_interval = sampling_interval_;
+    total_samples = total_samples_;
+    dropped_samples = dropped_samples_;
+  }
+  os << "Allocation sampling: " << total_samples << " samples every "
+     << PrettySize(sampling_interval) << " on average at " << call_sites.size() << " call sites";
+  if (dropped_samples != 0) {
+    os << ", " << dropped_samples << " samples of new call sites dropped";
+  }
+  os << "\n";
+  using CallSiteEntry = std::pair<CallSite, CallSiteStats>;
+  std::vector<const CallSiteEntry*> sorted_call_sites;
+  for (const CallSiteEntry& entry : call_sites) {
+    sorted_call_sites.push_back(&entry);
+  }
+  const size_t num_printed = std::min(sorted_call_sites.size(), kNumSigQuitCallSites);
+  std::partial_sort(sorted_call_sites.begin(),
+                    sorted_call_sites.begin() + num_printed,
+                    sorted_call_sites.end(),
+                    [](const CallSiteEntry* a, const CallSiteEntry* b) {
+                      return a->second.estimated_bytes > b->second.estimated_bytes;
+                    });
+  for (size_t i = 0; i < num_printed; ++i) {
+    const CallSite& site = sorted_call_sites[i]->first;
+    const CallSiteStats& stats = sorted_call_sites[i]->second;
+    os << "  ~" << PrettySize(EstimateToValue(stats.estimated_bytes)) << " in ~"
+       << EstimateToValue(stats.estimated_objects) << " "
+       << PrettyDescriptor(site.class_descriptor.c_str()) << " at ";
+    if (site.trace.GetDepth() == 0) {
+      os << "<no managed frames>";
+    } else {
+      const AllocRecordStackTraceElement& element = site.trace.GetStackElement(0);
+      os << PrettyMethod(element.GetMethod()) << ":" << element.ComputeLineNumber();
+    }
+    os << "\n";
+  }
+}
+
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_ALLOCATION_SAMPLER_H_
+#define ART_RUNTIME_GC_ALLOCATION_SAMPLER_H_
+
+#include <iosfwd>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "base/mutex.h"
+#include "gc/allocation_record.h"
+#include "object_callbacks.h"
+#include "thread.h"
+
+namespace art {
+
+namespace mirror {
+  class Object;
+}
+
+namespace gc {
+
+// A low overhead alternative to the allocation tracker. Instead of recording every allocation, it
+// takes a sample on average every sampling interval bytes allocated by a thread, capturing a
+// bounded stack. The samples are aggregated by call site and allocated class and can be dumped in
+// the pprof profile.proto format. The gaps between samples are drawn from an exponential
+// distribution so that the samples form a Poisson process over the allocated bytes, which lets
+// the dump estimate the total number of objects and bytes allocated at each call site.
+class AllocationSampler {
+ public:
+  static constexpr size_t kDefaultSamplingInterval = 512 * KB;
+  // The maximum number of frames captured per sample.
+  static constexpr size_t kMaxStackDepth = 32;
+  // Samples from new call sites are dropped once this many call sites have been seen.
+  static constexpr size_t kMaxCallSites = 64 * KB;
+
+  // Enables or disables the sampling. Enabling starts a new countdown in every thread. The
+  // allocation entry points are not instrumented: a thread's TLAB ends at its next sample point so
+  // that the compiled code fast path calls into the runtime there.
+  static void SetSamplingEnabled(bool enabled, size_t sampling_interval)
+      REQUIRES(!Locks::alloc_tracker_lock_, !Locks::thread_list_lock_);
+
+  // Starts the countdown of a thread attaching while sampling is enabled.
+  static void InitThread(Thread* thread) REQUIRES(!Locks::alloc_tracker_lock_);
+
+  explicit AllocationSampler(size_t sampling_interval);
+
+  // Called for every allocation which goes through the runtime while sampling is enabled. Bump
+  // pointer allocations from the TLAB are counted by its position, which the compiled code fast
+  // path advances too. Other allocations are counted by the bytes the heap counts for them. For
+  // the RosAlloc thread-local runs, which the compiled code also allocates from, these are the
+  // bytes of the whole run when it is refilled, so their samples are taken at run granularity.
+  void MaybeSampleAllocation(Thread* self,
+                             mirror::Object** obj,
+                             size_t byte_count,
+                             size_t bytes_tl_bulk_allocated)
+      REQUIRES(!Locks::alloc_tracker_lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_) {
+    const uint8_t* address = reinterpret_cast<const uint8_t*>(*obj);
+    ssize_t bytes_until_sample = self->GetBytesUntilAllocSample();
+    if (address >= self->GetTlabStart() && address < self->GetTlabPos()) {
+      // The TLAB position already counts the allocation.
+      if (LIKELY(bytes_until_sample > 0)) {
+        return;
+      }
+    } else {
+      bytes_until_sample -= static_cast<ssize_t>(bytes_tl_bulk_allocated);
+      if (LIKELY(bytes_until_sample > 0)) {
+        self->SetBytesUntilAllocSample(bytes_until_sample);
+        return;
+      }
+      if (bytes_tl_bulk_allocated > byte_count) {
+        // A thread-local run refill, which may span several sample points.
+        SampleAllocation(self, obj, byte_count, bytes_until_sample);
+        return;
+      }
+    }
+    SampleAllocation(self, obj, byte_count, 0);
+  }
+
+  size_t GetSamplingInterval() const REQUIRES(Locks::alloc_tracker_lock_) {
+    return sampling_interval_;
+  }
+
+  // Keeps the methods in the sampled stacks from being unloaded.
+  void VisitRoots(RootVisitor* visitor)
+      SHARED_REQUIRES(Locks::mutator_lock_)
+      REQUIRES(Locks::alloc_tracker_lock_);
+
+  // Writes the aggregated samples to the file in the pprof profile.proto format.
+  bool DumpPprof(const std::string& filename, std::string* error_msg)
+      REQUIRES(!Locks::alloc_tracker_lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
+  // Prints a summary and the call sites with the most estimated allocated bytes.
+  void DumpForSigQuit(std::ostream& os)
+      REQUIRES(!Locks::alloc_tracker_lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
+  void Clear() REQUIRES(Locks::alloc_tracker_lock_);
+
+ private:
+  struct CallSite {
+    AllocRecordStackTrace trace;
+    std::string class_descriptor;
+
+    bool operator==(const CallSite& other) const {
+      return class_descriptor == other.class_descriptor && trace == other.trace;
+    }
+  };
+
+  struct HashCallSite {
+    size_t operator()(const CallSite& site) const {
+      return HashAllocRecordTypes()(site.trace) * AllocRecordStackTrace::kHashMultiplier +
+          std::hash<std::string>()(site.class_descriptor);
+    }
+  };
+
+  struct CallSiteStats {
+    size_t samples = 0;
+    // Estimates of the number of objects and bytes allocated at the call site, each sample
+    // weighted by the inverse of the probability that an allocation of its size is sampled.
+    double estimated_objects = 0.0;
+    double estimated_bytes = 0.0;
+  };
+
+  using CallSiteMap = std::unordered_map<CallSite, CallSiteStats, HashCallSite>;
+
+  // Slow path of MaybeSampleAllocation, for the allocation that reaches the sample point. Bulk
+  // allocations pass how far past the sample point they went, and take a sample for each further
+  // sample point they cover.
+  void SampleAllocation(Thread* self,
+                        mirror::Object** obj,
+                        size_t byte_count,
+                        ssize_t bytes_until_sample)
+      REQUIRES(!Locks::alloc_tracker_lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
+  // SetSamplingEnabled() once the other threads are suspended.
+  static void SetSamplingEnabledSuspended(bool enabled, size_t sampling_interval)
+      REQUIRES(!Locks::alloc_tracker_lock_, !Locks::thread_list_lock_);
+
+  size_t NextSampleInterval() REQUIRES(Locks::alloc_tracker_lock_);
+
+  // Returns the weight of a sample of `byte_count` bytes, the inverse of the probability that such
+  // an allocation is sampled.
+  static double SampleWeight(size_t byte_count, size_t sampling_interval);
+
+  size_t sampling_interval_ GUARDED_BY(Locks::alloc_tracker_lock_);
+  std::mt19937_64 rng_ GUARDED_BY(Locks::alloc_tracker_lock_);
+  CallSiteMap call_sites_ GUARDED_BY(Locks::alloc_tracker_lock_);
+  size_t total_samples_ GUARDED_BY(Locks::alloc_tracker_lock_);
+  size_t dropped_samples_ GUARDED_BY(Locks::alloc_tracker_lock_);
+  uint64_t start_time_ns_ GUARDED_BY(Locks::alloc_tracker_lock_);
+
+  friend class AllocationSamplerTest;
+
+  DISALLOW_COPY_AND_ASSIGN(AllocationSampler);
+};
+
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_ALLOCATION_SAMPLER_H_
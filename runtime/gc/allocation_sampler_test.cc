@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allocation_sampler.h"
+
+#include <cmath>
+
+#include "common_runtime_test.h"
+#include "gc/heap.h"
+#include "mirror/array-inl.h"
+#include "scoped_thread_state_change.h"
+#include "utils.h"
+
+namespace art {
+namespace gc {
+
+class AllocationSamplerTest : public CommonRuntimeTest {
+ protected:
+  void TearDown() OVERRIDE {
+    AllocationSampler::SetSamplingEnabled(false, 0);
+    CommonRuntimeTest::TearDown();
+  }
+
+  static AllocationSampler* GetSampler() {
+    MutexLock mu(Thread::Current(), *Locks::alloc_tracker_lock_);
+    return Runtime::Current()->GetHeap()->GetAllocationSampler();
+  }
+
+  static size_t NextSampleInterval(AllocationSampler* sampler) {
+    MutexLock mu(Thread::Current(), *Locks::alloc_tracker_lock_);
+    return sampler->NextSampleInterval();
+  }
+
+  static size_t GetTotalSamples(AllocationSampler* sampler) {
+    MutexLock mu(Thread::Current(), *Locks::alloc_tracker_lock_);
+    return sampler->total_samples_;
+  }
+
+  static size_t GetNumberOfCallSites(AllocationSampler* sampler) {
+    MutexLock mu(Thread::Current(), *Locks::alloc_tracker_lock_);
+    return sampler->call_sites_.size();
+  }
+
+  static double SampleWeight(size_t byte_count, size_t sampling_interval) {
+    return AllocationSampler::SampleWeight(byte_count, sampling_interval);
+  }
+
+  // Allocates `total_bytes` in int arrays of `array_bytes` bytes.
+  static void AllocateIntArrays(size_t total_bytes, size_t array_bytes) {
+    Thread* self = Thread::Current();
+    ScopedObjectAccess soa(self);
+    const size_t length = (array_bytes - mirror::Array::DataOffset(sizeof(int32_t)).SizeValue()) /
+        sizeof(int32_t);
+    for (size_t allocated = 0; allocated < total_bytes; allocated += array_bytes) {
+      ASSERT_TRUE(mirror::IntArray::Alloc(self, length) != nullptr);
+    }
+  }
+};
+
+// Reads the fields of a protocol buffer message.
+class ProtoReader {
+ public:
+  explicit ProtoReader(const std::string& data) : data_(data), offset_(0) {}
+
+  bool IsAtEnd() const {
+    return offset_ == data_.size();
+  }
+
+  bool ReadVarint(uint64_t* value) {
+    *value = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+      if (offset_ == data_.size()) {
+        return false;
+      }
+      const uint8_t byte = static_cast<uint8_t>(data_[offset_++]);
+      *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Reads the next field, setting `value` for varints and `bytes` for length delimited fields.
+  bool ReadField(uint32_t* field, uint64_t* value, std::string* bytes) {
+    uint64_t tag;
+    if (!ReadVarint(&tag)) {
+      return false;
+    }
+    *field = static_cast<uint32_t>(tag >> 3);
+    switch (tag & 7) {
+      case 0:
+        return ReadVarint(value);
+      case 2: {
+        uint64_t length;
+        if (!ReadVarint(&length) || data_.size() - offset_ < length) {
+          return false;
+        }
+        bytes->assign(data_, offset_, length);
+        offset_ += length;
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+
+ private:
+  const std::string data_;
+  size_t offset_;
+};
+
+TEST_F(AllocationSamplerTest, SampleIntervalsAreExponential) {
+  static constexpr size_t kInterval = 4 * KB;
+  static constexpr size_t kNumIntervals = 100000;
+  AllocationSampler sampler(kInterval);
+  double sum = 0.0;
+  size_t below_mean = 0;
+  for (size_t i = 0; i < kNumIntervals; ++i) {
+    const size_t interval = NextSampleInterval(&sampler);
+    ASSERT_GT(interval, 0u);
+    sum += interval;
+    if (interval < kInterval) {
+      ++below_mean;
+    }
+  }
+  EXPECT_NEAR(sum / kNumIntervals, kInterval, kInterval * 0.02);
+  // P(X < mean) is 1 - 1/e for an exponential distribution.
+  EXPECT_NEAR(static_cast<double>(below_mean) / kNumIntervals, 1.0 - std::exp(-1.0), 0.01);
+}
+
+TEST_F(AllocationSamplerTest, SampleWeights) {
+  // Allocations much larger than the interval are always sampled.
+  EXPECT_NEAR(SampleWeight(64 * KB, 1 * KB), 1.0, 1e-9);
+  EXPECT_NEAR(SampleWeight(1 * KB, 1 * KB), 1.0 / (1.0 - std::exp(-1.0)), 1e-9);
+  // Small allocations stand for about interval / size allocations.
+  EXPECT_NEAR(SampleWeight(16, 512 * KB), 512.0 * KB / 16, 1.0);
+}
+
+TEST_F(AllocationSamplerTest, SamplesEveryIntervalOnAverage) {
+  static constexpr size_t kInterval = 32 * KB;
+  static constexpr size_t kTotalBytes = 8 * MB;
+  AllocationSampler::SetSamplingEnabled(true, kInterval);
+  AllocationSampler* sampler = GetSampler();
+  ASSERT_TRUE(sampler != nullptr);
+  AllocateIntArrays(kTotalBytes, 64);
+  // About 256 samples, the bounds are more than four standard deviations away.
+  const size_t samples = GetTotalSamples(sampler);
+  EXPECT_GE(samples, 180u);
+  EXPECT_LE(samples, 330u);
+}
+
+TEST_F(AllocationSamplerTest, ReenablingStartsNewCountdowns) {
+  AllocationSampler::SetSamplingEnabled(true, 1 * GB);
+  Thread* self = Thread::Current();
+  EXPECT_GT(self->GetBytesUntilAllocSample(), 0);
+  AllocationSampler::SetSamplingEnabled(false, 0);
+  // A small interval must take effect right away, not after the countdown of the large one.
+  AllocationSampler::SetSamplingEnabled(true, 64);
+  EXPECT_LT(self->GetBytesUntilAllocSample(), static_cast<ssize_t>(64 * KB));
+  AllocateIntArrays(256 * KB, 64);
+  EXPECT_GT(GetTotalSamples(GetSampler()), 0u);
+}
+
+TEST_F(AllocationSamplerTest, DumpPprof) {
+  static constexpr size_t kInterval = 4 * KB;
+  AllocationSampler::SetSamplingEnabled(true, kInterval);
+  AllocateIntArrays(1 * MB, 128);
+  AllocationSampler* sampler = GetSampler();
+  ASSERT_GT(GetTotalSamples(sampler), 0u);
+
+  ScratchFile file;
+  std::string error_msg;
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    ASSERT_TRUE(sampler->DumpPprof(file.GetFilename(), &error_msg)) << error_msg;
+  }
+  std::string data;
+  ASSERT_TRUE(ReadFileToString(file.GetFilename(), &data));
+
+  // The fields of profile.proto used by the dump.
+  static constexpr uint32_t kSampleType = 1;
+  static constexpr uint32_t kSample = 2;
+  static constexpr uint32_t kStringTable = 6;
+  static constexpr uint32_t kPeriod = 12;
+  static constexpr uint32_t kSampleValue = 2;
+  ProtoReader profile(data);
+  std::vector<std::string> strings;
+  size_t num_sample_types = 0;
+  size_t num_samples = 0;
+  uint64_t estimated_bytes = 0;
+  uint64_t period = 0;
+  while (!profile.IsAtEnd()) {
+    uint32_t field;
+    uint64_t value;
+    std::string bytes;
+    ASSERT_TRUE(profile.ReadField(&field, &value, &bytes));
+    if (field == kSampleType) {
+      ++num_sample_types;
+    } else if (field == kStringTable) {
+      strings.push_back(bytes);
+    } else if (field == kPeriod) {
+      period = value;
+    } else if (field == kSample) {
+      ++num_samples;
+      ProtoReader sample(bytes);
+      while (!sample.IsAtEnd()) {
+        ASSERT_TRUE(sample.ReadField(&field, &value, &bytes));
+        if (field == kSampleValue) {
+          // The packed estimates of the objects and bytes allocated.
+          ProtoReader values(bytes);
+          uint64_t objects;
+          uint64_t site_bytes;
+          ASSERT_TRUE(values.ReadVarint(&objects));
+          ASSERT_TRUE(values.ReadVarint(&site_bytes));
+          ASSERT_TRUE(values.IsAtEnd());
+          estimated_bytes += site_bytes;
+        }
+      }
+    }
+  }
+  EXPECT_EQ(num_sample_types, 2u);
+  EXPECT_EQ(period, kInterval);
+  EXPECT_EQ(num_samples, GetNumberOfCallSites(sampler));
+  ASSERT_FALSE(strings.empty());
+  EXPECT_EQ(strings[0], "");
+  EXPECT_NE(std::find(strings.begin(), strings.end(), "alloc_space"), strings.end());
+  EXPECT_NE(std::find(strings.begin(), strings.end(), "int[]"), strings.end());
+  // The test allocated 1MB, about 256 samples.
+  EXPECT_GE(estimated_bytes, 1 * MB / 2);
+  EXPECT_LE(estimated_bytes, 2 * MB);
+}
+
+}  // namespace gc
+}  // namespace art
@@ -100,12 +100,19 @@ inline void* RosAlloc::AllocFromThreadLocalRun(Thread* self, size_t size,
 }
 
 inline size_t RosAlloc::MaxBytesBulkAllocatedFor(size_t size) {
-  if (UNLIKELY(!IsSizeForThreadLocal(size))) {
+  if (UNLIKELY(size > kLargeSizeThreshold)) {
     return size;
   }
   size_t bracket_size;
   size_t idx = SizeToIndexAndBracketSize(size, &bracket_size);
-  return numOfSlots[idx] * bracket_size;
+  if (IsSizeForThreadLocal(size)) {
+    return numOfSlots[idx] * bracket_size;
+  }
+  if (use_magazines_) {
+    // A magazine refill accounts for all the slots it takes.
+    return MagazineCapacity(idx) * bracket_size;
+  }
+  return bracket_size;
 }
 
 inline void* RosAlloc::Run::AllocSlot() {
@@ -26,9 +26,11 @@
 #include "thread-inl.h"
 #include "thread_list.h"
 
+#include <algorithm>
 #include <map>
 #include <list>
 #include <sstream>
+#include <unordered_set>
 #include <vector>
 
 namespace art {
@@ -57,7 +59,8 @@ RosAlloc::RosAlloc(void* base, size_t capacity, size_t max_capacity,
       bulk_free_lock_("rosalloc bulk free lock", kRosAllocBulkFreeLock),
       page_release_mode_(page_release_mode),
       page_release_size_threshold_(page_release_size_threshold),
-      is_running_on_memory_tool_(running_on_memory_tool) {
+      is_running_on_memory_tool_(running_on_memory_tool),
+      use_magazines_(true), use_huge_pages_(false) {
   DCHECK_ALIGNED(base, kPageSize);
   DCHECK_EQ(RoundUp(capacity, kPageSize), capacity);
   DCHECK_EQ(RoundUp(max_capacity, kPageSize), max_capacity);
@@ -595,10 +598,37 @@ RosAlloc::Run* RosAlloc::RefillRun(Thread* self, size_t idx) {
     bt->erase(it);
     return non_full_run;
   }
+  // If there's none, sweep the lowest address run left to the allocator by a bulk free.
+  auto* const runs_to_sweep = &runs_to_sweep_[idx];
+  if (kUseLazySweep && !runs_to_sweep->empty()) {
+    Run* run_to_sweep = *runs_to_sweep->begin();
+    FinishLazySweep(run_to_sweep);
+    if (kIsDebugBuild) {
+      full_runs_[idx].erase(run_to_sweep);
+    }
+    DCHECK(!run_to_sweep->IsFull());
+    DCHECK(!run_to_sweep->IsThreadLocal());
+    return run_to_sweep;
+  }
   // If there's none, allocate a new run and use it as the current run.
   return AllocRun(self, idx);
 }
 
+void RosAlloc::FinishLazySweep(Run* run) {
+  const size_t idx = run->size_bracket_idx_;
+  DCHECK(!run->IsThreadLocal());
+  DCHECK(!run->IsLazyFreeListEmpty());
+  DCHECK(run->IsFull());
+  DCHECK_NE(run, current_runs_[idx]);
+  run->MergeLazyFreeListToFreeList();
+  const size_t num_erased = runs_to_sweep_[idx].erase(run);
+  DCHECK_EQ(num_erased, 1U);
+  if (kTraceRosAlloc) {
+    LOG(INFO) << "RosAlloc::FinishLazySweep() : Swept run 0x" << std::hex
+              << reinterpret_cast<intptr_t>(run);
+  }
+}
+
 inline void* RosAlloc::AllocFromCurrentRunUnlocked(Thread* self, size_t idx) {
   Run* current_run = current_runs_[idx];
   DCHECK(current_run != nullptr);
@@ -741,6 +771,17 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated,
     *bytes_allocated = bracket_size;
     *usable_size = bracket_size;
   } else {
+    ThreadMagazines* magazines = reinterpret_cast<ThreadMagazines*>(self->GetRosAllocMagazines());
+    if (use_magazines_ && (magazines == nullptr || magazines->owner == this)) {
+      // Use a magazine.
+      slot_addr = AllocFromMagazine(self, idx, magazines, bytes_tl_bulk_allocated);
+      if (LIKELY(slot_addr != nullptr)) {
+        *bytes_allocated = bracket_size;
+        *usable_size = bracket_size;
+      }
+      // Caller verifies that it is all 0.
+      return slot_addr;
+    }
     // Use the (shared) current run.
     MutexLock mu(self, *size_bracket_locks_[idx]);
     slot_addr = AllocFromCurrentRunUnlocked(self, idx);
@@ -760,14 +801,59 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated,
   return slot_addr;
 }
 
+void* RosAlloc::AllocFromMagazine(Thread* self, size_t idx, ThreadMagazines* magazines,
+                                  size_t* bytes_tl_bulk_allocated) {
+  DCHECK_GE(idx, kNumThreadLocalSizeBrackets);
+  if (UNLIKELY(magazines == nullptr)) {
+    magazines = new ThreadMagazines(this);
+    self->SetRosAllocMagazines(magazines);
+  }
+  DCHECK_EQ(magazines->owner, this);
+  Magazine* magazine = &magazines->magazines[idx - kNumThreadLocalSizeBrackets];
+  if (LIKELY(magazine->num_slots != 0)) {
+    // The slot is already counted. Leave it as is.
+    *bytes_tl_bulk_allocated = 0;
+    return magazine->slots[--magazine->num_slots];
+  }
+  // The magazine is empty. Refill it with a single acquisition of the size bracket lock.
+  const size_t capacity = MagazineCapacity(idx);
+  {
+    MutexLock mu(self, *size_bracket_locks_[idx]);
+    while (magazine->num_slots < capacity) {
+      void* slot_addr = AllocFromCurrentRunUnlocked(self, idx);
+      if (slot_addr == nullptr) {
+        break;
+      }
+      magazine->slots[magazine->num_slots++] = slot_addr;
+    }
+  }
+  if (UNLIKELY(magazine->num_slots == 0)) {
+    return nullptr;
+  }
+  // Hand out the slots in the order they came off the free list.
+  std::reverse(magazine->slots, magazine->slots + magazine->num_slots);
+  // Account for all the slots in the refilled magazine.
+  *bytes_tl_bulk_allocated = magazine->num_slots * bracketSizes[idx];
+  if (kTraceRosAlloc) {
+    LOG(INFO) << "RosAlloc::AllocFromMagazine() : Refilled the magazine of bracket " << idx
+              << " with " << magazine->num_slots << " slots";
+  }
+  return magazine->slots[--magazine->num_slots];
+}
+
 size_t RosAlloc::FreeFromRun(Thread* self, void* ptr, Run* run) {
+  MutexLock brackets_mu(self, *size_bracket_locks_[run->size_bracket_idx_]);
+  return FreeFromRunLocked(self, ptr, run);
+}
+
+size_t RosAlloc::FreeFromRunLocked(Thread* self, void* ptr, Run* run) {
   DCHECK_EQ(run->magic_num_, kMagicNum);
   DCHECK_LT(run, ptr);
   DCHECK_LT(ptr, run->End());
   const size_t idx = run->size_bracket_idx_;
   const size_t bracket_size = bracketSizes[idx];
   bool run_was_full = false;
-  MutexLock brackets_mu(self, *size_bracket_locks_[idx]);
+  size_bracket_locks_[idx]->AssertHeld(self);
   if (kIsDebugBuild) {
     run_was_full = run->IsFull();
   }
@@ -787,6 +873,15 @@ size_t RosAlloc::FreeFromRun(Thread* self, void* ptr, Run* run) {
     // A thread local run will be kept as a thread local even if it's become all free.
     return bracket_size;
   }
+  if (UNLIKELY(!run->IsLazyFreeListEmpty())) {
+    // Sweep the run first. It's full so it's only in the full run set (debug only.)
+    FinishLazySweep(run);
+    if (kIsDebugBuild) {
+      full_runs_[idx].erase(run);
+    }
+    non_full_runs_[idx].insert(run);
+    run_was_full = false;
+  }
   // Free the slot in the run.
   run->FreeSlot(ptr);
   auto* non_full_runs = &non_full_runs_[idx];
@@ -799,6 +894,8 @@ size_t RosAlloc::FreeFromRun(Thread* self, void* ptr, Run* run) {
         LOG(INFO) << "RosAlloc::FreeFromRun() : Erased run 0x" << std::hex
                   << reinterpret_cast<intptr_t>(run) << " from non_full_runs_";
       }
+    } else {
+      retired_runs_[idx].erase(run);
     }
     if (run == current_runs_[idx]) {
       current_runs_[idx] = dedicated_full_run_;
@@ -812,12 +909,13 @@ size_t RosAlloc::FreeFromRun(Thread* self, void* ptr, Run* run) {
     }
   } else {
     // It is not completely free. If it wasn't the current run or
-    // already in the non-full run set (i.e., it was full) insert it
-    // into the non-full run set.
+    // already in the non-full or retired run set (i.e., it was full)
+    // insert it into the non-full run set.
     if (run != current_runs_[idx]) {
       auto* full_runs = kIsDebugBuild ? &full_runs_[idx] : nullptr;
       auto pos = non_full_runs->find(run);
-      if (pos == non_full_runs->end()) {
+      if (pos == non_full_runs->end() &&
+          retired_runs_[idx].find(run) == retired_runs_[idx].end()) {
         DCHECK(run_was_full);
         DCHECK(full_runs->find(run) != full_runs->end());
         if (kIsDebugBuild) {
@@ -871,6 +969,7 @@ std::string RosAlloc::Run::Dump() {
          << " free_list=" << FreeListToStr(&free_list_)
          << " bulk_free_list=" << FreeListToStr(&bulk_free_list_)
          << " thread_local_list=" << FreeListToStr(&thread_local_free_list_)
+         << " lazy_free_list=" << FreeListToStr(&lazy_free_list_)
          << " }" << std::endl;
   return stream.str();
 }
@@ -917,6 +1016,18 @@ inline void RosAlloc::Run::MergeBulkFreeListToThreadLocalFreeList() {
   thread_local_free_list_.Merge(&bulk_free_list_);
 }
 
+inline void RosAlloc::Run::MergeBulkFreeListToLazyFreeList() {
+  DCHECK(!IsThreadLocal());
+  // Merge the bulk free list into the lazy free list and clear the bulk free list.
+  lazy_free_list_.Merge(&bulk_free_list_);
+}
+
+inline void RosAlloc::Run::MergeLazyFreeListToFreeList() {
+  DCHECK(!IsThreadLocal());
+  // Merge the lazy free list into the free list and clear the lazy free list.
+  free_list_.Merge(&lazy_free_list_);
+}
+
 inline void RosAlloc::Run::AddToThreadLocalFreeList(void* ptr) {
   DCHECK(IsThreadLocal());
   AddToFreeListShared(ptr, &thread_local_free_list_, __FUNCTION__);
@@ -991,6 +1102,11 @@ void RosAlloc::Run::InspectAllSlots(void (*handler)(void* start, void* end, size
       is_free[slot_idx] = true;
     }
   }
+  for (Slot* slot = lazy_free_list_.Head(); slot != nullptr; slot = slot->Next()) {
+    size_t slot_idx = SlotIndex(slot);
+    DCHECK_LT(slot_idx, num_slots);
+    is_free[slot_idx] = true;
+  }
   for (size_t slot_idx = 0; slot_idx < num_slots; ++slot_idx) {
     uint8_t* slot_addr = slot_base + slot_idx * bracket_size;
     if (!is_free[slot_idx]) {
@@ -1008,17 +1124,46 @@ void RosAlloc::Run::InspectAllSlots(void (*handler)(void* start, void* end, size
 static constexpr bool kReadPageMapEntryWithoutLockInBulkFree = true;
 
 size_t RosAlloc::BulkFree(Thread* self, void** ptrs, size_t num_ptrs) {
-  size_t freed_bytes = 0;
   if ((false)) {
     // Used only to test Free() as GC uses only BulkFree().
+    size_t freed_bytes = 0;
     for (size_t i = 0; i < num_ptrs; ++i) {
       freed_bytes += FreeInternal(self, ptrs[i]);
     }
     return freed_bytes;
   }
-
   WriterMutexLock wmu(self, bulk_free_lock_);
+  return BulkFreeLocked(self, ptrs, num_ptrs);
+}
+
+void RosAlloc::StartParallelBulkFree(Thread* self) {
+  bulk_free_lock_.ExclusiveLock(self);
+}
+
+void RosAlloc::FinishParallelBulkFree(Thread* self) {
+  bulk_free_lock_.ExclusiveUnlock(self);
+}
+
+size_t RosAlloc::BulkFreeInParallel(Thread* self, void** ptrs, size_t num_ptrs) {
+  // The thread which called StartParallelBulkFree() holds bulk_free_lock_ on behalf of all the
+  // threads freeing in parallel. They free slots of disjoint runs, so they don't race on the bulk
+  // free lists. The size bracket locks protect the rest.
+  return BulkFreeLocked(self, ptrs, num_ptrs);
+}
 
+void* RosAlloc::RoundUpToRunBoundary(void* addr) {
+  DCHECK_LE(base_, addr);
+  MutexLock mu(Thread::Current(), lock_);
+  size_t pm_idx = ToPageMapIndex(AlignUp(addr, kPageSize));
+  while (pm_idx < page_map_size_ &&
+         (page_map_[pm_idx] == kPageMapRunPart || page_map_[pm_idx] == kPageMapLargeObjectPart)) {
+    ++pm_idx;
+  }
+  return base_ + pm_idx * kPageSize;
+}
+
+size_t RosAlloc::BulkFreeLocked(Thread* self, void** ptrs, size_t num_ptrs) {
+  size_t freed_bytes = 0;
   // First mark slots to free in the bulk free bit map without locking the
   // size bracket locks. On host, unordered_set is faster than vector + flag.
 #ifdef __ANDROID__
@@ -1123,6 +1268,25 @@ size_t RosAlloc::BulkFree(Thread* self, void** ptrs, size_t num_ptrs) {
       // it's become all free.
     } else {
       bool run_was_full = run->IsFull();
+      if (kUseLazySweep && run_was_full && run != current_runs_[idx]) {
+        const size_t num_freed_slots = run->BulkFreeList()->Size() + run->LazyFreeList()->Size();
+        if (num_freed_slots < numOfSlots[idx]) {
+          // Leave the freed slots to the allocator, see RefillRun(). The run stays in the full run
+          // set (debug only.)
+          run->MergeBulkFreeListToLazyFreeList();
+          runs_to_sweep_[idx].insert(run);
+          if (kTraceRosAlloc) {
+            LOG(INFO) << "RosAlloc::BulkFree() : Inserted run 0x" << std::hex
+                      << reinterpret_cast<intptr_t>(run) << " into runs_to_sweep_["
+                      << std::dec << idx << "]";
+          }
+          continue;
+        }
+        // The run becomes all free, sweep it now to free its pages.
+        if (!run->IsLazyFreeListEmpty()) {
+          FinishLazySweep(run);
+        }
+      }
       run->MergeBulkFreeListToFreeList();
       if (kTraceRosAlloc) {
         LOG(INFO) << "RosAlloc::BulkFree() : Freed slot(s) in a run 0x" << std::hex
@@ -1154,6 +1318,10 @@ size_t RosAlloc::BulkFree(Thread* self, void** ptrs, size_t num_ptrs) {
             }
             DCHECK(full_runs->find(run) == full_runs->end());
           }
+        } else if (retired_runs_[idx].erase(run) != 0) {
+          // It was retired, it's removed from the retired run set.
+          DCHECK(full_runs->find(run) == full_runs->end());
+          DCHECK(non_full_runs->find(run) == non_full_runs->end());
         } else {
           // If it was in a non full run set, remove it from the set.
           DCHECK(full_runs->find(run) == full_runs->end());
@@ -1199,9 +1367,10 @@ size_t RosAlloc::BulkFree(Thread* self, void** ptrs, size_t num_ptrs) {
                       << " into non_full_runs_[" << std::dec << idx;
           }
         } else {
-          // If it was not full, so leave it in the non full run set.
+          // If it was not full, so leave it in the non full (or retired) run set.
           DCHECK(full_runs->find(run) == full_runs->end());
-          DCHECK(non_full_runs->find(run) != non_full_runs->end());
+          DCHECK(non_full_runs->find(run) != non_full_runs->end() ||
+                 retired_runs_[idx].find(run) != retired_runs_[idx].end());
         }
       }
     }
@@ -1209,6 +1378,62 @@ size_t RosAlloc::BulkFree(Thread* self, void** ptrs, size_t num_ptrs) {
   return freed_bytes;
 }
 
+size_t RosAlloc::RetireSparseRuns(Thread* self, size_t max_runs) {
+  size_t num_retired_runs = 0;
+  // Pairs of the number of free slots and the run.
+  std::vector<std::pair<size_t, Run*>> candidates;
+  for (size_t idx = 0; idx < kNumOfSizeBrackets; ++idx) {
+    MutexLock brackets_mu(self, *size_bracket_locks_[idx]);
+    auto* non_full_runs = &non_full_runs_[idx];
+    auto* retired_runs = &retired_runs_[idx];
+    // The runs that are still sparse are likely retired again below.
+    non_full_runs->insert(retired_runs->begin(), retired_runs->end());
+    retired_runs->clear();
+    if (num_retired_runs >= max_runs || non_full_runs->size() < 2) {
+      continue;
+    }
+    const size_t num_slots = numOfSlots[idx];
+    size_t num_free_slots = 0;
+    candidates.clear();
+    for (Run* run : *non_full_runs) {
+      const size_t run_free_slots = run->NumberOfFreeSlots();
+      num_free_slots += run_free_slots;
+      if ((num_slots - run_free_slots) * 100 <= num_slots * kRetireRunMaxOccupancyPercent) {
+        candidates.push_back(std::make_pair(run_free_slots, run));
+      }
+    }
+    // Retire the sparsest runs first.
+    std::sort(candidates.begin(), candidates.end(),
+              [](const std::pair<size_t, Run*>& a, const std::pair<size_t, Run*>& b) {
+                return a.first > b.first;
+              });
+    for (const std::pair<size_t, Run*>& candidate : candidates) {
+      const size_t run_free_slots = candidate.first;
+      const size_t run_used_slots = num_slots - run_free_slots;
+      // Only retire the run if the other runs have room for as many objects as it holds,
+      // otherwise we would just end up allocating new runs.
+      if (num_retired_runs >= max_runs || num_free_slots - run_free_slots < run_used_slots) {
+        break;
+      }
+      num_free_slots -= run_free_slots;
+      non_full_runs->erase(candidate.second);
+      retired_runs->insert(candidate.second);
+      ++num_retired_runs;
+    }
+  }
+  return num_retired_runs;
+}
+
+void RosAlloc::GetRetiredRuns(Thread* self, std::vector<std::pair<uint8_t*, uint8_t*>>* ranges) {
+  for (size_t idx = 0; idx < kNumOfSizeBrackets; ++idx) {
+    MutexLock brackets_mu(self, *size_bracket_locks_[idx]);
+    for (Run* run : retired_runs_[idx]) {
+      uint8_t* begin = reinterpret_cast<uint8_t*>(run);
+      ranges->push_back(std::make_pair(begin, begin + numOfPages[idx] * kPageSize));
+    }
+  }
+}
+
 std::string RosAlloc::DumpPageMap() {
   std::ostringstream stream;
   stream << "RosAlloc PageMap: " << std::endl;
@@ -1542,9 +1767,59 @@ size_t RosAlloc::RevokeThreadLocalRuns(Thread* thread) {
       RevokeRun(self, idx, thread_local_run);
     }
   }
+  free_bytes += RevokeMagazines(thread);
   return free_bytes;
 }
 
+size_t RosAlloc::RevokeMagazines(Thread* thread) {
+  ThreadMagazines* magazines = reinterpret_cast<ThreadMagazines*>(thread->GetRosAllocMagazines());
+  if (magazines == nullptr || magazines->owner != this) {
+    return 0U;
+  }
+  Thread* self = Thread::Current();
+  size_t free_bytes = 0U;
+  // Like Free(), avoid racing with BulkFree() on the runs.
+  ReaderMutexLock rmu(self, bulk_free_lock_);
+  for (size_t i = 0; i < kNumMagazineSizeBrackets; ++i) {
+    Magazine* magazine = &magazines->magazines[i];
+    if (magazine->num_slots == 0) {
+      continue;
+    }
+    const size_t idx = kNumThreadLocalSizeBrackets + i;
+    // The runs can't go away since the slots are allocated in them.
+    Run* runs[kMaxMagazineSlots];
+    {
+      MutexLock mu(self, lock_);
+      for (size_t j = 0; j < magazine->num_slots; ++j) {
+        runs[j] = SlotToRun(magazine->slots[j]);
+      }
+    }
+    // Flush the whole magazine with a single acquisition of the size bracket lock.
+    MutexLock brackets_mu(self, *size_bracket_locks_[idx]);
+    for (size_t j = 0; j < magazine->num_slots; ++j) {
+      DCHECK_EQ(runs[j]->size_bracket_idx_, idx);
+      free_bytes += FreeFromRunLocked(self, magazine->slots[j], runs[j]);
+    }
+    magazine->num_slots = 0;
+  }
+  thread->SetRosAllocMagazines(nullptr);
+  delete magazines;
+  return free_bytes;
+}
+
+RosAlloc::Run* RosAlloc::SlotToRun(void* ptr) {
+  DCHECK_LE(base_, ptr);
+  DCHECK_LT(ptr, base_ + footprint_);
+  size_t pm_idx = RoundDownToPageMapIndex(ptr);
+  while (page_map_[pm_idx] != kPageMapRun) {
+    DCHECK_EQ(page_map_[pm_idx], kPageMapRunPart);
+    --pm_idx;
+  }
+  Run* run = reinterpret_cast<Run*>(base_ + pm_idx * kPageSize);
+  DCHECK_EQ(run->magic_num_, kMagicNum);
+  return run;
+}
+
 void RosAlloc::RevokeRun(Thread* self, size_t idx, Run* run) {
   size_bracket_locks_[idx]->AssertHeld(self);
   DCHECK(run != dedicated_full_run_);
@@ -1609,6 +1884,9 @@ void RosAlloc::AssertThreadLocalRunsAreRevoked(Thread* thread) {
       Run* thread_local_run = reinterpret_cast<Run*>(thread->GetRosAllocRun(idx));
       DCHECK(thread_local_run == nullptr || thread_local_run == dedicated_full_run_);
     }
+    ThreadMagazines* magazines =
+        reinterpret_cast<ThreadMagazines*>(thread->GetRosAllocMagazines());
+    DCHECK(magazines == nullptr || magazines->owner != this);
   }
 }
 
@@ -1846,7 +2124,16 @@ void RosAlloc::Verify() {
     }
   }
   std::list<Thread*> threads = Runtime::Current()->GetThreadList()->GetList();
+  std::unordered_set<void*> magazine_slots;
   for (Thread* thread : threads) {
+    ThreadMagazines* magazines =
+        reinterpret_cast<ThreadMagazines*>(thread->GetRosAllocMagazines());
+    if (magazines != nullptr && magazines->owner == this) {
+      for (const Magazine& magazine : magazines->magazines) {
+        CHECK_LE(magazine.num_slots, kMaxMagazineSlots);
+        magazine_slots.insert(magazine.slots, magazine.slots + magazine.num_slots);
+      }
+    }
     for (size_t i = 0; i < kNumThreadLocalSizeBrackets; ++i) {
       MutexLock brackets_mu(self, *size_bracket_locks_[i]);
       Run* thread_local_run = reinterpret_cast<Run*>(thread->GetRosAllocRun(i));
@@ -1868,11 +2155,12 @@ void RosAlloc::Verify() {
   }
   // Call Verify() here for the lock order.
   for (auto& run : runs) {
-    run->Verify(self, this, is_running_on_memory_tool_);
+    run->Verify(self, this, is_running_on_memory_tool_, magazine_slots);
   }
 }
 
-void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc, bool running_on_memory_tool) {
+void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc, bool running_on_memory_tool,
+                           const std::unordered_set<void*>& magazine_slots) {
   DCHECK_EQ(magic_num_, kMagicNum) << "Bad magic number : " << Dump();
   const size_t idx = size_bracket_idx_;
   CHECK_LT(idx, kNumOfSizeBrackets) << "Out of range size bracket index : " << Dump();
@@ -1932,9 +2220,14 @@ void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc, bool running_on_mem
       auto& non_full_runs = rosalloc->non_full_runs_[idx];
       // If it's all free, it must be a free page run rather than a run.
       CHECK(!IsAllFree()) << "A free run must be in a free page run set " << Dump();
+      auto& runs_to_sweep = rosalloc->runs_to_sweep_[idx];
+      CHECK_EQ(runs_to_sweep.find(this) != runs_to_sweep.end(), !IsLazyFreeListEmpty())
+          << "A run with lazily freed slots isn't in the run set to sweep " << Dump();
       if (!IsFull()) {
-        // If it's not full, it must in the non-full run set.
-        CHECK(non_full_runs.find(this) != non_full_runs.end())
+        // If it's not full, it must in the non-full or the retired run set.
+        auto& retired_runs = rosalloc->retired_runs_[idx];
+        CHECK(non_full_runs.find(this) != non_full_runs.end() ||
+              retired_runs.find(this) != retired_runs.end())
             << "A non-full run isn't in the non-full run set " << Dump();
       } else {
         // If it's full, it must in the full run set (debug build only.)
@@ -1965,6 +2258,19 @@ void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc, bool running_on_mem
       is_free[slot_idx] = true;
     }
   }
+  for (Slot* slot = lazy_free_list_.Head(); slot != nullptr; slot = slot->Next()) {
+    size_t slot_idx = SlotIndex(slot);
+    DCHECK_LT(slot_idx, num_slots);
+    is_free[slot_idx] = true;
+  }
+  // The slots in the magazines are allocated but don't hold objects yet.
+  if (!magazine_slots.empty()) {
+    for (size_t slot_idx = 0; slot_idx < num_slots; ++slot_idx) {
+      if (magazine_slots.find(slot_base + slot_idx * bracket_size) != magazine_slots.end()) {
+        is_free[slot_idx] = true;
+      }
+    }
+  }
   for (size_t slot_idx = 0; slot_idx < num_slots; ++slot_idx) {
     uint8_t* slot_addr = slot_base + slot_idx * bracket_size;
     if (running_on_memory_tool) {
@@ -2054,6 +2360,15 @@ size_t RosAlloc::ReleasePageRange(uint8_t* start, uint8_t* end) {
       return 0;
     }
   }
+  if (use_huge_pages_) {
+    // Releasing part of a huge page would make the kernel split it. Keep the partial huge pages
+    // at both ends of the range, they stay in the page map as empty pages.
+    start = AlignUp(start, MemMap::kHugePageSize);
+    end = AlignDown(end, MemMap::kHugePageSize);
+    if (start >= end) {
+      return 0;
+    }
+  }
   if (!kMadviseZeroes) {
     // TODO: Do this when we resurrect the page instead.
     memset(start, 0, end - start);
@@ -2114,6 +2429,7 @@ void RosAlloc::DumpStats(std::ostream& os) {
   std::unique_ptr<size_t[]> num_slots(new size_t[kNumOfSizeBrackets]());
   std::unique_ptr<size_t[]> num_used_slots(new size_t[kNumOfSizeBrackets]());
   std::unique_ptr<size_t[]> num_metadata_bytes(new size_t[kNumOfSizeBrackets]());
+  std::unique_ptr<size_t[]> num_runs_to_sweep(new size_t[kNumOfSizeBrackets]());
   ReaderMutexLock rmu(self, bulk_free_lock_);
   MutexLock lock_mu(self, lock_);
   for (size_t i = 0; i < page_map_size_; ) {
@@ -2146,8 +2462,11 @@ void RosAlloc::DumpStats(std::ostream& os) {
         num_runs[idx]++;
         num_pages_runs[idx] += num_pages;
         num_slots[idx] += numOfSlots[idx];
-        size_t num_free_slots = run->NumberOfFreeSlots();
+        size_t num_free_slots = run->NumberOfFreeSlots() + run->LazyFreeList()->Size();
         num_used_slots[idx] += numOfSlots[idx] - num_free_slots;
+        if (!run->IsLazyFreeListEmpty()) {
+          num_runs_to_sweep[idx]++;
+        }
         num_metadata_bytes[idx] += headerSizes[idx];
         i += num_pages;
         break;
@@ -2164,6 +2483,7 @@ void RosAlloc::DumpStats(std::ostream& os) {
   for (size_t i = 0; i < kNumOfSizeBrackets; ++i) {
     os << "Bracket " << i << " (" << bracketSizes[i] << "):"
        << " #runs=" << num_runs[i]
+       << " #runs_to_sweep=" << num_runs_to_sweep[i]
        << " #pages=" << num_pages_runs[i]
        << " (" << PrettySize(num_pages_runs[i] * kPageSize) << ")"
        << " #metadata_bytes=" << PrettySize(num_metadata_bytes[i])
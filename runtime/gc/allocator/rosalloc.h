@@ -38,6 +38,12 @@ namespace art {
 class MemMap;
 
 namespace gc {
+
+namespace space {
+class RosAllocSpaceLazySweepTest;
+class RosAllocSpaceRetireRunsTest;
+}  // namespace space
+
 namespace allocator {
 
 // A runs-of-slots memory allocator.
@@ -333,6 +339,10 @@ class RosAlloc {
   // | list              |
   // |                   |
   // +-------------------+
+  // |                   |
+  // | lazy free list    |
+  // |                   |
+  // +-------------------+
   // | padding due to    |
   // | alignment         |
   // +-------------------+
@@ -358,6 +368,8 @@ class RosAlloc {
     SlotFreeList<false> free_list_;
     SlotFreeList<true> bulk_free_list_;
     SlotFreeList<true> thread_local_free_list_;
+    // The slots freed by BulkFree() that are not yet in the free list, see kUseLazySweep.
+    SlotFreeList<true> lazy_free_list_;
     // Padding due to alignment
     // Slot 0
     // Slot 1
@@ -388,6 +400,9 @@ class RosAlloc {
     SlotFreeList<true>* ThreadLocalFreeList() {
       return &thread_local_free_list_;
     }
+    SlotFreeList<true>* LazyFreeList() {
+      return &lazy_free_list_;
+    }
     void* End() {
       return reinterpret_cast<uint8_t*>(this) + kPageSize * numOfPages[size_bracket_idx_];
     }
@@ -417,6 +432,12 @@ class RosAlloc {
     // can write without a lock, and later acquire a lock once per run to merge the bulk free list
     // to the thread-local free list.
     void MergeBulkFreeListToThreadLocalFreeList();
+    // Move the bulk free list to the lazy free list. Used in a bulk free to leave the merge into
+    // the free list to the allocator.
+    void MergeBulkFreeListToLazyFreeList();
+    // Merge the lazy free list to the free list. Used when the allocator reaches a lazily swept
+    // run.
+    void MergeLazyFreeListToFreeList();
     // Allocates a slot in a run.
     ALWAYS_INLINE void* AllocSlot();
     // Frees a slot in a run. This is used in a non-bulk free.
@@ -443,6 +464,10 @@ class RosAlloc {
     bool IsThreadLocalFreeListEmpty() const {
       return thread_local_free_list_.Size() == 0;
     }
+    // Returns true if the lazy free list is empty.
+    bool IsLazyFreeListEmpty() const {
+      return lazy_free_list_.Size() == 0;
+    }
     // Zero the run's data.
     void ZeroData();
     // Zero the run's header and the slot headers.
@@ -451,8 +476,9 @@ class RosAlloc {
     void InspectAllSlots(void (*handler)(void* start, void* end, size_t used_bytes, void* callback_arg), void* arg);
     // Dump the run metadata for debugging.
     std::string Dump();
-    // Verify for debugging.
-    void Verify(Thread* self, RosAlloc* rosalloc, bool running_on_memory_tool)
+    // Verify for debugging. The slots in magazine_slots are in thread magazines.
+    void Verify(Thread* self, RosAlloc* rosalloc, bool running_on_memory_tool,
+                const std::unordered_set<void*>& magazine_slots)
         REQUIRES(Locks::mutator_lock_)
         REQUIRES(Locks::thread_list_lock_);
 
@@ -632,6 +658,15 @@ class RosAlloc {
   // If true, log verbose details of operations.
   static constexpr bool kTraceRosAlloc = false;
 
+  // RetireSparseRuns() only retires the runs with at most this percent of their slots in use.
+  static constexpr size_t kRetireRunMaxOccupancyPercent = 25;
+
+  // If true, BulkFree() leaves the slots it frees in full runs on the runs' lazy free lists and
+  // the allocator sweeps such a run when it reaches it in RefillRun() or FreeFromRun(). This
+  // moves the per run work of the sweep from the GC to the allocating threads. The runs that
+  // become all free are still freed right away.
+  static constexpr bool kUseLazySweep = true;
+
   struct hash_run {
     size_t operator()(const RosAlloc::Run* r) const {
       return reinterpret_cast<size_t>(r);
@@ -670,6 +705,14 @@ class RosAlloc {
   // This should be equal to bracketSizes[kNumThreadLocalSizeBrackets - 1].
   static const size_t kMaxThreadLocalBracketSize = 128;
 
+  // We use per-thread magazines in front of the shared (current) runs for the size brackets
+  // without thread-local runs. A magazine holds about kMagazineBytes worth of slots, but no fewer
+  // than kMinMagazineSlots and no more than kMaxMagazineSlots.
+  static const size_t kNumMagazineSizeBrackets = kNumOfSizeBrackets - kNumThreadLocalSizeBrackets;
+  static constexpr size_t kMagazineBytes = 2 * KB;
+  static constexpr size_t kMinMagazineSlots = 2;
+  static constexpr size_t kMaxMagazineSlots = 16;
+
   // We use regular (8 or 16-bytes increment) runs for the size brackets whose indexes are less than
   // this index.
   static const size_t kNumRegularSizeBrackets = 40;
@@ -714,6 +757,12 @@ class RosAlloc {
   // debug only. full_runs_[i] is guarded by size_bracket_locks_[i].
   std::unordered_set<Run*, hash_run, eq_run, TrackingAllocator<Run*, kAllocatorTagRosAlloc>>
       full_runs_[kNumOfSizeBrackets];
+  // The run sets that hold the non-full runs taken out of non_full_runs_ by RetireSparseRuns().
+  // retired_runs_[i] is guarded by size_bracket_locks_[i].
+  AllocationTrackingSet<Run*, kAllocatorTagRosAlloc> retired_runs_[kNumOfSizeBrackets];
+  // The run sets that hold the full runs with a non-empty lazy free list. They are also in
+  // full_runs_ (debug only). runs_to_sweep_[i] is guarded by size_bracket_locks_[i].
+  AllocationTrackingSet<Run*, kAllocatorTagRosAlloc> runs_to_sweep_[kNumOfSizeBrackets];
   // The set of free pages.
   AllocationTrackingSet<FreePageRun*, kAllocatorTagRosAlloc> free_page_runs_ GUARDED_BY(lock_);
   // The dedicated full run, it is always full and shared by all threads when revoking happens.
@@ -767,6 +816,36 @@ class RosAlloc {
   // Whether this allocator is running under Valgrind.
   bool is_running_on_memory_tool_;
 
+  // Whether the threads allocate from magazines for the size brackets without thread-local runs.
+  bool use_magazines_;
+
+  // Whether the pages are backed by transparent huge pages. If so, free pages are only released
+  // in whole huge pages so that the kernel doesn't split them.
+  bool use_huge_pages_;
+
+  // A per-thread cache of slots taken from the current run of a size bracket. The slots are
+  // allocated as far as the runs are concerned, they are given back to the runs when the
+  // magazines are revoked.
+  struct Magazine {
+    size_t num_slots;
+    void* slots[kMaxMagazineSlots];
+  };
+  // The magazines of a thread, see Thread::GetRosAllocMagazines(). Only the owning thread
+  // accesses them, except when they are revoked.
+  struct ThreadMagazines {
+    explicit ThreadMagazines(RosAlloc* rosalloc) : owner(rosalloc), magazines() {}
+    // The allocator the slots come from.
+    RosAlloc* const owner;
+    Magazine magazines[kNumMagazineSizeBrackets];
+  };
+  // Returns how many slots a magazine of the size bracket holds.
+  static size_t MagazineCapacity(size_t idx) {
+    DCHECK_GE(idx, kNumThreadLocalSizeBrackets);
+    const size_t num_slots = kMagazineBytes / bracketSizes[idx];
+    return num_slots < kMinMagazineSlots ? kMinMagazineSlots :
+        (num_slots > kMaxMagazineSlots ? kMaxMagazineSlots : num_slots);
+  }
+
   // The base address of the memory region that's managed by this allocator.
   uint8_t* Begin() { return base_; }
   // The end address of the memory region that's managed by this allocator.
@@ -778,6 +857,10 @@ class RosAlloc {
   // Returns how many bytes were freed.
   size_t FreePages(Thread* self, void* ptr, bool already_zero) REQUIRES(lock_);
 
+  // The body of BulkFree().
+  size_t BulkFreeLocked(Thread* self, void** ptrs, size_t num_ptrs)
+      REQUIRES(bulk_free_lock_, !lock_);
+
   // Allocate/free a run slot.
   void* AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated, size_t* usable_size,
                      size_t* bytes_tl_bulk_allocated)
@@ -788,10 +871,23 @@ class RosAlloc {
                                  size_t* usable_size, size_t* bytes_tl_bulk_allocated)
       REQUIRES(!lock_);
   void* AllocFromCurrentRunUnlocked(Thread* self, size_t idx) REQUIRES(!lock_);
+  // Allocate a slot from the thread's magazine, refilling the magazine from the current run if it
+  // is empty. Creates the magazines if magazines is null.
+  void* AllocFromMagazine(Thread* self, size_t idx, ThreadMagazines* magazines,
+                          size_t* bytes_tl_bulk_allocated)
+      REQUIRES(!lock_);
+  // Give the slots in the magazines of the given thread back to their runs and delete the
+  // magazines. Returns the total bytes of the slots.
+  size_t RevokeMagazines(Thread* thread) REQUIRES(!lock_, !bulk_free_lock_);
+  // Returns the run that contains the given slot.
+  Run* SlotToRun(void* ptr) REQUIRES(lock_);
 
   // Returns the bracket size.
   size_t FreeFromRun(Thread* self, void* ptr, Run* run)
       REQUIRES(!lock_);
+  // Same as FreeFromRun() but the caller holds the size bracket lock.
+  size_t FreeFromRunLocked(Thread* self, void* ptr, Run* run)
+      REQUIRES(!lock_);
 
   // Used to allocate a new thread local run for a size bracket.
   Run* AllocRun(Thread* self, size_t idx) REQUIRES(!lock_);
@@ -799,6 +895,9 @@ class RosAlloc {
   // Used to acquire a new/reused run for a size bracket. Used when a
   // thread-local or current run gets full.
   Run* RefillRun(Thread* self, size_t idx) REQUIRES(!lock_);
+  // Finish the lazy sweep of a run in runs_to_sweep_ and remove it from the set. The caller
+  // holds the size bracket lock and takes care of the other run sets.
+  void FinishLazySweep(Run* run);
 
   // The internal of non-bulk Free().
   size_t FreeInternal(Thread* self, void* ptr) REQUIRES(!lock_);
@@ -850,6 +949,24 @@ class RosAlloc {
       REQUIRES(!bulk_free_lock_, !lock_);
   size_t BulkFree(Thread* self, void** ptrs, size_t num_ptrs)
       REQUIRES(!bulk_free_lock_, !lock_);
+  // Parallel sweeping support. Between StartParallelBulkFree() and FinishParallelBulkFree(),
+  // any number of threads may call BulkFreeInParallel() as long as no two of them free slots of
+  // the same run at the same time, see RoundUpToRunBoundary().
+  void StartParallelBulkFree(Thread* self) ACQUIRE(bulk_free_lock_);
+  void FinishParallelBulkFree(Thread* self) RELEASE(bulk_free_lock_);
+  size_t BulkFreeInParallel(Thread* self, void** ptrs, size_t num_ptrs)
+      NO_THREAD_SAFETY_ANALYSIS;
+  // Returns the first page boundary at or after addr which is not inside of a run or a large
+  // object. Ranges split at such boundaries can be bulk freed in parallel.
+  void* RoundUpToRunBoundary(void* addr) REQUIRES(!lock_);
+  // Stop allocating in up to max_runs of the sparsest runs so that their pages are freed once the
+  // objects in them die, or once the GC moved them out, see GetRetiredRuns(). The runs retired
+  // by the previous call are put back into the non-full run sets first. Returns the number of
+  // runs retired.
+  size_t RetireSparseRuns(Thread* self, size_t max_runs) REQUIRES(!lock_);
+  // Appends the [begin, end) page ranges of the runs retired by RetireSparseRuns() to ranges.
+  void GetRetiredRuns(Thread* self, std::vector<std::pair<uint8_t*, uint8_t*>>* ranges)
+      REQUIRES(!lock_);
 
   // Returns true if the given allocation request can be allocated in
   // an existing thread local run without allocating a new run.
@@ -902,6 +1019,17 @@ class RosAlloc {
   void AssertThreadLocalRunsAreRevoked(Thread* thread) REQUIRES(!bulk_free_lock_);
   // Assert all the thread local runs are revoked.
   void AssertAllThreadLocalRunsAreRevoked() REQUIRES(!Locks::thread_list_lock_, !bulk_free_lock_);
+  // Enable or disable the magazines. Only called when no thread has magazines of this allocator,
+  // e.g. right after a RevokeAllThreadLocalRuns().
+  void SetUseMagazines(bool use_magazines) {
+    use_magazines_ = use_magazines;
+  }
+  // Release the free pages in huge page granularity. Called once after the space's memory is
+  // advised to use transparent huge pages.
+  void SetUseHugePages(bool use_huge_pages) REQUIRES(!lock_) {
+    MutexLock mu(Thread::Current(), lock_);
+    use_huge_pages_ = use_huge_pages;
+  }
 
   static Run* GetDedicatedFullRun() {
     return dedicated_full_run_;
@@ -933,6 +1061,8 @@ class RosAlloc {
 
  private:
   friend std::ostream& operator<<(std::ostream& os, const RosAlloc::PageMapKind& rhs);
+  friend class space::RosAllocSpaceLazySweepTest;
+  friend class space::RosAllocSpaceRetireRunsTest;
 
   DISALLOW_COPY_AND_ASSIGN(RosAlloc);
 };
@@ -18,11 +18,14 @@
 
 #include "art_field-inl.h"
 #include "base/stl_util.h"
+#include "base/time_utils.h"
 #include "debugger.h"
+#include "gc/accounting/card_table-inl.h"
 #include "gc/accounting/heap_bitmap-inl.h"
 #include "gc/accounting/space_bitmap-inl.h"
 #include "gc/reference_processor.h"
 #include "gc/space/image_space.h"
+#include "gc/space/large_object_space.h"
 #include "gc/space/space-inl.h"
 #include "image-inl.h"
 #include "intern_table.h"
@@ -31,6 +34,7 @@
 #include "scoped_thread_state_change.h"
 #include "thread-inl.h"
 #include "thread_list.h"
+#include "thread_pool.h"
 #include "well_known_classes.h"
 
 namespace art {
@@ -38,12 +42,16 @@ namespace gc {
 namespace collector {
 
 static constexpr size_t kDefaultGcMarkStackSize = 2 * MB;
+// Don't bother starting the marking threads for a small mark stack.
+static constexpr size_t kMinimumParallelMarkStackSize = 128;
+// Capacity of the per-thread parallel marking deques.
+static constexpr size_t kParallelMarkDequeSize = 64 * KB;
 
-ConcurrentCopying::ConcurrentCopying(Heap* heap, const std::string& name_prefix)
+ConcurrentCopying::ConcurrentCopying(Heap* heap, bool young_gen, const std::string& name_prefix)
     : GarbageCollector(heap,
                        name_prefix + (name_prefix.empty() ? "" : " ") +
                        "concurrent copying + mark sweep"),
-      region_space_(nullptr), gc_barrier_(new Barrier(0)),
+      region_space_(nullptr), young_gen_(young_gen), gc_barrier_(new Barrier(0)),
       gc_mark_stack_(accounting::ObjectStack::Create("concurrent copying gc mark stack",
                                                      kDefaultGcMarkStackSize,
                                                      kDefaultGcMarkStackSize)),
@@ -52,6 +60,16 @@ ConcurrentCopying::ConcurrentCopying(Heap* heap, const std::string& name_prefix)
       is_marking_(false), is_active_(false), is_asserting_to_space_invariant_(false),
       heap_mark_bitmap_(nullptr), live_stack_freeze_size_(0), mark_stack_mode_(kMarkStackModeOff),
       weak_ref_access_enabled_(true),
+      num_parallel_mark_workers_(0),
+      is_parallel_marking_(false),
+      parallel_mark_done_(false),
+      num_active_parallel_markers_(0),
+      parallel_mark_count_(0),
+      marking_time_ns_(0),
+      cumulative_marking_time_ns_(0),
+      cumulative_live_bytes_(0),
+      cumulative_bytes_copied_(0),
+      cumulative_bytes_reclaimed_(0),
       skipped_blocks_lock_("concurrent copying bytes blocks lock", kMarkSweepMarkStackLock),
       rb_table_(heap_->GetReadBarrierTable()),
       force_evacuate_all_(false) {
@@ -147,12 +165,13 @@ void ConcurrentCopying::BindBitmaps() {
       cc_heap_bitmap_->AddContinuousSpaceBitmap(bitmap);
       cc_bitmaps_.push_back(bitmap);
     } else if (space == region_space_) {
-      accounting::ContinuousSpaceBitmap* bitmap =
-          accounting::ContinuousSpaceBitmap::Create("cc region space bitmap",
-                                                    space->Begin(), space->Capacity());
-      cc_heap_bitmap_->AddContinuousSpaceBitmap(bitmap);
-      cc_bitmaps_.push_back(bitmap);
-      region_space_bitmap_ = bitmap;
+      // The region space bitmap outlives the collection. A young collection relies on the marks
+      // left by the previous collections to find the old objects on dirty cards.
+      region_space_bitmap_ = region_space_->GetCCMarkBitmap();
+      if (!young_gen_) {
+        region_space_bitmap_->Clear();
+      }
+      cc_heap_bitmap_->AddContinuousSpaceBitmap(region_space_bitmap_);
     }
   }
 }
@@ -238,15 +257,28 @@ class ConcurrentCopying::FlipCallback : public Closure {
     Thread* self = Thread::Current();
     CHECK(thread == self);
     Locks::mutator_lock_->AssertExclusiveHeld(self);
-    cc->region_space_->SetFromSpace(cc->rb_table_, cc->force_evacuate_all_);
+    cc->region_space_->SetFromSpace(cc->rb_table_, cc->force_evacuate_all_, cc->young_gen_);
     cc->SwapStacks();
     if (ConcurrentCopying::kEnableFromSpaceAccountingCheck) {
       cc->RecordLiveStackFreezeSize(self);
-      cc->from_space_num_objects_at_first_pause_ = cc->region_space_->GetObjectsAllocated();
-      cc->from_space_num_bytes_at_first_pause_ = cc->region_space_->GetBytesAllocated();
+      if (cc->young_gen_) {
+        // The old regions stay in the to-space.
+        cc->from_space_num_objects_at_first_pause_ =
+            cc->region_space_->GetObjectsAllocatedInFromSpace();
+        cc->from_space_num_bytes_at_first_pause_ =
+            cc->region_space_->GetBytesAllocatedInFromSpace();
+      } else {
+        cc->from_space_num_objects_at_first_pause_ = cc->region_space_->GetObjectsAllocated();
+        cc->from_space_num_bytes_at_first_pause_ = cc->region_space_->GetBytesAllocated();
+      }
     }
     cc->is_marking_ = true;
     cc->mark_stack_mode_.StoreRelaxed(ConcurrentCopying::kMarkStackModeThreadLocal);
+    if (cc->young_gen_) {
+      cc->ScanDirtyCards();
+    } else if (cc->heap_->use_generational_cc_) {
+      cc->ClearCards();
+    }
     if (UNLIKELY(Runtime::Current()->IsActiveTransaction())) {
       CHECK(Runtime::Current()->IsAotCompiler());
       TimingLogger::ScopedTiming split2("(Paused)VisitTransactionRoots", cc->GetTimings());
@@ -296,6 +328,68 @@ void ConcurrentCopying::RecordLiveStackFreezeSize(Thread* self) {
   live_stack_freeze_size_ = heap_->GetLiveStack()->Size();
 }
 
+// Used to gray the objects on dirty cards at the start of a young collection.
+class ConcurrentCopying::DirtyCardObjectVisitor {
+ public:
+  explicit DirtyCardObjectVisitor(ConcurrentCopying* cc) : collector_(cc) {}
+
+  void operator()(mirror::Object* obj) const SHARED_REQUIRES(Locks::mutator_lock_)
+      SHARED_REQUIRES(Locks::heap_bitmap_lock_) {
+    DCHECK(obj != nullptr);
+    if (collector_->region_space_->HasAddress(obj)) {
+      // An old object. It stays in the to-space, so Mark() won't gray it. Gray it here so that
+      // mutators go through the read barrier until it's scanned.
+      DCHECK(collector_->region_space_->IsInToSpace(obj)) << obj;
+      if (kUseBakerReadBarrier) {
+        DCHECK_EQ(obj->GetReadBarrierPointer(), ReadBarrier::WhitePtr()) << obj;
+        obj->SetReadBarrierPointer(ReadBarrier::GrayPtr());
+      }
+      collector_->PushOntoMarkStack(obj);
+    } else {
+      collector_->MarkNonMoving(obj);
+    }
+  }
+
+ private:
+  ConcurrentCopying* const collector_;
+};
+
+// A young collection does not mark through the old objects. An old object whose card is clean has
+// not been written since the previous pause and may only refer to old objects, so only the objects
+// on dirty cards need to be scanned. Gray them in the pause before the mutators can read them.
+void ConcurrentCopying::ScanDirtyCards() {
+  TimingLogger::ScopedTiming split("(Paused)ScanDirtyCards", GetTimings());
+  CHECK(young_gen_);
+  Thread* self = Thread::Current();
+  accounting::CardTable* card_table = heap_->GetCardTable();
+  DirtyCardObjectVisitor visitor(this);
+  WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+  size_t cards_scanned = 0;
+  for (space::ContinuousSpace* space : heap_->GetContinuousSpaces()) {
+    accounting::ContinuousSpaceBitmap* bitmap =
+        space == region_space_ ? region_space_bitmap_ : space->GetLiveBitmap();
+    if (bitmap == nullptr) {
+      continue;
+    }
+    cards_scanned += card_table->Scan<true>(bitmap, space->Begin(), space->End(), visitor);
+  }
+  if (kVerboseMode) {
+    LOG(INFO) << "Scanned " << cards_scanned << " dirty cards";
+  }
+}
+
+// Clear the cards at the start of a full collection so that the next young collection only scans
+// the objects written after this pause.
+void ConcurrentCopying::ClearCards() {
+  TimingLogger::ScopedTiming split("(Paused)ClearCards", GetTimings());
+  accounting::CardTable* card_table = heap_->GetCardTable();
+  for (space::ContinuousSpace* space : heap_->GetContinuousSpaces()) {
+    // The image space end is not necessarily card aligned.
+    card_table->ClearCardRange(space->Begin(),
+                               AlignUp(space->End(), accounting::CardTable::kCardSize));
+  }
+}
+
 // Used to visit objects in the immune spaces.
 class ConcurrentCopying::ImmuneSpaceObjVisitor {
  public:
@@ -356,6 +450,7 @@ void ConcurrentCopying::MarkingPhase() {
   if (kVerboseMode) {
     LOG(INFO) << "GC MarkingPhase";
   }
+  const uint64_t marking_start_time = NanoTime();
   CHECK(weak_ref_access_enabled_);
   {
     // Mark the image root. The WB-based collectors do not need to
@@ -462,6 +557,7 @@ void ConcurrentCopying::MarkingPhase() {
   }
 
   CHECK(weak_ref_access_enabled_);
+  marking_time_ns_ = NanoTime() - marking_start_time;
   if (kVerboseMode) {
     LOG(INFO) << "GC end of MarkingPhase";
   }
@@ -586,6 +682,17 @@ void ConcurrentCopying::PushOntoMarkStack(mirror::Object* to_ref) {
   CHECK(thread_running_gc_ != nullptr);
   MarkStackMode mark_stack_mode = mark_stack_mode_.LoadRelaxed();
   if (LIKELY(mark_stack_mode == kMarkStackModeThreadLocal)) {
+    if (UNLIKELY(is_parallel_marking_.LoadAcquire())) {
+      // If a marking thread, use its deque. Mutators keep using their thread-local mark stacks.
+      accounting::WorkStealingDeque<mirror::Object>* deque = self->GetThreadLocalMarkDeque();
+      if (deque != nullptr) {
+        if (UNLIKELY(!deque->Push(to_ref))) {
+          MutexLock mu(self, mark_stack_lock_);
+          parallel_mark_overflow_.push_back(to_ref);
+        }
+        return;
+      }
+    }
     if (LIKELY(self == thread_running_gc_)) {
       // If GC-running thread, use the GC mark stack instead of a thread-local mark stack.
       CHECK(self->GetThreadLocalMarkStack() == nullptr);
@@ -674,9 +781,11 @@ class ConcurrentCopying::VerifyNoFromSpaceRefsVisitor : public SingleRootVisitor
             << "To-space ref " << ref << " " << PrettyTypeOf(ref)
             << " has non-white rb_ptr " << ref->GetReadBarrierPointer();
       } else {
+        // A young collection doesn't mark the non-moving objects only reachable from the old
+        // objects.
         CHECK(ref->GetReadBarrierPointer() == ReadBarrier::BlackPtr() ||
               (ref->GetReadBarrierPointer() == ReadBarrier::WhitePtr() &&
-               collector_->IsOnAllocStack(ref)))
+               (collector_->young_gen_ || collector_->IsOnAllocStack(ref))))
             << "Non-moving/unevac from space ref " << ref << " " << PrettyTypeOf(ref)
             << " has non-black rb_ptr " << ref->GetReadBarrierPointer()
             << " but isn't on the alloc stack (and has white rb_ptr)."
@@ -975,10 +1084,15 @@ bool ConcurrentCopying::ProcessMarkStackOnce() {
   if (mark_stack_mode == kMarkStackModeThreadLocal) {
     // Process the thread-local mark stacks and the GC mark stack.
     count += ProcessThreadLocalMarkStacks(false);
-    while (!gc_mark_stack_->IsEmpty()) {
-      mirror::Object* to_ref = gc_mark_stack_->PopBack();
-      ProcessMarkStackRef(to_ref);
-      ++count;
+    const size_t thread_count = GetParallelMarkThreadCount();
+    if (thread_count > 1 && gc_mark_stack_->Size() >= kMinimumParallelMarkStackSize) {
+      count += ProcessMarkStackParallel(thread_count);
+    } else {
+      while (!gc_mark_stack_->IsEmpty()) {
+        mirror::Object* to_ref = gc_mark_stack_->PopBack();
+        ProcessMarkStackRef(to_ref);
+        ++count;
+      }
     }
     gc_mark_stack_->Reset();
   } else if (mark_stack_mode == kMarkStackModeShared) {
@@ -1058,6 +1172,168 @@ size_t ConcurrentCopying::ProcessThreadLocalMarkStacks(bool disable_weak_ref_acc
   return count;
 }
 
+class ConcurrentCopying::ParallelMarkTask : public SelfDeletingTask {
+ public:
+  ParallelMarkTask(ConcurrentCopying* concurrent_copying, size_t worker_index)
+      : concurrent_copying_(concurrent_copying), worker_index_(worker_index) {
+  }
+
+  virtual void Run(Thread* self ATTRIBUTE_UNUSED) OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+    // The GC-running thread holds the mutator lock on our behalf while we run.
+    concurrent_copying_->ParallelMark(worker_index_);
+  }
+
+ private:
+  ConcurrentCopying* const concurrent_copying_;
+  const size_t worker_index_;
+};
+
+size_t ConcurrentCopying::GetParallelMarkThreadCount() const {
+  ThreadPool* thread_pool = heap_->GetThreadPool();
+  // Use less threads if we are in a background state (non jank perceptible) since we want to leave
+  // more CPU time for the foreground apps.
+  if (!kEnableParallelMarking ||
+      thread_pool == nullptr ||
+      !Runtime::Current()->InJankPerceptibleProcessState()) {
+    return 1;
+  }
+  return std::min(heap_->GetConcGCThreadCount(), thread_pool->GetThreadCount()) + 1;
+}
+
+// Process the GC mark stack with the GC-running thread and thread_count - 1 heap thread pool
+// workers. Objects newly marked by the marking threads go onto per-thread work-stealing deques
+// while objects marked by mutators keep going onto their thread-local mark stacks and are
+// processed by the caller afterwards.
+size_t ConcurrentCopying::ProcessMarkStackParallel(size_t thread_count) {
+  TimingLogger::ScopedTiming split("ProcessMarkStackParallel", GetTimings());
+  Thread* self = Thread::Current();
+  DCHECK_EQ(self, thread_running_gc_);
+  DCHECK_EQ(static_cast<uint32_t>(mark_stack_mode_.LoadRelaxed()),
+            static_cast<uint32_t>(kMarkStackModeThreadLocal));
+  ThreadPool* thread_pool = heap_->GetThreadPool();
+  while (parallel_mark_workers_.size() < thread_count) {
+    parallel_mark_workers_.emplace_back(new ParallelMarkWorker(kParallelMarkDequeSize));
+  }
+  num_parallel_mark_workers_.StoreRelease(thread_count);
+  {
+    // Distribute the GC mark stack over the deques.
+    MutexLock mu(self, mark_stack_lock_);
+    DCHECK(parallel_mark_overflow_.empty());
+    size_t i = 0;
+    for (StackReference<mirror::Object>* p = gc_mark_stack_->Begin();
+         p != gc_mark_stack_->End(); ++p, ++i) {
+      ParallelMarkWorker* worker = parallel_mark_workers_[i % thread_count].get();
+      if (!worker->deque.Push(p->AsMirrorPtr())) {
+        parallel_mark_overflow_.push_back(p->AsMirrorPtr());
+      }
+    }
+    gc_mark_stack_->Reset();
+  }
+  parallel_mark_count_.StoreRelaxed(0);
+  num_active_parallel_markers_.StoreRelaxed(0);
+  parallel_mark_done_.StoreRelaxed(false);
+  is_parallel_marking_.StoreRelease(true);
+  QuasiAtomic::ThreadFenceSequentiallyConsistent();
+  for (size_t i = 1; i < thread_count; ++i) {
+    thread_pool->AddTask(self, new ParallelMarkTask(this, i));
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  thread_pool->StartWorkers(self);
+  ParallelMark(0);
+  thread_pool->Wait(self, false, true);
+  thread_pool->StopWorkers(self);
+  is_parallel_marking_.StoreRelease(false);
+  QuasiAtomic::ThreadFenceSequentiallyConsistent();
+  for (size_t i = 0; i < thread_count; ++i) {
+    ParallelMarkWorker* worker = parallel_mark_workers_[i].get();
+    CHECK(worker->deque.IsEmpty());
+    worker->deque.Reset();
+  }
+  {
+    MutexLock mu(self, mark_stack_lock_);
+    CHECK(parallel_mark_overflow_.empty());
+  }
+  num_parallel_mark_workers_.StoreRelease(0);
+  return parallel_mark_count_.LoadRelaxed();
+}
+
+// Runs on each marking thread. Terminates once no marking thread has work left. Only marking
+// threads push onto the deques or the overflow stack, so no new work can show up after that.
+void ConcurrentCopying::ParallelMark(size_t worker_index) {
+  Thread* self = Thread::Current();
+  DCHECK_LT(worker_index, num_parallel_mark_workers_.LoadAcquire());
+  ParallelMarkWorker* worker = parallel_mark_workers_[worker_index].get();
+  if (parallel_mark_done_.LoadSequentiallyConsistent()) {
+    // Started too late, the other threads already finished.
+    return;
+  }
+  DCHECK(self->GetThreadLocalMarkDeque() == nullptr);
+  self->SetThreadLocalMarkDeque(&worker->deque);
+  num_active_parallel_markers_.FetchAndAddSequentiallyConsistent(1);
+  size_t count = 0;
+  while (true) {
+    mirror::Object* to_ref = worker->deque.Pop();
+    if (to_ref == nullptr) {
+      to_ref = StealParallelMarkWork(worker_index);
+    }
+    if (to_ref != nullptr) {
+      ProcessMarkStackRef(to_ref);
+      ++count;
+      continue;
+    }
+    // Out of work. Wait until there is something to steal or until everybody is out of work.
+    num_active_parallel_markers_.FetchAndSubSequentiallyConsistent(1);
+    while (true) {
+      if (parallel_mark_done_.LoadSequentiallyConsistent()) {
+        parallel_mark_count_.FetchAndAddSequentiallyConsistent(count);
+        self->SetThreadLocalMarkDeque(nullptr);
+        return;
+      }
+      if (HasParallelMarkWork()) {
+        num_active_parallel_markers_.FetchAndAddSequentiallyConsistent(1);
+        break;
+      }
+      if (num_active_parallel_markers_.LoadSequentiallyConsistent() == 0 &&
+          !HasParallelMarkWork()) {
+        parallel_mark_done_.StoreSequentiallyConsistent(true);
+        parallel_mark_count_.FetchAndAddSequentiallyConsistent(count);
+        self->SetThreadLocalMarkDeque(nullptr);
+        return;
+      }
+      sched_yield();
+    }
+  }
+}
+
+mirror::Object* ConcurrentCopying::StealParallelMarkWork(size_t worker_index) {
+  const size_t num_workers = num_parallel_mark_workers_.LoadAcquire();
+  for (size_t i = 1; i < num_workers; ++i) {
+    ParallelMarkWorker* victim = parallel_mark_workers_[(worker_index + i) % num_workers].get();
+    mirror::Object* to_ref = victim->deque.Steal();
+    if (to_ref != nullptr) {
+      return to_ref;
+    }
+  }
+  MutexLock mu(Thread::Current(), mark_stack_lock_);
+  if (!parallel_mark_overflow_.empty()) {
+    mirror::Object* to_ref = parallel_mark_overflow_.back();
+    parallel_mark_overflow_.pop_back();
+    return to_ref;
+  }
+  return nullptr;
+}
+
+bool ConcurrentCopying::HasParallelMarkWork() {
+  const size_t num_workers = num_parallel_mark_workers_.LoadAcquire();
+  for (size_t i = 0; i < num_workers; ++i) {
+    if (!parallel_mark_workers_[i]->deque.IsEmpty()) {
+      return true;
+    }
+  }
+  MutexLock mu(Thread::Current(), mark_stack_lock_);
+  return !parallel_mark_overflow_.empty();
+}
+
 inline void ConcurrentCopying::ProcessMarkStackRef(mirror::Object* to_ref) {
   DCHECK(!region_space_->IsInFromSpace(to_ref));
   if (kUseBakerReadBarrier) {
@@ -1201,9 +1477,17 @@ void ConcurrentCopying::Sweep(bool swap_bitmaps) {
       CHECK_GE(live_stack_freeze_size_, live_stack->Size());
     }
     heap_->MarkAllocStackAsLive(live_stack);
+    if (young_gen_) {
+      SweepNewLargeObjects(live_stack);
+    }
     live_stack->Reset();
   }
   CheckEmptyMarkStack();
+  if (young_gen_) {
+    // The objects only reachable from the old objects aren't marked, so the non-moving spaces
+    // can't be swept. Their garbage is left to the next full collection.
+    return;
+  }
   TimingLogger::ScopedTiming split("Sweep", GetTimings());
   for (const auto& space : GetHeap()->GetContinuousSpaces()) {
     if (space->IsContinuousMemMapAllocSpace()) {
@@ -1224,6 +1508,34 @@ void ConcurrentCopying::SweepLargeObjects(bool swap_bitmaps) {
   RecordFreeLOS(heap_->GetLargeObjectsSpace()->Sweep(swap_bitmaps));
 }
 
+// Free the unmarked large objects allocated since the last collection. Large objects are primitive
+// arrays or strings, so an old object can only refer to a new one after a write that dirtied its
+// card, in which case the young collection scanned it.
+void ConcurrentCopying::SweepNewLargeObjects(accounting::ObjectStack* live_stack) {
+  TimingLogger::ScopedTiming split("SweepNewLargeObjects", GetTimings());
+  space::LargeObjectSpace* large_object_space = heap_->GetLargeObjectsSpace();
+  if (large_object_space == nullptr) {
+    return;
+  }
+  accounting::LargeObjectBitmap* live_bitmap = large_object_space->GetLiveBitmap();
+  accounting::LargeObjectBitmap* mark_bitmap = large_object_space->GetMarkBitmap();
+  Thread* self = Thread::Current();
+  ObjectBytePair freed;
+  for (auto* it = live_stack->Begin(), *end = live_stack->End(); it != end; ++it) {
+    mirror::Object* obj = it->AsMirrorPtr();
+    if (obj == nullptr || heap_->non_moving_space_->HasAddress(obj)) {
+      continue;
+    }
+    DCHECK(large_object_space->Contains(obj)) << obj;
+    if (!mark_bitmap->Test(obj)) {
+      live_bitmap->Clear(obj);
+      freed.bytes += large_object_space->Free(self, obj);
+      ++freed.objects;
+    }
+  }
+  RecordFreeLOS(freed);
+}
+
 class ConcurrentCopying::ClearBlackPtrsVisitor {
  public:
   explicit ClearBlackPtrsVisitor(ConcurrentCopying* cc) : collector_(cc) {}
@@ -1329,19 +1641,34 @@ void ConcurrentCopying::ReclaimPhase() {
       LOG(INFO) << "(before) num_bytes_allocated=" << heap_->num_bytes_allocated_.LoadSequentiallyConsistent();
     }
     RecordFree(ObjectBytePair(freed_objects, freed_bytes));
+    cumulative_bytes_copied_ += to_bytes;
+    cumulative_bytes_reclaimed_ += freed_bytes;
+    VLOG(gc) << "Concurrent copying copied " << PrettySize(to_bytes) << " and reclaimed "
+             << PrettySize(freed_bytes) << " in the region space";
     if (kVerboseMode) {
       LOG(INFO) << "(after) num_bytes_allocated=" << heap_->num_bytes_allocated_.LoadSequentiallyConsistent();
     }
+    // What is left allocated approximates the live data that the marking phase traced.
+    const uint64_t live_bytes = heap_->GetBytesAllocated();
+    cumulative_marking_time_ns_ += marking_time_ns_;
+    cumulative_live_bytes_ += live_bytes;
+    VLOG(gc) << "Concurrent copying marked " << PrettySize(live_bytes) << " in "
+             << PrettyDuration(marking_time_ns_) << " with " << GetParallelMarkThreadCount()
+             << " marking threads";
   }
 
-  {
+  if (!young_gen_) {
+    // A young collection has no unevacuated from-space regions.
     TimingLogger::ScopedTiming split3("ComputeUnevacFromSpaceLiveRatio", GetTimings());
     ComputeUnevacFromSpaceLiveRatio();
   }
 
   {
     TimingLogger::ScopedTiming split4("ClearFromSpace", GetTimings());
-    region_space_->ClearFromSpace();
+    // The pause cleared the cards that a young collection scanned, but the cards of the young
+    // regions dirtied since then would make the next young collection scan the objects allocated
+    // in the freed regions. A full collection clears all the cards in its pause instead.
+    region_space_->ClearFromSpace(young_gen_ ? heap_->GetCardTable() : nullptr);
   }
 
   {
@@ -1350,7 +1677,10 @@ void ConcurrentCopying::ReclaimPhase() {
       ClearBlackPtrs();
     }
     Sweep(false);
-    SwapBitmaps();
+    if (!young_gen_) {
+      // A young collection didn't sweep the non-moving spaces, their live bitmaps stay valid.
+      SwapBitmaps();
+    }
     heap_->UnBindBitmaps();
 
     // Remove bitmaps for the immune spaces.
@@ -1360,6 +1690,11 @@ void ConcurrentCopying::ReclaimPhase() {
       delete cc_bitmap;
       cc_bitmaps_.pop_back();
     }
+    cc_heap_bitmap_->RemoveContinuousSpaceBitmap(region_space_bitmap_);
+    if (!heap_->use_generational_cc_) {
+      // Nothing needs the marks until the next collection, release the memory.
+      region_space_bitmap_->Clear();
+    }
     region_space_bitmap_ = nullptr;
   }
 
@@ -1378,7 +1713,12 @@ class ConcurrentCopying::ComputeUnevacFromSpaceLiveRatioVisitor {
       SHARED_REQUIRES(Locks::heap_bitmap_lock_) {
     DCHECK(ref != nullptr);
     DCHECK(collector_->region_space_bitmap_->Test(ref)) << ref;
-    DCHECK(collector_->region_space_->IsInUnevacFromSpace(ref)) << ref;
+    if (!collector_->region_space_->IsInUnevacFromSpace(ref)) {
+      // With generational collection the evacuated objects are marked too.
+      DCHECK(collector_->heap_->use_generational_cc_) << ref;
+      DCHECK(collector_->region_space_->IsInToSpace(ref)) << ref;
+      return;
+    }
     if (kUseBakerReadBarrier) {
       DCHECK_EQ(ref->GetReadBarrierPointer(), ReadBarrier::BlackPtr()) << ref;
       // Clear the black ptr.
@@ -1545,6 +1885,11 @@ void ConcurrentCopying::LogFromSpaceRefHolder(mirror::Object* obj, MemberOffset
 
 void ConcurrentCopying::AssertToSpaceInvariantInNonMovingSpace(mirror::Object* obj,
                                                                mirror::Object* ref) {
+  if (young_gen_) {
+    // The non-moving objects only reachable from the old objects aren't marked by a young
+    // collection, but they don't refer to from-space objects either, see ScanDirtyCards().
+    return;
+  }
   // In a non-moving spaces. Check that the ref is marked.
   if (immune_spaces_.ContainsObject(ref)) {
     accounting::ContinuousSpaceBitmap* cc_bitmap =
@@ -1894,9 +2239,18 @@ mirror::Object* ConcurrentCopying::Copy(mirror::Object* from_ref) {
       bytes_moved_.FetchAndAddSequentiallyConsistent(region_space_alloc_size);
       if (LIKELY(!fall_back_to_non_moving)) {
         DCHECK(region_space_->IsInToSpace(to_ref));
+        if (heap_->use_generational_cc_) {
+          // The object is old from now on. Record it so that a young collection can find it on
+          // a dirty card.
+          region_space_bitmap_->AtomicTestAndSet(to_ref);
+        }
       } else {
         DCHECK(heap_->non_moving_space_->HasAddress(to_ref));
         DCHECK_EQ(bytes_allocated, non_moving_space_bytes_allocated);
+        if (young_gen_) {
+          // A young collection doesn't swap the bitmaps of the non-moving space.
+          heap_->non_moving_space_->GetLiveBitmap()->AtomicTestAndSet(to_ref);
+        }
       }
       if (kUseBakerReadBarrier) {
         DCHECK(to_ref->GetReadBarrierPointer() == ReadBarrier::GrayPtr());
@@ -1919,6 +2273,13 @@ mirror::Object* ConcurrentCopying::IsMarked(mirror::Object* from_ref) {
     // It's already marked.
     return from_ref;
   }
+  if (young_gen_ && rtype == space::RegionSpace::RegionType::kRegionTypeNone &&
+      IsOldNonMovingObject(from_ref)) {
+    // A young collection doesn't mark the old objects that only old objects refer to, and
+    // doesn't free them either. Treat them as marked so that the system weaks, the references
+    // and the monitors of the live objects are kept.
+    return from_ref;
+  }
   mirror::Object* to_ref;
   if (rtype == space::RegionSpace::RegionType::kRegionTypeFromSpace) {
     to_ref = GetFwdPtr(from_ref);
@@ -1978,6 +2339,18 @@ mirror::Object* ConcurrentCopying::IsMarked(mirror::Object* from_ref) {
   return to_ref;
 }
 
+bool ConcurrentCopying::IsOldNonMovingObject(mirror::Object* ref) {
+  DCHECK(young_gen_);
+  space::LargeObjectSpace* large_object_space = heap_->GetLargeObjectsSpace();
+  if (large_object_space == nullptr || !large_object_space->Contains(ref)) {
+    // A young collection doesn't sweep the non-moving spaces, everything there survives it.
+    return true;
+  }
+  // The large objects allocated since the last collection are freed unless marked, see
+  // SweepNewLargeObjects(). They are not in the live bitmap until the sweep.
+  return large_object_space->GetLiveBitmap()->Test(ref);
+}
+
 bool ConcurrentCopying::IsOnAllocStack(mirror::Object* ref) {
   QuasiAtomic::ThreadFenceAcquire();
   accounting::ObjectStack* alloc_stack = GetAllocationStack();
@@ -2111,6 +2484,31 @@ void ConcurrentCopying::ProcessReferences(Thread* self) {
       true /*concurrent*/, GetTimings(), GetCurrentIteration()->GetClearSoftReferences(), this);
 }
 
+void ConcurrentCopying::DumpPerformanceInfo(std::ostream& os) {
+  GarbageCollector::DumpPerformanceInfo(os);
+  if (cumulative_live_bytes_ != 0) {
+    os << GetName() << " marking time per GB live: "
+       << PrettyDuration(static_cast<uint64_t>(
+           static_cast<double>(cumulative_marking_time_ns_) * GB / cumulative_live_bytes_))
+       << " with " << GetParallelMarkThreadCount() << " marking threads\n";
+  }
+  const uint64_t iterations = NumberOfIterations();
+  if (iterations != 0) {
+    os << GetName() << " bytes copied: " << PrettySize(cumulative_bytes_copied_)
+       << " (" << PrettySize(cumulative_bytes_copied_ / iterations) << " per cycle)\n";
+    os << GetName() << " bytes reclaimed: " << PrettySize(cumulative_bytes_reclaimed_)
+       << " (" << PrettySize(cumulative_bytes_reclaimed_ / iterations) << " per cycle)\n";
+  }
+  // region_space_ is only set during a collection. The counters belong to the region space, so
+  // only the full collector prints them when there is a young one too.
+  space::RegionSpace* region_space = heap_->GetRegionSpace();
+  if (!young_gen_ && region_space != nullptr && region_space->GetNumaPoolCount() > 1U) {
+    os << GetName() << " TLABs from the local NUMA node: " << region_space->GetNumaLocalTlabs()
+       << ", from a remote node: " << region_space->GetNumaRemoteTlabs() << " ("
+       << region_space->GetNumaPoolCount() << " nodes)\n";
+  }
+}
+
 void ConcurrentCopying::RevokeAllThreadLocalBuffers() {
   TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
   region_space_->RevokeAllThreadLocalBuffers();
@@ -26,6 +26,7 @@
 #include "gc/accounting/atomic_stack.h"
 #include "gc/accounting/read_barrier_table.h"
 #include "gc/accounting/space_bitmap.h"
+#include "gc/accounting/work_stealing_deque.h"
 #include "mirror/object.h"
 #include "mirror/object_reference.h"
 #include "safe_map.h"
@@ -58,8 +59,13 @@ class ConcurrentCopying : public GarbageCollector {
   static constexpr bool kEnableFromSpaceAccountingCheck = true;
   // Enable verbose mode.
   static constexpr bool kVerboseMode = false;
+  // Enable parallel marking with the heap thread pool in the thread-local mark stack mode.
+  static constexpr bool kEnableParallelMarking = true;
 
-  ConcurrentCopying(Heap* heap, const std::string& name_prefix = "");
+  // A young collection (young_gen is true) only evacuates the regions allocated since the last
+  // collection. Objects in the older regions are treated as live and only the ones on dirty cards
+  // are scanned.
+  ConcurrentCopying(Heap* heap, bool young_gen, const std::string& name_prefix = "");
   ~ConcurrentCopying();
 
   virtual void RunPhases() OVERRIDE REQUIRES(!mark_stack_lock_, !skipped_blocks_lock_);
@@ -72,7 +78,7 @@ class ConcurrentCopying : public GarbageCollector {
   void BindBitmaps() SHARED_REQUIRES(Locks::mutator_lock_)
       REQUIRES(!Locks::heap_bitmap_lock_);
   virtual GcType GetGcType() const OVERRIDE {
-    return kGcTypePartial;
+    return young_gen_ ? kGcTypeSticky : kGcTypePartial;
   }
   virtual CollectorType GetCollectorType() const OVERRIDE {
     return kCollectorTypeCC;
@@ -109,8 +115,17 @@ class ConcurrentCopying : public GarbageCollector {
   }
   void RevokeThreadLocalMarkStack(Thread* thread) SHARED_REQUIRES(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
+  virtual void DumpPerformanceInfo(std::ostream& os) OVERRIDE REQUIRES(!pause_histogram_lock_);
 
  private:
+  // Per-thread state for parallel marking. Each marking thread pushes newly marked objects onto
+  // its own deque, found through Thread::GetThreadLocalMarkDeque(), and steals from the others
+  // when it runs out of work.
+  struct ParallelMarkWorker {
+    explicit ParallelMarkWorker(size_t capacity) : deque(capacity) {}
+    accounting::WorkStealingDeque<mirror::Object> deque;
+  };
+
   void PushOntoMarkStack(mirror::Object* obj) SHARED_REQUIRES(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
   mirror::Object* Copy(mirror::Object* from_ref) SHARED_REQUIRES(Locks::mutator_lock_)
@@ -134,6 +149,13 @@ class ConcurrentCopying : public GarbageCollector {
   virtual void ProcessMarkStack() OVERRIDE SHARED_REQUIRES(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
   bool ProcessMarkStackOnce() SHARED_REQUIRES(Locks::mutator_lock_) REQUIRES(!mark_stack_lock_);
+  size_t GetParallelMarkThreadCount() const;
+  size_t ProcessMarkStackParallel(size_t thread_count) SHARED_REQUIRES(Locks::mutator_lock_)
+      REQUIRES(!mark_stack_lock_);
+  void ParallelMark(size_t worker_index) SHARED_REQUIRES(Locks::mutator_lock_)
+      REQUIRES(!mark_stack_lock_);
+  mirror::Object* StealParallelMarkWork(size_t worker_index) REQUIRES(!mark_stack_lock_);
+  bool HasParallelMarkWork() REQUIRES(!mark_stack_lock_);
   void ProcessMarkStackRef(mirror::Object* to_ref) SHARED_REQUIRES(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
   size_t ProcessThreadLocalMarkStacks(bool disable_weak_ref_access)
@@ -169,11 +191,17 @@ class ConcurrentCopying : public GarbageCollector {
   void CheckEmptyMarkStack() SHARED_REQUIRES(Locks::mutator_lock_) REQUIRES(!mark_stack_lock_);
   void IssueEmptyCheckpoint() SHARED_REQUIRES(Locks::mutator_lock_);
   bool IsOnAllocStack(mirror::Object* ref) SHARED_REQUIRES(Locks::mutator_lock_);
+  // Whether a young collection keeps ref, an object outside the region space, alive.
+  bool IsOldNonMovingObject(mirror::Object* ref) SHARED_REQUIRES(Locks::mutator_lock_);
   mirror::Object* GetFwdPtr(mirror::Object* from_ref)
       SHARED_REQUIRES(Locks::mutator_lock_);
   void FlipThreadRoots() REQUIRES(!Locks::mutator_lock_);
   void SwapStacks() SHARED_REQUIRES(Locks::mutator_lock_);
   void RecordLiveStackFreezeSize(Thread* self);
+  void ScanDirtyCards() REQUIRES(Locks::mutator_lock_, !mark_stack_lock_, !skipped_blocks_lock_);
+  void ClearCards() REQUIRES(Locks::mutator_lock_);
+  void SweepNewLargeObjects(accounting::ObjectStack* live_stack)
+      SHARED_REQUIRES(Locks::mutator_lock_) REQUIRES(Locks::heap_bitmap_lock_);
   void ComputeUnevacFromSpaceLiveRatio();
   void LogFromSpaceRefHolder(mirror::Object* obj, MemberOffset offset)
       SHARED_REQUIRES(Locks::mutator_lock_);
@@ -187,6 +215,7 @@ class ConcurrentCopying : public GarbageCollector {
       REQUIRES(!mark_stack_lock_, !skipped_blocks_lock_);
 
   space::RegionSpace* region_space_;      // The underlying region space.
+  const bool young_gen_;                  // True for a young (sticky) collection.
   std::unique_ptr<Barrier> gc_barrier_;
   std::unique_ptr<accounting::ObjectStack> gc_mark_stack_;
   Mutex mark_stack_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
@@ -222,6 +251,26 @@ class ConcurrentCopying : public GarbageCollector {
   Atomic<MarkStackMode> mark_stack_mode_;
   Atomic<bool> weak_ref_access_enabled_;
 
+  // Parallel marking state. The workers are created lazily and reused across GCs. Objects that
+  // don't fit in a worker's deque spill over to parallel_mark_overflow_. The GC-running thread
+  // only changes parallel_mark_workers_ while no marking thread runs, and publishes the workers
+  // to the marking threads by a release store of num_parallel_mark_workers_.
+  std::vector<std::unique_ptr<ParallelMarkWorker>> parallel_mark_workers_;
+  Atomic<size_t> num_parallel_mark_workers_;
+  std::vector<mirror::Object*> parallel_mark_overflow_ GUARDED_BY(mark_stack_lock_);
+  Atomic<bool> is_parallel_marking_;
+  Atomic<bool> parallel_mark_done_;
+  // Number of marking threads which are not looking for work.
+  Atomic<int32_t> num_active_parallel_markers_;
+  Atomic<size_t> parallel_mark_count_;
+  // Wall time of the marking phase and the bytes that survived, for the mark rate statistics.
+  uint64_t marking_time_ns_;
+  uint64_t cumulative_marking_time_ns_;
+  uint64_t cumulative_live_bytes_;
+  // Region space bytes copied to the to-space and freed in the from-space, over all collections.
+  uint64_t cumulative_bytes_copied_;
+  uint64_t cumulative_bytes_reclaimed_;
+
   // How many objects and bytes we moved. Used for accounting.
   Atomic<size_t> bytes_moved_;
   Atomic<size_t> objects_moved_;
@@ -242,10 +291,12 @@ class ConcurrentCopying : public GarbageCollector {
   class AssertToSpaceInvariantRefsVisitor;
   class ClearBlackPtrsVisitor;
   class ComputeUnevacFromSpaceLiveRatioVisitor;
+  class DirtyCardObjectVisitor;
   class DisableMarkingCheckpoint;
   class FlipCallback;
   class ImmuneSpaceObjVisitor;
   class LostCopyVisitor;
+  class ParallelMarkTask;
   class RefFieldsVisitor;
   class RevokeThreadLocalMarkStackCheckpoint;
   class VerifyNoFromSpaceRefsFieldVisitor;
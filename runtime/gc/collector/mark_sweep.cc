@@ -20,6 +20,7 @@
 #include <functional>
 #include <numeric>
 #include <climits>
+#include <limits>
 #include <vector>
 
 #include "base/bounded_fifo.h"
@@ -36,6 +37,7 @@
 #include "gc/heap.h"
 #include "gc/reference_processor.h"
 #include "gc/space/large_object_space.h"
+#include "gc/space/rosalloc_space-inl.h"
 #include "gc/space/space-inl.h"
 #include "mark_sweep-inl.h"
 #include "mirror/object-inl.h"
@@ -78,6 +80,21 @@ static constexpr bool kVerifyRootsMarked = kIsDebugBuild;
 // checkpoint, as opposed to during the pause.
 static constexpr bool kRevokeRosAllocThreadLocalBuffersAtCheckpoint = true;
 
+// Sweep the RosAlloc spaces and the large object space with the GC thread pool.
+static constexpr bool kParallelSweep = true;
+// Spaces smaller than this are swept by the GC thread only.
+static constexpr size_t kMinimumParallelSweepBytes = 4 * MB;
+// Split the sweeping into more ranges than threads to balance the load.
+static constexpr size_t kSweepRangesPerThread = 4;
+// Allocation stacks with fewer entries than this are swept by the GC thread only.
+static constexpr size_t kMinimumParallelSweepArrayObjects = 64 * KB;
+
+// The maximum number of sparse RosAlloc runs retired per GC, see RosAlloc::RetireSparseRuns().
+// This also bounds how many runs the next full or partial GC moves the objects out of.
+static constexpr size_t kMaxRetiredRosAllocRunsPerGc = 64;
+// Move the marked objects out of the retired runs in a second pause, see EvacuatePhase().
+static constexpr bool kEvacuateRetiredRosAllocRuns = true;
+
 void MarkSweep::BindBitmaps() {
   TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
   WriterMutexLock mu(Thread::Current(), *Locks::heap_bitmap_lock_);
@@ -99,7 +116,11 @@ MarkSweep::MarkSweep(Heap* heap, bool is_concurrent, const std::string& name_pre
       gc_barrier_(new Barrier(0)),
       mark_stack_lock_("mark sweep mark stack lock", kMarkSweepMarkStackLock),
       is_concurrent_(is_concurrent),
-      live_stack_freeze_size_(0) {
+      live_stack_freeze_size_(0),
+      evacuation_space_(nullptr),
+      evacuation_begin_(0),
+      evacuation_end_(0),
+      evacuation_slots_lock_("mark sweep evacuation slots lock", kMarkSweepMarkStackLock) {
   std::string error_msg;
   MemMap* mem_map = MemMap::MapAnonymous(
       "mark sweep sweep array free buffer", nullptr,
@@ -162,6 +183,15 @@ void MarkSweep::RunPhases() {
     PausePhase();
     RevokeAllThreadLocalBuffers();
   }
+  {
+    // Process the references concurrently, before the evacuation since they may mark objects.
+    ReaderMutexLock mu(self, *Locks::mutator_lock_);
+    ProcessReferences(self);
+  }
+  if (evacuation_space_ != nullptr) {
+    ScopedPause pause(this);
+    EvacuatePhase();
+  }
   {
     // Sweeping always done concurrently, even for non concurrent mark sweep.
     ReaderMutexLock mu(self, *Locks::mutator_lock_);
@@ -256,6 +286,7 @@ void MarkSweep::MarkingPhase() {
   Thread* self = Thread::Current();
   BindBitmaps();
   FindDefaultSpaceBitmap();
+  SetUpRunEvacuation(self);
   // Process dirty cards and add dirty cards to mod union tables.
   // If the GC type is non sticky, then we just clear the cards instead of ageing them.
   heap_->ProcessCards(GetTimings(), false, true, GetGcType() != kGcTypeSticky);
@@ -314,8 +345,7 @@ void MarkSweep::MarkReachableObjects() {
 void MarkSweep::ReclaimPhase() {
   TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
   Thread* const self = Thread::Current();
-  // Process the references concurrently.
-  ProcessReferences(self);
+  // The references were processed before the evacuation, see RunPhases().
   SweepSystemWeaks(self);
   Runtime* const runtime = Runtime::Current();
   runtime->AllowNewSystemWeaks();
@@ -334,6 +364,293 @@ void MarkSweep::ReclaimPhase() {
     // Unbind the live and mark bitmaps.
     GetHeap()->UnBindBitmaps();
   }
+  RetireSparseRosAllocRuns(self);
+}
+
+void MarkSweep::RetireSparseRosAllocRuns(Thread* self) {
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  // Keep new objects out of the sparsest runs. The objects that are still alive by the next full
+  // or partial GC are moved out of them in its evacuation pause, or stay where they are until
+  // they die if the space is not movable.
+  for (space::ContinuousSpace* space : GetHeap()->GetContinuousSpaces()) {
+    if (space->IsRosAllocSpace() && !immune_spaces_.ContainsSpace(space)) {
+      size_t num_retired_runs = space->AsRosAllocSpace()->GetRosAlloc()->RetireSparseRuns(
+          self, kMaxRetiredRosAllocRunsPerGc);
+      VLOG(heap) << "Retired " << num_retired_runs << " sparse runs in " << space->GetName();
+    }
+  }
+}
+
+void MarkSweep::SetUpRunEvacuation(Thread* self) {
+  // Sticky GCs don't mark the old objects, so they can't tell which ones to move.
+  if (!kEvacuateRetiredRosAllocRuns || GetGcType() == kGcTypeSticky) {
+    return;
+  }
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  for (space::ContinuousSpace* space : GetHeap()->GetContinuousSpaces()) {
+    // Only spaces whose objects may move, JNI and the other native users of the objects of the
+    // other spaces hold on to their addresses.
+    if (space->IsRosAllocSpace() && space->CanMoveObjects() &&
+        !immune_spaces_.ContainsSpace(space)) {
+      space->AsRosAllocSpace()->GetRosAlloc()->GetRetiredRuns(self, &evacuated_runs_);
+      if (!evacuated_runs_.empty()) {
+        evacuation_space_ = space->AsRosAllocSpace();
+      }
+      break;
+    }
+  }
+  if (evacuation_space_ == nullptr) {
+    return;
+  }
+  uintptr_t begin = std::numeric_limits<uintptr_t>::max();
+  uintptr_t end = 0;
+  for (const std::pair<uint8_t*, uint8_t*>& run : evacuated_runs_) {
+    begin = std::min(begin, reinterpret_cast<uintptr_t>(run.first));
+    end = std::max(end, reinterpret_cast<uintptr_t>(run.second));
+  }
+  evacuated_pages_.assign((end - begin) / kPageSize, false);
+  for (const std::pair<uint8_t*, uint8_t*>& run : evacuated_runs_) {
+    for (uint8_t* page = run.first; page < run.second; page += kPageSize) {
+      evacuated_pages_[(reinterpret_cast<uintptr_t>(page) - begin) / kPageSize] = true;
+    }
+  }
+  evacuation_begin_ = begin;
+  evacuation_end_ = end;
+}
+
+inline mirror::Object* MarkSweep::GetForwardingAddress(mirror::Object* obj) {
+  if (!IsInEvacuatedRuns(obj)) {
+    return nullptr;
+  }
+  const LockWord lock_word = obj->GetLockWord(false);
+  if (lock_word.GetState() != LockWord::kForwardingAddress) {
+    return nullptr;
+  }
+  return reinterpret_cast<mirror::Object*>(lock_word.ForwardingAddress());
+}
+
+inline void MarkSweep::RecordEvacuationSlot(mirror::Object* ref,
+                                            mirror::Object* holder,
+                                            MemberOffset offset) {
+  if (IsInEvacuatedRuns(ref)) {
+    MutexLock mu(Thread::Current(), evacuation_slots_lock_);
+    evacuation_slots_.push_back(std::make_pair(holder, offset));
+  }
+}
+
+inline void MarkSweep::RecordEvacuationRoot(mirror::CompressedReference<mirror::Object>* root) {
+  if (IsInEvacuatedRuns(root->AsMirrorPtr())) {
+    MutexLock mu(Thread::Current(), evacuation_slots_lock_);
+    evacuation_roots_.push_back(root);
+  }
+}
+
+// Classes, dex caches and class loaders are referenced from native data structures, the
+// references are on the reference processor lists, and locked objects use their lock word.
+static bool CanEvacuate(mirror::Object* obj) SHARED_REQUIRES(Locks::mutator_lock_) {
+  if (obj->IsClass() || obj->IsDexCache() || obj->IsClassLoader() ||
+      obj->IsReferenceInstance()) {
+    return false;
+  }
+  const LockWord::LockState state = obj->GetLockWord(false).GetState();
+  return state == LockWord::kUnlocked || state == LockWord::kHashCode;
+}
+
+void MarkSweep::EvacuatePhase() {
+  TimingLogger::ScopedTiming t("(Paused)EvacuatePhase", GetTimings());
+  Thread* const self = Thread::Current();
+  Locks::mutator_lock_->AssertExclusiveHeld(self);
+  // JNI critical sections hold on to the addresses of the movable objects.
+  if (heap_->IsMovingGCDisabled(self)) {
+    VLOG(heap) << "Not evacuating the retired runs since moving GC is disabled";
+    return;
+  }
+  WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+  if (EvacuateRetiredRuns(self) != 0) {
+    UpdateEvacuatedReferences(self);
+  }
+}
+
+size_t MarkSweep::EvacuateRetiredRuns(Thread* self) {
+  TimingLogger::ScopedTiming t("(Paused)EvacuateRetiredRuns", GetTimings());
+  accounting::ContinuousSpaceBitmap* const mark_bitmap = evacuation_space_->GetMarkBitmap();
+  accounting::CardTable* const card_table = heap_->GetCardTable();
+  // Collect the objects first since setting the mark bits of the copies changes the bitmap.
+  std::vector<mirror::Object*> objects;
+  for (const std::pair<uint8_t*, uint8_t*>& run : evacuated_runs_) {
+    mark_bitmap->VisitMarkedRange(reinterpret_cast<uintptr_t>(run.first),
+                                  reinterpret_cast<uintptr_t>(run.second),
+                                  [&objects](mirror::Object* obj) {
+      objects.push_back(obj);
+    });
+  }
+  size_t moved_objects = 0;
+  size_t moved_bytes = 0;
+  for (mirror::Object* obj : objects) {
+    if (!CanEvacuate(obj)) {
+      continue;
+    }
+    const size_t object_size = obj->SizeOf();
+    size_t bytes_allocated = 0;
+    size_t usable_size = 0;
+    size_t bytes_tl_bulk_allocated = 0;
+    // The allocation never returns a slot of a retired run.
+    mirror::Object* copy = evacuation_space_->AllocThreadUnsafe(
+        self, object_size, &bytes_allocated, &usable_size, &bytes_tl_bulk_allocated);
+    if (copy == nullptr) {
+      // Out of space, leave the other objects where they are.
+      break;
+    }
+    memcpy(reinterpret_cast<void*>(copy), reinterpret_cast<void*>(obj), object_size);
+    obj->SetLockWord(LockWord::FromForwardingAddress(reinterpret_cast<size_t>(copy)), false);
+    // The copy survives the sweep and the original is freed along with its run.
+    mark_bitmap->Set(copy);
+    mark_bitmap->Clear(obj);
+    // Let the sticky GCs find the references to younger objects in the copy.
+    card_table->MarkCard(copy);
+    heap_->num_bytes_allocated_.FetchAndAddSequentiallyConsistent(bytes_tl_bulk_allocated);
+    ++moved_objects;
+    moved_bytes += bytes_allocated;
+  }
+  VLOG(heap) << "Evacuated " << moved_objects << " objects (" << PrettySize(moved_bytes)
+             << ") out of " << evacuated_runs_.size() << " retired runs in "
+             << evacuation_space_->GetName();
+  return moved_objects;
+}
+
+class MarkSweep::EvacuationUpdateVisitor : public MarkObjectVisitor {
+ public:
+  explicit EvacuationUpdateVisitor(MarkSweep* collector) : collector_(collector) {}
+
+  void operator()(mirror::Object* obj, MemberOffset offset, bool is_static ATTRIBUTE_UNUSED) const
+      ALWAYS_INLINE REQUIRES(Locks::mutator_lock_, Locks::heap_bitmap_lock_) {
+    Update(obj->GetFieldObjectReferenceAddr<kVerifyNone>(offset));
+  }
+
+  void operator()(mirror::Class* klass ATTRIBUTE_UNUSED, mirror::Reference* ref) const
+      REQUIRES(Locks::mutator_lock_, Locks::heap_bitmap_lock_) {
+    Update(ref->GetFieldObjectReferenceAddr<kVerifyNone>(mirror::Reference::ReferentOffset()));
+  }
+
+  // TODO: Remove NO_THREAD_SAFETY_ANALYSIS when clang better understands visitors.
+  void VisitRootIfNonNull(mirror::CompressedReference<mirror::Object>* root) const
+      NO_THREAD_SAFETY_ANALYSIS {
+    if (!root->IsNull()) {
+      VisitRoot(root);
+    }
+  }
+
+  void VisitRoot(mirror::CompressedReference<mirror::Object>* root) const
+      NO_THREAD_SAFETY_ANALYSIS {
+    Update(root);
+  }
+
+  // Used by the mod-union tables.
+  virtual mirror::Object* MarkObject(mirror::Object* obj) OVERRIDE
+      SHARED_REQUIRES(Locks::mutator_lock_) {
+    mirror::Object* forwarding_address = collector_->GetForwardingAddress(obj);
+    return forwarding_address != nullptr ? forwarding_address : obj;
+  }
+
+  virtual void MarkHeapReference(mirror::HeapReference<mirror::Object>* ref) OVERRIDE
+      SHARED_REQUIRES(Locks::mutator_lock_) {
+    Update(ref);
+  }
+
+ private:
+  template <typename Reference>
+  void Update(Reference* ref) const SHARED_REQUIRES(Locks::mutator_lock_) {
+    mirror::Object* forwarding_address = collector_->GetForwardingAddress(ref->AsMirrorPtr());
+    if (forwarding_address != nullptr) {
+      ref->Assign(forwarding_address);
+    }
+  }
+
+  MarkSweep* const collector_;
+};
+
+class MarkSweep::EvacuationUpdateRootVisitor : public RootVisitor {
+ public:
+  explicit EvacuationUpdateRootVisitor(MarkSweep* collector) : collector_(collector) {}
+
+  void VisitRoots(mirror::Object*** roots, size_t count, const RootInfo& info ATTRIBUTE_UNUSED)
+      OVERRIDE REQUIRES(Locks::mutator_lock_)
+      SHARED_REQUIRES(Locks::heap_bitmap_lock_) {
+    for (size_t i = 0; i < count; ++i) {
+      mirror::Object* forwarding_address = collector_->GetForwardingAddress(*roots[i]);
+      if (forwarding_address != nullptr) {
+        *roots[i] = forwarding_address;
+      }
+    }
+  }
+
+  void VisitRoots(mirror::CompressedReference<mirror::Object>** roots, size_t count,
+                  const RootInfo& info ATTRIBUTE_UNUSED)
+      OVERRIDE REQUIRES(Locks::mutator_lock_)
+      SHARED_REQUIRES(Locks::heap_bitmap_lock_) {
+    for (size_t i = 0; i < count; ++i) {
+      mirror::Object* forwarding_address =
+          collector_->GetForwardingAddress(roots[i]->AsMirrorPtr());
+      if (forwarding_address != nullptr) {
+        roots[i]->Assign(forwarding_address);
+      }
+    }
+  }
+
+ private:
+  MarkSweep* const collector_;
+};
+
+void MarkSweep::UpdateEvacuatedReferences(Thread* self) {
+  TimingLogger::ScopedTiming t("(Paused)UpdateEvacuatedReferences", GetTimings());
+  EvacuationUpdateVisitor visitor(this);
+  {
+    // The references found by the marking. Those of the moved objects are updated in the copies
+    // below, their cards are dirty.
+    MutexLock mu(self, evacuation_slots_lock_);
+    for (const std::pair<mirror::Object*, MemberOffset>& slot : evacuation_slots_) {
+      if (GetForwardingAddress(slot.first) == nullptr) {
+        visitor(slot.first, slot.second, false);
+      }
+    }
+    for (mirror::CompressedReference<mirror::Object>* root : evacuation_roots_) {
+      visitor.VisitRoot(root);
+    }
+  }
+  // The objects written to since they were marked, and the copies.
+  accounting::CardTable* const card_table = heap_->GetCardTable();
+  for (const auto& space : GetHeap()->GetContinuousSpaces()) {
+    if (space->GetMarkBitmap() != nullptr) {
+      card_table->Scan<false>(space->GetMarkBitmap(),
+                              space->Begin(),
+                              space->End(),
+                              [&visitor](mirror::Object* obj)
+          REQUIRES(Locks::mutator_lock_, Locks::heap_bitmap_lock_) {
+        obj->VisitReferences(visitor, visitor);
+      }, accounting::CardTable::kCardDirty);
+    }
+  }
+  // The objects allocated since the marking pause, which were not marked.
+  accounting::ObjectStack* const allocation_stack = heap_->allocation_stack_.get();
+  for (StackReference<mirror::Object>* it = allocation_stack->Begin();
+       it != allocation_stack->End();
+       ++it) {
+    mirror::Object* obj = it->AsMirrorPtr();
+    // The unused entries of the thread-local allocation stacks are null.
+    if (obj != nullptr) {
+      obj->VisitReferences(visitor, visitor);
+    }
+  }
+  // The roots, including the thread stacks.
+  EvacuationUpdateRootVisitor root_visitor(this);
+  Runtime::Current()->VisitRoots(&root_visitor);
+  // The references from the immune spaces that the mod-union tables remember instead of cards.
+  for (const auto& space : immune_spaces_.GetSpaces()) {
+    accounting::ModUnionTable* mod_union_table = heap_->FindModUnionTableFromSpace(space);
+    if (mod_union_table != nullptr) {
+      mod_union_table->UpdateAndMarkReferences(&visitor);
+    }
+  }
 }
 
 void MarkSweep::FindDefaultSpaceBitmap() {
@@ -679,7 +996,9 @@ class MarkSweep::MarkStackTask : public Task {
                     MemberOffset offset,
                     bool is_static ATTRIBUTE_UNUSED) const
         SHARED_REQUIRES(Locks::mutator_lock_) {
-      Mark(obj->GetFieldObject<mirror::Object>(offset));
+      mirror::Object* ref = obj->GetFieldObject<mirror::Object>(offset);
+      mark_sweep_->RecordEvacuationSlot(ref, obj, offset);
+      Mark(ref);
     }
 
     void VisitRootIfNonNull(mirror::CompressedReference<mirror::Object>* root) const
@@ -695,6 +1014,7 @@ class MarkSweep::MarkStackTask : public Task {
         Locks::mutator_lock_->AssertSharedHeld(Thread::Current());
         Locks::heap_bitmap_lock_->AssertExclusiveHeld(Thread::Current());
       }
+      mark_sweep_->RecordEvacuationRoot(root);
       Mark(root->AsMirrorPtr());
     }
 
@@ -1221,6 +1541,11 @@ void MarkSweep::SweepArray(accounting::ObjectStack* allocations, bool swap_bitma
     if (swap_bitmaps) {
       std::swap(live_bitmap, mark_bitmap);
     }
+    if (space->IsRosAllocSpace() && UseParallelSweepArray(count)) {
+      freed.Add(SweepArrayInParallel(space->AsRosAllocSpace(), live_bitmap, mark_bitmap, objects,
+                                     &count));
+      continue;
+    }
     StackReference<mirror::Object>* out = objects;
     for (size_t i = 0; i < count; ++i) {
       mirror::Object* const obj = objects[i].AsMirrorPtr();
@@ -1302,7 +1627,11 @@ void MarkSweep::Sweep(bool swap_bitmaps) {
       TimingLogger::ScopedTiming split(
           alloc_space->IsZygoteSpace() ? "SweepZygoteSpace" : "SweepMallocSpace",
           GetTimings());
-      RecordFree(alloc_space->Sweep(swap_bitmaps));
+      if (space->IsRosAllocSpace() && UseParallelSweep(space->Size())) {
+        RecordFree(SweepRosAllocSpaceInParallel(space->AsRosAllocSpace(), swap_bitmaps));
+      } else {
+        RecordFree(alloc_space->Sweep(swap_bitmaps));
+      }
     }
   }
   SweepLargeObjects(swap_bitmaps);
@@ -1312,13 +1641,364 @@ void MarkSweep::SweepLargeObjects(bool swap_bitmaps) {
   space::LargeObjectSpace* los = heap_->GetLargeObjectsSpace();
   if (los != nullptr) {
     TimingLogger::ScopedTiming split(__FUNCTION__, GetTimings());
-    RecordFreeLOS(los->Sweep(swap_bitmaps));
+    if (los->Begin() < los->End() &&
+        UseParallelSweep(static_cast<size_t>(los->End() - los->Begin()))) {
+      RecordFreeLOS(SweepLargeObjectsInParallel(los, swap_bitmaps));
+    } else {
+      RecordFreeLOS(los->Sweep(swap_bitmaps));
+    }
+  }
+}
+
+bool MarkSweep::UseParallelSweep(size_t space_size) const {
+  return kParallelSweep && space_size >= kMinimumParallelSweepBytes && GetThreadCount(false) > 1;
+}
+
+// Sweeps a range of a space. The ranges of the tasks running at the same time share neither words
+// of the bitmaps nor RosAlloc runs.
+template <typename BitmapType>
+class SweepTask : public Task {
+ public:
+  SweepTask(space::AllocSpace* alloc_space,
+            space::RosAllocSpace* rosalloc_space,
+            const BitmapType* live_bitmap,
+            const BitmapType* mark_bitmap,
+            BitmapType* bitmap_to_clear,
+            uintptr_t begin,
+            uintptr_t end,
+            ObjectBytePair* freed)
+      : alloc_space_(alloc_space),
+        rosalloc_space_(rosalloc_space),
+        live_bitmap_(live_bitmap),
+        mark_bitmap_(mark_bitmap),
+        bitmap_to_clear_(bitmap_to_clear),
+        begin_(begin),
+        end_(end),
+        freed_(freed),
+        self_(nullptr) {}
+
+  // The GC thread holds the heap bitmap lock on behalf of the sweeping threads.
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    self_ = self;
+    BitmapType::SweepWalk(*live_bitmap_, *mark_bitmap_, begin_, end_, &SweepCallback, this);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  static void SweepCallback(size_t num_ptrs, mirror::Object** ptrs, void* arg)
+      NO_THREAD_SAFETY_ANALYSIS {
+    SweepTask* task = reinterpret_cast<SweepTask*>(arg);
+    // If the bitmaps aren't swapped we need to clear the bits since the GC isn't going to
+    // re-swap the bitmaps as an optimization.
+    if (task->bitmap_to_clear_ != nullptr) {
+      for (size_t i = 0; i < num_ptrs; ++i) {
+        task->bitmap_to_clear_->Clear(ptrs[i]);
+      }
+    }
+    task->freed_->objects += num_ptrs;
+    if (task->rosalloc_space_ != nullptr) {
+      task->freed_->bytes +=
+          task->rosalloc_space_->FreeListInParallelSweep(task->self_, num_ptrs, ptrs);
+    } else {
+      task->freed_->bytes += task->alloc_space_->FreeList(task->self_, num_ptrs, ptrs);
+    }
+  }
+
+  space::AllocSpace* const alloc_space_;
+  space::RosAllocSpace* const rosalloc_space_;
+  const BitmapType* const live_bitmap_;
+  const BitmapType* const mark_bitmap_;
+  BitmapType* const bitmap_to_clear_;
+  const uintptr_t begin_;
+  const uintptr_t end_;
+  ObjectBytePair* const freed_;
+  Thread* self_;
+};
+
+// Returns the boundaries of the ranges to sweep in parallel: [begin, b1), [b1, b2), ... [bn, end).
+// Boundaries are aligned to the bitmap words so that tasks can clear bits without atomics. If
+// rosalloc is not null, they are also moved past any run or large object they fall into.
+template <typename BitmapType>
+static std::vector<uintptr_t> ComputeSweepRanges(const BitmapType* bitmap,
+                                                 uintptr_t begin,
+                                                 uintptr_t end,
+                                                 size_t num_ranges,
+                                                 allocator::RosAlloc* rosalloc) {
+  const uintptr_t heap_begin = bitmap->HeapBegin();
+  const uintptr_t word_span = BitmapType::template IndexToOffset<uintptr_t>(1);
+  const uintptr_t range_size = RoundUp((end - begin) / num_ranges + 1, word_span);
+  std::vector<uintptr_t> boundaries;
+  boundaries.push_back(begin);
+  for (uintptr_t addr = begin + range_size; addr < end; addr += range_size) {
+    uintptr_t boundary = heap_begin + RoundUp(addr - heap_begin, word_span);
+    if (rosalloc != nullptr) {
+      boundary = reinterpret_cast<uintptr_t>(
+          rosalloc->RoundUpToRunBoundary(reinterpret_cast<void*>(boundary)));
+      DCHECK_ALIGNED(boundary - heap_begin, word_span);
+    }
+    if (boundary >= end) {
+      break;
+    }
+    if (boundary > boundaries.back()) {
+      boundaries.push_back(boundary);
+    }
+  }
+  boundaries.push_back(end);
+  return boundaries;
+}
+
+template <typename BitmapType>
+ObjectBytePair MarkSweep::SweepRangesInParallel(space::AllocSpace* alloc_space,
+                                                space::RosAllocSpace* rosalloc_space,
+                                                const BitmapType* live_bitmap,
+                                                const BitmapType* mark_bitmap,
+                                                BitmapType* bitmap_to_clear,
+                                                const std::vector<uintptr_t>& boundaries) {
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = GetHeap()->GetThreadPool();
+  const size_t thread_count = GetThreadCount(false);
+  const uint64_t start_time = NanoTime();
+  std::vector<ObjectBytePair> freed(boundaries.size() - 1);
+  for (size_t i = 0; i + 1 < boundaries.size(); ++i) {
+    thread_pool->AddTask(self, new SweepTask<BitmapType>(alloc_space,
+                                                         rosalloc_space,
+                                                         live_bitmap,
+                                                         mark_bitmap,
+                                                         bitmap_to_clear,
+                                                         boundaries[i],
+                                                         boundaries[i + 1],
+                                                         &freed[i]));
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
+  ObjectBytePair total;
+  for (const ObjectBytePair& range_freed : freed) {
+    total.Add(range_freed);
+  }
+  VLOG(gc) << "Swept " << total.objects << " objects in " << boundaries.size() - 1
+           << " ranges with " << thread_count << " threads in "
+           << PrettyDuration(NanoTime() - start_time);
+  return total;
+}
+
+ObjectBytePair MarkSweep::SweepRosAllocSpaceInParallel(space::RosAllocSpace* space,
+                                                       bool swap_bitmaps) {
+  accounting::ContinuousSpaceBitmap* live_bitmap = space->GetLiveBitmap();
+  accounting::ContinuousSpaceBitmap* mark_bitmap = space->GetMarkBitmap();
+  // If the bitmaps are bound then sweeping this space clearly won't do anything.
+  if (live_bitmap == mark_bitmap) {
+    return ObjectBytePair(0, 0);
+  }
+  accounting::ContinuousSpaceBitmap* bitmap_to_clear = swap_bitmaps ? nullptr : live_bitmap;
+  if (swap_bitmaps) {
+    std::swap(live_bitmap, mark_bitmap);
+  }
+  allocator::RosAlloc* rosalloc = space->GetRosAlloc();
+  const std::vector<uintptr_t> boundaries =
+      ComputeSweepRanges(live_bitmap,
+                         reinterpret_cast<uintptr_t>(space->Begin()),
+                         reinterpret_cast<uintptr_t>(space->End()),
+                         GetThreadCount(false) * kSweepRangesPerThread,
+                         rosalloc);
+  Thread* self = Thread::Current();
+  rosalloc->StartParallelBulkFree(self);
+  ObjectBytePair freed = SweepRangesInParallel(space,
+                                               space,
+                                               live_bitmap,
+                                               mark_bitmap,
+                                               bitmap_to_clear,
+                                               boundaries);
+  rosalloc->FinishParallelBulkFree(self);
+  return freed;
+}
+
+ObjectBytePair MarkSweep::SweepLargeObjectsInParallel(space::LargeObjectSpace* los,
+                                                      bool swap_bitmaps) {
+  accounting::LargeObjectBitmap* live_bitmap = los->GetLiveBitmap();
+  accounting::LargeObjectBitmap* mark_bitmap = los->GetMarkBitmap();
+  accounting::LargeObjectBitmap* bitmap_to_clear = swap_bitmaps ? nullptr : live_bitmap;
+  if (swap_bitmaps) {
+    std::swap(live_bitmap, mark_bitmap);
+  }
+  const std::vector<uintptr_t> boundaries =
+      ComputeSweepRanges(live_bitmap,
+                         reinterpret_cast<uintptr_t>(los->Begin()),
+                         reinterpret_cast<uintptr_t>(los->End()),
+                         GetThreadCount(false) * kSweepRangesPerThread,
+                         static_cast<allocator::RosAlloc*>(nullptr));
+  return SweepRangesInParallel(los,
+                               static_cast<space::RosAllocSpace*>(nullptr),
+                               live_bitmap,
+                               mark_bitmap,
+                               bitmap_to_clear,
+                               boundaries);
+}
+
+bool MarkSweep::UseParallelSweepArray(size_t count) const {
+  return kParallelSweep && count >= kMinimumParallelSweepArrayObjects && GetThreadCount(false) > 1;
+}
+
+// Scans a chunk of the allocation stack. The objects of the space are removed from the chunk, and
+// the unmarked ones are sorted into the ranges of the space that are freed in parallel later.
+class SweepArrayScanTask : public Task {
+ public:
+  SweepArrayScanTask(space::ContinuousSpace* space,
+                     const accounting::ContinuousSpaceBitmap* mark_bitmap,
+                     const std::vector<uintptr_t>* boundaries,
+                     StackReference<mirror::Object>* begin,
+                     StackReference<mirror::Object>* end,
+                     size_t* remaining,
+                     std::vector<std::vector<mirror::Object*>>* dead_objects)
+      : space_(space),
+        mark_bitmap_(mark_bitmap),
+        boundaries_(boundaries),
+        begin_(begin),
+        end_(end),
+        remaining_(remaining),
+        dead_objects_(dead_objects) {}
+
+  // The GC thread holds the heap bitmap lock on behalf of the sweeping threads.
+  virtual void Run(Thread* self ATTRIBUTE_UNUSED) NO_THREAD_SAFETY_ANALYSIS {
+    StackReference<mirror::Object>* out = begin_;
+    for (StackReference<mirror::Object>* it = begin_; it != end_; ++it) {
+      mirror::Object* const obj = it->AsMirrorPtr();
+      if (kUseThreadLocalAllocationStack && obj == nullptr) {
+        continue;
+      }
+      if (!space_->HasAddress(obj)) {
+        (out++)->Assign(obj);
+      } else if (!mark_bitmap_->Test(obj)) {
+        auto range = std::upper_bound(boundaries_->begin(),
+                                      boundaries_->end(),
+                                      reinterpret_cast<uintptr_t>(obj));
+        (*dead_objects_)[range - boundaries_->begin() - 1].push_back(obj);
+      }
+    }
+    *remaining_ = out - begin_;
+  }
+
+  virtual void Finalize() {
+    delete this;
   }
+
+ private:
+  space::ContinuousSpace* const space_;
+  const accounting::ContinuousSpaceBitmap* const mark_bitmap_;
+  const std::vector<uintptr_t>* const boundaries_;
+  StackReference<mirror::Object>* const begin_;
+  StackReference<mirror::Object>* const end_;
+  size_t* const remaining_;
+  std::vector<std::vector<mirror::Object*>>* const dead_objects_;
+};
+
+// Frees the unmarked objects of one range of a RosAlloc space, as found by all the scan tasks.
+class SweepArrayFreeTask : public Task {
+ public:
+  SweepArrayFreeTask(space::RosAllocSpace* space,
+                     const std::vector<std::vector<std::vector<mirror::Object*>>>* dead_objects,
+                     size_t range,
+                     ObjectBytePair* freed)
+      : space_(space), dead_objects_(dead_objects), range_(range), freed_(freed) {}
+
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    for (const std::vector<std::vector<mirror::Object*>>& chunk_dead_objects : *dead_objects_) {
+      const std::vector<mirror::Object*>& objects = chunk_dead_objects[range_];
+      if (!objects.empty()) {
+        // FreeList() takes a non const array, but does not modify it.
+        mirror::Object** ptrs = const_cast<mirror::Object**>(objects.data());
+        freed_->objects += objects.size();
+        freed_->bytes += space_->FreeListInParallelSweep(self, objects.size(), ptrs);
+      }
+    }
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  space::RosAllocSpace* const space_;
+  const std::vector<std::vector<std::vector<mirror::Object*>>>* const dead_objects_;
+  const size_t range_;
+  ObjectBytePair* const freed_;
+};
+
+ObjectBytePair MarkSweep::SweepArrayInParallel(space::RosAllocSpace* space,
+                                               const accounting::ContinuousSpaceBitmap* live_bitmap,
+                                               const accounting::ContinuousSpaceBitmap* mark_bitmap,
+                                               StackReference<mirror::Object>* objects,
+                                               size_t* count) {
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = GetHeap()->GetThreadPool();
+  const size_t thread_count = GetThreadCount(false);
+  const uint64_t start_time = NanoTime();
+  allocator::RosAlloc* rosalloc = space->GetRosAlloc();
+  // Objects of a run may be anywhere in the allocation stack, so the stack is first split into
+  // chunks which are scanned in parallel. The dead objects they find are grouped by the ranges of
+  // the space which share no runs, and then each range is freed by a single thread.
+  const std::vector<uintptr_t> boundaries =
+      ComputeSweepRanges(live_bitmap,
+                         reinterpret_cast<uintptr_t>(space->Begin()),
+                         reinterpret_cast<uintptr_t>(space->End()),
+                         thread_count * kSweepRangesPerThread,
+                         rosalloc);
+  const size_t num_ranges = boundaries.size() - 1;
+  const size_t num_chunks = std::min(thread_count * kSweepRangesPerThread, *count);
+  std::vector<std::vector<std::vector<mirror::Object*>>> dead_objects(
+      num_chunks, std::vector<std::vector<mirror::Object*>>(num_ranges));
+  std::vector<size_t> remaining(num_chunks);
+  for (size_t i = 0; i < num_chunks; ++i) {
+    thread_pool->AddTask(self, new SweepArrayScanTask(space,
+                                                      mark_bitmap,
+                                                      &boundaries,
+                                                      objects + i * *count / num_chunks,
+                                                      objects + (i + 1) * *count / num_chunks,
+                                                      &remaining[i],
+                                                      &dead_objects[i]));
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
+  // Move the remaining objects of the chunks together for the next spaces.
+  StackReference<mirror::Object>* out = objects;
+  for (size_t i = 0; i < num_chunks; ++i) {
+    StackReference<mirror::Object>* chunk_begin = objects + i * *count / num_chunks;
+    std::copy(chunk_begin, chunk_begin + remaining[i], out);
+    out += remaining[i];
+  }
+  *count = out - objects;
+  std::vector<ObjectBytePair> freed(num_ranges);
+  rosalloc->StartParallelBulkFree(self);
+  for (size_t i = 0; i < num_ranges; ++i) {
+    thread_pool->AddTask(self, new SweepArrayFreeTask(space, &dead_objects, i, &freed[i]));
+  }
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
+  rosalloc->FinishParallelBulkFree(self);
+  ObjectBytePair total;
+  for (const ObjectBytePair& range_freed : freed) {
+    total.Add(range_freed);
+  }
+  VLOG(gc) << "Swept " << total.objects << " objects of the allocation stack in " << num_chunks
+           << " chunks and " << num_ranges << " ranges with " << thread_count << " threads in "
+           << PrettyDuration(NanoTime() - start_time);
+  return total;
 }
 
 // Process the "referent" field in a java.lang.ref.Reference.  If the referent has not yet been
 // marked, put it on the appropriate list in the heap for later processing.
 void MarkSweep::DelayReferenceReferent(mirror::Class* klass, mirror::Reference* ref) {
+  // Whether or not the referent is marked yet, the reference processing may keep it alive.
+  RecordEvacuationSlot(ref->GetReferent<kWithoutReadBarrier>(),
+                       ref,
+                       mirror::Reference::ReferentOffset());
   heap_->GetReferenceProcessor()->DelayReferenceReferent(klass, ref, this);
 }
 
@@ -1335,7 +2015,9 @@ class MarkVisitor {
       Locks::mutator_lock_->AssertSharedHeld(Thread::Current());
       Locks::heap_bitmap_lock_->AssertExclusiveHeld(Thread::Current());
     }
-    mark_sweep_->MarkObject(obj->GetFieldObject<mirror::Object>(offset), obj, offset);
+    mirror::Object* ref = obj->GetFieldObject<mirror::Object>(offset);
+    mark_sweep_->RecordEvacuationSlot(ref, obj, offset);
+    mark_sweep_->MarkObject(ref, obj, offset);
   }
 
   void VisitRootIfNonNull(mirror::CompressedReference<mirror::Object>* root) const
@@ -1353,6 +2035,7 @@ class MarkVisitor {
       Locks::mutator_lock_->AssertSharedHeld(Thread::Current());
       Locks::heap_bitmap_lock_->AssertExclusiveHeld(Thread::Current());
     }
+    mark_sweep_->RecordEvacuationRoot(root);
     mark_sweep_->MarkObject(root->AsMirrorPtr());
   }
 
@@ -1431,6 +2114,11 @@ inline mirror::Object* MarkSweep::IsMarked(mirror::Object* object) {
   if (immune_spaces_.IsInImmuneRegion(object)) {
     return object;
   }
+  // The system weaks are swept after the evacuation.
+  mirror::Object* forwarding_address = GetForwardingAddress(object);
+  if (forwarding_address != nullptr) {
+    return forwarding_address;
+  }
   if (current_space_bitmap_->HasAddress(object)) {
     return current_space_bitmap_->Test(object) ? object : nullptr;
   }
@@ -1468,6 +2156,16 @@ void MarkSweep::FinishPhase() {
   CHECK(mark_stack_->IsEmpty());  // Ensure that the mark stack is empty.
   mark_stack_->Reset();
   Thread* const self = Thread::Current();
+  evacuation_space_ = nullptr;
+  evacuated_runs_.clear();
+  evacuated_pages_.clear();
+  evacuation_begin_ = 0;
+  evacuation_end_ = 0;
+  {
+    MutexLock mu(self, evacuation_slots_lock_);
+    evacuation_slots_.clear();
+    evacuation_roots_.clear();
+  }
   ReaderMutexLock mu(self, *Locks::mutator_lock_);
   WriterMutexLock mu2(self, *Locks::heap_bitmap_lock_);
   heap_->ClearMarkedObjects();
@@ -18,6 +18,8 @@
 #define ART_RUNTIME_GC_COLLECTOR_MARK_SWEEP_H_
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "atomic.h"
 #include "barrier.h"
@@ -38,6 +40,7 @@ class Object;
 class Reference;
 }  // namespace mirror
 
+template<class MirrorType> class StackReference;
 class Thread;
 enum VisitRootFlags : uint8_t;
 
@@ -50,6 +53,12 @@ template<typename T> class AtomicStack;
 typedef AtomicStack<mirror::Object> ObjectStack;
 }  // namespace accounting
 
+namespace space {
+class AllocSpace;
+class LargeObjectSpace;
+class RosAllocSpace;
+}  // namespace space
+
 namespace collector {
 
 class MarkSweep : public GarbageCollector {
@@ -58,12 +67,14 @@ class MarkSweep : public GarbageCollector {
 
   ~MarkSweep() {}
 
-  virtual void RunPhases() OVERRIDE REQUIRES(!mark_stack_lock_);
+  virtual void RunPhases() OVERRIDE REQUIRES(!mark_stack_lock_, !evacuation_slots_lock_);
   void InitializePhase();
   void MarkingPhase() REQUIRES(!mark_stack_lock_) SHARED_REQUIRES(Locks::mutator_lock_);
   void PausePhase() REQUIRES(Locks::mutator_lock_) REQUIRES(!mark_stack_lock_);
+  void EvacuatePhase() REQUIRES(Locks::mutator_lock_)
+      REQUIRES(!mark_stack_lock_, !evacuation_slots_lock_);
   void ReclaimPhase() REQUIRES(!mark_stack_lock_) SHARED_REQUIRES(Locks::mutator_lock_);
-  void FinishPhase();
+  void FinishPhase() REQUIRES(!evacuation_slots_lock_);
   virtual void MarkReachableObjects()
       REQUIRES(Locks::heap_bitmap_lock_)
       REQUIRES(!mark_stack_lock_)
@@ -145,6 +156,68 @@ class MarkSweep : public GarbageCollector {
       REQUIRES(!mark_stack_lock_)
       SHARED_REQUIRES(Locks::mutator_lock_);
 
+  // Parallel versions of the space sweeps, using the GC thread pool.
+  bool UseParallelSweep(size_t space_size) const;
+  ObjectBytePair SweepRosAllocSpaceInParallel(space::RosAllocSpace* space, bool swap_bitmaps)
+      REQUIRES(Locks::heap_bitmap_lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+  ObjectBytePair SweepLargeObjectsInParallel(space::LargeObjectSpace* los, bool swap_bitmaps)
+      REQUIRES(Locks::heap_bitmap_lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+  // Parallel version of the sweep of a RosAlloc space in SweepArray(). Removes the objects of the
+  // space from the first count entries of objects and updates count.
+  bool UseParallelSweepArray(size_t count) const;
+  ObjectBytePair SweepArrayInParallel(space::RosAllocSpace* space,
+                                      const accounting::ContinuousSpaceBitmap* live_bitmap,
+                                      const accounting::ContinuousSpaceBitmap* mark_bitmap,
+                                      StackReference<mirror::Object>* objects,
+                                      size_t* count)
+      REQUIRES(Locks::heap_bitmap_lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+  template <typename BitmapType>
+  ObjectBytePair SweepRangesInParallel(space::AllocSpace* alloc_space,
+                                       space::RosAllocSpace* rosalloc_space,
+                                       const BitmapType* live_bitmap,
+                                       const BitmapType* mark_bitmap,
+                                       BitmapType* bitmap_to_clear,
+                                       const std::vector<uintptr_t>& boundaries)
+      REQUIRES(Locks::heap_bitmap_lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
+  // Stop allocating in the sparsest RosAlloc runs so that they get freed as their objects die,
+  // or once the next full or partial GC moved the objects out, see EvacuatePhase().
+  void RetireSparseRosAllocRuns(Thread* self) REQUIRES(!Locks::heap_bitmap_lock_);
+
+  // Picks the runs retired by the previous GC whose marked objects EvacuatePhase() moves.
+  void SetUpRunEvacuation(Thread* self) SHARED_REQUIRES(Locks::mutator_lock_);
+
+  // Returns true if the object is in one of the runs set up by SetUpRunEvacuation().
+  bool IsInEvacuatedRuns(const mirror::Object* obj) const {
+    const uintptr_t offset = reinterpret_cast<uintptr_t>(obj) - evacuation_begin_;
+    return UNLIKELY(offset < evacuation_end_ - evacuation_begin_) &&
+        evacuated_pages_[offset / kPageSize];
+  }
+
+  // Returns the new address of an object moved by EvacuatePhase(), otherwise null.
+  mirror::Object* GetForwardingAddress(mirror::Object* obj)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
+  // Remember the reference fields and roots that point into the evacuated runs, so that the
+  // evacuation pause only has to update those and the ones written since they were marked.
+  void RecordEvacuationSlot(mirror::Object* ref, mirror::Object* holder, MemberOffset offset)
+      REQUIRES(!evacuation_slots_lock_);
+  void RecordEvacuationRoot(mirror::CompressedReference<mirror::Object>* root)
+      REQUIRES(!evacuation_slots_lock_);
+
+  // Copies the marked objects out of the evacuated runs, returns how many were moved.
+  size_t EvacuateRetiredRuns(Thread* self)
+      REQUIRES(Locks::mutator_lock_, Locks::heap_bitmap_lock_);
+
+  // Points the references to the objects moved by EvacuateRetiredRuns() to their copies.
+  void UpdateEvacuatedReferences(Thread* self)
+      REQUIRES(Locks::mutator_lock_, Locks::heap_bitmap_lock_)
+      REQUIRES(!evacuation_slots_lock_);
+
   // Sweeps unmarked objects to complete the garbage collection. Virtual as by default it sweeps
   // all allocation spaces. Partial and sticky GCs want to just sweep a subset of the heap.
   virtual void Sweep(bool swap_bitmaps)
@@ -226,6 +299,7 @@ class MarkSweep : public GarbageCollector {
 
   // Schedules an unmarked object for reference processing.
   void DelayReferenceReferent(mirror::Class* klass, mirror::Reference* reference)
+      REQUIRES(!evacuation_slots_lock_)
       SHARED_REQUIRES(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
 
  protected:
@@ -352,10 +426,28 @@ class MarkSweep : public GarbageCollector {
 
   std::unique_ptr<MemMap> sweep_array_free_buffer_mem_map_;
 
+  // The space whose retired runs are evacuated in this GC, null if there are none.
+  space::RosAllocSpace* evacuation_space_;
+  // The [begin, end) page ranges of the evacuated runs and the pages they cover between the
+  // lowest and the highest one.
+  std::vector<std::pair<uint8_t*, uint8_t*>> evacuated_runs_;
+  std::vector<bool> evacuated_pages_;
+  uintptr_t evacuation_begin_;
+  uintptr_t evacuation_end_;
+
+  // The reference fields and roots found by the marking that point into the evacuated runs.
+  Mutex evacuation_slots_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::vector<std::pair<mirror::Object*, MemberOffset>> evacuation_slots_
+      GUARDED_BY(evacuation_slots_lock_);
+  std::vector<mirror::CompressedReference<mirror::Object>*> evacuation_roots_
+      GUARDED_BY(evacuation_slots_lock_);
+
  private:
   class CardScanTask;
   class CheckpointMarkThreadRoots;
   class DelayReferenceReferentVisitor;
+  class EvacuationUpdateRootVisitor;
+  class EvacuationUpdateVisitor;
   template<bool kUseFinger> class MarkStackTask;
   class MarkObjectSlowPath;
   class RecursiveMarkTask;
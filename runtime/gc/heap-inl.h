@@ -22,6 +22,7 @@
 #include "base/time_utils.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/allocation_record.h"
+#include "gc/allocation_sampler.h"
 #include "gc/collector/semi_space.h"
 #include "gc/space/bump_pointer_space-inl.h"
 #include "gc/space/dlmalloc_space-inl.h"
@@ -70,6 +71,8 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self,
   size_t bytes_allocated;
   size_t usable_size;
   size_t new_num_bytes_allocated = 0;
+  // bytes allocated that takes bulk thread-local buffer allocations into account.
+  size_t bytes_tl_bulk_allocated = 0;
   if (allocator == kAllocatorTypeTLAB || allocator == kAllocatorTypeRegionTLAB) {
     byte_count = RoundUp(byte_count, space::BumpPointerSpace::kAlignment);
   }
@@ -104,8 +107,6 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self,
     pre_fence_visitor(obj, usable_size);
     QuasiAtomic::ThreadFenceForConstructor();
   } else {
-    // bytes allocated that takes bulk thread-local buffer allocations into account.
-    size_t bytes_tl_bulk_allocated = 0;
     obj = TryToAllocate<kInstrumented, false>(self, allocator, byte_count, &bytes_allocated,
                                               &usable_size, &bytes_tl_bulk_allocated);
     if (UNLIKELY(obj == nullptr)) {
@@ -184,6 +185,15 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self,
   } else {
     DCHECK(!IsAllocTrackingEnabled());
   }
+  // The allocation sampling does not instrument the entry points, the compiled code fast paths
+  // call into the runtime when they reach the sample point.
+  if (UNLIKELY(IsAllocSamplingEnabled())) {
+    // allocation_sampler_ is not null since it never becomes null after allocation sampling is
+    // enabled.
+    DCHECK(allocation_sampler_ != nullptr);
+    allocation_sampler_->MaybeSampleAllocation(self, &obj, bytes_allocated,
+                                               bytes_tl_bulk_allocated);
+  }
   if (AllocatorHasAllocationStack(allocator)) {
     PushOnAllocationStack(self, &obj);
   }
@@ -312,6 +322,11 @@ inline mirror::Object* Heap::TryToAllocate(Thread* self,
     }
     case kAllocatorTypeTLAB: {
       DCHECK_ALIGNED(alloc_size, space::BumpPointerSpace::kAlignment);
+      if (UNLIKELY(self->TlabSize() < alloc_size) &&
+          self->TlabRemainingCapacity() >= alloc_size) {
+        // The TLAB ends at the next allocation sample point, allocate past it.
+        self->ExpandTlab();
+      }
       if (UNLIKELY(self->TlabSize() < alloc_size)) {
         const size_t new_tlab_size = alloc_size + kDefaultTLABSize;
         if (UNLIKELY(IsOutOfMemoryOnAllocation<kGrow>(allocator_type, new_tlab_size))) {
@@ -343,6 +358,11 @@ inline mirror::Object* Heap::TryToAllocate(Thread* self,
     case kAllocatorTypeRegionTLAB: {
       DCHECK(region_space_ != nullptr);
       DCHECK_ALIGNED(alloc_size, space::RegionSpace::kAlignment);
+      if (UNLIKELY(self->TlabSize() < alloc_size) &&
+          self->TlabRemainingCapacity() >= alloc_size) {
+        // The TLAB ends at the next allocation sample point, allocate past it.
+        self->ExpandTlab();
+      }
       if (UNLIKELY(self->TlabSize() < alloc_size)) {
         if (space::RegionSpace::kRegionSize >= alloc_size) {
           // Non-large. Check OOME for a tlab.
@@ -39,6 +39,7 @@
 #include "gc/accounting/mod_union_table-inl.h"
 #include "gc/accounting/remembered_set.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "gc/allocation_sampler.h"
 #include "gc/collector/concurrent_copying.h"
 #include "gc/collector/mark_compact.h"
 #include "gc/collector/mark_sweep.h"
@@ -87,6 +88,17 @@ static constexpr size_t kMaxConcurrentRemainingBytes = 512 * KB;
 // relative to partial/full GC. This may be desirable since sticky GCs interfere less with mutator
 // threads (lower pauses, use less memory bandwidth).
 static constexpr double kStickyGcThroughputAdjustment = 1.0;
+// The GC ergonomics adjust their multipliers by these factors after each GC, within the bounds
+// below. The GC time fraction is smoothed with the given weight of the latest measurement.
+static constexpr double kGcErgonomicsGrowFactor = 1.25;
+static constexpr double kGcErgonomicsShrinkFactor = 0.9;
+static constexpr double kGcErgonomicsMinHeapFreeMultiplier = 0.25;
+static constexpr double kGcErgonomicsMaxHeapFreeMultiplier = 8.0;
+static constexpr double kGcErgonomicsMaxConcurrentStartMultiplier = 8.0;
+static constexpr double kGcErgonomicsSmoothing = 0.5;
+// Only shrink the heap once the GC time fraction is below this fraction of the target, so that
+// the heap size doesn't oscillate around the target.
+static constexpr double kGcErgonomicsShrinkThreshold = 0.5;
 // Whether or not we compact the zygote in PreZygoteFork.
 static constexpr bool kCompactZygote = kMovingCollector;
 // How many reserve entries are at the end of the allocation stack, these are only needed if the
@@ -153,6 +165,11 @@ Heap::Heap(size_t initial_size,
            bool verify_pre_sweeping_rosalloc,
            bool verify_post_gc_rosalloc,
            bool gc_stress_mode,
+           bool use_generational_cc,
+           unsigned int region_space_evacuate_live_percent,
+           bool use_transparent_huge_pages,
+           uint64_t max_gc_pause,
+           unsigned int max_gc_cpu_percent,
            bool use_homogeneous_space_compaction_for_oom,
            uint64_t min_interval_homogeneous_space_compaction_by_oom)
     : non_moving_space_(nullptr),
@@ -224,8 +241,21 @@ Heap::Heap(size_t initial_size,
       total_wait_time_(0),
       verify_object_mode_(kVerifyObjectModeDisabled),
       disable_moving_gc_count_(0),
+      young_concurrent_copying_collector_(nullptr),
+      active_concurrent_copying_collector_(nullptr),
       is_running_on_memory_tool_(Runtime::Current()->IsRunningOnMemoryTool()),
       use_tlab_(use_tlab),
+      use_generational_cc_(use_generational_cc),
+      use_transparent_huge_pages_(use_transparent_huge_pages),
+      max_gc_pause_(max_gc_pause),
+      max_gc_cpu_fraction_(max_gc_cpu_percent / 100.0),
+      gc_ergonomics_last_gc_time_(0U),
+      gc_ergonomics_last_update_time_(0U),
+      gc_ergonomics_last_wait_time_(0U),
+      gc_time_fraction_(0.0),
+      gc_ergonomics_heap_free_multiplier_(1.0),
+      gc_ergonomics_concurrent_start_multiplier_(1.0),
+      gc_ergonomics_prefer_sticky_(false),
       main_space_backup_(nullptr),
       min_interval_homogeneous_space_compaction_by_oom_(
           min_interval_homogeneous_space_compaction_by_oom),
@@ -244,6 +274,7 @@ Heap::Heap(size_t initial_size,
       blocking_gc_count_rate_histogram_("blocking gc count rate histogram", 1U,
                                         kGcCountRateMaxBucketCount),
       alloc_tracking_enabled_(false),
+      alloc_sampling_enabled_(false),
       backtrace_lock_(nullptr),
       seen_backtrace_count_(0u),
       unique_backtrace_count_(0u),
@@ -399,6 +430,12 @@ Heap::Heap(size_t initial_size,
     // Try to reserve virtual memory at a lower address if we have a separate non moving space.
     request_begin = reinterpret_cast<uint8_t*>(300 * MB);
   }
+  // Start the main spaces on a huge page boundary so that their first huge page isn't partial.
+  // The zygote's main space must follow the image directly though.
+  if (use_transparent_huge_pages_ && request_begin != nullptr &&
+      (separate_non_moving_space || !is_zygote)) {
+    request_begin = AlignUp(request_begin, MemMap::kHugePageSize);
+  }
   // Attempt to create 2 mem maps at or after the requested begin.
   if (foreground_collector_type_ != kCollectorTypeCC) {
     ScopedTrace trace2("Create main mem map");
@@ -442,7 +479,11 @@ Heap::Heap(size_t initial_size,
   }
   // Create other spaces based on whether or not we have a moving GC.
   if (foreground_collector_type_ == kCollectorTypeCC) {
-    region_space_ = space::RegionSpace::Create("Region space", capacity_ * 2, request_begin);
+    region_space_ = space::RegionSpace::Create("Region space", capacity_ * 2, request_begin,
+                                               region_space_evacuate_live_percent);
+    if (use_transparent_huge_pages_) {
+      AdviseHugePages(region_space_);
+    }
     AddSpace(region_space_);
   } else if (IsMovingGc(foreground_collector_type_) &&
       foreground_collector_type_ != kCollectorTypeGSS) {
@@ -527,6 +568,9 @@ Heap::Heap(size_t initial_size,
   card_table_.reset(accounting::CardTable::Create(reinterpret_cast<uint8_t*>(kMinHeapAddress),
                                                   4 * GB - kMinHeapAddress));
   CHECK(card_table_.get() != nullptr) << "Failed to create card table";
+  if (use_transparent_huge_pages_) {
+    card_table_->AdviseHugePages();
+  }
   if (foreground_collector_type_ == kCollectorTypeCC && kUseTableLookupReadBarrier) {
     rb_table_.reset(new accounting::ReadBarrierTable());
     DCHECK(rb_table_->IsAllCleared());
@@ -594,8 +638,14 @@ Heap::Heap(size_t initial_size,
       garbage_collectors_.push_back(semi_space_collector_);
     }
     if (MayUseCollector(kCollectorTypeCC)) {
-      concurrent_copying_collector_ = new collector::ConcurrentCopying(this);
+      concurrent_copying_collector_ = new collector::ConcurrentCopying(this, false);
       garbage_collectors_.push_back(concurrent_copying_collector_);
+      active_concurrent_copying_collector_.StoreRelease(concurrent_copying_collector_);
+      if (use_generational_cc_) {
+        young_concurrent_copying_collector_ =
+            new collector::ConcurrentCopying(this, true, "young");
+        garbage_collectors_.push_back(young_concurrent_copying_collector_);
+      }
     }
     if (MayUseCollector(kCollectorTypeMC)) {
       mark_compact_collector_ = new collector::MarkCompact(this);
@@ -677,9 +727,32 @@ space::MallocSpace* Heap::CreateMallocSpaceFromMemMap(MemMap* mem_map,
   }
   CHECK(malloc_space != nullptr) << "Failed to create " << name;
   malloc_space->SetFootprintLimit(malloc_space->Capacity());
+  if (use_transparent_huge_pages_) {
+    AdviseHugePages(malloc_space);
+  }
   return malloc_space;
 }
 
+void Heap::AdviseHugePages(space::ContinuousMemMapAllocSpace* space) {
+  if (!space->GetMemMap()->AdviseHugePages()) {
+    // The kernel has no transparent huge pages, keep releasing memory page by page.
+    return;
+  }
+  if (space->GetLiveBitmap() != nullptr) {
+    space->GetLiveBitmap()->AdviseHugePages();
+  }
+  if (space->GetMarkBitmap() != nullptr) {
+    space->GetMarkBitmap()->AdviseHugePages();
+  }
+  if (space->IsRosAllocSpace()) {
+    space->AsRosAllocSpace()->GetRosAlloc()->SetUseHugePages(true);
+  } else if (space->IsRegionSpace()) {
+    space->AsRegionSpace()->GetCCMarkBitmap()->AdviseHugePages();
+    space->AsRegionSpace()->SetUseHugePages(true);
+  }
+  VLOG(heap) << "Using transparent huge pages for " << space->GetName();
+}
+
 void Heap::CreateMainMallocSpace(MemMap* mem_map, size_t initial_size, size_t growth_limit,
                                  size_t capacity) {
   // Is background compaction is enabled?
@@ -1168,10 +1241,19 @@ void Heap::DumpGcPerformanceInfo(std::ostream& os) {
   }
   os << "Total mutator paused time: " << PrettyDuration(total_paused_time) << "\n";
   os << "Total time waiting for GC to complete: " << PrettyDuration(total_wait_time_) << "\n";
+  os << "Total time blocked in Reference.get(): "
+     << PrettyDuration(reference_processor_->GetReferentBlockedTime()) << " ("
+     << reference_processor_->GetReferentBlockedCount() << " calls)\n";
   os << "Total GC count: " << GetGcCount() << "\n";
   os << "Total GC time: " << PrettyDuration(GetGcTime()) << "\n";
   os << "Total blocking GC count: " << GetBlockingGcCount() << "\n";
   os << "Total blocking GC time: " << PrettyDuration(GetBlockingGcTime()) << "\n";
+  if (IsGcErgonomicsEnabled()) {
+    os << "GC ergonomics: GC time " << gc_time_fraction_ * 100.0 << "% (target "
+       << max_gc_cpu_fraction_ * 100.0 << "%), max pause target " << PrettyDuration(max_gc_pause_)
+       << ", heap free multiplier " << gc_ergonomics_heap_free_multiplier_
+       << ", concurrent start multiplier " << gc_ergonomics_concurrent_start_multiplier_ << "\n";
+  }
 
   {
     MutexLock mu(Thread::Current(), *gc_complete_lock_);
@@ -1216,6 +1298,7 @@ void Heap::ResetGcPerformanceInfo() {
   total_bytes_freed_ever_ = 0;
   total_objects_freed_ever_ = 0;
   total_wait_time_ = 0;
+  reference_processor_->ResetReferentBlockedStats();
   blocking_gc_count_ = 0;
   blocking_gc_time_ = 0;
   gc_count_last_window_ = 0;
@@ -1273,6 +1356,7 @@ Heap::~Heap() {
   // If we don't reset then the mark stack complains in its destructor.
   allocation_stack_->Reset();
   allocation_records_.reset();
+  allocation_sampler_.reset();
   live_stack_->Reset();
   STLDeleteValues(&mod_union_tables_);
   STLDeleteValues(&remembered_sets_);
@@ -2256,6 +2340,9 @@ void Heap::ChangeCollector(CollectorType collector_type) {
     gc_plan_.clear();
     switch (collector_type_) {
       case kCollectorTypeCC: {
+        if (use_generational_cc_) {
+          gc_plan_.push_back(collector::kGcTypeSticky);
+        }
         gc_plan_.push_back(collector::kGcTypeFull);
         if (use_tlab_) {
           ChangeAllocator(kAllocatorTypeRegionTLAB);
@@ -2524,6 +2611,10 @@ void Heap::PreZygoteFork() {
   if (same_space) {
     main_space_ = non_moving_space_;
     SetSpaceAsDefault(main_space_);
+    if (use_transparent_huge_pages_) {
+      // The new space got a fresh mapping from RemapAtEnd.
+      AdviseHugePages(main_space_);
+    }
   }
   delete old_alloc_space;
   CHECK(HasZygoteSpace()) << "Failed creating zygote space";
@@ -2674,10 +2765,16 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type,
         semi_space_collector_->SetSwapSemiSpaces(true);
         collector = semi_space_collector_;
         break;
-      case kCollectorTypeCC:
-        concurrent_copying_collector_->SetRegionSpace(region_space_);
-        collector = concurrent_copying_collector_;
+      case kCollectorTypeCC: {
+        collector::ConcurrentCopying* concurrent_copying =
+            use_generational_cc_ && gc_type == collector::kGcTypeSticky
+                ? young_concurrent_copying_collector_
+                : concurrent_copying_collector_;
+        concurrent_copying->SetRegionSpace(region_space_);
+        active_concurrent_copying_collector_.StoreRelease(concurrent_copying);
+        collector = concurrent_copying;
         break;
+      }
       case kCollectorTypeMC:
         mark_compact_collector_->SetSpace(bump_pointer_space_);
         collector = mark_compact_collector_;
@@ -2685,7 +2782,8 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type,
       default:
         LOG(FATAL) << "Invalid collector type " << static_cast<size_t>(collector_type_);
     }
-    if (collector != mark_compact_collector_ && collector != concurrent_copying_collector_) {
+    if (collector != mark_compact_collector_ &&
+        collector != active_concurrent_copying_collector_.LoadRelaxed()) {
       temp_space_->GetMemMap()->Protect(PROT_READ | PROT_WRITE);
       if (kIsDebugBuild) {
         // Try to read each page of the memory map in case mprotect didn't work properly b/19894268.
@@ -2693,7 +2791,9 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type,
       }
       CHECK(temp_space_->IsEmpty());
     }
-    gc_type = collector::kGcTypeFull;  // TODO: Not hard code this in.
+    if (collector != young_concurrent_copying_collector_) {
+      gc_type = collector::kGcTypeFull;  // TODO: Not hard code this in.
+    }
   } else if (current_allocator_ == kAllocatorTypeRosAlloc ||
       current_allocator_ == kAllocatorTypeDlMalloc) {
     collector = FindCollectorByGcType(gc_type);
@@ -3491,6 +3591,16 @@ void Heap::DumpForSigQuit(std::ostream& os) {
   os << "Heap: " << GetPercentFree() << "% free, " << PrettySize(GetBytesAllocated()) << "/"
      << PrettySize(GetTotalMemory()) << "; " << GetObjectsAllocated() << " objects\n";
   DumpGcPerformanceInfo(os);
+  Thread* self = Thread::Current();
+  AllocationSampler* sampler;
+  {
+    MutexLock mu(self, *Locks::alloc_tracker_lock_);
+    sampler = GetAllocationSampler();
+  }
+  if (sampler != nullptr) {
+    ScopedObjectAccess soa(self);
+    sampler->DumpForSigQuit(os);
+  }
 }
 
 size_t Heap::GetPercentFree() {
@@ -3554,8 +3664,11 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran,
   const uint64_t bytes_allocated = GetBytesAllocated();
   uint64_t target_size;
   collector::GcType gc_type = collector_ran->GetGcType();
-  const double multiplier = HeapGrowthMultiplier();  // Use the multiplier to grow more for
-  // foreground.
+  if (IsGcErgonomicsEnabled()) {
+    UpdateGcErgonomics(collector_ran);
+  }
+  // Use the multiplier to grow more for foreground and when the GC ergonomics ask for it.
+  const double multiplier = HeapGrowthMultiplier() * gc_ergonomics_heap_free_multiplier_;
   const uint64_t adjusted_min_free = static_cast<uint64_t>(min_free_ * multiplier);
   const uint64_t adjusted_max_free = static_cast<uint64_t>(max_free_ * multiplier);
   if (gc_type != collector::kGcTypeSticky) {
@@ -3570,16 +3683,23 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran,
   } else {
     collector::GcType non_sticky_gc_type =
         HasZygoteSpace() ? collector::kGcTypePartial : collector::kGcTypeFull;
-    // Find what the next non sticky collector will be.
-    collector::GarbageCollector* non_sticky_collector = FindCollectorByGcType(non_sticky_gc_type);
+    // Find what the next non sticky collector will be. The full concurrent copying collector
+    // reports kGcTypePartial, so it can't be looked up by GC type.
+    collector::GarbageCollector* non_sticky_collector =
+        collector_ran == young_concurrent_copying_collector_
+            ? concurrent_copying_collector_
+            : FindCollectorByGcType(non_sticky_gc_type);
     // If the throughput of the current sticky GC >= throughput of the non sticky collector, then
     // do another sticky collection next.
     // We also check that the bytes allocated aren't over the footprint limit in order to prevent a
     // pathological case where dead objects which aren't reclaimed by sticky could get accumulated
     // if the sticky GC throughput always remained >= the full/partial throughput.
-    if (current_gc_iteration_.GetEstimatedThroughput() * kStickyGcThroughputAdjustment >=
-        non_sticky_collector->GetEstimatedMeanThroughput() &&
-        non_sticky_collector->NumberOfIterations() > 0 &&
+    // The GC ergonomics may also ask for sticky collections for their shorter pauses.
+    const bool sticky_is_faster =
+        current_gc_iteration_.GetEstimatedThroughput() * kStickyGcThroughputAdjustment >=
+            non_sticky_collector->GetEstimatedMeanThroughput() &&
+        non_sticky_collector->NumberOfIterations() > 0;
+    if ((sticky_is_faster || gc_ergonomics_prefer_sticky_) &&
         bytes_allocated <= max_allowed_footprint_) {
       next_gc_type_ = collector::kGcTypeSticky;
     } else {
@@ -3610,6 +3730,9 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran,
       size_t remaining_bytes = bytes_allocated_during_gc * gc_duration_seconds;
       remaining_bytes = std::min(remaining_bytes, kMaxConcurrentRemainingBytes);
       remaining_bytes = std::max(remaining_bytes, kMinConcurrentRemainingBytes);
+      // Leave the mutators more room to allocate during the GC if they had to wait for it.
+      remaining_bytes = static_cast<size_t>(
+          remaining_bytes * gc_ergonomics_concurrent_start_multiplier_);
       if (UNLIKELY(remaining_bytes > max_allowed_footprint_)) {
         // A never going to happen situation that from the estimated allocation rate we will exceed
         // the applications entire footprint with the given estimated allocation rate. Schedule
@@ -3627,6 +3750,79 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran,
   }
 }
 
+void Heap::UpdateGcErgonomics(collector::GarbageCollector* collector_ran) {
+  uint64_t total_gc_time = 0;
+  for (const auto& collector : garbage_collectors_) {
+    total_gc_time += collector->GetCumulativeTimings().GetTotalNs();
+  }
+  uint64_t max_pause = 0;
+  for (uint64_t pause : current_gc_iteration_.GetPauseTimes()) {
+    max_pause = std::max(max_pause, pause);
+  }
+  UpdateGcErgonomics(collector_ran->GetGcType(),
+                     NanoTime(),
+                     total_gc_time,
+                     total_wait_time_,
+                     max_pause);
+}
+
+void Heap::UpdateGcErgonomics(collector::GcType gc_type,
+                              uint64_t now,
+                              uint64_t total_gc_time,
+                              uint64_t total_wait_time,
+                              uint64_t max_pause) {
+  // The cumulative timings go back to zero when the statistics are reset, start over then.
+  if (gc_ergonomics_last_update_time_ != 0 && now > gc_ergonomics_last_update_time_ &&
+      total_gc_time >= gc_ergonomics_last_gc_time_) {
+    const double window_fraction =
+        static_cast<double>(total_gc_time - gc_ergonomics_last_gc_time_) /
+        (now - gc_ergonomics_last_update_time_);
+    gc_time_fraction_ = kGcErgonomicsSmoothing * window_fraction +
+        (1.0 - kGcErgonomicsSmoothing) * gc_time_fraction_;
+  }
+  const uint64_t wait_time = (total_wait_time >= gc_ergonomics_last_wait_time_)
+      ? total_wait_time - gc_ergonomics_last_wait_time_
+      : total_wait_time;
+  gc_ergonomics_last_gc_time_ = total_gc_time;
+  gc_ergonomics_last_update_time_ = now;
+  gc_ergonomics_last_wait_time_ = total_wait_time;
+  // Grow the heap while the GC takes too much time, since fewer GCs then run, and shrink it back
+  // when the GC is comfortably under the target.
+  if (max_gc_cpu_fraction_ != 0.0) {
+    if (gc_time_fraction_ > max_gc_cpu_fraction_) {
+      gc_ergonomics_heap_free_multiplier_ = std::min(
+          gc_ergonomics_heap_free_multiplier_ * kGcErgonomicsGrowFactor,
+          kGcErgonomicsMaxHeapFreeMultiplier);
+    } else if (gc_time_fraction_ < max_gc_cpu_fraction_ * kGcErgonomicsShrinkThreshold) {
+      gc_ergonomics_heap_free_multiplier_ = std::max(
+          gc_ergonomics_heap_free_multiplier_ * kGcErgonomicsShrinkFactor,
+          kGcErgonomicsMinHeapFreeMultiplier);
+    }
+  }
+  if (max_gc_pause_ != 0) {
+    // Mutators wait for a GC when they run out of memory before the concurrent GC finishes.
+    // Starting the concurrent GCs earlier leaves them more memory to allocate in the meantime,
+    // so the time they waited since the previous GC drives how early the next one starts.
+    if (wait_time > max_gc_pause_) {
+      gc_ergonomics_concurrent_start_multiplier_ = std::min(
+          gc_ergonomics_concurrent_start_multiplier_ * kGcErgonomicsGrowFactor,
+          kGcErgonomicsMaxConcurrentStartMultiplier);
+    } else {
+      gc_ergonomics_concurrent_start_multiplier_ = std::max(
+          gc_ergonomics_concurrent_start_multiplier_ * kGcErgonomicsShrinkFactor, 1.0);
+    }
+    // The pauses of the collectors themselves are longer for the non sticky GCs, which scan
+    // more roots and cards. Keep running sticky GCs while the non sticky ones miss the target.
+    if (gc_type != collector::kGcTypeSticky) {
+      gc_ergonomics_prefer_sticky_ = max_pause > max_gc_pause_;
+    }
+  }
+  VLOG(gc) << "GC ergonomics: GC time " << gc_time_fraction_ * 100.0 << "%, heap free multiplier "
+           << gc_ergonomics_heap_free_multiplier_ << ", concurrent start multiplier "
+           << gc_ergonomics_concurrent_start_multiplier_ << ", prefer sticky "
+           << gc_ergonomics_prefer_sticky_;
+}
+
 void Heap::ClampGrowthLimit() {
   // Use heap bitmap lock to guard against races with BindLiveToMarkBitmap.
   ScopedObjectAccess soa(Thread::Current());
@@ -3993,6 +4189,29 @@ void Heap::VisitAllocationRecords(RootVisitor* visitor) const {
       GetAllocationRecords()->VisitRoots(visitor);
     }
   }
+  // The sampler outlives the sampling, its stacks need to be visited as long as it exists.
+  MutexLock mu(Thread::Current(), *Locks::alloc_tracker_lock_);
+  AllocationSampler* sampler = GetAllocationSampler();
+  if (sampler != nullptr) {
+    sampler->VisitRoots(visitor);
+  }
+}
+
+void Heap::SetAllocationSampler(AllocationSampler* sampler) {
+  allocation_sampler_.reset(sampler);
+}
+
+bool Heap::DumpAllocationProfile(const std::string& filename, std::string* error_msg) {
+  AllocationSampler* sampler;
+  {
+    MutexLock mu(Thread::Current(), *Locks::alloc_tracker_lock_);
+    sampler = GetAllocationSampler();
+  }
+  if (sampler == nullptr) {
+    *error_msg = "Allocation sampling was never enabled";
+    return false;
+  }
+  return sampler->DumpPprof(filename, error_msg);
 }
 
 void Heap::SweepAllocationRecords(IsMarkedVisitor* visitor) const {
@@ -57,6 +57,7 @@ namespace mirror {
 namespace gc {
 
 class AllocRecordObjectMap;
+class AllocationSampler;
 class ReferenceProcessor;
 class TaskProcessor;
 
@@ -131,6 +132,8 @@ class Heap {
   static constexpr size_t kDefaultTLABSize = 256 * KB;
   static constexpr double kDefaultTargetUtilization = 0.5;
   static constexpr double kDefaultHeapGrowthMultiplier = 2.0;
+  // Regions whose live percent is at or above this are marked in place rather than evacuated.
+  static constexpr unsigned int kDefaultRegionSpaceEvacuateLivePercent = 75U;
   // Primitive arrays larger than this size are put in the large object space.
   static constexpr size_t kDefaultLargeObjectThreshold = 3 * kPageSize;
   // Whether or not parallel GC is enabled. If not, then we never create the thread pool.
@@ -182,6 +185,11 @@ class Heap {
        bool verify_pre_sweeping_rosalloc,
        bool verify_post_gc_rosalloc,
        bool gc_stress_mode,
+       bool use_generational_cc,
+       unsigned int region_space_evacuate_live_percent,
+       bool use_transparent_huge_pages,
+       uint64_t max_gc_pause,
+       unsigned int max_gc_cpu_percent,
        bool use_homogeneous_space_compaction,
        uint64_t min_interval_homogeneous_space_compaction_by_oom);
 
@@ -617,6 +625,10 @@ class Heap {
     return rosalloc_space_;
   }
 
+  space::RegionSpace* GetRegionSpace() const {
+    return region_space_;
+  }
+
   // Return the corresponding rosalloc space.
   space::RosAllocSpace* GetRosAllocSpace(gc::allocator::RosAlloc* rosalloc) const
       SHARED_REQUIRES(Locks::mutator_lock_);
@@ -694,8 +706,9 @@ class Heap {
     return zygote_space_ != nullptr;
   }
 
+  // Returns the concurrent copying collector running the current (or last) collection.
   collector::ConcurrentCopying* ConcurrentCopyingCollector() {
-    return concurrent_copying_collector_;
+    return active_concurrent_copying_collector_.LoadAcquire();
   }
 
   CollectorType CurrentCollectorType() {
@@ -778,6 +791,29 @@ class Heap {
       SHARED_REQUIRES(Locks::mutator_lock_)
       REQUIRES(!Locks::alloc_tracker_lock_);
 
+  // Allocation sampling support, see AllocationSampler.
+  bool IsAllocSamplingEnabled() const {
+    return alloc_sampling_enabled_.LoadRelaxed();
+  }
+
+  void SetAllocSamplingEnabled(bool enabled) REQUIRES(Locks::alloc_tracker_lock_) {
+    alloc_sampling_enabled_.StoreRelaxed(enabled);
+  }
+
+  AllocationSampler* GetAllocationSampler() const
+      REQUIRES(Locks::alloc_tracker_lock_) {
+    return allocation_sampler_.get();
+  }
+
+  void SetAllocationSampler(AllocationSampler* sampler)
+      REQUIRES(Locks::alloc_tracker_lock_);
+
+  // Writes the allocation samples taken so far in the pprof format. Returns false and sets
+  // error_msg if there are no samples or the file could not be written.
+  bool DumpAllocationProfile(const std::string& filename, std::string* error_msg)
+      SHARED_REQUIRES(Locks::mutator_lock_)
+      REQUIRES(!Locks::alloc_tracker_lock_);
+
   void DisableGCForShutdown() REQUIRES(!*gc_complete_lock_);
 
   // Create a new alloc space and compact default alloc space to it.
@@ -953,6 +989,10 @@ class Heap {
                                                   const char* name,
                                                   bool can_move_objects);
 
+  // Back the space and its bitmaps with transparent huge pages and make its allocator release
+  // memory in whole huge pages.
+  void AdviseHugePages(space::ContinuousMemMapAllocSpace* space);
+
   // Given the current contents of the alloc space, increase the allowed heap footprint to match
   // the target utilization ratio.  This should only be called immediately after a full garbage
   // collection. bytes_allocated_before_gc is used to measure bytes / second for the period which
@@ -960,6 +1000,24 @@ class Heap {
   void GrowForUtilization(collector::GarbageCollector* collector_ran,
                           uint64_t bytes_allocated_before_gc = 0);
 
+  // Whether the heap sizing adapts to a pause time or GC CPU target, see -XX:MaxGcPause and
+  // -XX:MaxGcCpuPercent.
+  bool IsGcErgonomicsEnabled() const {
+    return max_gc_pause_ != 0 || max_gc_cpu_fraction_ != 0.0;
+  }
+
+  // Measure how the collection that just ran did against the pause time and GC CPU targets and
+  // adjust the heap growth, the concurrent GC start and the sticky GC preference accordingly.
+  void UpdateGcErgonomics(collector::GarbageCollector* collector_ran);
+
+  // The control loop of the GC ergonomics, given the cumulative GC time, the cumulative time
+  // mutators waited for GCs, and the longest pause of the collection that just ran.
+  void UpdateGcErgonomics(collector::GcType gc_type,
+                          uint64_t now,
+                          uint64_t total_gc_time,
+                          uint64_t total_wait_time,
+                          uint64_t max_pause);
+
   size_t GetPercentFree();
 
   static void VerificationCallback(mirror::Object* obj, void* arg)
@@ -1272,10 +1330,45 @@ class Heap {
   collector::SemiSpace* semi_space_collector_;
   collector::MarkCompact* mark_compact_collector_;
   collector::ConcurrentCopying* concurrent_copying_collector_;
+  // Only collects the regions allocated since the last collection, null unless
+  // use_generational_cc_.
+  collector::ConcurrentCopying* young_concurrent_copying_collector_;
+  // Switched by the GC thread between the full and the young collector while mutators read it
+  // from the read barrier slow path. Published with release semantics once set up.
+  Atomic<collector::ConcurrentCopying*> active_concurrent_copying_collector_;
 
   const bool is_running_on_memory_tool_;
   const bool use_tlab_;
 
+  // Whether the concurrent copying collector runs sticky (young) collections between the full
+  // ones.
+  const bool use_generational_cc_;
+
+  // Whether the main space, the region space, their bitmaps and the card table are backed by
+  // transparent huge pages.
+  const bool use_transparent_huge_pages_;
+
+  // The pause time in nanoseconds and the fraction of the time spent in GC that the GC ergonomics
+  // aim for, 0 if there is no such target.
+  const uint64_t max_gc_pause_;
+  const double max_gc_cpu_fraction_;
+
+  // The GC ergonomics state, only updated by UpdateGcErgonomics(). The cumulative GC time and the
+  // time of the previous update measure the GC time fraction since then, which is smoothed into
+  // gc_time_fraction_.
+  uint64_t gc_ergonomics_last_gc_time_;
+  uint64_t gc_ergonomics_last_update_time_;
+  // The total_wait_time_ at the previous update, to measure how long mutators waited since.
+  uint64_t gc_ergonomics_last_wait_time_;
+  double gc_time_fraction_;
+  // Scales the free memory the heap grows by after a GC.
+  double gc_ergonomics_heap_free_multiplier_;
+  // Scales how early a concurrent GC starts before the footprint limit is reached, raised while
+  // mutators wait for GCs longer than the pause target.
+  double gc_ergonomics_concurrent_start_multiplier_;
+  // Whether to keep running sticky GCs because the last non sticky GC exceeded the pause target.
+  bool gc_ergonomics_prefer_sticky_;
+
   // Pointer to the space which becomes the new main space when we do homogeneous space compaction.
   // Use unique_ptr since the space is only added during the homogeneous compaction phase.
   std::unique_ptr<space::MallocSpace> main_space_backup_;
@@ -1334,6 +1427,11 @@ class Heap {
   Atomic<bool> alloc_tracking_enabled_;
   std::unique_ptr<AllocRecordObjectMap> allocation_records_;
 
+  // Allocation sampling support. The sampler is kept after the sampling is disabled so that the
+  // profile can still be dumped.
+  Atomic<bool> alloc_sampling_enabled_;
+  std::unique_ptr<AllocationSampler> allocation_sampler_;
+
   // GC stress related data structures.
   Mutex* backtrace_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   // Debugging variables, seen backtraces vs unique backtraces.
@@ -1355,6 +1453,8 @@ class Heap {
   friend class collector::ConcurrentCopying;
   friend class collector::MarkSweep;
   friend class collector::SemiSpace;
+  friend class GcErgonomicsHeapTest;
+  friend class ParallelSweepArrayHeapTest;
   friend class ReferenceQueue;
   friend class ScopedGCCriticalSection;
   friend class VerifyReferenceCardVisitor;
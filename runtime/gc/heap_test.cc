@@ -18,10 +18,14 @@
 #include "common_runtime_test.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "gc/collector/gc_type.h"
+#include "gc/collector/mark_sweep.h"
+#include "gc/space/rosalloc_space.h"
 #include "handle_scope-inl.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
 #include "mirror/object_array-inl.h"
+#include "mirror/string-inl.h"
 #include "scoped_thread_state_change.h"
 
 namespace art {
@@ -84,5 +88,248 @@ TEST_F(ZygoteHeapTest, PreZygoteFork) {
   Runtime::Current()->GetHeap()->PreZygoteFork();
 }
 
+class GcErgonomicsHeapTest : public CommonRuntimeTest {
+ protected:
+  void SetUpRuntimeOptions(RuntimeOptions* options) {
+    CommonRuntimeTest::SetUpRuntimeOptions(options);
+    options->push_back(std::make_pair("-XX:MaxGcPause=10", nullptr));
+    options->push_back(std::make_pair("-XX:MaxGcCpuPercent=10", nullptr));
+  }
+
+  void SetUp() OVERRIDE {
+    CommonRuntimeTest::SetUp();
+    heap_ = Runtime::Current()->GetHeap();
+    heap_->gc_ergonomics_last_gc_time_ = 0;
+    heap_->gc_ergonomics_last_update_time_ = 0;
+    heap_->gc_ergonomics_last_wait_time_ = 0;
+    heap_->gc_time_fraction_ = 0.0;
+    heap_->gc_ergonomics_heap_free_multiplier_ = 1.0;
+    heap_->gc_ergonomics_concurrent_start_multiplier_ = 1.0;
+    heap_->gc_ergonomics_prefer_sticky_ = false;
+    now_ = MsToNs(1000);
+    total_gc_time_ = 0;
+    total_wait_time_ = 0;
+  }
+
+  // Simulates a GC every 100ms, which took `gc_ms` of GC time and paused for at most `pause_ms`,
+  // while mutators waited `wait_ms` for GCs since the previous one.
+  void Update(collector::GcType gc_type, uint64_t gc_ms, uint64_t wait_ms, uint64_t pause_ms) {
+    now_ += MsToNs(100);
+    total_gc_time_ += MsToNs(gc_ms);
+    total_wait_time_ += MsToNs(wait_ms);
+    heap_->UpdateGcErgonomics(gc_type, now_, total_gc_time_, total_wait_time_, MsToNs(pause_ms));
+  }
+
+  uint64_t GetMaxGcPause() const {
+    return heap_->max_gc_pause_;
+  }
+
+  double GetHeapFreeMultiplier() const {
+    return heap_->gc_ergonomics_heap_free_multiplier_;
+  }
+
+  double GetConcurrentStartMultiplier() const {
+    return heap_->gc_ergonomics_concurrent_start_multiplier_;
+  }
+
+  bool PreferSticky() const {
+    return heap_->gc_ergonomics_prefer_sticky_;
+  }
+
+  Heap* heap_;
+  uint64_t now_;
+  uint64_t total_gc_time_;
+  uint64_t total_wait_time_;
+};
+
+TEST_F(GcErgonomicsHeapTest, MaxGcPauseInNanoseconds) {
+  // The option is given in ms and parsed into ns.
+  EXPECT_EQ(MsToNs(10), GetMaxGcPause());
+}
+
+TEST_F(GcErgonomicsHeapTest, ConcurrentStartFollowsMutatorWaits) {
+  // Long collector pauses alone do not start the concurrent GCs earlier, as that does not
+  // shorten them.
+  for (size_t i = 0; i < 10; ++i) {
+    Update(collector::kGcTypeSticky, /* gc_ms */ 5, /* wait_ms */ 0, /* pause_ms */ 50);
+  }
+  EXPECT_DOUBLE_EQ(1.0, GetConcurrentStartMultiplier());
+  // Mutators blocked on GCs start them earlier, up to a bound.
+  Update(collector::kGcTypeSticky, /* gc_ms */ 5, /* wait_ms */ 20, /* pause_ms */ 1);
+  EXPECT_GT(GetConcurrentStartMultiplier(), 1.0);
+  for (size_t i = 0; i < 50; ++i) {
+    Update(collector::kGcTypeSticky, /* gc_ms */ 5, /* wait_ms */ 20, /* pause_ms */ 1);
+  }
+  EXPECT_DOUBLE_EQ(8.0, GetConcurrentStartMultiplier());
+  // Once the waits are gone, the GCs start at the usual point again.
+  for (size_t i = 0; i < 50; ++i) {
+    Update(collector::kGcTypeSticky, /* gc_ms */ 5, /* wait_ms */ 5, /* pause_ms */ 1);
+  }
+  EXPECT_DOUBLE_EQ(1.0, GetConcurrentStartMultiplier());
+}
+
+TEST_F(GcErgonomicsHeapTest, PreferStickyFollowsNonStickyPauses) {
+  Update(collector::kGcTypePartial, /* gc_ms */ 5, /* wait_ms */ 0, /* pause_ms */ 20);
+  EXPECT_TRUE(PreferSticky());
+  // The shorter pauses of sticky GCs do not change the preference.
+  Update(collector::kGcTypeSticky, /* gc_ms */ 5, /* wait_ms */ 0, /* pause_ms */ 1);
+  EXPECT_TRUE(PreferSticky());
+  Update(collector::kGcTypeFull, /* gc_ms */ 5, /* wait_ms */ 0, /* pause_ms */ 5);
+  EXPECT_FALSE(PreferSticky());
+}
+
+TEST_F(GcErgonomicsHeapTest, HeapFreeFollowsGcTime) {
+  // 30% of the time in GC, above the 10% target.
+  for (size_t i = 0; i < 50; ++i) {
+    Update(collector::kGcTypeSticky, /* gc_ms */ 30, /* wait_ms */ 0, /* pause_ms */ 1);
+  }
+  EXPECT_DOUBLE_EQ(8.0, GetHeapFreeMultiplier());
+  // Between half the target and the target, the heap keeps its size.
+  for (size_t i = 0; i < 50; ++i) {
+    Update(collector::kGcTypeSticky, /* gc_ms */ 8, /* wait_ms */ 0, /* pause_ms */ 1);
+  }
+  EXPECT_DOUBLE_EQ(8.0, GetHeapFreeMultiplier());
+  // Idle, the heap shrinks back, down to a bound.
+  for (size_t i = 0; i < 100; ++i) {
+    Update(collector::kGcTypeSticky, /* gc_ms */ 0, /* wait_ms */ 0, /* pause_ms */ 1);
+  }
+  EXPECT_DOUBLE_EQ(0.25, GetHeapFreeMultiplier());
+}
+
+class EvacuationHeapTest : public CommonRuntimeTest {
+ protected:
+  void SetUpRuntimeOptions(RuntimeOptions* options) {
+    CommonRuntimeTest::SetUpRuntimeOptions(options);
+    options->push_back(std::make_pair("-Xgc:CMS", nullptr));
+    // Makes the main space movable.
+    options->push_back(std::make_pair("-XX:EnableHSpaceCompactForOOM", nullptr));
+  }
+
+  static bool IsInRuns(const std::vector<std::pair<uint8_t*, uint8_t*>>& runs,
+                       mirror::Object* obj) {
+    uint8_t* addr = reinterpret_cast<uint8_t*>(obj);
+    for (const std::pair<uint8_t*, uint8_t*>& run : runs) {
+      if (run.first <= addr && addr < run.second) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+TEST_F(EvacuationHeapTest, MovesObjectsOutOfRetiredRuns) {
+  // Strings of this length are allocated in shared runs rather than thread-local ones.
+  static constexpr size_t kLength = 400;
+  static constexpr size_t kNumStrings = 4 * KB;
+  static constexpr size_t kKeepEvery = 16;
+  Heap* heap = Runtime::Current()->GetHeap();
+  space::RosAllocSpace* space = heap->GetRosAllocSpace();
+  ASSERT_TRUE(space != nullptr);
+  ASSERT_TRUE(space->CanMoveObjects());
+  const std::string chars(kLength, 'x');
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<2> hs(soa.Self());
+  Handle<mirror::Class> c(
+      hs.NewHandle(class_linker_->FindSystemClass(soa.Self(), "[Ljava/lang/Object;")));
+  Handle<mirror::ObjectArray<mirror::Object>> survivors(hs.NewHandle(
+      mirror::ObjectArray<mirror::Object>::Alloc(soa.Self(), c.Get(), kNumStrings / kKeepEvery)));
+  ASSERT_TRUE(survivors.Get() != nullptr);
+  for (size_t i = 0; i < kNumStrings; ++i) {
+    mirror::String* string = mirror::String::AllocFromModifiedUtf8(soa.Self(), chars.c_str());
+    ASSERT_TRUE(string != nullptr);
+    if (i % kKeepEvery == 0) {
+      survivors->Set<false>(i / kKeepEvery, string);
+    }
+  }
+
+  // The first GC frees the other strings and retires the runs they leave sparse.
+  heap->CollectGarbage(false);
+  std::vector<std::pair<uint8_t*, uint8_t*>> retired_runs;
+  space->GetRosAlloc()->GetRetiredRuns(soa.Self(), &retired_runs);
+  ASSERT_FALSE(retired_runs.empty());
+  std::vector<int32_t> hash_codes;
+  size_t num_retired_survivors = 0;
+  for (int32_t i = 0; i < survivors->GetLength(); ++i) {
+    mirror::Object* obj = survivors->Get(i);
+    hash_codes.push_back(obj->IdentityHashCode());
+    if (IsInRuns(retired_runs, obj)) {
+      ++num_retired_survivors;
+    }
+  }
+  ASSERT_GT(num_retired_survivors, 0u);
+
+  // The next one moves them out, the references, contents and hash codes follow.
+  heap->CollectGarbage(false);
+  for (int32_t i = 0; i < survivors->GetLength(); ++i) {
+    mirror::Object* obj = survivors->Get(i);
+    EXPECT_FALSE(IsInRuns(retired_runs, obj));
+    EXPECT_EQ(obj->IdentityHashCode(), hash_codes[i]);
+    EXPECT_TRUE(obj->AsString()->Equals(chars.c_str()));
+  }
+}
+
+class ParallelSweepArrayHeapTest : public CommonRuntimeTest {
+ protected:
+  void SetUpRuntimeOptions(RuntimeOptions* options) {
+    CommonRuntimeTest::SetUpRuntimeOptions(options);
+    options->push_back(std::make_pair("-Xgc:CMS", nullptr));
+    options->push_back(std::make_pair("-XX:ConcGCThreads=2", nullptr));
+    // Large enough that the allocations below do not start a GC.
+    options->push_back(std::make_pair("-Xms64m", nullptr));
+  }
+
+  static size_t GetAllocationStackSize(Heap* heap) {
+    return heap->allocation_stack_->Size();
+  }
+
+  static collector::MarkSweep* GetStickyCollector(Heap* heap) {
+    return down_cast<collector::MarkSweep*>(heap->FindCollectorByGcType(collector::kGcTypeSticky));
+  }
+
+  static collector::GcType CollectSticky(Heap* heap) {
+    return heap->CollectGarbageInternal(collector::kGcTypeSticky, kGcCauseExplicit, false);
+  }
+};
+
+TEST_F(ParallelSweepArrayHeapTest, StickyGcSweepsAllocationStackInParallel) {
+  static constexpr size_t kNumStrings = 128 * KB;
+  static constexpr size_t kKeepEvery = 8;
+  Heap* heap = Runtime::Current()->GetHeap();
+  ASSERT_TRUE(heap->GetRosAllocSpace() != nullptr);
+  collector::MarkSweep* sticky = GetStickyCollector(heap);
+  ASSERT_TRUE(sticky != nullptr);
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<2> hs(soa.Self());
+  Handle<mirror::Class> c(
+      hs.NewHandle(class_linker_->FindSystemClass(soa.Self(), "[Ljava/lang/Object;")));
+  Handle<mirror::ObjectArray<mirror::Object>> survivors(hs.NewHandle(
+      mirror::ObjectArray<mirror::Object>::Alloc(soa.Self(), c.Get(), kNumStrings / kKeepEvery)));
+  ASSERT_TRUE(survivors.Get() != nullptr);
+  for (size_t i = 0; i < kNumStrings; ++i) {
+    std::string chars = std::to_string(i);
+    mirror::String* string = mirror::String::AllocFromModifiedUtf8(soa.Self(), chars.c_str());
+    ASSERT_TRUE(string != nullptr);
+    if (i % kKeepEvery == 0) {
+      survivors->Set<false>(i / kKeepEvery, string);
+    }
+  }
+  // All the strings are still on the allocation stack, enough of them for the parallel sweep.
+  ASSERT_GE(GetAllocationStackSize(heap), kNumStrings);
+  ASSERT_TRUE(sticky->UseParallelSweepArray(GetAllocationStackSize(heap)));
+
+  ASSERT_EQ(CollectSticky(heap), collector::kGcTypeSticky);
+  EXPECT_GE(heap->GetCurrentGcIteration()->GetFreedObjects(),
+            static_cast<uint64_t>(kNumStrings - kNumStrings / kKeepEvery));
+  // Reuse the freed slots, a survivor freed by mistake would be overwritten.
+  for (size_t i = 0; i < kNumStrings; ++i) {
+    ASSERT_TRUE(mirror::String::AllocFromModifiedUtf8(soa.Self(), "-") != nullptr);
+  }
+  for (int32_t i = 0; i < survivors->GetLength(); ++i) {
+    mirror::Object* obj = survivors->Get(i);
+    ASSERT_TRUE(obj != nullptr);
+    EXPECT_TRUE(obj->AsString()->Equals(std::to_string(i * kKeepEvery).c_str()));
+  }
+}
+
 }  // namespace gc
 }  // namespace art
@@ -16,8 +16,12 @@
 
 #include "reference_processor.h"
 
+#include <memory>
+#include <vector>
+
 #include "base/time_utils.h"
 #include "collector/garbage_collector.h"
+#include "heap.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
 #include "mirror/reference-inl.h"
@@ -33,11 +37,17 @@ namespace art {
 namespace gc {
 
 static constexpr bool kAsyncReferenceQueueAdd = false;
+// Clear the white references of a queue in parallel if it has at least this many references.
+static constexpr size_t kMinParallelClearReferences = 4 * KB;
+// How many queues to split a reference queue into per thread, for load balancing.
+static constexpr size_t kClearReferencesQueuesPerThread = 2;
 
 ReferenceProcessor::ReferenceProcessor()
     : collector_(nullptr),
       preserving_references_(false),
       condition_("reference processor condition", *Locks::reference_processor_lock_) ,
+      referent_blocked_time_(0U),
+      referent_blocked_count_(0U),
       soft_reference_queue_(Locks::reference_queue_soft_references_lock_),
       weak_reference_queue_(Locks::reference_queue_weak_references_lock_),
       finalizer_reference_queue_(Locks::reference_queue_finalizer_references_lock_),
@@ -73,6 +83,7 @@ mirror::Object* ReferenceProcessor::GetReferent(Thread* self, mirror::Reference*
     }
   }
   MutexLock mu(self, *Locks::reference_processor_lock_);
+  bool blocked = false;
   while ((!kUseReadBarrier && SlowPathEnabled()) ||
          (kUseReadBarrier && !self->GetWeakRefAccessEnabled())) {
     mirror::HeapReference<mirror::Object>* const referent_addr =
@@ -98,11 +109,33 @@ mirror::Object* ReferenceProcessor::GetReferent(Thread* self, mirror::Reference*
         }
       }
     }
+    if (!blocked) {
+      blocked = true;
+      ++referent_blocked_count_;
+    }
+    const uint64_t wait_start = NanoTime();
     condition_.WaitHoldingLocks(self);
+    referent_blocked_time_ += NanoTime() - wait_start;
   }
   return reference->GetReferent();
 }
 
+uint64_t ReferenceProcessor::GetReferentBlockedTime() {
+  MutexLock mu(Thread::Current(), *Locks::reference_processor_lock_);
+  return referent_blocked_time_;
+}
+
+uint64_t ReferenceProcessor::GetReferentBlockedCount() {
+  MutexLock mu(Thread::Current(), *Locks::reference_processor_lock_);
+  return referent_blocked_count_;
+}
+
+void ReferenceProcessor::ResetReferentBlockedStats() {
+  MutexLock mu(Thread::Current(), *Locks::reference_processor_lock_);
+  referent_blocked_time_ = 0U;
+  referent_blocked_count_ = 0U;
+}
+
 void ReferenceProcessor::StartPreservingReferences(Thread* self) {
   MutexLock mu(self, *Locks::reference_processor_lock_);
   preserving_references_ = true;
@@ -115,6 +148,85 @@ void ReferenceProcessor::StopPreservingReferences(Thread* self) {
   condition_.Broadcast(self);
 }
 
+void ReferenceProcessor::FinishClearingReferents(Thread* self, bool concurrent) {
+  MutexLock mu(self, *Locks::reference_processor_lock_);
+  // Need to always do this since the next GC may be concurrent. Doing this for only concurrent
+  // could result in a stale is_marked_callback_ being called before the reference processing
+  // starts since there is a small window of time where slow_path_enabled_ is enabled but the
+  // callback isn't yet set.
+  collector_ = nullptr;
+  if (!kUseReadBarrier && concurrent) {
+    // The remaining soft and weak referents are all marked and the phantom references don't give
+    // out their referent, so disable the slow path and broadcast to the waiters.
+    DisableSlowPath(self);
+  }
+}
+
+class ClearWhiteReferencesTask : public Task {
+ public:
+  ClearWhiteReferencesTask(ReferenceQueue* queue,
+                           ReferenceQueue* cleared_references,
+                           collector::GarbageCollector* collector)
+      : queue_(queue), cleared_references_(cleared_references), collector_(collector) {}
+
+  // The GC thread holds the mutator lock and the heap bitmap lock on behalf of the workers.
+  virtual void Run(Thread* self ATTRIBUTE_UNUSED) NO_THREAD_SAFETY_ANALYSIS {
+    queue_->ClearWhiteReferences(cleared_references_, collector_);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  ReferenceQueue* const queue_;
+  ReferenceQueue* const cleared_references_;
+  collector::GarbageCollector* const collector_;
+};
+
+void ReferenceProcessor::ClearWhiteReferences(ReferenceQueue* queue, bool concurrent,
+                                              collector::GarbageCollector* collector) {
+  Runtime* const runtime = Runtime::Current();
+  Heap* const heap = runtime->GetHeap();
+  ThreadPool* const thread_pool = heap->GetThreadPool();
+  // Use less threads in the background, like the marking does, and none while a transaction
+  // records the cleared referents.
+  size_t thread_count = 1;
+  if (thread_pool != nullptr && runtime->InJankPerceptibleProcessState() &&
+      !runtime->IsActiveTransaction()) {
+    thread_count =
+        (concurrent ? heap->GetConcGCThreadCount() : heap->GetParallelGCThreadCount()) + 1;
+  }
+  if (thread_count == 1 || !queue->HasAtLeast(kMinParallelClearReferences)) {
+    queue->ClearWhiteReferences(&cleared_references_, collector);
+    return;
+  }
+  Thread* const self = Thread::Current();
+  const size_t num_queues = thread_count * kClearReferencesQueuesPerThread;
+  std::vector<std::unique_ptr<ReferenceQueue>> queues;
+  std::vector<std::unique_ptr<ReferenceQueue>> cleared;
+  std::vector<ReferenceQueue*> queue_ptrs;
+  for (size_t i = 0; i < num_queues; ++i) {
+    // The temporary queues are never enqueued to atomically, their lock is unused.
+    queues.emplace_back(new ReferenceQueue(Locks::reference_queue_cleared_references_lock_));
+    cleared.emplace_back(new ReferenceQueue(Locks::reference_queue_cleared_references_lock_));
+    queue_ptrs.push_back(queues.back().get());
+  }
+  queue->DistributeTo(queue_ptrs.data(), num_queues);
+  for (size_t i = 0; i < num_queues; ++i) {
+    thread_pool->AddTask(
+        self, new ClearWhiteReferencesTask(queues[i].get(), cleared[i].get(), collector));
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
+  for (size_t i = 0; i < num_queues; ++i) {
+    DCHECK(queues[i]->IsEmpty());
+    cleared_references_.Splice(cleared[i].get());
+  }
+}
+
 // Process reference class instances and schedule finalizations.
 void ReferenceProcessor::ProcessReferences(bool concurrent, TimingLogger* timings,
                                            bool clear_soft_references,
@@ -147,8 +259,8 @@ void ReferenceProcessor::ProcessReferences(bool concurrent, TimingLogger* timing
     }
   }
   // Clear all remaining soft and weak references with white referents.
-  soft_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
-  weak_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
+  ClearWhiteReferences(&soft_reference_queue_, concurrent, collector);
+  ClearWhiteReferences(&weak_reference_queue_, concurrent, collector);
   {
     TimingLogger::ScopedTiming t2(concurrent ? "EnqueueFinalizerReferences" :
         "(Paused)EnqueueFinalizerReferences", timings);
@@ -163,27 +275,16 @@ void ReferenceProcessor::ProcessReferences(bool concurrent, TimingLogger* timing
     }
   }
   // Clear all finalizer referent reachable soft and weak references with white referents.
-  soft_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
-  weak_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
+  ClearWhiteReferences(&soft_reference_queue_, concurrent, collector);
+  ClearWhiteReferences(&weak_reference_queue_, concurrent, collector);
+  FinishClearingReferents(self, concurrent);
   // Clear all phantom references with white referents.
-  phantom_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
+  ClearWhiteReferences(&phantom_reference_queue_, concurrent, collector);
   // At this point all reference queues other than the cleared references should be empty.
   DCHECK(soft_reference_queue_.IsEmpty());
   DCHECK(weak_reference_queue_.IsEmpty());
   DCHECK(finalizer_reference_queue_.IsEmpty());
   DCHECK(phantom_reference_queue_.IsEmpty());
-  {
-    MutexLock mu(self, *Locks::reference_processor_lock_);
-    // Need to always do this since the next GC may be concurrent. Doing this for only concurrent
-    // could result in a stale is_marked_callback_ being called before the reference processing
-    // starts since there is a small window of time where slow_path_enabled_ is enabled but the
-    // callback isn't yet set.
-    collector_ = nullptr;
-    if (!kUseReadBarrier && concurrent) {
-      // Done processing, disable the slow path and broadcast to the waiters.
-      DisableSlowPath(self);
-    }
-  }
 }
 
 // Process the "referent" field in a java.lang.ref.Reference.  If the referent has not yet been
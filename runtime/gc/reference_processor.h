@@ -70,6 +70,11 @@ class ReferenceProcessor {
       SHARED_REQUIRES(Locks::mutator_lock_)
       REQUIRES(!Locks::reference_processor_lock_,
                !Locks::reference_queue_finalizer_references_lock_);
+  // The time the mutators spent blocked in GetReferent() while references were processed, and
+  // the number of GetReferent() calls that blocked.
+  uint64_t GetReferentBlockedTime() REQUIRES(!Locks::reference_processor_lock_);
+  uint64_t GetReferentBlockedCount() REQUIRES(!Locks::reference_processor_lock_);
+  void ResetReferentBlockedStats() REQUIRES(!Locks::reference_processor_lock_);
 
  private:
   bool SlowPathEnabled() SHARED_REQUIRES(Locks::mutator_lock_);
@@ -81,6 +86,15 @@ class ReferenceProcessor {
   // referents.
   void StartPreservingReferences(Thread* self) REQUIRES(!Locks::reference_processor_lock_);
   void StopPreservingReferences(Thread* self) REQUIRES(!Locks::reference_processor_lock_);
+  // Called by ProcessReferences once no soft or weak reference can be cleared anymore, so that
+  // GetReferent() stops blocking before the phantom references are processed.
+  void FinishClearingReferents(Thread* self, bool concurrent)
+      REQUIRES(!Locks::reference_processor_lock_) SHARED_REQUIRES(Locks::mutator_lock_);
+  // Clears the white references of the queue, splitting it between the heap thread pool workers
+  // if it is long enough.
+  void ClearWhiteReferences(ReferenceQueue* queue, bool concurrent,
+                            collector::GarbageCollector* collector)
+      SHARED_REQUIRES(Locks::mutator_lock_) REQUIRES(Locks::heap_bitmap_lock_);
   // Collector which is clearing references, used by the GetReferent to return referents which are
   // already marked.
   collector::GarbageCollector* collector_ GUARDED_BY(Locks::reference_processor_lock_);
@@ -90,6 +104,9 @@ class ReferenceProcessor {
   // Condition that people wait on if they attempt to get the referent of a reference while
   // processing is in progress.
   ConditionVariable condition_ GUARDED_BY(Locks::reference_processor_lock_);
+  // See GetReferentBlockedTime() and GetReferentBlockedCount().
+  uint64_t referent_blocked_time_ GUARDED_BY(Locks::reference_processor_lock_);
+  uint64_t referent_blocked_count_ GUARDED_BY(Locks::reference_processor_lock_);
   // Reference queues used by the GC.
   ReferenceQueue soft_reference_queue_;
   ReferenceQueue weak_reference_queue_;
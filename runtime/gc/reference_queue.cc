@@ -105,6 +105,41 @@ mirror::Reference* ReferenceQueue::DequeuePendingReference() {
   return ref;
 }
 
+void ReferenceQueue::DistributeTo(ReferenceQueue** queues, size_t num_queues) {
+  DCHECK_GT(num_queues, 0U);
+  if (IsEmpty()) {
+    return;
+  }
+  // Unlike DequeuePendingReference(), this leaves the read barrier state of the references alone
+  // for the queues to process.
+  mirror::Reference* const head = list_;
+  mirror::Reference* ref = head;
+  size_t i = 0;
+  do {
+    mirror::Reference* const next = ref->GetPendingNext();
+    ref->SetPendingNext(nullptr);
+    queues[i]->EnqueueReference(ref);
+    i = (i + 1 == num_queues) ? 0 : i + 1;
+    ref = next;
+  } while (ref != head);
+  list_ = nullptr;
+}
+
+void ReferenceQueue::Splice(ReferenceQueue* other) {
+  if (other->IsEmpty()) {
+    return;
+  }
+  if (IsEmpty()) {
+    list_ = other->list_;
+  } else {
+    // Join the two cycles by swapping the successors of their list heads.
+    mirror::Reference* const next = list_->GetPendingNext();
+    list_->SetPendingNext(other->list_->GetPendingNext());
+    other->list_->SetPendingNext(next);
+  }
+  other->list_ = nullptr;
+}
+
 void ReferenceQueue::Dump(std::ostream& os) const {
   mirror::Reference* cur = list_;
   os << "Reference starting at list_=" << list_ << "\n";
@@ -134,6 +169,20 @@ size_t ReferenceQueue::GetLength() const {
   return count;
 }
 
+bool ReferenceQueue::HasAtLeast(size_t length) const {
+  size_t count = 0;
+  mirror::Reference* cur = list_;
+  if (cur != nullptr) {
+    do {
+      if (++count >= length) {
+        return true;
+      }
+      cur = cur->GetPendingNext();
+    } while (cur != list_);
+  }
+  return count >= length;
+}
+
 void ReferenceQueue::ClearWhiteReferences(ReferenceQueue* cleared_references,
                                           collector::GarbageCollector* collector) {
   while (!IsEmpty()) {
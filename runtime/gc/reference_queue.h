@@ -82,8 +82,18 @@ class ReferenceQueue {
                             collector::GarbageCollector* collector)
       SHARED_REQUIRES(Locks::mutator_lock_);
 
+  // Moves the references to the given queues in round robin order without processing them, so
+  // that the queues can be processed in parallel. Not thread safe.
+  void DistributeTo(ReferenceQueue** queues, size_t num_queues)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
+  // Moves the references of the other queue to this one. Not thread safe.
+  void Splice(ReferenceQueue* other) SHARED_REQUIRES(Locks::mutator_lock_);
+
   void Dump(std::ostream& os) const SHARED_REQUIRES(Locks::mutator_lock_);
   size_t GetLength() const SHARED_REQUIRES(Locks::mutator_lock_);
+  // Faster than comparing GetLength() since it stops at the given length.
+  bool HasAtLeast(size_t length) const SHARED_REQUIRES(Locks::mutator_lock_);
 
   bool IsEmpty() const {
     return list_ == nullptr;
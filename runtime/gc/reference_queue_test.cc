@@ -84,5 +84,46 @@ TEST_F(ReferenceQueueTest, Dump) {
   queue.Dump(LOG(INFO));
 }
 
+TEST_F(ReferenceQueueTest, DistributeAndSplice) {
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  StackHandleScope<20> hs(self);
+  Mutex lock("Reference queue lock");
+  ReferenceQueue queue(&lock);
+  ReferenceQueue queue1(&lock);
+  ReferenceQueue queue2(&lock);
+  ReferenceQueue* queues[] = {&queue1, &queue2};
+  queue.DistributeTo(queues, 2);
+  ASSERT_TRUE(queue1.IsEmpty());
+  ASSERT_TRUE(queue2.IsEmpty());
+  auto ref_class = hs.NewHandle(
+      Runtime::Current()->GetClassLinker()->FindClass(self, "Ljava/lang/ref/WeakReference;",
+                                                      ScopedNullHandle<mirror::ClassLoader>()));
+  ASSERT_TRUE(ref_class.Get() != nullptr);
+  std::set<mirror::Reference*> refs;
+  for (size_t i = 0; i < 5; ++i) {
+    auto ref(hs.NewHandle(ref_class->AllocObject(self)->AsReference()));
+    ASSERT_TRUE(ref.Get() != nullptr);
+    queue.EnqueueReference(ref.Get());
+    refs.insert(ref.Get());
+  }
+  ASSERT_TRUE(queue.HasAtLeast(5U));
+  ASSERT_FALSE(queue.HasAtLeast(6U));
+  queue.DistributeTo(queues, 2);
+  ASSERT_TRUE(queue.IsEmpty());
+  ASSERT_EQ(queue1.GetLength(), 3U);
+  ASSERT_EQ(queue2.GetLength(), 2U);
+  queue.Splice(&queue1);
+  queue.Splice(&queue2);
+  ASSERT_TRUE(queue1.IsEmpty());
+  ASSERT_TRUE(queue2.IsEmpty());
+  ASSERT_EQ(queue.GetLength(), 5U);
+  std::set<mirror::Reference*> dequeued;
+  while (!queue.IsEmpty()) {
+    dequeued.insert(queue.DequeuePendingReference());
+  }
+  ASSERT_EQ(refs, dequeued);
+}
+
 }  // namespace gc
 }  // namespace art
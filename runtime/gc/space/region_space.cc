@@ -14,8 +14,11 @@
  * limitations under the License.
  */
 
+#include <vector>
+
 #include "bump_pointer_space.h"
 #include "bump_pointer_space-inl.h"
+#include "gc/accounting/card_table.h"
 #include "mirror/object-inl.h"
 #include "mirror/class-inl.h"
 #include "thread_list.h"
@@ -24,12 +27,8 @@ namespace art {
 namespace gc {
 namespace space {
 
-// If a region has live objects whose size is less than this percent
-// value of the region size, evaculate the region.
-static constexpr uint kEvaculateLivePercentThreshold = 75U;
-
 RegionSpace* RegionSpace::Create(const std::string& name, size_t capacity,
-                                 uint8_t* requested_begin) {
+                                 uint8_t* requested_begin, uint evacuate_live_percent_threshold) {
   capacity = RoundUp(capacity, kRegionSize);
   std::string error_msg;
   std::unique_ptr<MemMap> mem_map(MemMap::MapAnonymous(name.c_str(), requested_begin, capacity,
@@ -41,13 +40,17 @@ RegionSpace* RegionSpace::Create(const std::string& name, size_t capacity,
     MemMap::DumpMaps(LOG(ERROR));
     return nullptr;
   }
-  return new RegionSpace(name, mem_map.release());
+  return new RegionSpace(name, mem_map.release(), evacuate_live_percent_threshold);
 }
 
-RegionSpace::RegionSpace(const std::string& name, MemMap* mem_map)
+RegionSpace::RegionSpace(const std::string& name, MemMap* mem_map,
+                         uint evacuate_live_percent_threshold)
     : ContinuousMemMapAllocSpace(name, mem_map, mem_map->Begin(), mem_map->End(), mem_map->End(),
                                  kGcRetentionPolicyAlwaysCollect),
-      region_lock_("Region lock", kRegionSpaceRegionLock), time_(1U) {
+      region_lock_("Region lock", kRegionSpaceRegionLock), time_(1U),
+      evacuate_live_percent_threshold_(evacuate_live_percent_threshold),
+      num_numa_nodes_(1U), use_huge_pages_(false), numa_local_tlabs_(0U), numa_remote_tlabs_(0U) {
+  CHECK_LE(evacuate_live_percent_threshold, 100U);
   size_t mem_map_size = mem_map->Size();
   CHECK_ALIGNED(mem_map_size, kRegionSize);
   CHECK_ALIGNED(mem_map->Begin(), kRegionSize);
@@ -70,6 +73,33 @@ RegionSpace::RegionSpace(const std::string& name, MemMap* mem_map)
     }
     CHECK_EQ(regions_[num_regions_ - 1].End(), Limit());
   }
+  if (kUseNumaAwareRegions) {
+    // Give each node a contiguous pool of at least one region and prefer the node for the pool's
+    // pages. The pages are only faulted in when a region is first used, so the policy decides
+    // where they land.
+    std::vector<size_t> numa_nodes = GetOnlineNumaNodes();
+    if (numa_nodes.size() > num_regions_) {
+      numa_nodes.resize(num_regions_);
+    }
+    if (numa_nodes.size() > 1U) {
+      numa_pool_nodes_ = numa_nodes;
+      num_numa_nodes_ = numa_pool_nodes_.size();
+      for (size_t pool = 0; pool < num_numa_nodes_; ++pool) {
+        uint8_t* pool_begin = regions_[NumaPoolBegin(pool)].Begin();
+        size_t pool_size = (NumaPoolEnd(pool) - NumaPoolBegin(pool)) * kRegionSize;
+        if (!mem_map->BindToNumaNode(pool_begin, pool_size, numa_pool_nodes_[pool])) {
+          // Without memory policies the pools would only be a partition of the regions. Undo the
+          // policies of the pools bound so far, so that no part of the space prefers a node.
+          mem_map->ResetNumaPolicy();
+          numa_pool_nodes_.clear();
+          num_numa_nodes_ = 1U;
+          break;
+        }
+      }
+      VLOG(heap) << "Split " << num_regions_ << " regions of " << name << " into "
+                 << num_numa_nodes_ << " NUMA pools";
+    }
+  }
   full_region_ = Region();
   DCHECK(!full_region_.IsFree());
   DCHECK(full_region_.IsAllocated());
@@ -77,6 +107,9 @@ RegionSpace::RegionSpace(const std::string& name, MemMap* mem_map)
   evac_region_ = nullptr;
   size_t ignored;
   DCHECK(full_region_.Alloc(kAlignment, &ignored, nullptr, &ignored) == nullptr);
+  cc_mark_bitmap_.reset(accounting::ContinuousSpaceBitmap::Create("cc region space bitmap",
+                                                                  Begin(), Capacity()));
+  CHECK(cc_mark_bitmap_.get() != nullptr) << "Failed to create the region space mark bitmap";
 }
 
 size_t RegionSpace::FromSpaceSize() {
@@ -115,11 +148,12 @@ size_t RegionSpace::ToSpaceSize() {
   return num_regions * kRegionSize;
 }
 
-inline bool RegionSpace::Region::ShouldBeEvacuated() {
+inline bool RegionSpace::Region::ShouldBeEvacuated(uint evacuate_live_percent_threshold) {
   DCHECK((IsAllocated() || IsLarge()) && IsInToSpace());
   // if the region was allocated after the start of the
   // previous GC or the live ratio is below threshold, evacuate
-  // it.
+  // it. Denser regions are marked in place, which saves copying
+  // long-lived data over and over.
   bool result;
   if (is_newly_allocated_) {
     result = true;
@@ -131,7 +165,7 @@ inline bool RegionSpace::Region::ShouldBeEvacuated() {
         // Side node: live_percent == 0 does not necessarily mean
         // there's no live objects due to rounding (there may be a
         // few).
-        result = live_percent < kEvaculateLivePercentThreshold;
+        result = live_percent < evacuate_live_percent_threshold;
       } else {
         DCHECK(IsLarge());
         result = live_percent == 0U;
@@ -144,8 +178,10 @@ inline bool RegionSpace::Region::ShouldBeEvacuated() {
 }
 
 // Determine which regions to evacuate and mark them as
-// from-space. Mark the rest as unevacuated from-space.
-void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table, bool force_evacuate_all) {
+// from-space. Mark the rest as unevacuated from-space, or leave them
+// in the to-space for a young collection.
+void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table, bool force_evacuate_all,
+                               bool young_gen) {
   ++time_;
   if (kUseTableLookupReadBarrier) {
     DCHECK(rb_table->IsAllCleared());
@@ -164,13 +200,24 @@ void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table, bool forc
         DCHECK((state == RegionState::kRegionStateAllocated ||
                 state == RegionState::kRegionStateLarge) &&
                type == RegionType::kRegionTypeToSpace);
-        bool should_evacuate = force_evacuate_all || r->ShouldBeEvacuated();
+        bool should_evacuate;
+        if (young_gen) {
+          // Only the young regions are collected. Their survivors get promoted by being copied
+          // into (old) evacuation regions.
+          should_evacuate = r->IsYoung();
+        } else {
+          should_evacuate =
+              force_evacuate_all || r->ShouldBeEvacuated(evacuate_live_percent_threshold_);
+        }
         if (should_evacuate) {
           r->SetAsFromSpace();
           DCHECK(r->IsInFromSpace());
-        } else {
+        } else if (!young_gen) {
           r->SetAsUnevacFromSpace();
           DCHECK(r->IsInUnevacFromSpace());
+        } else if (kUseTableLookupReadBarrier) {
+          // Old regions stay in the to-space during a young collection.
+          rb_table->Clear(r->Begin(), r->End());
         }
         if (UNLIKELY(state == RegionState::kRegionStateLarge &&
                      type == RegionType::kRegionTypeToSpace)) {
@@ -184,9 +231,11 @@ void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table, bool forc
         if (prev_large_evacuated) {
           r->SetAsFromSpace();
           DCHECK(r->IsInFromSpace());
-        } else {
+        } else if (!young_gen) {
           r->SetAsUnevacFromSpace();
           DCHECK(r->IsInUnevacFromSpace());
+        } else if (kUseTableLookupReadBarrier) {
+          rb_table->Clear(r->Begin(), r->End());
         }
         --num_expected_large_tails;
       }
@@ -202,20 +251,64 @@ void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table, bool forc
   evac_region_ = &full_region_;
 }
 
-void RegionSpace::ClearFromSpace() {
+void RegionSpace::ClearFromSpace(accounting::CardTable* card_table) {
   MutexLock mu(Thread::Current(), region_lock_);
+  std::vector<Region*> cleared_regions;
   for (size_t i = 0; i < num_regions_; ++i) {
     Region* r = &regions_[i];
     if (r->IsInFromSpace()) {
-      r->Clear();
+      if (card_table != nullptr) {
+        card_table->ClearCardRange(r->Begin(), r->End());
+      }
+      r->Clear(!use_huge_pages_);
       --num_non_free_regions_;
+      if (use_huge_pages_) {
+        cleared_regions.push_back(r);
+      }
     } else if (r->IsInUnevacFromSpace()) {
       r->SetUnevacFromSpaceAsToSpace();
     }
   }
+  // Free all the regions first so that the huge pages whose regions are all cleared get released.
+  for (Region* r : cleared_regions) {
+    ZeroAndReleaseRegion(r);
+  }
   evac_region_ = nullptr;
 }
 
+void RegionSpace::ZeroAndReleaseRegion(Region* r) {
+  static_assert(MemMap::kHugePageSize % kRegionSize == 0,
+                "Huge pages must be made of whole regions");
+  DCHECK(r->IsFree());
+  uint8_t* begin = r->Begin();
+  size_t size = kRegionSize;
+  if (use_huge_pages_) {
+    uint8_t* huge_page_begin = AlignDown(r->Begin(), MemMap::kHugePageSize);
+    uint8_t* huge_page_end = huge_page_begin + MemMap::kHugePageSize;
+    bool release_huge_page = huge_page_begin >= Begin() && huge_page_end <= Limit();
+    for (uint8_t* addr = huge_page_begin; release_huge_page && addr < huge_page_end;
+         addr += kRegionSize) {
+      release_huge_page = regions_[(addr - Begin()) / kRegionSize].IsFree();
+    }
+    if (!release_huge_page) {
+      // The allocation paths expect zeroed memory.
+      memset(begin, 0, size);
+      return;
+    }
+    begin = huge_page_begin;
+    size = MemMap::kHugePageSize;
+  }
+  if (!kMadviseZeroes) {
+    memset(begin, 0, size);
+  }
+  madvise(begin, size, MADV_DONTNEED);
+}
+
+void RegionSpace::SetUseHugePages(bool use_huge_pages) {
+  MutexLock mu(Thread::Current(), region_lock_);
+  use_huge_pages_ = use_huge_pages;
+}
+
 void RegionSpace::AssertAllRegionLiveBytesZeroOrCleared() {
   if (kIsDebugBuild) {
     MutexLock mu(Thread::Current(), region_lock_);
@@ -274,8 +367,16 @@ void RegionSpace::Clear() {
     if (!r->IsFree()) {
       --num_non_free_regions_;
     }
-    r->Clear();
+    r->Clear(!use_huge_pages_);
+  }
+  if (use_huge_pages_) {
+    // Release the whole space at once rather than region by region.
+    if (!kMadviseZeroes) {
+      memset(Begin(), 0, Limit() - Begin());
+    }
+    madvise(Begin(), Limit() - Begin(), MADV_DONTNEED);
   }
+  cc_mark_bitmap_->Clear();
   current_region_ = &full_region_;
   evac_region_ = &full_region_;
 }
@@ -299,9 +400,14 @@ void RegionSpace::FreeLarge(mirror::Object* large_obj, size_t bytes_allocated) {
     } else {
       DCHECK(reg->IsLargeTail());
     }
-    reg->Clear();
+    reg->Clear(!use_huge_pages_);
     --num_non_free_regions_;
   }
+  if (use_huge_pages_) {
+    for (uint8_t* addr = begin_addr; addr < end_addr; addr += kRegionSize) {
+      ZeroAndReleaseRegion(RefToRegionLocked(reinterpret_cast<mirror::Object*>(addr)));
+    }
+  }
   if (end_addr < Limit()) {
     // If we aren't at the end of the space, check that the next region is not a large tail.
     Region* following_reg = RefToRegionLocked(reinterpret_cast<mirror::Object*>(end_addr));
@@ -332,6 +438,31 @@ void RegionSpace::RecordAlloc(mirror::Object* ref) {
   reinterpret_cast<Atomic<uint64_t>*>(&r->objects_allocated_)->FetchAndAddSequentiallyConsistent(1);
 }
 
+size_t RegionSpace::GetLocalNumaPool() const {
+  if (num_numa_nodes_ == 1U) {
+    return 0U;
+  }
+  // There are only a few nodes, a linear search is fine.
+  const size_t node = GetCurrentNumaNode();
+  for (size_t pool = 0; pool < num_numa_nodes_; ++pool) {
+    if (numa_pool_nodes_[pool] == node) {
+      return pool;
+    }
+  }
+  // The node got no pool, because the space has fewer regions than there are nodes.
+  return node % num_numa_nodes_;
+}
+
+RegionSpace::Region* RegionSpace::FindFreeRegionInNumaPool(size_t pool) {
+  for (size_t i = NumaPoolBegin(pool), end = NumaPoolEnd(pool); i < end; ++i) {
+    Region* r = &regions_[i];
+    if (r->IsFree()) {
+      return r;
+    }
+  }
+  return nullptr;
+}
+
 bool RegionSpace::AllocNewTlab(Thread* self) {
   MutexLock mu(self, region_lock_);
   RevokeThreadLocalBuffersLocked(self);
@@ -339,10 +470,14 @@ bool RegionSpace::AllocNewTlab(Thread* self) {
   if ((num_non_free_regions_ + 1) * 2 > num_regions_) {
     return false;
   }
-  for (size_t i = 0; i < num_regions_; ++i) {
-    Region* r = &regions_[i];
-    if (r->IsFree()) {
+  // Try the pool of the node the thread is running on first. If it ran out, fall back to the
+  // other nodes in order, starting with the next one so that the spill is spread across them.
+  const size_t local_pool = GetLocalNumaPool();
+  for (size_t i = 0; i < num_numa_nodes_; ++i) {
+    Region* r = FindFreeRegionInNumaPool((local_pool + i) % num_numa_nodes_);
+    if (r != nullptr) {
       r->Unfree(time_);
+      r->SetYoung();
       ++num_non_free_regions_;
       // TODO: this is buggy. Debug it.
       // r->SetNewlyAllocated();
@@ -350,12 +485,27 @@ bool RegionSpace::AllocNewTlab(Thread* self) {
       r->is_a_tlab_ = true;
       r->thread_ = self;
       self->SetTlab(r->Begin(), r->End());
+      if (i == 0) {
+        ++numa_local_tlabs_;
+      } else {
+        ++numa_remote_tlabs_;
+      }
       return true;
     }
   }
   return false;
 }
 
+uint64_t RegionSpace::GetNumaLocalTlabs() {
+  MutexLock mu(Thread::Current(), region_lock_);
+  return numa_local_tlabs_;
+}
+
+uint64_t RegionSpace::GetNumaRemoteTlabs() {
+  MutexLock mu(Thread::Current(), region_lock_);
+  return numa_remote_tlabs_;
+}
+
 size_t RegionSpace::RevokeThreadLocalBuffers(Thread* thread) {
   MutexLock mu(Thread::Current(), region_lock_);
   RevokeThreadLocalBuffersLocked(thread);
@@ -413,7 +563,8 @@ void RegionSpace::Region::Dump(std::ostream& os) const {
      << " state=" << static_cast<uint>(state_) << " type=" << static_cast<uint>(type_)
      << " objects_allocated=" << objects_allocated_
      << " alloc_time=" << alloc_time_ << " live_bytes=" << live_bytes_
-     << " is_newly_allocated=" << is_newly_allocated_ << " is_a_tlab=" << is_a_tlab_ << " thread=" << thread_ << "\n";
+     << " is_newly_allocated=" << is_newly_allocated_ << " is_young=" << is_young_
+     << " is_a_tlab=" << is_a_tlab_ << " thread=" << thread_ << "\n";
 }
 
 }  // namespace space
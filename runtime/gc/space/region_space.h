@@ -18,12 +18,18 @@
 #define ART_RUNTIME_GC_SPACE_REGION_SPACE_H_
 
 #include "gc/accounting/read_barrier_table.h"
+#include "gc/accounting/space_bitmap.h"
 #include "object_callbacks.h"
 #include "space.h"
 #include "thread.h"
 
 namespace art {
 namespace gc {
+
+namespace accounting {
+class CardTable;
+}  // namespace accounting
+
 namespace space {
 
 // A space that consists of equal-sized regions.
@@ -37,8 +43,11 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
 
   // Create a region space with the requested sizes. The requested base address is not
   // guaranteed to be granted, if it is required, the caller should call Begin on the returned
-  // space to confirm the request was granted.
-  static RegionSpace* Create(const std::string& name, size_t capacity, uint8_t* requested_begin);
+  // space to confirm the request was granted. Regions whose live percent from the previous
+  // collection is at or above evacuate_live_percent_threshold are marked in place instead of
+  // being evacuated.
+  static RegionSpace* Create(const std::string& name, size_t capacity, uint8_t* requested_begin,
+                             uint evacuate_live_percent_threshold);
 
   // Allocate num_bytes, returns null if the space is full.
   mirror::Object* Alloc(Thread* self, size_t num_bytes, size_t* bytes_allocated,
@@ -169,6 +178,9 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
   static constexpr size_t kAlignment = kObjectAlignment;
   // The region size.
   static constexpr size_t kRegionSize = 1 * MB;
+  // Whether to split the regions into per NUMA node pools and hand out TLABs from the pool of the
+  // allocating thread's node on multi-node machines.
+  static constexpr bool kUseNumaAwareRegions = true;
 
   bool IsInFromSpace(mirror::Object* ref) {
     if (HasAddress(ref)) {
@@ -202,13 +214,18 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
     return RegionType::kRegionTypeNone;
   }
 
-  void SetFromSpace(accounting::ReadBarrierTable* rb_table, bool force_evacuate_all)
+  // Determine which regions to evacuate. A young collection (young_gen is true) only evacuates
+  // the regions allocated by mutators since the last collection and leaves the rest in the
+  // to-space.
+  void SetFromSpace(accounting::ReadBarrierTable* rb_table, bool force_evacuate_all, bool young_gen)
       REQUIRES(!region_lock_);
 
   size_t FromSpaceSize() REQUIRES(!region_lock_);
   size_t UnevacFromSpaceSize() REQUIRES(!region_lock_);
   size_t ToSpaceSize() REQUIRES(!region_lock_);
-  void ClearFromSpace() REQUIRES(!region_lock_);
+  // Free the from-space regions. If card_table is not null, also clear their cards so that the
+  // next young collection doesn't scan the objects later allocated in them.
+  void ClearFromSpace(accounting::CardTable* card_table = nullptr) REQUIRES(!region_lock_);
 
   void AddLiveBytes(mirror::Object* ref, size_t alloc_size) {
     Region* reg = RefToRegionUnlocked(ref);
@@ -220,12 +237,30 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
   void RecordAlloc(mirror::Object* ref) REQUIRES(!region_lock_);
   bool AllocNewTlab(Thread* self) REQUIRES(!region_lock_);
 
+  // The number of TLABs handed out from the allocating thread's NUMA node and from another node
+  // because the local pool ran out.
+  uint64_t GetNumaLocalTlabs() REQUIRES(!region_lock_);
+  uint64_t GetNumaRemoteTlabs() REQUIRES(!region_lock_);
+  size_t GetNumaPoolCount() const {
+    return num_numa_nodes_;
+  }
+
+  // Called once the space's memory is advised to use transparent huge pages. Cleared regions are
+  // then only released in whole huge pages so that the kernel doesn't split them.
+  void SetUseHugePages(bool use_huge_pages) REQUIRES(!region_lock_);
+
   uint32_t Time() {
     return time_;
   }
 
+  // The mark bitmap used by the concurrent copying collector. It is kept across collections so
+  // that a young collection can find the old objects that are on dirty cards.
+  accounting::ContinuousSpaceBitmap* GetCCMarkBitmap() {
+    return cc_mark_bitmap_.get();
+  }
+
  private:
-  RegionSpace(const std::string& name, MemMap* mem_map);
+  RegionSpace(const std::string& name, MemMap* mem_map, uint evacuate_live_percent_threshold);
 
   template<bool kToSpaceOnly>
   void WalkInternal(ObjectCallback* callback, void* arg) NO_THREAD_SAFETY_ANALYSIS;
@@ -237,13 +272,13 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
           begin_(nullptr), top_(nullptr), end_(nullptr),
           state_(RegionState::kRegionStateAllocated), type_(RegionType::kRegionTypeToSpace),
           objects_allocated_(0), alloc_time_(0), live_bytes_(static_cast<size_t>(-1)),
-          is_newly_allocated_(false), is_a_tlab_(false), thread_(nullptr) {}
+          is_newly_allocated_(false), is_young_(false), is_a_tlab_(false), thread_(nullptr) {}
 
     Region(size_t idx, uint8_t* begin, uint8_t* end)
         : idx_(idx), begin_(begin), top_(begin), end_(end),
           state_(RegionState::kRegionStateFree), type_(RegionType::kRegionTypeNone),
           objects_allocated_(0), alloc_time_(0), live_bytes_(static_cast<size_t>(-1)),
-          is_newly_allocated_(false), is_a_tlab_(false), thread_(nullptr) {
+          is_newly_allocated_(false), is_young_(false), is_a_tlab_(false), thread_(nullptr) {
       DCHECK_LT(begin, end);
       DCHECK_EQ(static_cast<size_t>(end - begin), kRegionSize);
     }
@@ -256,18 +291,22 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
       return type_;
     }
 
-    void Clear() {
+    // If zero_and_release_pages is false, the caller is responsible for zeroing the region.
+    void Clear(bool zero_and_release_pages) {
       top_ = begin_;
       state_ = RegionState::kRegionStateFree;
       type_ = RegionType::kRegionTypeNone;
       objects_allocated_ = 0;
       alloc_time_ = 0;
       live_bytes_ = static_cast<size_t>(-1);
-      if (!kMadviseZeroes) {
-        memset(begin_, 0, end_ - begin_);
+      if (zero_and_release_pages) {
+        if (!kMadviseZeroes) {
+          memset(begin_, 0, end_ - begin_);
+        }
+        madvise(begin_, end_ - begin_, MADV_DONTNEED);
       }
-      madvise(begin_, end_ - begin_, MADV_DONTNEED);
       is_newly_allocated_ = false;
+      is_young_ = false;
       is_a_tlab_ = false;
       thread_ = nullptr;
     }
@@ -312,6 +351,14 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
       is_newly_allocated_ = true;
     }
 
+    void SetYoung() {
+      is_young_ = true;
+    }
+
+    bool IsYoung() const {
+      return is_young_;
+    }
+
     // Non-large, non-large-tail allocated.
     bool IsAllocated() const {
       return state_ == RegionState::kRegionStateAllocated;
@@ -365,6 +412,8 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
       DCHECK(!IsFree() && IsInToSpace());
       type_ = RegionType::kRegionTypeUnevacFromSpace;
       live_bytes_ = 0U;
+      // Survivors are old from now on.
+      is_young_ = false;
     }
 
     void SetUnevacFromSpaceAsToSpace() {
@@ -372,7 +421,7 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
       type_ = RegionType::kRegionTypeToSpace;
     }
 
-    ALWAYS_INLINE bool ShouldBeEvacuated();
+    ALWAYS_INLINE bool ShouldBeEvacuated(uint evacuate_live_percent_threshold);
 
     void AddLiveBytes(size_t live_bytes) {
       DCHECK(IsInUnevacFromSpace());
@@ -472,6 +521,8 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
     uint32_t alloc_time_;          // The allocation time of the region.
     size_t live_bytes_;            // The live bytes. Used to compute the live percent.
     bool is_newly_allocated_;      // True if it's allocated after the last collection.
+    bool is_young_;                // True if a mutator allocated it (including as a tlab or a
+                                   // large object) after the last collection.
     bool is_a_tlab_;               // True if it's a tlab.
     Thread* thread_;               // The owning thread if it's a tlab.
 
@@ -508,6 +559,22 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
   mirror::Object* GetNextObject(mirror::Object* obj)
       SHARED_REQUIRES(Locks::mutator_lock_);
 
+  // The regions [begin, end) of the given NUMA pool.
+  size_t NumaPoolBegin(size_t pool) const {
+    return pool * num_regions_ / num_numa_nodes_;
+  }
+  size_t NumaPoolEnd(size_t pool) const {
+    return (pool + 1) * num_regions_ / num_numa_nodes_;
+  }
+  // Returns the pool of the NUMA node the calling thread runs on.
+  size_t GetLocalNumaPool() const;
+  // Returns the first free region of the given NUMA pool, or null.
+  Region* FindFreeRegionInNumaPool(size_t pool) REQUIRES(region_lock_);
+
+  // Zeroes a region cleared with Region::Clear(false). With huge pages, the region's huge page is
+  // released if all of its regions are free and the region is zeroed by hand otherwise.
+  void ZeroAndReleaseRegion(Region* r) REQUIRES(region_lock_);
+
   Mutex region_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
 
   uint32_t time_;                  // The time as the number of collections since the startup.
@@ -518,6 +585,15 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
   Region* current_region_;         // The region that's being allocated currently.
   Region* evac_region_;            // The region that's being evacuated to currently.
   Region full_region_;             // The dummy/sentinel region that looks full.
+  const uint evacuate_live_percent_threshold_;  // See Create().
+  size_t num_numa_nodes_;          // The number of NUMA pools the regions are split into.
+  std::vector<size_t> numa_pool_nodes_;  // The NUMA node ID of each pool, if there are several.
+  bool use_huge_pages_ GUARDED_BY(region_lock_);  // See SetUseHugePages().
+  uint64_t numa_local_tlabs_ GUARDED_BY(region_lock_);   // See GetNumaLocalTlabs().
+  uint64_t numa_remote_tlabs_ GUARDED_BY(region_lock_);  // See GetNumaRemoteTlabs().
+
+  // The concurrent copying mark bitmap, see GetCCMarkBitmap().
+  std::unique_ptr<accounting::ContinuousSpaceBitmap> cc_mark_bitmap_;
 
   DISALLOW_COPY_AND_ASSIGN(RegionSpace);
 };
@@ -201,6 +201,17 @@ size_t RosAllocSpace::Free(Thread* self, mirror::Object* ptr) {
 }
 
 size_t RosAllocSpace::FreeList(Thread* self, size_t num_ptrs, mirror::Object** ptrs) {
+  return FreeListInternal<false>(self, num_ptrs, ptrs);
+}
+
+size_t RosAllocSpace::FreeListInParallelSweep(Thread* self,
+                                              size_t num_ptrs,
+                                              mirror::Object** ptrs) {
+  return FreeListInternal<true>(self, num_ptrs, ptrs);
+}
+
+template<bool kInParallelSweep>
+size_t RosAllocSpace::FreeListInternal(Thread* self, size_t num_ptrs, mirror::Object** ptrs) {
   DCHECK(ptrs != nullptr);
 
   size_t verify_bytes = 0;
@@ -234,7 +245,9 @@ size_t RosAllocSpace::FreeList(Thread* self, size_t num_ptrs, mirror::Object** p
     CHECK_EQ(num_broken_ptrs, 0u);
   }
 
-  const size_t bytes_freed = rosalloc_->BulkFree(self, reinterpret_cast<void**>(ptrs), num_ptrs);
+  const size_t bytes_freed = kInParallelSweep
+      ? rosalloc_->BulkFreeInParallel(self, reinterpret_cast<void**>(ptrs), num_ptrs)
+      : rosalloc_->BulkFree(self, reinterpret_cast<void**>(ptrs), num_ptrs);
   if (kVerifyFreedBytes) {
     CHECK_EQ(verify_bytes, bytes_freed);
   }
@@ -67,6 +67,10 @@ class RosAllocSpace : public MallocSpace {
       SHARED_REQUIRES(Locks::mutator_lock_);
   size_t FreeList(Thread* self, size_t num_ptrs, mirror::Object** ptrs) OVERRIDE
       SHARED_REQUIRES(Locks::mutator_lock_);
+  // Like FreeList(), for the threads sweeping in parallel between
+  // RosAlloc::StartParallelBulkFree() and RosAlloc::FinishParallelBulkFree().
+  size_t FreeListInParallelSweep(Thread* self, size_t num_ptrs, mirror::Object** ptrs)
+      SHARED_REQUIRES(Locks::mutator_lock_);
 
   mirror::Object* AllocNonvirtual(Thread* self, size_t num_bytes, size_t* bytes_allocated,
                                   size_t* usable_size, size_t* bytes_tl_bulk_allocated) {
@@ -153,6 +157,10 @@ class RosAllocSpace : public MallocSpace {
                 bool low_memory_mode);
 
  private:
+  template<bool kInParallelSweep>
+  size_t FreeListInternal(Thread* self, size_t num_ptrs, mirror::Object** ptrs)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
   template<bool kThreadSafe = true>
   mirror::Object* AllocCommon(Thread* self, size_t num_bytes, size_t* bytes_allocated,
                               size_t* usable_size, size_t* bytes_tl_bulk_allocated);
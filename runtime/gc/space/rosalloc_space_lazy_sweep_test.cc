@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "gc/allocator/rosalloc.h"
+#include "scoped_thread_state_change.h"
+#include "space_test.h"
+
+namespace art {
+namespace gc {
+namespace space {
+
+class RosAllocSpaceLazySweepTest : public SpaceTest<CommonRuntimeTest> {
+ protected:
+  typedef allocator::RosAlloc::Run Run;
+
+  // Mid-sized, so that the objects come from the shared runs rather than thread-local ones.
+  static constexpr size_t kObjectSize = 1 * KB;
+  static constexpr size_t kNumRuns = 8;
+  static constexpr size_t kCapacity = 16 * MB;
+
+  void SetUp() OVERRIDE {
+    SpaceTest<CommonRuntimeTest>::SetUp();
+    space_.reset(RosAllocSpace::Create("test", kCapacity, kCapacity, kCapacity, nullptr, false,
+                                       false));
+    ASSERT_TRUE(space_ != nullptr);
+    rosalloc_ = space_->GetRosAlloc();
+    // Fill the runs in allocation order.
+    rosalloc_->SetUseMagazines(false);
+  }
+
+  void TearDown() OVERRIDE {
+    space_.reset();
+    SpaceTest<CommonRuntimeTest>::TearDown();
+  }
+
+  static size_t Index() {
+    return allocator::RosAlloc::SizeToIndex(kObjectSize);
+  }
+
+  static size_t NumOfSlots() {
+    return allocator::RosAlloc::numOfSlots[Index()];
+  }
+
+  static size_t BracketSize() {
+    return allocator::RosAlloc::IndexToBracketSize(Index());
+  }
+
+  Run* GetRun(mirror::Object* obj) {
+    size_t pm_idx = rosalloc_->RoundDownToPageMapIndex(obj);
+    while (rosalloc_->page_map_[pm_idx] == allocator::RosAlloc::kPageMapRunPart) {
+      --pm_idx;
+    }
+    EXPECT_EQ(rosalloc_->page_map_[pm_idx], allocator::RosAlloc::kPageMapRun);
+    return reinterpret_cast<Run*>(rosalloc_->base_ + pm_idx * kPageSize);
+  }
+
+  bool IsToBeSwept(Run* run) {
+    const auto& runs_to_sweep = rosalloc_->runs_to_sweep_[Index()];
+    return runs_to_sweep.find(run) != runs_to_sweep.end();
+  }
+
+  Run* CurrentRun() {
+    return rosalloc_->current_runs_[Index()];
+  }
+
+  size_t NumRunsToSweep() {
+    return rosalloc_->runs_to_sweep_[Index()].size();
+  }
+
+  mirror::Object* Alloc(Thread* self) SHARED_REQUIRES(Locks::mutator_lock_) {
+    size_t bytes_allocated = 0;
+    size_t usable_size = 0;
+    size_t bytes_tl_bulk_allocated = 0;
+    mirror::Object* obj = space_->Alloc(self, kObjectSize, &bytes_allocated, &usable_size,
+                                        &bytes_tl_bulk_allocated);
+    EXPECT_TRUE(obj != nullptr);
+    return obj;
+  }
+
+  // Fills kNumRuns runs and bulk frees all objects but one in keep_every of them, as the GC
+  // does. Returns the objects left.
+  std::vector<mirror::Object*> AllocateAndBulkFree(Thread* self, size_t keep_every)
+      SHARED_REQUIRES(Locks::mutator_lock_) {
+    std::vector<mirror::Object*> survivors;
+    std::vector<mirror::Object*> garbage;
+    for (size_t i = 0; i < kNumRuns * NumOfSlots(); ++i) {
+      mirror::Object* obj = Alloc(self);
+      if (i % keep_every == 0) {
+        survivors.push_back(obj);
+      } else {
+        garbage.push_back(obj);
+      }
+    }
+    // The freed bytes are accounted right away, even for the slots left to the allocator.
+    EXPECT_EQ(space_->FreeList(self, garbage.size(), garbage.data()),
+              garbage.size() * BracketSize());
+    return survivors;
+  }
+
+  std::unique_ptr<RosAllocSpace> space_;
+  allocator::RosAlloc* rosalloc_;
+};
+
+TEST_F(RosAllocSpaceLazySweepTest, LeavesFullRunsToTheAllocator) {
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  std::vector<mirror::Object*> survivors = AllocateAndBulkFree(self, 4);
+  std::map<Run*, size_t> num_survivors_per_run;
+  for (mirror::Object* obj : survivors) {
+    ++num_survivors_per_run[GetRun(obj)];
+  }
+  ASSERT_EQ(num_survivors_per_run.size(), kNumRuns);
+  // All the runs but the current one are left unswept, the freed slots are not in their free
+  // lists yet.
+  EXPECT_EQ(NumRunsToSweep(), kNumRuns - 1);
+  for (const std::pair<Run*, size_t>& entry : num_survivors_per_run) {
+    Run* run = entry.first;
+    if (run == CurrentRun()) {
+      EXPECT_FALSE(IsToBeSwept(run));
+      EXPECT_EQ(run->NumberOfFreeSlots(), NumOfSlots() - entry.second);
+    } else {
+      EXPECT_TRUE(IsToBeSwept(run));
+      EXPECT_EQ(run->NumberOfFreeSlots(), 0u);
+      EXPECT_EQ(run->LazyFreeList()->Size(), NumOfSlots() - entry.second);
+    }
+  }
+  // The unswept slots do not count as allocated.
+  EXPECT_EQ(space_->GetBytesAllocated(), survivors.size() * BracketSize());
+}
+
+TEST_F(RosAllocSpaceLazySweepTest, SweepsRunBeforeAllocating) {
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  std::vector<mirror::Object*> survivors = AllocateAndBulkFree(self, 4);
+  ASSERT_EQ(NumRunsToSweep(), kNumRuns - 1);
+  // Fill the current run again.
+  Run* current_run = CurrentRun();
+  for (size_t i = current_run->NumberOfFreeSlots(); i != 0; --i) {
+    survivors.push_back(Alloc(self));
+    EXPECT_EQ(GetRun(survivors.back()), current_run);
+  }
+  ASSERT_EQ(NumRunsToSweep(), kNumRuns - 1);
+  // There are no non-full runs, the allocator sweeps one of the runs left to it.
+  mirror::Object* obj = Alloc(self);
+  Run* run = GetRun(obj);
+  EXPECT_NE(run, current_run);
+  EXPECT_EQ(NumRunsToSweep(), kNumRuns - 2);
+  EXPECT_FALSE(IsToBeSwept(run));
+  EXPECT_TRUE(run->IsLazyFreeListEmpty());
+  // The slot is one of the freed ones, the run has the objects it kept and the new one.
+  size_t num_survivors_in_run = 0;
+  for (mirror::Object* survivor : survivors) {
+    if (GetRun(survivor) == run) {
+      ++num_survivors_in_run;
+    }
+  }
+  EXPECT_EQ(run->NumberOfFreeSlots(), NumOfSlots() - num_survivors_in_run - 1);
+  EXPECT_EQ(space_->GetBytesAllocated(), (survivors.size() + 1) * BracketSize());
+}
+
+TEST_F(RosAllocSpaceLazySweepTest, SweepsRunBeforeFreeing) {
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  std::vector<mirror::Object*> survivors = AllocateAndBulkFree(self, 4);
+  mirror::Object* obj = survivors.front();
+  Run* run = GetRun(obj);
+  ASSERT_TRUE(IsToBeSwept(run));
+  const size_t num_free_slots = run->LazyFreeList()->Size() + 1;
+  EXPECT_EQ(space_->Free(self, obj), BracketSize());
+  EXPECT_FALSE(IsToBeSwept(run));
+  EXPECT_TRUE(run->IsLazyFreeListEmpty());
+  EXPECT_EQ(run->NumberOfFreeSlots(), num_free_slots);
+}
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "base/time_utils.h"
+#include "gc/allocator/rosalloc.h"
+#include "space_test.h"
+#include "thread_pool.h"
+
+namespace art {
+namespace gc {
+namespace space {
+
+class RosAllocSpaceMultiThreadTest : public SpaceTest<CommonRuntimeTest> {};
+
+// Allocates mid-sized objects, i.e. the ones without thread-local runs, from a thread pool worker.
+class MidSizeAllocTask : public Task {
+ public:
+  MidSizeAllocTask(RosAllocSpace* space, size_t num_allocs, size_t seed)
+      : space_(space),
+        num_allocs_(num_allocs),
+        seed_(seed),
+        bytes_allocated_(0),
+        bytes_tl_bulk_allocated_(0),
+        bytes_revoked_(0) {}
+
+  void Run(Thread* self) {
+    static constexpr size_t kMinSize = allocator::RosAlloc::kMaxThreadLocalBracketSize + 1;
+    static constexpr size_t kMaxSize = 1 * KB;
+    objects_.reserve(num_allocs_);
+    for (size_t i = 0; i < num_allocs_; ++i) {
+      size_t size = kMinSize + test_rand(&seed_) % (kMaxSize - kMinSize + 1);
+      size_t bytes_allocated = 0;
+      size_t usable_size = 0;
+      size_t bytes_tl_bulk_allocated = 0;
+      mirror::Object* obj =
+          space_->Alloc(self, size, &bytes_allocated, &usable_size, &bytes_tl_bulk_allocated);
+      ASSERT_TRUE(obj != nullptr);
+      ASSERT_GE(usable_size, size);
+      // The heap checks the footprint limit against this bound before allocating.
+      ASSERT_LE(bytes_tl_bulk_allocated, space_->MaxBytesBulkAllocatedFor(size));
+      objects_.push_back(std::make_pair(reinterpret_cast<uint8_t*>(obj), usable_size));
+      bytes_allocated_ += bytes_allocated;
+      bytes_tl_bulk_allocated_ += bytes_tl_bulk_allocated;
+    }
+    // Give the slots left in the magazines back before the thread goes away. The worker has no
+    // thread-local runs since it doesn't allocate small objects.
+    bytes_revoked_ = space_->RevokeThreadLocalBuffers(self);
+  }
+
+  void Finalize() {}
+
+  const std::vector<std::pair<uint8_t*, size_t>>& GetObjects() const {
+    return objects_;
+  }
+
+  // What the heap would count as allocated after the revoke, and what was actually allocated.
+  size_t GetBytesCounted() const {
+    return bytes_tl_bulk_allocated_ - bytes_revoked_;
+  }
+  size_t GetBytesAllocated() const {
+    return bytes_allocated_;
+  }
+
+ private:
+  RosAllocSpace* const space_;
+  const size_t num_allocs_;
+  size_t seed_;
+  size_t bytes_allocated_;
+  size_t bytes_tl_bulk_allocated_;
+  size_t bytes_revoked_;
+  std::vector<std::pair<uint8_t*, size_t>> objects_;
+};
+
+// Returns the wall time it took kNumThreads threads to allocate kNumAllocsPerThread mid-sized
+// objects each, and checks that the allocations don't overlap.
+static uint64_t AllocateMidSizeObjectsInParallel(bool use_magazines) {
+  static constexpr size_t kNumThreads = 4;
+  static constexpr size_t kNumAllocsPerThread = 16 * KB;
+  static constexpr size_t kCapacity = 64 * MB;
+  Thread* self = Thread::Current();
+  std::unique_ptr<RosAllocSpace> space(RosAllocSpace::Create("test", kCapacity, kCapacity,
+                                                             kCapacity, nullptr, false, false));
+  EXPECT_TRUE(space != nullptr);
+  space->GetRosAlloc()->SetUseMagazines(use_magazines);
+  ThreadPool thread_pool("RosAlloc multithread test thread pool", kNumThreads);
+  std::vector<std::unique_ptr<MidSizeAllocTask>> tasks;
+  for (size_t i = 0; i < kNumThreads; ++i) {
+    tasks.emplace_back(new MidSizeAllocTask(space.get(), kNumAllocsPerThread, i + 1));
+    thread_pool.AddTask(self, tasks.back().get());
+  }
+  const uint64_t start_time = NanoTime();
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, false, false);
+  const uint64_t duration = NanoTime() - start_time;
+  thread_pool.StopWorkers(self);
+  std::vector<std::pair<uint8_t*, size_t>> objects;
+  for (const std::unique_ptr<MidSizeAllocTask>& task : tasks) {
+    EXPECT_EQ(task->GetBytesCounted(), task->GetBytesAllocated());
+    objects.insert(objects.end(), task->GetObjects().begin(), task->GetObjects().end());
+  }
+  EXPECT_EQ(objects.size(), kNumThreads * kNumAllocsPerThread);
+  std::sort(objects.begin(), objects.end());
+  for (size_t i = 1; i < objects.size(); ++i) {
+    EXPECT_LE(objects[i - 1].first + objects[i - 1].second, objects[i].first);
+  }
+  return duration;
+}
+
+// A microbenchmark for the size bracket lock contention: with the magazines the threads only take
+// the size bracket locks to refill their magazines.
+TEST_F(RosAllocSpaceMultiThreadTest, MidSizeAllocations) {
+  const uint64_t shared_runs_time = AllocateMidSizeObjectsInParallel(false);
+  const uint64_t magazines_time = AllocateMidSizeObjectsInParallel(true);
+  LOG(INFO) << "Mid-sized allocations with shared runs: " << PrettyDuration(shared_runs_time)
+            << ", with magazines: " << PrettyDuration(magazines_time);
+}
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <vector>
+
+#include "gc/allocator/rosalloc.h"
+#include "scoped_thread_state_change.h"
+#include "space_test.h"
+
+namespace art {
+namespace gc {
+namespace space {
+
+class RosAllocSpaceRetireRunsTest : public SpaceTest<CommonRuntimeTest> {
+ protected:
+  // Mid-sized, so that the objects come from the shared runs rather than thread-local ones.
+  static constexpr size_t kObjectSize = 1 * KB;
+  static constexpr size_t kNumRuns = 16;
+  static constexpr size_t kCapacity = 16 * MB;
+
+  void SetUp() OVERRIDE {
+    SpaceTest<CommonRuntimeTest>::SetUp();
+    space_.reset(RosAllocSpace::Create("test", kCapacity, kCapacity, kCapacity, nullptr, false,
+                                       false));
+    ASSERT_TRUE(space_ != nullptr);
+    rosalloc_ = space_->GetRosAlloc();
+    // Fill the runs in allocation order.
+    rosalloc_->SetUseMagazines(false);
+  }
+
+  void TearDown() OVERRIDE {
+    space_.reset();
+    SpaceTest<CommonRuntimeTest>::TearDown();
+  }
+
+  static size_t NumOfSlots() {
+    return allocator::RosAlloc::numOfSlots[allocator::RosAlloc::SizeToIndex(kObjectSize)];
+  }
+
+  // Returns the page map index of the run the object was allocated in.
+  size_t GetRunPageMapIndex(mirror::Object* obj) {
+    size_t pm_idx = rosalloc_->RoundDownToPageMapIndex(obj);
+    while (rosalloc_->page_map_[pm_idx] == allocator::RosAlloc::kPageMapRunPart) {
+      --pm_idx;
+    }
+    EXPECT_EQ(rosalloc_->page_map_[pm_idx], allocator::RosAlloc::kPageMapRun);
+    return pm_idx;
+  }
+
+  bool IsInRetiredRun(mirror::Object* obj) {
+    allocator::RosAlloc::Run* run = reinterpret_cast<allocator::RosAlloc::Run*>(
+        rosalloc_->base_ + GetRunPageMapIndex(obj) * kPageSize);
+    const auto& retired_runs = rosalloc_->retired_runs_[run->size_bracket_idx_];
+    return retired_runs.find(run) != retired_runs.end();
+  }
+
+  size_t NumRetiredRuns() {
+    return rosalloc_->retired_runs_[allocator::RosAlloc::SizeToIndex(kObjectSize)].size();
+  }
+
+  mirror::Object* Alloc(Thread* self) SHARED_REQUIRES(Locks::mutator_lock_) {
+    size_t bytes_allocated = 0;
+    size_t usable_size = 0;
+    size_t bytes_tl_bulk_allocated = 0;
+    mirror::Object* obj = space_->Alloc(self, kObjectSize, &bytes_allocated, &usable_size,
+                                        &bytes_tl_bulk_allocated);
+    EXPECT_TRUE(obj != nullptr);
+    return obj;
+  }
+
+  // Fills kNumRuns runs and frees all objects but one in keep_every of them. Returns the objects
+  // left, each filled with a byte pattern derived from its index.
+  std::vector<mirror::Object*> AllocateRuns(Thread* self, size_t keep_every)
+      SHARED_REQUIRES(Locks::mutator_lock_) {
+    std::vector<mirror::Object*> survivors;
+    std::vector<mirror::Object*> garbage;
+    for (size_t i = 0; i < kNumRuns * NumOfSlots(); ++i) {
+      mirror::Object* obj = Alloc(self);
+      if (i % keep_every == 0) {
+        memset(obj, static_cast<int>(survivors.size() & 0xff), kObjectSize);
+        survivors.push_back(obj);
+      } else {
+        garbage.push_back(obj);
+      }
+    }
+    space_->FreeList(self, garbage.size(), garbage.data());
+    return survivors;
+  }
+
+  static bool HasPattern(mirror::Object* obj, size_t index) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(obj);
+    for (size_t i = 0; i < kObjectSize; ++i) {
+      if (bytes[i] != static_cast<uint8_t>(index & 0xff)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::unique_ptr<RosAllocSpace> space_;
+  allocator::RosAlloc* rosalloc_;
+};
+
+TEST_F(RosAllocSpaceRetireRunsTest, RetiresSparseRuns) {
+  static constexpr size_t kMaxRuns = 4;
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  std::vector<mirror::Object*> survivors = AllocateRuns(self, 8);
+  EXPECT_EQ(rosalloc_->RetireSparseRuns(self, kMaxRuns), kMaxRuns);
+  EXPECT_EQ(NumRetiredRuns(), kMaxRuns);
+
+  // The objects stay where they were allocated, retiring a run does not move them.
+  size_t num_retired_survivors = 0;
+  for (size_t i = 0; i < survivors.size(); ++i) {
+    EXPECT_TRUE(HasPattern(survivors[i], i));
+    if (IsInRetiredRun(survivors[i])) {
+      ++num_retired_survivors;
+    }
+  }
+  EXPECT_GT(num_retired_survivors, 0u);
+
+  // The other sparse runs take the new objects.
+  for (size_t i = 0; i < kMaxRuns * NumOfSlots(); ++i) {
+    EXPECT_FALSE(IsInRetiredRun(Alloc(self)));
+  }
+
+  // The next call puts the retired runs back before picking the sparsest runs again.
+  EXPECT_LE(rosalloc_->RetireSparseRuns(self, 1), 1u);
+  EXPECT_LE(NumRetiredRuns(), 1u);
+}
+
+TEST_F(RosAllocSpaceRetireRunsTest, FreesEmptyRetiredRuns) {
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  std::vector<mirror::Object*> survivors = AllocateRuns(self, 8);
+  ASSERT_GT(rosalloc_->RetireSparseRuns(self, kNumRuns), 0u);
+  std::vector<mirror::Object*> retired_survivors;
+  std::vector<size_t> retired_run_pages;
+  for (mirror::Object* obj : survivors) {
+    if (IsInRetiredRun(obj)) {
+      retired_survivors.push_back(obj);
+      retired_run_pages.push_back(GetRunPageMapIndex(obj));
+    }
+  }
+  ASSERT_FALSE(retired_survivors.empty());
+
+  // Once their objects die, the pages of the retired runs are free.
+  space_->FreeList(self, retired_survivors.size(), retired_survivors.data());
+  EXPECT_EQ(NumRetiredRuns(), 0u);
+  for (size_t pm_idx : retired_run_pages) {
+    EXPECT_TRUE(rosalloc_->IsFreePage(pm_idx));
+  }
+}
+
+TEST_F(RosAllocSpaceRetireRunsTest, KeepsDenseRuns) {
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  // Free one object in every eight, so that no run is sparse enough to be retired.
+  std::vector<mirror::Object*> survivors;
+  std::vector<mirror::Object*> garbage;
+  for (size_t i = 0; i < kNumRuns * NumOfSlots(); ++i) {
+    mirror::Object* obj = Alloc(self);
+    if (i % 8 == 0) {
+      garbage.push_back(obj);
+    } else {
+      survivors.push_back(obj);
+    }
+  }
+  space_->FreeList(self, garbage.size(), garbage.data());
+  EXPECT_EQ(rosalloc_->RetireSparseRuns(self, kNumRuns), 0u);
+  EXPECT_EQ(NumRetiredRuns(), 0u);
+}
+
+}  // namespace space
+}  // namespace gc
+}  // namespace art
@@ -23,6 +23,7 @@
 #include "entrypoints/runtime_asm_entrypoints.h"
 #include "interpreter/interpreter.h"
 #include "jit_code_cache.h"
+#include "jit_warm_start_file.h"
 #include "oat_file_manager.h"
 #include "oat_quick_method_header.h"
 #include "offline_profiling_info.h"
@@ -45,7 +46,7 @@ void* Jit::jit_library_handle_= nullptr;
 void* Jit::jit_compiler_handle_ = nullptr;
 void* (*Jit::jit_load_)(bool*) = nullptr;
 void (*Jit::jit_unload_)(void*) = nullptr;
-bool (*Jit::jit_compile_method_)(void*, ArtMethod*, Thread*, bool) = nullptr;
+bool (*Jit::jit_compile_method_)(void*, ArtMethod*, Thread*, bool, bool) = nullptr;
 void (*Jit::jit_types_loaded_)(void*, mirror::Class**, size_t count) = nullptr;
 bool Jit::generate_debug_info_ = false;
 
@@ -76,6 +77,15 @@ JitOptions* JitOptions::CreateFromRuntimeArguments(const RuntimeArgumentMap& opt
     jit_options->warmup_threshold_ = jit_options->compile_threshold_ / 2;
   }
 
+  if (options.Exists(RuntimeArgumentMap::JITBaselineThreshold)) {
+    jit_options->baseline_threshold_ = *options.Get(RuntimeArgumentMap::JITBaselineThreshold);
+    if (jit_options->baseline_threshold_ <= jit_options->warmup_threshold_) {
+      LOG(FATAL) << "Baseline compilation threshold is not above the warmup threshold.";
+    } else if (jit_options->baseline_threshold_ >= jit_options->compile_threshold_) {
+      LOG(FATAL) << "Baseline compilation threshold is not below the compile threshold.";
+    }
+  }
+
   if (options.Exists(RuntimeArgumentMap::JITOsrThreshold)) {
     jit_options->osr_threshold_ = *options.Get(RuntimeArgumentMap::JITOsrThreshold);
     if (jit_options->osr_threshold_ > std::numeric_limits<uint16_t>::max()) {
@@ -116,6 +126,15 @@ JitOptions* JitOptions::CreateFromRuntimeArguments(const RuntimeArgumentMap& opt
         static_cast<size_t>(1));;
   }
 
+  jit_options->thread_count_ = options.GetOrDefault(RuntimeArgumentMap::JITThreadCount);
+  if (jit_options->thread_count_ == 0) {
+    LOG(FATAL) << "JIT thread count cannot be 0.";
+  }
+
+  if (options.Exists(RuntimeArgumentMap::JITWarmStartFile)) {
+    jit_options->warm_start_file_ = *options.Get(RuntimeArgumentMap::JITWarmStartFile);
+  }
+
   return jit_options;
 }
 
@@ -127,8 +146,19 @@ bool Jit::ShouldUsePriorityThreadWeight() {
 void Jit::DumpInfo(std::ostream& os) {
   code_cache_->Dump(os);
   cumulative_timings_.Dump(os);
+  if (warm_start_file_ != nullptr) {
+    os << "JIT warm start methods pending: " << warm_start_file_->GetNumberOfPendingMethods()
+       << "\n";
+  }
   MutexLock mu(Thread::Current(), lock_);
   memory_use_.PrintMemoryUse(os);
+  os << "JIT queue: " << pending_tasks_.size() << " pending (max " << max_pending_tasks_
+     << ") on " << thread_count_ << " threads, " << dequeued_tasks_ << " dequeued, "
+     << deduplicated_tasks_ << " deduplicated\n";
+  if (dequeued_tasks_ != 0) {
+    os << "JIT queue latency: mean " << PrettyDuration(total_queue_latency_ns_ / dequeued_tasks_)
+       << ", max " << PrettyDuration(max_queue_latency_ns_) << "\n";
+  }
 }
 
 void Jit::DumpForSigQuit(std::ostream& os) {
@@ -143,9 +173,16 @@ void Jit::AddTimingLogger(const TimingLogger& logger) {
 Jit::Jit() : dump_info_on_shutdown_(false),
              cumulative_timings_("JIT timings"),
              memory_use_("Memory used for compilation", 16),
-             lock_("JIT memory use lock"),
+             lock_("JIT lock"),
              use_jit_compilation_(true),
-             save_profiling_info_(false) {}
+             save_profiling_info_(false),
+             thread_count_(kDefaultThreadCount),
+             last_warm_start_save_ns_(0),
+             max_pending_tasks_(0),
+             deduplicated_tasks_(0),
+             dequeued_tasks_(0),
+             total_queue_latency_ns_(0),
+             max_queue_latency_ns_(0) {}
 
 Jit* Jit::Create(JitOptions* options, std::string* error_msg) {
   DCHECK(options->UseJitCompilation() || options->GetSaveProfilingInfo());
@@ -168,14 +205,34 @@ Jit* Jit::Create(JitOptions* options, std::string* error_msg) {
       << PrettySize(options->GetCodeCacheInitialCapacity())
       << ", max_capacity=" << PrettySize(options->GetCodeCacheMaxCapacity())
       << ", compile_threshold=" << options->GetCompileThreshold()
+      << ", baseline_threshold=" << options->GetBaselineThreshold()
       << ", save_profiling_info=" << options->GetSaveProfilingInfo();
 
 
   jit->hot_method_threshold_ = options->GetCompileThreshold();
   jit->warm_method_threshold_ = options->GetWarmupThreshold();
+  jit->baseline_method_threshold_ = options->GetBaselineThreshold();
   jit->osr_method_threshold_ = options->GetOsrThreshold();
   jit->priority_thread_weight_ = options->GetPriorityThreadWeight();
   jit->invoke_transition_weight_ = options->GetInvokeTransitionWeight();
+  jit->thread_count_ = options->GetThreadCount();
+
+  if (jit->use_jit_compilation_ && !options->GetWarmStartFile().empty()) {
+    jit->warm_start_filename_ = options->GetWarmStartFile();
+    jit->warm_start_file_.reset(
+        new JitWarmStartFile(JitWarmStartFile::GetBootImageChecksum()));
+    std::string warm_start_error;
+    if (jit->warm_start_file_->Load(jit->warm_start_filename_, &warm_start_error)) {
+      VLOG(jit) << "Loaded " << jit->warm_start_file_->GetNumberOfPendingMethods()
+                << " methods from " << jit->warm_start_filename_;
+    } else {
+      // A missing or stale file is expected on the first start and after updates, the file
+      // gets rewritten with the methods compiled in this run.
+      VLOG(jit) << "Ignoring JIT warm start file " << jit->warm_start_filename_ << ": "
+                << warm_start_error;
+    }
+    jit->last_warm_start_save_ns_.StoreRelaxed(NanoTime());
+  }
 
   jit->CreateThreadPool();
 
@@ -206,7 +263,7 @@ bool Jit::LoadCompilerLibrary(std::string* error_msg) {
     *error_msg = "JIT couldn't find jit_unload entry point";
     return false;
   }
-  jit_compile_method_ = reinterpret_cast<bool (*)(void*, ArtMethod*, Thread*, bool)>(
+  jit_compile_method_ = reinterpret_cast<bool (*)(void*, ArtMethod*, Thread*, bool, bool)>(
       dlsym(jit_library_handle_, "jit_compile_method"));
   if (jit_compile_method_ == nullptr) {
     dlclose(jit_library_handle_);
@@ -240,13 +297,78 @@ bool Jit::LoadCompiler(std::string* error_msg) {
   return true;
 }
 
-bool Jit::CompileMethod(ArtMethod* method, Thread* self, bool osr) {
+JitCompileTask::JitCompileTask(ArtMethod* method, TaskKind kind)
+    : method_(method), kind_(kind), creation_time_ns_(NanoTime()) {
+  ScopedObjectAccess soa(Thread::Current());
+  // Add a global ref to the class to prevent class unloading until compilation is done.
+  klass_ = soa.Vm()->AddGlobalRef(soa.Self(), method_->GetDeclaringClass());
+  CHECK(klass_ != nullptr);
+}
+
+JitCompileTask::~JitCompileTask() {
+  ScopedObjectAccess soa(Thread::Current());
+  soa.Vm()->DeleteGlobalRef(soa.Self(), klass_);
+}
+
+void JitCompileTask::Run(Thread* self) {
+  ScopedObjectAccess soa(self);
+  if (kind_ == kCompileBaseline) {
+    Runtime::Current()->GetJit()->CompileMethod(method_, self, /* baseline */ true,
+                                                /* osr */ false);
+  } else if (kind_ == kCompile) {
+    Runtime::Current()->GetJit()->CompileMethod(method_, self, /* baseline */ false,
+                                                /* osr */ false);
+  } else if (kind_ == kCompileOsr) {
+    Runtime::Current()->GetJit()->CompileMethod(method_, self, /* baseline */ false,
+                                                /* osr */ true);
+  } else {
+    DCHECK(kind_ == kAllocateProfile);
+    if (ProfilingInfo::Create(self, method_, /* retry_allocation */ true)) {
+      VLOG(jit) << "Start profiling " << PrettyMethod(method_);
+    }
+  }
+  ProfileSaver::NotifyJitActivity();
+}
+
+// OSR requests go first since the method is stuck in a loop in the interpreter, then the
+// hottest methods. The hotness counter is read when the task is about to run, the counters of
+// the methods keep increasing while their tasks are pending.
+bool JitCompileTask::HasLowerPriorityThan(const JitCompileTask& other) const {
+  if ((kind_ == kCompileOsr) != (other.kind_ == kCompileOsr)) {
+    return other.kind_ == kCompileOsr;
+  }
+  return method_->GetCounter() < other.method_->GetCounter();
+}
+
+// The task given to the thread pool for every pending compilation task. It runs the pending
+// compilation task with the highest priority rather than a specific one.
+class JitRunNextCompileTask FINAL : public Task {
+ public:
+  void Run(Thread* self) OVERRIDE {
+    JitCompileTask* task = Runtime::Current()->GetJit()->PopCompileTask(self);
+    // The pending tasks are dropped at shutdown.
+    if (task != nullptr) {
+      task->Run(self);
+      task->Finalize();
+    }
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+};
+
+bool Jit::CompileMethod(ArtMethod* method, Thread* self, bool baseline, bool osr) {
   DCHECK(Runtime::Current()->UseJitCompilation());
   DCHECK(!method->IsRuntimeMethod());
+  DCHECK(!baseline || !osr);
 
   // Don't compile the method if it has breakpoints.
   if (Dbg::IsDebuggerActive() && Dbg::MethodHasAnyBreakpoints(method)) {
     VLOG(jit) << "JIT not compiling " << PrettyMethod(method) << " due to breakpoint";
+    if (osr) {
+      code_cache_->DropOsrRequests(method, self);
+    }
     return false;
   }
 
@@ -254,41 +376,82 @@ bool Jit::CompileMethod(ArtMethod* method, Thread* self, bool osr) {
   instrumentation::Instrumentation* instrumentation = Runtime::Current()->GetInstrumentation();
   if (instrumentation->AreAllMethodsDeoptimized() || instrumentation->IsDeoptimized(method)) {
     VLOG(jit) << "JIT not compiling " << PrettyMethod(method) << " due to deoptimization";
+    if (osr) {
+      code_cache_->DropOsrRequests(method, self);
+    }
     return false;
   }
 
   // If we get a request to compile a proxy method, we pass the actual Java method
   // of that proxy method, as the compiler does not expect a proxy method.
   ArtMethod* method_to_compile = method->GetInterfaceMethodIfProxy(sizeof(void*));
-  if (!code_cache_->NotifyCompilationOf(method_to_compile, self, osr)) {
+  if (baseline && method_to_compile->GetCounter() >= hot_method_threshold_) {
+    // The method got hot while the baseline compilation was pending, the optimizing compilation
+    // requested when it crossed the compile threshold supersedes it.
+    VLOG(jit) << "JIT not baseline compiling hot method " << PrettyMethod(method_to_compile);
+    return false;
+  }
+  if (!code_cache_->NotifyCompilationOf(method_to_compile, self, baseline, osr)) {
     return false;
   }
 
   VLOG(jit) << "Compiling method "
             << PrettyMethod(method_to_compile)
+            << " baseline=" << std::boolalpha << baseline
             << " osr=" << std::boolalpha << osr;
-  bool success = jit_compile_method_(jit_compiler_handle_, method_to_compile, self, osr);
+  bool success =
+      jit_compile_method_(jit_compiler_handle_, method_to_compile, self, baseline, osr);
   code_cache_->DoneCompiling(method_to_compile, self, osr);
   if (!success) {
     VLOG(jit) << "Failed to compile method "
               << PrettyMethod(method_to_compile)
+              << " baseline=" << std::boolalpha << baseline
               << " osr=" << std::boolalpha << osr;
+  } else if (baseline && method_to_compile->GetCounter() >= hot_method_threshold_) {
+    // The optimizing compilation requested while the baseline compilation was in progress
+    // was turned down, request it again now that the baseline code is in place.
+    AddCompileTask(self, new JitCompileTask(method_to_compile, JitCompileTask::kCompile));
+  } else if (!baseline && !osr) {
+    MaybeSaveWarmStartFile(self);
   }
   return success;
 }
 
+void Jit::MaybeSaveWarmStartFile(Thread* self) {
+  if (warm_start_file_ == nullptr) {
+    return;
+  }
+  uint64_t last_save = last_warm_start_save_ns_.LoadRelaxed();
+  uint64_t now = NanoTime();
+  if (now - last_save < kWarmStartFileSavePeriodNs ||
+      !last_warm_start_save_ns_.CompareExchangeStrongSequentiallyConsistent(last_save, now)) {
+    // Too early, or another compiler thread is saving it.
+    return;
+  }
+  std::vector<MethodReference> methods;
+  code_cache_->GetCompiledMethods(self, methods);
+  // Write the file in native state, so that the I/O does not hold up suspend-all requests.
+  ScopedThreadSuspension sts(self, kNative);
+  std::string error_msg;
+  if (warm_start_file_->Save(warm_start_filename_, methods, &error_msg)) {
+    VLOG(jit) << "Saved " << methods.size() << " compiled methods to " << warm_start_filename_;
+  } else {
+    LOG(WARNING) << "Could not save JIT warm start file: " << error_msg;
+  }
+}
+
 void Jit::CreateThreadPool() {
   // There is a DCHECK in the 'AddSamples' method to ensure the tread pool
   // is not null when we instrument.
-  thread_pool_.reset(new ThreadPool("Jit thread pool", 1));
+  thread_pool_.reset(new ThreadPool("Jit thread pool", thread_count_));
   thread_pool_->SetPthreadPriority(kJitPoolThreadPthreadPriority);
   thread_pool_->StartWorkers(Thread::Current());
 }
 
 void Jit::DeleteThreadPool() {
   Thread* self = Thread::Current();
-  DCHECK(Runtime::Current()->IsShuttingDown(self));
   if (thread_pool_ != nullptr) {
+    DCHECK(Runtime::Current()->IsShuttingDown(self));
     ThreadPool* cache = nullptr;
     {
       ScopedSuspendAll ssa(__FUNCTION__);
@@ -303,6 +466,11 @@ void Jit::DeleteThreadPool() {
     // here. Besides, this is only done for shutdown.
     cache->Wait(self, false, false);
     delete cache;
+    // Drop the compilation tasks which have not been picked up by a worker.
+    JitCompileTask* task;
+    while ((task = PopCompileTask(self)) != nullptr) {
+      task->Finalize();
+    }
   }
 }
 
@@ -540,54 +708,52 @@ void Jit::AddMemoryUsage(ArtMethod* method, size_t bytes) {
   memory_use_.AddValue(bytes);
 }
 
-class JitCompileTask FINAL : public Task {
- public:
-  enum TaskKind {
-    kAllocateProfile,
-    kCompile,
-    kCompileOsr
-  };
-
-  JitCompileTask(ArtMethod* method, TaskKind kind) : method_(method), kind_(kind) {
-    ScopedObjectAccess soa(Thread::Current());
-    // Add a global ref to the class to prevent class unloading until compilation is done.
-    klass_ = soa.Vm()->AddGlobalRef(soa.Self(), method_->GetDeclaringClass());
-    CHECK(klass_ != nullptr);
-  }
-
-  ~JitCompileTask() {
-    ScopedObjectAccess soa(Thread::Current());
-    soa.Vm()->DeleteGlobalRef(soa.Self(), klass_);
-  }
-
-  void Run(Thread* self) OVERRIDE {
-    ScopedObjectAccess soa(self);
-    if (kind_ == kCompile) {
-      Runtime::Current()->GetJit()->CompileMethod(method_, self, /* osr */ false);
-    } else if (kind_ == kCompileOsr) {
-      Runtime::Current()->GetJit()->CompileMethod(method_, self, /* osr */ true);
+void Jit::AddCompileTask(Thread* self, JitCompileTask* task) {
+  {
+    MutexLock mu(self, lock_);
+    auto it = std::find_if(pending_tasks_.begin(),
+                           pending_tasks_.end(),
+                           [task](JitCompileTask* pending) {
+                             return pending->IsSameRequest(*task);
+                           });
+    if (it == pending_tasks_.end()) {
+      pending_tasks_.push_back(task);
+      max_pending_tasks_ = std::max(max_pending_tasks_, pending_tasks_.size());
+      task = nullptr;
     } else {
-      DCHECK(kind_ == kAllocateProfile);
-      if (ProfilingInfo::Create(self, method_, /* retry_allocation */ true)) {
-        VLOG(jit) << "Start profiling " << PrettyMethod(method_);
-      }
+      ++deduplicated_tasks_;
     }
-    ProfileSaver::NotifyJitActivity();
   }
-
-  void Finalize() OVERRIDE {
-    delete this;
+  if (task != nullptr) {
+    // Delete outside of the lock, the destructor needs the mutator lock.
+    task->Finalize();
+    return;
   }
+  thread_pool_->AddTask(self, new JitRunNextCompileTask());
+}
 
- private:
-  ArtMethod* const method_;
-  const TaskKind kind_;
-  jobject klass_;
-
-  DISALLOW_IMPLICIT_CONSTRUCTORS(JitCompileTask);
-};
+JitCompileTask* Jit::PopCompileTask(Thread* self) {
+  MutexLock mu(self, lock_);
+  if (pending_tasks_.empty()) {
+    return nullptr;
+  }
+  // The queue is short and the priorities change while the tasks are pending, so just scan it.
+  // max_element returns the first of equal elements, which keeps the order of equal tasks FIFO.
+  auto it = std::max_element(pending_tasks_.begin(),
+                              pending_tasks_.end(),
+                              [](JitCompileTask* a, JitCompileTask* b) {
+                                return a->HasLowerPriorityThan(*b);
+                              });
+  JitCompileTask* task = *it;
+  pending_tasks_.erase(it);
+  const uint64_t latency = NanoTime() - task->GetCreationTime();
+  ++dequeued_tasks_;
+  total_queue_latency_ns_ += latency;
+  max_queue_latency_ns_ = std::max(max_queue_latency_ns_, latency);
+  return task;
+}
 
-void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count, bool with_backedges) {
+void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count) {
   if (thread_pool_ == nullptr) {
     // Should only see this when shutting down.
     DCHECK(Runtime::Current()->IsShuttingDown(self));
@@ -601,11 +767,35 @@ void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count, bool with_
   DCHECK(thread_pool_ != nullptr);
   DCHECK_GT(warm_method_threshold_, 0);
   DCHECK_GT(hot_method_threshold_, warm_method_threshold_);
+  DCHECK(!UseBaselineCompilation() || (baseline_method_threshold_ > warm_method_threshold_));
+  DCHECK(!UseBaselineCompilation() || (baseline_method_threshold_ < hot_method_threshold_));
   DCHECK_GT(osr_method_threshold_, hot_method_threshold_);
   DCHECK_GE(priority_thread_weight_, 1);
   DCHECK_LE(priority_thread_weight_, hot_method_threshold_);
 
   int32_t starting_count = method->GetCounter();
+  if (UNLIKELY(starting_count == 0 &&
+               use_jit_compilation_ &&
+               warm_start_file_ != nullptr &&
+               !warm_start_file_->IsEmpty() &&
+               warm_start_file_->TakeMethod(*method->GetDexFile(), method->GetDexMethodIndex()))) {
+    // The method was compiled in the previous run, compile it now rather than waiting for it to
+    // get hot again. The compiler requires a ProfilingInfo object.
+    if (method->GetProfilingInfo(sizeof(void*)) == nullptr) {
+      ProfilingInfo::Create(self, method, /* retry_allocation */ false);
+      if (thread_pool_ == nullptr) {
+        // Calling ProfilingInfo::Create might put us in a suspended state, which could
+        // lead to the thread pool being deleted when we are shutting down.
+        DCHECK(Runtime::Current()->IsShuttingDown(self));
+        return;
+      }
+    }
+    if (method->GetProfilingInfo(sizeof(void*)) != nullptr) {
+      AddCompileTask(self, new JitCompileTask(method, JitCompileTask::kCompile));
+      method->SetCounter(hot_method_threshold_);
+      return;
+    }
+  }
   if (Jit::ShouldUsePriorityThreadWeight()) {
     count *= priority_thread_weight_;
   }
@@ -628,35 +818,63 @@ void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count, bool with_
       if (!success) {
         // We failed allocating. Instead of doing the collection on the Java thread, we push
         // an allocation to a compiler thread, that will do the collection.
-        thread_pool_->AddTask(self, new JitCompileTask(method, JitCompileTask::kAllocateProfile));
+        AddCompileTask(self, new JitCompileTask(method, JitCompileTask::kAllocateProfile));
       }
     }
     // Avoid jumping more than one state at a time.
-    new_count = std::min(new_count, hot_method_threshold_ - 1);
+    new_count = std::min(new_count,
+                         (UseBaselineCompilation() ? baseline_method_threshold_
+                                                   : hot_method_threshold_) - 1);
   } else if (use_jit_compilation_) {
     if (starting_count < hot_method_threshold_) {
-      if ((new_count >= hot_method_threshold_) &&
-          !code_cache_->ContainsPc(method->GetEntryPointFromQuickCompiledCode())) {
+      const bool is_compiled =
+          code_cache_->ContainsPc(method->GetEntryPointFromQuickCompiledCode());
+      if (new_count >= hot_method_threshold_) {
+        // Baseline code gets replaced by optimized code once hot.
+        if (!is_compiled || code_cache_->IsBaselineCompiled(method)) {
+          DCHECK(thread_pool_ != nullptr);
+          AddCompileTask(self, new JitCompileTask(method, JitCompileTask::kCompile));
+        }
+      } else if (UseBaselineCompilation() &&
+                 (starting_count < baseline_method_threshold_) &&
+                 (new_count >= baseline_method_threshold_) &&
+                 !is_compiled) {
         DCHECK(thread_pool_ != nullptr);
-        thread_pool_->AddTask(self, new JitCompileTask(method, JitCompileTask::kCompile));
+        AddCompileTask(self, new JitCompileTask(method, JitCompileTask::kCompileBaseline));
       }
       // Avoid jumping more than one state at a time.
-      new_count = std::min(new_count, osr_method_threshold_ - 1);
-    } else if (starting_count < osr_method_threshold_) {
-      if (!with_backedges) {
-        // If the samples don't contain any back edge, we don't increment the hotness.
-        return;
-      }
-      if ((new_count >= osr_method_threshold_) &&  !code_cache_->IsOsrCompiled(method)) {
-        DCHECK(thread_pool_ != nullptr);
-        thread_pool_->AddTask(self, new JitCompileTask(method, JitCompileTask::kCompileOsr));
-      }
+      new_count = std::min(new_count, static_cast<int32_t>(hot_method_threshold_));
+    } else {
+      // The method is hot, its back edges are now counted per loop by AddLoopSamples.
+      return;
     }
   }
   // Update hotness counter
   method->SetCounter(new_count);
 }
 
+void Jit::AddLoopSamples(Thread* self,
+                         ArtMethod* method,
+                         uint32_t loop_header_dex_pc,
+                         uint16_t count) {
+  AddSamples(self, method, count);
+  if (!kEnableOnStackReplacement ||
+      !use_jit_compilation_ ||
+      thread_pool_ == nullptr ||
+      method->GetCounter() < hot_method_threshold_ ||
+      method->IsClassInitializer() ||
+      !method->IsCompilable()) {
+    return;
+  }
+  ProfilingInfo* info = method->GetProfilingInfo(sizeof(void*));
+  if ((info != nullptr) &&
+      info->AddLoopBackEdges(loop_header_dex_pc, count, OSRLoopThreshold())) {
+    // Compiles the method again for OSR if its OSR code cannot be entered at this loop.
+    VLOG(jit) << "Hot loop at " << PrettyMethod(method) << "@" << loop_header_dex_pc;
+    AddCompileTask(self, new JitCompileTask(method, JitCompileTask::kCompileOsr));
+  }
+}
+
 void Jit::MethodEntered(Thread* thread, ArtMethod* method) {
   Runtime* runtime = Runtime::Current();
   if (UNLIKELY(runtime->UseJitCompilation() && runtime->GetJit()->JitAtFirstUse())) {
@@ -674,7 +892,7 @@ void Jit::MethodEntered(Thread* thread, ArtMethod* method) {
     Runtime::Current()->GetInstrumentation()->UpdateMethodsCode(
         method, profiling_info->GetSavedEntryPoint());
   } else {
-    AddSamples(thread, method, 1, /* with_backedges */false);
+    AddSamples(thread, method, 1);
   }
 }
 
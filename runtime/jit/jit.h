@@ -34,7 +34,10 @@ struct RuntimeArgumentMap;
 namespace jit {
 
 class JitCodeCache;
+class JitCompileQueueTest;
+class JitCompileTask;
 class JitOptions;
+class JitWarmStartFile;
 
 static constexpr int16_t kJitCheckForOSR = -1;
 static constexpr int16_t kJitHotnessDisabled = -2;
@@ -45,10 +48,16 @@ class Jit {
   static constexpr size_t kDefaultCompileThreshold = kStressMode ? 2 : 10000;
   static constexpr size_t kDefaultPriorityThreadWeightRatio = 1000;
   static constexpr size_t kDefaultInvokeTransitionWeightRatio = 500;
+  static constexpr size_t kDefaultThreadCount = 1;
+  // How often the compiler threads write the warm start file.
+  static constexpr uint64_t kWarmStartFileSavePeriodNs = 30 * UINT64_C(1000000000);
 
   virtual ~Jit();
   static Jit* Create(JitOptions* options, std::string* error_msg);
-  bool CompileMethod(ArtMethod* method, Thread* self, bool osr)
+  // Compiles the method with the full optimizing pipeline, or with the baseline tier if
+  // `baseline` is set. Baseline code keeps the hotness counter and the inline caches of the
+  // method's ProfilingInfo updated so that it gets recompiled with the full pipeline once hot.
+  bool CompileMethod(ArtMethod* method, Thread* self, bool baseline, bool osr)
       SHARED_REQUIRES(Locks::mutator_lock_);
   void CreateThreadPool();
 
@@ -75,6 +84,15 @@ class Jit {
     return osr_method_threshold_;
   }
 
+  // Number of back edges of a loop, once its method is hot, after which the method
+  // gets compiled for OSR with an entry at the loop header. With a threshold of 0,
+  // the first back edge of each loop requests the OSR compilation.
+  uint16_t OSRLoopThreshold() const {
+    return (osr_method_threshold_ > hot_method_threshold_)
+        ? osr_method_threshold_ - hot_method_threshold_
+        : 0u;
+  }
+
   size_t HotMethodThreshold() const {
     return hot_method_threshold_;
   }
@@ -83,6 +101,15 @@ class Jit {
     return warm_method_threshold_;
   }
 
+  // Returns 0 if the baseline tier is disabled.
+  size_t BaselineMethodThreshold() const {
+    return baseline_method_threshold_;
+  }
+
+  bool UseBaselineCompilation() const {
+    return baseline_method_threshold_ != 0;
+  }
+
   uint16_t PriorityThreadWeight() const {
     return priority_thread_weight_;
   }
@@ -99,11 +126,24 @@ class Jit {
   // Wait until there is no more pending compilation tasks.
   void WaitForCompilationToFinish(Thread* self);
 
+  // Takes the pending compilation task that should run next off the queue, or returns null if
+  // there is none. The caller owns the returned task.
+  JitCompileTask* PopCompileTask(Thread* self) REQUIRES(!lock_);
+
   // Profiling methods.
   void MethodEntered(Thread* thread, ArtMethod* method)
       SHARED_REQUIRES(Locks::mutator_lock_);
 
-  void AddSamples(Thread* self, ArtMethod* method, uint16_t samples, bool with_backedges)
+  void AddSamples(Thread* self, ArtMethod* method, uint16_t samples)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
+  // Adds samples for back edges to the loop header at `loop_header_dex_pc`. Once the
+  // method is hot, they are also counted for the loop, and the method gets compiled
+  // for OSR into the loops that reach the OSR loop threshold.
+  void AddLoopSamples(Thread* self,
+                      ArtMethod* method,
+                      uint32_t loop_header_dex_pc,
+                      uint16_t samples)
       SHARED_REQUIRES(Locks::mutator_lock_);
 
   void InvokeVirtualOrInterface(Thread* thread,
@@ -115,12 +155,12 @@ class Jit {
 
   void NotifyInterpreterToCompiledCodeTransition(Thread* self, ArtMethod* caller)
       SHARED_REQUIRES(Locks::mutator_lock_) {
-    AddSamples(self, caller, invoke_transition_weight_, false);
+    AddSamples(self, caller, invoke_transition_weight_);
   }
 
   void NotifyCompiledCodeToInterpreterTransition(Thread* self, ArtMethod* callee)
       SHARED_REQUIRES(Locks::mutator_lock_) {
-    AddSamples(self, callee, invoke_transition_weight_, false);
+    AddSamples(self, callee, invoke_transition_weight_);
   }
 
   // Starts the profile saver if the config options allow profile recording.
@@ -172,12 +212,21 @@ class Jit {
 
   static bool LoadCompiler(std::string* error_msg);
 
+  // Writes the methods compiled so far to the warm start file, at most once per
+  // kWarmStartFileSavePeriodNs. Called by the compiler threads after a compilation, the file is
+  // written in native state.
+  void MaybeSaveWarmStartFile(Thread* self) SHARED_REQUIRES(Locks::mutator_lock_);
+
+  // Queues the task for the thread pool, unless a task of the same kind is already pending for
+  // the same method. Takes ownership of the task.
+  void AddCompileTask(Thread* self, JitCompileTask* task) REQUIRES(!lock_);
+
   // JIT compiler
   static void* jit_library_handle_;
   static void* jit_compiler_handle_;
   static void* (*jit_load_)(bool*);
   static void (*jit_unload_)(void*);
-  static bool (*jit_compile_method_)(void*, ArtMethod*, Thread*, bool);
+  static bool (*jit_compile_method_)(void*, ArtMethod*, Thread*, bool, bool);
   static void (*jit_types_loaded_)(void*, mirror::Class**, size_t count);
 
   // Performance monitoring.
@@ -193,14 +242,84 @@ class Jit {
   static bool generate_debug_info_;
   uint16_t hot_method_threshold_;
   uint16_t warm_method_threshold_;
+  uint16_t baseline_method_threshold_;
   uint16_t osr_method_threshold_;
   uint16_t priority_thread_weight_;
   uint16_t invoke_transition_weight_;
+  size_t thread_count_;
   std::unique_ptr<ThreadPool> thread_pool_;
 
+  // The methods compiled in the previous run of the process, compiled again at their first
+  // invocation in this run. Null unless -Xjitwarmstartfile is passed.
+  std::string warm_start_filename_;
+  std::unique_ptr<JitWarmStartFile> warm_start_file_;
+  Atomic<uint64_t> last_warm_start_save_ns_;
+
+  // The compilation tasks waiting for a worker, in the order they were added. The thread pool
+  // holds one task per pending compilation task which runs the one with the highest priority when
+  // it gets a worker, so that the priorities reflect the hotness at the time of the compilation
+  // rather than when the task was added.
+  std::vector<JitCompileTask*> pending_tasks_ GUARDED_BY(lock_);
+  // Queue statistics.
+  size_t max_pending_tasks_ GUARDED_BY(lock_);
+  uint64_t deduplicated_tasks_ GUARDED_BY(lock_);
+  uint64_t dequeued_tasks_ GUARDED_BY(lock_);
+  uint64_t total_queue_latency_ns_ GUARDED_BY(lock_);
+  uint64_t max_queue_latency_ns_ GUARDED_BY(lock_);
+
+  friend class JitCompileQueueTest;
+
   DISALLOW_COPY_AND_ASSIGN(Jit);
 };
 
+// A request to compile a method, or to allocate its ProfilingInfo, waiting in the queue of the
+// Jit for a worker of the thread pool.
+class JitCompileTask FINAL : public Task {
+ public:
+  enum TaskKind {
+    kAllocateProfile,
+    kCompileBaseline,
+    kCompile,
+    kCompileOsr
+  };
+
+  JitCompileTask(ArtMethod* method, TaskKind kind);
+  ~JitCompileTask();
+
+  void Run(Thread* self) OVERRIDE;
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+  ArtMethod* GetMethod() const {
+    return method_;
+  }
+
+  TaskKind GetKind() const {
+    return kind_;
+  }
+
+  bool IsSameRequest(const JitCompileTask& other) const {
+    return method_ == other.method_ && kind_ == other.kind_;
+  }
+
+  bool HasLowerPriorityThan(const JitCompileTask& other) const
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
+  uint64_t GetCreationTime() const {
+    return creation_time_ns_;
+  }
+
+ private:
+  ArtMethod* const method_;
+  const TaskKind kind_;
+  const uint64_t creation_time_ns_;
+  jobject klass_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(JitCompileTask);
+};
+
 class JitOptions {
  public:
   static JitOptions* CreateFromRuntimeArguments(const RuntimeArgumentMap& options);
@@ -210,6 +329,9 @@ class JitOptions {
   size_t GetWarmupThreshold() const {
     return warmup_threshold_;
   }
+  size_t GetBaselineThreshold() const {
+    return baseline_threshold_;
+  }
   size_t GetOsrThreshold() const {
     return osr_threshold_;
   }
@@ -219,6 +341,9 @@ class JitOptions {
   size_t GetInvokeTransitionWeight() const {
     return invoke_transition_weight_;
   }
+  size_t GetThreadCount() const {
+    return thread_count_;
+  }
   size_t GetCodeCacheInitialCapacity() const {
     return code_cache_initial_capacity_;
   }
@@ -231,6 +356,9 @@ class JitOptions {
   bool GetSaveProfilingInfo() const {
     return save_profiling_info_;
   }
+  const std::string& GetWarmStartFile() const {
+    return warm_start_file_;
+  }
   bool UseJitCompilation() const {
     return use_jit_compilation_;
   }
@@ -243,6 +371,7 @@ class JitOptions {
   void SetJitAtFirstUse() {
     use_jit_compilation_ = true;
     compile_threshold_ = 0;
+    baseline_threshold_ = 0;
   }
 
  private:
@@ -251,17 +380,22 @@ class JitOptions {
   size_t code_cache_max_capacity_;
   size_t compile_threshold_;
   size_t warmup_threshold_;
+  size_t baseline_threshold_;
   size_t osr_threshold_;
   uint16_t priority_thread_weight_;
   size_t invoke_transition_weight_;
+  size_t thread_count_;
   bool dump_info_on_shutdown_;
   bool save_profiling_info_;
+  std::string warm_start_file_;
 
   JitOptions()
       : use_jit_compilation_(false),
         code_cache_initial_capacity_(0),
         code_cache_max_capacity_(0),
         compile_threshold_(0),
+        baseline_threshold_(0),
+        thread_count_(Jit::kDefaultThreadCount),
         dump_info_on_shutdown_(false),
         save_profiling_info_(false) { }
 
@@ -16,6 +16,7 @@
 
 #include "jit_code_cache.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include "art_method-inl.h"
@@ -25,6 +26,7 @@
 #include "debugger_interface.h"
 #include "entrypoints/runtime_asm_entrypoints.h"
 #include "gc/accounting/bitmap-inl.h"
+#include "gc/allocator/dlmalloc.h"
 #include "gc/scoped_gc_critical_section.h"
 #include "jit/jit.h"
 #include "jit/profiling_info.h"
@@ -44,6 +46,16 @@ static constexpr int kProtCode = PROT_READ | PROT_EXEC;
 static constexpr size_t kCodeSizeLogThreshold = 50 * KB;
 static constexpr size_t kStackMapSizeLogThreshold = 50 * KB;
 
+// Compiled code used across that many full collections is considered old. Polling
+// the liveness of old code sends its method through the interpreter until it is
+// invoked again, so we only poll it every kOldGenerationPollingPeriod full collections,
+// or when the code cache cannot grow anymore.
+static constexpr uint16_t kOldGenerationAge = 3;
+static constexpr size_t kOldGenerationPollingPeriod = 4;
+
+// The code cache is fragmented when that percentage of its committed region is free.
+static constexpr size_t kFragmentedFreePercentage = 25;
+
 #define CHECKED_MPROTECT(memory, size, prot)                \
   do {                                                      \
     int rc = mprotect(memory, size, prot);                  \
@@ -137,8 +149,15 @@ JitCodeCache::JitCodeCache(MemMap* code_map,
       used_memory_for_code_(0),
       number_of_compilations_(0),
       number_of_osr_compilations_(0),
+      number_of_baseline_compilations_(0),
       number_of_deoptimizations_(0),
+      number_of_cha_invalidations_(0),
       number_of_collections_(0),
+      number_of_full_collections_(0),
+      number_of_evictions_(0),
+      number_of_recompilations_after_eviction_(0),
+      recompiled_code_size_(0),
+      released_free_pages_size_(0),
       histogram_stack_map_memory_use_("Memory used for stack maps", 16),
       histogram_code_memory_use_("Memory used for compiled code", 16),
       histogram_profiling_info_memory_use_("Memory used for profiling info", 16) {
@@ -202,7 +221,9 @@ uint8_t* JitCodeCache::CommitCode(Thread* self,
                                   size_t fp_spill_mask,
                                   const uint8_t* code,
                                   size_t code_size,
-                                  bool osr) {
+                                  bool baseline,
+                                  bool osr,
+                                  const ArenaSet<ArtMethod*>& cha_single_implementations) {
   uint8_t* result = CommitCodeInternal(self,
                                        method,
                                        vmap_table,
@@ -211,7 +232,9 @@ uint8_t* JitCodeCache::CommitCode(Thread* self,
                                        fp_spill_mask,
                                        code,
                                        code_size,
-                                       osr);
+                                       baseline,
+                                       osr,
+                                       cha_single_implementations);
   if (result == nullptr) {
     // Retry.
     GarbageCollectCache(self);
@@ -223,7 +246,9 @@ uint8_t* JitCodeCache::CommitCode(Thread* self,
                                 fp_spill_mask,
                                 code,
                                 code_size,
-                                osr);
+                                baseline,
+                                osr,
+                                cha_single_implementations);
   }
   return result;
 }
@@ -256,6 +281,24 @@ void JitCodeCache::FreeCode(const void* code_ptr, ArtMethod* method ATTRIBUTE_UN
     const uint8_t* data = method_header->code_ - method_header->vmap_table_offset_;
     FreeData(const_cast<uint8_t*>(data));
   }
+  baseline_code_.erase(code_ptr);
+  auto code_it = cha_code_dependencies_.find(code_ptr);
+  if (code_it != cha_code_dependencies_.end()) {
+    for (ArtMethod* single_implementation : code_it->second) {
+      auto it = cha_dependencies_.find(single_implementation);
+      if (it == cha_dependencies_.end()) {
+        // Already invalidated, or the method got unloaded.
+        continue;
+      }
+      std::vector<const void*>& dependents = it->second;
+      dependents.erase(std::remove(dependents.begin(), dependents.end(), code_ptr),
+                       dependents.end());
+      if (dependents.empty()) {
+        cha_dependencies_.erase(it);
+      }
+    }
+    cha_code_dependencies_.erase(code_it);
+  }
   FreeCode(reinterpret_cast<uint8_t*>(allocation));
 }
 
@@ -284,6 +327,20 @@ void JitCodeCache::RemoveMethodsIn(Thread* self, const LinearAlloc& alloc) {
       ++it;
     }
   }
+  for (auto it = evicted_methods_.begin(); it != evicted_methods_.end();) {
+    if (alloc.ContainsUnsafe(*it)) {
+      it = evicted_methods_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (auto it = cha_dependencies_.begin(); it != cha_dependencies_.end();) {
+    if (alloc.ContainsUnsafe(it->first)) {
+      it = cha_dependencies_.erase(it);
+    } else {
+      ++it;
+    }
+  }
   for (auto it = profiling_infos_.begin(); it != profiling_infos_.end();) {
     ProfilingInfo* info = *it;
     if (alloc.ContainsUnsafe(info->GetMethod())) {
@@ -313,7 +370,9 @@ uint8_t* JitCodeCache::CommitCodeInternal(Thread* self,
                                           size_t fp_spill_mask,
                                           const uint8_t* code,
                                           size_t code_size,
-                                          bool osr) {
+                                          bool baseline,
+                                          bool osr,
+                                          const ArenaSet<ArtMethod*>& cha_single_implementations) {
   size_t alignment = GetInstructionSetAlignment(kRuntimeISA);
   // Ensure the header ends up at expected instruction alignment.
   size_t header_size = RoundUp(sizeof(OatQuickMethodHeader), alignment);
@@ -352,10 +411,42 @@ uint8_t* JitCodeCache::CommitCodeInternal(Thread* self,
   {
     MutexLock mu(self, lock_);
     method_code_map_.Put(code_ptr, method);
-    if (osr) {
+    if (!AddSingleImplementationDependenciesLocked(code_ptr, cha_single_implementations)) {
+      // A class overriding a method the code devirtualized got loaded during the compilation.
+      // Do not install the code, the next collection frees it.
+      VLOG(jit) << "Not installing " << PrettyMethod(method)
+                << " which devirtualized calls to an overridden method";
+      // Have the method compiled again, without the broken assumption, once it gets hot.
+      if (osr) {
+        // The loops the compilation was for request it again, rather than being marked as
+        // failed by DoneCompiling.
+        ProfilingInfo* info = method->GetProfilingInfo(sizeof(void*));
+        for (size_t i = 0; info != nullptr && i < info->GetNumberOfLoopCaches(); ++i) {
+          LoopCache& loop = info->GetLoopCacheAt(i);
+          if (loop.GetOsrState() == LoopCache::OsrState::kCompiling) {
+            loop.SetOsrState(LoopCache::OsrState::kNone);
+          }
+        }
+      } else {
+        method->ClearCounter();
+      }
+    } else if (osr) {
       number_of_osr_compilations_++;
-      osr_code_map_.Put(method, code_ptr);
+      // Replaces OSR code which does not have entries for all the hot loops.
+      osr_code_map_.Overwrite(method, code_ptr);
     } else {
+      if (baseline) {
+        number_of_baseline_compilations_++;
+        baseline_code_.insert(code_ptr);
+      }
+      if (evicted_methods_.erase(method) != 0) {
+        number_of_recompilations_after_eviction_++;
+        recompiled_code_size_ += code_size;
+      }
+      ProfilingInfo* info = method->GetProfilingInfo(sizeof(void*));
+      if (info != nullptr) {
+        info->SetIsBaselineCode(baseline);
+      }
       Runtime::Current()->GetInstrumentation()->UpdateMethodsCode(
           method, method_header->GetEntryPoint());
     }
@@ -366,7 +457,8 @@ uint8_t* JitCodeCache::CommitCodeInternal(Thread* self,
     }
     last_update_time_ns_.StoreRelease(NanoTime());
     VLOG(jit)
-        << "JIT added (osr=" << std::boolalpha << osr << std::noboolalpha << ") "
+        << "JIT added (baseline=" << std::boolalpha << baseline
+        << ", osr=" << osr << std::noboolalpha << ") "
         << PrettyMethod(method) << "@" << method
         << " ccache_size=" << PrettySize(CodeCacheSizeLocked()) << ": "
         << " dcache_size=" << PrettySize(DataCacheSizeLocked()) << ": "
@@ -560,6 +652,10 @@ bool JitCodeCache::ShouldDoFullCollection() {
     // Always do partial collection when the code cache size is below the reserved
     // capacity.
     return false;
+  } else if (IsCodeCacheFragmented()) {
+    // Free space is available, but in chunks too scattered to be reused: collect
+    // rather than grow.
+    return true;
   } else if (last_collection_increased_code_cache_) {
     // This time do a full collection.
     return true;
@@ -625,7 +721,14 @@ void JitCodeCache::GarbageCollectCache(Thread* self) {
       // Increase the code cache only when we do partial collections.
       // TODO: base this strategy on how full the code cache is?
       if (do_full_collection) {
+        number_of_full_collections_++;
         last_collection_increased_code_cache_ = false;
+        if (IsCodeCacheFragmented()) {
+          size_t released = ReleaseFreePages();
+          if (!kIsDebugBuild || VLOG_IS_ON(jit)) {
+            LOG(INFO) << "Released " << PrettySize(released) << " of fragmented code cache";
+          }
+        }
       } else {
         last_collection_increased_code_cache_ = true;
         IncreaseCodeCacheCapacity();
@@ -638,7 +741,13 @@ void JitCodeCache::GarbageCollectCache(Thread* self) {
         // Save the entry point of methods we have compiled, and update the entry
         // point of those methods to the interpreter. If the method is invoked, the
         // interpreter will update its entry point to the compiled code and call it.
+        // Old code is only polled from time to time, unless we need all the room we can get.
+        const bool poll_old_generation = (current_capacity_ == max_capacity_) ||
+            (number_of_full_collections_ % kOldGenerationPollingPeriod == 0);
         for (ProfilingInfo* info : profiling_infos_) {
+          if (!poll_old_generation && info->GetSurvivedCollections() >= kOldGenerationAge) {
+            continue;
+          }
           const void* entry_point = info->GetMethod()->GetEntryPointFromQuickCompiledCode();
           if (ContainsPc(entry_point)) {
             info->SetSavedEntryPoint(entry_point);
@@ -688,6 +797,15 @@ void JitCodeCache::DoCollection(Thread* self, bool collect_profiling_info) {
         }
 
         if (info->GetSavedEntryPoint() != nullptr) {
+          if (ptr == info->GetSavedEntryPoint()) {
+            // The method was invoked since we started polling, keep its code.
+            info->IncrementSurvivedCollections();
+          } else if (!ContainsPc(ptr)) {
+            // The code will be freed, unless it is on a thread stack.
+            info->ResetSurvivedCollections();
+            number_of_evictions_++;
+            evicted_methods_.insert(info->GetMethod());
+          }
           info->SetSavedEntryPoint(nullptr);
           // We are going to move this method back to interpreter. Clear the counter now to
           // give it a chance to be hot again.
@@ -716,6 +834,9 @@ void JitCodeCache::DoCollection(Thread* self, bool collect_profiling_info) {
 
     // Empty osr method map, as osr compiled code will be deleted (except the ones
     // on thread stacks).
+    for (const auto& it : osr_code_map_) {
+      ResetLoopOsrStatesLocked(it.first);
+    }
     osr_code_map_.clear();
   }
 
@@ -760,6 +881,53 @@ void JitCodeCache::DoCollection(Thread* self, bool collect_profiling_info) {
   }
 }
 
+// The free space between the allocated chunks of an mspace. Relies on mspace_inspect_all()
+// visiting the chunks in address order.
+struct CommittedFreeSpace {
+  uintptr_t committed_end = 0;
+  size_t free_bytes = 0;
+  // The free chunks after the last allocated chunk seen so far.
+  size_t pending_free_bytes = 0;
+};
+
+static void CommittedFreeSpaceCallback(void* start, void* end, size_t used_bytes, void* arg) {
+  CommittedFreeSpace* free_space = reinterpret_cast<CommittedFreeSpace*>(arg);
+  if (used_bytes == 0) {
+    free_space->pending_free_bytes += reinterpret_cast<uintptr_t>(end) -
+        reinterpret_cast<uintptr_t>(start);
+  } else {
+    free_space->committed_end = reinterpret_cast<uintptr_t>(end);
+    free_space->free_bytes += free_space->pending_free_bytes;
+    free_space->pending_free_bytes = 0;
+  }
+}
+
+bool JitCodeCache::IsCodeCacheFragmented() {
+  // Only the free chunks below the last compiled code count: the space above it, up to the
+  // footprint and the capacity of the code cache, can still be used for code of any size.
+  CommittedFreeSpace free_space;
+  mspace_inspect_all(code_mspace_, CommittedFreeSpaceCallback, &free_space);
+  if (free_space.committed_end == 0) {
+    return false;
+  }
+  size_t committed_size =
+      free_space.committed_end - reinterpret_cast<uintptr_t>(code_map_->Begin());
+  return (free_space.free_bytes >= kReservedCapacity / 2) &&
+      (free_space.free_bytes * 100 >= committed_size * kFragmentedFreePercentage);
+}
+
+size_t JitCodeCache::ReleaseFreePages() {
+  ScopedTrace trace(__FUNCTION__);
+  size_t released = 0;
+  mspace_inspect_all(data_mspace_, DlmallocMadviseCallback, &released);
+  {
+    ScopedCodeCacheWrite scc(code_map_.get());
+    mspace_inspect_all(code_mspace_, DlmallocMadviseCallback, &released);
+  }
+  released_free_pages_size_ += released;
+  return released;
+}
+
 bool JitCodeCache::CheckLiveCompiledCodeHasProfilingInfo() {
   ScopedTrace trace(__FUNCTION__);
   // Check that methods we have compiled do have a ProfilingInfo object. We would
@@ -821,6 +989,8 @@ OatQuickMethodHeader* JitCodeCache::LookupOsrMethodHeader(ArtMethod* method) {
 ProfilingInfo* JitCodeCache::AddProfilingInfo(Thread* self,
                                               ArtMethod* method,
                                               const std::vector<uint32_t>& entries,
+                                              const std::vector<uint32_t>& branch_entries,
+                                              const std::vector<uint32_t>& loop_entries,
                                               bool retry_allocation)
     // No thread safety analysis as we are using TryLock/Unlock explicitly.
     NO_THREAD_SAFETY_ANALYSIS {
@@ -829,19 +999,19 @@ ProfilingInfo* JitCodeCache::AddProfilingInfo(Thread* self,
     // If we are allocating for the interpreter, just try to lock, to avoid
     // lock contention with the JIT.
     if (lock_.ExclusiveTryLock(self)) {
-      info = AddProfilingInfoInternal(self, method, entries);
+      info = AddProfilingInfoInternal(self, method, entries, branch_entries, loop_entries);
       lock_.ExclusiveUnlock(self);
     }
   } else {
     {
       MutexLock mu(self, lock_);
-      info = AddProfilingInfoInternal(self, method, entries);
+      info = AddProfilingInfoInternal(self, method, entries, branch_entries, loop_entries);
     }
 
     if (info == nullptr) {
       GarbageCollectCache(self);
       MutexLock mu(self, lock_);
-      info = AddProfilingInfoInternal(self, method, entries);
+      info = AddProfilingInfoInternal(self, method, entries, branch_entries, loop_entries);
     }
   }
   return info;
@@ -849,9 +1019,14 @@ ProfilingInfo* JitCodeCache::AddProfilingInfo(Thread* self,
 
 ProfilingInfo* JitCodeCache::AddProfilingInfoInternal(Thread* self ATTRIBUTE_UNUSED,
                                                       ArtMethod* method,
-                                                      const std::vector<uint32_t>& entries) {
+                                                      const std::vector<uint32_t>& entries,
+                                                      const std::vector<uint32_t>& branch_entries,
+                                                      const std::vector<uint32_t>& loop_entries) {
   size_t profile_info_size = RoundUp(
-      sizeof(ProfilingInfo) + sizeof(InlineCache) * entries.size(),
+      sizeof(ProfilingInfo) +
+          sizeof(InlineCache) * entries.size() +
+          sizeof(BranchCache) * branch_entries.size() +
+          sizeof(LoopCache) * loop_entries.size(),
       sizeof(void*));
 
   // Check whether some other thread has concurrently created it.
@@ -864,7 +1039,7 @@ ProfilingInfo* JitCodeCache::AddProfilingInfoInternal(Thread* self ATTRIBUTE_UNU
   if (data == nullptr) {
     return nullptr;
   }
-  info = new (data) ProfilingInfo(method, entries);
+  info = new (data) ProfilingInfo(method, entries, branch_entries, loop_entries);
 
   // Make sure other threads see the data in the profiling info object before the
   // store in the ArtMethod's ProfilingInfo pointer.
@@ -904,26 +1079,86 @@ void JitCodeCache::GetProfiledMethods(const std::set<std::string>& dex_base_loca
   }
 }
 
+void JitCodeCache::GetCompiledMethods(Thread* self, std::vector<MethodReference>& methods) {
+  ScopedTrace trace(__FUNCTION__);
+  MutexLock mu(self, lock_);
+  for (const auto& entry : method_code_map_) {
+    ArtMethod* method = entry.second;
+    if (method->GetEntryPointFromQuickCompiledCode() != entry.first) {
+      // OSR code, or code which got replaced.
+      continue;
+    }
+    ProfilingInfo* info = method->GetProfilingInfo(sizeof(void*));
+    if (info != nullptr && info->IsBaselineCode()) {
+      continue;
+    }
+    methods.emplace_back(method->GetDexFile(), method->GetDexMethodIndex());
+  }
+}
+
 uint64_t JitCodeCache::GetLastUpdateTimeNs() const {
   return last_update_time_ns_.LoadAcquire();
 }
 
-bool JitCodeCache::IsOsrCompiled(ArtMethod* method) {
+bool JitCodeCache::HasOsrEntry(ArtMethod* method, uint32_t dex_pc) {
   MutexLock mu(Thread::Current(), lock_);
-  return osr_code_map_.find(method) != osr_code_map_.end();
+  return HasOsrEntryLocked(method, dex_pc);
 }
 
-bool JitCodeCache::NotifyCompilationOf(ArtMethod* method, Thread* self, bool osr) {
-  if (!osr && ContainsPc(method->GetEntryPointFromQuickCompiledCode())) {
+bool JitCodeCache::HasOsrEntryLocked(ArtMethod* method, uint32_t dex_pc) {
+  auto it = osr_code_map_.find(method);
+  if (it == osr_code_map_.end()) {
     return false;
   }
+  CodeInfo code_info = OatQuickMethodHeader::FromCodePointer(it->second)->GetOptimizedCodeInfo();
+  CodeInfoEncoding encoding = code_info.ExtractEncoding();
+  return code_info.GetOsrStackMapForDexPc(dex_pc, encoding).IsValid();
+}
+
+bool JitCodeCache::IsBaselineCode(const OatQuickMethodHeader* header) {
+  MutexLock mu(Thread::Current(), lock_);
+  return baseline_code_.find(header->GetCode()) != baseline_code_.end();
+}
+
+bool JitCodeCache::IsBaselineCompiled(ArtMethod* method) {
+  MutexLock mu(Thread::Current(), lock_);
+  ProfilingInfo* info = method->GetProfilingInfo(sizeof(void*));
+  return (info != nullptr) &&
+      info->IsBaselineCode() &&
+      ContainsPc(method->GetEntryPointFromQuickCompiledCode());
+}
 
+bool JitCodeCache::NotifyCompilationOf(ArtMethod* method, Thread* self, bool baseline, bool osr) {
   MutexLock mu(self, lock_);
-  if (osr && (osr_code_map_.find(method) != osr_code_map_.end())) {
-    return false;
+  ProfilingInfo* info = method->GetProfilingInfo(sizeof(void*));
+  if (!osr && ContainsPc(method->GetEntryPointFromQuickCompiledCode())) {
+    // Only baseline code gets compiled again, by the optimizing tier.
+    if (baseline || (info == nullptr) || !info->IsBaselineCode()) {
+      return false;
+    }
+  }
+
+  if (osr && (info != nullptr) && !info->IsMethodBeingCompiled(osr)) {
+    // The method gets compiled OSR again if a loop got hot which the OSR code
+    // cannot be entered at, unless its last OSR compilation failed.
+    bool needs_compilation = false;
+    for (size_t i = 0; i < info->GetNumberOfLoopCaches(); ++i) {
+      LoopCache& loop = info->GetLoopCacheAt(i);
+      if (!loop.IsHot()) {
+        continue;
+      }
+      if (HasOsrEntryLocked(method, loop.GetDexPc())) {
+        loop.SetOsrState(LoopCache::OsrState::kReady);
+      } else if (loop.GetOsrState() != LoopCache::OsrState::kFailed) {
+        loop.SetOsrState(LoopCache::OsrState::kCompiling);
+        needs_compilation = true;
+      }
+    }
+    if (!needs_compilation) {
+      return false;
+    }
   }
 
-  ProfilingInfo* info = method->GetProfilingInfo(sizeof(void*));
   if (info == nullptr) {
     VLOG(jit) << PrettyMethod(method) << " needs a ProfilingInfo to be compiled";
     // Because the counter is not atomic, there are some rare cases where we may not
@@ -934,6 +1169,11 @@ bool JitCodeCache::NotifyCompilationOf(ArtMethod* method, Thread* self, bool osr
   }
 
   if (info->IsMethodBeingCompiled(osr)) {
+    if (osr) {
+      // The loops got hot after the OSR compilation in progress started. Let them request
+      // the compilation again if its code cannot be entered at them.
+      info->ResetLoopOsrRequests();
+    }
     return false;
   }
 
@@ -957,12 +1197,50 @@ void JitCodeCache::DoneCompilerUse(ArtMethod* method, Thread* self) {
   info->DecrementInlineUse();
 }
 
-void JitCodeCache::DoneCompiling(ArtMethod* method, Thread* self ATTRIBUTE_UNUSED, bool osr) {
+void JitCodeCache::DoneCompiling(ArtMethod* method, Thread* self, bool osr) {
   ProfilingInfo* info = method->GetProfilingInfo(sizeof(void*));
   DCHECK(info->IsMethodBeingCompiled(osr));
+  if (osr) {
+    MutexLock mu(self, lock_);
+    UpdateLoopOsrStatesLocked(method, info);
+  }
   info->SetIsMethodBeingCompiled(false, osr);
 }
 
+void JitCodeCache::DropOsrRequests(ArtMethod* method, Thread* self) {
+  MutexLock mu(self, lock_);
+  ProfilingInfo* info = method->GetProfilingInfo(sizeof(void*));
+  if (info != nullptr) {
+    info->ResetLoopOsrRequests();
+  }
+}
+
+void JitCodeCache::UpdateLoopOsrStatesLocked(ArtMethod* method, ProfilingInfo* info) {
+  for (size_t i = 0; i < info->GetNumberOfLoopCaches(); ++i) {
+    LoopCache& loop = info->GetLoopCacheAt(i);
+    LoopCache::OsrState state = loop.GetOsrState();
+    if (state == LoopCache::OsrState::kNone || state == LoopCache::OsrState::kFailed) {
+      continue;
+    }
+    if (HasOsrEntryLocked(method, loop.GetDexPc())) {
+      loop.SetOsrState(LoopCache::OsrState::kReady);
+    } else if (state == LoopCache::OsrState::kCompiling) {
+      // Do not compile the method again for this loop.
+      loop.SetOsrState(LoopCache::OsrState::kFailed);
+    } else {
+      // The loop got hot during the compilation, and its request was dropped.
+      loop.SetOsrState(LoopCache::OsrState::kNone);
+    }
+  }
+}
+
+void JitCodeCache::ResetLoopOsrStatesLocked(ArtMethod* method) {
+  ProfilingInfo* info = method->GetProfilingInfo(sizeof(void*));
+  if (info != nullptr) {
+    info->ResetLoopOsrStates();
+  }
+}
+
 size_t JitCodeCache::GetMemorySizeOfCodePointer(const void* ptr) {
   MutexLock mu(Thread::Current(), lock_);
   return mspace_usable_size(reinterpret_cast<const void*>(FromCodeToAllocation(ptr)));
@@ -970,6 +1248,67 @@ size_t JitCodeCache::GetMemorySizeOfCodePointer(const void* ptr) {
 
 void JitCodeCache::InvalidateCompiledCodeFor(ArtMethod* method,
                                              const OatQuickMethodHeader* header) {
+  RemoveCompiledCodeEntry(method, header);
+  MutexLock mu(Thread::Current(), lock_);
+  number_of_deoptimizations_++;
+}
+
+bool JitCodeCache::AddSingleImplementationDependenciesLocked(
+    const void* code_ptr,
+    const ArenaSet<ArtMethod*>& cha_single_implementations) {
+  // The class hierarchy analysis clears the flag before looking for the dependents with
+  // `lock_` held, so the code either sees the flag cleared here or gets invalidated later.
+  for (ArtMethod* single_implementation : cha_single_implementations) {
+    if (!single_implementation->HasSingleImplementation()) {
+      return false;
+    }
+  }
+  if (cha_single_implementations.empty()) {
+    return true;
+  }
+  for (ArtMethod* single_implementation : cha_single_implementations) {
+    auto it = cha_dependencies_.find(single_implementation);
+    if (it == cha_dependencies_.end()) {
+      it = cha_dependencies_.Put(single_implementation, std::vector<const void*>());
+    }
+    it->second.push_back(code_ptr);
+  }
+  cha_code_dependencies_.Put(code_ptr,
+                             std::vector<ArtMethod*>(cha_single_implementations.begin(),
+                                                     cha_single_implementations.end()));
+  return true;
+}
+
+bool JitCodeCache::HasSingleImplementationDependencies(const void* code_ptr) {
+  MutexLock mu(Thread::Current(), lock_);
+  return cha_code_dependencies_.find(code_ptr) != cha_code_dependencies_.end();
+}
+
+void JitCodeCache::InvalidateSingleImplementationDependents(ArtMethod* method) {
+  Thread* self = Thread::Current();
+  std::vector<std::pair<ArtMethod*, const void*>> dependents;
+  {
+    MutexLock mu(self, lock_);
+    auto it = cha_dependencies_.find(method);
+    if (it == cha_dependencies_.end()) {
+      return;
+    }
+    for (const void* code_ptr : it->second) {
+      dependents.emplace_back(method_code_map_.Get(code_ptr), code_ptr);
+    }
+    cha_dependencies_.erase(it);
+    number_of_cha_invalidations_ += dependents.size();
+  }
+  for (const std::pair<ArtMethod*, const void*>& dependent : dependents) {
+    VLOG(jit) << "Invalidating " << PrettyMethod(dependent.first)
+              << " which devirtualized calls to " << PrettyMethod(method);
+    RemoveCompiledCodeEntry(dependent.first,
+                            OatQuickMethodHeader::FromCodePointer(dependent.second));
+  }
+}
+
+void JitCodeCache::RemoveCompiledCodeEntry(ArtMethod* method,
+                                           const OatQuickMethodHeader* header) {
   ProfilingInfo* profiling_info = method->GetProfilingInfo(sizeof(void*));
   if ((profiling_info != nullptr) &&
       (profiling_info->GetSavedEntryPoint() == header->GetEntryPoint())) {
@@ -990,10 +1329,9 @@ void JitCodeCache::InvalidateCompiledCodeFor(ArtMethod* method,
     if (it != osr_code_map_.end() && OatQuickMethodHeader::FromCodePointer(it->second) == header) {
       // Remove the OSR method, to avoid using it again.
       osr_code_map_.erase(it);
+      ResetLoopOsrStatesLocked(method);
     }
   }
-  MutexLock mu(Thread::Current(), lock_);
-  number_of_deoptimizations_++;
 }
 
 uint8_t* JitCodeCache::AllocateCode(size_t code_size) {
@@ -1032,8 +1370,18 @@ void JitCodeCache::Dump(std::ostream& os) {
      << "Total number of JIT compilations: " << number_of_compilations_ << "\n"
      << "Total number of JIT compilations for on stack replacement: "
         << number_of_osr_compilations_ << "\n"
+     << "Total number of JIT baseline compilations: " << number_of_baseline_compilations_ << "\n"
      << "Total number of deoptimizations: " << number_of_deoptimizations_ << "\n"
-     << "Total number of JIT code cache collections: " << number_of_collections_ << std::endl;
+     << "Total number of JIT code invalidations by class loading: "
+        << number_of_cha_invalidations_ << "\n"
+     << "Total number of JIT code cache collections: " << number_of_collections_ << "\n"
+     << "Total number of full JIT code cache collections: " << number_of_full_collections_ << "\n"
+     << "Total number of methods evicted from the JIT code cache: " << number_of_evictions_ << "\n"
+     << "Total number of JIT recompilations after eviction: "
+        << number_of_recompilations_after_eviction_ << " ("
+        << PrettySize(recompiled_code_size_) << ")\n"
+     << "Total JIT code cache memory released: " << PrettySize(released_free_pages_size_)
+     << std::endl;
   histogram_stack_map_memory_use_.PrintMemoryUse(os);
   histogram_code_memory_use_.PrintMemoryUse(os);
   histogram_profiling_info_memory_use_.PrintMemoryUse(os);
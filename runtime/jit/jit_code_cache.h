@@ -19,7 +19,11 @@
 
 #include "instrumentation.h"
 
+#include <set>
+#include <vector>
+
 #include "atomic.h"
+#include "base/arena_containers.h"
 #include "base/histogram-inl.h"
 #include "base/macros.h"
 #include "base/mutex.h"
@@ -40,6 +44,7 @@ class ProfilingInfo;
 
 namespace jit {
 
+class JitCodeCacheTest;
 class JitInstrumentationCache;
 
 // Alignment in bits that will suit all architectures.
@@ -69,7 +74,9 @@ class JitCodeCache {
   // Number of bytes allocated in the data cache.
   size_t DataCacheSize() REQUIRES(!lock_);
 
-  bool NotifyCompilationOf(ArtMethod* method, Thread* self, bool osr)
+  // Returns whether the compilation of `method` should go ahead. A method already compiled
+  // only gets compiled again to replace its baseline code with optimized code.
+  bool NotifyCompilationOf(ArtMethod* method, Thread* self, bool baseline, bool osr)
       SHARED_REQUIRES(Locks::mutator_lock_)
       REQUIRES(!lock_);
 
@@ -85,11 +92,19 @@ class JitCodeCache {
       SHARED_REQUIRES(Locks::mutator_lock_)
       REQUIRES(!lock_);
 
+  // Called when an OSR compilation of `method` is dropped before NotifyCompilationOf,
+  // so that the loops which requested it can request it again.
+  void DropOsrRequests(ArtMethod* method, Thread* self)
+      SHARED_REQUIRES(Locks::mutator_lock_)
+      REQUIRES(!lock_);
+
   void DoneCompilerUse(ArtMethod* method, Thread* self)
       SHARED_REQUIRES(Locks::mutator_lock_)
       REQUIRES(!lock_);
 
-  // Allocate and write code and its metadata to the code cache.
+  // Allocate and write code and its metadata to the code cache. The code is not installed if
+  // one of the methods in `cha_single_implementations`, which the code devirtualized calls
+  // to, was overridden in the meantime.
   uint8_t* CommitCode(Thread* self,
                       ArtMethod* method,
                       const uint8_t* vmap_table,
@@ -98,7 +113,9 @@ class JitCodeCache {
                       size_t fp_spill_mask,
                       const uint8_t* code,
                       size_t code_size,
-                      bool osr)
+                      bool baseline,
+                      bool osr,
+                      const ArenaSet<ArtMethod*>& cha_single_implementations)
       SHARED_REQUIRES(Locks::mutator_lock_)
       REQUIRES(!lock_);
 
@@ -123,6 +140,8 @@ class JitCodeCache {
   }
 
   // Return whether we should do a full collection given the current state of the cache.
+  // A fragmented code cache also gets a full collection, to let the mspace coalesce
+  // the chunks of the code it frees.
   bool ShouldDoFullCollection()
       REQUIRES(lock_)
       SHARED_REQUIRES(Locks::mutator_lock_);
@@ -155,6 +174,8 @@ class JitCodeCache {
   ProfilingInfo* AddProfilingInfo(Thread* self,
                                   ArtMethod* method,
                                   const std::vector<uint32_t>& entries,
+                                  const std::vector<uint32_t>& branch_entries,
+                                  const std::vector<uint32_t>& loop_entries,
                                   bool retry_allocation)
       REQUIRES(!lock_)
       SHARED_REQUIRES(Locks::mutator_lock_);
@@ -171,6 +192,11 @@ class JitCodeCache {
       REQUIRES(!lock_)
       SHARED_REQUIRES(Locks::mutator_lock_);
 
+  // Adds to `methods` all methods whose entry point is optimized code from the cache.
+  void GetCompiledMethods(Thread* self, std::vector<MethodReference>& methods)
+      REQUIRES(!lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
   uint64_t GetLastUpdateTimeNs() const;
 
   size_t GetCurrentCapacity() REQUIRES(!lock_) {
@@ -184,9 +210,28 @@ class JitCodeCache {
       REQUIRES(!lock_)
       SHARED_REQUIRES(Locks::mutator_lock_);
 
+  // Called by the class hierarchy analysis when a class overriding `method` got loaded, to
+  // invalidate the compiled code which relied on `method` having a single implementation.
+  void InvalidateSingleImplementationDependents(ArtMethod* method)
+      REQUIRES(!lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
+  // Return true if the compiled code at `code_ptr` relies on methods having a single
+  // implementation.
+  bool HasSingleImplementationDependencies(const void* code_ptr) REQUIRES(!lock_);
+
   void Dump(std::ostream& os) REQUIRES(!lock_);
 
-  bool IsOsrCompiled(ArtMethod* method) REQUIRES(!lock_);
+  // Return true if the OSR code of the method can be entered at the loop header at `dex_pc`.
+  bool HasOsrEntry(ArtMethod* method, uint32_t dex_pc) REQUIRES(!lock_);
+
+  // Return true if `header` is the header of code compiled by the baseline tier.
+  bool IsBaselineCode(const OatQuickMethodHeader* header) REQUIRES(!lock_);
+
+  // Return true if the entry point of the method is baseline code from the code cache.
+  bool IsBaselineCompiled(ArtMethod* method)
+      REQUIRES(!lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_);
 
  private:
   // Take ownership of maps.
@@ -207,13 +252,30 @@ class JitCodeCache {
                               size_t fp_spill_mask,
                               const uint8_t* code,
                               size_t code_size,
-                              bool osr)
+                              bool baseline,
+                              bool osr,
+                              const ArenaSet<ArtMethod*>& cha_single_implementations)
+      REQUIRES(!lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
+  // Records that `code_ptr` relies on the methods in `cha_single_implementations` having
+  // a single implementation. Returns false if one of them does not anymore.
+  bool AddSingleImplementationDependenciesLocked(
+      const void* code_ptr,
+      const ArenaSet<ArtMethod*>& cha_single_implementations)
+      REQUIRES(lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
+  // Stops the uses of the compiled code `header` of `method`.
+  void RemoveCompiledCodeEntry(ArtMethod* method, const OatQuickMethodHeader* header)
       REQUIRES(!lock_)
       SHARED_REQUIRES(Locks::mutator_lock_);
 
   ProfilingInfo* AddProfilingInfoInternal(Thread* self,
                                           ArtMethod* method,
-                                          const std::vector<uint32_t>& entries)
+                                          const std::vector<uint32_t>& entries,
+                                          const std::vector<uint32_t>& branch_entries,
+                                          const std::vector<uint32_t>& loop_entries)
       REQUIRES(lock_)
       SHARED_REQUIRES(Locks::mutator_lock_);
 
@@ -225,6 +287,19 @@ class JitCodeCache {
   // Free in the mspace allocations taken by 'method'.
   void FreeCode(const void* code_ptr, ArtMethod* method) REQUIRES(lock_);
 
+  bool HasOsrEntryLocked(ArtMethod* method, uint32_t dex_pc) REQUIRES(lock_);
+
+  // Record in the loop caches of `info` which loops the OSR code of `method` can be
+  // entered at, once an OSR compilation of the method is done.
+  void UpdateLoopOsrStatesLocked(ArtMethod* method, ProfilingInfo* info)
+      REQUIRES(lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
+  // Called when the OSR code of `method` is removed.
+  void ResetLoopOsrStatesLocked(ArtMethod* method)
+      REQUIRES(lock_)
+      SHARED_REQUIRES(Locks::mutator_lock_);
+
   // Number of bytes allocated in the code cache.
   size_t CodeCacheSizeLocked() REQUIRES(lock_);
 
@@ -256,6 +331,16 @@ class JitCodeCache {
   bool CheckLiveCompiledCodeHasProfilingInfo()
       REQUIRES(lock_);
 
+  // Return whether enough of the code cache below its last compiled code is in
+  // free chunks for the code cache to be considered fragmented.
+  bool IsCodeCacheFragmented() REQUIRES(lock_);
+
+  // Give the pages of the free chunks of the code and data caches back to the
+  // kernel. Compiled code cannot be moved as it is referenced from entry points
+  // and thread stacks, so this is how a fragmented code cache gets compacted.
+  // Return the number of bytes released.
+  size_t ReleaseFreePages() REQUIRES(lock_);
+
   void FreeCode(uint8_t* code) REQUIRES(lock_);
   uint8_t* AllocateCode(size_t code_size) REQUIRES(lock_);
   void FreeData(uint8_t* data) REQUIRES(lock_);
@@ -281,6 +366,14 @@ class JitCodeCache {
   SafeMap<const void*, ArtMethod*> method_code_map_ GUARDED_BY(lock_);
   // Holds osr compiled code associated to the ArtMethod.
   SafeMap<ArtMethod*, const void*> osr_code_map_ GUARDED_BY(lock_);
+  // The compiled code in `method_code_map_` which was compiled by the baseline tier.
+  std::set<const void*> baseline_code_ GUARDED_BY(lock_);
+  // The compiled code which devirtualized calls to a method with a single implementation,
+  // keyed by that method.
+  SafeMap<ArtMethod*, std::vector<const void*>> cha_dependencies_ GUARDED_BY(lock_);
+  // The reverse of `cha_dependencies_`, so that freeing code does not scan all of it.
+  // The methods may have been invalidated or unloaded since.
+  SafeMap<const void*, std::vector<ArtMethod*>> cha_code_dependencies_ GUARDED_BY(lock_);
   // ProfilingInfo objects we have allocated.
   std::vector<ProfilingInfo*> profiling_infos_ GUARDED_BY(lock_);
 
@@ -318,12 +411,37 @@ class JitCodeCache {
   // Number of compilations for on-stack-replacement done throughout the lifetime of the JIT.
   size_t number_of_osr_compilations_ GUARDED_BY(lock_);
 
+  // Number of baseline compilations done throughout the lifetime of the JIT.
+  size_t number_of_baseline_compilations_ GUARDED_BY(lock_);
+
   // Number of deoptimizations done throughout the lifetime of the JIT.
   size_t number_of_deoptimizations_ GUARDED_BY(lock_);
 
+  // Number of compiled methods invalidated because a class overriding a method they
+  // devirtualized got loaded.
+  size_t number_of_cha_invalidations_ GUARDED_BY(lock_);
+
   // Number of code cache collections done throughout the lifetime of the JIT.
   size_t number_of_collections_ GUARDED_BY(lock_);
 
+  // Number of full code cache collections done throughout the lifetime of the JIT.
+  size_t number_of_full_collections_ GUARDED_BY(lock_);
+
+  // Number of methods whose compiled code was dropped by a full collection because
+  // it was not used since the previous one.
+  size_t number_of_evictions_ GUARDED_BY(lock_);
+
+  // Number of evicted methods that got compiled again, and the size of that code.
+  // Together with the number of evictions, they measure the recompilation churn.
+  size_t number_of_recompilations_after_eviction_ GUARDED_BY(lock_);
+  size_t recompiled_code_size_ GUARDED_BY(lock_);
+
+  // Number of bytes given back to the kernel from fragmented code and data caches.
+  size_t released_free_pages_size_ GUARDED_BY(lock_);
+
+  // Methods whose compiled code was evicted and which were not compiled again yet.
+  std::set<ArtMethod*> evicted_methods_ GUARDED_BY(lock_);
+
   // Histograms for keeping track of stack map size statistics.
   Histogram<uint64_t> histogram_stack_map_memory_use_ GUARDED_BY(lock_);
 
@@ -333,6 +451,8 @@ class JitCodeCache {
   // Histograms for keeping track of profiling info statistics.
   Histogram<uint64_t> histogram_profiling_info_memory_use_ GUARDED_BY(lock_);
 
+  friend class JitCodeCacheTest;
+
   DISALLOW_IMPLICIT_CONSTRUCTORS(JitCodeCache);
 };
 
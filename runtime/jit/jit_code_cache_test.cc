@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/mman.h>
+
+#include <vector>
+
+#include "common_runtime_test.h"
+#include "jit/jit_code_cache.h"
+#include "mem_map.h"
+
+namespace art {
+namespace jit {
+
+class JitCodeCacheTest : public CommonRuntimeTest {
+ protected:
+  // The code cache gets half of the capacity, twice the reserved capacity under which it is
+  // never considered fragmented.
+  static constexpr size_t kCapacity = JitCodeCache::kReservedCapacity * 4;
+  // Large enough for every chunk to hold a whole page, small enough for the space left once the
+  // cache is full to stay under the fragmentation threshold.
+  static constexpr size_t kChunkSize = 2 * kPageSize;
+
+  void SetUp() OVERRIDE {
+    CommonRuntimeTest::SetUp();
+    std::string error_msg;
+    code_cache_.reset(JitCodeCache::Create(kCapacity,
+                                           kCapacity,
+                                           /* generate_debug_info */ false,
+                                           &error_msg));
+    ASSERT_TRUE(code_cache_ != nullptr) << error_msg;
+  }
+
+  void TearDown() OVERRIDE {
+    code_cache_.reset();
+    CommonRuntimeTest::TearDown();
+  }
+
+  // Allocates chunks of code until the code cache cannot give more.
+  std::vector<uint8_t*> FillCodeCache() {
+    MutexLock mu(Thread::Current(), code_cache_->lock_);
+    std::vector<uint8_t*> chunks;
+    code_cache_->code_map_->Protect(PROT_READ | PROT_WRITE | PROT_EXEC);
+    for (uint8_t* chunk = code_cache_->AllocateCode(kChunkSize);
+         chunk != nullptr;
+         chunk = code_cache_->AllocateCode(kChunkSize)) {
+      chunks.push_back(chunk);
+    }
+    code_cache_->code_map_->Protect(PROT_READ | PROT_EXEC);
+    return chunks;
+  }
+
+  void FreeCode(const std::vector<uint8_t*>& chunks) {
+    MutexLock mu(Thread::Current(), code_cache_->lock_);
+    code_cache_->code_map_->Protect(PROT_READ | PROT_WRITE | PROT_EXEC);
+    for (uint8_t* chunk : chunks) {
+      code_cache_->FreeCode(chunk);
+    }
+    code_cache_->code_map_->Protect(PROT_READ | PROT_EXEC);
+  }
+
+  bool IsCodeCacheFragmented() {
+    MutexLock mu(Thread::Current(), code_cache_->lock_);
+    return code_cache_->IsCodeCacheFragmented();
+  }
+
+  size_t ReleaseFreePages() {
+    MutexLock mu(Thread::Current(), code_cache_->lock_);
+    return code_cache_->ReleaseFreePages();
+  }
+
+  size_t GetReleasedFreePagesSize() {
+    MutexLock mu(Thread::Current(), code_cache_->lock_);
+    return code_cache_->released_free_pages_size_;
+  }
+
+  std::unique_ptr<JitCodeCache> code_cache_;
+};
+
+TEST_F(JitCodeCacheTest, FullCodeCacheIsNotFragmented) {
+  std::vector<uint8_t*> chunks = FillCodeCache();
+  ASSERT_FALSE(chunks.empty());
+  EXPECT_GE(chunks.size() * kChunkSize, kCapacity / 2 - JitCodeCache::kReservedCapacity / 2);
+  EXPECT_FALSE(IsCodeCacheFragmented());
+}
+
+TEST_F(JitCodeCacheTest, FreeingEveryOtherChunkFragments) {
+  std::vector<uint8_t*> chunks = FillCodeCache();
+  ASSERT_GE(chunks.size(), 4u);
+  std::vector<uint8_t*> freed;
+  for (size_t i = 0; i < chunks.size(); i += 2) {
+    freed.push_back(chunks[i]);
+  }
+  FreeCode(freed);
+  // Half of the code cache is free, in chunks that cannot be coalesced.
+  EXPECT_TRUE(IsCodeCacheFragmented());
+
+  // Each free chunk gives back at least its whole page.
+  size_t released = ReleaseFreePages();
+  EXPECT_GE(released, freed.size() * kPageSize);
+  EXPECT_EQ(GetReleasedFreePagesSize(), released);
+
+  // The free chunks are still available for new code, after which the cache is full again.
+  std::vector<uint8_t*> refilled = FillCodeCache();
+  EXPECT_EQ(refilled.size(), freed.size());
+  EXPECT_FALSE(IsCodeCacheFragmented());
+}
+
+}  // namespace jit
+}  // namespace art
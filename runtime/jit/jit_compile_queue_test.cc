@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include "art_method-inl.h"
+#include "class_linker.h"
+#include "common_runtime_test.h"
+#include "jit/jit.h"
+#include "mirror/class-inl.h"
+#include "scoped_thread_state_change.h"
+#include "thread_pool.h"
+
+namespace art {
+namespace jit {
+
+// Checks the order in which the Jit hands its pending compilation tasks to the workers. The
+// workers of the thread pool are never started, so the tasks stay in the queue until the test
+// takes them off.
+class JitCompileQueueTest : public CommonRuntimeTest {
+ protected:
+  static constexpr size_t kNumMethods = 4;
+
+  void SetUp() OVERRIDE {
+    CommonRuntimeTest::SetUp();
+    jit_.reset(new Jit());
+    jit_->thread_pool_.reset(new ThreadPool("Jit thread pool", 1));
+    ScopedObjectAccess soa(Thread::Current());
+    mirror::Class* klass = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+    ASSERT_TRUE(klass != nullptr);
+    ASSERT_GE(klass->NumVirtualMethods(), kNumMethods);
+    for (size_t i = 0; i < kNumMethods; ++i) {
+      ArtMethod* method = klass->GetVirtualMethod(i, sizeof(void*));
+      methods_.push_back(method);
+      saved_counters_.push_back(method->GetCounter());
+    }
+  }
+
+  void TearDown() OVERRIDE {
+    Thread* self = Thread::Current();
+    {
+      ScopedObjectAccess soa(self);
+      JitCompileTask* task;
+      while ((task = jit_->PopCompileTask(self)) != nullptr) {
+        task->Finalize();
+      }
+      for (size_t i = 0; i < methods_.size(); ++i) {
+        methods_[i]->SetCounter(saved_counters_[i]);
+      }
+    }
+    jit_->thread_pool_->RemoveAllTasks(self);
+    jit_->thread_pool_.reset();
+    jit_.reset();
+    CommonRuntimeTest::TearDown();
+  }
+
+  void AddCompileTask(ArtMethod* method, JitCompileTask::TaskKind kind)
+      SHARED_REQUIRES(Locks::mutator_lock_) {
+    jit_->AddCompileTask(Thread::Current(), new JitCompileTask(method, kind));
+  }
+
+  // Takes the next task off the queue and checks that it is the expected one.
+  void ExpectNextTask(ArtMethod* method, JitCompileTask::TaskKind kind)
+      SHARED_REQUIRES(Locks::mutator_lock_) {
+    JitCompileTask* task = jit_->PopCompileTask(Thread::Current());
+    ASSERT_TRUE(task != nullptr);
+    EXPECT_EQ(task->GetMethod(), method) << PrettyMethod(task->GetMethod());
+    EXPECT_EQ(task->GetKind(), kind);
+    task->Finalize();
+  }
+
+  void ExpectEmptyQueue() {
+    EXPECT_TRUE(jit_->PopCompileTask(Thread::Current()) == nullptr);
+  }
+
+  std::unique_ptr<Jit> jit_;
+  std::vector<ArtMethod*> methods_;
+  std::vector<uint16_t> saved_counters_;
+};
+
+TEST_F(JitCompileQueueTest, HotterTasksFirst) {
+  ScopedObjectAccess soa(Thread::Current());
+  methods_[0]->SetCounter(100);
+  methods_[1]->SetCounter(300);
+  methods_[2]->SetCounter(200);
+  for (size_t i = 0; i < 3; ++i) {
+    AddCompileTask(methods_[i], JitCompileTask::kCompile);
+  }
+  ExpectNextTask(methods_[1], JitCompileTask::kCompile);
+  ExpectNextTask(methods_[2], JitCompileTask::kCompile);
+  ExpectNextTask(methods_[0], JitCompileTask::kCompile);
+  ExpectEmptyQueue();
+}
+
+TEST_F(JitCompileQueueTest, HotnessIsReadWhenTheTaskIsTaken) {
+  ScopedObjectAccess soa(Thread::Current());
+  methods_[0]->SetCounter(200);
+  methods_[1]->SetCounter(100);
+  AddCompileTask(methods_[0], JitCompileTask::kCompile);
+  AddCompileTask(methods_[1], JitCompileTask::kCompile);
+  // The newer task got hotter while both were pending.
+  methods_[1]->SetCounter(300);
+  ExpectNextTask(methods_[1], JitCompileTask::kCompile);
+  ExpectNextTask(methods_[0], JitCompileTask::kCompile);
+  ExpectEmptyQueue();
+}
+
+TEST_F(JitCompileQueueTest, OsrTasksFirst) {
+  ScopedObjectAccess soa(Thread::Current());
+  methods_[0]->SetCounter(300);
+  methods_[1]->SetCounter(200);
+  methods_[2]->SetCounter(100);
+  AddCompileTask(methods_[0], JitCompileTask::kCompile);
+  AddCompileTask(methods_[1], JitCompileTask::kCompileBaseline);
+  AddCompileTask(methods_[2], JitCompileTask::kCompileOsr);
+  AddCompileTask(methods_[1], JitCompileTask::kCompileOsr);
+  // The OSR requests go before the hotter methods, the hotter first among them.
+  ExpectNextTask(methods_[1], JitCompileTask::kCompileOsr);
+  ExpectNextTask(methods_[2], JitCompileTask::kCompileOsr);
+  ExpectNextTask(methods_[0], JitCompileTask::kCompile);
+  ExpectNextTask(methods_[1], JitCompileTask::kCompileBaseline);
+  ExpectEmptyQueue();
+}
+
+TEST_F(JitCompileQueueTest, EqualPrioritiesStayInOrder) {
+  ScopedObjectAccess soa(Thread::Current());
+  for (size_t i = 0; i < kNumMethods; ++i) {
+    methods_[i]->SetCounter(100);
+  }
+  for (size_t i = 0; i < kNumMethods; ++i) {
+    AddCompileTask(methods_[kNumMethods - 1 - i], JitCompileTask::kCompile);
+  }
+  // A second request for a pending task does not move it.
+  AddCompileTask(methods_[0], JitCompileTask::kCompile);
+  for (size_t i = 0; i < kNumMethods; ++i) {
+    ExpectNextTask(methods_[kNumMethods - 1 - i], JitCompileTask::kCompile);
+  }
+  ExpectEmptyQueue();
+}
+
+}  // namespace jit
+}  // namespace art
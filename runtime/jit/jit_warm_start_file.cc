@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_warm_start_file.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <limits>
+
+#include "base/stringprintf.h"
+#include "base/systrace.h"
+#include "dex_file.h"
+#include "gc/heap.h"
+#include "gc/space/image_space.h"
+#include "image.h"
+#include "runtime.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+namespace jit {
+
+uint32_t JitWarmStartFile::GetBootImageChecksum() {
+  const std::vector<gc::space::ImageSpace*>& image_spaces =
+      Runtime::Current()->GetHeap()->GetBootImageSpaces();
+  if (image_spaces.empty()) {
+    return 0u;
+  }
+  return image_spaces[0]->GetImageHeader().GetOatChecksum();
+}
+
+JitWarmStartFile::JitWarmStartFile(uint32_t boot_image_checksum)
+    : boot_image_checksum_(boot_image_checksum),
+      lock_("JIT warm start file lock"),
+      number_of_pending_methods_(0) {}
+
+bool JitWarmStartFile::Load(const std::string& filename, std::string* error_msg) {
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    *error_msg = StringPrintf("Could not open %s: %s", filename.c_str(), strerror(errno));
+    return false;
+  }
+  ProfileCompilationInfo info;
+  bool success = info.Load(fd);
+  close(fd);
+  if (!success) {
+    *error_msg = StringPrintf("Could not load %s", filename.c_str());
+    return false;
+  }
+  // The code compiled for the methods depends on the boot image, drop all of them if it changed.
+  bool has_boot_image_checksum = false;
+  for (const DexCacheResolvedClasses& entry : info.GetResolvedClasses()) {
+    if (entry.GetDexLocation() == kBootImageKey) {
+      if (entry.GetLocationChecksum() != boot_image_checksum_) {
+        *error_msg = StringPrintf("Boot image checksum mismatch: %x vs %x",
+                                  entry.GetLocationChecksum(),
+                                  boot_image_checksum_);
+        return false;
+      }
+      has_boot_image_checksum = true;
+    }
+  }
+  if (!has_boot_image_checksum) {
+    *error_msg = StringPrintf("No boot image checksum in %s", filename.c_str());
+    return false;
+  }
+
+  MutexLock mu(Thread::Current(), lock_);
+  previous_run_.MergeWith(info);
+  taken_methods_.clear();
+  number_of_pending_methods_.StoreRelaxed(previous_run_.GetNumberOfMethods());
+  return true;
+}
+
+bool JitWarmStartFile::Save(const std::string& filename,
+                            const std::vector<MethodReference>& methods,
+                            std::string* error_msg) const {
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  // The profile format stores 16-bit method indexes.
+  std::vector<MethodReference> profile_methods;
+  for (const MethodReference& ref : methods) {
+    if (ref.dex_method_index <= std::numeric_limits<uint16_t>::max()) {
+      profile_methods.push_back(ref);
+    }
+  }
+  std::set<DexCacheResolvedClasses> boot_image;
+  DexCacheResolvedClasses boot_image_entry(kBootImageKey, kBootImageKey, boot_image_checksum_);
+  // The profile writes no entry without methods or classes.
+  const uint16_t class_def_idx = 0u;
+  boot_image_entry.AddClasses(&class_def_idx, &class_def_idx + 1);
+  boot_image.insert(boot_image_entry);
+  ProfileCompilationInfo info;
+  if (!info.AddMethodsAndClasses(profile_methods, boot_image)) {
+    *error_msg = "Could not add the compiled methods";
+    return false;
+  }
+
+  // MergeAndSave only updates existing files.
+  int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    *error_msg = StringPrintf("Could not create %s: %s", filename.c_str(), strerror(errno));
+    return false;
+  }
+  close(fd);
+
+  // Keep the methods of the previous run which did not get invoked yet, they are likely to be
+  // needed later in this run too. Start over if a dex file or the boot image changed since the
+  // file was written, their entries then have other checksums and the merge fails.
+  uint64_t bytes_written;
+  if (!info.MergeAndSave(filename, &bytes_written, /* force */ true)) {
+    *error_msg = StringPrintf("Could not save %s", filename.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool JitWarmStartFile::TakeMethod(const DexFile& dex_file, uint32_t method_idx) {
+  if (IsEmpty() || method_idx > std::numeric_limits<uint16_t>::max()) {
+    return false;
+  }
+  MethodReference ref(&dex_file, method_idx);
+  MutexLock mu(Thread::Current(), lock_);
+  // ContainsMethod also checks the dex file checksum, methods of changed dex files never match.
+  if (!previous_run_.ContainsMethod(ref) || !taken_methods_.insert(ref).second) {
+    return false;
+  }
+  number_of_pending_methods_.FetchAndSubSequentiallyConsistent(1);
+  return true;
+}
+
+}  // namespace jit
+}  // namespace art
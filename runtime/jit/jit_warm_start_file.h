@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_JIT_WARM_START_FILE_H_
+#define ART_RUNTIME_JIT_JIT_WARM_START_FILE_H_
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "atomic.h"
+#include "base/mutex.h"
+#include "method_reference.h"
+#include "offline_profiling_info.h"
+
+namespace art {
+
+class DexFile;
+
+namespace jit {
+
+// The methods the JIT compiled with the optimizing compiler in a previous run of the process,
+// so that the next run can compile them at their first invocation instead of waiting for them to
+// get hot again. The JIT code itself embeds addresses of runtime data structures which are only
+// valid in the process that compiled it, so the file records which methods to compile rather
+// than the code: the methods still get compiled once in every run. The file is a profile in the
+// ProfileCompilationInfo format, which keys the methods by dex location and checksum. An extra
+// entry records the checksum of the boot image, a file written with another boot image is
+// rejected as a whole.
+class JitWarmStartFile {
+ public:
+  explicit JitWarmStartFile(uint32_t boot_image_checksum);
+
+  // Returns the oat checksum of the boot image of the runtime, 0 without a boot image.
+  static uint32_t GetBootImageChecksum();
+
+  // Loads the methods from `filename`. Returns false and sets `error_msg` if the file cannot be
+  // read, is malformed or was written with another boot image.
+  bool Load(const std::string& filename, std::string* error_msg) REQUIRES(!lock_);
+
+  // Adds `methods` to `filename`, keeping the methods already in it unless their dex file or the
+  // boot image changed. Does file I/O, so must not be called with the mutator lock held.
+  bool Save(const std::string& filename,
+            const std::vector<MethodReference>& methods,
+            std::string* error_msg) const REQUIRES(!Locks::mutator_lock_);
+
+  // Returns whether the method was compiled in the previous run. Returns true only once per
+  // method.
+  bool TakeMethod(const DexFile& dex_file, uint32_t method_idx) REQUIRES(!lock_);
+
+  bool IsEmpty() const {
+    return number_of_pending_methods_.LoadRelaxed() == 0;
+  }
+
+  size_t GetNumberOfPendingMethods() const {
+    return number_of_pending_methods_.LoadRelaxed();
+  }
+
+ private:
+  // The profile key of the entry holding the boot image checksum. Profile keys of dex files are
+  // base names of dex locations, which do not start with '!'.
+  static constexpr const char* kBootImageKey = "!boot-image";
+
+  const uint32_t boot_image_checksum_;
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  // The methods loaded from the file, and the ones of them which were already requested.
+  ProfileCompilationInfo previous_run_ GUARDED_BY(lock_);
+  std::set<MethodReference, MethodReferenceComparator> taken_methods_ GUARDED_BY(lock_);
+  Atomic<size_t> number_of_pending_methods_;
+
+  DISALLOW_COPY_AND_ASSIGN(JitWarmStartFile);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_JIT_WARM_START_FILE_H_
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "base/unix_file/fd_file.h"
+#include "common_runtime_test.h"
+#include "dex_file.h"
+#include "jit/jit_warm_start_file.h"
+#include "jit/offline_profiling_info.h"
+#include "method_reference.h"
+#include "os.h"
+
+namespace art {
+namespace jit {
+
+class JitWarmStartFileTest : public CommonRuntimeTest {
+ protected:
+  void SetUp() OVERRIDE {
+    CommonRuntimeTest::SetUp();
+    dex_files_ = OpenTestDexFiles("ProfileTestMultiDex");
+    ASSERT_EQ(dex_files_.size(), 2u);
+  }
+
+  static bool Save(const std::string& filename,
+                   const std::vector<MethodReference>& methods,
+                   std::string* error_msg,
+                   uint32_t boot_image_checksum = kBootImageChecksum) {
+    return JitWarmStartFile(boot_image_checksum).Save(filename, methods, error_msg);
+  }
+
+  static constexpr uint32_t kBootImageChecksum = 0x12345678u;
+
+  std::vector<std::unique_ptr<const DexFile>> dex_files_;
+};
+
+TEST_F(JitWarmStartFileTest, SaveAndLoad) {
+  ScratchFile file;
+  std::string error_msg;
+  std::vector<MethodReference> methods;
+  methods.emplace_back(dex_files_[0].get(), 1);
+  methods.emplace_back(dex_files_[0].get(), 3);
+  methods.emplace_back(dex_files_[1].get(), 2);
+  ASSERT_TRUE(Save(file.GetFilename(), methods, &error_msg)) << error_msg;
+
+  JitWarmStartFile loaded(kBootImageChecksum);
+  ASSERT_TRUE(loaded.Load(file.GetFilename(), &error_msg)) << error_msg;
+  EXPECT_EQ(loaded.GetNumberOfPendingMethods(), 3u);
+  EXPECT_FALSE(loaded.TakeMethod(*dex_files_[0], 2));
+  EXPECT_TRUE(loaded.TakeMethod(*dex_files_[0], 1));
+  // Methods are only handed out once.
+  EXPECT_FALSE(loaded.TakeMethod(*dex_files_[0], 1));
+  EXPECT_TRUE(loaded.TakeMethod(*dex_files_[0], 3));
+  EXPECT_FALSE(loaded.TakeMethod(*dex_files_[1], 1));
+  EXPECT_TRUE(loaded.TakeMethod(*dex_files_[1], 2));
+  EXPECT_TRUE(loaded.IsEmpty());
+}
+
+TEST_F(JitWarmStartFileTest, IsAProfile) {
+  ScratchFile file;
+  std::string error_msg;
+  std::vector<MethodReference> methods;
+  methods.emplace_back(dex_files_[0].get(), 1);
+  methods.emplace_back(dex_files_[1].get(), 2);
+  ASSERT_TRUE(Save(file.GetFilename(), methods, &error_msg)) << error_msg;
+
+  ProfileCompilationInfo info;
+  ASSERT_TRUE(info.Load(file.GetFile()->Fd()));
+  EXPECT_EQ(info.GetNumberOfMethods(), 2u);
+  EXPECT_TRUE(info.ContainsMethod(MethodReference(dex_files_[0].get(), 1)));
+  EXPECT_TRUE(info.ContainsMethod(MethodReference(dex_files_[1].get(), 2)));
+}
+
+TEST_F(JitWarmStartFileTest, SaveKeepsPreviousMethods) {
+  ScratchFile file;
+  std::string error_msg;
+  std::vector<MethodReference> first_run;
+  first_run.emplace_back(dex_files_[0].get(), 1);
+  first_run.emplace_back(dex_files_[0].get(), 2);
+  ASSERT_TRUE(Save(file.GetFilename(), first_run, &error_msg)) << error_msg;
+
+  // Method 2 was never invoked in the second run, but stays in the file.
+  std::vector<MethodReference> second_run;
+  second_run.emplace_back(dex_files_[0].get(), 1);
+  second_run.emplace_back(dex_files_[1].get(), 4);
+  ASSERT_TRUE(Save(file.GetFilename(), second_run, &error_msg)) << error_msg;
+
+  JitWarmStartFile third_run(kBootImageChecksum);
+  ASSERT_TRUE(third_run.Load(file.GetFilename(), &error_msg)) << error_msg;
+  EXPECT_EQ(third_run.GetNumberOfPendingMethods(), 3u);
+  EXPECT_TRUE(third_run.TakeMethod(*dex_files_[0], 1));
+  EXPECT_TRUE(third_run.TakeMethod(*dex_files_[0], 2));
+  EXPECT_TRUE(third_run.TakeMethod(*dex_files_[1], 4));
+}
+
+TEST_F(JitWarmStartFileTest, CreatesMissingFile) {
+  ScratchFile directory;
+  std::string filename = directory.GetFilename() + ".warm_start";
+  std::string error_msg;
+  std::vector<MethodReference> methods;
+  methods.emplace_back(dex_files_[0].get(), 1);
+  ASSERT_TRUE(Save(filename, methods, &error_msg)) << error_msg;
+
+  JitWarmStartFile loaded(kBootImageChecksum);
+  ASSERT_TRUE(loaded.Load(filename, &error_msg)) << error_msg;
+  EXPECT_TRUE(loaded.TakeMethod(*dex_files_[0], 1));
+  unlink(filename.c_str());
+}
+
+TEST_F(JitWarmStartFileTest, RejectsTruncatedFile) {
+  ScratchFile file;
+  std::string error_msg;
+  std::vector<MethodReference> methods;
+  methods.emplace_back(dex_files_[0].get(), 1);
+  ASSERT_TRUE(Save(file.GetFilename(), methods, &error_msg)) << error_msg;
+
+  std::unique_ptr<File> truncated(OS::OpenFileReadWrite(file.GetFilename().c_str()));
+  ASSERT_TRUE(truncated != nullptr);
+  ASSERT_EQ(truncated->SetLength(truncated->GetLength() - 2), 0);
+  ASSERT_EQ(truncated->FlushCloseOrErase(), 0);
+
+  JitWarmStartFile loaded(kBootImageChecksum);
+  EXPECT_FALSE(loaded.Load(file.GetFilename(), &error_msg));
+  EXPECT_TRUE(loaded.IsEmpty());
+}
+
+TEST_F(JitWarmStartFileTest, RejectsOtherBootImage) {
+  ScratchFile file;
+  std::string error_msg;
+  std::vector<MethodReference> methods;
+  methods.emplace_back(dex_files_[0].get(), 1);
+  ASSERT_TRUE(Save(file.GetFilename(), methods, &error_msg)) << error_msg;
+
+  JitWarmStartFile loaded(kBootImageChecksum + 1);
+  EXPECT_FALSE(loaded.Load(file.GetFilename(), &error_msg));
+  EXPECT_TRUE(loaded.IsEmpty());
+  EXPECT_FALSE(loaded.TakeMethod(*dex_files_[0], 1));
+}
+
+TEST_F(JitWarmStartFileTest, SaveDropsMethodsOfOtherBootImage) {
+  ScratchFile file;
+  std::string error_msg;
+  std::vector<MethodReference> first_run;
+  first_run.emplace_back(dex_files_[0].get(), 1);
+  ASSERT_TRUE(Save(file.GetFilename(), first_run, &error_msg)) << error_msg;
+
+  // The boot image changed, the methods of the first run are not kept.
+  std::vector<MethodReference> second_run;
+  second_run.emplace_back(dex_files_[0].get(), 2);
+  ASSERT_TRUE(Save(file.GetFilename(), second_run, &error_msg, kBootImageChecksum + 1))
+      << error_msg;
+
+  JitWarmStartFile third_run(kBootImageChecksum + 1);
+  ASSERT_TRUE(third_run.Load(file.GetFilename(), &error_msg)) << error_msg;
+  EXPECT_EQ(third_run.GetNumberOfPendingMethods(), 1u);
+  EXPECT_FALSE(third_run.TakeMethod(*dex_files_[0], 1));
+  EXPECT_TRUE(third_run.TakeMethod(*dex_files_[0], 2));
+}
+
+}  // namespace jit
+}  // namespace art
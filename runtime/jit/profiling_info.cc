@@ -16,6 +16,8 @@
 
 #include "profiling_info.h"
 
+#include <algorithm>
+
 #include "art_method-inl.h"
 #include "dex_instruction.h"
 #include "jit/jit.h"
@@ -25,17 +27,35 @@
 
 namespace art {
 
-ProfilingInfo::ProfilingInfo(ArtMethod* method, const std::vector<uint32_t>& entries)
+ProfilingInfo::ProfilingInfo(ArtMethod* method,
+                             const std::vector<uint32_t>& entries,
+                             const std::vector<uint32_t>& branch_entries,
+                             const std::vector<uint32_t>& loop_entries)
       : number_of_inline_caches_(entries.size()),
+        number_of_branch_caches_(branch_entries.size()),
+        number_of_loop_caches_(loop_entries.size()),
         method_(method),
         is_method_being_compiled_(false),
         is_osr_method_being_compiled_(false),
+        is_baseline_code_(false),
         current_inline_uses_(0),
+        survived_collections_(0),
+        deoptimization_count_(0),
         saved_entry_point_(nullptr) {
   memset(&cache_, 0, number_of_inline_caches_ * sizeof(InlineCache));
   for (size_t i = 0; i < number_of_inline_caches_; ++i) {
     cache_[i].dex_pc_ = entries[i];
   }
+  BranchCache* branch_caches = GetBranchCaches();
+  memset(branch_caches, 0, number_of_branch_caches_ * sizeof(BranchCache));
+  for (size_t i = 0; i < number_of_branch_caches_; ++i) {
+    branch_caches[i].dex_pc_ = branch_entries[i];
+  }
+  LoopCache* loop_caches = GetLoopCaches();
+  memset(loop_caches, 0, number_of_loop_caches_ * sizeof(LoopCache));
+  for (size_t i = 0; i < number_of_loop_caches_; ++i) {
+    loop_caches[i].dex_pc_ = loop_entries[i];
+  }
   if (method->IsCopied()) {
     // GetHoldingClassOfCopiedMethod is expensive, but creating a profiling info for a copied method
     // appears to happen very rarely in practice.
@@ -56,10 +76,19 @@ bool ProfilingInfo::Create(Thread* self, ArtMethod* method, bool retry_allocatio
   const uint16_t* code_ptr = code_item.insns_;
   const uint16_t* code_end = code_item.insns_ + code_item.insns_size_in_code_units_;
 
+  // Only baseline code records the branches, the interpreter doesn't.
+  const bool profile_branches = Runtime::Current()->GetJit()->UseBaselineCompilation();
+
   uint32_t dex_pc = 0;
   std::vector<uint32_t> entries;
+  std::vector<uint32_t> branch_entries;
+  std::vector<uint32_t> loop_entries;
   while (code_ptr < code_end) {
     const Instruction& instruction = *Instruction::At(code_ptr);
+    if (instruction.IsBranch() && instruction.GetTargetOffset() <= 0) {
+      // The target of a backward branch is a loop header.
+      loop_entries.push_back(dex_pc + instruction.GetTargetOffset());
+    }
     switch (instruction.Opcode()) {
       case Instruction::INVOKE_VIRTUAL:
       case Instruction::INVOKE_VIRTUAL_RANGE:
@@ -70,6 +99,23 @@ bool ProfilingInfo::Create(Thread* self, ArtMethod* method, bool retry_allocatio
         entries.push_back(dex_pc);
         break;
 
+      case Instruction::IF_EQ:
+      case Instruction::IF_NE:
+      case Instruction::IF_LT:
+      case Instruction::IF_GE:
+      case Instruction::IF_GT:
+      case Instruction::IF_LE:
+      case Instruction::IF_EQZ:
+      case Instruction::IF_NEZ:
+      case Instruction::IF_LTZ:
+      case Instruction::IF_GEZ:
+      case Instruction::IF_GTZ:
+      case Instruction::IF_LEZ:
+        if (profile_branches) {
+          branch_entries.push_back(dex_pc);
+        }
+        break;
+
       default:
         break;
     }
@@ -77,12 +123,17 @@ bool ProfilingInfo::Create(Thread* self, ArtMethod* method, bool retry_allocatio
     code_ptr += instruction.SizeInCodeUnits();
   }
 
+  // Loops can have several back edges.
+  std::sort(loop_entries.begin(), loop_entries.end());
+  loop_entries.erase(std::unique(loop_entries.begin(), loop_entries.end()), loop_entries.end());
+
   // We always create a `ProfilingInfo` object, even if there is no instruction we are
   // interested in. The JIT code cache internally uses it.
 
   // Allocate the `ProfilingInfo` object int the JIT's data space.
   jit::JitCodeCache* code_cache = Runtime::Current()->GetJit()->GetCodeCache();
-  return code_cache->AddProfilingInfo(self, method, entries, retry_allocation) != nullptr;
+  return code_cache->AddProfilingInfo(
+      self, method, entries, branch_entries, loop_entries, retry_allocation) != nullptr;
 }
 
 InlineCache* ProfilingInfo::GetInlineCache(uint32_t dex_pc) {
@@ -97,13 +148,106 @@ InlineCache* ProfilingInfo::GetInlineCache(uint32_t dex_pc) {
   return cache;
 }
 
+BranchCache* ProfilingInfo::GetBranchCache(uint32_t dex_pc) {
+  // The branch caches are sorted by dex pc.
+  BranchCache* begin = GetBranchCaches();
+  BranchCache* end = begin + number_of_branch_caches_;
+  BranchCache* it = std::lower_bound(begin, end, dex_pc, [](const BranchCache& cache,
+                                                            uint32_t pc) {
+    return cache.dex_pc_ < pc;
+  });
+  return (it != end && it->dex_pc_ == dex_pc) ? it : nullptr;
+}
+
+void ProfilingInfo::AddBranchInfo(uint32_t dex_pc, bool taken) {
+  BranchCache* cache = GetBranchCache(dex_pc);
+  if (cache == nullptr) {
+    // The profiling info was created without branch caches, for instance by the interpreter
+    // before the baseline tier was in use. Dropping the sample only delays speculation.
+    return;
+  }
+  uint16_t* count = taken ? &cache->taken_count_ : &cache->not_taken_count_;
+  if (*count != std::numeric_limits<uint16_t>::max()) {
+    ++*count;
+  }
+}
+
+LoopCache* ProfilingInfo::GetLoopCache(uint32_t dex_pc) {
+  // The loop caches are sorted by dex pc.
+  LoopCache* begin = GetLoopCaches();
+  LoopCache* end = begin + number_of_loop_caches_;
+  LoopCache* it = std::lower_bound(begin, end, dex_pc, [](const LoopCache& cache, uint32_t pc) {
+    return cache.dex_pc_ < pc;
+  });
+  return (it != end && it->dex_pc_ == dex_pc) ? it : nullptr;
+}
+
+bool ProfilingInfo::AddLoopBackEdges(uint32_t dex_pc, uint16_t count, uint16_t threshold) {
+  LoopCache* cache = GetLoopCache(dex_pc);
+  if (cache == nullptr) {
+    // Loops through a switch are not profiled.
+    return false;
+  }
+  if (cache->osr_state_ != LoopCache::OsrState::kNone) {
+    // The OSR compilation was requested already, or the loop knows whether it has OSR code.
+    return false;
+  }
+  uint32_t new_count = cache->back_edge_count_ + count;
+  if (new_count >= threshold) {
+    cache->is_hot_ = true;
+    cache->back_edge_count_ = 0;
+    cache->osr_state_ = LoopCache::OsrState::kRequested;
+    return true;
+  }
+  cache->back_edge_count_ = new_count;
+  return false;
+}
+
+void ProfilingInfo::ResetLoopOsrStates() {
+  LoopCache* loop_caches = GetLoopCaches();
+  for (size_t i = 0; i < number_of_loop_caches_; ++i) {
+    if (loop_caches[i].osr_state_ == LoopCache::OsrState::kReady) {
+      loop_caches[i].osr_state_ = LoopCache::OsrState::kNone;
+    }
+  }
+}
+
+void ProfilingInfo::ResetLoopOsrRequests() {
+  LoopCache* loop_caches = GetLoopCaches();
+  for (size_t i = 0; i < number_of_loop_caches_; ++i) {
+    if (loop_caches[i].osr_state_ == LoopCache::OsrState::kRequested) {
+      loop_caches[i].osr_state_ = LoopCache::OsrState::kNone;
+    }
+  }
+}
+
+bool ProfilingInfo::AddSpeculationFailure(uint32_t dex_pc) {
+  BranchCache* cache = GetBranchCache(dex_pc);
+  if (cache != nullptr) {
+    // The compiled code assumed that the branch only goes one way, and it just went the
+    // other way. Record it so that both directions are seen from now on.
+    if (cache->taken_count_ == 0) {
+      cache->taken_count_ = 1;
+      return true;
+    } else if (cache->not_taken_count_ == 0) {
+      cache->not_taken_count_ = 1;
+      return true;
+    }
+    return false;
+  }
+  // Inline cache guards need no bookkeeping, the interpreter records the new receiver
+  // type when it executes the invoke the code deoptimized at.
+  return GetInlineCache(dex_pc) != nullptr;
+}
+
 void ProfilingInfo::AddInvokeInfo(uint32_t dex_pc, mirror::Class* cls) {
   InlineCache* cache = GetInlineCache(dex_pc);
   CHECK(cache != nullptr) << PrettyMethod(method_) << "@" << dex_pc;
   for (size_t i = 0; i < InlineCache::kIndividualCacheSize; ++i) {
     mirror::Class* existing = cache->classes_[i].Read();
     if (existing == cls) {
-      // Receiver type is already in the cache, nothing else to do.
+      // Receiver type is already in the cache, just count it.
+      InlineCache::IncrementCount(&cache->counts_[i]);
       return;
     } else if (existing == nullptr) {
       // Cache entry is empty, try to put `cls` in it.
@@ -115,7 +259,8 @@ void ProfilingInfo::AddInvokeInfo(uint32_t dex_pc, mirror::Class* cls) {
         // entry in case the entry contains `cls`.
         --i;
       } else {
-        // We successfully set `cls`, just return.
+        // We successfully set `cls`, count it and return.
+        InlineCache::IncrementCount(&cache->counts_[i]);
         // Since the instrumentation is marked from the declaring class we need to mark the card so
         // that mod-union tables and card rescanning know about the update.
         // Note that the declaring class is not necessarily the holding class if the method is
@@ -130,6 +275,7 @@ void ProfilingInfo::AddInvokeInfo(uint32_t dex_pc, mirror::Class* cls) {
   }
   // Unsuccessfull - cache is full, making it megamorphic. We do not DCHECK it though,
   // as the garbage collector might clear the entries concurrently.
+  InlineCache::IncrementCount(&cache->megamorphic_count_);
 }
 
 }  // namespace art
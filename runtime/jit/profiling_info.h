@@ -17,6 +17,7 @@
 #ifndef ART_RUNTIME_JIT_PROFILING_INFO_H_
 #define ART_RUNTIME_JIT_PROFILING_INFO_H_
 
+#include <limits>
 #include <vector>
 
 #include "base/macros.h"
@@ -35,8 +36,10 @@ namespace mirror {
 class Class;
 }
 
-// Structure to store the classes seen at runtime for a specific instruction.
-// Once the classes_ array is full, we consider the INVOKE to be megamorphic.
+// Structure to store the classes seen at runtime for a specific instruction,
+// along with how many times each of them was seen. Once the classes_ array is
+// full, we consider the INVOKE to be megamorphic and only count the receivers
+// that are not in the cache.
 class InlineCache {
  public:
   bool IsMonomorphic() const {
@@ -73,17 +76,122 @@ class InlineCache {
     return classes_[i].Read();
   }
 
-  static constexpr uint16_t kIndividualCacheSize = 5;
+  // Number of times the class at index `i` was seen as receiver.
+  uint32_t GetCountAt(size_t i) const {
+    return counts_[i];
+  }
+
+  // Number of times a receiver not in the cache was seen once the cache was full.
+  uint32_t GetMegamorphicCount() const {
+    return megamorphic_count_;
+  }
+
+  static constexpr uint16_t kIndividualCacheSize = 8;
 
  private:
+  static void IncrementCount(uint32_t* count) {
+    if (*count != std::numeric_limits<uint32_t>::max()) {
+      ++*count;
+    }
+  }
+
   uint32_t dex_pc_;
   GcRoot<mirror::Class> classes_[kIndividualCacheSize];
+  // The counts are updated without synchronization, so concurrent updates can
+  // be lost. This is fine as the compiler only uses them as a profile.
+  uint32_t counts_[kIndividualCacheSize];
+  uint32_t megamorphic_count_;
 
   friend class ProfilingInfo;
 
   DISALLOW_COPY_AND_ASSIGN(InlineCache);
 };
 
+// Number of times a conditional branch jumped to its target or fell through.
+// Only recorded by baseline JIT code, for the optimizing tier to speculate
+// that a branch direction never seen is not going to be taken.
+class BranchCache {
+ public:
+  uint32_t GetDexPc() const {
+    return dex_pc_;
+  }
+
+  uint16_t GetTakenCount() const {
+    return taken_count_;
+  }
+
+  uint16_t GetNotTakenCount() const {
+    return not_taken_count_;
+  }
+
+ private:
+  uint32_t dex_pc_;
+  // The counts saturate, and like the inline cache counts they are updated
+  // without synchronization.
+  uint16_t taken_count_;
+  uint16_t not_taken_count_;
+
+  friend class ProfilingInfo;
+
+  DISALLOW_COPY_AND_ASSIGN(BranchCache);
+};
+
+// Number of back edges to a loop header, counted once the method is hot, to
+// find the loops that run long enough to need on-stack replacement.
+class LoopCache {
+ public:
+  uint32_t GetDexPc() const {
+    return dex_pc_;
+  }
+
+  // Whether the loop reached the OSR threshold. The OSR code of the method
+  // can be entered at the headers of the hot loops.
+  bool IsHot() const {
+    return is_hot_;
+  }
+
+  // Back edges counted since the method got hot, or since the loop last reached
+  // the OSR threshold.
+  uint16_t GetBackEdgeCount() const {
+    return back_edge_count_;
+  }
+
+  // Progress of the OSR compilation for the loop, cached here so that hot loops
+  // do not look up the OSR code at every back edge.
+  enum class OsrState : uint8_t {
+    kNone,        // No OSR compilation with an entry at the loop is pending.
+    kRequested,   // The loop got hot and requested an OSR compilation.
+    kCompiling,   // The OSR compilation in progress makes the loop an entry.
+    kReady,       // The OSR code of the method can be entered at the loop header.
+    kFailed,      // The OSR compilation did not produce an entry at the loop header.
+  };
+
+  OsrState GetOsrState() const {
+    return osr_state_;
+  }
+
+  void SetOsrState(OsrState state) {
+    osr_state_ = state;
+  }
+
+  bool HasOsrCode() const {
+    return osr_state_ == OsrState::kReady;
+  }
+
+ private:
+  uint32_t dex_pc_;
+  // Updated without synchronization, like the inline cache counts.
+  uint16_t back_edge_count_;
+  bool is_hot_;
+  // Only moved out of kNone by the mutators, the other transitions are made by
+  // the JIT code cache with its lock held.
+  OsrState osr_state_;
+
+  friend class ProfilingInfo;
+
+  DISALLOW_COPY_AND_ASSIGN(LoopCache);
+};
+
 /**
  * Profiling info for a method, created and filled by the interpreter once the
  * method is warm, and used by the compiler to drive optimizations.
@@ -92,6 +200,7 @@ class ProfilingInfo {
  public:
   // Create a ProfilingInfo for 'method'. Return whether it succeeded, or if it is
   // not needed in case the method does not have virtual/interface invocations.
+  // The IF instructions are only profiled when the baseline JIT tier is used.
   static bool Create(Thread* self, ArtMethod* method, bool retry_allocation)
       SHARED_REQUIRES(Locks::mutator_lock_);
 
@@ -102,6 +211,21 @@ class ProfilingInfo {
       REQUIRES(Roles::uninterruptible_)
       SHARED_REQUIRES(Locks::mutator_lock_);
 
+  // Add the direction taken by an executed IF instruction to the profile.
+  void AddBranchInfo(uint32_t dex_pc, bool taken);
+
+  // Add `count` back edges to the loop whose header is at `dex_pc`. Returns true
+  // if the loop reached `threshold` back edges, in which case it is marked hot and
+  // requests an OSR compilation. Loops which already requested one are not counted
+  // until the JIT code cache resets their OSR state.
+  bool AddLoopBackEdges(uint32_t dex_pc, uint16_t count, uint16_t threshold);
+
+  // Called when compiled code deoptimized at `dex_pc` of this method, so that
+  // the next compilation doesn't make the same assumption again. Returns whether
+  // the deoptimization came from a speculation on this profile: a branch that
+  // only went one way, or an invoke with an inline cache.
+  bool AddSpeculationFailure(uint32_t dex_pc);
+
   // NO_THREAD_SAFETY_ANALYSIS since we don't know what the callback requires.
   template<typename RootVisitorType>
   void VisitRoots(RootVisitorType& visitor) NO_THREAD_SAFETY_ANALYSIS {
@@ -120,6 +244,56 @@ class ProfilingInfo {
 
   InlineCache* GetInlineCache(uint32_t dex_pc);
 
+  // Returns null if the IF at `dex_pc` is not profiled.
+  BranchCache* GetBranchCache(uint32_t dex_pc);
+
+  size_t GetNumberOfBranchCaches() const {
+    return number_of_branch_caches_;
+  }
+
+  const BranchCache& GetBranchCacheAt(size_t i) const {
+    DCHECK_LT(i, number_of_branch_caches_);
+    return GetBranchCaches()[i];
+  }
+
+  // Returns null if `dex_pc` is not the target of a backward branch.
+  LoopCache* GetLoopCache(uint32_t dex_pc);
+
+  size_t GetNumberOfLoopCaches() const {
+    return number_of_loop_caches_;
+  }
+
+  const LoopCache& GetLoopCacheAt(size_t i) const {
+    DCHECK_LT(i, number_of_loop_caches_);
+    return GetLoopCaches()[i];
+  }
+
+  LoopCache& GetLoopCacheAt(size_t i) {
+    DCHECK_LT(i, number_of_loop_caches_);
+    return GetLoopCaches()[i];
+  }
+
+  // Called when the OSR code of the method is removed, so that its hot loops
+  // request a new OSR compilation.
+  void ResetLoopOsrStates();
+
+  // Called when an OSR compilation requested by the hot loops of the method is
+  // dropped before it starts, so that the loops request it again.
+  void ResetLoopOsrRequests();
+
+  // Number of times the compiled code of the method deoptimized because a
+  // speculation on the profile failed, see AddSpeculationFailure(). Once it gets
+  // too high, the compiler stops speculating for the method.
+  uint16_t GetDeoptimizationCount() const {
+    return deoptimization_count_;
+  }
+
+  void IncrementDeoptimizationCount() {
+    if (deoptimization_count_ != std::numeric_limits<uint16_t>::max()) {
+      deoptimization_count_++;
+    }
+  }
+
   bool IsMethodBeingCompiled(bool osr) const {
     return osr
         ? is_osr_method_being_compiled_
@@ -142,12 +316,40 @@ class ProfilingInfo {
     return saved_entry_point_;
   }
 
+  // Number of consecutive full code cache collections the compiled code of the
+  // method was used across. Guarded by the JIT code cache lock.
+  uint16_t GetSurvivedCollections() const {
+    return survived_collections_;
+  }
+
+  void IncrementSurvivedCollections() {
+    if (survived_collections_ != std::numeric_limits<uint16_t>::max()) {
+      survived_collections_++;
+    }
+  }
+
+  void ResetSurvivedCollections() {
+    survived_collections_ = 0;
+  }
+
+  // Whether the compiled code of the method, if any, is baseline code.
+  bool IsBaselineCode() const {
+    return is_baseline_code_;
+  }
+
+  void SetIsBaselineCode(bool value) {
+    is_baseline_code_ = value;
+  }
+
   void ClearGcRootsInInlineCaches() {
     for (size_t i = 0; i < number_of_inline_caches_; ++i) {
       InlineCache* cache = &cache_[i];
       memset(&cache->classes_[0],
              0,
              InlineCache::kIndividualCacheSize * sizeof(GcRoot<mirror::Class>));
+      // The counts are only meaningful along with their class.
+      memset(&cache->counts_[0], 0, InlineCache::kIndividualCacheSize * sizeof(uint32_t));
+      cache->megamorphic_count_ = 0;
     }
   }
 
@@ -167,10 +369,33 @@ class ProfilingInfo {
   }
 
  private:
-  ProfilingInfo(ArtMethod* method, const std::vector<uint32_t>& entries);
+  ProfilingInfo(ArtMethod* method,
+                const std::vector<uint32_t>& entries,
+                const std::vector<uint32_t>& branch_entries,
+                const std::vector<uint32_t>& loop_entries);
+
+  // The branch caches are allocated after the inline caches.
+  BranchCache* GetBranchCaches() {
+    return reinterpret_cast<BranchCache*>(&cache_[number_of_inline_caches_]);
+  }
+
+  const BranchCache* GetBranchCaches() const {
+    return reinterpret_cast<const BranchCache*>(&cache_[number_of_inline_caches_]);
+  }
+
+  // The loop caches are allocated after the branch caches.
+  LoopCache* GetLoopCaches() {
+    return reinterpret_cast<LoopCache*>(GetBranchCaches() + number_of_branch_caches_);
+  }
+
+  const LoopCache* GetLoopCaches() const {
+    return reinterpret_cast<const LoopCache*>(GetBranchCaches() + number_of_branch_caches_);
+  }
 
   // Number of instructions we are profiling in the ArtMethod.
   const uint32_t number_of_inline_caches_;
+  const uint32_t number_of_branch_caches_;
+  const uint32_t number_of_loop_caches_;
 
   // Method this profiling info is for.
   ArtMethod* const method_;
@@ -184,15 +409,27 @@ class ProfilingInfo {
   bool is_method_being_compiled_;
   bool is_osr_method_being_compiled_;
 
+  // Whether the last non-OSR code committed for the ArtMethod was compiled by the
+  // baseline tier, which keeps updating this profiling info. Guarded like the flags above.
+  bool is_baseline_code_;
+
   // When the compiler inlines the method associated to this ProfilingInfo,
   // it updates this counter so that the GC does not try to clear the inline caches.
   uint16_t current_inline_uses_;
 
+  // See GetSurvivedCollections().
+  uint16_t survived_collections_;
+
+  // See GetDeoptimizationCount().
+  uint16_t deoptimization_count_;
+
   // Entry point of the corresponding ArtMethod, while the JIT code cache
   // is poking for the liveness of compiled code.
   const void* saved_entry_point_;
 
-  // Dynamically allocated array of size `number_of_inline_caches_`.
+  // Dynamically allocated array of size `number_of_inline_caches_`, followed
+  // by `number_of_branch_caches_` branch caches and `number_of_loop_caches_`
+  // loop caches.
   InlineCache cache_[0];
 
   friend class jit::JitCodeCache;
@@ -23,6 +23,7 @@
 
 #include <memory>
 #include <sstream>
+#include <vector>
 
 #include "base/stringprintf.h"
 
@@ -40,6 +41,11 @@
 #include <sys/resource.h>
 #endif
 
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#endif
+
 #ifndef MAP_ANONYMOUS
 #define MAP_ANONYMOUS MAP_ANON
 #endif
@@ -594,6 +600,59 @@ void MemMap::MadviseDontNeedAndZero() {
   }
 }
 
+bool MemMap::AdviseHugePages() {
+  if (base_begin_ == nullptr && base_size_ == 0) {
+    return true;
+  }
+#if defined(MADV_HUGEPAGE)
+  if (madvise(base_begin_, base_size_, MADV_HUGEPAGE) != 0) {
+    PLOG(WARNING) << "madvise(MADV_HUGEPAGE) failed for " << name_;
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool MemMap::BindToNumaNode(uint8_t* begin, size_t size, size_t node) {
+  DCHECK(HasAddress(begin)) << begin;
+  DCHECK_LE(begin + size, End());
+  DCHECK_ALIGNED(begin, kPageSize);
+  DCHECK_ALIGNED(size, kPageSize);
+#if defined(__linux__) && defined(__NR_mbind)
+  // The kernel reads the node mask as an array of longs, which are pointer sized on Linux.
+  static constexpr size_t kBitsPerMaskWord = sizeof(uintptr_t) * kBitsPerByte;
+  std::vector<uintptr_t> node_mask(node / kBitsPerMaskWord + 1, 0U);
+  node_mask[node / kBitsPerMaskWord] |= static_cast<uintptr_t>(1U) << (node % kBitsPerMaskWord);
+  // The kernel expects the number of bits in the mask plus one.
+  const uintptr_t max_node = node_mask.size() * kBitsPerMaskWord + 1;
+  if (syscall(__NR_mbind, begin, size, MPOL_PREFERRED, node_mask.data(), max_node, 0) != 0) {
+    PLOG(WARNING) << "mbind(" << reinterpret_cast<void*>(begin) << ", " << size << ", " << node
+                  << ") failed for " << name_;
+    return false;
+  }
+  if (kIsDebugBuild) {
+    // Check the policy of the range without touching its pages.
+    int mode = -1;
+    CHECK_EQ(syscall(__NR_get_mempolicy, &mode, nullptr, 0, begin, MPOL_F_ADDR), 0);
+    CHECK_EQ(mode, MPOL_PREFERRED) << name_;
+  }
+  return true;
+#else
+  UNUSED(begin, size, node);
+  return false;
+#endif
+}
+
+void MemMap::ResetNumaPolicy() {
+#if defined(__linux__) && defined(__NR_mbind)
+  if (syscall(__NR_mbind, base_begin_, base_size_, MPOL_DEFAULT, nullptr, 0, 0) != 0) {
+    PLOG(WARNING) << "mbind(MPOL_DEFAULT) failed for " << name_;
+  }
+#endif
+}
+
 bool MemMap::Sync() {
   bool result;
   if (redzone_size_ != 0) {
@@ -52,6 +52,9 @@ static constexpr bool kMadviseZeroes = false;
 // Otherwise, calls might see uninitialized values.
 class MemMap {
  public:
+  // The size of a transparent huge page, a PMD mapping with 4 KB pages.
+  static constexpr size_t kHugePageSize = 2 * MB;
+
   // Request an anonymous region of length 'byte_count' and a requested base address.
   // Use null as the requested base address if you don't care.
   // "reuse" allows re-mapping an address range from an existing mapping.
@@ -132,6 +135,18 @@ class MemMap {
 
   void MadviseDontNeedAndZero();
 
+  // Asks the kernel to back the map with transparent huge pages. Only the kHugePageSize aligned
+  // parts of the map can get huge pages. Returns false if the kernel doesn't support them.
+  bool AdviseHugePages();
+
+  // Sets the preferred NUMA node of the pages in [begin, begin + size), which must be a page
+  // aligned range of this map. Pages that are already resident are not migrated. Returns false if
+  // the kernel doesn't support NUMA memory policies.
+  bool BindToNumaNode(uint8_t* begin, size_t size, size_t node);
+
+  // Goes back to the default NUMA policy of the process for the whole map.
+  void ResetNumaPolicy();
+
   int GetProtect() const {
     return prot_;
   }
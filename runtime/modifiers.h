@@ -68,6 +68,9 @@ static constexpr uint32_t kAccCompileDontBother =     0x01000000;  // method (ru
 // Set by the verifier for a method that could not be verified to follow structured locking.
 static constexpr uint32_t kAccMustCountLocks =        0x02000000;  // method (runtime)
 
+// Set by the class hierarchy analysis for a virtual method which no loaded class overrides.
+static constexpr uint32_t kAccSingleImplementation =  0x08000000;  // method (runtime)
+
 // Special runtime-only flags.
 // Interface and all its super-interfaces with default methods have been recursively initialized.
 static constexpr uint32_t kAccRecursivelyInitialized    = 0x20000000;
@@ -114,6 +114,18 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
       .Define("-XX:ForegroundHeapGrowthMultiplier=_")
           .WithType<double>().WithRange(0.1, 1.0)
           .IntoKey(M::ForegroundHeapGrowthMultiplier)
+      .Define("-XX:RegionSpaceEvacuateLivePercent=_")
+          .WithType<unsigned int>().WithRange(0, 100)
+          .IntoKey(M::RegionSpaceEvacuateLivePercent)
+      .Define("-XX:UseTransparentHugePages")
+          .WithValue(true)
+          .IntoKey(M::UseTransparentHugePages)
+      .Define("-XX:MaxGcPause=_")  // in ms
+          .WithType<MillisecondsToNanoseconds>()  // store as ns
+          .IntoKey(M::MaxGcPause)
+      .Define("-XX:MaxGcCpuPercent=_")
+          .WithType<unsigned int>().WithRange(0, 100)
+          .IntoKey(M::MaxGcCpuPercent)
       .Define("-XX:ParallelGCThreads=_")
           .WithType<unsigned int>()
           .IntoKey(M::ParallelGCThreads)
@@ -166,6 +178,9 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
       .Define("-Xjitwarmupthreshold:_")
           .WithType<unsigned int>()
           .IntoKey(M::JITWarmupThreshold)
+      .Define("-Xjitbaselinethreshold:_")
+          .WithType<unsigned int>()
+          .IntoKey(M::JITBaselineThreshold)
       .Define("-Xjitosrthreshold:_")
           .WithType<unsigned int>()
           .IntoKey(M::JITOsrThreshold)
@@ -175,9 +190,15 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
       .Define("-Xjittransitionweight:_")
           .WithType<unsigned int>()
           .IntoKey(M::JITInvokeTransitionWeight)
+      .Define("-Xjitthreads:_")
+          .WithType<unsigned int>()
+          .IntoKey(M::JITThreadCount)
       .Define("-Xjitsaveprofilinginfo")
           .WithValue(true)
           .IntoKey(M::JITSaveProfilingInfo)
+      .Define("-Xjitwarmstartfile:_")
+          .WithType<std::string>()
+          .IntoKey(M::JITWarmStartFile)
       .Define("-XX:HspaceCompactForOOMMinIntervalMs=_")  // in ms
           .WithType<MillisecondsToNanoseconds>()  // store as ns
           .IntoKey(M::HSpaceCompactForOOMMinIntervalsMs)
@@ -214,6 +235,12 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
       .Define("-XX:LargeObjectThreshold=_")
           .WithType<Memory<1>>()
           .IntoKey(M::LargeObjectThreshold)
+      .Define("-XX:AllocationSamplingInterval=_")
+          .WithType<Memory<1>>()
+          .IntoKey(M::AllocationSamplingInterval)
+      .Define("-XX:AllocationProfileFile=_")
+          .WithType<std::string>()
+          .IntoKey(M::AllocationProfileFile)
       .Define("-XX:BackgroundGC=_")
           .WithType<BackgroundGcOption>()
           .IntoKey(M::BackgroundGc)
@@ -673,6 +700,11 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -Xgc:[no]postsweepingverify_rosalloc\n");
   UsageMessage(stream, "  -Xgc:[no]postverify_rosalloc\n");
   UsageMessage(stream, "  -Xgc:[no]presweepingverify\n");
+  UsageMessage(stream, "  -Xgc:[no]generational_cc\n");
+  UsageMessage(stream, "  -XX:RegionSpaceEvacuateLivePercent=integervalue\n");
+  UsageMessage(stream, "  -XX:UseTransparentHugePages\n");
+  UsageMessage(stream, "  -XX:MaxGcPause=integervalue\n");
+  UsageMessage(stream, "  -XX:MaxGcCpuPercent=integervalue\n");
   UsageMessage(stream, "  -Ximage:filename\n");
   UsageMessage(stream, "  -Xbootclasspath-locations:bootclasspath\n"
                        "     (override the dex locations of the -Xbootclasspath files)\n");
@@ -689,6 +721,8 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -XX:BackgroundGC=none\n");
   UsageMessage(stream, "  -XX:LargeObjectSpace={disabled,map,freelist}\n");
   UsageMessage(stream, "  -XX:LargeObjectThreshold=N\n");
+  UsageMessage(stream, "  -XX:AllocationSamplingInterval=N\n");
+  UsageMessage(stream, "  -XX:AllocationProfileFile=filename\n");
   UsageMessage(stream, "  -XX:DumpNativeStackOnSigQuit=booleanvalue\n");
   UsageMessage(stream, "  -Xmethod-trace\n");
   UsageMessage(stream, "  -Xmethod-trace-file:filename");
@@ -712,8 +746,11 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -Xjitinitialsize:N\n");
   UsageMessage(stream, "  -Xjitmaxsize:N\n");
   UsageMessage(stream, "  -Xjitwarmupthreshold:integervalue\n");
+  UsageMessage(stream, "  -Xjitbaselinethreshold:integervalue\n");
   UsageMessage(stream, "  -Xjitosrthreshold:integervalue\n");
   UsageMessage(stream, "  -Xjitprithreadweight:integervalue\n");
+  UsageMessage(stream, "  -Xjitthreads:integervalue\n");
+  UsageMessage(stream, "  -Xjitwarmstartfile:filename\n");
   UsageMessage(stream, "  -X[no]relocate\n");
   UsageMessage(stream, "  -X[no]dex2oat (Whether to invoke dex2oat on the application)\n");
   UsageMessage(stream, "  -X[no]image-dex2oat (Whether to create and use a boot image)\n");
@@ -25,6 +25,7 @@
 #include "handle_scope-inl.h"
 #include "jit/jit.h"
 #include "jit/jit_code_cache.h"
+#include "jit/profiling_info.h"
 #include "mirror/class-inl.h"
 #include "mirror/class_loader.h"
 #include "mirror/throwable.h"
@@ -290,7 +291,9 @@ class DeoptimizeStackVisitor FINAL : public StackVisitor {
         single_frame_deopt_(single_frame),
         single_frame_done_(false),
         single_frame_deopt_method_(nullptr),
-        single_frame_deopt_quick_method_header_(nullptr) {
+        single_frame_deopt_quick_method_header_(nullptr),
+        deopt_site_method_(nullptr),
+        deopt_site_dex_pc_(DexFile::kDexNoIndex) {
   }
 
   ArtMethod* GetSingleFrameDeoptMethod() const {
@@ -301,6 +304,15 @@ class DeoptimizeStackVisitor FINAL : public StackVisitor {
     return single_frame_deopt_quick_method_header_;
   }
 
+  // The method and dex pc of the innermost frame, where the deoptimization happened.
+  ArtMethod* GetDeoptSiteMethod() const {
+    return deopt_site_method_;
+  }
+
+  uint32_t GetDeoptSiteDexPc() const {
+    return deopt_site_dex_pc_;
+  }
+
   bool VisitFrame() OVERRIDE SHARED_REQUIRES(Locks::mutator_lock_) {
     exception_handler_->SetHandlerFrameDepth(GetFrameDepth());
     ArtMethod* method = GetMethod();
@@ -352,6 +364,8 @@ class DeoptimizeStackVisitor FINAL : public StackVisitor {
       if (prev_shadow_frame_ != nullptr) {
         prev_shadow_frame_->SetLink(new_frame);
       } else {
+        deopt_site_method_ = method;
+        deopt_site_dex_pc_ = new_frame->GetDexPC();
         // Will be popped after the long jump after DeoptimizeStack(),
         // right before interpreter::EnterInterpreterFromDeoptimize().
         stacked_shadow_frame_pushed_ = true;
@@ -478,6 +492,8 @@ class DeoptimizeStackVisitor FINAL : public StackVisitor {
   bool single_frame_done_;
   ArtMethod* single_frame_deopt_method_;
   const OatQuickMethodHeader* single_frame_deopt_quick_method_header_;
+  ArtMethod* deopt_site_method_;
+  uint32_t deopt_site_dex_pc_;
 
   DISALLOW_COPY_AND_ASSIGN(DeoptimizeStackVisitor);
 };
@@ -510,8 +526,25 @@ void QuickExceptionHandler::DeoptimizeSingleFrame() {
   ArtMethod* deopt_method = visitor.GetSingleFrameDeoptMethod();
   DCHECK(deopt_method != nullptr);
   if (Runtime::Current()->UseJitCompilation()) {
-    Runtime::Current()->GetJit()->GetCodeCache()->InvalidateCompiledCodeFor(
-        deopt_method, visitor.GetSingleFrameDeoptQuickMethodHeader());
+    jit::JitCodeCache* code_cache = Runtime::Current()->GetJit()->GetCodeCache();
+    const OatQuickMethodHeader* deopt_header = visitor.GetSingleFrameDeoptQuickMethodHeader();
+    // Baseline code only deoptimizes at a loop header, for the interpreter to enter the OSR
+    // code of the loop. It did not speculate and stays valid.
+    if (!code_cache->IsBaselineCode(deopt_header)) {
+      // Tell the profile which speculation failed so that the method does not get compiled
+      // with it again, and count the failure against the compiled method. Other
+      // deoptimizations, like the ones of bounds check elimination, are not profile driven.
+      ProfilingInfo* deopt_site_info =
+          visitor.GetDeoptSiteMethod()->GetProfilingInfo(sizeof(void*));
+      if (deopt_site_info != nullptr &&
+          deopt_site_info->AddSpeculationFailure(visitor.GetDeoptSiteDexPc())) {
+        ProfilingInfo* profiling_info = deopt_method->GetProfilingInfo(sizeof(void*));
+        if (profiling_info != nullptr) {
+          profiling_info->IncrementDeoptimizationCount();
+        }
+      }
+      code_cache->InvalidateCompiledCodeFor(deopt_method, deopt_header);
+    }
   } else {
     // Transfer the code to interpreter.
     Runtime::Current()->GetInstrumentation()->UpdateMethodsCode(
@@ -70,6 +70,7 @@
 #include "experimental_flags.h"
 #include "fault_handler.h"
 #include "gc/accounting/card_table-inl.h"
+#include "gc/allocation_sampler.h"
 #include "gc/heap.h"
 #include "gc/space/image_space.h"
 #include "gc/space/space-inl.h"
@@ -232,6 +233,7 @@ Runtime::Runtime()
       is_low_memory_mode_(false),
       safe_mode_(false),
       dump_native_stack_on_sig_quit_(true),
+      allocation_sampling_interval_(0),
       pruned_dalvik_cache_(false),
       // Initially assume we perceive jank in case the process state is never updated.
       process_state_(kProcessStateJankPerceptible),
@@ -749,6 +751,11 @@ void Runtime::InitNonZygoteOrPostFork(
   // before fork aren't attributed to an app.
   heap_->ResetGcPerformanceInfo();
 
+  // Start the allocation sampling after the fork so that the zygote's allocations are not
+  // attributed to the app.
+  if (allocation_sampling_interval_ != 0) {
+    gc::AllocationSampler::SetSamplingEnabled(true, allocation_sampling_interval_);
+  }
 
   if (!is_system_server &&
       !safe_mode_ &&
@@ -962,6 +969,8 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   dex2oat_enabled_ = runtime_options.GetOrDefault(Opt::Dex2Oat);
   image_dex2oat_enabled_ = runtime_options.GetOrDefault(Opt::ImageDex2Oat);
   dump_native_stack_on_sig_quit_ = runtime_options.GetOrDefault(Opt::DumpNativeStackOnSigQuit);
+  allocation_sampling_interval_ = runtime_options.GetOrDefault(Opt::AllocationSamplingInterval);
+  allocation_profile_file_ = runtime_options.ReleaseOrDefault(Opt::AllocationProfileFile);
 
   vfprintf_ = runtime_options.GetOrDefault(Opt::HookVfprintf);
   exit_ = runtime_options.GetOrDefault(Opt::HookExit);
@@ -1040,6 +1049,11 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
                        xgc_option.verify_pre_sweeping_rosalloc_,
                        xgc_option.verify_post_gc_rosalloc_,
                        xgc_option.gcstress_,
+                       xgc_option.generational_cc_,
+                       runtime_options.GetOrDefault(Opt::RegionSpaceEvacuateLivePercent),
+                       runtime_options.GetOrDefault(Opt::UseTransparentHugePages),
+                       runtime_options.GetOrDefault(Opt::MaxGcPause),
+                       runtime_options.GetOrDefault(Opt::MaxGcCpuPercent),
                        runtime_options.GetOrDefault(Opt::EnableHSpaceCompactForOOM),
                        runtime_options.GetOrDefault(Opt::HSpaceCompactForOOMMinIntervalsMs));
 
@@ -1423,6 +1437,15 @@ void Runtime::DumpForSigQuit(std::ostream& os) {
   GetInternTable()->DumpForSigQuit(os);
   GetJavaVM()->DumpForSigQuit(os);
   GetHeap()->DumpForSigQuit(os);
+  if (!allocation_profile_file_.empty()) {
+    ScopedObjectAccess soa(Thread::Current());
+    std::string error_msg;
+    if (GetHeap()->DumpAllocationProfile(allocation_profile_file_, &error_msg)) {
+      os << "Wrote allocation profile to " << allocation_profile_file_ << "\n";
+    } else {
+      os << "Failed to write allocation profile: " << error_msg << "\n";
+    }
+  }
   oat_file_manager_->DumpForSigQuit(os);
   if (GetJit() != nullptr) {
     GetJit()->DumpForSigQuit(os);
@@ -623,6 +623,10 @@ class Runtime {
     return dump_native_stack_on_sig_quit_;
   }
 
+  const std::string& GetAllocationProfileFile() const {
+    return allocation_profile_file_;
+  }
+
   bool GetPrunedDalvikCache() const {
     return pruned_dalvik_cache_;
   }
@@ -873,6 +877,13 @@ class Runtime {
   // Whether threads should dump their native stack on SIGQUIT.
   bool dump_native_stack_on_sig_quit_;
 
+  // The mean number of bytes between allocation samples, 0 if the sampling is not enabled at
+  // startup.
+  size_t allocation_sampling_interval_;
+
+  // Where the allocation profile is written on SIGQUIT, if not empty.
+  std::string allocation_profile_file_;
+
   // Whether the dalvik cache was pruned when initializing the runtime.
   bool pruned_dalvik_cache_;
 
@@ -45,6 +45,7 @@
 #include "gc/accounting/card_table-inl.h"
 #include "gc/accounting/heap_bitmap-inl.h"
 #include "gc/allocator/rosalloc.h"
+#include "gc/allocation_sampler.h"
 #include "gc/heap.h"
 #include "gc/space/space-inl.h"
 #include "handle_scope-inl.h"
@@ -739,6 +740,9 @@ bool Thread::Init(ThreadList* thread_list, JavaVMExt* java_vm, JNIEnvExt* jni_en
   }
 
   thread_list->Register(this);
+  // After joining the thread list: enabling the allocation sampling concurrently either starts the
+  // countdown of this thread, or is seen enabled here.
+  gc::AllocationSampler::InitThread(this);
   return true;
 }
 
@@ -2582,6 +2586,9 @@ void Thread::DumpThreadOffset(std::ostream& os, uint32_t offset) {
   QUICK_ENTRY_POINT_INFO(pReadBarrierMark)
   QUICK_ENTRY_POINT_INFO(pReadBarrierSlow)
   QUICK_ENTRY_POINT_INFO(pReadBarrierForRootSlow)
+  QUICK_ENTRY_POINT_INFO(pJitUpdateHotness)
+  QUICK_ENTRY_POINT_INFO(pJitUpdateInlineCache)
+  QUICK_ENTRY_POINT_INFO(pJitUpdateBranchProfile)
 #undef QUICK_ENTRY_POINT_INFO
 
   os << offset;
@@ -2934,10 +2941,25 @@ void Thread::SetStackEndForStackOverflow() {
 
 void Thread::SetTlab(uint8_t* start, uint8_t* end) {
   DCHECK_LE(start, end);
+  // Carry the allocation sampling countdown over to the new TLAB.
+  const ssize_t bytes_until_alloc_sample = GetBytesUntilAllocSample();
   tlsPtr_.thread_local_start = start;
   tlsPtr_.thread_local_pos  = tlsPtr_.thread_local_start;
   tlsPtr_.thread_local_end = end;
+  tlsPtr_.thread_local_limit = end;
   tlsPtr_.thread_local_objects = 0;
+  if (Runtime::Current()->GetHeap()->IsAllocSamplingEnabled()) {
+    SetBytesUntilAllocSample(bytes_until_alloc_sample);
+  } else {
+    tlsPtr_.bytes_until_alloc_sample = 0;
+  }
+}
+
+void Thread::SetBytesUntilAllocSample(ssize_t bytes) {
+  const size_t capacity = TlabRemainingCapacity();
+  const size_t bytes_in_tlab = bytes > 0 ? std::min(static_cast<size_t>(bytes), capacity) : 0u;
+  tlsPtr_.thread_local_end = tlsPtr_.thread_local_pos + bytes_in_tlab;
+  tlsPtr_.bytes_until_alloc_sample = bytes - static_cast<ssize_t>(bytes_in_tlab);
 }
 
 bool Thread::HasTlab() const {
@@ -49,6 +49,7 @@ namespace art {
 namespace gc {
 namespace accounting {
   template<class T> class AtomicStack;
+  template<class T> class WorkStealingDeque;
 }  // namespace accounting
 namespace collector {
   class SemiSpace;
@@ -244,6 +245,15 @@ class Thread {
     tlsPtr_.thread_local_mark_stack = stack;
   }
 
+  // The work-stealing deque of the thread while it is a parallel marking thread of the concurrent
+  // copying collector, null otherwise.
+  gc::accounting::WorkStealingDeque<mirror::Object>* GetThreadLocalMarkDeque() {
+    return tlsPtr_.thread_local_mark_deque;
+  }
+  void SetThreadLocalMarkDeque(gc::accounting::WorkStealingDeque<mirror::Object>* deque) {
+    tlsPtr_.thread_local_mark_deque = deque;
+  }
+
   // Called when thread detected that the thread_suspend_count_ was non-zero. Gives up share of
   // mutator_lock_ and waits until it is resumed and thread_suspend_count_ is zero.
   void FullSuspendCheck()
@@ -981,6 +991,15 @@ class Thread {
 
   // Returns the remaining space in the TLAB.
   size_t TlabSize() const;
+  // Returns the remaining space in the TLAB, including the part past the allocation sample point.
+  size_t TlabRemainingCapacity() const {
+    return tlsPtr_.thread_local_limit - tlsPtr_.thread_local_pos;
+  }
+  // Moves the end of the TLAB past the allocation sample point, keeping the countdown.
+  void ExpandTlab() {
+    tlsPtr_.bytes_until_alloc_sample -= tlsPtr_.thread_local_limit - tlsPtr_.thread_local_end;
+    tlsPtr_.thread_local_end = tlsPtr_.thread_local_limit;
+  }
   // Doesn't check that there is room.
   mirror::Object* AllocTlab(size_t bytes);
   void SetTlab(uint8_t* start, uint8_t* end);
@@ -1019,7 +1038,7 @@ class Thread {
   void RevokeThreadLocalAllocationStack();
 
   size_t GetThreadLocalBytesAllocated() const {
-    return tlsPtr_.thread_local_end - tlsPtr_.thread_local_start;
+    return tlsPtr_.thread_local_limit - tlsPtr_.thread_local_start;
   }
 
   size_t GetThreadLocalObjectsAllocated() const {
@@ -1034,6 +1053,32 @@ class Thread {
     tlsPtr_.rosalloc_runs[index] = run;
   }
 
+  void* GetRosAllocMagazines() const {
+    return tlsPtr_.rosalloc_magazines;
+  }
+
+  void SetRosAllocMagazines(void* magazines) {
+    tlsPtr_.rosalloc_magazines = magazines;
+  }
+
+  // The number of bytes this thread may allocate before the allocation sampler takes its next
+  // sample, zero or negative once the sample point is reached. While sampling, the end of the TLAB
+  // is moved back to the sample point so that the compiled code fast path calls into the runtime
+  // there, and the bytes allocated from the TLAB are counted by its position.
+  ssize_t GetBytesUntilAllocSample() const {
+    return (tlsPtr_.thread_local_end - tlsPtr_.thread_local_pos) +
+        tlsPtr_.bytes_until_alloc_sample;
+  }
+
+  // Starts a countdown of `bytes` from the current TLAB position.
+  void SetBytesUntilAllocSample(ssize_t bytes);
+
+  // Stops the countdown and gives the TLAB its full size back.
+  void ClearBytesUntilAllocSample() {
+    tlsPtr_.thread_local_end = tlsPtr_.thread_local_limit;
+    tlsPtr_.bytes_until_alloc_sample = 0;
+  }
+
   bool ProtectStack(bool fatal_on_error = true);
   bool UnprotectStack();
 
@@ -1358,7 +1403,8 @@ class Thread {
       mterp_current_ibase(nullptr), mterp_default_ibase(nullptr), mterp_alt_ibase(nullptr),
       thread_local_alloc_stack_top(nullptr), thread_local_alloc_stack_end(nullptr),
       nested_signal_state(nullptr), flip_function(nullptr), method_verifier(nullptr),
-      thread_local_mark_stack(nullptr) {
+      thread_local_mark_stack(nullptr), rosalloc_magazines(nullptr), bytes_until_alloc_sample(0),
+      thread_local_limit(nullptr), thread_local_mark_deque(nullptr) {
       std::fill(held_mutexes, held_mutexes + kLockLevelCount, nullptr);
     }
 
@@ -1502,6 +1548,20 @@ class Thread {
 
     // Thread-local mark stack for the concurrent copying collector.
     gc::accounting::AtomicStack<mirror::Object>* thread_local_mark_stack;
+
+    // The RosAlloc magazines for the size brackets without thread-local runs.
+    void* rosalloc_magazines;
+
+    // Bytes left until the next allocation sample past thread_local_end, see
+    // GetBytesUntilAllocSample().
+    ssize_t bytes_until_alloc_sample;
+
+    // The end of the TLAB. thread_local_end is before it while the allocation sampler has moved
+    // it back to the next sample point.
+    uint8_t* thread_local_limit;
+
+    // Work-stealing deque of a parallel marking thread of the concurrent copying collector.
+    gc::accounting::WorkStealingDeque<mirror::Object>* thread_local_mark_deque;
   } tlsPtr_;
 
   // Guards the 'interrupted_' and 'wait_monitor_' members.
@@ -1026,6 +1026,44 @@ std::string GetSchedulerGroupName(pid_t tid) {
   return "";
 }
 
+std::vector<size_t> GetOnlineNumaNodes() {
+  // /sys/devices/system/node/online looks like "0" or "0-1" or "0,2-3". The node IDs need not be
+  // contiguous, for instance when a node has no memory.
+  std::vector<size_t> nodes;
+  std::string online;
+  if (ReadFileToString("/sys/devices/system/node/online", &online)) {
+    std::vector<std::string> ranges;
+    Split(Trim(online), ',', &ranges);
+    for (const std::string& range : ranges) {
+      std::vector<std::string> bounds;
+      Split(range, '-', &bounds);
+      if (bounds.empty()) {
+        continue;
+      }
+      size_t first = strtoul(bounds.front().c_str(), nullptr, 10);
+      size_t last = strtoul(bounds.back().c_str(), nullptr, 10);
+      for (size_t node = first; node <= last; ++node) {
+        nodes.push_back(node);
+      }
+    }
+  }
+  if (nodes.empty()) {
+    nodes.push_back(0U);
+  }
+  return nodes;
+}
+
+size_t GetCurrentNumaNode() {
+#if defined(__linux__) && defined(__NR_getcpu)
+  unsigned cpu = 0U;
+  unsigned node = 0U;
+  if (syscall(__NR_getcpu, &cpu, &node, nullptr) == 0) {
+    return node;
+  }
+#endif
+  return 0U;
+}
+
 #if defined(__linux__)
 
 ALWAYS_INLINE
@@ -238,6 +238,13 @@ void GetTaskStats(pid_t tid, char* state, int* utime, int* stime, int* task_cpu)
 // Returns the name of the scheduler group for the given thread the current process, or the empty string.
 std::string GetSchedulerGroupName(pid_t tid);
 
+// Returns the IDs of the online NUMA nodes of the machine in increasing order, just node 0 if they
+// can't be determined.
+std::vector<size_t> GetOnlineNumaNodes();
+
+// Returns the NUMA node of the CPU the calling thread is running on, 0 if it can't be determined.
+size_t GetCurrentNumaNode();
+
 // Sets the name of the current thread. The name may be truncated to an
 // implementation-defined limit.
 void SetThreadName(const char* thread_name);
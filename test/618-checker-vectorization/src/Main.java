@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+
+  public static void assertIntEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  public static void assertLongEquals(long expected, long result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  public static void assertFloatEquals(float expected, float result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  /// CHECK-START-X86_64: void Main.addConstant(int[]) loop_optimization (before)
+  /// CHECK-NOT:                    VecLoad
+
+  /// CHECK-START-X86_64: void Main.addConstant(int[]) loop_optimization (after)
+  /// CHECK-DAG: <<Rep:d\d+>>       VecReplicateScalar
+  /// CHECK-DAG: <<Load:d\d+>>      VecLoad
+  /// CHECK-DAG: <<Add:d\d+>>       VecAdd [<<Load>>,<<Rep>>]
+  /// CHECK-DAG:                    VecStore [{{l\d+}},{{i\d+}},<<Add>>]
+
+  /// CHECK-START-ARM64: void Main.addConstant(int[]) loop_optimization (after)
+  /// CHECK-DAG: <<Rep:d\d+>>       VecReplicateScalar
+  /// CHECK-DAG: <<Load:d\d+>>      VecLoad
+  /// CHECK-DAG: <<Add:d\d+>>       VecAdd [<<Load>>,<<Rep>>]
+  /// CHECK-DAG:                    VecStore [{{l\d+}},{{i\d+}},<<Add>>]
+
+  public static void addConstant(int[] a) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] += 3;
+    }
+  }
+
+  // The narrowing conversion back to byte is dropped in the vector loop.
+
+  /// CHECK-START-X86_64: void Main.xorBytes(byte[], byte) loop_optimization (after)
+  /// CHECK-DAG: <<Load:d\d+>>      VecLoad
+  /// CHECK-DAG: <<Xor:d\d+>>       VecXor [<<Load>>,{{d\d+}}]
+  /// CHECK-DAG:                    VecStore [{{l\d+}},{{i\d+}},<<Xor>>]
+
+  /// CHECK-START-ARM64: void Main.xorBytes(byte[], byte) loop_optimization (after)
+  /// CHECK-DAG: <<Load:d\d+>>      VecLoad
+  /// CHECK-DAG: <<Xor:d\d+>>       VecXor [<<Load>>,{{d\d+}}]
+  /// CHECK-DAG:                    VecStore [{{l\d+}},{{i\d+}},<<Xor>>]
+
+  public static void xorBytes(byte[] a, byte x) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] ^= x;
+    }
+  }
+
+  /// CHECK-START-X86_64: void Main.scaleFloats(float[], float) loop_optimization (after)
+  /// CHECK-DAG: <<Load:d\d+>>      VecLoad
+  /// CHECK-DAG: <<Mul:d\d+>>       VecMul [<<Load>>,{{d\d+}}]
+  /// CHECK-DAG:                    VecStore [{{l\d+}},{{i\d+}},<<Mul>>]
+
+  /// CHECK-START-ARM64: void Main.scaleFloats(float[], float) loop_optimization (after)
+  /// CHECK-DAG: <<Load:d\d+>>      VecLoad
+  /// CHECK-DAG: <<Mul:d\d+>>       VecMul [<<Load>>,{{d\d+}}]
+  /// CHECK-DAG:                    VecStore [{{l\d+}},{{i\d+}},<<Mul>>]
+
+  public static void scaleFloats(float[] a, float s) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] *= s;
+    }
+  }
+
+  /// CHECK-START-X86_64: void Main.mulChars(char[], char) loop_optimization (after)
+  /// CHECK-DAG: <<Load:d\d+>>      VecLoad
+  /// CHECK-DAG: <<Mul:d\d+>>       VecMul [<<Load>>,{{d\d+}}]
+  /// CHECK-DAG:                    VecStore [{{l\d+}},{{i\d+}},<<Mul>>]
+
+  /// CHECK-START-ARM64: void Main.mulChars(char[], char) loop_optimization (after)
+  /// CHECK-DAG: <<Load:d\d+>>      VecLoad
+  /// CHECK-DAG: <<Mul:d\d+>>       VecMul [<<Load>>,{{d\d+}}]
+  /// CHECK-DAG:                    VecStore [{{l\d+}},{{i\d+}},<<Mul>>]
+
+  public static void mulChars(char[] a, char m) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] *= m;
+    }
+  }
+
+  // The sum is accumulated lane-wise, and the lanes are added up after the vector loop.
+
+  /// CHECK-START-X86_64: int Main.sumInts(int[]) loop_optimization (after)
+  /// CHECK-DAG: <<Zero:d\d+>>      VecReplicateScalar
+  /// CHECK-DAG: <<Acc:d\d+>>       Phi [<<Zero>>,<<Add:d\d+>>] loop:<<Loop:B\d+>>
+  /// CHECK-DAG: <<Load:d\d+>>      VecLoad                     loop:<<Loop>>
+  /// CHECK-DAG: <<Add>>            VecAdd [<<Acc>>,<<Load>>]   loop:<<Loop>>
+  /// CHECK-DAG:                    VecReduce [<<Acc>>]
+
+  /// CHECK-START-ARM64: int Main.sumInts(int[]) loop_optimization (after)
+  /// CHECK-DAG: <<Zero:d\d+>>      VecReplicateScalar
+  /// CHECK-DAG: <<Acc:d\d+>>       Phi [<<Zero>>,<<Add:d\d+>>] loop:<<Loop:B\d+>>
+  /// CHECK-DAG: <<Load:d\d+>>      VecLoad                     loop:<<Loop>>
+  /// CHECK-DAG: <<Add>>            VecAdd [<<Acc>>,<<Load>>]   loop:<<Loop>>
+  /// CHECK-DAG:                    VecReduce [<<Acc>>]
+
+  public static int sumInts(int[] a) {
+    int sum = 0;
+    for (int i = 0; i < a.length; i++) {
+      sum += a[i];
+    }
+    return sum;
+  }
+
+  /// CHECK-START-X86_64: long Main.sumLongs(long[]) loop_optimization (after)
+  /// CHECK-DAG: <<Load:d\d+>>      VecLoad
+  /// CHECK-DAG:                    VecAdd [{{d\d+}},<<Load>>]
+  /// CHECK-DAG:                    VecReduce
+
+  /// CHECK-START-ARM64: long Main.sumLongs(long[]) loop_optimization (after)
+  /// CHECK-DAG: <<Load:d\d+>>      VecLoad
+  /// CHECK-DAG:                    VecAdd [{{d\d+}},<<Load>>]
+  /// CHECK-DAG:                    VecReduce
+
+  public static long sumLongs(long[] a) {
+    long sum = 0;
+    for (int i = 0; i < a.length; i++) {
+      sum += a[i];
+    }
+    return sum;
+  }
+
+  // Loops not starting at 0, or accessing other elements than the induction, are not
+  // vectorized.
+
+  /// CHECK-START-X86_64: void Main.prefixSum(int[]) loop_optimization (after)
+  /// CHECK-NOT:                    VecLoad
+
+  /// CHECK-START-ARM64: void Main.prefixSum(int[]) loop_optimization (after)
+  /// CHECK-NOT:                    VecLoad
+
+  public static void prefixSum(int[] a) {
+    for (int i = 1; i < a.length; i++) {
+      a[i] += a[i - 1];
+    }
+  }
+
+  /// CHECK-START-X86_64: void Main.shiftLeft(int[]) loop_optimization (after)
+  /// CHECK-NOT:                    VecLoad
+
+  /// CHECK-START-ARM64: void Main.shiftLeft(int[]) loop_optimization (after)
+  /// CHECK-NOT:                    VecLoad
+
+  public static void shiftLeft(int[] a) {
+    for (int i = 0; i < a.length - 1; i++) {
+      a[i] = a[i + 1];
+    }
+  }
+
+  public static void main(String[] args) {
+    // Lengths around multiples of the vector lengths, to exercise the cleanup loops.
+    for (int n = 0; n <= 37; n++) {
+      int[] ints = new int[n];
+      long[] longs = new long[n];
+      byte[] bytes = new byte[n];
+      char[] chars = new char[n];
+      float[] floats = new float[n];
+      for (int i = 0; i < n; i++) {
+        ints[i] = i * 1000 - 7;
+        longs[i] = (long) i << 33;
+        bytes[i] = (byte) (i * 13);
+        chars[i] = (char) (i * 4099);
+        floats[i] = i + 0.5f;
+      }
+
+      addConstant(ints);
+      xorBytes(bytes, (byte) 0x5a);
+      scaleFloats(floats, 2.0f);
+      mulChars(chars, (char) 7);
+      int int_sum = 0;
+      long long_sum = 0;
+      for (int i = 0; i < n; i++) {
+        assertIntEquals(i * 1000 - 4, ints[i]);
+        assertIntEquals((byte) ((i * 13) ^ 0x5a), bytes[i]);
+        assertFloatEquals((i + 0.5f) * 2.0f, floats[i]);
+        assertIntEquals((char) (i * 4099 * 7), chars[i]);
+        int_sum += ints[i];
+        long_sum += longs[i];
+      }
+      assertIntEquals(int_sum, sumInts(ints));
+      assertLongEquals(long_sum, sumLongs(longs));
+
+      prefixSum(ints);
+      int prefix = 0;
+      for (int i = 0; i < n; i++) {
+        prefix += i * 1000 - 4;
+        assertIntEquals(prefix, ints[i]);
+      }
+
+      int[] copy = ints.clone();
+      shiftLeft(ints);
+      for (int i = 0; i < n - 1; i++) {
+        assertIntEquals(copy[i + 1], ints[i]);
+      }
+    }
+    System.out.println("passed");
+  }
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+
+  public static void assertIntEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  static class Holder {
+    int value;
+  }
+
+  // A loop with a small constant trip count is replaced by copies of its body.
+
+  /// CHECK-START: int Main.sumFour(int) loop_optimization (before)
+  /// CHECK-DAG:                    Phi loop:{{B\d+}}
+
+  /// CHECK-START: int Main.sumFour(int) loop_optimization (after)
+  /// CHECK-NOT:                    Phi
+
+  public static int sumFour(int x) {
+    int sum = 0;
+    for (int i = 0; i < 4; i++) {
+      sum += i * x;
+    }
+    return sum;
+  }
+
+  // A loop with a small body gets a loop running two copies of the body per
+  // iteration inserted before it.
+
+  /// CHECK-START: int Main.sumProducts(int, int) loop_optimization (before)
+  /// CHECK:                        Mul loop:{{B\d+}}
+  /// CHECK-NOT:                    Mul
+
+  /// CHECK-START: int Main.sumProducts(int, int) loop_optimization (after)
+  /// CHECK:                        Mul loop:{{B\d+}}
+  /// CHECK:                        Mul loop:<<Loop:B\d+>>
+  /// CHECK:                        Mul loop:<<Loop>>
+  /// CHECK-NOT:                    Mul
+
+  public static int sumProducts(int n, int x) {
+    int sum = 0;
+    for (int i = 0; i < n; i++) {
+      sum += i * x;
+    }
+    return sum;
+  }
+
+  public static int sumRange(int lo, int hi, int x) {
+    int sum = 0;
+    for (int i = lo; i < hi; i++) {
+      sum += i ^ x;
+    }
+    return sum;
+  }
+
+  // The null check of an invariant moves out of the loop with the first iteration.
+
+  /// CHECK-START: int Main.sumHolder(Main$Holder, int) loop_optimization (before)
+  /// CHECK-DAG:                    NullCheck loop:{{B\d+}}
+
+  /// CHECK-START: int Main.sumHolder(Main$Holder, int) loop_optimization (after)
+  /// CHECK-DAG:                    NullCheck loop:none
+
+  /// CHECK-START: int Main.sumHolder(Main$Holder, int) loop_optimization (after)
+  /// CHECK-NOT:                    NullCheck loop:{{B\d+}}
+
+  public static int sumHolder(Holder h, int n) {
+    int sum = 0;
+    for (int i = 0; i < n; i++) {
+      sum += h.value;
+    }
+    return sum;
+  }
+
+  public static void main(String[] args) {
+    for (int x = -3; x <= 3; x++) {
+      assertIntEquals(6 * x, sumFour(x));
+    }
+
+    Holder holder = new Holder();
+    holder.value = 5;
+    for (int n = -2; n <= 21; n++) {
+      int expected = 0;
+      for (int i = 0; i < n; i++) {
+        expected += i * 7;
+      }
+      assertIntEquals(expected, sumProducts(n, 7));
+      assertIntEquals(Math.max(n, 0) * 5, sumHolder(holder, n));
+    }
+
+    // The bound of the unrolled loop is computed without overflow near the int limits.
+    int[] bounds = { Integer.MIN_VALUE, -5, 0, 5, Integer.MAX_VALUE - 9 };
+    for (int lo : bounds) {
+      for (int k = -2; k <= 9; k++) {
+        int hi = lo + k;
+        if (hi != (long) lo + k) {
+          continue;
+        }
+        int expected = 0;
+        for (long i = lo; i < (long) lo + k; i++) {
+          expected += ((int) i) ^ 3;
+        }
+        assertIntEquals(expected, sumRange(lo, hi, 3));
+      }
+      assertIntEquals(0, sumRange(Integer.MAX_VALUE, lo, 3));
+    }
+
+    assertIntEquals(0, sumHolder(null, 0));
+    try {
+      sumHolder(null, 1);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException expected) {
+      // Expected.
+    }
+    System.out.println("passed");
+  }
+}
@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+
+  public static void assertIntEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  static class Point {
+    int x;
+    int y;
+  }
+
+  static class FinalPoint {
+    final int x;
+
+    FinalPoint(int x) {
+      this.x = x;
+    }
+  }
+
+  static class Outer {
+    Point inner;
+  }
+
+  static Object sink;
+
+  // The field takes its value from the branches through a phi.
+
+  /// CHECK-START: int Main.merge(boolean, int, int) partial_escape_analysis (before)
+  /// CHECK-DAG:                    NewInstance
+  /// CHECK-DAG:                    InstanceFieldGet
+
+  /// CHECK-START: int Main.merge(boolean, int, int) partial_escape_analysis (after)
+  /// CHECK-DAG: <<Phi:i\d+>>       Phi
+  /// CHECK-DAG:                    Return [<<Phi>>]
+
+  /// CHECK-START: int Main.merge(boolean, int, int) partial_escape_analysis (after)
+  /// CHECK-NOT:                    NewInstance
+  /// CHECK-NOT:                    InstanceFieldGet
+  /// CHECK-NOT:                    InstanceFieldSet
+
+  public static int merge(boolean b, int x, int y) {
+    Point p = new Point();
+    if (b) {
+      p.x = x;
+    } else {
+      p.x = y;
+    }
+    return p.x;
+  }
+
+  /// CHECK-START: int Main.sumLoop(int) partial_escape_analysis (before)
+  /// CHECK-DAG:                    NewInstance
+  /// CHECK-DAG:                    InstanceFieldGet loop:{{B\d+}}
+
+  /// CHECK-START: int Main.sumLoop(int) partial_escape_analysis (after)
+  /// CHECK-NOT:                    NewInstance
+  /// CHECK-NOT:                    InstanceFieldGet
+
+  public static int sumLoop(int n) {
+    Point p = new Point();
+    for (int i = 0; i < n; i++) {
+      p.x += i;
+    }
+    return p.x;
+  }
+
+  /// CHECK-START: int Main.sumArray(int, int) partial_escape_analysis (before)
+  /// CHECK-DAG:                    NewArray
+  /// CHECK-DAG:                    ArraySet
+
+  /// CHECK-START: int Main.sumArray(int, int) partial_escape_analysis (after)
+  /// CHECK-NOT:                    NewArray
+  /// CHECK-NOT:                    ArraySet
+
+  public static int sumArray(int a, int b) {
+    int[] array = new int[2];
+    array[0] = a;
+    array[1] = b;
+    return array[0] + array[1];
+  }
+
+  // The object is only allocated on the path where it escapes.
+
+  /// CHECK-START: int Main.escapeOnError(int, int) partial_escape_analysis (before)
+  /// CHECK:                        NewInstance
+  /// CHECK:                        If
+  /// CHECK:                        StaticFieldSet
+
+  /// CHECK-START: int Main.escapeOnError(int, int) partial_escape_analysis (after)
+  /// CHECK:                        If
+  /// CHECK: <<Obj:l\d+>>           NewInstance
+  /// CHECK:                        InstanceFieldSet [<<Obj>>,{{i\d+}}]
+  /// CHECK:                        StaticFieldSet [{{l\d+}},<<Obj>>]
+
+  /// CHECK-START: int Main.escapeOnError(int, int) partial_escape_analysis (after)
+  /// CHECK-NOT:                    InstanceFieldGet
+
+  public static int escapeOnError(int x, int y) {
+    Point p = new Point();
+    p.x = x;
+    p.y = y;
+    if (x < 0) {
+      sink = p;
+      return -1;
+    }
+    return p.x + p.y;
+  }
+
+  // The final field must be visible before the materialized object is published.
+
+  /// CHECK-START: int Main.escapeFinal(int) partial_escape_analysis (after)
+  /// CHECK:                        If
+  /// CHECK: <<Obj:l\d+>>           NewInstance
+  /// CHECK:                        InstanceFieldSet [<<Obj>>,{{i\d+}}]
+  /// CHECK:                        MemoryBarrier kind:StoreStore
+  /// CHECK:                        StaticFieldSet [{{l\d+}},<<Obj>>]
+
+  public static int escapeFinal(int x) {
+    FinalPoint p = new FinalPoint(x);
+    if (x < 0) {
+      sink = p;
+      return -1;
+    }
+    return p.x;
+  }
+
+  // The inner object no longer escapes through the store once the outer one is replaced.
+
+  /// CHECK-START: int Main.nested(int) partial_escape_analysis (before)
+  /// CHECK:                        NewInstance
+  /// CHECK:                        NewInstance
+  /// CHECK:                        If
+
+  /// CHECK-START: int Main.nested(int) partial_escape_analysis (after)
+  /// CHECK:                        If
+  /// CHECK:                        NewInstance
+  /// CHECK:                        NewInstance
+  /// CHECK:                        StaticFieldSet
+
+  /// CHECK-START: int Main.nested(int) partial_escape_analysis (after)
+  /// CHECK-NOT:                    InstanceFieldGet
+
+  public static int nested(int x) {
+    Outer o = new Outer();
+    o.inner = new Point();
+    o.inner.x = x;
+    if (x < 0) {
+      sink = o;
+      return -1;
+    }
+    return o.inner.x;
+  }
+
+  // The object is only allocated for the interpreter when the method deoptimizes.
+
+  /// CHECK-START: int Main.deoptimize(int[], int) partial_escape_analysis (before)
+  /// CHECK:                        NewInstance
+  /// CHECK:                        Deoptimize
+
+  /// CHECK-START: int Main.deoptimize(int[], int) partial_escape_analysis (after)
+  /// CHECK:                        If
+  /// CHECK: <<Obj:l\d+>>           NewInstance
+  /// CHECK:                        InstanceFieldSet [<<Obj>>,{{i\d+}}]
+  /// CHECK:                        Deoptimize
+
+  /// CHECK-START: int Main.deoptimize(int[], int) partial_escape_analysis (after)
+  /// CHECK-NOT:                    InstanceFieldGet
+
+  public static int deoptimize(int[] array, int x) {
+    Point p = new Point();
+    p.x = x;
+    array[1] = p.x;
+    array[2] = 1;
+    array[3] = 1;
+    array[4] = 1;
+    return p.x + array[1];
+  }
+
+  // The lock of an object that does not escape is elided.
+
+  /// CHECK-START: int Main.lockedIncrement(int) partial_escape_analysis (before)
+  /// CHECK-DAG:                    MonitorOperation kind:enter
+
+  /// CHECK-START: int Main.lockedIncrement(int) partial_escape_analysis (after)
+  /// CHECK-NOT:                    MonitorOperation
+  /// CHECK-NOT:                    NewInstance
+
+  public static int lockedIncrement(int x) {
+    Point p = new Point();
+    synchronized (p) {
+      p.x = x + 1;
+    }
+    return p.x;
+  }
+
+  public static void main(String[] args) {
+    assertIntEquals(1, merge(true, 1, 2));
+    assertIntEquals(2, merge(false, 1, 2));
+    assertIntEquals(0, sumLoop(0));
+    assertIntEquals(45, sumLoop(10));
+    assertIntEquals(7, sumArray(3, 4));
+
+    assertIntEquals(7, escapeOnError(3, 4));
+    if (sink != null) {
+      throw new Error("Unexpected escape");
+    }
+    assertIntEquals(-1, escapeOnError(-3, 4));
+    Point escaped = (Point) sink;
+    assertIntEquals(-3, escaped.x);
+    assertIntEquals(4, escaped.y);
+
+    assertIntEquals(6, lockedIncrement(5));
+
+    sink = null;
+    assertIntEquals(4, escapeFinal(4));
+    assertIntEquals(-1, escapeFinal(-4));
+    assertIntEquals(-4, ((FinalPoint) sink).x);
+
+    sink = null;
+    assertIntEquals(3, nested(3));
+    assertIntEquals(-1, nested(-3));
+    assertIntEquals(-3, ((Outer) sink).inner.x);
+
+    assertIntEquals(12, deoptimize(new int[5], 6));
+    int[] small = new int[3];
+    try {
+      deoptimize(small, 7);
+      throw new Error("Expected ArrayIndexOutOfBoundsException");
+    } catch (ArrayIndexOutOfBoundsException e) {
+      // The interpreter read the field of the materialized object.
+      assertIntEquals(7, small[1]);
+    }
+    System.out.println("passed");
+  }
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+
+  public static void assertIntEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  public static void assertLongEquals(long expected, long result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  public static void assertDoubleEquals(double expected, double result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  static int calls;
+
+  public static int $noinline$call(int x) {
+    calls++;
+    return x;
+  }
+
+  // More values are live in the loop than there are registers, so some must be spilled.
+  public static int pressure(int n) {
+    int a = 1, b = 2, c = 3, d = 4, e = 5, f = 6, g = 7, h = 8;
+    int i = 9, j = 10, k = 11, l = 12, m = 13, o = 14, p = 15, q = 16, r = 17;
+    for (int x = 0; x < n; x++) {
+      a += b; b += c; c += d; d += e; e += f; f += g; g += h; h += i;
+      i += j; j += k; k += l; l += m; m += o; o += p; p += q; q += r; r += a;
+    }
+    return a ^ b ^ c ^ d ^ e ^ f ^ g ^ h ^ i ^ j ^ k ^ l ^ m ^ o ^ p ^ q ^ r;
+  }
+
+  public static int pressureReference(int n) {
+    int[] v = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17 };
+    for (int x = 0; x < n; x++) {
+      for (int y = 0; y < v.length; y++) {
+        v[y] += v[(y + 1) % v.length];
+      }
+    }
+    int result = 0;
+    for (int y = 0; y < v.length; y++) {
+      result ^= v[y];
+    }
+    return result;
+  }
+
+  // Values live across calls, mixed with register pairs on 32-bit targets.
+  public static long acrossCalls(int n, long seed, double scale) {
+    long acc = seed;
+    double total = 0;
+    for (int x = 0; x < n; x++) {
+      int v = $noinline$call(x);
+      acc = acc * 31 + v;
+      total += v * scale;
+    }
+    return acc + (long) total;
+  }
+
+  // Loop phis that swap values every iteration.
+  public static int swap(int n) {
+    int a = 1;
+    int b = 2;
+    int c = 3;
+    for (int x = 0; x < n; x++) {
+      int t = a;
+      a = b;
+      b = c;
+      c = t + x;
+    }
+    return a * 100 + b * 10 + c;
+  }
+
+  // Array accesses and divisions with slow paths, while other values are live.
+  public static int slowPaths(int[] array, int divisor) {
+    int sum = 0;
+    int product = 1;
+    for (int x = 0; x < array.length; x++) {
+      int value = array[x] / divisor;
+      sum += value;
+      product *= value | 1;
+    }
+    return sum + product;
+  }
+
+  // Values flowing into a catch block through catch phis.
+  public static int catchPhis(int[] array, int index) {
+    int a = 1;
+    int b = 2;
+    try {
+      a = array[index];
+      b = array[index + 1];
+    } catch (ArrayIndexOutOfBoundsException e) {
+      return a * 10 + b;
+    }
+    return a + b;
+  }
+
+  public static double mixed(float f, double d, long l, int i) {
+    double result = 0;
+    for (int x = 0; x < i; x++) {
+      result += f * x + d / (x + 1) + (l >> x);
+      f += 0.5f;
+      d *= 2;
+    }
+    return result;
+  }
+
+  public static void main(String[] args) {
+    assertIntEquals(pressureReference(0), pressure(0));
+    assertIntEquals(pressureReference(1), pressure(1));
+    assertIntEquals(pressureReference(100), pressure(100));
+
+    calls = 0;
+    assertLongEquals(7, acrossCalls(0, 7, 0.5));
+    assertLongEquals((((7L * 31) * 31 + 1) * 31 + 2) + 1, acrossCalls(3, 7, 0.5));
+    assertIntEquals(3, calls);
+
+    assertIntEquals(123, swap(0));
+    assertIntEquals(231, swap(1));
+    assertIntEquals(313, swap(2));
+
+    assertIntEquals(1 + 1, slowPaths(new int[] { 2 }, 2));
+    assertIntEquals(10 + 1 * 3 * 3 * 5, slowPaths(new int[] { 1, 2, 3, 4 }, 1));
+    try {
+      slowPaths(new int[] { 1 }, 0);
+      throw new Error("Expected ArithmeticException");
+    } catch (ArithmeticException e) {
+      // Expected.
+    }
+
+    int[] array = { 5, 6, 7 };
+    assertIntEquals(11, catchPhis(array, 0));
+    assertIntEquals(72, catchPhis(array, 2));
+    assertIntEquals(12, catchPhis(array, 3));
+
+    assertDoubleEquals(0, mixed(1.0f, 1.0, 8L, 0));
+    assertDoubleEquals(0 + 1.0 + 8, mixed(1.0f, 1.0, 8L, 1));
+    assertDoubleEquals(9.0 + (1.5 + 1.0 + 4), mixed(1.0f, 1.0, 8L, 2));
+
+    System.out.println("passed");
+  }
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+
+  public static void assertIntEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  public static void assertLongEquals(long expected, long result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  static class Node {
+    int key;
+    int value;
+    long weight;
+    Node next;
+  }
+
+  static int step;
+
+  // Loads that can be issued ahead of their uses.
+  public static int dotProduct(int[] x, int[] y) {
+    int sum = 0;
+    for (int i = 0; i < x.length - 1; i += 2) {
+      sum += x[i] * y[i];
+      sum += x[i + 1] * y[i + 1];
+    }
+    return sum;
+  }
+
+  // The load of `y` must stay after the store to `x`, as they may be the same array.
+  public static int aliasingArrays(int[] x, int[] y, int value) {
+    int before = y[1] * 3;
+    x[0] = value;
+    return before + y[0];
+  }
+
+  // The int load must stay after the int store, the long load may move.
+  public static long aliasingFields(Node a, Node b, int value) {
+    a.key = value;
+    long weight = b.weight;
+    return b.key * 10 + weight;
+  }
+
+  // The store to `step` must stay between the two null checks.
+  public static int nullCheckOrder(Node a, Node b) {
+    step = 1;
+    int x = a.key * 5;
+    step = 2;
+    int y = b.value * 7;
+    step = 3;
+    return x + y;
+  }
+
+  // The stores must be visible when the bounds check or the division throws.
+  public static int throwOrder(int[] array, int index, int divisor) {
+    step = 0;
+    array[0] = 42;
+    step = 1;
+    int value = array[index];
+    step = 2;
+    int quotient = value / divisor;
+    step = 3;
+    return quotient;
+  }
+
+  // Array accesses around allocations, which may trigger a GC and move the arrays.
+  public static int aroundAllocations(int[] array) {
+    int sum = 0;
+    for (int i = 0; i < array.length; i++) {
+      int value = array[i];
+      Node node = new Node();
+      node.key = value;
+      sum += node.key + array[array.length - 1 - i];
+    }
+    return sum;
+  }
+
+  public static int walkList(Node node) {
+    int total = 0;
+    while (node != null) {
+      total += node.key * 3 + node.value;
+      node = node.next;
+    }
+    return total;
+  }
+
+  public static void main(String[] args) {
+    int[] x = { 1, 2, 3, 4, 5, 6 };
+    int[] y = { 6, 5, 4, 3, 2, 1 };
+    assertIntEquals(6 + 10 + 12 + 12 + 10 + 6, dotProduct(x, y));
+
+    int[] array = { 1, 2, 3 };
+    assertIntEquals(2 * 3 + 9, aliasingArrays(array, array, 9));
+    assertIntEquals(9, array[0]);
+    assertIntEquals(5 * 3 + 6, aliasingArrays(array, y, 7));
+
+    Node a = new Node();
+    a.key = 1;
+    a.weight = 100;
+    Node b = new Node();
+    b.key = 2;
+    b.weight = 200;
+    assertLongEquals(50 + 100, aliasingFields(a, a, 5));
+    assertLongEquals(20 + 200, aliasingFields(a, b, 6));
+
+    a.next = b;
+    b.value = 4;
+    assertIntEquals(6 * 5 + 4 * 7, nullCheckOrder(a, b));
+    assertIntEquals(3, step);
+    try {
+      nullCheckOrder(null, b);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException e) {
+      assertIntEquals(1, step);
+    }
+    try {
+      nullCheckOrder(a, null);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException e) {
+      assertIntEquals(2, step);
+    }
+
+    int[] values = { 0, 10, 20 };
+    assertIntEquals(5, throwOrder(values, 1, 2));
+    assertIntEquals(42, values[0]);
+    assertIntEquals(3, step);
+    values[0] = 0;
+    try {
+      throwOrder(values, 3, 2);
+      throw new Error("Expected ArrayIndexOutOfBoundsException");
+    } catch (ArrayIndexOutOfBoundsException e) {
+      assertIntEquals(42, values[0]);
+      assertIntEquals(1, step);
+    }
+    try {
+      throwOrder(values, 2, 0);
+      throw new Error("Expected ArithmeticException");
+    } catch (ArithmeticException e) {
+      assertIntEquals(2, step);
+    }
+
+    int[] large = new int[1000];
+    for (int i = 0; i < large.length; i++) {
+      large[i] = i;
+    }
+    assertIntEquals(999 * 1000, aroundAllocations(large));
+
+    assertIntEquals((6 * 3 + 0) + (2 * 3 + 4), walkList(a));
+
+    System.out.println("passed");
+  }
+}
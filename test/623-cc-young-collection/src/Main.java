@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.lang.ref.WeakReference;
+
+public class Main {
+  static final int NUM_OLD = 32;
+  static final int NUM_ROUNDS = 20;
+
+  static class Payload {
+    int value;
+    int[] large;
+    Payload young;
+
+    Payload(int value) {
+      this.value = value;
+    }
+  }
+
+  static class Holder {
+    Payload payload;
+  }
+
+  // Old objects, each holding the only strong reference to its payload.
+  static Holder[] holders = new Holder[NUM_OLD];
+  static WeakReference<Payload>[] weakPayloads = new WeakReference[NUM_OLD];
+  static WeakReference<int[]>[] weakLarge = new WeakReference[NUM_OLD];
+
+  static Object sink;
+
+  public static void main(String[] args) throws Exception {
+    for (int i = 0; i < NUM_OLD; i++) {
+      Payload payload = new Payload(i);
+      // Large enough to go to the large object space.
+      payload.large = new int[16 * 1024];
+      payload.large[0] = i;
+      holders[i] = new Holder();
+      holders[i].payload = payload;
+      weakPayloads[i] = new WeakReference<Payload>(payload);
+      weakLarge[i] = new WeakReference<int[]>(payload.large);
+      inflateMonitor(payload);
+    }
+    // Make everything old.
+    Runtime.getRuntime().gc();
+
+    for (int round = 0; round < NUM_ROUNDS; round++) {
+      // An old object referring to a young one, only found through the card table.
+      Payload old = holders[round % NUM_OLD].payload;
+      old.young = new Payload(round);
+      allocateGarbage();
+      check();
+      if (old.young.value != round) {
+        throw new Error("Young object reachable from an old one was lost: " + round);
+      }
+    }
+    System.out.println("passed");
+  }
+
+  // Allocates enough short-lived objects to trigger young collections.
+  static void allocateGarbage() {
+    for (int i = 0; i < 100000; i++) {
+      sink = new Object[8];
+    }
+    sink = null;
+  }
+
+  static void inflateMonitor(Object o) throws InterruptedException {
+    synchronized (o) {
+      // Waiting inflates the lock into a monitor.
+      o.wait(1);
+    }
+  }
+
+  static void check() throws InterruptedException {
+    for (int i = 0; i < NUM_OLD; i++) {
+      Payload payload = weakPayloads[i].get();
+      if (payload == null || payload != holders[i].payload) {
+        throw new Error("Weak reference to an old object was cleared: " + i);
+      }
+      int[] large = weakLarge[i].get();
+      if (large == null || large != payload.large || large[0] != i) {
+        throw new Error("Weak reference to an old large object was cleared: " + i);
+      }
+      // Use the monitor of the old object.
+      synchronized (payload) {
+        payload.notifyAll();
+      }
+      if (payload.value != i) {
+        throw new Error("Old object was corrupted: " + i);
+      }
+    }
+  }
+}
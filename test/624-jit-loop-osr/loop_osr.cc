@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "art_method-inl.h"
+#include "jit/jit.h"
+#include "jit/jit_code_cache.h"
+#include "jit/profiling_info.h"
+#include "mirror/class-inl.h"
+#include "oat_quick_method_header.h"
+#include "scoped_thread_state_change.h"
+#include "ScopedUtfChars.h"
+
+namespace art {
+
+static ArtMethod* FindMethod(ScopedObjectAccess& soa, JNIEnv* env, jclass cls, jstring name)
+    SHARED_REQUIRES(Locks::mutator_lock_) {
+  ScopedUtfChars chars(env, name);
+  CHECK(chars.c_str() != nullptr);
+  mirror::Class* klass = soa.Decode<mirror::Class*>(cls);
+  ArtMethod* method = klass->FindDeclaredDirectMethodByName(chars.c_str(), sizeof(void*));
+  CHECK(method != nullptr) << chars.c_str();
+  return method;
+}
+
+// Returns the number of loops of the method that its OSR code can be entered at,
+// or -1 when not running with the JIT.
+extern "C" JNIEXPORT jint JNICALL Java_Main_getNumberOfOsrLoops(JNIEnv* env,
+                                                                jclass,
+                                                                jclass cls,
+                                                                jstring method_name) {
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  if (jit == nullptr || !Runtime::Current()->UseJitCompilation()) {
+    return -1;
+  }
+  ScopedObjectAccess soa(Thread::Current());
+  ArtMethod* method = FindMethod(soa, env, cls, method_name);
+  ProfilingInfo* info = method->GetProfilingInfo(sizeof(void*));
+  if (info == nullptr) {
+    return 0;
+  }
+  jint count = 0;
+  for (size_t i = 0; i < info->GetNumberOfLoopCaches(); ++i) {
+    const LoopCache& loop = info->GetLoopCacheAt(i);
+    if (jit->GetCodeCache()->HasOsrEntry(method, loop.GetDexPc())) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_Main_ensureBaselineCompiled(JNIEnv* env,
+                                                                   jclass,
+                                                                   jclass cls,
+                                                                   jstring method_name) {
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  if (jit == nullptr || !Runtime::Current()->UseJitCompilation()) {
+    return;
+  }
+  ScopedObjectAccess soa(Thread::Current());
+  ArtMethod* method = FindMethod(soa, env, cls, method_name);
+  // Make sure there is a profiling info, required by the compiler.
+  ProfilingInfo::Create(soa.Self(), method, /* retry_allocation */ true);
+  // Hot methods do not get baseline compiled.
+  while (!jit->GetCodeCache()->IsBaselineCompiled(method) &&
+         method->GetCounter() < jit->HotMethodThreshold()) {
+    // Sleep to yield to the compiler thread.
+    usleep(1000);
+    // Will either ensure it's compiled or do the compilation itself.
+    jit->CompileMethod(method, soa.Self(), /* baseline */ true, /* osr */ false);
+  }
+}
+
+class BaselineVisitor : public StackVisitor {
+ public:
+  BaselineVisitor(Thread* thread, const char* method_name)
+      SHARED_REQUIRES(Locks::mutator_lock_)
+      : StackVisitor(thread, nullptr, StackVisitor::StackWalkKind::kIncludeInlinedFrames),
+        method_name_(method_name),
+        in_baseline_code_(false) {}
+
+  bool VisitFrame() SHARED_REQUIRES(Locks::mutator_lock_) {
+    ArtMethod* m = GetMethod();
+    std::string m_name(m->GetName());
+
+    if (m_name.compare(method_name_) == 0) {
+      const OatQuickMethodHeader* header = GetCurrentOatQuickMethodHeader();
+      in_baseline_code_ = !IsCurrentFrameInInterpreter() &&
+          (header != nullptr) &&
+          Runtime::Current()->GetJit()->GetCodeCache()->IsBaselineCode(header);
+      return false;
+    }
+    return true;
+  }
+
+  const char* const method_name_;
+  bool in_baseline_code_;
+};
+
+extern "C" JNIEXPORT jboolean JNICALL Java_Main_isInBaselineCode(JNIEnv* env,
+                                                                 jclass,
+                                                                 jstring method_name) {
+  if (!Runtime::Current()->UseJitCompilation()) {
+    return JNI_FALSE;
+  }
+  ScopedUtfChars chars(env, method_name);
+  CHECK(chars.c_str() != nullptr);
+  ScopedObjectAccess soa(Thread::Current());
+  BaselineVisitor visitor(soa.Self(), chars.c_str());
+  visitor.WalkStack();
+  return visitor.in_baseline_code_;
+}
+
+}  // namespace art
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+  public static void main(String[] args) {
+    System.loadLibrary(args[0]);
+    Thread testThread = new Thread() {
+      public void run() {
+        performTest();
+      }
+    };
+    testThread.start();
+    try {
+      testThread.join(20 * 1000);  // 20s timeout.
+    } catch (InterruptedException ie) {
+      System.out.println("Interrupted.");
+      System.exit(1);
+    }
+    Thread.State state = testThread.getState();
+    if (state != Thread.State.TERMINATED) {
+      System.out.println("Test timed out, current state: " + state);
+      System.exit(1);
+    }
+    System.out.println("passed");
+  }
+
+  public static void performTest() {
+    // Only the loop that got hot is an OSR entry.
+    if ($noinline$twoLoops(/* first */ true)) {
+      assertOsrLoops(1, "$noinline$twoLoops");
+      // The other loop getting hot compiles the method for OSR again, with both loops as entries.
+      if ($noinline$twoLoops(/* first */ false)) {
+        assertOsrLoops(2, "$noinline$twoLoops");
+      }
+    }
+
+    ensureBaselineCompiled(Main.class, "$noinline$baselineLoop");
+    $noinline$baselineLoop();
+  }
+
+  public static boolean $noinline$twoLoops(boolean first) {
+    if (doThrow) throw new Error("");
+    // If we are running in non-JIT mode, or were unlucky enough to get this method
+    // already JITted, the loops cannot be entered through OSR.
+    if (!isInInterpreter("$noinline$twoLoops")) {
+      return false;
+    }
+    if (first) {
+      while (!isInOsrCode("$noinline$twoLoops")) {
+        counter++;
+      }
+    } else {
+      while (!isInOsrCode("$noinline$twoLoops")) {
+        counter--;
+      }
+    }
+    return true;
+  }
+
+  public static void $noinline$baselineLoop() {
+    if (doThrow) throw new Error("");
+    // Nothing to test without the baseline tier, or if the method got hot and compiled
+    // by the optimizing tier already.
+    if (!isInBaselineCode("$noinline$baselineLoop")) {
+      return;
+    }
+    // The baseline code counts the back edges of the loop until it is hot, then leaves
+    // for the interpreter, which enters the OSR code of the loop.
+    while (!isInOsrCode("$noinline$baselineLoop")) {
+      counter++;
+    }
+  }
+
+  public static void assertOsrLoops(int expected, String methodName) {
+    int result = getNumberOfOsrLoops(Main.class, methodName);
+    if (result != -1 && result != expected) {
+      throw new Error("Expected " + expected + " OSR loops in " + methodName + ", found " + result);
+    }
+  }
+
+  public static native boolean isInOsrCode(String methodName);
+  public static native boolean isInInterpreter(String methodName);
+  public static native boolean isInBaselineCode(String methodName);
+  public static native void ensureBaselineCompiled(Class<?> cls, String methodName);
+  public static native int getNumberOfOsrLoops(Class<?> cls, String methodName);
+
+  public static boolean doThrow = false;
+  public static int counter = 0;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "art_method-inl.h"
+#include "jit/jit.h"
+#include "jit/jit_code_cache.h"
+#include "mirror/class-inl.h"
+#include "oat_quick_method_header.h"
+#include "scoped_thread_state_change.h"
+#include "ScopedUtfChars.h"
+
+namespace art {
+
+// Returns the code cache entry the method currently runs, or null.
+static const void* GetJitCompiledCode(JNIEnv* env, jclass cls, jstring method_name) {
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  if (jit == nullptr) {
+    return nullptr;
+  }
+  ScopedObjectAccess soa(Thread::Current());
+  ScopedUtfChars chars(env, method_name);
+  CHECK(chars.c_str() != nullptr);
+  mirror::Class* klass = soa.Decode<mirror::Class*>(cls);
+  ArtMethod* method = klass->FindDeclaredDirectMethodByName(chars.c_str(), sizeof(void*));
+  CHECK(method != nullptr) << chars.c_str();
+  const void* entry_point = method->GetEntryPointFromQuickCompiledCode();
+  if (!jit->GetCodeCache()->ContainsPc(entry_point)) {
+    return nullptr;
+  }
+  return OatQuickMethodHeader::FromEntryPoint(entry_point)->GetCode();
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_Main_hasJitCompiledEntrypoint(JNIEnv* env,
+                                                                         jclass,
+                                                                         jclass cls,
+                                                                         jstring method_name) {
+  return GetJitCompiledCode(env, cls, method_name) != nullptr;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_Main_hasSingleImplementationDependencies(
+    JNIEnv* env, jclass, jclass cls, jstring method_name) {
+  const void* code = GetJitCompiledCode(env, cls, method_name);
+  return (code != nullptr) &&
+      Runtime::Current()->GetJit()->GetCodeCache()->HasSingleImplementationDependencies(code);
+}
+
+}  // namespace art
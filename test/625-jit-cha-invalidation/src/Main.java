@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+  public static void assertIntEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  public static void main(String[] args) throws Exception {
+    System.loadLibrary(args[0]);
+
+    // Fill the inline caches with receivers of Base, the only class implementing foo() so far.
+    Base base = new Base();
+    for (int i = 0; i < 100; ++i) {
+      assertIntEquals(1, $noinline$callFoo(base));
+      assertIntEquals(1, $noinline$callFooOnNewInstance(/* sub */ false));
+    }
+    ensureJitCompiled(Main.class, "$noinline$callFoo");
+    ensureJitCompiled(Main.class, "$noinline$callFooOnNewInstance");
+    boolean devirtualized = hasSingleImplementationDependencies(Main.class, "$noinline$callFoo");
+
+    // Sub gets loaded while the compiled code of $noinline$callFooOnNewInstance runs. The guard
+    // of the devirtualized call then sees a receiver of Sub and deoptimizes.
+    assertIntEquals(2, $noinline$callFooOnNewInstance(/* sub */ true));
+
+    // Loading Sub invalidated the code which devirtualized calls to Base.foo().
+    if (devirtualized && hasJitCompiledEntrypoint(Main.class, "$noinline$callFoo")) {
+      throw new Error("Expected the compiled code of $noinline$callFoo to be invalidated");
+    }
+
+    // The calls dispatch to the implementation of the receiver's class, before and after
+    // the method gets compiled again.
+    Base sub = $noinline$newInstance(/* sub */ true);
+    for (int i = 0; i < 100; ++i) {
+      assertIntEquals(1, $noinline$callFoo(base));
+      assertIntEquals(2, $noinline$callFoo(sub));
+    }
+    ensureJitCompiled(Main.class, "$noinline$callFoo");
+    assertIntEquals(1, $noinline$callFoo(base));
+    assertIntEquals(2, $noinline$callFoo(sub));
+    assertIntEquals(1, $noinline$callFooOnNewInstance(/* sub */ false));
+    assertIntEquals(2, $noinline$callFooOnNewInstance(/* sub */ true));
+
+    System.out.println("passed");
+  }
+
+  public static int $noinline$callFoo(Base b) {
+    if (doThrow) throw new Error("");
+    return b.foo();
+  }
+
+  public static int $noinline$callFooOnNewInstance(boolean sub) throws Exception {
+    if (doThrow) throw new Error("");
+    Base b = $noinline$newInstance(sub);
+    return b.foo();
+  }
+
+  public static Base $noinline$newInstance(boolean sub) throws Exception {
+    if (doThrow) throw new Error("");
+    // Sub is loaded through reflection, so that it only gets loaded by the first call
+    // with `sub` set.
+    return sub ? (Base) Class.forName("Sub").newInstance() : new Base();
+  }
+
+  public static native void ensureJitCompiled(Class<?> cls, String methodName);
+  public static native boolean hasJitCompiledEntrypoint(Class<?> cls, String methodName);
+  public static native boolean hasSingleImplementationDependencies(Class<?> cls,
+                                                                   String methodName);
+
+  public static boolean doThrow = false;
+}
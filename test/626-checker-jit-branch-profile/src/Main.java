@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+  public static void assertIntEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  public static void main(String[] args) {
+    System.loadLibrary(args[0]);
+
+    // Only positive values go through the baseline code, which records that the
+    // branch always goes the same way.
+    ensureBaselineCompiled(Main.class, "$noinline$sign");
+    for (int i = 1; i <= 1000; ++i) {
+      assertIntEquals(1, $noinline$sign(i));
+    }
+
+    ensureOptimizedCompiled(Main.class, "$noinline$sign");
+    assertIntEquals(1, $noinline$sign(42));
+    // The branch goes the other way, the optimized code deoptimizes.
+    assertIntEquals(-1, $noinline$sign(-42));
+    assertIntEquals(1, $noinline$sign(42));
+
+    System.out.println("passed");
+  }
+
+  // The first compilation of the method is the baseline one, which updates the
+  // branch profile before the If.
+
+  /// CHECK-START: int Main.$noinline$sign(int) builder (after)
+  /// CHECK:         <<Cond:z\d+>> {{GreaterThan|LessThanOrEqual}}
+  /// CHECK:                       UpdateBranchProfile [{{[ij]\d+}},<<Cond>>]
+  /// CHECK:                       If [<<Cond>>]
+
+  // The optimizing compilation guards the never seen direction with a deoptimization,
+  // and the other successor of the If gets removed.
+
+  /// CHECK-START: int Main.$noinline$sign(int) dead_code_elimination (before)
+  /// CHECK:                       Deoptimize
+  /// CHECK:                       If [{{i\d+}}]
+
+  /// CHECK-START: int Main.$noinline$sign(int) dead_code_elimination (after)
+  /// CHECK-NOT:                   If
+
+  /// CHECK-START: int Main.$noinline$sign(int) dead_code_elimination (after)
+  /// CHECK:                       Return
+  /// CHECK-NOT:                   Return
+
+  public static int $noinline$sign(int value) {
+    if (value > 0) {
+      return 1;
+    }
+    return -1;
+  }
+
+  public static native void ensureBaselineCompiled(Class<?> cls, String methodName);
+  public static native void ensureOptimizedCompiled(Class<?> cls, String methodName);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "art_method-inl.h"
+#include "jit/jit.h"
+#include "jit/jit_code_cache.h"
+#include "mirror/class-inl.h"
+#include "oat_quick_method_header.h"
+#include "scoped_thread_state_change.h"
+#include "ScopedUtfChars.h"
+
+namespace art {
+
+extern "C" JNIEXPORT jboolean JNICALL Java_Main_hasJit(JNIEnv*, jclass) {
+  return Runtime::Current()->GetJit() != nullptr && Runtime::Current()->UseJitCompilation();
+}
+
+// Returns whether the method runs optimizing JIT code, without compiling it.
+extern "C" JNIEXPORT jboolean JNICALL Java_Main_isOptimizedCompiled(JNIEnv* env,
+                                                                    jclass,
+                                                                    jclass cls,
+                                                                    jstring method_name) {
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  if (jit == nullptr || !Runtime::Current()->UseJitCompilation()) {
+    return JNI_FALSE;
+  }
+  ScopedObjectAccess soa(Thread::Current());
+  ScopedUtfChars chars(env, method_name);
+  CHECK(chars.c_str() != nullptr);
+  mirror::Class* klass = soa.Decode<mirror::Class*>(cls);
+  ArtMethod* method = klass->FindDeclaredDirectMethodByName(chars.c_str(), sizeof(void*));
+  CHECK(method != nullptr) << chars.c_str();
+  const void* entry_point = method->GetEntryPointFromQuickCompiledCode();
+  jit::JitCodeCache* code_cache = jit->GetCodeCache();
+  return code_cache->ContainsPc(entry_point) &&
+      !code_cache->IsBaselineCode(OatQuickMethodHeader::FromEntryPoint(entry_point));
+}
+
+}  // namespace art
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+class Base {
+  public int value() {
+    return 1;
+  }
+}
+
+class Derived extends Base {
+  public int value() {
+    return 2;
+  }
+}
+
+public class Main {
+  public static void assertIntEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  public static void main(String[] args) throws Exception {
+    System.loadLibrary(args[0]);
+    if (!hasJit()) {
+      // The tiers only exist with the JIT.
+      System.out.println("passed");
+      return;
+    }
+    Base base = new Base();
+    Base derived = new Derived();
+
+    ensureBaselineCompiled(Main.class, "$noinline$sum");
+    if (isOptimizedCompiled(Main.class, "$noinline$sum")) {
+      throw new Error("Optimized before reaching the hot threshold");
+    }
+
+    // The baseline code counts the invocations, the hot threshold queues the
+    // optimizing compilation which then replaces it.
+    for (int i = 0; !isOptimizedCompiled(Main.class, "$noinline$sum"); ++i) {
+      if (i == 10000) {
+        throw new Error("Not optimized after reaching the hot threshold");
+      }
+      for (int j = 0; j < 100; ++j) {
+        assertIntEquals(6, $noinline$sum(base, derived));
+      }
+      Thread.sleep(1);
+    }
+    assertIntEquals(6, $noinline$sum(base, derived));
+
+    System.out.println("passed");
+  }
+
+  // The first compilation of the method is the baseline one. It counts the
+  // invocation on entry, records the receiver classes before the virtual calls,
+  // and does not inline the static call.
+
+  /// CHECK-START: int Main.$noinline$sum(Base, Base) instruction_simplifier_before_codegen (after)
+  /// CHECK:                       UpdateHotness
+  /// CHECK:                       UpdateInlineCache
+  /// CHECK:                       InvokeVirtual method_name:Base.value
+  /// CHECK:                       UpdateInlineCache
+  /// CHECK:                       InvokeVirtual method_name:Base.value
+  /// CHECK:                       InvokeStaticOrDirect method_name:Main.$inline$twice
+
+  // Only the optimizing compilation runs the inliner, and its code does not
+  // count invocations anymore.
+
+  /// CHECK-START: int Main.$noinline$sum(Base, Base) inliner (before)
+  /// CHECK:                       InvokeStaticOrDirect method_name:Main.$inline$twice
+
+  /// CHECK-START: int Main.$noinline$sum(Base, Base) inliner (after)
+  /// CHECK-NOT:                   InvokeStaticOrDirect method_name:Main.$inline$twice
+
+  /// CHECK-START: int Main.$noinline$sum(Base, Base) inliner (after)
+  /// CHECK-NOT:                   UpdateHotness
+
+  /// CHECK-START: int Main.$noinline$sum(Base, Base) inliner (after)
+  /// CHECK-NOT:                   UpdateInlineCache
+
+  public static int $noinline$sum(Base a, Base b) {
+    return $inline$twice(a.value() + b.value());
+  }
+
+  public static int $inline$twice(int value) {
+    return value * 2;
+  }
+
+  public static native boolean hasJit();
+  public static native void ensureBaselineCompiled(Class<?> cls, String methodName);
+  public static native boolean isOptimizedCompiled(Class<?> cls, String methodName);
+}
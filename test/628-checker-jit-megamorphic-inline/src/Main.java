@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+class Base {
+  public int value() {
+    return 0;
+  }
+}
+
+class Frequent extends Base {
+  public int value() {
+    return 11;
+  }
+}
+
+class Common extends Base {
+  public int value() {
+    return 22;
+  }
+}
+
+class Rare0 extends Base {
+  public int value() {
+    return 100;
+  }
+}
+
+class Rare1 extends Base {
+  public int value() {
+    return 101;
+  }
+}
+
+class Rare2 extends Base {
+  public int value() {
+    return 102;
+  }
+}
+
+class Rare3 extends Base {
+  public int value() {
+    return 103;
+  }
+}
+
+class Rare4 extends Base {
+  public int value() {
+    return 104;
+  }
+}
+
+class Rare5 extends Base {
+  public int value() {
+    return 105;
+  }
+}
+
+class Rare6 extends Base {
+  public int value() {
+    return 106;
+  }
+}
+
+class Rare7 extends Base {
+  public int value() {
+    return 107;
+  }
+}
+
+public class Main {
+  public static void assertIntEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  public static void main(String[] args) {
+    System.loadLibrary(args[0]);
+    Base frequent = new Frequent();
+    Base common = new Common();
+    Base[] rares = {
+      new Rare0(), new Rare1(), new Rare2(), new Rare3(),
+      new Rare4(), new Rare5(), new Rare6(), new Rare7()
+    };
+
+    // The interpreter records the receivers in the inline cache. Common is seen
+    // first, and the rare receivers fill the cache and make the call megamorphic.
+    ensureProfilingInfo(Main.class, "$noinline$value");
+    assertIntEquals(22, $noinline$value(common));
+    assertIntEquals(11, $noinline$value(frequent));
+    for (int i = 0; i < rares.length; ++i) {
+      assertIntEquals(100 + i, $noinline$value(rares[i]));
+    }
+    // Frequent then gets most of the calls, Common a third of them.
+    for (int i = 0; i < 1000; ++i) {
+      for (int j = 0; j < 6; ++j) {
+        assertIntEquals(11, $noinline$value(frequent));
+      }
+      for (int j = 0; j < 3; ++j) {
+        assertIntEquals(22, $noinline$value(common));
+      }
+    }
+
+    ensureJitCompiled(Main.class, "$noinline$value");
+    assertIntEquals(11, $noinline$value(frequent));
+    assertIntEquals(22, $noinline$value(common));
+    // The rare receivers go through the virtual call rather than deoptimizing.
+    for (int i = 0; i < rares.length; ++i) {
+      assertIntEquals(100 + i, $noinline$value(rares[i]));
+    }
+    if (hasJit() && !hasJitCompiledEntrypoint(Main.class, "$noinline$value")) {
+      throw new Error("Deoptimized for a rare receiver");
+    }
+
+    System.out.println("passed");
+  }
+
+  // The call is megamorphic, only the two dominant receivers are inlined. The
+  // guard of the most frequent one comes first, the rare receivers and the ones
+  // not in the cache are left to the virtual call.
+
+  /// CHECK-START: int Main.$noinline$value(Base) inliner (before)
+  /// CHECK:                       InvokeVirtual method_name:Base.value
+
+  /// CHECK-START: int Main.$noinline$value(Base) inliner (after)
+  /// CHECK-DAG:     <<Receiver:l\d+>> ParameterValue
+  /// CHECK-DAG:     <<Const11:i\d+>>  IntConstant 11
+  /// CHECK-DAG:     <<Const22:i\d+>>  IntConstant 22
+  /// CHECK-DAG:     <<NullCheck:l\d+>> NullCheck [<<Receiver>>]
+  /// CHECK-DAG:     <<Invoke:i\d+>>   InvokeVirtual [<<NullCheck>>] method_name:Base.value
+  /// CHECK-DAG:     <<Inner:i\d+>>    Phi [<<Const22>>,<<Invoke>>]
+  /// CHECK-DAG:     <<Outer:i\d+>>    Phi [<<Const11>>,<<Inner>>]
+  /// CHECK-DAG:                       Return [<<Outer>>]
+
+  /// CHECK-START: int Main.$noinline$value(Base) inliner (after)
+  /// CHECK:                           InstanceFieldGet field_name:java.lang.Object.shadow$_klass_
+  /// CHECK:         <<Guard1:z\d+>>   NotEqual
+  /// CHECK:                           If [<<Guard1>>]
+  /// CHECK:                           InstanceFieldGet field_name:java.lang.Object.shadow$_klass_
+  /// CHECK:         <<Guard2:z\d+>>   NotEqual
+  /// CHECK:                           If [<<Guard2>>]
+  /// CHECK-NOT:                       NotEqual
+
+  /// CHECK-START: int Main.$noinline$value(Base) inliner (after)
+  /// CHECK:                           InvokeVirtual
+  /// CHECK-NOT:                       InvokeVirtual
+
+  /// CHECK-START: int Main.$noinline$value(Base) inliner (after)
+  /// CHECK-NOT:                       Deoptimize
+
+  /// CHECK-START: int Main.$noinline$value(Base) inliner (after)
+  /// CHECK-NOT:                       IntConstant 10{{\d}}
+
+  public static int $noinline$value(Base b) {
+    return b.value();
+  }
+
+  public static native boolean hasJit();
+  public static native void ensureProfilingInfo(Class<?> cls, String methodName);
+  public static native void ensureJitCompiled(Class<?> cls, String methodName);
+  public static native boolean hasJitCompiledEntrypoint(Class<?> cls, String methodName);
+}
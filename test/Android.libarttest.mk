@@ -45,7 +45,12 @@ LIBARTTEST_COMMON_SRC_FILES := \
   570-checker-osr/osr.cc \
   595-profile-saving/profile-saving.cc \
   596-app-images/app_images.cc \
-  597-deopt-new-string/deopt.cc
+  597-deopt-new-string/deopt.cc \
+  624-jit-loop-osr/loop_osr.cc \
+  625-jit-cha-invalidation/cha.cc \
+  626-checker-jit-branch-profile/branch_profile.cc \
+  627-checker-jit-baseline/baseline.cc \
+  628-checker-jit-megamorphic-inline/megamorphic_inline.cc
 
 ART_TARGET_LIBARTTEST_$(ART_PHONY_TEST_TARGET_SUFFIX) += $(ART_TARGET_TEST_OUT)/$(TARGET_ARCH)/libarttest.so
 ART_TARGET_LIBARTTEST_$(ART_PHONY_TEST_TARGET_SUFFIX) += $(ART_TARGET_TEST_OUT)/$(TARGET_ARCH)/libarttestd.so
@@ -426,11 +426,21 @@ TEST_ART_BROKEN_FALLBACK_RUN_TESTS :=
 # 802 and 570-checker-osr:
 # This test dynamically enables tracing to force a deoptimization. This makes the test meaningless
 # when already tracing, and writes an error message that we do not want to check for.
+# 624-jit-loop-osr:
+# Tracing deoptimizes the methods, which never get OSR code then.
+# 626-checker-jit-branch-profile and 627-checker-jit-baseline:
+# Tracing deoptimizes the methods, which never get baseline code then.
+# 628-checker-jit-megamorphic-inline:
+# Tracing deoptimizes the method, which then never gets JIT code to check.
 TEST_ART_BROKEN_TRACING_RUN_TESTS := \
   087-gc-after-link \
   137-cfi \
   141-class-unload \
   570-checker-osr \
+  624-jit-loop-osr \
+  626-checker-jit-branch-profile \
+  627-checker-jit-baseline \
+  628-checker-jit-megamorphic-inline \
   802-deoptimization
 
 ifneq (,$(filter trace stream,$(TRACE_TYPES)))